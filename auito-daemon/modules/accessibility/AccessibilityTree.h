@@ -4,6 +4,19 @@
 
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
+#import "KimiRunA11yJSONStream.h"
+
+// Marks cached trees and interactive elements stale (screen or layout
+// change, window shown or hidden, gesture delivered). Cheap and safe from
+// any thread; does not initialize the class.
+FOUNDATION_EXPORT void KimiRunA11yNoteContentChanged(void);
+// Touch pipeline hook: a gesture, key press or activation was delivered.
+// Notes the change here and posts it to the other KimiRun processes, whose
+// apps are the ones that will redraw.
+FOUNDATION_EXPORT void KimiRunA11yNoteActionPerformed(void);
+// Called by KimiRunA11yChangeHook when it loads. Without it nothing reports
+// UI changes the process did not cause, so caches keep short fixed lifetimes.
+FOUNDATION_EXPORT void KimiRunA11yNoteChangeHookInstalled(void);
 
 @interface AccessibilityTree : NSObject
 
@@ -13,12 +26,66 @@
 + (NSDictionary *)getFullTree;
 + (NSString *)getFullTreeAsJSON;
 
+// /uiHierarchy query: the subtree under the view at rootPath (dotted
+// subview indexes from the key window), or under the first view matching
+// rootIdentifier/rootLabel; maxDepth < 0 for the default depth; fields is a
+// comma-separated list of element keys (nil for all but path). Errors carry
+// an HTTP status as their code (400 unknown field, 404 root not found).
++ (NSDictionary *)getTreeWithRootIdentifier:(NSString *)rootIdentifier
+                                  rootLabel:(NSString *)rootLabel
+                                   rootPath:(NSString *)rootPath
+                                   maxDepth:(NSInteger)maxDepth
+                                     fields:(NSString *)fields
+                            interactiveOnly:(BOOL)interactiveOnly
+                                      error:(NSError **)error;
+
+// getFullTree written into json: the cached tree while it is current,
+// otherwise streamed like the method below (and not cached).
++ (BOOL)writeFullTreeToJSON:(KimiRunA11yJSONStream *)json;
+
+// The same tree written straight into json as the views are walked, a few
+// dozen nodes at a time, without building it first. Off the main thread,
+// main only captures the views and the caller builds and writes them; main
+// stops walking if the caller falls behind by more than a few batches (a
+// stalled client). Returns NO with error set (nothing written) for the
+// errors above, or NO once json has failed.
++ (BOOL)writeTreeWithRootIdentifier:(NSString *)rootIdentifier
+                          rootLabel:(NSString *)rootLabel
+                           rootPath:(NSString *)rootPath
+                           maxDepth:(NSInteger)maxDepth
+                             fields:(NSString *)fields
+                    interactiveOnly:(BOOL)interactiveOnly
+                             toJSON:(KimiRunA11yJSONStream *)json
+                              error:(NSError **)error;
+
 // Get tree for specific view
 + (NSDictionary *)getTreeForView:(UIView *)view;
 
 // Get interactive elements only (buttons, text fields, etc.)
 + (NSArray<NSDictionary *> *)getInteractiveElements;
 + (NSString *)getInteractiveElementsAsJSON;
+// Versioned interactive snapshots. Every element carries a stable "key";
+// the sequence advances whenever the list changes. Returns the elements
+// added or changed since snapshot `since` plus the keys removed ("order"
+// lists every key when survivors moved), or the whole list with
+// "full": true when `since` is 0 or no longer held.
++ (NSDictionary *)getInteractiveElementsSince:(uint64_t)since;
+// Compact encodings ("min", "columnar", "msgpack"; see KimiRunA11yEncode.h).
+// Returns nil for an unknown format.
++ (NSData *)encodeInteractiveElements:(NSArray<NSDictionary *> *)elements
+                               format:(NSString *)format
+                          contentType:(NSString **)contentType;
+// Row dicts (the getInteractiveElements shape) from a "msgpack" payload;
+// nil when the payload is malformed.
++ (NSArray<NSDictionary *> *)interactiveElementsFromMsgPack:(NSData *)data;
+// Spatial queries over the current interactive elements (grid index rebuilt
+// per collection). Elements under a point come innermost first; a negative
+// maxDistance is unbounded.
++ (NSArray<NSDictionary *> *)interactiveElementsAtPoint:(CGPoint)point;
++ (NSArray<NSDictionary *> *)interactiveElementsInRect:(CGRect)rect contained:(BOOL)contained;
++ (NSDictionary *)nearestActionableElementToPoint:(CGPoint)point
+                                      maxDistance:(CGFloat)maxDistance
+                                         distance:(CGFloat *)distance;
 // Activate interactive element by index (from getInteractiveElements)
 + (BOOL)activateInteractiveElementAtIndex:(NSUInteger)index;
 // Activate best-match accessible element at screen point.
@@ -29,6 +96,21 @@
 // Find element by properties
 + (NSDictionary *)findElementWithLabel:(NSString *)label;
 + (NSDictionary *)findElementWithIdentifier:(NSString *)identifier;
+// Ranked label / identifier search over the current interactive elements
+// (exact, prefix, substring, and trigram-similar when fuzzy). Each result
+// is {score, match, field, element}; limit 0 returns every match.
++ (NSArray<NSDictionary *> *)findElementsMatching:(NSString *)query
+                                          inLabel:(BOOL)inLabel
+                                     inIdentifier:(BOOL)inIdentifier
+                                            fuzzy:(BOOL)fuzzy
+                                            limit:(NSUInteger)limit;
+// Several queries against one collection; one result array per query, in
+// order, each limited to `limit` matches.
++ (NSArray<NSArray<NSDictionary *> *> *)findElementsMatchingQueries:(NSArray<NSString *> *)queries
+                                                            inLabel:(BOOL)inLabel
+                                                       inIdentifier:(BOOL)inIdentifier
+                                                              fuzzy:(BOOL)fuzzy
+                                                              limit:(NSUInteger)limit;
 
 // Overlay controls (DroidRun-style a11y boxes)
 + (void)setOverlayEnabled:(BOOL)enabled interactiveOnly:(BOOL)interactiveOnly;
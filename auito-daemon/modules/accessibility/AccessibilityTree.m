@@ -3,21 +3,66 @@
  */
 
 #import "AccessibilityTree.h"
+#import "KimiRunA11yEncode.h"
+#import "KimiRunA11ySampler.h"
+#import "KimiRunA11ySearch.h"
+#import "KimiRunA11ySnapshot.h"
+#import "KimiRunA11ySpatial.h"
+#import "../prefs/KimiRunPrefs.h"
 #import <QuartzCore/QuartzCore.h>
 #import <objc/runtime.h>
 #import <objc/message.h>
 #import <dlfcn.h>
+#import <stdatomic.h>
 
 // Interactive element types we care about
 static NSSet<NSString *> *interactiveTraits = nil;
 static NSDictionary *cachedFullTree = nil;
 static NSTimeInterval cachedFullTreeAt = 0;
+static uint64_t cachedFullTreeGeneration = 0;
 static NSArray *cachedInteractive = nil;
 static NSTimeInterval cachedInteractiveAt = 0;
+static uint64_t cachedInteractiveGeneration = 0;
+static BOOL cachedInteractiveTruncated = NO;
+// Cached trees and element lists are served until a change signal advances
+// the content generation (KimiRunA11yNoteContentChanged). Lists collected
+// within kChangeSettleWindow of a signal may still show the UI mid-update,
+// so they only live kSettlingCacheTTL; kCacheMaxAge bounds changes nothing
+// signals, such as a label rewritten by a timer. Only processes that load
+// KimiRunA11yChangeHook see UI changes as they happen; elsewhere (the daemon,
+// apps outside the tweak filter) the touch pipeline is the only signal, so
+// entries keep the short kTreeCacheTTL / kInteractiveCacheTTL lifetimes.
+static _Atomic uint64_t contentGeneration = 1;
+static _Atomic bool changeHookInstalled = false;
+static _Atomic double contentChangedAt = 0;
+static _Atomic uint64_t cacheHits = 0;
+static _Atomic uint64_t cacheMisses = 0;
+static const NSTimeInterval kChangeSettleWindow = 0.35;
+static const NSTimeInterval kSettlingCacheTTL = 0.1;
+static const NSTimeInterval kCacheMaxAge = 2.0;
 static const NSTimeInterval kTreeCacheTTL = 0.25;
 static const NSTimeInterval kInteractiveCacheTTL = 0.5;
+static CFStringRef const kTouchActionDarwinName = CFSTR("com.auito.daemon/touchActionPerformed");
 static const NSUInteger kAXMaxElements = 500;
+// /uiHierarchy walks this deep below its root unless maxDepth says
+// otherwise, and never deeper than kTreeMaxDepth.
+static const int kTreeDefaultDepth = 30;
+static const int kTreeMaxDepth = 128;
+// Captures held at once while a tree is streamed.
+static const NSUInteger kTreeStreamBatch = 64;
+// Batches the main-thread walk may get ahead of the writer, and how long it
+// waits for the writer before giving up the walk.
+#define kTreeStreamHandoffDepth 4
+static const NSTimeInterval kTreeStreamHandoffWait = 0.25;
+// AX fallback sources are cross-process calls; the whole fallback gets this
+// budget unless the A11yAXBudgetMs pref overrides it. Workers still stuck in
+// a call past their deadline count against kAXMaxWorkersInFlight.
+static const double kAXFallbackBudgetMs = 750.0;
+static const NSInteger kAXMaxWorkersInFlight = 16;
+static _Atomic NSInteger axWorkersInFlight = 0;
+static NSDictionary *lastAXFallbackStats = nil;
 static const NSUInteger kOverlayMaxElements = 200;
+static const CGFloat kActivateNearestRadius = 63.0;
 static UIWindow *overlayWindow = nil;
 static CAShapeLayer *overlayLayer = nil;
 static NSMutableArray<CATextLayer *> *overlayTextLayers = nil;
@@ -25,6 +70,60 @@ static BOOL overlayEnabled = NO;
 static BOOL overlayInteractiveOnly = YES;
 static BOOL overlayRefreshing = NO;
 static NSMutableArray *lastInteractiveElements = nil;
+static BOOL lastInteractiveRefsAligned = NO;
+static KimiRunA11yStore *interactiveSnapshots = NULL;
+static NSArray *interactiveSnapshotElements = nil;
+static KimiRunA11ySpatial *interactiveSpatial = NULL;
+static NSArray *interactiveSpatialElements = nil;
+static KimiRunA11ySearch *interactiveSearch = NULL;
+static NSArray *interactiveSearchElements = nil;
+
+void KimiRunA11yNoteContentChanged(void) {
+    atomic_store(&contentChangedAt, CACurrentMediaTime());
+    atomic_fetch_add(&contentGeneration, 1);
+}
+
+void KimiRunA11yNoteActionPerformed(void) {
+    KimiRunA11yNoteContentChanged();
+    CFNotificationCenterPostNotification(CFNotificationCenterGetDarwinNotifyCenter(),
+                                         kTouchActionDarwinName,
+                                         NULL,
+                                         NULL,
+                                         true);
+}
+
+static void IOSRunTouchActionPerformed(__unused CFNotificationCenterRef center,
+                                       __unused void *observer,
+                                       __unused CFStringRef name,
+                                       __unused const void *object,
+                                       __unused CFDictionaryRef userInfo) {
+    KimiRunA11yNoteContentChanged();
+}
+
+void KimiRunA11yNoteChangeHookInstalled(void) {
+    atomic_store(&changeHookInstalled, true);
+}
+
+// Longest an entry is served; unhookedTTL applies without the change hook.
+static NSTimeInterval IOSRunCacheMaxAge(NSTimeInterval unhookedTTL) {
+    return atomic_load(&changeHookInstalled) ? kCacheMaxAge : unhookedTTL;
+}
+
+// generation is the content generation read before the entry was collected.
+static BOOL IOSRunCacheEntryCurrent(uint64_t generation, NSTimeInterval builtAt,
+                                    NSTimeInterval now, NSTimeInterval unhookedTTL) {
+    if (generation != atomic_load(&contentGeneration)) {
+        return NO;
+    }
+    NSTimeInterval age = now - builtAt;
+    if (age >= IOSRunCacheMaxAge(unhookedTTL)) {
+        return NO;
+    }
+    if (builtAt - atomic_load(&contentChangedAt) < kChangeSettleWindow) {
+        return age < kSettlingCacheTTL;
+    }
+    return YES;
+}
 
 static BOOL IOSRunClassNameContainsAny(NSString *className, NSArray<NSString *> *needles) {
     if (className.length == 0) return NO;
@@ -368,21 +467,29 @@ static BOOL IOSRunAXBool(id element, SEL selector) {
     return msgSend(element, selector);
 }
 
-static id IOSRunAXElementFromPoint(CGPoint point) {
+// The hit test itself; the one cross-process call per point.
+static id IOSRunAXUIElementFromPoint(CGPoint point) {
     Class AXUIElementClass = NSClassFromString(@"AXUIElement");
-    Class AXElementClass = NSClassFromString(@"AXElement");
-    if (!AXUIElementClass || !AXElementClass) return nil;
+    if (!AXUIElementClass) return nil;
     SEL sel = @selector(uiElementAtCoordinate:);
     if (![AXUIElementClass respondsToSelector:sel]) return nil;
     id (*msgSendPoint)(id, SEL, CGPoint) = (id (*)(id, SEL, CGPoint))objc_msgSend;
-    id uiElem = msgSendPoint(AXUIElementClass, sel, point);
-    if (!uiElem) return nil;
+    return msgSendPoint(AXUIElementClass, sel, point);
+}
+
+static id IOSRunAXElementForUIElement(id uiElem) {
+    Class AXElementClass = NSClassFromString(@"AXElement");
+    if (!uiElem || !AXElementClass) return nil;
     if ([AXElementClass respondsToSelector:@selector(elementWithUIElement:)]) {
         return [AXElementClass performSelector:@selector(elementWithUIElement:) withObject:uiElem];
     }
     return nil;
 }
 
+static id IOSRunAXElementFromPoint(CGPoint point) {
+    return IOSRunAXElementForUIElement(IOSRunAXUIElementFromPoint(point));
+}
+
 static CGRect IOSRunRectFromDict(NSDictionary *dict) {
     if (![dict isKindOfClass:[NSDictionary class]]) return CGRectZero;
     CGFloat x = [dict[@"x"] doubleValue];
@@ -392,6 +499,27 @@ static CGRect IOSRunRectFromDict(NSDictionary *dict) {
     return CGRectMake(x, y, w, h);
 }
 
+// One AX fallback source, collected on a worker queue. The worker appends
+// under @synchronized(run); at the deadline the collector copies whatever is
+// there and cancels the rest.
+@interface IOSRunAXSourceRun : NSObject
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, strong) NSMutableArray<NSDictionary *> *elements;
+@property (nonatomic, strong) NSMutableArray *refs;
+@property (nonatomic, strong) NSMutableSet<NSValue *> *visited;
+@property (nonatomic, strong) NSArray *results;
+// Call counts the source reports for /a11y/debug, set as it finishes.
+@property (atomic, copy) NSDictionary<NSString *, NSNumber *> *counters;
+@property (atomic, assign) CFTimeInterval deadline;
+@property (atomic, assign) CFTimeInterval startedAt;
+@property (atomic, assign) CFTimeInterval finishedAt;
+@property (atomic, assign) BOOL cancelled;
+@property (atomic, assign) BOOL finished;
+@end
+
+@implementation IOSRunAXSourceRun
+@end
+
 @implementation AccessibilityTree
 
 static BOOL IOSRunIsInteractiveAccessibilityElement(UIAccessibilityElement *element) {
@@ -495,33 +623,125 @@ static BOOL IOSRunAXElementIsInteractive(id element) {
     return NO;
 }
 
-static void IOSRunAXCollectFromElement(id element,
-                                       NSMutableSet<NSValue *> *visited,
-                                       NSMutableArray<NSDictionary *> *out,
-                                       NSUInteger *count) {
-    if (!element || !visited || !out || !count) return;
-    if (*count >= kAXMaxElements) return;
+static BOOL IOSRunAXRunShouldStop(IOSRunAXSourceRun *run) {
+    if (run.cancelled || CACurrentMediaTime() >= run.deadline) {
+        return YES;
+    }
+    @synchronized(run) {
+        return run.elements.count >= kAXMaxElements;
+    }
+}
+
+static void IOSRunAXRunAppend(IOSRunAXSourceRun *run, id element) {
+    NSDictionary *dict = IOSRunDictForAXElement(element);
+    if (!dict) return;
+    @synchronized(run) {
+        [run.elements addObject:dict];
+        [run.refs addObject:element];
+    }
+}
+
+static void IOSRunAXCollectFromElement(id element, IOSRunAXSourceRun *run) {
+    if (!element || IOSRunAXRunShouldStop(run)) return;
 
     NSValue *key = [NSValue valueWithPointer:(__bridge const void *)(element)];
-    if ([visited containsObject:key]) return;
-    [visited addObject:key];
+    if ([run.visited containsObject:key]) return;
+    [run.visited addObject:key];
 
     if (IOSRunAXElementIsInteractive(element)) {
-        NSDictionary *dict = IOSRunDictForAXElement(element);
-        if (dict) {
-            NSMutableDictionary *mutable = [dict mutableCopy];
-            mutable[@"index"] = @(*count);
-            [out addObject:mutable];
-            (*count)++;
-            if (*count >= kAXMaxElements) return;
-        }
+        IOSRunAXRunAppend(run, element);
     }
 
     if ([element respondsToSelector:@selector(children)]) {
         NSArray *children = [element performSelector:@selector(children)];
         for (id child in children ?: @[]) {
-            IOSRunAXCollectFromElement(child, visited, out, count);
-            if (*count >= kAXMaxElements) return;
+            IOSRunAXCollectFromElement(child, run);
+            if (IOSRunAXRunShouldStop(run)) return;
+        }
+    }
+}
+
+static uint64_t IOSRunAXSampleHitTest(void *context, float x, float y) {
+    uint64_t (^hitTest)(CGPoint) = (__bridge uint64_t (^)(CGPoint))context;
+    return hitTest(CGPointMake(x, y));
+}
+
+static IOSRunAXSourceRun *IOSRunAXStartRun(NSString *name,
+                                           dispatch_group_t group,
+                                           CFTimeInterval deadline,
+                                           void (^body)(IOSRunAXSourceRun *run)) {
+    IOSRunAXSourceRun *run = [[IOSRunAXSourceRun alloc] init];
+    run.name = name;
+    run.elements = [NSMutableArray array];
+    run.refs = [NSMutableArray array];
+    run.visited = [NSMutableSet set];
+    run.deadline = deadline;
+    if (atomic_fetch_add(&axWorkersInFlight, 1) >= kAXMaxWorkersInFlight) {
+        // Earlier workers are still blocked in AX calls; do not pile on.
+        atomic_fetch_sub(&axWorkersInFlight, 1);
+        run.cancelled = YES;
+        return run;
+    }
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        run.startedAt = CACurrentMediaTime();
+        @autoreleasepool {
+            @try {
+                body(run);
+            } @catch (__unused NSException *e) {
+            }
+        }
+        run.finishedAt = CACurrentMediaTime();
+        run.finished = YES;
+        atomic_fetch_sub(&axWorkersInFlight, 1);
+    });
+    return run;
+}
+
+// Waits for group until deadline; YES when every run finished in time.
+static BOOL IOSRunAXWait(dispatch_group_t group, CFTimeInterval deadline) {
+    CFTimeInterval remaining = deadline - CACurrentMediaTime();
+    if (remaining <= 0) {
+        return dispatch_group_wait(group, DISPATCH_TIME_NOW) == 0;
+    }
+    return dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(remaining * NSEC_PER_SEC))) == 0;
+}
+
+// Runs refused for too many workers in flight never start, so the group
+// alone does not say whether everything was collected.
+static BOOL IOSRunAXAllFinished(NSArray<IOSRunAXSourceRun *> *runs) {
+    for (IOSRunAXSourceRun *run in runs) {
+        if (!run.finished) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+static void IOSRunAXRecordRuns(NSArray<IOSRunAXSourceRun *> *runs, NSMutableArray *stats) {
+    CFTimeInterval now = CACurrentMediaTime();
+    NSMutableDictionary<NSString *, NSMutableDictionary *> *byName = [NSMutableDictionary dictionary];
+    for (IOSRunAXSourceRun *run in runs) {
+        run.cancelled = YES;
+        NSUInteger count = 0;
+        @synchronized(run) {
+            count = run.elements.count;
+        }
+        CFTimeInterval started = run.startedAt;
+        double ms = started > 0 ? ((run.finished ? run.finishedAt : now) - started) * 1000.0 : 0.0;
+        NSMutableDictionary *entry = byName[run.name];
+        if (!entry) {
+            entry = [@{@"name": run.name, @"ms": @0.0, @"count": @0, @"finished": @YES} mutableCopy];
+            byName[run.name] = entry;
+            [stats addObject:entry];
+        }
+        // Runs sharing a name ran side by side: report the slowest.
+        entry[@"ms"] = @(MAX([entry[@"ms"] doubleValue], round(ms * 100.0) / 100.0));
+        entry[@"count"] = @([entry[@"count"] unsignedIntegerValue] + count);
+        [run.counters enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSNumber *value, __unused BOOL *stop) {
+            entry[key] = @([entry[key] unsignedIntegerValue] + value.unsignedIntegerValue);
+        }];
+        if (!run.finished) {
+            entry[@"finished"] = @NO;
         }
     }
 }
@@ -535,6 +755,13 @@ static void IOSRunAXCollectFromElement(id element,
             @"TextArea", @"Switch", @"Slider", @"Stepper", @"Picker",
             @"DatePicker", @"PageIndicator", @"Tab", @"Cell", @"MenuItem"
         ]];
+        // Gestures delivered by the daemon or another process's pipeline.
+        CFNotificationCenterAddObserver(CFNotificationCenterGetDarwinNotifyCenter(),
+                                        NULL,
+                                        (CFNotificationCallback)IOSRunTouchActionPerformed,
+                                        kTouchActionDarwinName,
+                                        NULL,
+                                        CFNotificationSuspensionBehaviorDeliverImmediately);
         NSLog(@"[KimiRunA11y] AccessibilityTree initialized");
     });
 }
@@ -691,563 +918,1988 @@ static void IOSRunAXCollectFromElement(id element,
         [counts addObject:entry];
     }
     info[@"sourceCounts"] = counts;
+    @synchronized(self) {
+        info[@"axFallback"] = lastAXFallbackStats ?: @{};
+    }
+    info[@"cache"] = @{
+        @"generation": @(atomic_load(&contentGeneration)),
+        @"sinceChangeMs": @((CACurrentMediaTime() - atomic_load(&contentChangedAt)) * 1000.0),
+        @"changeHook": @(atomic_load(&changeHookInstalled)),
+        @"treeMaxAgeMs": @(IOSRunCacheMaxAge(kTreeCacheTTL) * 1000.0),
+        @"interactiveMaxAgeMs": @(IOSRunCacheMaxAge(kInteractiveCacheTTL) * 1000.0),
+        @"hits": @(atomic_load(&cacheHits)),
+        @"misses": @(atomic_load(&cacheMisses))
+    };
     return info;
 }
 
-#pragma mark - Full Tree
-
-+ (NSDictionary *)getFullTree {
-    __block NSDictionary *result = nil;
-    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
-    if (cachedFullTree && (now - cachedFullTreeAt) < kTreeCacheTTL) {
-        return cachedFullTree;
-    }
-
+#pragma mark - Capture
+
+// Collection runs in two phases. The main-thread pass only walks the view
+// hierarchy and copies raw fields into a flat array of captures; class-name
+// filtering, dictionary building and JSON encoding run on the caller's
+// thread (the HTTP servers call in from their own queues).
+
+typedef NS_ENUM(uint8_t, IOSRunCaptureKind) {
+    IOSRunCaptureKindView = 0,
+    IOSRunCaptureKindAccessibilityElement,
+    IOSRunCaptureKindGeneric
+};
+
+typedef NS_ENUM(uint8_t, IOSRunCaptureText) {
+    IOSRunCaptureTextNone = 0,
+    IOSRunCaptureTextPlain,       // UILabel, UIButton, UITextView
+    IOSRunCaptureTextField,       // text + placeholder
+    IOSRunCaptureTextCell         // textLabel + detailTextLabel
+};
+
+// Node attributes a /uiHierarchy query can ask for (fields=). Unrequested
+// ones are neither emitted nor, where that costs anything (value, text,
+// geometry, class names, type and traits), read.
+typedef NS_OPTIONS(uint32_t, IOSRunTreeFields) {
+    IOSRunTreeFieldType = 1u << 0,
+    IOSRunTreeFieldClassName = 1u << 1,
+    IOSRunTreeFieldLabel = 1u << 2,
+    IOSRunTreeFieldIdentifier = 1u << 3,
+    IOSRunTreeFieldValue = 1u << 4,
+    IOSRunTreeFieldHint = 1u << 5,
+    IOSRunTreeFieldTraits = 1u << 6,
+    IOSRunTreeFieldBounds = 1u << 7,
+    IOSRunTreeFieldRect = 1u << 8,
+    IOSRunTreeFieldCenter = 1u << 9,     // center_x, center_y
+    IOSRunTreeFieldEnabled = 1u << 10,
+    IOSRunTreeFieldVisible = 1u << 11,
+    IOSRunTreeFieldText = 1u << 12,      // text, placeholder
+    IOSRunTreeFieldIndex = 1u << 13,
+    IOSRunTreeFieldPath = 1u << 14,      // subview indices from the window, "0.2.1"
+    IOSRunTreeFieldsGeometry = IOSRunTreeFieldBounds | IOSRunTreeFieldRect | IOSRunTreeFieldCenter,
+    IOSRunTreeFieldsDefault = (IOSRunTreeFieldPath - 1),
+    IOSRunTreeFieldsAll = (IOSRunTreeFieldPath << 1) - 1
+};
+
+typedef struct IOSRunCaptureList IOSRunCaptureList;
+
+// One capture pass: how deep to go, what to keep and what to read. drain
+// (optional) sees the list as the walk goes and may empty it; returning NO
+// ends the walk.
+typedef struct {
+    int maxDepth;
+    BOOL interactiveOnly;
+    IOSRunTreeFields fields;
+    BOOL (*drain)(IOSRunCaptureList *list, void *context);
+    void *drainContext;
+} IOSRunCaptureWalk;
+
+typedef struct {
+    CFTypeRef ref;                      // retained; released on main
+    __unsafe_unretained Class cls;
+    CGRect frame;                       // screen coordinates
+    UIAccessibilityTraits traits;
+    CFStringRef label;                  // retained copies, NULL when nil
+    CFStringRef identifier;
+    CFStringRef value;
+    CFStringRef hint;
+    CFStringRef text;
+    CFStringRef detail;                 // placeholder or cell detail text
+    CFStringRef path;                   // IOSRunTreeFieldPath only
+    IOSRunCaptureKind kind;
+    IOSRunCaptureText textKind;
+    BOOL enabled;
+    BOOL visible;
+} IOSRunCapture;
+
+struct IOSRunCaptureList {
+    IOSRunCapture *items;
+    NSUInteger count;
+    NSUInteger capacity;
+};
+
+static void IOSRunSyncOnMain(dispatch_block_t block) {
     if ([NSThread isMainThread]) {
-        result = [self buildTreeFromKeyWindow];
+        block();
     } else {
-        dispatch_sync(dispatch_get_main_queue(), ^{
-            result = [self buildTreeFromKeyWindow];
-        });
+        dispatch_sync(dispatch_get_main_queue(), block);
     }
-
-    if (result) {
-        cachedFullTree = result;
-        cachedFullTreeAt = now;
-    }
-    return result ?: @{@"error": @"No key window available"};
 }
 
-+ (NSString *)getFullTreeAsJSON {
-    NSDictionary *tree = [self getFullTree];
-    NSError *error;
-    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:tree
-                                                       options:NSJSONWritingPrettyPrinted
-                                                         error:&error];
-    if (error) {
-        return [NSString stringWithFormat:@"{\"error\": \"%@\"}", error.localizedDescription];
+// UIKit objects must be deallocated on the main thread. Moves the caller's
+// reference (which may be the last one) over to main.
+static void IOSRunReleaseOnMain(__strong id *object) {
+    if (!*object) return;
+    if ([NSThread isMainThread]) {
+        *object = nil;
+        return;
     }
-    return [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+    CFTypeRef retained = CFBridgingRetain(*object);
+    *object = nil;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        CFRelease(retained);
+    });
 }
 
-+ (NSDictionary *)buildTreeFromKeyWindow {
-    UIWindow *keyWindow = IOSRunPreferredWindow();
-
-    if (!keyWindow) {
-        return @{@"error": @"No window found"};
-    }
-    NSArray *viewChildren = [self buildTreeForView:keyWindow depth:0 maxDepth:30 index:[[NSMutableArray alloc] init]];
-    if (![viewChildren isKindOfClass:[NSArray class]]) {
-        viewChildren = @[];
-    }
-
-    // Foreground recovery fallback:
-    // If key-window traversal yields no useful nodes, reuse interactive/AX
-    // collection so /uiHierarchy still represents the current foreground UI.
-    if (viewChildren.count == 0) {
-        NSArray *interactiveFallback = [self collectInteractiveElements];
-        if ([interactiveFallback isKindOfClass:[NSArray class]] && interactiveFallback.count > 0) {
-            return @{
-                @"type": @"Window",
-                @"bounds": [self rectToDict:keyWindow.bounds],
-                @"children": interactiveFallback,
-                @"source": @"interactive_fallback"
-            };
-        }
-    }
-
-    return @{
-        @"type": @"Window",
-        @"bounds": [self rectToDict:keyWindow.bounds],
-        @"children": viewChildren
-    };
+static CFStringRef IOSRunCaptureString(NSString *string) {
+    // Copy: UIKit may hand out a mutable string it keeps editing.
+    return string ? (__bridge_retained CFStringRef)[string copy] : NULL;
 }
 
-+ (NSArray *)buildTreeForView:(UIView *)view depth:(int)depth maxDepth:(int)maxDepth index:(NSMutableArray *)indexCounter {
-    if (depth > maxDepth || !view || view.hidden || view.alpha < 0.01) {
-        return @[];
-    }
-
-    NSMutableArray *elements = [NSMutableArray array];
-
-    // Check if this view is accessible
-    if (view.isAccessibilityElement || [self viewHasAccessibilityInfo:view]) {
-        NSMutableDictionary *element = [self elementDictForView:view];
-
-        // Assign index
-        element[@"index"] = @(indexCounter.count);
-        [indexCounter addObject:element];
+static NSString *IOSRunCapturedString(CFStringRef string) {
+    return string ? (__bridge NSString *)string : @"";
+}
 
-        [elements addObject:element];
-    }
+static IOSRunCapture *IOSRunCaptureAppend(IOSRunCaptureList *list, id ref, IOSRunCaptureKind kind) {
+    if (list->count == list->capacity) {
+        NSUInteger capacity = list->capacity ? list->capacity * 2 : 128;
+        IOSRunCapture *items = realloc(list->items, capacity * sizeof(*items));
+        if (!items) return NULL;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    IOSRunCapture *capture = &list->items[list->count++];
+    memset(capture, 0, sizeof(*capture));
+    capture->ref = CFBridgingRetain(ref);
+    capture->cls = [ref class];
+    capture->kind = kind;
+    return capture;
+}
 
-    // Recurse into subviews
-    for (UIView *subview in view.subviews) {
-        [elements addObjectsFromArray:[self buildTreeForView:subview depth:depth+1 maxDepth:maxDepth index:indexCounter]];
-    }
+static void IOSRunCaptureRelease(CFTypeRef ref) {
+    if (ref) CFRelease(ref);
+}
 
-    // Also check accessibility elements if present
-    if ([view respondsToSelector:@selector(accessibilityElements)] && view.accessibilityElements.count > 0) {
-        for (id element in view.accessibilityElements) {
-            if ([element isKindOfClass:[UIAccessibilityElement class]]) {
-                UIAccessibilityElement *accElement = (UIAccessibilityElement *)element;
-                NSMutableDictionary *dict = [self elementDictForAccessibilityElement:accElement];
-                dict[@"index"] = @(indexCounter.count);
-                [indexCounter addObject:dict];
-                [elements addObject:dict];
-            }
-        }
+static void IOSRunCaptureItemsRelease(IOSRunCapture *items, NSUInteger count) {
+    for (NSUInteger i = 0; i < count; i++) {
+        IOSRunCapture *capture = &items[i];
+        IOSRunCaptureRelease(capture->ref);
+        IOSRunCaptureRelease(capture->label);
+        IOSRunCaptureRelease(capture->identifier);
+        IOSRunCaptureRelease(capture->value);
+        IOSRunCaptureRelease(capture->hint);
+        IOSRunCaptureRelease(capture->text);
+        IOSRunCaptureRelease(capture->detail);
+        IOSRunCaptureRelease(capture->path);
     }
+}
 
-    return elements;
+static void IOSRunCaptureItemsFree(IOSRunCapture *items, NSUInteger count) {
+    IOSRunCaptureItemsRelease(items, count);
+    free(items);
 }
 
-+ (BOOL)viewHasAccessibilityInfo:(UIView *)view {
-    return view.accessibilityLabel.length > 0 ||
-           view.accessibilityIdentifier.length > 0 ||
-           view.accessibilityValue.length > 0 ||
-           view.accessibilityHint.length > 0;
+// Main thread only. Releases the captures and keeps the storage.
+static void IOSRunCaptureListClear(IOSRunCaptureList *list) {
+    IOSRunCaptureItemsRelease(list->items, list->count);
+    list->count = 0;
 }
 
-+ (NSMutableDictionary *)elementDictForView:(UIView *)view {
-    CGRect screenFrame = [view.superview convertRect:view.frame toView:nil];
+static void IOSRunCaptureListFree(IOSRunCaptureList *list) {
+    IOSRunCapture *items = list->items;
+    NSUInteger count = list->count;
+    memset(list, 0, sizeof(*list));
+    if (!items) return;
+    if ([NSThread isMainThread]) {
+        IOSRunCaptureItemsFree(items, count);
+        return;
+    }
+    // The captures may hold the last reference to views that have since
+    // left the hierarchy.
+    dispatch_async(dispatch_get_main_queue(), ^{
+        IOSRunCaptureItemsFree(items, count);
+    });
+}
 
-    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
-    dict[@"type"] = [self elementTypeForView:view];
-    dict[@"className"] = NSStringFromClass([view class]);
-    dict[@"label"] = view.accessibilityLabel ?: @"";
-    dict[@"identifier"] = view.accessibilityIdentifier ?: @"";
-    dict[@"value"] = view.accessibilityValue ?: @"";
-    dict[@"hint"] = view.accessibilityHint ?: @"";
-    dict[@"traits"] = [self traitsToArray:view.accessibilityTraits];
-    dict[@"bounds"] = [self rectToDict:screenFrame];
-    dict[@"rect"] = [NSString stringWithFormat:@"%.1f,%.1f,%.1f,%.1f",
-                     screenFrame.origin.x, screenFrame.origin.y,
-                     screenFrame.size.width, screenFrame.size.height];
-    dict[@"center_x"] = @(CGRectGetMidX(screenFrame));
-    dict[@"center_y"] = @(CGRectGetMidY(screenFrame));
-    dict[@"enabled"] = @(view.userInteractionEnabled);
-    dict[@"visible"] = @(!view.hidden && view.alpha > 0.01);
-
-    // Extract text from common controls
+static void IOSRunCaptureView(IOSRunCaptureList *list,
+                              UIView *view,
+                              UIAccessibilityTraits traits,
+                              NSString *label,
+                              NSString *identifier,
+                              NSString *value,
+                              NSString *hint,
+                              IOSRunTreeFields fields,
+                              NSString *path) {
+    IOSRunCapture *capture = IOSRunCaptureAppend(list, view, IOSRunCaptureKindView);
+    if (!capture) return;
+    if (fields & IOSRunTreeFieldsGeometry) {
+        capture->frame = [view.superview convertRect:view.frame toView:nil];
+    }
+    capture->traits = traits;
+    capture->label = IOSRunCaptureString(label);
+    capture->identifier = IOSRunCaptureString(identifier);
+    capture->value = IOSRunCaptureString(value);
+    capture->hint = IOSRunCaptureString(hint);
+    capture->path = IOSRunCaptureString(path);
+    capture->enabled = view.userInteractionEnabled;
+    capture->visible = !view.hidden && view.alpha > 0.01;
+
+    // Extract text from common controls; cell text also stands in for an
+    // empty label and its detail text for the value.
+    if (!(fields & (IOSRunTreeFieldText | IOSRunTreeFieldLabel | IOSRunTreeFieldValue))) {
+        return;
+    }
     if ([view isKindOfClass:[UILabel class]]) {
-        dict[@"text"] = ((UILabel *)view).text ?: @"";
+        capture->textKind = IOSRunCaptureTextPlain;
+        capture->text = IOSRunCaptureString(((UILabel *)view).text);
     } else if ([view isKindOfClass:[UIButton class]]) {
-        dict[@"text"] = ((UIButton *)view).titleLabel.text ?: @"";
+        capture->textKind = IOSRunCaptureTextPlain;
+        capture->text = IOSRunCaptureString(((UIButton *)view).titleLabel.text);
     } else if ([view isKindOfClass:[UITextField class]]) {
         UITextField *tf = (UITextField *)view;
-        dict[@"text"] = tf.text ?: @"";
-        dict[@"placeholder"] = tf.placeholder ?: @"";
+        capture->textKind = IOSRunCaptureTextField;
+        capture->text = IOSRunCaptureString(tf.text);
+        capture->detail = IOSRunCaptureString(tf.placeholder);
     } else if ([view isKindOfClass:[UITextView class]]) {
-        dict[@"text"] = ((UITextView *)view).text ?: @"";
+        capture->textKind = IOSRunCaptureTextPlain;
+        capture->text = IOSRunCaptureString(((UITextView *)view).text);
     } else if ([view isKindOfClass:[UITableViewCell class]]) {
         UITableViewCell *cell = (UITableViewCell *)view;
-        NSString *text = cell.textLabel.text ?: @"";
-        NSString *detail = cell.detailTextLabel.text ?: @"";
-        if (!dict[@"label"] || [dict[@"label"] length] == 0) {
-            dict[@"label"] = text ?: @"";
-        }
-        if (detail.length > 0) {
-            dict[@"value"] = detail;
-        }
-        if (text.length > 0) {
-            dict[@"text"] = text;
-        }
-    }
-
-    return dict;
-}
-
-+ (NSMutableDictionary *)elementDictForAccessibilityElement:(UIAccessibilityElement *)element {
-    CGRect frame = element.accessibilityFrame;
-
-    NSMutableDictionary *dict = [NSMutableDictionary dictionary];
-    dict[@"type"] = [self elementTypeForTraits:element.accessibilityTraits];
-    dict[@"className"] = @"UIAccessibilityElement";
-    dict[@"label"] = element.accessibilityLabel ?: @"";
-    dict[@"identifier"] = element.accessibilityIdentifier ?: @"";
-    dict[@"value"] = element.accessibilityValue ?: @"";
-    dict[@"hint"] = element.accessibilityHint ?: @"";
-    dict[@"traits"] = [self traitsToArray:element.accessibilityTraits];
-    dict[@"bounds"] = [self rectToDict:frame];
-    dict[@"rect"] = [NSString stringWithFormat:@"%.1f,%.1f,%.1f,%.1f",
-                     frame.origin.x, frame.origin.y,
-                     frame.size.width, frame.size.height];
-    dict[@"center_x"] = @(CGRectGetMidX(frame));
-    dict[@"center_y"] = @(CGRectGetMidY(frame));
-    dict[@"enabled"] = @YES;
-    dict[@"visible"] = @YES;
-
-    return dict;
-}
-
-+ (NSString *)elementTypeForView:(UIView *)view {
-    // Check traits first
-    NSString *traitType = [self elementTypeForTraits:view.accessibilityTraits];
-    if (![traitType isEqualToString:@"Other"]) {
-        return traitType;
+        capture->textKind = IOSRunCaptureTextCell;
+        capture->text = IOSRunCaptureString(cell.textLabel.text);
+        capture->detail = IOSRunCaptureString(cell.detailTextLabel.text);
     }
-
-    // Check class
-    if ([view isKindOfClass:[UIButton class]]) return @"Button";
-    if ([view isKindOfClass:[UILabel class]]) return @"StaticText";
-    if ([view isKindOfClass:[UITextField class]]) return @"TextField";
-    if ([view isKindOfClass:[UITextView class]]) return @"TextArea";
-    if ([view isKindOfClass:[UISwitch class]]) return @"Switch";
-    if ([view isKindOfClass:[UISlider class]]) return @"Slider";
-    if ([view isKindOfClass:[UIStepper class]]) return @"Stepper";
-    if ([view isKindOfClass:[UISegmentedControl class]]) return @"SegmentedControl";
-    if ([view isKindOfClass:[UITableViewCell class]]) return @"Cell";
-    if ([view isKindOfClass:[UICollectionViewCell class]]) return @"Cell";
-    if ([view isKindOfClass:[UIImageView class]]) return @"Image";
-    if ([view isKindOfClass:[UIScrollView class]]) return @"ScrollView";
-
-    return @"Other";
-}
-
-+ (NSString *)elementTypeForTraits:(UIAccessibilityTraits)traits {
-    if (traits & UIAccessibilityTraitButton) return @"Button";
-    if (traits & UIAccessibilityTraitLink) return @"Link";
-    if (traits & UIAccessibilityTraitSearchField) return @"SearchField";
-    if (traits & UIAccessibilityTraitKeyboardKey) return @"KeyboardKey";
-    if (traits & UIAccessibilityTraitStaticText) return @"StaticText";
-    if (traits & UIAccessibilityTraitImage) return @"Image";
-    if (traits & UIAccessibilityTraitHeader) return @"Header";
-    if (traits & UIAccessibilityTraitTabBar) return @"TabBar";
-    if (traits & UIAccessibilityTraitAdjustable) return @"Adjustable";
-    return @"Other";
 }
 
-+ (NSArray *)traitsToArray:(UIAccessibilityTraits)traits {
-    NSMutableArray *arr = [NSMutableArray array];
-    if (traits & UIAccessibilityTraitButton) [arr addObject:@"Button"];
-    if (traits & UIAccessibilityTraitLink) [arr addObject:@"Link"];
-    if (traits & UIAccessibilityTraitSearchField) [arr addObject:@"SearchField"];
-    if (traits & UIAccessibilityTraitImage) [arr addObject:@"Image"];
-    if (traits & UIAccessibilityTraitSelected) [arr addObject:@"Selected"];
-    if (traits & UIAccessibilityTraitNotEnabled) [arr addObject:@"NotEnabled"];
-    if (traits & UIAccessibilityTraitStaticText) [arr addObject:@"StaticText"];
-    if (traits & UIAccessibilityTraitHeader) [arr addObject:@"Header"];
-    if (traits & UIAccessibilityTraitAdjustable) [arr addObject:@"Adjustable"];
-    return arr;
+static void IOSRunCaptureElement(IOSRunCaptureList *list,
+                                 id element,
+                                 IOSRunCaptureKind kind,
+                                 CGRect frame,
+                                 UIAccessibilityTraits traits,
+                                 NSString *label,
+                                 NSString *identifier,
+                                 NSString *value,
+                                 NSString *hint,
+                                 NSString *path) {
+    IOSRunCapture *capture = IOSRunCaptureAppend(list, element, kind);
+    if (!capture) return;
+    capture->frame = frame;
+    capture->traits = traits;
+    capture->label = IOSRunCaptureString(label);
+    capture->identifier = IOSRunCaptureString(identifier);
+    capture->value = IOSRunCaptureString(value);
+    capture->hint = IOSRunCaptureString(hint);
+    capture->path = IOSRunCaptureString(path);
+    capture->enabled = YES;
+    capture->visible = YES;
 }
 
-+ (NSDictionary *)rectToDict:(CGRect)rect {
-    return @{
-        @"x": @(rect.origin.x),
-        @"y": @(rect.origin.y),
-        @"width": @(rect.size.width),
-        @"height": @(rect.size.height)
-    };
+// "i" for a window's i-th subview, "p.i" for the i-th subview of the view at p.
+static NSString *IOSRunChildTreePath(NSString *path, NSUInteger index) {
+    return path.length ? [NSString stringWithFormat:@"%@.%lu", path, (unsigned long)index]
+                       : [NSString stringWithFormat:@"%lu", (unsigned long)index];
 }
 
-#pragma mark - Interactive Elements
+static BOOL IOSRunViewIsInteractive(UIView *view, UIAccessibilityTraits traits, BOOL hasSemanticIdentity) {
+    if (view.userInteractionEnabled) {
+        if ([view isKindOfClass:[UIButton class]] ||
+            [view isKindOfClass:[UITextField class]] ||
+            [view isKindOfClass:[UITextView class]] ||
+            [view isKindOfClass:[UISwitch class]] ||
+            [view isKindOfClass:[UISlider class]] ||
+            [view isKindOfClass:[UITableViewCell class]] ||
+            [view isKindOfClass:[UICollectionViewCell class]]) {
+            return YES;
+        }
 
-+ (NSArray<NSDictionary *> *)getInteractiveElements {
-    __block NSArray *result = nil;
-    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
-    if (cachedInteractive && (now - cachedInteractiveAt) < kInteractiveCacheTTL) {
-        return cachedInteractive;
+        // Check traits
+        if (traits & (UIAccessibilityTraitButton | UIAccessibilityTraitLink | UIAccessibilityTraitSearchField)) {
+            return YES;
+        }
     }
 
-    if ([NSThread isMainThread]) {
-        result = [self collectInteractiveElements];
-    } else {
-        dispatch_sync(dispatch_get_main_queue(), ^{
-            result = [self collectInteractiveElements];
-        });
-    }
+    // Treat accessible elements with labels/traits as interactive
+    if (!hasSemanticIdentity) {
+        return NO;
+    }
+    BOOL hasActionableTraits = (traits & (UIAccessibilityTraitButton |
+                                          UIAccessibilityTraitLink |
+                                          UIAccessibilityTraitSearchField |
+                                          UIAccessibilityTraitAdjustable)) != 0;
+    BOOL isActionableClass = ([view isKindOfClass:[UIControl class]] ||
+                              [view isKindOfClass:[UITableViewCell class]] ||
+                              [view isKindOfClass:[UICollectionViewCell class]]);
+    return hasActionableTraits || isActionableClass;
+}
 
-    if (result) {
-        cachedInteractive = result;
-        cachedInteractiveAt = now;
-    }
-    return result ?: @[];
+// Main thread only. Captures, in traversal order, every view that is an
+// accessibility element or carries accessibility info (or, with
+// interactiveOnly, every interactive view and element).
++ (void)captureFromView:(UIView *)view
+                  depth:(int)depth
+               maxDepth:(int)maxDepth
+        interactiveOnly:(BOOL)interactiveOnly
+                   into:(IOSRunCaptureList *)list {
+    IOSRunCaptureWalk walk = { maxDepth, interactiveOnly, IOSRunTreeFieldsDefault };
+    [self captureFromView:view depth:depth path:nil walk:&walk into:list];
 }
 
-+ (NSString *)getInteractiveElementsAsJSON {
-    NSArray *elements = [self getInteractiveElements];
-    if (overlayEnabled) {
-        [self refreshOverlayWithElements:elements];
+// path is the view's own path, nil unless the walk's fields ask for paths.
++ (void)captureFromView:(UIView *)view
+                  depth:(int)depth
+                   path:(NSString *)path
+                   walk:(const IOSRunCaptureWalk *)walk
+                   into:(IOSRunCaptureList *)list {
+    if (depth > walk->maxDepth || !view || view.hidden || view.alpha < 0.01) {
+        return;
     }
-    NSError *error;
-    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:elements
-                                                       options:NSJSONWritingPrettyPrinted
-                                                         error:&error];
-    if (error) {
-        return @"[]";
+    if (walk->drain && !walk->drain(list, walk->drainContext)) {
+        return;
     }
-    return [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
-}
 
-+ (NSArray *)collectInteractiveElements {
-    NSMutableArray *elements = [NSMutableArray array];
-    NSMutableArray *indexCounter = [NSMutableArray array];
-    NSMutableArray *elementRefs = [NSMutableArray array];
+    UIAccessibilityTraits traits = view.accessibilityTraits;
+    NSString *label = view.accessibilityLabel;
+    NSString *identifier = view.accessibilityIdentifier;
+    // Hint and value (often computed, e.g. formatted slider values) are read
+    // when requested or when label and identifier leave inclusion open.
+    BOOL hasInfo = label.length > 0 || identifier.length > 0;
+    NSString *hint = (!hasInfo || (walk->fields & IOSRunTreeFieldHint)) ? view.accessibilityHint : nil;
+    hasInfo = hasInfo || hint.length > 0;
+    NSString *value = (!hasInfo || (walk->fields & IOSRunTreeFieldValue)) ? view.accessibilityValue : nil;
+    hasInfo = hasInfo || value.length > 0;
+    BOOL include = walk->interactiveOnly ? IOSRunViewIsInteractive(view, traits, hasInfo)
+                                         : (view.isAccessibilityElement || hasInfo);
+    if (include) {
+        IOSRunCaptureView(list, view, traits, label, identifier,
+                          (walk->fields & IOSRunTreeFieldValue) ? value : nil,
+                          (walk->fields & IOSRunTreeFieldHint) ? hint : nil,
+                          walk->fields, path);
+    }
+
+    [self captureChildrenOfView:view depth:depth path:path walk:walk into:list];
+}
 
-    for (UIWindow *window in IOSRunActiveWindows()) {
-        if (!window.hidden) {
-            [self collectInteractiveFromView:window into:elements indexCounter:indexCounter elementRefs:elementRefs];
+// Main thread only. The view's subviews, then its accessibility elements
+// (SpringBoard often exposes these instead of subviews).
++ (void)captureChildrenOfView:(UIView *)view
+                        depth:(int)depth
+                         path:(NSString *)path
+                         walk:(const IOSRunCaptureWalk *)walk
+                         into:(IOSRunCaptureList *)list {
+    NSArray<UIView *> *subviews = view.subviews;
+    for (NSUInteger i = 0; i < subviews.count; i++) {
+        NSString *childPath = path ? IOSRunChildTreePath(path, i) : nil;
+        [self captureFromView:subviews[i] depth:depth + 1 path:childPath walk:walk into:list];
+    }
+
+    BOOL wantsValue = (walk->fields & IOSRunTreeFieldValue) != 0;
+    BOOL wantsHint = (walk->fields & IOSRunTreeFieldHint) != 0;
+    NSArray *accessibilityElements = [view respondsToSelector:@selector(accessibilityElements)] ? view.accessibilityElements : nil;
+    for (NSUInteger i = 0; i < accessibilityElements.count; i++) {
+        id element = accessibilityElements[i];
+        // Elements are not subviews, so their paths cannot name a root.
+        NSString *elementPath = path ? [NSString stringWithFormat:@"%@#%lu", path, (unsigned long)i] : nil;
+        if ([element isKindOfClass:[UIAccessibilityElement class]]) {
+            UIAccessibilityElement *accElement = (UIAccessibilityElement *)element;
+            if (walk->interactiveOnly && !IOSRunIsInteractiveAccessibilityElement(accElement)) {
+                continue;
+            }
+            IOSRunCaptureElement(list, accElement, IOSRunCaptureKindAccessibilityElement,
+                                 accElement.accessibilityFrame, accElement.accessibilityTraits,
+                                 accElement.accessibilityLabel, accElement.accessibilityIdentifier,
+                                 wantsValue ? accElement.accessibilityValue : nil,
+                                 wantsHint ? accElement.accessibilityHint : nil,
+                                 elementPath);
+            continue;
         }
-    }
-
-    if (elements.count > 0 && !IOSRunElementsNeedAXFallback(elements)) {
-        @synchronized(self) {
-            lastInteractiveElements = elementRefs;
+        if (walk->interactiveOnly &&
+            [element respondsToSelector:@selector(accessibilityFrame)] &&
+            IOSRunIsInteractiveGenericElement(element)) {
+            IOSRunCaptureElement(list, element, IOSRunCaptureKindGeneric,
+                                 IOSRunAXRect(element, @selector(accessibilityFrame)),
+                                 IOSRunAXUnsigned(element, @selector(accessibilityTraits)),
+                                 IOSRunAXString(element, @selector(accessibilityLabel)),
+                                 IOSRunAXString(element, @selector(accessibilityIdentifier)),
+                                 wantsValue ? IOSRunAXString(element, @selector(accessibilityValue)) : nil,
+                                 wantsHint ? IOSRunAXString(element, @selector(accessibilityHint)) : nil,
+                                 elementPath);
         }
-        return elements;
     }
+}
 
-    // Keep AX fallback enabled when view traversal only sees SpringBoard overlays.
-    [elements removeAllObjects];
-    [elementRefs removeAllObjects];
-    [indexCounter removeAllObjects];
+// Any thread. Builds the element dictionaries for a capture list; with
+// interactiveOnly, views of overlay-ish classes are dropped here rather
+// than on main. refs (optional) receives the live object per element.
++ (NSMutableArray *)elementsFromCaptures:(const IOSRunCaptureList *)list
+                         interactiveOnly:(BOOL)interactiveOnly
+                                    refs:(NSMutableArray *)refs {
+    return [self elementsFromCaptures:list interactiveOnly:interactiveOnly fields:IOSRunTreeFieldsDefault refs:refs];
+}
 
-    // Fallback: AXRuntime cross-app elements
-    Class AXElementClass = NSClassFromString(@"AXElement");
-    if (!AXElementClass) {
-        return elements;
-    }
++ (NSMutableArray *)elementsFromCaptures:(const IOSRunCaptureList *)list
+                         interactiveOnly:(BOOL)interactiveOnly
+                                  fields:(IOSRunTreeFields)fields
+                                    refs:(NSMutableArray *)refs {
+    static NSArray<NSString *> *hiddenClassHints = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        hiddenClassHints = @[@"homegrabber", @"statusbar", @"overlay", @"keyboard", @"dock", @"assistive"];
+    });
 
-    @try {
-        id app = nil;
-        if ([AXElementClass respondsToSelector:@selector(primaryApp)]) {
-            app = [AXElementClass performSelector:@selector(primaryApp)];
+    NSMutableArray *elements = [NSMutableArray arrayWithCapacity:list->count];
+    for (NSUInteger i = 0; i < list->count; i++) {
+        const IOSRunCapture *capture = &list->items[i];
+        if (interactiveOnly && capture->kind == IOSRunCaptureKindView &&
+            IOSRunClassNameContainsAny(NSStringFromClass(capture->cls), hiddenClassHints)) {
+            continue;
         }
-        // Try to resolve the frontmost app using AXUIElement if primaryApp is nil
-        if (!app) {
-            CGPoint center = IOSRunPreferredProbePoint();
-            id uiApp = IOSRunAXUIElementAtPoint(center);
-            if (uiApp && [AXElementClass respondsToSelector:@selector(elementWithUIElement:)]) {
-                app = [AXElementClass performSelector:@selector(elementWithUIElement:) withObject:uiApp];
-            }
+        NSMutableDictionary *element = [self elementDictForCapture:capture fields:fields];
+        if (fields & IOSRunTreeFieldIndex) {
+            element[@"index"] = @(elements.count);
         }
-        id system = nil;
-        if ([AXElementClass respondsToSelector:@selector(systemWideElement)]) {
-            system = [AXElementClass performSelector:@selector(systemWideElement)];
+        [elements addObject:element];
+        if (refs) {
+            [refs addObject:(__bridge id)capture->ref ?: [NSNull null]];
         }
+    }
+    return elements;
+}
 
-        NSMutableArray *sources = [NSMutableArray array];
-        if (app) [sources addObject:app];
-        if (system && system != app) [sources addObject:system];
-
-        NSMutableSet<NSValue *> *visited = [NSMutableSet set];
-        NSUInteger count = 0;
++ (NSMutableDictionary *)elementDictForCapture:(const IOSRunCapture *)capture {
+    return [self elementDictForCapture:capture fields:IOSRunTreeFieldsDefault];
+}
 
-        for (id source in sources) {
-            if ([source respondsToSelector:@selector(nativeFocusableElements)]) {
-                NSArray *axElems = [source performSelector:@selector(nativeFocusableElements)];
-                for (id ax in axElems ?: @[]) {
-                    IOSRunAXCollectFromElement(ax, visited, elements, &count);
-                    [elementRefs addObject:ax ?: [NSNull null]];
-                    if (count >= kAXMaxElements) break;
-                }
-            }
++ (NSMutableDictionary *)elementDictForCapture:(const IOSRunCapture *)capture fields:(IOSRunTreeFields)fields {
+    CGRect frame = capture->frame;
+
+    NSMutableDictionary *dict = [NSMutableDictionary dictionaryWithCapacity:18];
+    if (fields & IOSRunTreeFieldType) {
+        switch (capture->kind) {
+            case IOSRunCaptureKindView:
+                dict[@"type"] = [self elementTypeForTraits:capture->traits viewClass:capture->cls];
+                break;
+            case IOSRunCaptureKindAccessibilityElement:
+                dict[@"type"] = [self elementTypeForTraits:capture->traits];
+                break;
+            case IOSRunCaptureKindGeneric:
+                dict[@"type"] = @"Other";
+                break;
+        }
+    }
+    if (fields & IOSRunTreeFieldClassName) {
+        dict[@"className"] = capture->kind == IOSRunCaptureKindAccessibilityElement
+            ? @"UIAccessibilityElement" : NSStringFromClass(capture->cls);
+    }
+    if (fields & IOSRunTreeFieldLabel) {
+        dict[@"label"] = IOSRunCapturedString(capture->label);
+    }
+    if (fields & IOSRunTreeFieldIdentifier) {
+        dict[@"identifier"] = IOSRunCapturedString(capture->identifier);
+    }
+    if (fields & IOSRunTreeFieldValue) {
+        dict[@"value"] = IOSRunCapturedString(capture->value);
+    }
+    if (fields & IOSRunTreeFieldHint) {
+        dict[@"hint"] = IOSRunCapturedString(capture->hint);
+    }
+    if (fields & IOSRunTreeFieldTraits) {
+        dict[@"traits"] = [self traitsToArray:capture->traits];
+    }
+    if (fields & IOSRunTreeFieldBounds) {
+        dict[@"bounds"] = [self rectToDict:frame];
+    }
+    if (fields & IOSRunTreeFieldRect) {
+        dict[@"rect"] = [NSString stringWithFormat:@"%.1f,%.1f,%.1f,%.1f",
+                         frame.origin.x, frame.origin.y,
+                         frame.size.width, frame.size.height];
+    }
+    if (fields & IOSRunTreeFieldCenter) {
+        dict[@"center_x"] = @(CGRectGetMidX(frame));
+        dict[@"center_y"] = @(CGRectGetMidY(frame));
+    }
+    if (fields & IOSRunTreeFieldEnabled) {
+        dict[@"enabled"] = @(capture->enabled);
+    }
+    if (fields & IOSRunTreeFieldVisible) {
+        dict[@"visible"] = @(capture->visible);
+    }
+    if ((fields & IOSRunTreeFieldPath) && capture->path) {
+        dict[@"path"] = (__bridge NSString *)capture->path;
+    }
+
+    BOOL wantsText = (fields & IOSRunTreeFieldText) != 0;
+    switch (capture->textKind) {
+        case IOSRunCaptureTextNone:
+            break;
+        case IOSRunCaptureTextPlain:
+            if (wantsText) {
+                dict[@"text"] = IOSRunCapturedString(capture->text);
+            }
+            break;
+        case IOSRunCaptureTextField:
+            if (wantsText) {
+                dict[@"text"] = IOSRunCapturedString(capture->text);
+                dict[@"placeholder"] = IOSRunCapturedString(capture->detail);
+            }
+            break;
+        case IOSRunCaptureTextCell: {
+            NSString *text = IOSRunCapturedString(capture->text);
+            NSString *detail = IOSRunCapturedString(capture->detail);
+            if ((fields & IOSRunTreeFieldLabel) && [dict[@"label"] length] == 0) {
+                dict[@"label"] = text;
+            }
+            if ((fields & IOSRunTreeFieldValue) && detail.length > 0) {
+                dict[@"value"] = detail;
+            }
+            if (wantsText && text.length > 0) {
+                dict[@"text"] = text;
+            }
+            break;
+        }
+    }
+    return dict;
+}
+
+#pragma mark - Full Tree
+
++ (NSDictionary *)getFullTree {
+    NSTimeInterval now = CACurrentMediaTime();
+    uint64_t generation = atomic_load(&contentGeneration);
+    @synchronized(self) {
+        if (cachedFullTree && IOSRunCacheEntryCurrent(cachedFullTreeGeneration, cachedFullTreeAt, now, kTreeCacheTTL)) {
+            atomic_fetch_add(&cacheHits, 1);
+            return cachedFullTree;
+        }
+    }
+    atomic_fetch_add(&cacheMisses, 1);
+
+    NSDictionary *result = [self buildTreeFromKeyWindow];
+    if (result) {
+        @synchronized(self) {
+            cachedFullTree = result;
+            cachedFullTreeAt = now;
+            cachedFullTreeGeneration = generation;
+        }
+    }
+    return result ?: @{@"error": @"No key window available"};
+}
+
++ (NSString *)getFullTreeAsJSON {
+    NSDictionary *tree = [self getFullTree];
+    NSError *error;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:tree
+                                                       options:0
+                                                         error:&error];
+    if (error) {
+        return [NSString stringWithFormat:@"{\"error\": \"%@\"}", error.localizedDescription];
+    }
+    return [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+}
 
-            if (count >= kAXMaxElements) break;
++ (NSDictionary *)buildTreeFromKeyWindow {
+    return [self getTreeWithRootIdentifier:nil
+                                 rootLabel:nil
+                                  rootPath:nil
+                                  maxDepth:-1
+                                    fields:nil
+                           interactiveOnly:NO
+                                     error:NULL];
+}
 
-            if ([source respondsToSelector:@selector(explorerElements)]) {
-                NSArray *axElems = [source performSelector:@selector(explorerElements)];
-                for (id ax in axElems ?: @[]) {
-                    IOSRunAXCollectFromElement(ax, visited, elements, &count);
-                    [elementRefs addObject:ax ?: [NSNull null]];
-                    if (count >= kAXMaxElements) break;
+#pragma mark - Tree Queries
+
+static IOSRunTreeFields IOSRunTreeFieldNamed(NSString *name) {
+    static NSDictionary<NSString *, NSNumber *> *fieldsByName = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        fieldsByName = @{
+            @"type": @(IOSRunTreeFieldType),
+            @"className": @(IOSRunTreeFieldClassName),
+            @"label": @(IOSRunTreeFieldLabel),
+            @"identifier": @(IOSRunTreeFieldIdentifier),
+            @"value": @(IOSRunTreeFieldValue),
+            @"hint": @(IOSRunTreeFieldHint),
+            @"traits": @(IOSRunTreeFieldTraits),
+            @"bounds": @(IOSRunTreeFieldBounds),
+            @"rect": @(IOSRunTreeFieldRect),
+            @"center": @(IOSRunTreeFieldCenter),
+            @"center_x": @(IOSRunTreeFieldCenter),
+            @"center_y": @(IOSRunTreeFieldCenter),
+            @"enabled": @(IOSRunTreeFieldEnabled),
+            @"visible": @(IOSRunTreeFieldVisible),
+            @"text": @(IOSRunTreeFieldText),
+            @"placeholder": @(IOSRunTreeFieldText),
+            @"index": @(IOSRunTreeFieldIndex),
+            @"path": @(IOSRunTreeFieldPath),
+            @"all": @(IOSRunTreeFieldsAll)
+        };
+    });
+    return (IOSRunTreeFields)[fieldsByName[name] unsignedIntValue];
+}
+
+// Keys of an already-built element (the interactive fallback) that fields
+// asks for; keys no field names are dropped.
+static NSDictionary *IOSRunProjectElement(NSDictionary *element, IOSRunTreeFields fields) {
+    if (![element isKindOfClass:[NSDictionary class]]) return element;
+    NSMutableDictionary *projected = [NSMutableDictionary dictionaryWithCapacity:element.count];
+    [element enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, __unused BOOL *stop) {
+        if (IOSRunTreeFieldNamed(key) & fields) {
+            projected[key] = value;
+        }
+    }];
+    return projected;
+}
+
+// Main thread only. "0.2.1" is subviews[0].subviews[2].subviews[1] of the
+// window; "" is the window.
+static UIView *IOSRunViewAtTreePath(UIView *window, NSString *path) {
+    UIView *view = window;
+    if (path.length == 0) return view;
+    NSCharacterSet *nonDigits = [[NSCharacterSet decimalDigitCharacterSet] invertedSet];
+    for (NSString *component in [path componentsSeparatedByString:@"."]) {
+        if (component.length == 0 || [component rangeOfCharacterFromSet:nonDigits].location != NSNotFound) {
+            return nil;
+        }
+        NSArray<UIView *> *subviews = view.subviews;
+        NSInteger index = component.integerValue;
+        if (index >= (NSInteger)subviews.count) {
+            return nil;
+        }
+        view = subviews[index];
+    }
+    return view;
+}
+
+// Main thread only. First visible view, depth first, whose identifier and
+// label equal the given ones (either may be empty). The identifier is a
+// stored property and is compared first; labels may be computed.
+static UIView *IOSRunFindTreeRoot(UIView *view,
+                                  NSString *identifier,
+                                  NSString *label,
+                                  NSString *path,
+                                  int depth,
+                                  NSString **pathOut) {
+    if (!view || view.hidden || view.alpha < 0.01 || depth > kTreeMaxDepth) {
+        return nil;
+    }
+    if ((identifier.length == 0 || [view.accessibilityIdentifier isEqualToString:identifier]) &&
+        (label.length == 0 || [view.accessibilityLabel isEqualToString:label])) {
+        *pathOut = path;
+        return view;
+    }
+    NSArray<UIView *> *subviews = view.subviews;
+    for (NSUInteger i = 0; i < subviews.count; i++) {
+        UIView *found = IOSRunFindTreeRoot(subviews[i], identifier, label, IOSRunChildTreePath(path, i),
+                                           depth + 1, pathOut);
+        if (found) {
+            return found;
+        }
+    }
+    return nil;
+}
+
+static NSError *IOSRunTreeError(NSInteger code, NSString *message) {
+    return [NSError errorWithDomain:@"KimiRunA11y" code:code userInfo:@{NSLocalizedDescriptionKey: message}];
+}
+
+static BOOL IOSRunTreeWalkForQuery(NSInteger maxDepth,
+                                   NSString *fields,
+                                   BOOL interactiveOnly,
+                                   IOSRunCaptureWalk *walk,
+                                   NSError **error) {
+    IOSRunTreeFields mask = IOSRunTreeFieldsDefault;
+    if (fields.length > 0) {
+        mask = 0;
+        NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+        for (NSString *component in [fields componentsSeparatedByString:@","]) {
+            NSString *name = [component stringByTrimmingCharactersInSet:whitespace];
+            if (name.length == 0) continue;
+            IOSRunTreeFields field = IOSRunTreeFieldNamed(name);
+            if (!field) {
+                if (error) {
+                    *error = IOSRunTreeError(400, [NSString stringWithFormat:@"Unknown field: %@", name]);
                 }
+                return NO;
             }
+            mask |= field;
+        }
+    }
+    memset(walk, 0, sizeof(*walk));
+    walk->maxDepth = maxDepth < 0 ? kTreeDefaultDepth : (int)MIN(maxDepth, (NSInteger)kTreeMaxDepth);
+    walk->interactiveOnly = interactiveOnly;
+    walk->fields = mask;
+    return YES;
+}
+
+// Main thread only. The window itself when no selector is given, else the
+// selected view or nil. pathOut receives the root's path when the walk
+// emits paths.
+static UIView *IOSRunTreeRootForQuery(UIWindow *window,
+                                      NSString *rootIdentifier,
+                                      NSString *rootLabel,
+                                      NSString *rootPath,
+                                      IOSRunTreeFields fields,
+                                      NSString **pathOut) {
+    NSString *path = rootPath ?: @"";
+    UIView *root = window;
+    if (rootPath) {
+        root = IOSRunViewAtTreePath(window, rootPath);
+    } else if (rootIdentifier.length > 0 || rootLabel.length > 0) {
+        root = IOSRunFindTreeRoot(window, rootIdentifier, rootLabel, @"", 0, &path);
+    }
+    *pathOut = (fields & IOSRunTreeFieldPath) ? path : nil;
+    return root;
+}
+
+// Main thread only. The selected root as a node of its own, whatever
+// interactiveOnly would say about it; the walk starts at its children.
+static void IOSRunCaptureTreeRoot(IOSRunCaptureList *list, UIView *root, IOSRunTreeFields fields, NSString *path) {
+    IOSRunCaptureView(list, root, root.accessibilityTraits, root.accessibilityLabel,
+                      root.accessibilityIdentifier,
+                      (fields & IOSRunTreeFieldValue) ? root.accessibilityValue : nil,
+                      (fields & IOSRunTreeFieldHint) ? root.accessibilityHint : nil,
+                      fields, path);
+}
+
++ (NSDictionary *)getTreeWithRootIdentifier:(NSString *)rootIdentifier
+                                  rootLabel:(NSString *)rootLabel
+                                   rootPath:(NSString *)rootPath
+                                   maxDepth:(NSInteger)maxDepth
+                                     fields:(NSString *)fields
+                            interactiveOnly:(BOOL)interactiveOnly
+                                      error:(NSError **)error {
+    IOSRunCaptureWalk walk;
+    if (!IOSRunTreeWalkForQuery(maxDepth, fields, interactiveOnly, &walk, error)) {
+        return nil;
+    }
+    IOSRunTreeFields mask = walk.fields;
+    BOOL hasRoot = rootPath != nil || rootIdentifier.length > 0 || rootLabel.length > 0;
+
+    IOSRunCaptureList captures = {0};
+    IOSRunCaptureList rootCapture = {0};
+    IOSRunCaptureList *capturesRef = &captures;
+    IOSRunCaptureList *rootCaptureRef = &rootCapture;
+    IOSRunCaptureWalk *walkRef = &walk;
+    __block BOOL hasWindow = NO;
+    __block BOOL foundRoot = NO;
+    __block CGRect windowBounds = CGRectZero;
+    IOSRunSyncOnMain(^{
+        UIWindow *keyWindow = IOSRunPreferredWindow();
+        if (!keyWindow) return;
+        hasWindow = YES;
+        windowBounds = keyWindow.bounds;
+        NSString *path = nil;
+        UIView *root = IOSRunTreeRootForQuery(keyWindow, rootIdentifier, rootLabel, rootPath, mask, &path);
+        if (!root) return;
+        foundRoot = YES;
+        if (!hasRoot) {
+            [self captureFromView:keyWindow depth:0 path:path walk:walkRef into:capturesRef];
+            return;
+        }
+        IOSRunCaptureTreeRoot(rootCaptureRef, root, mask, path);
+        [self captureChildrenOfView:root depth:0 path:path walk:walkRef into:capturesRef];
+    });
+
+    if (!hasWindow) {
+        return @{@"error": @"No window found"};
+    }
+    if (!foundRoot) {
+        if (error) {
+            *error = IOSRunTreeError(404, @"Root not found");
+        }
+        return nil;
+    }
+    NSArray *viewChildren = [self elementsFromCaptures:&captures interactiveOnly:interactiveOnly fields:mask refs:nil];
+    NSMutableDictionary *node = rootCapture.count > 0
+        ? [self elementDictForCapture:&rootCapture.items[0] fields:mask]
+        : [@{@"type": @"Window", @"bounds": [self rectToDict:windowBounds]} mutableCopy];
+    IOSRunCaptureListFree(&captures);
+    IOSRunCaptureListFree(&rootCapture);
+
+    // Foreground recovery fallback:
+    // If key-window traversal yields no useful nodes, reuse interactive/AX
+    // collection so /uiHierarchy still represents the current foreground UI.
+    if (!hasRoot && viewChildren.count == 0) {
+        BOOL truncated = NO;
+        NSArray *interactiveFallback = [self collectInteractiveElementsTruncated:&truncated];
+        if ([interactiveFallback isKindOfClass:[NSArray class]] && interactiveFallback.count > 0) {
+            if (fields.length > 0) {
+                NSMutableArray *projected = [NSMutableArray arrayWithCapacity:interactiveFallback.count];
+                for (NSDictionary *element in interactiveFallback) {
+                    [projected addObject:IOSRunProjectElement(element, mask)];
+                }
+                interactiveFallback = projected;
+            }
+            node[@"children"] = interactiveFallback;
+            node[@"source"] = @"interactive_fallback";
+            node[@"truncated"] = @(truncated);
+            return node;
+        }
+    }
+
+    node[@"children"] = viewChildren;
+    return node;
+}
+
+#pragma mark - Streamed Tree
+
+static BOOL IOSRunJSONWriteString(KimiRunA11yJSONStream *json, NSString *string) {
+    const char *utf8 = string.UTF8String;
+    return KimiRunA11yJSONString(json, utf8, utf8 ? strlen(utf8) : 0);
+}
+
+static BOOL IOSRunJSONWriteObject(KimiRunA11yJSONStream *json, id object);
+
+static BOOL IOSRunJSONWriteMembers(KimiRunA11yJSONStream *json, NSDictionary *dict) {
+    for (id key in dict) {
+        const char *name = [key isKindOfClass:[NSString class]] ? [key UTF8String] : [[key description] UTF8String];
+        if (!KimiRunA11yJSONKey(json, name ?: "") || !IOSRunJSONWriteObject(json, dict[key])) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// The element dictionaries' value types; anything else is written as its
+// description.
+static BOOL IOSRunJSONWriteObject(KimiRunA11yJSONStream *json, id object) {
+    if ([object isKindOfClass:[NSString class]]) {
+        return IOSRunJSONWriteString(json, object);
+    }
+    if ([object isKindOfClass:[NSNumber class]]) {
+        NSNumber *number = object;
+        if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+            return KimiRunA11yJSONBool(json, number.boolValue);
+        }
+        switch (number.objCType[0]) {
+            case 'f':
+            case 'd':
+                return KimiRunA11yJSONDouble(json, number.doubleValue);
+            case 'Q':
+            case 'L':
+            case 'I':
+            case 'S':
+            case 'C':
+                return KimiRunA11yJSONUnsigned(json, number.unsignedLongLongValue);
+            default:
+                return KimiRunA11yJSONInteger(json, number.longLongValue);
+        }
+    }
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        return KimiRunA11yJSONBeginObject(json) &&
+               IOSRunJSONWriteMembers(json, object) &&
+               KimiRunA11yJSONEndObject(json);
+    }
+    if ([object isKindOfClass:[NSArray class]]) {
+        if (!KimiRunA11yJSONBeginArray(json)) {
+            return NO;
+        }
+        for (id item in (NSArray *)object) {
+            if (!IOSRunJSONWriteObject(json, item)) {
+                return NO;
+            }
+        }
+        return KimiRunA11yJSONEndArray(json);
+    }
+    if (!object || object == [NSNull null]) {
+        return KimiRunA11yJSONNull(json);
+    }
+    return IOSRunJSONWriteString(json, [object description]);
+}
+
+// A streamed walk. Off main, the main thread only captures: full batches
+// are handed to the calling thread through a ring of kTreeStreamHandoffDepth
+// lists, and that thread builds and writes them. A caller on main writes
+// each batch itself as it fills.
+typedef struct {
+    KimiRunA11yJSONStream *json;
+    IOSRunTreeFields fields;
+    BOOL interactiveOnly;
+    BOOL hasRoot;
+    NSUInteger emitted;
+    BOOL handoff;
+    __unsafe_unretained dispatch_semaphore_t slots;   // free ring entries
+    __unsafe_unretained dispatch_semaphore_t filled;  // the root, each batch, then the end
+    IOSRunCaptureList ring[kTreeStreamHandoffDepth];
+    _Atomic NSUInteger head;            // advanced on main
+    NSUInteger tail;                    // advanced by the writer
+    _Atomic bool cancelled;             // the writer failed; main stops walking
+    // Set on main before the first signal of filled.
+    BOOL hasWindow;
+    BOOL foundRoot;
+    CGRect windowBounds;
+    IOSRunCaptureList root;
+} IOSRunTreeStream;
+
+// Any thread. Writes the captures as children; the caller frees the list.
+static BOOL IOSRunTreeStreamWrite(IOSRunCaptureList *list, IOSRunTreeStream *tree) {
+    @autoreleasepool {
+        // Indexes run across batches, so they are numbered here.
+        NSArray *elements = [AccessibilityTree elementsFromCaptures:list
+                                                    interactiveOnly:tree->interactiveOnly
+                                                             fields:(tree->fields & ~IOSRunTreeFieldIndex)
+                                                               refs:nil];
+        for (NSMutableDictionary *element in elements) {
+            if (tree->fields & IOSRunTreeFieldIndex) {
+                element[@"index"] = @(tree->emitted);
+            }
+            tree->emitted++;
+            if (!IOSRunJSONWriteObject(tree->json, element)) {
+                break;
+            }
+        }
+    }
+    return !tree->json->failed;
+}
+
+// Any thread. The root node up to its open children array.
+static void IOSRunTreeStreamWriteHead(IOSRunTreeStream *tree) {
+    KimiRunA11yJSONStream *json = tree->json;
+    KimiRunA11yJSONBeginObject(json);
+    if (tree->hasRoot) {
+        if (tree->root.count > 0) {
+            @autoreleasepool {
+                IOSRunJSONWriteMembers(json, [AccessibilityTree elementDictForCapture:&tree->root.items[0]
+                                                                               fields:tree->fields]);
+            }
+        }
+    } else {
+        KimiRunA11yJSONKey(json, "type");
+        KimiRunA11yJSONString(json, "Window", 6);
+        KimiRunA11yJSONKey(json, "bounds");
+        IOSRunJSONWriteObject(json, [AccessibilityTree rectToDict:tree->windowBounds]);
+    }
+    KimiRunA11yJSONKey(json, "children");
+    KimiRunA11yJSONBeginArray(json);
+}
+
+static BOOL IOSRunTreeStreamCancelled(IOSRunTreeStream *tree) {
+    return tree->handoff ? atomic_load(&tree->cancelled) : tree->json->failed;
+}
+
+// Main thread only. Passes the captures on and leaves the list empty. The
+// writer gets kTreeStreamHandoffWait to make room; a writer stuck that long
+// on the socket ends the walk rather than holding main.
+static BOOL IOSRunTreeStreamHandOver(IOSRunCaptureList *list, IOSRunTreeStream *tree) {
+    if (!tree->handoff) {
+        BOOL written = IOSRunTreeStreamWrite(list, tree);
+        IOSRunCaptureListClear(list);
+        return written;
+    }
+    if (list->count == 0) {
+        return YES;
+    }
+    dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kTreeStreamHandoffWait * NSEC_PER_SEC));
+    if (atomic_load(&tree->cancelled) || dispatch_semaphore_wait(tree->slots, deadline) != 0) {
+        atomic_store(&tree->cancelled, true);
+        IOSRunCaptureListClear(list);
+        return NO;
+    }
+    NSUInteger head = atomic_load(&tree->head);
+    tree->ring[head % kTreeStreamHandoffDepth] = *list;
+    memset(list, 0, sizeof(*list));
+    atomic_store(&tree->head, head + 1);
+    dispatch_semaphore_signal(tree->filled);
+    return YES;
+}
+
+static BOOL IOSRunTreeStreamDrain(IOSRunCaptureList *list, void *context) {
+    IOSRunTreeStream *tree = context;
+    if (IOSRunTreeStreamCancelled(tree)) {
+        return NO;
+    }
+    return list->count < kTreeStreamBatch || IOSRunTreeStreamHandOver(list, tree);
+}
+
+// Writer side of the handoff. NO once main has finished the walk.
+static BOOL IOSRunTreeStreamNextBatch(IOSRunTreeStream *tree, IOSRunCaptureList *batch) {
+    dispatch_semaphore_wait(tree->filled, DISPATCH_TIME_FOREVER);
+    NSUInteger tail = tree->tail;
+    if (tail == atomic_load(&tree->head)) {
+        return NO;
+    }
+    *batch = tree->ring[tail % kTreeStreamHandoffDepth];
+    tree->tail = tail + 1;
+    dispatch_semaphore_signal(tree->slots);
+    return YES;
+}
+
++ (BOOL)writeFullTreeToJSON:(KimiRunA11yJSONStream *)json {
+    NSTimeInterval now = CACurrentMediaTime();
+    NSDictionary *cached = nil;
+    @synchronized(self) {
+        if (cachedFullTree && IOSRunCacheEntryCurrent(cachedFullTreeGeneration, cachedFullTreeAt, now, kTreeCacheTTL)) {
+            cached = cachedFullTree;
+        }
+    }
+    if (cached) {
+        atomic_fetch_add(&cacheHits, 1);
+        return IOSRunJSONWriteObject(json, cached);
+    }
+    atomic_fetch_add(&cacheMisses, 1);
+    return [self writeTreeWithRootIdentifier:nil
+                                   rootLabel:nil
+                                    rootPath:nil
+                                    maxDepth:-1
+                                      fields:nil
+                             interactiveOnly:NO
+                                      toJSON:json
+                                       error:NULL];
+}
+
+// Main thread only. Finds the root, then walks below it handing batches
+// over. With a handoff, filled is signalled once the root is known and
+// again when the walk is done; the stream may be gone after either.
++ (void)captureTreeForStream:(IOSRunTreeStream *)tree
+                        walk:(const IOSRunCaptureWalk *)walk
+             rootIdentifier:(NSString *)rootIdentifier
+                  rootLabel:(NSString *)rootLabel
+                   rootPath:(NSString *)rootPath {
+    UIWindow *keyWindow = IOSRunPreferredWindow();
+    NSString *path = nil;
+    UIView *root = keyWindow ? IOSRunTreeRootForQuery(keyWindow, rootIdentifier, rootLabel, rootPath, tree->fields, &path)
+                             : nil;
+    tree->hasWindow = keyWindow != nil;
+    tree->foundRoot = root != nil;
+    if (root) {
+        tree->windowBounds = keyWindow.bounds;
+        if (tree->hasRoot) {
+            IOSRunCaptureTreeRoot(&tree->root, root, tree->fields, path);
+        }
+    }
+    BOOL handoff = tree->handoff;
+    dispatch_semaphore_t filled = tree->filled;
+    if (!root) {
+        if (handoff) {
+            dispatch_semaphore_signal(filled);
+        }
+        return;
+    }
+    if (handoff) {
+        dispatch_semaphore_signal(filled);
+    } else {
+        IOSRunTreeStreamWriteHead(tree);
+    }
+
+    IOSRunCaptureList captures = {0};
+    if (tree->hasRoot) {
+        [self captureChildrenOfView:root depth:0 path:path walk:walk into:&captures];
+    } else {
+        [self captureFromView:keyWindow depth:0 path:path walk:walk into:&captures];
+    }
+    if (!IOSRunTreeStreamCancelled(tree)) {
+        IOSRunTreeStreamHandOver(&captures, tree);
+    }
+    IOSRunCaptureListFree(&captures);
+    if (handoff) {
+        dispatch_semaphore_signal(filled);
+    }
+}
+
++ (BOOL)writeTreeWithRootIdentifier:(NSString *)rootIdentifier
+                          rootLabel:(NSString *)rootLabel
+                           rootPath:(NSString *)rootPath
+                           maxDepth:(NSInteger)maxDepth
+                             fields:(NSString *)fields
+                    interactiveOnly:(BOOL)interactiveOnly
+                             toJSON:(KimiRunA11yJSONStream *)json
+                              error:(NSError **)error {
+    IOSRunCaptureWalk walk;
+    if (!IOSRunTreeWalkForQuery(maxDepth, fields, interactiveOnly, &walk, error)) {
+        return NO;
+    }
+    IOSRunTreeFields mask = walk.fields;
+    IOSRunTreeStream tree;
+    memset(&tree, 0, sizeof(tree));
+    tree.json = json;
+    tree.fields = mask;
+    tree.interactiveOnly = interactiveOnly;
+    tree.hasRoot = rootPath != nil || rootIdentifier.length > 0 || rootLabel.length > 0;
+    tree.handoff = ![NSThread isMainThread];
+    walk.drain = IOSRunTreeStreamDrain;
+    walk.drainContext = &tree;
+
+    // Nothing is written before the root is known.
+    if (!tree.handoff) {
+        [self captureTreeForStream:&tree walk:&walk rootIdentifier:rootIdentifier rootLabel:rootLabel rootPath:rootPath];
+    } else {
+        // Held here for the whole exchange; the stream only borrows them.
+        dispatch_semaphore_t slots = dispatch_semaphore_create((long)kTreeStreamHandoffDepth);
+        dispatch_semaphore_t filled = dispatch_semaphore_create(0);
+        tree.slots = slots;
+        tree.filled = filled;
+        IOSRunTreeStream *treeRef = &tree;
+        IOSRunCaptureWalk *walkRef = &walk;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self captureTreeForStream:treeRef walk:walkRef rootIdentifier:rootIdentifier rootLabel:rootLabel rootPath:rootPath];
+        });
+        dispatch_semaphore_wait(tree.filled, DISPATCH_TIME_FOREVER);
+        if (tree.foundRoot) {
+            IOSRunTreeStreamWriteHead(&tree);
+            IOSRunCaptureList batch;
+            while (IOSRunTreeStreamNextBatch(&tree, &batch)) {
+                if (!json->failed) {
+                    IOSRunTreeStreamWrite(&batch, &tree);
+                }
+                if (json->failed) {
+                    atomic_store(&tree.cancelled, true);
+                }
+                IOSRunCaptureListFree(&batch);
+            }
+        }
+    }
+    IOSRunCaptureListFree(&tree.root);
+
+    if (!tree.hasWindow) {
+        return IOSRunJSONWriteObject(json, @{@"error": @"No window found"});
+    }
+    if (!tree.foundRoot) {
+        if (error) {
+            *error = IOSRunTreeError(404, @"Root not found");
+        }
+        return NO;
+    }
+
+    // Same foreground recovery as getTreeWithRootIdentifier:..., into the
+    // children array that is still open.
+    if (!tree.hasRoot && tree.emitted == 0 && !json->failed) {
+        BOOL truncated = NO;
+        NSArray *interactiveFallback = [self collectInteractiveElementsTruncated:&truncated];
+        if ([interactiveFallback isKindOfClass:[NSArray class]] && interactiveFallback.count > 0) {
+            for (NSDictionary *element in interactiveFallback) {
+                IOSRunJSONWriteObject(json, fields.length > 0 ? IOSRunProjectElement(element, mask) : element);
+            }
+            KimiRunA11yJSONEndArray(json);
+            KimiRunA11yJSONKey(json, "source");
+            KimiRunA11yJSONString(json, "interactive_fallback", 20);
+            KimiRunA11yJSONKey(json, "truncated");
+            KimiRunA11yJSONBool(json, truncated);
+            KimiRunA11yJSONEndObject(json);
+            return !json->failed;
+        }
+    }
+    KimiRunA11yJSONEndArray(json);
+    KimiRunA11yJSONEndObject(json);
+    return !json->failed;
+}
+
++ (NSMutableDictionary *)elementDictForView:(UIView *)view {
+    IOSRunCaptureList list = {0};
+    IOSRunCaptureView(&list, view, view.accessibilityTraits, view.accessibilityLabel,
+                      view.accessibilityIdentifier, view.accessibilityValue, view.accessibilityHint,
+                      IOSRunTreeFieldsDefault, nil);
+    NSMutableDictionary *dict = list.count > 0 ? [self elementDictForCapture:&list.items[0]]
+                                               : [NSMutableDictionary dictionary];
+    IOSRunCaptureListFree(&list);
+    return dict;
+}
+
+// Class checks go through the class hierarchy only, so this is safe off main.
++ (NSString *)elementTypeForTraits:(UIAccessibilityTraits)traits viewClass:(Class)cls {
+    // Check traits first
+    NSString *traitType = [self elementTypeForTraits:traits];
+    if (![traitType isEqualToString:@"Other"]) {
+        return traitType;
+    }
+
+    // Check class
+    if ([cls isSubclassOfClass:[UIButton class]]) return @"Button";
+    if ([cls isSubclassOfClass:[UILabel class]]) return @"StaticText";
+    if ([cls isSubclassOfClass:[UITextField class]]) return @"TextField";
+    if ([cls isSubclassOfClass:[UITextView class]]) return @"TextArea";
+    if ([cls isSubclassOfClass:[UISwitch class]]) return @"Switch";
+    if ([cls isSubclassOfClass:[UISlider class]]) return @"Slider";
+    if ([cls isSubclassOfClass:[UIStepper class]]) return @"Stepper";
+    if ([cls isSubclassOfClass:[UISegmentedControl class]]) return @"SegmentedControl";
+    if ([cls isSubclassOfClass:[UITableViewCell class]]) return @"Cell";
+    if ([cls isSubclassOfClass:[UICollectionViewCell class]]) return @"Cell";
+    if ([cls isSubclassOfClass:[UIImageView class]]) return @"Image";
+    if ([cls isSubclassOfClass:[UIScrollView class]]) return @"ScrollView";
+
+    return @"Other";
+}
+
++ (NSString *)elementTypeForTraits:(UIAccessibilityTraits)traits {
+    if (traits & UIAccessibilityTraitButton) return @"Button";
+    if (traits & UIAccessibilityTraitLink) return @"Link";
+    if (traits & UIAccessibilityTraitSearchField) return @"SearchField";
+    if (traits & UIAccessibilityTraitKeyboardKey) return @"KeyboardKey";
+    if (traits & UIAccessibilityTraitStaticText) return @"StaticText";
+    if (traits & UIAccessibilityTraitImage) return @"Image";
+    if (traits & UIAccessibilityTraitHeader) return @"Header";
+    if (traits & UIAccessibilityTraitTabBar) return @"TabBar";
+    if (traits & UIAccessibilityTraitAdjustable) return @"Adjustable";
+    return @"Other";
+}
+
++ (NSArray *)traitsToArray:(UIAccessibilityTraits)traits {
+    NSMutableArray *arr = [NSMutableArray array];
+    if (traits & UIAccessibilityTraitButton) [arr addObject:@"Button"];
+    if (traits & UIAccessibilityTraitLink) [arr addObject:@"Link"];
+    if (traits & UIAccessibilityTraitSearchField) [arr addObject:@"SearchField"];
+    if (traits & UIAccessibilityTraitImage) [arr addObject:@"Image"];
+    if (traits & UIAccessibilityTraitSelected) [arr addObject:@"Selected"];
+    if (traits & UIAccessibilityTraitNotEnabled) [arr addObject:@"NotEnabled"];
+    if (traits & UIAccessibilityTraitStaticText) [arr addObject:@"StaticText"];
+    if (traits & UIAccessibilityTraitHeader) [arr addObject:@"Header"];
+    if (traits & UIAccessibilityTraitAdjustable) [arr addObject:@"Adjustable"];
+    return arr;
+}
+
++ (NSDictionary *)rectToDict:(CGRect)rect {
+    return @{
+        @"x": @(rect.origin.x),
+        @"y": @(rect.origin.y),
+        @"width": @(rect.size.width),
+        @"height": @(rect.size.height)
+    };
+}
+
+#pragma mark - Interactive Elements
+
++ (NSArray<NSDictionary *> *)getInteractiveElements {
+    NSTimeInterval now = CACurrentMediaTime();
+    uint64_t generation = atomic_load(&contentGeneration);
+    @synchronized(self) {
+        if (cachedInteractive && IOSRunCacheEntryCurrent(cachedInteractiveGeneration, cachedInteractiveAt, now, kInteractiveCacheTTL)) {
+            atomic_fetch_add(&cacheHits, 1);
+            return cachedInteractive;
+        }
+    }
+    atomic_fetch_add(&cacheMisses, 1);
+
+    BOOL truncated = NO;
+    NSArray *result = [self collectInteractiveElementsTruncated:&truncated];
+    if (result) {
+        [self commitInteractiveSnapshot:result];
+        [self indexInteractiveElements:result];
+        @synchronized(self) {
+            cachedInteractive = result;
+            cachedInteractiveAt = now;
+            // A partial AX list is served once, then collected again.
+            cachedInteractiveGeneration = truncated ? 0 : generation;
+            cachedInteractiveTruncated = truncated;
+        }
+    }
+    return result ?: @[];
+}
+
+#pragma mark - Interactive Snapshots
+
+static uint64_t IOSRunSnapshotHashString(uint64_t seed, NSString *string) {
+    const char *utf8 = [string isKindOfClass:[NSString class]] ? string.UTF8String : NULL;
+    // Length-terminated so ("ab","c") and ("a","bc") differ.
+    uint64_t hash = utf8 ? KimiRunA11yHash(seed, utf8, strlen(utf8)) : seed;
+    return KimiRunA11yHashU64(hash, utf8 ? strlen(utf8) : UINT64_MAX);
+}
+
+static uint64_t IOSRunSnapshotKey(NSDictionary *element, id ref) {
+    uint64_t key = IOSRunSnapshotHashString(KIMIRUN_A11Y_HASH_SEED, element[@"className"]);
+    if (ref && ref != (id)[NSNull null]) {
+        // The live object is the identity while it exists. UIKit reuses
+        // cells; a reused cell shows up as changed, not removed + added.
+        return KimiRunA11yHashU64(key, (uint64_t)(uintptr_t)(__bridge void *)ref);
+    }
+    // AX fallback objects are recreated on every query: identify by content.
+    NSString *identifier = element[@"identifier"];
+    if ([identifier isKindOfClass:[NSString class]] && identifier.length > 0) {
+        return IOSRunSnapshotHashString(key, identifier);
+    }
+    key = IOSRunSnapshotHashString(key, element[@"label"]);
+    key = KimiRunA11yHashU64(key, (uint64_t)llround([element[@"center_x"] doubleValue]));
+    return KimiRunA11yHashU64(key, (uint64_t)llround([element[@"center_y"] doubleValue]));
+}
 
-            if (count >= kAXMaxElements) break;
+static uint64_t IOSRunSnapshotContentHash(NSDictionary *element) {
+    static NSArray<NSString *> *fields = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        fields = @[@"type", @"className", @"label", @"identifier", @"value", @"hint",
+                   @"text", @"placeholder", @"rect", @"traits", @"enabled", @"visible",
+                   @"processName", @"bundleID"];
+    });
+    uint64_t hash = KIMIRUN_A11Y_HASH_SEED;
+    for (NSString *field in fields) {
+        id value = element[field];
+        if (!value) {
+            hash = KimiRunA11yHashU64(hash, 0);
+            continue;
+        }
+        NSString *text = [value isKindOfClass:[NSString class]] ? value : [value description];
+        hash = IOSRunSnapshotHashString(IOSRunSnapshotHashString(hash, field), text);
+    }
+    return hash;
+}
 
-            if ([source respondsToSelector:@selector(elementsWithSemanticContext)]) {
-                NSArray *axElems = [source performSelector:@selector(elementsWithSemanticContext)];
-                for (id ax in axElems ?: @[]) {
-                    IOSRunAXCollectFromElement(ax, visited, elements, &count);
-                    [elementRefs addObject:ax ?: [NSNull null]];
-                    if (count >= kAXMaxElements) break;
+// Give a fresh collection its stable keys and record it as a snapshot.
+// "index" is left out of the content hash; moves are reported as order.
++ (void)commitInteractiveSnapshot:(NSArray *)elements {
+    @synchronized(self) {
+        if (!interactiveSnapshots) {
+            interactiveSnapshots = KimiRunA11yStoreCreate(0);
+            if (!interactiveSnapshots) {
+                return;
+            }
+        }
+        NSArray *refs = (lastInteractiveRefsAligned && lastInteractiveElements.count == elements.count)
+            ? lastInteractiveElements : nil;
+        uint32_t count = (uint32_t)elements.count;
+        KimiRunA11yEntry *entries = malloc((size_t)(count ? count : 1) * sizeof(*entries));
+        if (!entries) {
+            return;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            NSDictionary *element = elements[i];
+            entries[i].key = IOSRunSnapshotKey(element, refs ? refs[i] : nil);
+            entries[i].hash = IOSRunSnapshotContentHash(element);
+        }
+        if (KimiRunA11yStoreCommit(interactiveSnapshots, entries, count, NULL) != 0) {
+            for (uint32_t i = 0; i < count; i++) {
+                NSMutableDictionary *element = elements[i];
+                if ([element isKindOfClass:[NSMutableDictionary class]]) {
+                    element[@"key"] = [NSString stringWithFormat:@"%016llx", (unsigned long long)entries[i].key];
                 }
             }
+            interactiveSnapshotElements = elements;
+        }
+        free(entries);
+    }
+}
 
-            if (count >= kAXMaxElements) break;
++ (NSDictionary *)getInteractiveElementsSince:(uint64_t)since {
+    NSArray *elements = [self getInteractiveElements];
+    @synchronized(self) {
+        NSArray *current = interactiveSnapshotElements ?: elements;
+        KimiRunA11yDelta delta;
+        if (!interactiveSnapshots || !KimiRunA11yStoreDiff(interactiveSnapshots, since, &delta)) {
+            return @{@"sequence": @0, @"since": @(since), @"full": @YES, @"truncated": @(cachedInteractiveTruncated),
+                     @"count": @(elements.count), @"elements": elements ?: @[]};
+        }
+        NSMutableDictionary *payload = [NSMutableDictionary dictionary];
+        payload[@"sequence"] = @(delta.sequence);
+        payload[@"since"] = @(since);
+        payload[@"full"] = @(delta.full);
+        payload[@"truncated"] = @(cachedInteractiveTruncated);
+        payload[@"count"] = @(current.count);
+        if (delta.full) {
+            payload[@"elements"] = current;
+            KimiRunA11yDeltaFree(&delta);
+            return payload;
+        }
+        NSMutableArray *added = [NSMutableArray arrayWithCapacity:delta.addedCount];
+        for (uint32_t i = 0; i < delta.addedCount; i++) {
+            [added addObject:current[delta.added[i]]];
+        }
+        NSMutableArray *changed = [NSMutableArray arrayWithCapacity:delta.changedCount];
+        for (uint32_t i = 0; i < delta.changedCount; i++) {
+            [changed addObject:current[delta.changed[i]]];
+        }
+        NSMutableArray *removed = [NSMutableArray arrayWithCapacity:delta.removedCount];
+        for (uint32_t i = 0; i < delta.removedCount; i++) {
+            [removed addObject:[NSString stringWithFormat:@"%016llx", (unsigned long long)delta.removed[i]]];
+        }
+        payload[@"added"] = added;
+        payload[@"changed"] = changed;
+        payload[@"removed"] = removed;
+        if (delta.orderChanged) {
+            NSMutableArray *order = [NSMutableArray arrayWithCapacity:current.count];
+            for (NSDictionary *element in current) {
+                [order addObject:element[@"key"] ?: @""];
+            }
+            payload[@"order"] = order;
+        }
+        KimiRunA11yDeltaFree(&delta);
+        return payload;
+    }
+}
+
++ (NSString *)getInteractiveElementsAsJSON {
+    NSArray *elements = [self getInteractiveElements];
+    if (overlayEnabled) {
+        [self refreshOverlayWithElements:elements];
+    }
+    NSError *error;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:elements
+                                                       options:0
+                                                         error:&error];
+    if (error) {
+        return @"[]";
+    }
+    return [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - Encodings
 
-            if ([source respondsToSelector:@selector(firstElementInApplication)]) {
-                id root = [source performSelector:@selector(firstElementInApplication)];
-                IOSRunAXCollectFromElement(root, visited, elements, &count);
-                [elementRefs addObject:root ?: [NSNull null]];
+static const char *IOSRunEncodeString(id value) {
+    return [value isKindOfClass:[NSString class]] ? [value UTF8String] : NULL;
+}
+
+static NSString *IOSRunDecodedString(const char *value) {
+    return value ? ([NSString stringWithUTF8String:value] ?: @"") : @"";
+}
+
+// Row dicts carry trait names; AX fallback rows carry the raw bitmask.
+static uint64_t IOSRunTraitsBitmask(id traits) {
+    if ([traits isKindOfClass:[NSNumber class]]) {
+        return [traits unsignedLongLongValue];
+    }
+    if (![traits isKindOfClass:[NSArray class]]) {
+        return 0;
+    }
+    static NSDictionary<NSString *, NSNumber *> *bits = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        bits = @{
+            @"Button": @(UIAccessibilityTraitButton),
+            @"Link": @(UIAccessibilityTraitLink),
+            @"SearchField": @(UIAccessibilityTraitSearchField),
+            @"Image": @(UIAccessibilityTraitImage),
+            @"Selected": @(UIAccessibilityTraitSelected),
+            @"NotEnabled": @(UIAccessibilityTraitNotEnabled),
+            @"StaticText": @(UIAccessibilityTraitStaticText),
+            @"Header": @(UIAccessibilityTraitHeader),
+            @"Adjustable": @(UIAccessibilityTraitAdjustable)
+        };
+    });
+    uint64_t mask = 0;
+    for (id name in (NSArray *)traits) {
+        mask |= [bits[name] unsignedLongLongValue];
+    }
+    return mask;
+}
+
+static void IOSRunEncodeFill(KimiRunA11yElement *item, NSDictionary *element) {
+    item->type = IOSRunEncodeString(element[@"type"]);
+    item->className = IOSRunEncodeString(element[@"className"]);
+    item->label = IOSRunEncodeString(element[@"label"]);
+    item->identifier = IOSRunEncodeString(element[@"identifier"]);
+    item->value = IOSRunEncodeString(element[@"value"]);
+    item->hint = IOSRunEncodeString(element[@"hint"]);
+    item->text = IOSRunEncodeString(element[@"text"]);
+    item->placeholder = IOSRunEncodeString(element[@"placeholder"]);
+    item->processName = IOSRunEncodeString(element[@"processName"]);
+    item->bundleID = IOSRunEncodeString(element[@"bundleID"]);
+    CGRect frame = IOSRunRectFromDict(element[@"bounds"]);
+    item->x = (float)frame.origin.x;
+    item->y = (float)frame.origin.y;
+    item->width = (float)frame.size.width;
+    item->height = (float)frame.size.height;
+    item->traits = IOSRunTraitsBitmask(element[@"traits"]);
+    NSString *key = element[@"key"];
+    item->key = [key isKindOfClass:[NSString class]] ? strtoull(key.UTF8String, NULL, 16) : 0;
+    id enabled = element[@"enabled"];
+    id visible = element[@"visible"];
+    item->flags = (uint8_t)(((!enabled || [enabled boolValue]) ? KimiRunA11yFlagEnabled : 0) |
+                            ((!visible || [visible boolValue]) ? KimiRunA11yFlagVisible : 0));
+}
+
++ (NSData *)encodeInteractiveElements:(NSArray<NSDictionary *> *)elements
+                               format:(NSString *)format
+                          contentType:(NSString **)contentType {
+    KimiRunA11yFormat encoding;
+    if (![format isKindOfClass:[NSString class]] ||
+        !KimiRunA11yFormatFromName(format.lowercaseString.UTF8String, &encoding)) {
+        return nil;
+    }
+    NSUInteger count = elements.count;
+    KimiRunA11yElement *items = calloc(count ? count : 1, sizeof(*items));
+    if (!items) {
+        return nil;
+    }
+    KimiRunA11yBuffer buffer = {0};
+    BOOL ok;
+    // The UTF-8 pointers live in this pool; encode before draining it.
+    @autoreleasepool {
+        for (NSUInteger i = 0; i < count; i++) {
+            NSDictionary *element = elements[i];
+            if ([element isKindOfClass:[NSDictionary class]]) {
+                IOSRunEncodeFill(&items[i], element);
             }
         }
-    } @catch (__unused NSException *e) {
+        ok = KimiRunA11yEncode(encoding, items, count, &buffer);
     }
+    free(items);
+    if (!ok) {
+        KimiRunA11yBufferFree(&buffer);
+        return nil;
+    }
+    if (contentType) {
+        *contentType = @(KimiRunA11yFormatContentType(encoding));
+    }
+    return [NSData dataWithBytesNoCopy:buffer.bytes length:buffer.length freeWhenDone:YES];
+}
 
-    if (elements.count > 0) {
++ (NSArray<NSDictionary *> *)interactiveElementsFromMsgPack:(NSData *)data {
+    KimiRunA11yDecoded decoded;
+    if (!KimiRunA11yDecodeMsgPack(data.bytes, data.length, &decoded)) {
+        return nil;
+    }
+    NSMutableArray *elements = [NSMutableArray arrayWithCapacity:decoded.count];
+    for (size_t i = 0; i < decoded.count; i++) {
+        const KimiRunA11yElement *item = &decoded.elements[i];
+        CGRect frame = CGRectMake(item->x, item->y, item->width, item->height);
+        NSMutableDictionary *dict = [NSMutableDictionary dictionaryWithCapacity:18];
+        dict[@"type"] = IOSRunDecodedString(item->type);
+        dict[@"className"] = IOSRunDecodedString(item->className);
+        dict[@"label"] = IOSRunDecodedString(item->label);
+        dict[@"identifier"] = IOSRunDecodedString(item->identifier);
+        dict[@"value"] = IOSRunDecodedString(item->value);
+        dict[@"hint"] = IOSRunDecodedString(item->hint);
+        dict[@"traits"] = [self traitsToArray:(UIAccessibilityTraits)item->traits];
+        dict[@"bounds"] = [self rectToDict:frame];
+        dict[@"rect"] = [NSString stringWithFormat:@"%.1f,%.1f,%.1f,%.1f",
+                         frame.origin.x, frame.origin.y,
+                         frame.size.width, frame.size.height];
+        dict[@"center_x"] = @(CGRectGetMidX(frame));
+        dict[@"center_y"] = @(CGRectGetMidY(frame));
+        dict[@"enabled"] = @((item->flags & KimiRunA11yFlagEnabled) != 0);
+        dict[@"visible"] = @((item->flags & KimiRunA11yFlagVisible) != 0);
+        if (item->text) dict[@"text"] = IOSRunDecodedString(item->text);
+        if (item->placeholder) dict[@"placeholder"] = IOSRunDecodedString(item->placeholder);
+        if (item->processName) dict[@"processName"] = IOSRunDecodedString(item->processName);
+        if (item->bundleID) dict[@"bundleID"] = IOSRunDecodedString(item->bundleID);
+        if (item->key) dict[@"key"] = [NSString stringWithFormat:@"%016llx", (unsigned long long)item->key];
+        dict[@"index"] = @(i);
+        [elements addObject:dict];
+    }
+    KimiRunA11yDecodedFree(&decoded);
+    return elements;
+}
+
++ (NSArray *)collectInteractiveElementsTruncated:(BOOL *)truncated {
+    if (truncated) {
+        *truncated = NO;
+    }
+    IOSRunCaptureList captures = {0};
+    IOSRunCaptureList *capturesRef = &captures;
+    IOSRunSyncOnMain(^{
+        for (UIWindow *window in IOSRunActiveWindows()) {
+            if (!window.hidden) {
+                [self captureFromView:window depth:0 maxDepth:INT_MAX interactiveOnly:YES into:capturesRef];
+            }
+        }
+    });
+
+    id elementRefs = [NSMutableArray arrayWithCapacity:captures.count];
+    NSMutableArray *elements = [self elementsFromCaptures:&captures interactiveOnly:YES refs:elementRefs];
+    IOSRunCaptureListFree(&captures);
+
+    if (elements.count > 0 && !IOSRunElementsNeedAXFallback(elements)) {
+        id previous = nil;
         @synchronized(self) {
+            previous = lastInteractiveElements;
             lastInteractiveElements = elementRefs;
+            lastInteractiveRefsAligned = YES;
         }
+        elementRefs = nil;
+        IOSRunReleaseOnMain(&previous);
         return elements;
     }
 
-    // Last-resort fallback: sample grid with AXUIElement at coordinates
-    @try {
+    // Keep AX fallback enabled when view traversal only sees SpringBoard overlays.
+    IOSRunReleaseOnMain(&elementRefs);
+    double budgetMs = KimiRunPrefsDouble(@"A11yAXBudgetMs", kAXFallbackBudgetMs);
+    NSArray *fallback = [self collectAXInteractiveElementsBefore:CACurrentMediaTime() + MAX(budgetMs, 1.0) / 1000.0
+                                                       truncated:truncated];
+    return fallback ?: @[];
+}
+
+// Sources run concurrently off the main thread; anything still running at
+// the deadline is cancelled and what it found so far is kept, with
+// *truncated set. Per-source cost is kept for /a11y/debug.
++ (NSArray *)collectAXInteractiveElementsBefore:(CFTimeInterval)deadline truncated:(BOOL *)truncated {
+    CFTimeInterval startedAt = CACurrentMediaTime();
+    NSMutableArray *stats = [NSMutableArray array];
+    NSMutableArray<IOSRunAXSourceRun *> *runs = [NSMutableArray array];
+    BOOL complete = YES;
+
+    // The workers make no UIKit calls; read the geometry they need up front.
+    __block CGPoint probePoint = CGPointZero;
+    __block CGRect bounds = CGRectZero;
+    IOSRunSyncOnMain(^{
+        probePoint = IOSRunPreferredProbePoint();
         UIWindow *window = IOSRunPreferredWindow();
-        CGRect bounds = window ? [window convertRect:window.bounds toWindow:nil] : [UIScreen mainScreen].bounds;
+        bounds = window ? [window convertRect:window.bounds toWindow:nil] : [UIScreen mainScreen].bounds;
         if (CGRectIsEmpty(bounds)) {
             bounds = [UIScreen mainScreen].bounds;
         }
-        NSInteger cols = 6;
-        NSInteger rows = 10;
-        CGFloat dx = bounds.size.width / cols;
-        CGFloat dy = bounds.size.height / rows;
-        NSMutableSet<NSValue *> *seen = [NSMutableSet set];
-        NSUInteger count = 0;
-        for (NSInteger r = 0; r < rows; r++) {
-            for (NSInteger c = 0; c < cols; c++) {
-                CGPoint p = CGPointMake((c + 0.5) * dx, (r + 0.5) * dy);
-                id axElem = IOSRunAXElementFromPoint(p);
-                if (!axElem) continue;
-                NSValue *key = [NSValue valueWithPointer:(__bridge const void *)(axElem)];
-                if ([seen containsObject:key]) continue;
-                [seen addObject:key];
-                if (!IOSRunAXElementIsInteractive(axElem)) continue;
-                NSDictionary *dict = IOSRunDictForAXElement(axElem);
-                if (!dict) continue;
+    });
+
+    Class AXElementClass = NSClassFromString(@"AXElement");
+    if (AXElementClass) {
+        dispatch_group_t resolveGroup = dispatch_group_create();
+        IOSRunAXSourceRun *resolve = IOSRunAXStartRun(@"resolve", resolveGroup, deadline, ^(IOSRunAXSourceRun *run) {
+            id app = nil;
+            if ([AXElementClass respondsToSelector:@selector(primaryApp)]) {
+                app = [AXElementClass performSelector:@selector(primaryApp)];
+            }
+            // Try to resolve the frontmost app using AXUIElement if primaryApp is nil
+            if (!app) {
+                id uiApp = IOSRunAXUIElementAtPoint(probePoint);
+                if (uiApp && [AXElementClass respondsToSelector:@selector(elementWithUIElement:)]) {
+                    app = [AXElementClass performSelector:@selector(elementWithUIElement:) withObject:uiApp];
+                }
+            }
+            id system = nil;
+            if ([AXElementClass respondsToSelector:@selector(systemWideElement)]) {
+                system = [AXElementClass performSelector:@selector(systemWideElement)];
+            }
+            NSMutableArray *sources = [NSMutableArray array];
+            if (app) [sources addObject:@[@"app", app]];
+            if (system && system != app) [sources addObject:@[@"system", system]];
+            run.results = sources;
+        });
+        complete = IOSRunAXWait(resolveGroup, deadline) && IOSRunAXAllFinished(@[resolve]);
+        IOSRunAXRecordRuns(@[resolve], stats);
+
+        dispatch_group_t group = dispatch_group_create();
+        for (NSArray *source in (complete ? resolve.results : nil)) {
+            NSString *prefix = source[0];
+            id element = source[1];
+            for (NSString *selectorName in @[@"nativeFocusableElements", @"explorerElements",
+                                             @"elementsWithSemanticContext", @"firstElementInApplication"]) {
+                SEL selector = NSSelectorFromString(selectorName);
+                if (![element respondsToSelector:selector]) {
+                    continue;
+                }
+                NSString *name = [NSString stringWithFormat:@"%@.%@", prefix, selectorName];
+                [runs addObject:IOSRunAXStartRun(name, group, deadline, ^(IOSRunAXSourceRun *run) {
+                    id result = [element performSelector:selector];
+                    for (id ax in ([result isKindOfClass:[NSArray class]] ? result : (result ? @[result] : @[]))) {
+                        IOSRunAXCollectFromElement(ax, run);
+                        if (IOSRunAXRunShouldStop(run)) break;
+                    }
+                })];
+            }
+        }
+        complete = IOSRunAXWait(group, deadline) && IOSRunAXAllFinished(runs) && complete;
+    }
+
+    NSMutableArray *elements = [NSMutableArray array];
+    NSMutableArray *elementRefs = [NSMutableArray array];
+    NSMutableSet<NSString *> *seen = [NSMutableSet set];
+    void (^merge)(NSArray<IOSRunAXSourceRun *> *) = ^(NSArray<IOSRunAXSourceRun *> *sourceRuns) {
+        for (IOSRunAXSourceRun *run in sourceRuns) {
+            NSArray *found = nil;
+            NSArray *refs = nil;
+            @synchronized(run) {
+                found = [run.elements copy];
+                refs = [run.refs copy];
+            }
+            for (NSUInteger i = 0; i < found.count && elements.count < kAXMaxElements; i++) {
+                NSDictionary *dict = found[i];
+                // Each source (and each hit test) hands out its own wrappers.
+                NSString *identity = [NSString stringWithFormat:@"%@|%@|%@", dict[@"rect"], dict[@"label"], dict[@"identifier"]];
+                if ([seen containsObject:identity]) continue;
+                [seen addObject:identity];
                 NSMutableDictionary *mutable = [dict mutableCopy];
-                mutable[@"index"] = @(count);
+                mutable[@"index"] = @(elements.count);
                 [elements addObject:mutable];
-                [elementRefs addObject:axElem ?: [NSNull null]];
-                count++;
-                if (count >= kAXMaxElements) break;
+                [elementRefs addObject:refs[i]];
             }
-            if (count >= kAXMaxElements) break;
         }
-    } @catch (__unused NSException *e) {
+    };
+    merge(runs);
+    IOSRunAXRecordRuns(runs, stats);
+
+    // Last-resort fallback: hit-test sampling, seeded from the previous
+    // collection's element centers. Each hit test depends on the answers
+    // before it, so this is one worker; the target app answers them on its
+    // main thread, where parallel hit tests would only queue.
+    if (elements.count == 0 && CACurrentMediaTime() < deadline) {
+        NSArray *previous = nil;
+        @synchronized(self) {
+            previous = cachedInteractive;
+        }
+        NSMutableData *seeds = [NSMutableData dataWithCapacity:previous.count * 2 * sizeof(float)];
+        for (NSDictionary *element in previous) {
+            if (![element isKindOfClass:[NSDictionary class]]) continue;
+            float point[2] = { [element[@"center_x"] floatValue], [element[@"center_y"] floatValue] };
+            [seeds appendBytes:point length:sizeof(point)];
+        }
+        KimiRunA11ySampleConfig config;
+        KimiRunA11ySampleConfigDefault(&config);
+        config.maxCalls = (uint32_t)MAX(KimiRunPrefsInteger(@"A11yAXSampleCalls", config.maxCalls), 0);
+
+        dispatch_group_t group = dispatch_group_create();
+        IOSRunAXSourceRun *sample = IOSRunAXStartRun(@"sample", group, deadline, ^(IOSRunAXSourceRun *run) {
+            // Hit tests hand out new wrappers that compare equal for the same
+            // remote element; attributes are read once per element.
+            NSMutableArray *distinct = [NSMutableArray array];
+            uint64_t (^hitTest)(CGPoint) = ^uint64_t(CGPoint point) {
+                if (IOSRunAXRunShouldStop(run)) return KIMIRUN_A11Y_SAMPLE_STOP;
+                id uiElem = IOSRunAXUIElementFromPoint(point);
+                if (!uiElem) return KIMIRUN_A11Y_SAMPLE_NONE;
+                NSUInteger index = [distinct indexOfObject:uiElem];
+                if (index != NSNotFound) return index + 1;
+                [distinct addObject:uiElem];
+                id axElem = IOSRunAXElementForUIElement(uiElem);
+                if (axElem && IOSRunAXElementIsInteractive(axElem)) {
+                    IOSRunAXRunAppend(run, axElem);
+                }
+                return distinct.count;
+            };
+            KimiRunA11ySampleStats sampleStats;
+            KimiRunA11ySample((float)bounds.origin.x, (float)bounds.origin.y,
+                              (float)bounds.size.width, (float)bounds.size.height,
+                              &config, seeds.bytes, (uint32_t)(seeds.length / (2 * sizeof(float))),
+                              IOSRunAXSampleHitTest, (__bridge void *)hitTest, &sampleStats);
+            run.counters = @{
+                @"hitTests": @(sampleStats.calls),
+                @"seedHitTests": @(sampleStats.seedCalls),
+                @"splits": @(sampleStats.splits),
+                @"resolved": @(distinct.count)
+            };
+        });
+        complete = IOSRunAXWait(group, deadline) && IOSRunAXAllFinished(@[sample]) && complete;
+        merge(@[sample]);
+        IOSRunAXRecordRuns(@[sample], stats);
     }
 
-    if (elements.count > 0) {
-        @synchronized(self) {
+    NSUInteger hitTests = 0;
+    for (NSDictionary *entry in stats) {
+        hitTests += [entry[@"hitTests"] unsignedIntegerValue];
+    }
+    CFTimeInterval now = CACurrentMediaTime();
+    if (truncated) {
+        *truncated = !complete;
+    }
+    @synchronized(self) {
+        lastAXFallbackStats = @{
+            @"at": @([[NSDate date] timeIntervalSince1970]),
+            @"budgetMs": @(round((deadline - startedAt) * 1000.0)),
+            @"elapsedMs": @(round((now - startedAt) * 100000.0) / 100.0),
+            @"truncated": @(!complete),
+            @"count": @(elements.count),
+            @"hitTests": @(hitTests),
+            @"sources": stats
+        };
+        if (elements.count > 0) {
+            // One ref per element, but AX wrappers are new on every call, so
+            // snapshot keys stay content-derived.
             lastInteractiveElements = elementRefs;
+            lastInteractiveRefsAligned = NO;
         }
     }
     return elements;
 }
 
-+ (void)collectInteractiveFromView:(UIView *)view
-                               into:(NSMutableArray *)elements
-                      indexCounter:(NSMutableArray *)indexCounter
-                       elementRefs:(NSMutableArray *)elementRefs {
-    if (view.hidden || view.alpha < 0.01) return;
+#pragma mark - Spatial Queries
 
-    // Check if interactive
-    BOOL isInteractive = NO;
+// Rebuilt once per collection; queries between collections only touch the grid.
++ (void)indexInteractiveElements:(NSArray *)elements {
+    uint32_t count = (uint32_t)elements.count;
+    KimiRunA11yRect *rects = calloc(count ? count : 1, sizeof(*rects));
+    if (!rects) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        NSDictionary *element = elements[i];
+        if (![element isKindOfClass:[NSDictionary class]]) {
+            continue;
+        }
+        CGRect frame = IOSRunRectFromDict(element[@"bounds"]);
+        rects[i].x = (float)frame.origin.x;
+        rects[i].y = (float)frame.origin.y;
+        rects[i].width = (float)frame.size.width;
+        rects[i].height = (float)frame.size.height;
+        id enabled = element[@"enabled"];
+        id visible = element[@"visible"];
+        BOOL actionable = (!enabled || [enabled boolValue]) && (!visible || [visible boolValue]) &&
+            !(IOSRunTraitsBitmask(element[@"traits"]) & UIAccessibilityTraitNotEnabled);
+        rects[i].flags = actionable ? KimiRunA11ySpatialActionable : 0;
+    }
+    KimiRunA11ySpatial *spatial = KimiRunA11ySpatialCreate(rects, count, 0);
+    free(rects);
+    @synchronized(self) {
+        KimiRunA11ySpatialDestroy(interactiveSpatial);
+        interactiveSpatial = spatial;
+        interactiveSpatialElements = spatial ? elements : nil;
+    }
+}
 
-    if (view.userInteractionEnabled) {
-        if ([view isKindOfClass:[UIButton class]] ||
-            [view isKindOfClass:[UITextField class]] ||
-            [view isKindOfClass:[UITextView class]] ||
-            [view isKindOfClass:[UISwitch class]] ||
-            [view isKindOfClass:[UISlider class]] ||
-            [view isKindOfClass:[UITableViewCell class]] ||
-            [view isKindOfClass:[UICollectionViewCell class]]) {
-            isInteractive = YES;
++ (NSArray<NSDictionary *> *)interactiveElementsAtPoint:(CGPoint)point {
+    [self getInteractiveElements];
+    @synchronized(self) {
+        uint32_t matches[64];
+        uint32_t count = KimiRunA11ySpatialAtPoint(interactiveSpatial, (float)point.x, (float)point.y, 0,
+                                                   matches, 64);
+        NSMutableArray *result = [NSMutableArray arrayWithCapacity:MIN(count, 64u)];
+        for (uint32_t i = 0; i < count && i < 64; i++) {
+            [result addObject:interactiveSpatialElements[matches[i]]];
         }
+        return result;
+    }
+}
 
-        // Check traits
-        if (view.accessibilityTraits & UIAccessibilityTraitButton ||
-            view.accessibilityTraits & UIAccessibilityTraitLink ||
-            view.accessibilityTraits & UIAccessibilityTraitSearchField) {
-            isInteractive = YES;
++ (NSArray<NSDictionary *> *)interactiveElementsInRect:(CGRect)rect contained:(BOOL)contained {
+    [self getInteractiveElements];
+    @synchronized(self) {
+        uint32_t capacity = KimiRunA11ySpatialCount(interactiveSpatial);
+        uint32_t *matches = malloc((size_t)(capacity ? capacity : 1) * sizeof(*matches));
+        if (!matches) {
+            return @[];
+        }
+        uint32_t count = KimiRunA11ySpatialInRect(interactiveSpatial,
+                                                  (float)rect.origin.x, (float)rect.origin.y,
+                                                  (float)rect.size.width, (float)rect.size.height,
+                                                  contained, 0, matches, capacity);
+        NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+        for (uint32_t i = 0; i < count; i++) {
+            [result addObject:interactiveSpatialElements[matches[i]]];
         }
+        free(matches);
+        return result;
     }
+}
 
-    // Treat accessible elements with labels/traits as interactive
-    if (!isInteractive && (view.isAccessibilityElement || [self viewHasAccessibilityInfo:view])) {
-        BOOL hasActionableTraits = ((view.accessibilityTraits & UIAccessibilityTraitButton) ||
-                                    (view.accessibilityTraits & UIAccessibilityTraitLink) ||
-                                    (view.accessibilityTraits & UIAccessibilityTraitSearchField) ||
-                                    (view.accessibilityTraits & UIAccessibilityTraitAdjustable));
-        BOOL hasSemanticIdentity = (view.accessibilityLabel.length > 0 ||
-                                    view.accessibilityIdentifier.length > 0 ||
-                                    view.accessibilityValue.length > 0 ||
-                                    view.accessibilityHint.length > 0);
-        BOOL isActionableClass = ([view isKindOfClass:[UIControl class]] ||
-                                  [view isKindOfClass:[UITableViewCell class]] ||
-                                  [view isKindOfClass:[UICollectionViewCell class]]);
-        if ((hasActionableTraits || isActionableClass) && hasSemanticIdentity) {
-            isInteractive = YES;
-        }
-    }
-
-    if (isInteractive) {
-        NSString *className = NSStringFromClass([view class]) ?: @"";
-        if (IOSRunClassNameContainsAny(className, @[@"homegrabber", @"statusbar", @"overlay", @"keyboard", @"dock", @"assistive"])) {
-            isInteractive = NO;
-        }
-    }
-
-    if (isInteractive) {
-        NSMutableDictionary *element = [self elementDictForView:view];
-        element[@"index"] = @(indexCounter.count);
-        [indexCounter addObject:element];
-        [elements addObject:element];
-        if (elementRefs) {
-            [elementRefs addObject:view ?: [NSNull null]];
++ (NSDictionary *)nearestActionableElementToPoint:(CGPoint)point
+                                      maxDistance:(CGFloat)maxDistance
+                                         distance:(CGFloat *)distance {
+    [self getInteractiveElements];
+    @synchronized(self) {
+        uint32_t element = 0;
+        float found = 0;
+        if (!KimiRunA11ySpatialNearest(interactiveSpatial, (float)point.x, (float)point.y, (float)maxDistance,
+                                       KimiRunA11ySpatialActionable, &element, &found)) {
+            return nil;
+        }
+        if (distance) {
+            *distance = found;
         }
+        return interactiveSpatialElements[element];
+    }
+}
+
+#pragma mark - Find Elements
+
+static NSString *IOSRunSearchFold(id value) {
+    if (![value isKindOfClass:[NSString class]]) {
+        return nil;
     }
+    return [(NSString *)value stringByFoldingWithOptions:(NSCaseInsensitiveSearch |
+                                                          NSDiacriticInsensitiveSearch |
+                                                          NSWidthInsensitiveSearch)
+                                                  locale:nil];
+}
 
-    // Recurse
-    for (UIView *subview in view.subviews) {
-        [self collectInteractiveFromView:subview into:elements indexCounter:indexCounter elementRefs:elementRefs];
+static NSString *IOSRunMatchKindName(KimiRunA11yMatchKind kind) {
+    switch (kind) {
+        case KimiRunA11yMatchExact: return @"exact";
+        case KimiRunA11yMatchPrefix: return @"prefix";
+        case KimiRunA11yMatchSubstring: return @"substring";
+        case KimiRunA11yMatchFuzzy: return @"fuzzy";
     }
+    return @"fuzzy";
+}
 
-    // Include accessibility elements if present (SpringBoard often exposes these)
-    if ([view respondsToSelector:@selector(accessibilityElements)] && view.accessibilityElements.count > 0) {
-        for (id element in view.accessibilityElements) {
-            if ([element isKindOfClass:[UIAccessibilityElement class]]) {
-                UIAccessibilityElement *accElement = (UIAccessibilityElement *)element;
-                if (!IOSRunIsInteractiveAccessibilityElement(accElement)) {
+// Built on the first search against a collection, then reused until the
+// next one. Caller holds @synchronized(self).
++ (KimiRunA11ySearch *)searchIndexForElements:(NSArray *)elements {
+    if (interactiveSearch && interactiveSearchElements == elements) {
+        return interactiveSearch;
+    }
+    uint32_t count = (uint32_t)elements.count;
+    const char **labels = calloc(count ? count : 1, sizeof(*labels));
+    const char **identifiers = calloc(count ? count : 1, sizeof(*identifiers));
+    KimiRunA11ySearch *search = NULL;
+    if (labels && identifiers) {
+        @autoreleasepool {
+            for (uint32_t i = 0; i < count; i++) {
+                NSDictionary *element = elements[i];
+                if (![element isKindOfClass:[NSDictionary class]]) {
                     continue;
                 }
-                NSMutableDictionary *dict = [self elementDictForAccessibilityElement:accElement];
-                dict[@"index"] = @(indexCounter.count);
-                [indexCounter addObject:dict];
-                [elements addObject:dict];
-                if (elementRefs) {
-                    [elementRefs addObject:accElement ?: [NSNull null]];
-                }
-                continue;
-            }
-            if ([element respondsToSelector:@selector(accessibilityFrame)] &&
-                IOSRunIsInteractiveGenericElement(element)) {
-                NSMutableDictionary *dict = [IOSRunDictForGenericElement(element) mutableCopy];
-                if (!dict) continue;
-                dict[@"index"] = @(indexCounter.count);
-                [indexCounter addObject:dict];
-                [elements addObject:dict];
-                if (elementRefs) {
-                    [elementRefs addObject:element ?: [NSNull null]];
-                }
+                labels[i] = IOSRunSearchFold(element[@"label"]).UTF8String;
+                identifiers[i] = IOSRunSearchFold(element[@"identifier"]).UTF8String;
             }
+            search = KimiRunA11ySearchCreate(labels, identifiers, count);
         }
     }
+    free(labels);
+    free(identifiers);
+    KimiRunA11ySearchDestroy(interactiveSearch);
+    interactiveSearch = search;
+    interactiveSearchElements = search ? elements : nil;
+    return search;
 }
 
-#pragma mark - Find Elements
++ (NSArray<NSDictionary *> *)findElementsMatching:(NSString *)query
+                                          inLabel:(BOOL)inLabel
+                                     inIdentifier:(BOOL)inIdentifier
+                                            fuzzy:(BOOL)fuzzy
+                                            limit:(NSUInteger)limit {
+    if (!query) {
+        return @[];
+    }
+    return [self findElementsMatchingQueries:@[query]
+                                     inLabel:inLabel
+                                inIdentifier:inIdentifier
+                                       fuzzy:fuzzy
+                                       limit:limit].firstObject ?: @[];
+}
 
-+ (NSDictionary *)findElementWithLabel:(NSString *)label {
++ (NSArray<NSArray<NSDictionary *> *> *)findElementsMatchingQueries:(NSArray<NSString *> *)queries
+                                                            inLabel:(BOOL)inLabel
+                                                       inIdentifier:(BOOL)inIdentifier
+                                                              fuzzy:(BOOL)fuzzy
+                                                              limit:(NSUInteger)limit {
+    uint32_t fields = (inLabel ? KimiRunA11ySearchLabel : 0) | (inIdentifier ? KimiRunA11ySearchIdentifier : 0);
+    NSMutableArray<NSArray<NSDictionary *> *> *results = [NSMutableArray arrayWithCapacity:queries.count];
+    NSMutableArray<NSString *> *foldedQueries = [NSMutableArray arrayWithCapacity:queries.count];
+    BOOL anyQuery = NO;
+    for (NSString *query in queries) {
+        NSString *folded = [query isKindOfClass:[NSString class]] ? IOSRunSearchFold(query) : nil;
+        [foldedQueries addObject:folded ?: @""];
+        anyQuery = anyQuery || folded.length > 0;
+    }
+    if (!anyQuery || fields == 0) {
+        for (NSUInteger i = 0; i < queries.count; i++) {
+            [results addObject:@[]];
+        }
+        return results;
+    }
     NSArray *elements = [self getInteractiveElements];
-    for (NSDictionary *element in elements) {
-        if ([element[@"label"] isEqualToString:label]) {
-            return element;
+    @synchronized(self) {
+        KimiRunA11ySearch *search = [self searchIndexForElements:elements];
+        uint32_t capacity = (uint32_t)MIN(limit ? limit : elements.count, elements.count);
+        KimiRunA11yMatch *matches = malloc((size_t)(capacity ? capacity : 1) * sizeof(*matches));
+        for (NSString *folded in foldedQueries) {
+            if (!search || !matches || folded.length == 0) {
+                [results addObject:@[]];
+                continue;
+            }
+            uint32_t total = KimiRunA11ySearchFind(search, folded.UTF8String, fields, fuzzy, matches, capacity);
+            uint32_t count = MIN(total, capacity);
+            NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+            for (uint32_t i = 0; i < count; i++) {
+                [result addObject:@{
+                    @"score": @(round(matches[i].score * 1000.0) / 1000.0),
+                    @"match": IOSRunMatchKindName(matches[i].kind),
+                    @"field": matches[i].field == KimiRunA11ySearchIdentifier ? @"identifier" : @"label",
+                    @"element": interactiveSearchElements[matches[i].element]
+                }];
+            }
+            [results addObject:result];
         }
+        free(matches);
+        return results;
     }
-    return nil;
 }
 
-+ (NSDictionary *)findElementWithIdentifier:(NSString *)identifier {
-    NSArray *elements = [self getInteractiveElements];
-    for (NSDictionary *element in elements) {
-        if ([element[@"identifier"] isEqualToString:identifier]) {
+// Exact lookups go through the index; a case- or spacing-insensitive hit
+// is returned only when no element matches the string as given.
++ (NSDictionary *)findElementWithString:(NSString *)string field:(NSString *)field {
+    if (![string isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+    BOOL label = [field isEqualToString:@"label"];
+    NSDictionary *fallback = nil;
+    for (NSDictionary *match in [self findElementsMatching:string inLabel:label inIdentifier:!label fuzzy:NO limit:0]) {
+        if (![match[@"match"] isEqualToString:@"exact"]) {
+            break;
+        }
+        NSDictionary *element = match[@"element"];
+        if ([element[field] isEqualToString:string]) {
             return element;
         }
+        fallback = fallback ?: element;
     }
-    return nil;
+    return fallback;
+}
+
++ (NSDictionary *)findElementWithLabel:(NSString *)label {
+    return [self findElementWithString:label field:@"label"];
+}
+
++ (NSDictionary *)findElementWithIdentifier:(NSString *)identifier {
+    return [self findElementWithString:identifier field:@"identifier"];
 }
 
 + (BOOL)activateInteractiveElementAtIndex:(NSUInteger)index {
@@ -1262,14 +2914,17 @@ static void IOSRunAXCollectFromElement(id element,
     }
     if (!element) return NO;
 
-    if ([NSThread isMainThread]) {
-        return IOSRunActivateElement(element);
-    }
-
     __block BOOL success = NO;
-    dispatch_sync(dispatch_get_main_queue(), ^{
+    if ([NSThread isMainThread]) {
         success = IOSRunActivateElement(element);
-    });
+    } else {
+        dispatch_sync(dispatch_get_main_queue(), ^{
+            success = IOSRunActivateElement(element);
+        });
+    }
+    if (success) {
+        KimiRunA11yNoteContentChanged();
+    }
     return success;
 }
 
@@ -1303,45 +2958,21 @@ static void IOSRunAXCollectFromElement(id element,
             }
         }
 
-        // Final fallback: choose nearest interactive element bounds and activate by index.
-        NSArray<NSDictionary *> *interactive = [AccessibilityTree getInteractiveElements];
-        NSUInteger bestIndex = NSNotFound;
-        CGFloat bestDistance = CGFLOAT_MAX;
-        for (NSDictionary *element in interactive) {
-            NSDictionary *bounds = [element[@"bounds"] isKindOfClass:[NSDictionary class]] ? element[@"bounds"] : nil;
-            if (!bounds) {
-                continue;
-            }
-            CGFloat x = [bounds[@"x"] doubleValue];
-            CGFloat y = [bounds[@"y"] doubleValue];
-            CGFloat w = [bounds[@"width"] doubleValue];
-            CGFloat h = [bounds[@"height"] doubleValue];
-            CGRect rect = CGRectMake(x, y, w, h);
-            if (CGRectIsEmpty(rect)) {
-                continue;
-            }
-            NSUInteger idx = [element[@"index"] unsignedIntegerValue];
-            if (CGRectContainsPoint(rect, point)) {
-                if ([AccessibilityTree activateInteractiveElementAtIndex:idx]) {
-                    success = YES;
-                    return;
-                }
-            }
-            CGPoint center = CGPointMake(CGRectGetMidX(rect), CGRectGetMidY(rect));
-            CGFloat dx = center.x - point.x;
-            CGFloat dy = center.y - point.y;
-            CGFloat dist = (dx * dx) + (dy * dy);
-            if (dist < bestDistance) {
-                bestDistance = dist;
-                bestIndex = idx;
-            }
-        }
-        if (bestIndex != NSNotFound && bestDistance < 4000.0) { // ~63pt radius
-            if ([AccessibilityTree activateInteractiveElementAtIndex:bestIndex]) {
+        // Final fallback: the indexed interactive rects under the point,
+        // innermost first, then the nearest actionable one.
+        for (NSDictionary *element in [AccessibilityTree interactiveElementsAtPoint:point]) {
+            if ([AccessibilityTree activateInteractiveElementAtIndex:[element[@"index"] unsignedIntegerValue]]) {
                 success = YES;
                 return;
             }
         }
+        NSDictionary *nearest = [AccessibilityTree nearestActionableElementToPoint:point
+                                                                       maxDistance:kActivateNearestRadius
+                                                                          distance:NULL];
+        if (nearest && [AccessibilityTree activateInteractiveElementAtIndex:[nearest[@"index"] unsignedIntegerValue]]) {
+            success = YES;
+            return;
+        }
     };
 
     if ([NSThread isMainThread]) {
@@ -1349,6 +2980,9 @@ static void IOSRunAXCollectFromElement(id element,
     } else {
         dispatch_sync(dispatch_get_main_queue(), activateBlock);
     }
+    if (success) {
+        KimiRunA11yNoteContentChanged();
+    }
     return success;
 }
 
@@ -1373,6 +3007,9 @@ static void IOSRunAXCollectFromElement(id element,
     } else {
         dispatch_sync(dispatch_get_main_queue(), scrollBlock);
     }
+    if (success) {
+        KimiRunA11yNoteContentChanged();
+    }
     return success;
 }
 
@@ -1380,8 +3017,10 @@ static void IOSRunAXCollectFromElement(id element,
     if (!view) return @{};
 
     NSMutableDictionary *dict = [self elementDictForView:view];
-    NSMutableArray *indexCounter = [NSMutableArray array];
-    dict[@"children"] = [self buildTreeForView:view depth:0 maxDepth:20 index:indexCounter];
+    IOSRunCaptureList captures = {0};
+    [self captureFromView:view depth:0 maxDepth:20 interactiveOnly:NO into:&captures];
+    dict[@"children"] = [self elementsFromCaptures:&captures interactiveOnly:NO refs:nil];
+    IOSRunCaptureListFree(&captures);
 
     return dict;
 }
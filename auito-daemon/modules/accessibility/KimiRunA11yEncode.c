@@ -0,0 +1,915 @@
+//
+//  KimiRunA11yEncode.c
+//  KimiRun - Compact Accessibility Element Encodings
+//
+
+#include "KimiRunA11yEncode.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kMsgPackMaxDepth 16
+
+static bool KimiRunA11yReserve(KimiRunA11yBuffer *buffer, size_t extra) {
+    if (buffer->failed) {
+        return false;
+    }
+    if (buffer->length + extra <= buffer->capacity) {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+    uint8_t *bytes = realloc(buffer->bytes, capacity);
+    if (!bytes) {
+        buffer->failed = true;
+        return false;
+    }
+    buffer->bytes = bytes;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static void KimiRunA11yPut(KimiRunA11yBuffer *buffer, const void *bytes, size_t length) {
+    if (length == 0 || !KimiRunA11yReserve(buffer, length)) {
+        return;
+    }
+    memcpy(buffer->bytes + buffer->length, bytes, length);
+    buffer->length += length;
+}
+
+static void KimiRunA11yPutByte(KimiRunA11yBuffer *buffer, uint8_t byte) {
+    if (!KimiRunA11yReserve(buffer, 1)) {
+        return;
+    }
+    buffer->bytes[buffer->length++] = byte;
+}
+
+static void KimiRunA11yPutLiteral(KimiRunA11yBuffer *buffer, const char *literal) {
+    KimiRunA11yPut(buffer, literal, strlen(literal));
+}
+
+void KimiRunA11yBufferFree(KimiRunA11yBuffer *buffer) {
+    if (!buffer) {
+        return;
+    }
+    free(buffer->bytes);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+bool KimiRunA11yFormatFromName(const char *name, KimiRunA11yFormat *out) {
+    if (!name) {
+        return false;
+    }
+    if (strcmp(name, "min") == 0) {
+        *out = KimiRunA11yFormatMin;
+    } else if (strcmp(name, "columnar") == 0) {
+        *out = KimiRunA11yFormatColumnar;
+    } else if (strcmp(name, "msgpack") == 0) {
+        *out = KimiRunA11yFormatMsgPack;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *KimiRunA11yFormatContentType(KimiRunA11yFormat format) {
+    return format == KimiRunA11yFormatMsgPack ? "application/msgpack" : "application/json";
+}
+
+static void KimiRunA11yJSONString(KimiRunA11yBuffer *buffer, const char *string) {
+    static const char kHex[] = "0123456789abcdef";
+    KimiRunA11yPutByte(buffer, '"');
+    const unsigned char *p = (const unsigned char *)(string ? string : "");
+    const unsigned char *run = p;
+    for (; *p; p++) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        KimiRunA11yPut(buffer, run, (size_t)(p - run));
+        run = p + 1;
+        if (c == '"' || c == '\\') {
+            uint8_t escaped[2] = { '\\', c };
+            KimiRunA11yPut(buffer, escaped, 2);
+        } else if (c == '\n') {
+            KimiRunA11yPutLiteral(buffer, "\\n");
+        } else if (c == '\r') {
+            KimiRunA11yPutLiteral(buffer, "\\r");
+        } else if (c == '\t') {
+            KimiRunA11yPutLiteral(buffer, "\\t");
+        } else {
+            uint8_t escaped[6] = { '\\', 'u', '0', '0', (uint8_t)kHex[c >> 4], (uint8_t)kHex[c & 15] };
+            KimiRunA11yPut(buffer, escaped, 6);
+        }
+    }
+    KimiRunA11yPut(buffer, run, (size_t)(p - run));
+    KimiRunA11yPutByte(buffer, '"');
+}
+
+static void KimiRunA11yJSONUInt(KimiRunA11yBuffer *buffer, uint64_t value) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    if (!KimiRunA11yReserve(buffer, (size_t)n)) {
+        return;
+    }
+    while (n > 0) {
+        buffer->bytes[buffer->length++] = (uint8_t)digits[--n];
+    }
+}
+
+// Points with at most two decimals, trailing zeros trimmed ("12", "12.5").
+static void KimiRunA11yJSONCoord(KimiRunA11yBuffer *buffer, float value) {
+    double scaled = isfinite(value) ? (double)value * 100.0 : 0.0;
+    long long rounded = llround(scaled);
+    if (rounded < 0) {
+        KimiRunA11yPutByte(buffer, '-');
+        rounded = -rounded;
+    }
+    KimiRunA11yJSONUInt(buffer, (uint64_t)(rounded / 100));
+    int fraction = (int)(rounded % 100);
+    if (fraction) {
+        uint8_t tail[3] = { '.', (uint8_t)('0' + fraction / 10), (uint8_t)('0' + fraction % 10) };
+        KimiRunA11yPut(buffer, tail, (fraction % 10) ? 3 : 2);
+    }
+}
+
+static void KimiRunA11yJSONKey(KimiRunA11yBuffer *buffer, uint64_t key) {
+    static const char kHex[] = "0123456789abcdef";
+    uint8_t text[18];
+    text[0] = '"';
+    for (int i = 0; i < 16; i++) {
+        text[1 + i] = (uint8_t)kHex[(key >> (60 - 4 * i)) & 15];
+    }
+    text[17] = '"';
+    KimiRunA11yPut(buffer, text, sizeof(text));
+}
+
+static bool KimiRunA11yHasText(const char *string) {
+    return string && string[0];
+}
+
+static void KimiRunA11yMinField(KimiRunA11yBuffer *buffer, const char *name, const char *value, bool *first) {
+    if (!value) {
+        return;
+    }
+    KimiRunA11yPutLiteral(buffer, *first ? "\"" : ",\"");
+    KimiRunA11yPutLiteral(buffer, name);
+    KimiRunA11yPutLiteral(buffer, "\":");
+    KimiRunA11yJSONString(buffer, value);
+    *first = false;
+}
+
+static void KimiRunA11yEncodeMin(const KimiRunA11yElement *elements, size_t count, KimiRunA11yBuffer *out) {
+    KimiRunA11yPutByte(out, '[');
+    for (size_t i = 0; i < count; i++) {
+        const KimiRunA11yElement *e = &elements[i];
+        bool first = true;
+        KimiRunA11yPutLiteral(out, i ? ",{" : "{");
+        KimiRunA11yMinField(out, "type", KimiRunA11yHasText(e->type) ? e->type : NULL, &first);
+        KimiRunA11yMinField(out, "className", KimiRunA11yHasText(e->className) ? e->className : NULL, &first);
+        KimiRunA11yMinField(out, "label", KimiRunA11yHasText(e->label) ? e->label : NULL, &first);
+        KimiRunA11yMinField(out, "identifier", KimiRunA11yHasText(e->identifier) ? e->identifier : NULL, &first);
+        KimiRunA11yMinField(out, "value", KimiRunA11yHasText(e->value) ? e->value : NULL, &first);
+        KimiRunA11yMinField(out, "hint", KimiRunA11yHasText(e->hint) ? e->hint : NULL, &first);
+        KimiRunA11yMinField(out, "text", e->text, &first);
+        KimiRunA11yMinField(out, "placeholder", e->placeholder, &first);
+        KimiRunA11yMinField(out, "processName", e->processName, &first);
+        KimiRunA11yMinField(out, "bundleID", e->bundleID, &first);
+        KimiRunA11yPutLiteral(out, first ? "\"bounds\":[" : ",\"bounds\":[");
+        KimiRunA11yJSONCoord(out, e->x);
+        KimiRunA11yPutByte(out, ',');
+        KimiRunA11yJSONCoord(out, e->y);
+        KimiRunA11yPutByte(out, ',');
+        KimiRunA11yJSONCoord(out, e->width);
+        KimiRunA11yPutByte(out, ',');
+        KimiRunA11yJSONCoord(out, e->height);
+        KimiRunA11yPutByte(out, ']');
+        if (e->traits) {
+            KimiRunA11yPutLiteral(out, ",\"traits\":");
+            KimiRunA11yJSONUInt(out, e->traits);
+        }
+        if (!(e->flags & KimiRunA11yFlagEnabled)) {
+            KimiRunA11yPutLiteral(out, ",\"enabled\":false");
+        }
+        if (!(e->flags & KimiRunA11yFlagVisible)) {
+            KimiRunA11yPutLiteral(out, ",\"visible\":false");
+        }
+        if (e->key) {
+            KimiRunA11yPutLiteral(out, ",\"key\":");
+            KimiRunA11yJSONKey(out, e->key);
+        }
+        KimiRunA11yPutByte(out, '}');
+    }
+    KimiRunA11yPutByte(out, ']');
+}
+
+// Dictionary coding for the low-cardinality type and className columns.
+typedef struct {
+    const char **strings;          // unique values in first-seen order
+    uint32_t count;
+    uint32_t *slots;               // open addressing, UINT32_MAX == empty
+    uint32_t mask;
+    uint32_t *indexes;             // per element
+} KimiRunA11yStringTable;
+
+static uint32_t KimiRunA11yStringHash(const char *string) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)string; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static bool KimiRunA11yTableBuild(KimiRunA11yStringTable *table,
+                                  const KimiRunA11yElement *elements,
+                                  size_t count,
+                                  size_t fieldOffset) {
+    uint32_t size = 16;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+    memset(table, 0, sizeof(*table));
+    table->mask = size - 1;
+    table->slots = malloc(size * sizeof(*table->slots));
+    table->strings = malloc((count ? count : 1) * sizeof(*table->strings));
+    table->indexes = malloc((count ? count : 1) * sizeof(*table->indexes));
+    if (!table->slots || !table->strings || !table->indexes) {
+        return false;
+    }
+    memset(table->slots, 0xff, size * sizeof(*table->slots));
+    for (size_t i = 0; i < count; i++) {
+        const char *value = *(const char *const *)((const char *)&elements[i] + fieldOffset);
+        if (!value) {
+            value = "";
+        }
+        uint32_t slot = KimiRunA11yStringHash(value) & table->mask;
+        while (table->slots[slot] != UINT32_MAX && strcmp(table->strings[table->slots[slot]], value) != 0) {
+            slot = (slot + 1) & table->mask;
+        }
+        if (table->slots[slot] == UINT32_MAX) {
+            table->slots[slot] = table->count;
+            table->strings[table->count++] = value;
+        }
+        table->indexes[i] = table->slots[slot];
+    }
+    return true;
+}
+
+static void KimiRunA11yTableFree(KimiRunA11yStringTable *table) {
+    free(table->slots);
+    free(table->strings);
+    free(table->indexes);
+}
+
+// One writer for both columnar forms so the layouts cannot drift apart.
+typedef struct {
+    KimiRunA11yBuffer *out;
+    bool json;
+    bool needComma;
+} KimiRunA11yColumnWriter;
+
+static void KimiRunA11yMsgPackHeader(KimiRunA11yBuffer *out, uint8_t fix, uint8_t fixLimit,
+                                     uint8_t tag16, size_t length) {
+    if (length < fixLimit) {
+        KimiRunA11yPutByte(out, (uint8_t)(fix | length));
+    } else if (length <= 0xffff) {
+        uint8_t header[3] = { tag16, (uint8_t)(length >> 8), (uint8_t)length };
+        KimiRunA11yPut(out, header, 3);
+    } else {
+        uint8_t header[5] = { (uint8_t)(tag16 + 1), (uint8_t)(length >> 24), (uint8_t)(length >> 16),
+                              (uint8_t)(length >> 8), (uint8_t)length };
+        KimiRunA11yPut(out, header, 5);
+    }
+}
+
+static void KimiRunA11yMsgPackString(KimiRunA11yBuffer *out, const char *string) {
+    size_t length = string ? strlen(string) : 0;
+    if (length < 32) {
+        KimiRunA11yPutByte(out, (uint8_t)(0xa0 | length));
+    } else if (length <= 0xff) {
+        uint8_t header[2] = { 0xd9, (uint8_t)length };
+        KimiRunA11yPut(out, header, 2);
+    } else {
+        KimiRunA11yMsgPackHeader(out, 0, 0, 0xda, length);
+    }
+    KimiRunA11yPut(out, string, length);
+}
+
+static void KimiRunA11yMsgPackUInt(KimiRunA11yBuffer *out, uint64_t value) {
+    if (value < 0x80) {
+        KimiRunA11yPutByte(out, (uint8_t)value);
+    } else if (value <= 0xff) {
+        uint8_t bytes[2] = { 0xcc, (uint8_t)value };
+        KimiRunA11yPut(out, bytes, 2);
+    } else if (value <= 0xffff) {
+        uint8_t bytes[3] = { 0xcd, (uint8_t)(value >> 8), (uint8_t)value };
+        KimiRunA11yPut(out, bytes, 3);
+    } else if (value <= 0xffffffffu) {
+        uint8_t bytes[5] = { 0xce, (uint8_t)(value >> 24), (uint8_t)(value >> 16),
+                             (uint8_t)(value >> 8), (uint8_t)value };
+        KimiRunA11yPut(out, bytes, 5);
+    } else {
+        uint8_t bytes[9] = { 0xcf };
+        for (int i = 0; i < 8; i++) {
+            bytes[1 + i] = (uint8_t)(value >> (56 - 8 * i));
+        }
+        KimiRunA11yPut(out, bytes, 9);
+    }
+}
+
+static void KimiRunA11yMsgPackFloat(KimiRunA11yBuffer *out, float value) {
+    // Whole points (the common case) go out as ints.
+    if (value >= 0.0f && value < 65536.0f && value == (float)(uint32_t)value) {
+        KimiRunA11yMsgPackUInt(out, (uint32_t)value);
+        return;
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[5] = { 0xca, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16),
+                         (uint8_t)(bits >> 8), (uint8_t)bits };
+    KimiRunA11yPut(out, bytes, 5);
+}
+
+static void KimiRunA11yColumnName(KimiRunA11yColumnWriter *w, const char *name) {
+    if (w->json) {
+        KimiRunA11yPutLiteral(w->out, w->needComma ? ",\"" : "\"");
+        KimiRunA11yPutLiteral(w->out, name);
+        KimiRunA11yPutLiteral(w->out, "\":");
+        w->needComma = true;
+    } else {
+        KimiRunA11yMsgPackString(w->out, name);
+    }
+}
+
+static void KimiRunA11yColumnArray(KimiRunA11yColumnWriter *w, size_t count) {
+    if (w->json) {
+        KimiRunA11yPutByte(w->out, '[');
+    } else {
+        KimiRunA11yMsgPackHeader(w->out, 0x90, 16, 0xdc, count);
+    }
+}
+
+static void KimiRunA11yColumnEnd(KimiRunA11yColumnWriter *w) {
+    if (w->json) {
+        KimiRunA11yPutByte(w->out, ']');
+    }
+}
+
+static void KimiRunA11yColumnSeparator(KimiRunA11yColumnWriter *w, size_t i) {
+    if (w->json && i) {
+        KimiRunA11yPutByte(w->out, ',');
+    }
+}
+
+static void KimiRunA11yColumnUInt(KimiRunA11yColumnWriter *w, uint64_t value) {
+    if (w->json) {
+        KimiRunA11yJSONUInt(w->out, value);
+    } else {
+        KimiRunA11yMsgPackUInt(w->out, value);
+    }
+}
+
+static void KimiRunA11yColumnString(KimiRunA11yColumnWriter *w, const char *value, bool optional) {
+    if (!value && optional) {
+        if (w->json) {
+            KimiRunA11yPutLiteral(w->out, "null");
+        } else {
+            KimiRunA11yPutByte(w->out, 0xc0);
+        }
+        return;
+    }
+    if (w->json) {
+        KimiRunA11yJSONString(w->out, value);
+    } else {
+        KimiRunA11yMsgPackString(w->out, value);
+    }
+}
+
+static void KimiRunA11yStringColumn(KimiRunA11yColumnWriter *w, const char *name,
+                                    const KimiRunA11yElement *elements, size_t count,
+                                    size_t fieldOffset, bool optional) {
+    KimiRunA11yColumnName(w, name);
+    KimiRunA11yColumnArray(w, count);
+    for (size_t i = 0; i < count; i++) {
+        KimiRunA11yColumnSeparator(w, i);
+        const char *value = *(const char *const *)((const char *)&elements[i] + fieldOffset);
+        KimiRunA11yColumnString(w, value, optional);
+    }
+    KimiRunA11yColumnEnd(w);
+}
+
+static bool KimiRunA11yAnyField(const KimiRunA11yElement *elements, size_t count, size_t fieldOffset) {
+    for (size_t i = 0; i < count; i++) {
+        if (*(const char *const *)((const char *)&elements[i] + fieldOffset)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void KimiRunA11yTableColumns(KimiRunA11yColumnWriter *w, const char *namesKey, const char *indexKey,
+                                    const KimiRunA11yStringTable *table, size_t count) {
+    KimiRunA11yColumnName(w, namesKey);
+    KimiRunA11yColumnArray(w, table->count);
+    for (uint32_t i = 0; i < table->count; i++) {
+        KimiRunA11yColumnSeparator(w, i);
+        KimiRunA11yColumnString(w, table->strings[i], false);
+    }
+    KimiRunA11yColumnEnd(w);
+    KimiRunA11yColumnName(w, indexKey);
+    KimiRunA11yColumnArray(w, count);
+    for (size_t i = 0; i < count; i++) {
+        KimiRunA11yColumnSeparator(w, i);
+        KimiRunA11yColumnUInt(w, table->indexes[i]);
+    }
+    KimiRunA11yColumnEnd(w);
+}
+
+static bool KimiRunA11yEncodeColumnar(const KimiRunA11yElement *elements, size_t count,
+                                      bool json, KimiRunA11yBuffer *out) {
+    KimiRunA11yStringTable types;
+    KimiRunA11yStringTable classes;
+    bool built = KimiRunA11yTableBuild(&types, elements, count, offsetof(KimiRunA11yElement, type));
+    built = KimiRunA11yTableBuild(&classes, elements, count, offsetof(KimiRunA11yElement, className)) && built;
+    if (!built) {
+        KimiRunA11yTableFree(&types);
+        KimiRunA11yTableFree(&classes);
+        return false;
+    }
+
+    static const struct {
+        const char *name;
+        size_t offset;
+    } kOptional[] = {
+        { "text", offsetof(KimiRunA11yElement, text) },
+        { "placeholder", offsetof(KimiRunA11yElement, placeholder) },
+        { "processName", offsetof(KimiRunA11yElement, processName) },
+        { "bundleID", offsetof(KimiRunA11yElement, bundleID) },
+    };
+    bool present[sizeof(kOptional) / sizeof(kOptional[0])];
+    size_t columns = 13;
+    for (size_t c = 0; c < sizeof(kOptional) / sizeof(kOptional[0]); c++) {
+        present[c] = KimiRunA11yAnyField(elements, count, kOptional[c].offset);
+        columns += present[c];
+    }
+    bool hasKeys = false;
+    for (size_t i = 0; i < count && !hasKeys; i++) {
+        hasKeys = elements[i].key != 0;
+    }
+    columns += hasKeys;
+
+    KimiRunA11yColumnWriter w = { out, json, false };
+    if (json) {
+        KimiRunA11yPutByte(out, '{');
+    } else {
+        KimiRunA11yMsgPackHeader(out, 0x80, 16, 0xde, columns);
+    }
+    KimiRunA11yColumnName(&w, "v");
+    KimiRunA11yColumnUInt(&w, 1);
+    KimiRunA11yColumnName(&w, "n");
+    KimiRunA11yColumnUInt(&w, count);
+    KimiRunA11yTableColumns(&w, "types", "type", &types, count);
+    KimiRunA11yTableColumns(&w, "classes", "class", &classes, count);
+
+    KimiRunA11yColumnName(&w, "rect");
+    KimiRunA11yColumnArray(&w, count * 4);
+    for (size_t i = 0; i < count; i++) {
+        const float rect[4] = { elements[i].x, elements[i].y, elements[i].width, elements[i].height };
+        for (int k = 0; k < 4; k++) {
+            KimiRunA11yColumnSeparator(&w, i * 4 + (size_t)k);
+            if (json) {
+                KimiRunA11yJSONCoord(out, rect[k]);
+            } else {
+                KimiRunA11yMsgPackFloat(out, rect[k]);
+            }
+        }
+    }
+    KimiRunA11yColumnEnd(&w);
+
+    KimiRunA11yColumnName(&w, "traits");
+    KimiRunA11yColumnArray(&w, count);
+    for (size_t i = 0; i < count; i++) {
+        KimiRunA11yColumnSeparator(&w, i);
+        KimiRunA11yColumnUInt(&w, elements[i].traits);
+    }
+    KimiRunA11yColumnEnd(&w);
+    KimiRunA11yColumnName(&w, "flags");
+    KimiRunA11yColumnArray(&w, count);
+    for (size_t i = 0; i < count; i++) {
+        KimiRunA11yColumnSeparator(&w, i);
+        KimiRunA11yColumnUInt(&w, elements[i].flags);
+    }
+    KimiRunA11yColumnEnd(&w);
+
+    KimiRunA11yStringColumn(&w, "label", elements, count, offsetof(KimiRunA11yElement, label), false);
+    KimiRunA11yStringColumn(&w, "identifier", elements, count, offsetof(KimiRunA11yElement, identifier), false);
+    KimiRunA11yStringColumn(&w, "value", elements, count, offsetof(KimiRunA11yElement, value), false);
+    KimiRunA11yStringColumn(&w, "hint", elements, count, offsetof(KimiRunA11yElement, hint), false);
+    for (size_t c = 0; c < sizeof(kOptional) / sizeof(kOptional[0]); c++) {
+        if (present[c]) {
+            KimiRunA11yStringColumn(&w, kOptional[c].name, elements, count, kOptional[c].offset, true);
+        }
+    }
+    if (hasKeys) {
+        KimiRunA11yColumnName(&w, "key");
+        KimiRunA11yColumnArray(&w, count);
+        for (size_t i = 0; i < count; i++) {
+            KimiRunA11yColumnSeparator(&w, i);
+            if (json) {
+                KimiRunA11yJSONKey(out, elements[i].key);
+            } else {
+                KimiRunA11yMsgPackUInt(out, elements[i].key);
+            }
+        }
+        KimiRunA11yColumnEnd(&w);
+    }
+    if (json) {
+        KimiRunA11yPutByte(out, '}');
+    }
+
+    KimiRunA11yTableFree(&types);
+    KimiRunA11yTableFree(&classes);
+    return !out->failed;
+}
+
+bool KimiRunA11yEncode(KimiRunA11yFormat format,
+                       const KimiRunA11yElement *elements,
+                       size_t count,
+                       KimiRunA11yBuffer *out) {
+    if (!out || (!elements && count > 0)) {
+        return false;
+    }
+    // Rough upper bound for typical elements; avoids most regrowth.
+    KimiRunA11yReserve(out, 64 + count * 160);
+    switch (format) {
+        case KimiRunA11yFormatMin:
+            KimiRunA11yEncodeMin(elements, count, out);
+            return !out->failed;
+        case KimiRunA11yFormatColumnar:
+            return KimiRunA11yEncodeColumnar(elements, count, true, out);
+        case KimiRunA11yFormatMsgPack:
+            return KimiRunA11yEncodeColumnar(elements, count, false, out);
+    }
+    return false;
+}
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok;
+} KimiRunA11yReader;
+
+static uint64_t KimiRunA11yReadBig(KimiRunA11yReader *r, size_t width) {
+    if (!r->ok || (size_t)(r->end - r->p) < width) {
+        r->ok = false;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; i++) {
+        value = (value << 8) | r->p[i];
+    }
+    r->p += width;
+    return value;
+}
+
+static uint8_t KimiRunA11yReadTag(KimiRunA11yReader *r) {
+    return (uint8_t)KimiRunA11yReadBig(r, 1);
+}
+
+static uint8_t KimiRunA11yPeekTag(const KimiRunA11yReader *r) {
+    return (r->ok && r->p < r->end) ? *r->p : 0xc1;   // 0xc1 is never used
+}
+
+static size_t KimiRunA11yReadContainer(KimiRunA11yReader *r, bool map) {
+    uint8_t tag = KimiRunA11yReadTag(r);
+    uint8_t fix = map ? 0x80 : 0x90;
+    uint8_t tag16 = map ? 0xde : 0xdc;
+    size_t length = 0;
+    if ((tag & 0xf0) == fix) {
+        length = tag & 0x0f;
+    } else if (tag == tag16) {
+        length = (size_t)KimiRunA11yReadBig(r, 2);
+    } else if (tag == tag16 + 1) {
+        length = (size_t)KimiRunA11yReadBig(r, 4);
+    } else {
+        r->ok = false;
+    }
+    // Every entry takes at least one byte.
+    if (r->ok && length > (size_t)(r->end - r->p)) {
+        r->ok = false;
+    }
+    return r->ok ? length : 0;
+}
+
+static bool KimiRunA11yReadString(KimiRunA11yReader *r, const uint8_t **bytes, size_t *length) {
+    uint8_t tag = KimiRunA11yReadTag(r);
+    size_t n = 0;
+    if ((tag & 0xe0) == 0xa0) {
+        n = tag & 0x1f;
+    } else if (tag == 0xd9) {
+        n = (size_t)KimiRunA11yReadBig(r, 1);
+    } else if (tag == 0xda) {
+        n = (size_t)KimiRunA11yReadBig(r, 2);
+    } else if (tag == 0xdb) {
+        n = (size_t)KimiRunA11yReadBig(r, 4);
+    } else {
+        r->ok = false;
+    }
+    if (!r->ok || n > (size_t)(r->end - r->p)) {
+        r->ok = false;
+        return false;
+    }
+    *bytes = r->p;
+    *length = n;
+    r->p += n;
+    return true;
+}
+
+static uint64_t KimiRunA11yReadUInt(KimiRunA11yReader *r) {
+    uint8_t tag = KimiRunA11yReadTag(r);
+    if (tag < 0x80) {
+        return tag;
+    }
+    switch (tag) {
+        case 0xcc: return KimiRunA11yReadBig(r, 1);
+        case 0xcd: return KimiRunA11yReadBig(r, 2);
+        case 0xce: return KimiRunA11yReadBig(r, 4);
+        case 0xcf: return KimiRunA11yReadBig(r, 8);
+        default:
+            r->ok = false;
+            return 0;
+    }
+}
+
+static float KimiRunA11yReadNumber(KimiRunA11yReader *r) {
+    uint8_t tag = KimiRunA11yPeekTag(r);
+    if (tag == 0xca) {
+        r->p++;
+        uint32_t bits = (uint32_t)KimiRunA11yReadBig(r, 4);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    if (tag == 0xcb) {
+        r->p++;
+        uint64_t bits = KimiRunA11yReadBig(r, 8);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return (float)value;
+    }
+    if (tag >= 0xe0) {
+        r->p++;
+        return (float)(int8_t)tag;
+    }
+    return (float)KimiRunA11yReadUInt(r);
+}
+
+static void KimiRunA11ySkip(KimiRunA11yReader *r, int depth) {
+    if (depth > kMsgPackMaxDepth) {
+        r->ok = false;
+        return;
+    }
+    uint8_t tag = KimiRunA11yPeekTag(r);
+    if ((tag & 0xf0) == 0x80 || tag == 0xde || tag == 0xdf) {
+        size_t n = KimiRunA11yReadContainer(r, true);
+        for (size_t i = 0; i < n * 2 && r->ok; i++) {
+            KimiRunA11ySkip(r, depth + 1);
+        }
+        return;
+    }
+    if ((tag & 0xf0) == 0x90 || tag == 0xdc || tag == 0xdd) {
+        size_t n = KimiRunA11yReadContainer(r, false);
+        for (size_t i = 0; i < n && r->ok; i++) {
+            KimiRunA11ySkip(r, depth + 1);
+        }
+        return;
+    }
+    if ((tag & 0xe0) == 0xa0 || tag == 0xd9 || tag == 0xda || tag == 0xdb) {
+        const uint8_t *bytes;
+        size_t length;
+        KimiRunA11yReadString(r, &bytes, &length);
+        return;
+    }
+    r->p++;
+    switch (tag) {
+        case 0xc0: case 0xc2: case 0xc3: return;
+        case 0xcc: case 0xd0: KimiRunA11yReadBig(r, 1); return;
+        case 0xcd: case 0xd1: KimiRunA11yReadBig(r, 2); return;
+        case 0xca: case 0xce: case 0xd2: KimiRunA11yReadBig(r, 4); return;
+        case 0xcb: case 0xcf: case 0xd3: KimiRunA11yReadBig(r, 8); return;
+        default:
+            if (tag < 0x80 || tag >= 0xe0) {
+                return;
+            }
+            r->ok = false;
+    }
+}
+
+typedef struct {
+    char *next;
+    const char *end;
+} KimiRunA11yArena;
+
+static const char *KimiRunA11yArenaCopy(KimiRunA11yArena *arena, const uint8_t *bytes, size_t length) {
+    if ((size_t)(arena->end - arena->next) < length + 1) {
+        return NULL;
+    }
+    char *copy = arena->next;
+    memcpy(copy, bytes, length);
+    copy[length] = '\0';
+    arena->next += length + 1;
+    return copy;
+}
+
+static bool KimiRunA11yKeyIs(const uint8_t *bytes, size_t length, const char *name) {
+    return strlen(name) == length && memcmp(bytes, name, length) == 0;
+}
+
+// Reads a string (or nil when optional) column into the field at fieldOffset.
+static void KimiRunA11yReadStringColumn(KimiRunA11yReader *r, KimiRunA11yArena *arena,
+                                        KimiRunA11yElement *elements, size_t count,
+                                        size_t fieldOffset, bool optional) {
+    if (KimiRunA11yReadContainer(r, false) != count) {
+        r->ok = false;
+        return;
+    }
+    for (size_t i = 0; i < count && r->ok; i++) {
+        const char **field = (const char **)((char *)&elements[i] + fieldOffset);
+        if (KimiRunA11yPeekTag(r) == 0xc0 && optional) {
+            r->p++;
+            *field = NULL;
+            continue;
+        }
+        const uint8_t *bytes;
+        size_t length;
+        if (KimiRunA11yReadString(r, &bytes, &length)) {
+            *field = KimiRunA11yArenaCopy(arena, bytes, length);
+            r->ok = *field != NULL;
+        }
+    }
+}
+
+static const char **KimiRunA11yReadTable(KimiRunA11yReader *r, KimiRunA11yArena *arena, size_t *tableCount) {
+    size_t n = KimiRunA11yReadContainer(r, false);
+    const char **strings = r->ok ? calloc(n ? n : 1, sizeof(*strings)) : NULL;
+    if (!strings) {
+        r->ok = false;
+        return NULL;
+    }
+    for (size_t i = 0; i < n && r->ok; i++) {
+        const uint8_t *bytes;
+        size_t length;
+        if (KimiRunA11yReadString(r, &bytes, &length)) {
+            strings[i] = KimiRunA11yArenaCopy(arena, bytes, length);
+            r->ok = strings[i] != NULL;
+        }
+    }
+    *tableCount = n;
+    return strings;
+}
+
+static void KimiRunA11yReadIndexColumn(KimiRunA11yReader *r, const char **table, size_t tableCount,
+                                       KimiRunA11yElement *elements, size_t count, size_t fieldOffset) {
+    if (!table || KimiRunA11yReadContainer(r, false) != count) {
+        r->ok = false;
+        return;
+    }
+    for (size_t i = 0; i < count && r->ok; i++) {
+        uint64_t index = KimiRunA11yReadUInt(r);
+        if (index >= tableCount) {
+            r->ok = false;
+            return;
+        }
+        *(const char **)((char *)&elements[i] + fieldOffset) = table[index];
+    }
+}
+
+bool KimiRunA11yDecodeMsgPack(const uint8_t *bytes, size_t length, KimiRunA11yDecoded *out) {
+    if (!out) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!bytes) {
+        return false;
+    }
+    KimiRunA11yReader r = { bytes, bytes + length, true };
+    size_t columns = KimiRunA11yReadContainer(&r, true);
+    // A string and its NUL never take more room than its encoding did.
+    out->arena = malloc(length + 1);
+    if (!r.ok || !out->arena) {
+        KimiRunA11yDecodedFree(out);
+        return false;
+    }
+    KimiRunA11yArena arena = { out->arena, out->arena + length + 1 };
+    const char **types = NULL;
+    const char **classes = NULL;
+    size_t typeCount = 0, classCount = 0;
+    bool haveCount = false;
+
+    for (size_t c = 0; c < columns && r.ok; c++) {
+        const uint8_t *key;
+        size_t keyLength;
+        if (!KimiRunA11yReadString(&r, &key, &keyLength)) {
+            break;
+        }
+        if (KimiRunA11yKeyIs(key, keyLength, "n")) {
+            uint64_t n = KimiRunA11yReadUInt(&r);
+            if (haveCount || n > length) {
+                r.ok = false;
+                break;
+            }
+            out->count = (size_t)n;
+            out->elements = calloc(out->count ? out->count : 1, sizeof(*out->elements));
+            r.ok = r.ok && out->elements != NULL;
+            haveCount = true;
+            continue;
+        }
+        if (!haveCount) {
+            // "v" and unknown leading keys only.
+            KimiRunA11ySkip(&r, 0);
+            continue;
+        }
+        KimiRunA11yElement *elements = out->elements;
+        size_t count = out->count;
+        if (KimiRunA11yKeyIs(key, keyLength, "types")) {
+            free(types);
+            types = KimiRunA11yReadTable(&r, &arena, &typeCount);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "classes")) {
+            free(classes);
+            classes = KimiRunA11yReadTable(&r, &arena, &classCount);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "type")) {
+            KimiRunA11yReadIndexColumn(&r, types, typeCount, elements, count, offsetof(KimiRunA11yElement, type));
+        } else if (KimiRunA11yKeyIs(key, keyLength, "class")) {
+            KimiRunA11yReadIndexColumn(&r, classes, classCount, elements, count, offsetof(KimiRunA11yElement, className));
+        } else if (KimiRunA11yKeyIs(key, keyLength, "rect")) {
+            if (KimiRunA11yReadContainer(&r, false) != count * 4) {
+                r.ok = false;
+                break;
+            }
+            for (size_t i = 0; i < count && r.ok; i++) {
+                elements[i].x = KimiRunA11yReadNumber(&r);
+                elements[i].y = KimiRunA11yReadNumber(&r);
+                elements[i].width = KimiRunA11yReadNumber(&r);
+                elements[i].height = KimiRunA11yReadNumber(&r);
+            }
+        } else if (KimiRunA11yKeyIs(key, keyLength, "traits") ||
+                   KimiRunA11yKeyIs(key, keyLength, "flags") ||
+                   KimiRunA11yKeyIs(key, keyLength, "key")) {
+            if (KimiRunA11yReadContainer(&r, false) != count) {
+                r.ok = false;
+                break;
+            }
+            for (size_t i = 0; i < count && r.ok; i++) {
+                uint64_t value = KimiRunA11yReadUInt(&r);
+                if (key[0] == 't') {
+                    elements[i].traits = value;
+                } else if (key[0] == 'f') {
+                    elements[i].flags = (uint8_t)value;
+                } else {
+                    elements[i].key = value;
+                }
+            }
+        } else if (KimiRunA11yKeyIs(key, keyLength, "label")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, label), false);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "identifier")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, identifier), false);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "value")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, value), false);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "hint")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, hint), false);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "text")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, text), true);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "placeholder")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, placeholder), true);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "processName")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, processName), true);
+        } else if (KimiRunA11yKeyIs(key, keyLength, "bundleID")) {
+            KimiRunA11yReadStringColumn(&r, &arena, elements, count, offsetof(KimiRunA11yElement, bundleID), true);
+        } else {
+            KimiRunA11ySkip(&r, 0);
+        }
+    }
+    free(types);
+    free(classes);
+    if (!r.ok || !haveCount) {
+        KimiRunA11yDecodedFree(out);
+        return false;
+    }
+    return true;
+}
+
+void KimiRunA11yDecodedFree(KimiRunA11yDecoded *decoded) {
+    if (!decoded) {
+        return;
+    }
+    free(decoded->elements);
+    free(decoded->arena);
+    memset(decoded, 0, sizeof(*decoded));
+}
@@ -0,0 +1,108 @@
+//
+//  KimiRunA11yEncode.h
+//  KimiRun - Compact Accessibility Element Encodings
+//
+//  Portable C (no Foundation). Encodes interactive-element lists in three
+//  negotiated forms, all cheaper than the pretty-printed row JSON:
+//
+//    min       row JSON, minified; bounds as [x,y,w,h], traits as a
+//              bitmask, empty strings and derivable fields (rect,
+//              center_x/center_y, index) omitted
+//    columnar  one JSON object of parallel arrays (below)
+//    msgpack   the columnar object as MessagePack; keys are uint64
+//
+//  Columnar layout (JSON and MessagePack):
+//    v 1, n count,
+//    types / type      unique type names + per-element index into them
+//    classes / class   unique class names + per-element index
+//    rect              n*4 numbers, x y w h per element
+//    traits            UIAccessibilityTraits bitmask per element
+//    flags             bit0 enabled, bit1 visible
+//    label identifier value hint    strings ("" when empty)
+//    text placeholder processName bundleID
+//                      only when some element has them; nil/null = absent
+//    key               only when some element has one (hex strings in JSON)
+//
+//  Element positions are the element indexes.
+//
+
+#ifndef KIMIRUN_A11Y_ENCODE_H
+#define KIMIRUN_A11Y_ENCODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    KimiRunA11yFormatMin = 0,
+    KimiRunA11yFormatColumnar,
+    KimiRunA11yFormatMsgPack
+} KimiRunA11yFormat;
+
+enum {
+    KimiRunA11yFlagEnabled = 1u << 0,
+    KimiRunA11yFlagVisible = 1u << 1
+};
+
+// Strings are UTF-8. type/className/label/identifier/value/hint treat NULL
+// as ""; the optional fields treat NULL as absent.
+typedef struct {
+    const char *type;
+    const char *className;
+    const char *label;
+    const char *identifier;
+    const char *value;
+    const char *hint;
+    const char *text;
+    const char *placeholder;
+    const char *processName;
+    const char *bundleID;
+    float x;
+    float y;
+    float width;
+    float height;
+    uint64_t traits;
+    uint64_t key;                  // 0 == none
+    uint8_t flags;                 // KimiRunA11yFlag*
+} KimiRunA11yElement;
+
+typedef struct {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+    bool failed;                   // an allocation failed; bytes are incomplete
+} KimiRunA11yBuffer;
+
+/** Parse "min", "columnar" or "msgpack"; false for anything else. */
+bool KimiRunA11yFormatFromName(const char *name, KimiRunA11yFormat *out);
+const char *KimiRunA11yFormatContentType(KimiRunA11yFormat format);
+
+/** Append the encoding of elements to out. False on allocation failure. */
+bool KimiRunA11yEncode(KimiRunA11yFormat format,
+                       const KimiRunA11yElement *elements,
+                       size_t count,
+                       KimiRunA11yBuffer *out);
+void KimiRunA11yBufferFree(KimiRunA11yBuffer *buffer);
+
+typedef struct {
+    KimiRunA11yElement *elements;  // strings point into the arena
+    size_t count;
+    char *arena;
+} KimiRunA11yDecoded;
+
+/**
+ * Decode the msgpack form. Every string is copied into one arena and
+ * NUL-terminated. False on malformed input; out is then empty.
+ */
+bool KimiRunA11yDecodeMsgPack(const uint8_t *bytes, size_t length, KimiRunA11yDecoded *out);
+void KimiRunA11yDecodedFree(KimiRunA11yDecoded *decoded);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
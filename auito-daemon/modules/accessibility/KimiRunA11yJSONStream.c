@@ -0,0 +1,258 @@
+//
+//  KimiRunA11yJSONStream.c
+//  KimiRun - Streaming JSON Writer
+//
+
+#include "KimiRunA11yJSONStream.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool KimiRunA11yJSONFail(KimiRunA11yJSONStream *stream) {
+    stream->failed = true;
+    return false;
+}
+
+static bool KimiRunA11yJSONDrain(KimiRunA11yJSONStream *stream) {
+    if (stream->length == 0) {
+        return true;
+    }
+    size_t length = stream->length;
+    stream->length = 0;
+    stream->flushes++;
+    if (!stream->flush || !stream->flush(stream->context, stream->buffer, length)) {
+        return KimiRunA11yJSONFail(stream);
+    }
+    return true;
+}
+
+static bool KimiRunA11yJSONPut(KimiRunA11yJSONStream *stream, const void *bytes, size_t length) {
+    const char *p = bytes;
+    stream->bytes += length;
+    while (length > 0) {
+        size_t space = stream->capacity - stream->length;
+        if (space == 0) {
+            if (!KimiRunA11yJSONDrain(stream)) {
+                return false;
+            }
+            continue;
+        }
+        size_t n = length < space ? length : space;
+        memcpy(stream->buffer + stream->length, p, n);
+        stream->length += n;
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+static bool KimiRunA11yJSONPutByte(KimiRunA11yJSONStream *stream, char byte) {
+    if (stream->length == stream->capacity && !KimiRunA11yJSONDrain(stream)) {
+        return false;
+    }
+    stream->buffer[stream->length++] = byte;
+    stream->bytes++;
+    return true;
+}
+
+static bool KimiRunA11yJSONInObject(const KimiRunA11yJSONStream *stream) {
+    return stream->depth > 0 && (stream->objects >> (stream->depth - 1)) & 1;
+}
+
+// Separator bookkeeping shared by every value, containers included.
+static bool KimiRunA11yJSONBeginValue(KimiRunA11yJSONStream *stream) {
+    if (stream->failed || stream->done) {
+        return KimiRunA11yJSONFail(stream);
+    }
+    if (stream->depth == 0) {
+        return true;
+    }
+    if (KimiRunA11yJSONInObject(stream)) {
+        if (!stream->afterKey) {
+            return KimiRunA11yJSONFail(stream);
+        }
+        stream->afterKey = false;
+        return true;
+    }
+    uint64_t bit = 1ull << (stream->depth - 1);
+    if (stream->nonEmpty & bit) {
+        return KimiRunA11yJSONPutByte(stream, ',');
+    }
+    stream->nonEmpty |= bit;
+    return true;
+}
+
+static void KimiRunA11yJSONEndValue(KimiRunA11yJSONStream *stream) {
+    if (stream->depth == 0) {
+        stream->done = true;
+    }
+}
+
+static bool KimiRunA11yJSONOpen(KimiRunA11yJSONStream *stream, bool object) {
+    if (!KimiRunA11yJSONBeginValue(stream)) {
+        return false;
+    }
+    if (stream->depth == KIMIRUN_A11Y_JSON_MAX_DEPTH) {
+        return KimiRunA11yJSONFail(stream);
+    }
+    uint64_t bit = 1ull << stream->depth;
+    stream->objects = object ? (stream->objects | bit) : (stream->objects & ~bit);
+    stream->nonEmpty &= ~bit;
+    stream->depth++;
+    return KimiRunA11yJSONPutByte(stream, object ? '{' : '[');
+}
+
+static bool KimiRunA11yJSONClose(KimiRunA11yJSONStream *stream, bool object) {
+    if (stream->failed || stream->depth == 0 || stream->afterKey ||
+        KimiRunA11yJSONInObject(stream) != object) {
+        return KimiRunA11yJSONFail(stream);
+    }
+    stream->depth--;
+    if (!KimiRunA11yJSONPutByte(stream, object ? '}' : ']')) {
+        return false;
+    }
+    KimiRunA11yJSONEndValue(stream);
+    return true;
+}
+
+static bool KimiRunA11yJSONQuoted(KimiRunA11yJSONStream *stream, const char *string, size_t length) {
+    static const char kHex[] = "0123456789abcdef";
+    if (!KimiRunA11yJSONPutByte(stream, '"')) {
+        return false;
+    }
+    const unsigned char *p = (const unsigned char *)(string ? string : "");
+    const unsigned char *end = p + (string ? length : 0);
+    const unsigned char *run = p;
+    for (; p < end; p++) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        if (!KimiRunA11yJSONPut(stream, run, (size_t)(p - run))) {
+            return false;
+        }
+        run = p + 1;
+        bool ok;
+        if (c == '"' || c == '\\') {
+            char escaped[2] = { '\\', (char)c };
+            ok = KimiRunA11yJSONPut(stream, escaped, 2);
+        } else if (c == '\n') {
+            ok = KimiRunA11yJSONPut(stream, "\\n", 2);
+        } else if (c == '\r') {
+            ok = KimiRunA11yJSONPut(stream, "\\r", 2);
+        } else if (c == '\t') {
+            ok = KimiRunA11yJSONPut(stream, "\\t", 2);
+        } else {
+            char escaped[6] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 15] };
+            ok = KimiRunA11yJSONPut(stream, escaped, 6);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return KimiRunA11yJSONPut(stream, run, (size_t)(p - run)) && KimiRunA11yJSONPutByte(stream, '"');
+}
+
+void KimiRunA11yJSONStreamInit(KimiRunA11yJSONStream *stream,
+                               char *buffer,
+                               size_t capacity,
+                               KimiRunA11yJSONFlushFn flush,
+                               void *context) {
+    memset(stream, 0, sizeof(*stream));
+    stream->buffer = buffer;
+    stream->capacity = capacity;
+    stream->flush = flush;
+    stream->context = context;
+    stream->failed = !buffer || capacity < 16;
+}
+
+bool KimiRunA11yJSONBeginObject(KimiRunA11yJSONStream *stream) {
+    return KimiRunA11yJSONOpen(stream, true);
+}
+
+bool KimiRunA11yJSONEndObject(KimiRunA11yJSONStream *stream) {
+    return KimiRunA11yJSONClose(stream, true);
+}
+
+bool KimiRunA11yJSONBeginArray(KimiRunA11yJSONStream *stream) {
+    return KimiRunA11yJSONOpen(stream, false);
+}
+
+bool KimiRunA11yJSONEndArray(KimiRunA11yJSONStream *stream) {
+    return KimiRunA11yJSONClose(stream, false);
+}
+
+bool KimiRunA11yJSONKey(KimiRunA11yJSONStream *stream, const char *key) {
+    if (stream->failed || !KimiRunA11yJSONInObject(stream) || stream->afterKey || !key) {
+        return KimiRunA11yJSONFail(stream);
+    }
+    uint64_t bit = 1ull << (stream->depth - 1);
+    if ((stream->nonEmpty & bit) && !KimiRunA11yJSONPutByte(stream, ',')) {
+        return false;
+    }
+    stream->nonEmpty |= bit;
+    if (!KimiRunA11yJSONQuoted(stream, key, strlen(key)) || !KimiRunA11yJSONPutByte(stream, ':')) {
+        return false;
+    }
+    stream->afterKey = true;
+    return true;
+}
+
+bool KimiRunA11yJSONString(KimiRunA11yJSONStream *stream, const char *string, size_t length) {
+    if (!KimiRunA11yJSONBeginValue(stream) || !KimiRunA11yJSONQuoted(stream, string, length)) {
+        return false;
+    }
+    KimiRunA11yJSONEndValue(stream);
+    return true;
+}
+
+static bool KimiRunA11yJSONLiteral(KimiRunA11yJSONStream *stream, const char *literal, size_t length) {
+    if (!KimiRunA11yJSONBeginValue(stream) || !KimiRunA11yJSONPut(stream, literal, length)) {
+        return false;
+    }
+    KimiRunA11yJSONEndValue(stream);
+    return true;
+}
+
+bool KimiRunA11yJSONDouble(KimiRunA11yJSONStream *stream, double value) {
+    if (!isfinite(value)) {
+        return KimiRunA11yJSONNull(stream);
+    }
+    // Frames are mostly whole or half points; 15 digits covers nearly all
+    // of them without the 0.1 -> 0.10000000000000001 noise of 17.
+    char text[32];
+    int n = snprintf(text, sizeof(text), "%.15g", value);
+    if (strtod(text, NULL) != value) {
+        n = snprintf(text, sizeof(text), "%.17g", value);
+    }
+    return KimiRunA11yJSONLiteral(stream, text, (size_t)n);
+}
+
+bool KimiRunA11yJSONInteger(KimiRunA11yJSONStream *stream, int64_t value) {
+    char text[24];
+    int n = snprintf(text, sizeof(text), "%lld", (long long)value);
+    return KimiRunA11yJSONLiteral(stream, text, (size_t)n);
+}
+
+bool KimiRunA11yJSONUnsigned(KimiRunA11yJSONStream *stream, uint64_t value) {
+    char text[24];
+    int n = snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+    return KimiRunA11yJSONLiteral(stream, text, (size_t)n);
+}
+
+bool KimiRunA11yJSONBool(KimiRunA11yJSONStream *stream, bool value) {
+    return value ? KimiRunA11yJSONLiteral(stream, "true", 4) : KimiRunA11yJSONLiteral(stream, "false", 5);
+}
+
+bool KimiRunA11yJSONNull(KimiRunA11yJSONStream *stream) {
+    return KimiRunA11yJSONLiteral(stream, "null", 4);
+}
+
+bool KimiRunA11yJSONFlush(KimiRunA11yJSONStream *stream) {
+    if (stream->failed) {
+        return false;
+    }
+    return KimiRunA11yJSONDrain(stream);
+}
@@ -0,0 +1,77 @@
+//
+//  KimiRunA11yJSONStream.h
+//  KimiRun - Streaming JSON Writer
+//
+//  Portable C (no Foundation). Writes compact JSON token by token into a
+//  caller-owned fixed-size buffer and hands the buffer to a flush callback
+//  whenever it fills, so a document of any size is written in at most
+//  `capacity` bytes of memory. Commas and nesting are tracked by the
+//  writer; the caller only emits keys and values. After any error (flush
+//  failure, misplaced token, nesting deeper than KIMIRUN_A11Y_JSON_MAX_DEPTH)
+//  the writer is failed and every later call returns false.
+//
+
+#ifndef KIMIRUN_A11Y_JSON_STREAM_H
+#define KIMIRUN_A11Y_JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_A11Y_JSON_MAX_DEPTH 64
+
+// Returns false to abandon the document (e.g. the peer went away).
+typedef bool (*KimiRunA11yJSONFlushFn)(void *context, const char *bytes, size_t length);
+
+typedef struct {
+    char *buffer;
+    size_t capacity;
+    size_t length;                 // bytes buffered, not yet flushed
+    KimiRunA11yJSONFlushFn flush;
+    void *context;
+    uint64_t bytes;                // bytes written, flushed or not
+    uint32_t flushes;
+    uint32_t depth;
+    uint64_t objects;              // bit d: container at depth d is an object
+    uint64_t nonEmpty;             // bit d: container at depth d has a member
+    bool afterKey;                 // a key was written; its value is due
+    bool done;                     // the top-level value is complete
+    bool failed;
+} KimiRunA11yJSONStream;
+
+/** buffer must hold at least 16 bytes. */
+void KimiRunA11yJSONStreamInit(KimiRunA11yJSONStream *stream,
+                               char *buffer,
+                               size_t capacity,
+                               KimiRunA11yJSONFlushFn flush,
+                               void *context);
+
+bool KimiRunA11yJSONBeginObject(KimiRunA11yJSONStream *stream);
+bool KimiRunA11yJSONEndObject(KimiRunA11yJSONStream *stream);
+bool KimiRunA11yJSONBeginArray(KimiRunA11yJSONStream *stream);
+bool KimiRunA11yJSONEndArray(KimiRunA11yJSONStream *stream);
+
+/** Only inside an object, before each value. key is NUL-terminated UTF-8. */
+bool KimiRunA11yJSONKey(KimiRunA11yJSONStream *stream, const char *key);
+
+/** UTF-8; NULL is written as "". */
+bool KimiRunA11yJSONString(KimiRunA11yJSONStream *stream, const char *string, size_t length);
+/** Shortest form that reads back as the same double; NaN and infinities as null. */
+bool KimiRunA11yJSONDouble(KimiRunA11yJSONStream *stream, double value);
+bool KimiRunA11yJSONInteger(KimiRunA11yJSONStream *stream, int64_t value);
+bool KimiRunA11yJSONUnsigned(KimiRunA11yJSONStream *stream, uint64_t value);
+bool KimiRunA11yJSONBool(KimiRunA11yJSONStream *stream, bool value);
+bool KimiRunA11yJSONNull(KimiRunA11yJSONStream *stream);
+
+/** Flush whatever is buffered. False if the writer failed at any point. */
+bool KimiRunA11yJSONFlush(KimiRunA11yJSONStream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
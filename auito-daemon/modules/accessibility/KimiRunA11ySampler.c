@@ -0,0 +1,334 @@
+//
+//  KimiRunA11ySampler.c
+//  KimiRun - Adaptive Hit-Test Sampling
+//
+
+#include "KimiRunA11ySampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+typedef struct {
+    float x;
+    float y;
+    float width;
+    float height;
+    uint64_t identity;             // hit at the cell center
+    uint32_t firstChild;           // children row-major after this index; 0 = leaf
+    uint32_t depth;
+    uint32_t split;                // KimiRunA11ySplit* mask the children were made with
+} KimiRunA11yCell;
+
+enum {
+    KimiRunA11ySplitX = 1u << 0,   // left / right halves
+    KimiRunA11ySplitY = 1u << 1    // top / bottom halves
+};
+
+typedef struct {
+    float x;
+    float y;
+    uint64_t identity;
+} KimiRunA11ySeed;
+
+typedef struct {
+    float x;
+    float y;
+    float width;
+    float height;
+    uint32_t columns;
+    uint32_t rows;
+    KimiRunA11yCell *cells;
+    uint32_t count;
+    uint32_t capacity;
+    KimiRunA11ySeed *seeds;
+    uint32_t seedCount;
+} KimiRunA11ySampler;
+
+void KimiRunA11ySampleConfigDefault(KimiRunA11ySampleConfig *config) {
+    if (!config) {
+        return;
+    }
+    config->columns = 3;
+    config->rows = 10;
+    config->minCellSize = 20.0f;
+    config->maxCalls = 48;
+}
+
+static bool KimiRunA11ySamplerContains(const KimiRunA11ySampler *sampler, float px, float py) {
+    return px >= sampler->x && py >= sampler->y &&
+           px < sampler->x + sampler->width && py < sampler->y + sampler->height;
+}
+
+// Identity of the deepest sampled cell containing the point.
+static uint64_t KimiRunA11ySamplerLookup(const KimiRunA11ySampler *sampler, float px, float py) {
+    float cellWidth = sampler->width / (float)sampler->columns;
+    float cellHeight = sampler->height / (float)sampler->rows;
+    uint32_t column = (uint32_t)((px - sampler->x) / cellWidth);
+    uint32_t row = (uint32_t)((py - sampler->y) / cellHeight);
+    if (column >= sampler->columns) column = sampler->columns - 1;
+    if (row >= sampler->rows) row = sampler->rows - 1;
+    const KimiRunA11yCell *cell = &sampler->cells[row * sampler->columns + column];
+    while (cell->firstChild) {
+        uint32_t right = (cell->split & KimiRunA11ySplitX) && px >= cell->x + cell->width * 0.5f ? 1u : 0u;
+        uint32_t lower = (cell->split & KimiRunA11ySplitY) && py >= cell->y + cell->height * 0.5f ? 1u : 0u;
+        cell = &sampler->cells[cell->firstChild + lower * ((cell->split & KimiRunA11ySplitX) ? 2u : 1u) + right];
+    }
+    return cell->identity;
+}
+
+// Axes along which the cell's sample disagrees with the samples one
+// cell-size away, i.e. where an element boundary crosses the cell. A seed
+// inside the cell that hit something else splits both ways.
+static uint32_t KimiRunA11ySamplerCellSplit(const KimiRunA11ySampler *sampler, const KimiRunA11yCell *cell) {
+    float cx = cell->x + cell->width * 0.5f;
+    float cy = cell->y + cell->height * 0.5f;
+    const struct { float x; float y; uint32_t axis; } probes[4] = {
+        { cx - cell->width, cy, KimiRunA11ySplitX },
+        { cx + cell->width, cy, KimiRunA11ySplitX },
+        { cx, cy - cell->height, KimiRunA11ySplitY },
+        { cx, cy + cell->height, KimiRunA11ySplitY },
+    };
+    uint32_t split = 0;
+    for (int i = 0; i < 4; i++) {
+        if (!(split & probes[i].axis) &&
+            KimiRunA11ySamplerContains(sampler, probes[i].x, probes[i].y) &&
+            KimiRunA11ySamplerLookup(sampler, probes[i].x, probes[i].y) != cell->identity) {
+            split |= probes[i].axis;
+        }
+    }
+    for (uint32_t i = 0; i < sampler->seedCount && split != (KimiRunA11ySplitX | KimiRunA11ySplitY); i++) {
+        const KimiRunA11ySeed *seed = &sampler->seeds[i];
+        if (seed->x >= cell->x && seed->y >= cell->y &&
+            seed->x < cell->x + cell->width && seed->y < cell->y + cell->height &&
+            seed->identity != cell->identity) {
+            split = KimiRunA11ySplitX | KimiRunA11ySplitY;
+        }
+    }
+    return split;
+}
+
+static bool KimiRunA11ySamplerReserve(KimiRunA11ySampler *sampler, uint32_t extra) {
+    if (sampler->count + extra <= sampler->capacity) {
+        return true;
+    }
+    uint32_t capacity = sampler->capacity ? sampler->capacity : 32;
+    while (capacity < sampler->count + extra) {
+        capacity *= 2;
+    }
+    KimiRunA11yCell *cells = realloc(sampler->cells, (size_t)capacity * sizeof(*cells));
+    if (!cells) {
+        return false;
+    }
+    sampler->cells = cells;
+    sampler->capacity = capacity;
+    return true;
+}
+
+static uint32_t KimiRunA11ySamplerGcd(uint32_t a, uint32_t b) {
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Roughly n / golden ratio, coprime with n, so j * stride % n visits every
+// cell once while consecutive visits land far apart.
+static uint32_t KimiRunA11ySamplerStride(uint32_t n) {
+    uint32_t stride = (uint32_t)((double)n * 0.6180339887) | 1u;
+    while (stride > 1 && KimiRunA11ySamplerGcd(stride, n) != 1) {
+        stride++;
+    }
+    return stride ? stride : 1;
+}
+
+// One hit test; false when the callback asked to stop.
+static bool KimiRunA11ySamplerHit(KimiRunA11yHitTestFn hitTest, void *context, float px, float py,
+                                  KimiRunA11ySampleStats *stats, uint64_t *identity) {
+    stats->calls++;
+    *identity = hitTest(context, px, py);
+    if (*identity == KIMIRUN_A11Y_SAMPLE_STOP) {
+        stats->stopped = true;
+        return false;
+    }
+    return true;
+}
+
+typedef enum {
+    KimiRunA11ySplitDone = 0,      // split, or nothing to split
+    KimiRunA11ySplitStopped,
+    KimiRunA11ySplitFailed
+} KimiRunA11ySplitResult;
+
+// Halves the cell across the boundaries it sees, so a stack of full-width
+// rows costs two calls per split rather than four.
+static KimiRunA11ySplitResult KimiRunA11ySamplerSplit(KimiRunA11ySampler *sampler, uint32_t index,
+                                                      float minCellSize, uint32_t maxCalls,
+                                                      KimiRunA11yHitTestFn hitTest, void *context,
+                                                      KimiRunA11ySampleStats *stats) {
+    KimiRunA11yCell cell = sampler->cells[index];
+    uint32_t split = KimiRunA11ySamplerCellSplit(sampler, &cell);
+    if (cell.width * 0.5f < minCellSize) {
+        split &= ~(uint32_t)KimiRunA11ySplitX;
+    }
+    if (cell.height * 0.5f < minCellSize) {
+        split &= ~(uint32_t)KimiRunA11ySplitY;
+    }
+    if (!split) {
+        return KimiRunA11ySplitDone;
+    }
+    uint32_t columns = (split & KimiRunA11ySplitX) ? 2 : 1;
+    uint32_t rows = (split & KimiRunA11ySplitY) ? 2 : 1;
+    if (stats->calls + columns * rows > maxCalls) {
+        // A cheaper split further on may still fit.
+        stats->budgetExhausted = true;
+        return KimiRunA11ySplitDone;
+    }
+    if (!KimiRunA11ySamplerReserve(sampler, columns * rows)) {
+        return KimiRunA11ySplitFailed;
+    }
+    float childWidth = cell.width / (float)columns;
+    float childHeight = cell.height / (float)rows;
+    uint32_t first = sampler->count;
+    for (uint32_t n = 0; n < columns * rows; n++) {
+        KimiRunA11yCell *child = &sampler->cells[first + n];
+        *child = (KimiRunA11yCell){
+            .x = cell.x + childWidth * (float)(n % columns),
+            .y = cell.y + childHeight * (float)(n / columns),
+            .width = childWidth,
+            .height = childHeight,
+            .depth = cell.depth + 1,
+        };
+        if (!KimiRunA11ySamplerHit(hitTest, context, child->x + childWidth * 0.5f, child->y + childHeight * 0.5f,
+                                   stats, &child->identity)) {
+            return KimiRunA11ySplitStopped;
+        }
+    }
+    // Linked only once every child is sampled, so lookups never land on an
+    // unsampled one.
+    sampler->count += columns * rows;
+    sampler->cells[index].firstChild = first;
+    sampler->cells[index].split = split;
+    stats->splits++;
+    if (cell.depth + 1 > stats->depth) {
+        stats->depth = cell.depth + 1;
+    }
+    return KimiRunA11ySplitDone;
+}
+
+bool KimiRunA11ySample(float x, float y, float width, float height,
+                       const KimiRunA11ySampleConfig *config,
+                       const float *seeds,
+                       uint32_t seedCount,
+                       KimiRunA11yHitTestFn hitTest,
+                       void *context,
+                       KimiRunA11ySampleStats *stats) {
+    KimiRunA11ySampleStats localStats;
+    if (!stats) {
+        stats = &localStats;
+    }
+    *stats = (KimiRunA11ySampleStats){0};
+    if (!hitTest || !isfinite(x) || !isfinite(y) ||
+        !isfinite(width) || !isfinite(height) || width <= 0.0f || height <= 0.0f) {
+        return true;
+    }
+
+    KimiRunA11ySampleConfig defaults;
+    KimiRunA11ySampleConfigDefault(&defaults);
+    if (!config) {
+        config = &defaults;
+    }
+
+    KimiRunA11ySampler sampler = {
+        .x = x,
+        .y = y,
+        .width = width,
+        .height = height,
+        .columns = config->columns ? config->columns : 1,
+        .rows = config->rows ? config->rows : 1,
+    };
+    float minCellSize = config->minCellSize > 0.0f ? config->minCellSize : 1.0f;
+    bool ok = true;
+
+    if (seedCount > 0 && seeds) {
+        sampler.seeds = malloc((size_t)seedCount * sizeof(*sampler.seeds));
+        if (!sampler.seeds) {
+            return false;
+        }
+    }
+
+    // Seeds only get what the coarse grid leaves of the budget.
+    uint32_t coarseCount = sampler.columns * sampler.rows;
+    for (uint32_t i = 0; sampler.seeds && i < seedCount; i++) {
+        float px = seeds[i * 2];
+        float py = seeds[i * 2 + 1];
+        if (!isfinite(px) || !isfinite(py) || !KimiRunA11ySamplerContains(&sampler, px, py)) {
+            continue;
+        }
+        if (stats->calls + coarseCount >= config->maxCalls) {
+            stats->budgetExhausted = true;
+            break;
+        }
+        KimiRunA11ySeed *seed = &sampler.seeds[sampler.seedCount];
+        seed->x = px;
+        seed->y = py;
+        stats->seedCalls++;
+        if (!KimiRunA11ySamplerHit(hitTest, context, px, py, stats, &seed->identity)) {
+            goto done;
+        }
+        sampler.seedCount++;
+    }
+
+    // The coarse grid is sampled even past the budget so every region has
+    // an identity to compare against.
+    if (!KimiRunA11ySamplerReserve(&sampler, coarseCount)) {
+        ok = false;
+        goto done;
+    }
+    float cellWidth = width / (float)sampler.columns;
+    float cellHeight = height / (float)sampler.rows;
+    for (uint32_t row = 0; row < sampler.rows; row++) {
+        for (uint32_t column = 0; column < sampler.columns; column++) {
+            KimiRunA11yCell *cell = &sampler.cells[sampler.count];
+            *cell = (KimiRunA11yCell){
+                .x = x + cellWidth * (float)column,
+                .y = y + cellHeight * (float)row,
+                .width = cellWidth,
+                .height = cellHeight,
+            };
+            if (!KimiRunA11ySamplerHit(hitTest, context, cell->x + cellWidth * 0.5f, cell->y + cellHeight * 0.5f,
+                                       stats, &cell->identity)) {
+                goto done;
+            }
+            sampler.count++;
+        }
+    }
+
+    // Level by level, so the budget is spread over the whole region rather
+    // than spent down one corner; within a level cells are visited in a
+    // strided order, so a budget that runs out mid-level still leaves
+    // refinements scattered across it.
+    for (uint32_t levelStart = 0, levelEnd = sampler.count; levelStart < levelEnd;
+         levelStart = levelEnd, levelEnd = sampler.count) {
+        uint32_t levelCount = levelEnd - levelStart;
+        uint32_t stride = KimiRunA11ySamplerStride(levelCount);
+        for (uint32_t j = 0; j < levelCount; j++) {
+            uint32_t index = levelStart + (uint32_t)(((uint64_t)j * stride) % levelCount);
+            KimiRunA11ySplitResult result = KimiRunA11ySamplerSplit(&sampler, index, minCellSize, config->maxCalls,
+                                                                    hitTest, context, stats);
+            if (result == KimiRunA11ySplitFailed) {
+                ok = false;
+                goto done;
+            }
+            if (result == KimiRunA11ySplitStopped) {
+                goto done;
+            }
+        }
+    }
+
+done:
+    free(sampler.cells);
+    free(sampler.seeds);
+    return ok;
+}
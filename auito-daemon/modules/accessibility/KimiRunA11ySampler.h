@@ -0,0 +1,71 @@
+//
+//  KimiRunA11ySampler.h
+//  KimiRun - Adaptive Hit-Test Sampling
+//
+//  Portable C (no Foundation). Plans the hit tests of the last-resort
+//  accessibility fallback. Seed points (the previous snapshot's element
+//  centers) are sampled first, then the centers of a coarse grid. A cell is
+//  then halved across each axis along which its sample differs from the
+//  neighbouring one (quartered when a seed inside it hit something else),
+//  level by level, until cells reach the minimum size or the call budget
+//  runs out. Uniform regions (one large element, or nothing) cost one
+//  call; the rest of the budget goes to element boundaries.
+//  The caller's callback performs each hit test and returns an identity for
+//  what it hit; deduping elements by identity is left to the caller.
+//
+
+#ifndef KIMIRUN_A11Y_SAMPLER_H
+#define KIMIRUN_A11Y_SAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Identity for "nothing accessible here".
+#define KIMIRUN_A11Y_SAMPLE_NONE 0
+// Returned by the callback to abandon sampling (e.g. past a deadline).
+#define KIMIRUN_A11Y_SAMPLE_STOP UINT64_MAX
+
+typedef uint64_t (*KimiRunA11yHitTestFn)(void *context, float x, float y);
+
+typedef struct {
+    uint32_t columns;           // coarse grid
+    uint32_t rows;
+    float minCellSize;          // cells are not split into halves smaller than this
+    uint32_t maxCalls;          // hit-test budget, seeds included; the coarse
+                                // grid is always sampled in full
+} KimiRunA11ySampleConfig;
+
+typedef struct {
+    uint32_t calls;             // hit tests issued
+    uint32_t seedCalls;
+    uint32_t splits;            // cells subdivided
+    uint32_t depth;             // deepest level sampled (0 = coarse grid)
+    bool budgetExhausted;       // a split was skipped for lack of calls
+    bool stopped;               // the callback returned KIMIRUN_A11Y_SAMPLE_STOP
+} KimiRunA11ySampleStats;
+
+/** 3 x 10 coarse grid, 20 pt minimum cells, 48 calls. */
+void KimiRunA11ySampleConfigDefault(KimiRunA11ySampleConfig *config);
+
+/**
+ * Sample the region (x, y, width, height). seeds holds seedCount (x, y)
+ * pairs; seeds outside the region are skipped. config may be NULL for the
+ * defaults. Returns false only on allocation failure.
+ */
+bool KimiRunA11ySample(float x, float y, float width, float height,
+                       const KimiRunA11ySampleConfig *config,
+                       const float *seeds,
+                       uint32_t seedCount,
+                       KimiRunA11yHitTestFn hitTest,
+                       void *context,
+                       KimiRunA11ySampleStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,442 @@
+//
+//  KimiRunA11ySearch.c
+//  KimiRun - Label / Identifier Search Index
+//
+
+#include "KimiRunA11ySearch.h"
+#include "KimiRunA11ySnapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Each element contributes two documents: 2 * element (label) and
+// 2 * element + 1 (identifier).
+typedef struct {
+    uint32_t offset;               // into arena
+    uint32_t length;
+    uint32_t trigrams;             // distinct padded trigrams
+} KimiRunA11yDocument;
+
+typedef struct {
+    uint64_t hash;
+    uint32_t document;
+} KimiRunA11yExact;
+
+struct KimiRunA11ySearch {
+    uint32_t count;
+    uint32_t documentCount;
+    KimiRunA11yDocument *documents;
+    char *arena;
+    KimiRunA11yExact *exact;       // non-empty documents sorted by hash
+    uint32_t exactCount;
+    uint32_t *trigrams;            // distinct trigrams, sorted
+    uint32_t trigramCount;
+    uint32_t *postingStart;        // trigramCount + 1 offsets into postings
+    uint32_t *postings;            // documents, ascending per trigram
+    // Query scratch.
+    uint32_t *hits;                // per document: query trigrams present
+    uint32_t *paddedHits;          // per document: padded query trigrams present
+    uint32_t *touched;             // documents with a nonzero counter
+    KimiRunA11yMatch *best;        // per element
+    uint32_t *found;               // elements with a match, in discovery order
+};
+
+size_t KimiRunA11ySearchNormalize(const char *text, char *out) {
+    size_t length = 0;
+    bool pendingSpace = false;
+    for (const unsigned char *p = (const unsigned char *)(text ? text : ""); *p; p++) {
+        unsigned char c = *p;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f') {
+            pendingSpace = length > 0;
+            continue;
+        }
+        if (pendingSpace) {
+            out[length++] = ' ';
+            pendingSpace = false;
+        }
+        out[length++] = (char)((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static int KimiRunA11yCompareU32(const void *a, const void *b) {
+    uint32_t left = *(const uint32_t *)a;
+    uint32_t right = *(const uint32_t *)b;
+    return (left > right) - (left < right);
+}
+
+static int KimiRunA11yCompareU64(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t *)a;
+    uint64_t right = *(const uint64_t *)b;
+    return (left > right) - (left < right);
+}
+
+static int KimiRunA11yCompareExact(const void *a, const void *b) {
+    const KimiRunA11yExact *left = a;
+    const KimiRunA11yExact *right = b;
+    if (left->hash != right->hash) {
+        return left->hash < right->hash ? -1 : 1;
+    }
+    return (left->document > right->document) - (left->document < right->document);
+}
+
+// Distinct 3-byte windows of text (of " text " when padded), sorted.
+// out needs length + 2 slots (length - 2 unpadded). Returns the count.
+static uint32_t KimiRunA11yTrigrams(const char *text, uint32_t length, bool padded, uint32_t *out) {
+    uint32_t count = 0;
+    const unsigned char *s = (const unsigned char *)text;
+    if (padded) {
+        for (uint32_t i = 0; i < length; i++) {
+            uint32_t a = i == 0 ? ' ' : s[i - 1];
+            uint32_t c = i + 1 < length ? s[i + 1] : ' ';
+            out[count++] = (a << 16) | ((uint32_t)s[i] << 8) | c;
+        }
+    } else {
+        for (uint32_t i = 0; i + 2 < length; i++) {
+            out[count++] = ((uint32_t)s[i] << 16) | ((uint32_t)s[i + 1] << 8) | s[i + 2];
+        }
+    }
+    qsort(out, count, sizeof(*out), KimiRunA11yCompareU32);
+    uint32_t distinct = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (distinct == 0 || out[distinct - 1] != out[i]) {
+            out[distinct++] = out[i];
+        }
+    }
+    return distinct;
+}
+
+static uint64_t KimiRunA11ySearchHash(const char *text, uint32_t length) {
+    return KimiRunA11yHash(KIMIRUN_A11Y_HASH_SEED, text, length);
+}
+
+void KimiRunA11ySearchDestroy(KimiRunA11ySearch *index) {
+    if (!index) {
+        return;
+    }
+    free(index->documents);
+    free(index->arena);
+    free(index->exact);
+    free(index->trigrams);
+    free(index->postingStart);
+    free(index->postings);
+    free(index->hits);
+    free(index->paddedHits);
+    free(index->touched);
+    free(index->best);
+    free(index->found);
+    free(index);
+}
+
+KimiRunA11ySearch *KimiRunA11ySearchCreate(const char *const *labels,
+                                           const char *const *identifiers,
+                                           uint32_t count) {
+    if (count > UINT32_MAX / 2) {
+        return NULL;
+    }
+    KimiRunA11ySearch *index = calloc(1, sizeof(*index));
+    if (!index) {
+        return NULL;
+    }
+    index->count = count;
+    index->documentCount = count * 2;
+    uint32_t documents = index->documentCount ? index->documentCount : 1;
+    index->documents = calloc(documents, sizeof(*index->documents));
+    index->hits = calloc(documents, sizeof(*index->hits));
+    index->paddedHits = calloc(documents, sizeof(*index->paddedHits));
+    index->touched = malloc((size_t)documents * sizeof(*index->touched));
+    index->best = malloc((size_t)(count ? count : 1) * sizeof(*index->best));
+    index->found = malloc((size_t)(count ? count : 1) * sizeof(*index->found));
+    if (!index->documents || !index->hits || !index->paddedHits || !index->touched ||
+        !index->best || !index->found) {
+        KimiRunA11ySearchDestroy(index);
+        return NULL;
+    }
+
+    size_t arenaSize = 0;
+    for (uint32_t d = 0; d < index->documentCount; d++) {
+        const char *const *source = (d & 1) ? identifiers : labels;
+        const char *text = source ? source[d / 2] : NULL;
+        arenaSize += (text ? strlen(text) : 0) + 1;
+    }
+    if (arenaSize > UINT32_MAX) {
+        KimiRunA11ySearchDestroy(index);
+        return NULL;
+    }
+    index->arena = malloc(arenaSize ? arenaSize : 1);
+    if (!index->arena) {
+        KimiRunA11ySearchDestroy(index);
+        return NULL;
+    }
+
+    // Normalize every document; the normalized form is never longer.
+    size_t offset = 0, maxLength = 0, pairCapacity = 0;
+    for (uint32_t d = 0; d < index->documentCount; d++) {
+        const char *const *source = (d & 1) ? identifiers : labels;
+        const char *text = source ? source[d / 2] : NULL;
+        size_t length = KimiRunA11ySearchNormalize(text, index->arena + offset);
+        index->documents[d].offset = (uint32_t)offset;
+        index->documents[d].length = (uint32_t)length;
+        offset += length + 1;
+        maxLength = length > maxLength ? length : maxLength;
+        pairCapacity += length;
+        index->exactCount += length > 0;
+    }
+
+    index->exact = malloc((size_t)(index->exactCount ? index->exactCount : 1) * sizeof(*index->exact));
+    uint64_t *pairs = malloc((pairCapacity ? pairCapacity : 1) * sizeof(*pairs));
+    uint32_t *window = malloc((maxLength + 2) * sizeof(*window));
+    if (!index->exact || !pairs || !window) {
+        free(pairs);
+        free(window);
+        KimiRunA11ySearchDestroy(index);
+        return NULL;
+    }
+
+    size_t pairCount = 0;
+    uint32_t exactCount = 0;
+    for (uint32_t d = 0; d < index->documentCount; d++) {
+        KimiRunA11yDocument *document = &index->documents[d];
+        if (document->length == 0) {
+            continue;
+        }
+        const char *text = index->arena + document->offset;
+        index->exact[exactCount].hash = KimiRunA11ySearchHash(text, document->length);
+        index->exact[exactCount].document = d;
+        exactCount++;
+        document->trigrams = KimiRunA11yTrigrams(text, document->length, true, window);
+        for (uint32_t t = 0; t < document->trigrams; t++) {
+            pairs[pairCount++] = ((uint64_t)window[t] << 32) | d;
+        }
+    }
+    free(window);
+    qsort(index->exact, index->exactCount, sizeof(*index->exact), KimiRunA11yCompareExact);
+    qsort(pairs, pairCount, sizeof(*pairs), KimiRunA11yCompareU64);
+
+    uint32_t distinct = 0;
+    for (size_t i = 0; i < pairCount; i++) {
+        distinct += (i == 0 || (pairs[i] >> 32) != (pairs[i - 1] >> 32));
+    }
+    index->trigramCount = distinct;
+    index->trigrams = malloc((size_t)(distinct ? distinct : 1) * sizeof(*index->trigrams));
+    index->postingStart = malloc(((size_t)distinct + 1) * sizeof(*index->postingStart));
+    index->postings = malloc((pairCount ? pairCount : 1) * sizeof(*index->postings));
+    if (!index->trigrams || !index->postingStart || !index->postings) {
+        free(pairs);
+        KimiRunA11ySearchDestroy(index);
+        return NULL;
+    }
+    uint32_t t = 0;
+    for (size_t i = 0; i < pairCount; i++) {
+        uint32_t trigram = (uint32_t)(pairs[i] >> 32);
+        if (i == 0 || trigram != index->trigrams[t - 1]) {
+            index->trigrams[t] = trigram;
+            index->postingStart[t] = (uint32_t)i;
+            t++;
+        }
+        index->postings[i] = (uint32_t)pairs[i];
+    }
+    index->postingStart[distinct] = (uint32_t)pairCount;
+    free(pairs);
+    return index;
+}
+
+static bool KimiRunA11yPostings(const KimiRunA11ySearch *index, uint32_t trigram,
+                                uint32_t *begin, uint32_t *end) {
+    uint32_t lo = 0, hi = index->trigramCount;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->trigrams[mid] < trigram) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == index->trigramCount || index->trigrams[lo] != trigram) {
+        return false;
+    }
+    *begin = index->postingStart[lo];
+    *end = index->postingStart[lo + 1];
+    return true;
+}
+
+static uint32_t KimiRunA11yDocumentField(uint32_t document) {
+    return (document & 1) ? KimiRunA11ySearchIdentifier : KimiRunA11ySearchLabel;
+}
+
+static void KimiRunA11yConsider(KimiRunA11ySearch *index, uint32_t *foundCount, uint32_t document,
+                                KimiRunA11yMatchKind kind, float score) {
+    uint32_t element = document / 2;
+    KimiRunA11yMatch *best = &index->best[element];
+    if (best->score < 0.0f) {
+        index->found[(*foundCount)++] = element;
+    } else if (best->score > score || (best->score == score && best->kind <= kind)) {
+        return;
+    }
+    best->element = element;
+    best->field = KimiRunA11yDocumentField(document);
+    best->kind = kind;
+    best->score = score;
+}
+
+// Prefix / substring score for a document known to contain the query.
+static void KimiRunA11yConsiderSubstring(KimiRunA11ySearch *index, uint32_t *foundCount, uint32_t document,
+                                         const char *query, uint32_t queryLength) {
+    const KimiRunA11yDocument *doc = &index->documents[document];
+    const char *text = index->arena + doc->offset;
+    const char *at = strstr(text, query);
+    if (!at || doc->length == queryLength) {
+        return;                    // equal strings are scored as exact
+    }
+    float share = (float)queryLength / (float)doc->length;
+    if (at == text) {
+        KimiRunA11yConsider(index, foundCount, document, KimiRunA11yMatchPrefix, 0.9f + 0.09f * share);
+    } else {
+        KimiRunA11yConsider(index, foundCount, document, KimiRunA11yMatchSubstring, 0.8f + 0.09f * share);
+    }
+}
+
+static int KimiRunA11yCompareMatches(const void *a, const void *b) {
+    const KimiRunA11yMatch *left = a;
+    const KimiRunA11yMatch *right = b;
+    if (left->score != right->score) {
+        return left->score > right->score ? -1 : 1;
+    }
+    if (left->kind != right->kind) {
+        return left->kind < right->kind ? -1 : 1;
+    }
+    return (left->element > right->element) - (left->element < right->element);
+}
+
+uint32_t KimiRunA11ySearchFind(KimiRunA11ySearch *index,
+                               const char *query,
+                               uint32_t fields,
+                               bool fuzzy,
+                               KimiRunA11yMatch *out,
+                               uint32_t capacity) {
+    if (!index || !query || index->count == 0) {
+        return 0;
+    }
+    size_t rawLength = strlen(query);
+    if (rawLength > UINT32_MAX - 2) {
+        return 0;
+    }
+    char *normalized = malloc(rawLength + 1);
+    uint32_t *window = malloc((rawLength + 2) * sizeof(*window));
+    if (!normalized || !window) {
+        free(normalized);
+        free(window);
+        return 0;
+    }
+    uint32_t queryLength = (uint32_t)KimiRunA11ySearchNormalize(query, normalized);
+    if (queryLength == 0) {
+        free(normalized);
+        free(window);
+        return 0;
+    }
+    for (uint32_t i = 0; i < index->count; i++) {
+        index->best[i].score = -1.0f;
+    }
+    uint32_t foundCount = 0;
+
+    // Exact.
+    uint64_t hash = KimiRunA11ySearchHash(normalized, queryLength);
+    uint32_t lo = 0, hi = index->exactCount;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->exact[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (uint32_t i = lo; i < index->exactCount && index->exact[i].hash == hash; i++) {
+        uint32_t document = index->exact[i].document;
+        const KimiRunA11yDocument *doc = &index->documents[document];
+        if ((KimiRunA11yDocumentField(document) & fields) && doc->length == queryLength &&
+            memcmp(index->arena + doc->offset, normalized, queryLength) == 0) {
+            KimiRunA11yConsider(index, &foundCount, document, KimiRunA11yMatchExact, 1.0f);
+        }
+    }
+
+    // Substring candidates hold every trigram of the query; shorter queries
+    // have none, so check each document directly.
+    uint32_t touchedCount = 0;
+    uint32_t queryTrigrams = 0;
+    if (queryLength < 3) {
+        for (uint32_t d = 0; d < index->documentCount; d++) {
+            if ((KimiRunA11yDocumentField(d) & fields) && index->documents[d].length > queryLength) {
+                KimiRunA11yConsiderSubstring(index, &foundCount, d, normalized, queryLength);
+            }
+        }
+    } else {
+        queryTrigrams = KimiRunA11yTrigrams(normalized, queryLength, false, window);
+        for (uint32_t t = 0; t < queryTrigrams; t++) {
+            uint32_t begin, end;
+            if (!KimiRunA11yPostings(index, window[t], &begin, &end)) {
+                continue;
+            }
+            for (uint32_t p = begin; p < end; p++) {
+                uint32_t d = index->postings[p];
+                if (index->hits[d]++ == 0) {
+                    index->touched[touchedCount++] = d;
+                }
+            }
+        }
+    }
+
+    // Fuzzy: padded trigram similarity, counted for every document sharing one.
+    uint32_t paddedTrigrams = 0;
+    if (fuzzy) {
+        paddedTrigrams = KimiRunA11yTrigrams(normalized, queryLength, true, window);
+        for (uint32_t t = 0; t < paddedTrigrams; t++) {
+            uint32_t begin, end;
+            if (!KimiRunA11yPostings(index, window[t], &begin, &end)) {
+                continue;
+            }
+            for (uint32_t p = begin; p < end; p++) {
+                uint32_t d = index->postings[p];
+                if (index->hits[d] == 0 && index->paddedHits[d] == 0) {
+                    index->touched[touchedCount++] = d;
+                }
+                index->paddedHits[d]++;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < touchedCount; i++) {
+        uint32_t d = index->touched[i];
+        if (KimiRunA11yDocumentField(d) & fields) {
+            if (queryTrigrams > 0 && index->hits[d] == queryTrigrams) {
+                KimiRunA11yConsiderSubstring(index, &foundCount, d, normalized, queryLength);
+            }
+            if (index->paddedHits[d] > 0) {
+                uint32_t shared = index->paddedHits[d];
+                float similarity = (float)shared /
+                    (float)(paddedTrigrams + index->documents[d].trigrams - shared);
+                if (similarity >= KIMIRUN_A11Y_SEARCH_FUZZY_THRESHOLD) {
+                    KimiRunA11yConsider(index, &foundCount, d, KimiRunA11yMatchFuzzy, 0.79f * similarity);
+                }
+            }
+        }
+        index->hits[d] = 0;
+        index->paddedHits[d] = 0;
+    }
+    free(normalized);
+    free(window);
+
+    KimiRunA11yMatch *matches = malloc((size_t)(foundCount ? foundCount : 1) * sizeof(*matches));
+    if (!matches) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < foundCount; i++) {
+        matches[i] = index->best[index->found[i]];
+    }
+    qsort(matches, foundCount, sizeof(*matches), KimiRunA11yCompareMatches);
+    if (out && capacity > 0) {
+        memcpy(out, matches, (size_t)(foundCount < capacity ? foundCount : capacity) * sizeof(*out));
+    }
+    free(matches);
+    return foundCount;
+}
@@ -0,0 +1,83 @@
+//
+//  KimiRunA11ySearch.h
+//  KimiRun - Label / Identifier Search Index
+//
+//  Portable C (no Foundation). Built once per collection of interactive
+//  elements over each element's label and identifier. Strings are
+//  normalized (ASCII case folded, whitespace runs collapsed to one space,
+//  ends trimmed; callers fold Unicode case and diacritics beforehand) and
+//  indexed two ways:
+//    exact    sorted string hashes, binary searched
+//    trigram  posting lists of the padded 3-byte windows of each string,
+//             used to find substring candidates (every trigram of the
+//             query present) and fuzzy candidates (trigram similarity)
+//  Queries reuse scratch space inside the index; callers serialize access.
+//
+
+#ifndef KIMIRUN_A11Y_SEARCH_H
+#define KIMIRUN_A11Y_SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fuzzy matches need at least this trigram similarity (shared / union).
+#define KIMIRUN_A11Y_SEARCH_FUZZY_THRESHOLD 0.3f
+
+enum {
+    KimiRunA11ySearchLabel = 1u << 0,
+    KimiRunA11ySearchIdentifier = 1u << 1
+};
+
+typedef enum {
+    KimiRunA11yMatchExact = 0,
+    KimiRunA11yMatchPrefix,
+    KimiRunA11yMatchSubstring,
+    KimiRunA11yMatchFuzzy
+} KimiRunA11yMatchKind;
+
+typedef struct {
+    uint32_t element;
+    uint32_t field;                // KimiRunA11ySearchLabel or ...Identifier
+    KimiRunA11yMatchKind kind;
+    // exact 1.0; prefix 0.9-0.99 and substring 0.8-0.89 (longer share of
+    // the string ranks higher); fuzzy 0.79 * similarity
+    float score;
+} KimiRunA11yMatch;
+
+typedef struct KimiRunA11ySearch KimiRunA11ySearch;
+
+/**
+ * Index count elements. labels / identifiers may be NULL, as may any
+ * entry (treated as ""). Strings are copied. NULL on allocation failure.
+ */
+KimiRunA11ySearch *KimiRunA11ySearchCreate(const char *const *labels,
+                                           const char *const *identifiers,
+                                           uint32_t count);
+void KimiRunA11ySearchDestroy(KimiRunA11ySearch *index);
+
+/**
+ * Elements whose fields (a KimiRunA11ySearch* mask) match query, best
+ * first, one match per element (its best field). Without fuzzy only
+ * exact, prefix and substring matches are returned. Writes up to capacity
+ * matches and returns how many there were in total.
+ */
+uint32_t KimiRunA11ySearchFind(KimiRunA11ySearch *index,
+                               const char *query,
+                               uint32_t fields,
+                               bool fuzzy,
+                               KimiRunA11yMatch *out,
+                               uint32_t capacity);
+
+/** Normalize into out (NUL-terminated, at most strlen(text) + 1 bytes). */
+size_t KimiRunA11ySearchNormalize(const char *text, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,271 @@
+//
+//  KimiRunA11ySnapshot.c
+//  KimiRun - Versioned Accessibility Snapshot Store
+//
+
+#include "KimiRunA11ySnapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t sequence;             // 0 == empty slot
+    KimiRunA11yEntry *entries;
+    uint32_t count;
+} KimiRunA11ySnapshot;
+
+struct KimiRunA11yStore {
+    uint32_t history;
+    uint32_t newest;               // slot of the latest snapshot
+    uint64_t sequence;
+    KimiRunA11ySnapshot *snapshots;
+};
+
+// Open-addressing key -> position table sized for a load factor <= 0.5.
+typedef struct {
+    uint64_t *keys;
+    uint32_t *positions;           // UINT32_MAX == empty
+    uint32_t mask;
+} KimiRunA11yTable;
+
+uint64_t KimiRunA11yHash(uint64_t seed, const void *bytes, size_t length) {
+    const uint8_t *p = (const uint8_t *)bytes;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t KimiRunA11yHashU64(uint64_t seed, uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+    return KimiRunA11yHash(seed, bytes, sizeof(bytes));
+}
+
+static uint32_t KimiRunA11ySlot(uint64_t key, uint32_t mask) {
+    // Keys are already hashes; fold the high bits in for small tables.
+    return (uint32_t)(key ^ (key >> 32)) & mask;
+}
+
+static bool KimiRunA11yTableInit(KimiRunA11yTable *table, uint32_t count) {
+    uint32_t size = 16;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+    table->mask = size - 1;
+    table->keys = malloc((size_t)size * sizeof(*table->keys));
+    table->positions = malloc((size_t)size * sizeof(*table->positions));
+    if (!table->keys || !table->positions) {
+        free(table->keys);
+        free(table->positions);
+        return false;
+    }
+    memset(table->positions, 0xff, (size_t)size * sizeof(*table->positions));
+    return true;
+}
+
+static void KimiRunA11yTableFree(KimiRunA11yTable *table) {
+    free(table->keys);
+    free(table->positions);
+}
+
+// Returns the slot holding key, or the empty slot where it belongs.
+static uint32_t KimiRunA11yTableFind(const KimiRunA11yTable *table, uint64_t key) {
+    uint32_t slot = KimiRunA11ySlot(key, table->mask);
+    while (table->positions[slot] != UINT32_MAX && table->keys[slot] != key) {
+        slot = (slot + 1) & table->mask;
+    }
+    return slot;
+}
+
+KimiRunA11yStore *KimiRunA11yStoreCreate(uint32_t history) {
+    KimiRunA11yStore *store = calloc(1, sizeof(*store));
+    if (!store) {
+        return NULL;
+    }
+    store->history = history ? history : KIMIRUN_A11Y_DEFAULT_HISTORY;
+    store->snapshots = calloc(store->history, sizeof(*store->snapshots));
+    if (!store->snapshots) {
+        free(store);
+        return NULL;
+    }
+    return store;
+}
+
+void KimiRunA11yStoreDestroy(KimiRunA11yStore *store) {
+    if (!store) {
+        return;
+    }
+    for (uint32_t i = 0; i < store->history; i++) {
+        free(store->snapshots[i].entries);
+    }
+    free(store->snapshots);
+    free(store);
+}
+
+static bool KimiRunA11yMakeKeysUnique(KimiRunA11yEntry *entries, uint32_t count) {
+    KimiRunA11yTable table;
+    if (!KimiRunA11yTableInit(&table, count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key = entries[i].key;
+        for (uint64_t repeat = 1;; repeat++) {
+            uint32_t slot = KimiRunA11yTableFind(&table, key);
+            if (table.positions[slot] == UINT32_MAX) {
+                table.keys[slot] = key;
+                table.positions[slot] = i;
+                break;
+            }
+            key = KimiRunA11yHashU64(entries[i].key, repeat);
+        }
+        entries[i].key = key;
+    }
+    KimiRunA11yTableFree(&table);
+    return true;
+}
+
+uint64_t KimiRunA11yStoreCommit(KimiRunA11yStore *store,
+                                KimiRunA11yEntry *entries,
+                                uint32_t count,
+                                bool *changed) {
+    if (changed) {
+        *changed = false;
+    }
+    if (!store || (!entries && count > 0)) {
+        return 0;
+    }
+    if (!KimiRunA11yMakeKeysUnique(entries, count)) {
+        return 0;
+    }
+
+    KimiRunA11ySnapshot *latest = &store->snapshots[store->newest];
+    if (latest->sequence != 0 && latest->count == count &&
+        (count == 0 || memcmp(latest->entries, entries, (size_t)count * sizeof(*entries)) == 0)) {
+        return latest->sequence;
+    }
+
+    KimiRunA11yEntry *copy = malloc((size_t)(count ? count : 1) * sizeof(*copy));
+    if (!copy) {
+        return 0;
+    }
+    if (count > 0) {
+        memcpy(copy, entries, (size_t)count * sizeof(*copy));
+    }
+    uint32_t slot = (store->sequence == 0) ? 0 : (store->newest + 1) % store->history;
+    KimiRunA11ySnapshot *snapshot = &store->snapshots[slot];
+    free(snapshot->entries);
+    snapshot->entries = copy;
+    snapshot->count = count;
+    snapshot->sequence = ++store->sequence;
+    store->newest = slot;
+    if (changed) {
+        *changed = true;
+    }
+    return snapshot->sequence;
+}
+
+uint64_t KimiRunA11yStoreSequence(const KimiRunA11yStore *store) {
+    return store ? store->sequence : 0;
+}
+
+const KimiRunA11yEntry *KimiRunA11yStoreLatest(const KimiRunA11yStore *store, uint32_t *count) {
+    if (!store || store->sequence == 0) {
+        if (count) {
+            *count = 0;
+        }
+        return NULL;
+    }
+    const KimiRunA11ySnapshot *latest = &store->snapshots[store->newest];
+    if (count) {
+        *count = latest->count;
+    }
+    return latest->entries;
+}
+
+void KimiRunA11yDeltaFree(KimiRunA11yDelta *delta) {
+    if (!delta) {
+        return;
+    }
+    free(delta->added);
+    free(delta->changed);
+    free(delta->removed);
+    memset(delta, 0, sizeof(*delta));
+}
+
+bool KimiRunA11yStoreDiff(const KimiRunA11yStore *store, uint64_t since, KimiRunA11yDelta *out) {
+    if (!out) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!store) {
+        return false;
+    }
+    out->sequence = store->sequence;
+    out->since = since;
+    if (since == store->sequence && since != 0) {
+        return true;
+    }
+
+    const KimiRunA11ySnapshot *old = NULL;
+    for (uint32_t i = 0; i < store->history; i++) {
+        if (store->snapshots[i].sequence == since && since != 0) {
+            old = &store->snapshots[i];
+            break;
+        }
+    }
+    if (!old || store->sequence == 0) {
+        out->full = true;
+        return true;
+    }
+    const KimiRunA11ySnapshot *latest = &store->snapshots[store->newest];
+
+    KimiRunA11yTable table;
+    if (!KimiRunA11yTableInit(&table, old->count)) {
+        return false;
+    }
+    uint8_t *seen = calloc(old->count ? old->count : 1, 1);
+    out->added = malloc((size_t)(latest->count ? latest->count : 1) * sizeof(*out->added));
+    out->changed = malloc((size_t)(latest->count ? latest->count : 1) * sizeof(*out->changed));
+    out->removed = malloc((size_t)(old->count ? old->count : 1) * sizeof(*out->removed));
+    if (!seen || !out->added || !out->changed || !out->removed) {
+        free(seen);
+        KimiRunA11yTableFree(&table);
+        KimiRunA11yDeltaFree(out);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < old->count; i++) {
+        uint32_t slot = KimiRunA11yTableFind(&table, old->entries[i].key);
+        table.keys[slot] = old->entries[i].key;
+        table.positions[slot] = i;
+    }
+    for (uint32_t i = 0; i < latest->count; i++) {
+        const KimiRunA11yEntry *entry = &latest->entries[i];
+        uint32_t slot = KimiRunA11yTableFind(&table, entry->key);
+        uint32_t position = table.positions[slot];
+        if (position == UINT32_MAX) {
+            out->added[out->addedCount++] = i;
+            continue;
+        }
+        seen[position] = 1;
+        if (old->entries[position].hash != entry->hash) {
+            out->changed[out->changedCount++] = i;
+        }
+        if (position != i) {
+            out->orderChanged = true;
+        }
+    }
+    for (uint32_t i = 0; i < old->count; i++) {
+        if (!seen[i]) {
+            out->removed[out->removedCount++] = old->entries[i].key;
+        }
+    }
+    free(seen);
+    KimiRunA11yTableFree(&table);
+    return true;
+}
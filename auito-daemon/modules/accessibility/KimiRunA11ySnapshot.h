@@ -0,0 +1,86 @@
+//
+//  KimiRunA11ySnapshot.h
+//  KimiRun - Versioned Accessibility Snapshot Store
+//
+//  Portable C (no Foundation). Each collection of interactive elements is
+//  committed as an ordered list of (key, hash) entries: key is a stable
+//  per-element identity, hash covers the element's reported fields. A
+//  commit that differs from the latest snapshot gets the next sequence
+//  number; an identical one keeps the current number. The store keeps the
+//  last few snapshots so a client holding any of them can be sent only the
+//  elements that were added, changed or removed since.
+//  The store does no locking; callers serialize access.
+//
+
+#ifndef KIMIRUN_A11Y_SNAPSHOT_H
+#define KIMIRUN_A11Y_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_A11Y_DEFAULT_HISTORY 8
+
+typedef struct {
+    uint64_t key;
+    uint64_t hash;
+} KimiRunA11yEntry;
+
+typedef struct KimiRunA11yStore KimiRunA11yStore;
+
+typedef struct {
+    uint64_t sequence;             // latest snapshot
+    uint64_t since;
+    bool full;                     // since is not held: send the whole list
+    bool orderChanged;             // a surviving element changed position
+    uint32_t addedCount;
+    uint32_t *added;               // indexes into the latest snapshot
+    uint32_t changedCount;
+    uint32_t *changed;             // indexes into the latest snapshot
+    uint32_t removedCount;
+    uint64_t *removed;             // keys
+} KimiRunA11yDelta;
+
+/** history 0 == KIMIRUN_A11Y_DEFAULT_HISTORY. NULL on allocation failure. */
+KimiRunA11yStore *KimiRunA11yStoreCreate(uint32_t history);
+void KimiRunA11yStoreDestroy(KimiRunA11yStore *store);
+
+/**
+ * Commit a collection in display order. Repeated keys are made unique in
+ * place (the nth repeat is mixed with n), so callers should read keys back
+ * from entries afterwards. Returns the snapshot's sequence number, or 0 on
+ * allocation failure; changed reports whether it is a new snapshot.
+ */
+uint64_t KimiRunA11yStoreCommit(KimiRunA11yStore *store,
+                                KimiRunA11yEntry *entries,
+                                uint32_t count,
+                                bool *changed);
+
+/** Latest sequence number (0 before the first commit). */
+uint64_t KimiRunA11yStoreSequence(const KimiRunA11yStore *store);
+
+/** Latest snapshot's entries (owned by the store) and count. */
+const KimiRunA11yEntry *KimiRunA11yStoreLatest(const KimiRunA11yStore *store, uint32_t *count);
+
+/**
+ * Delta from snapshot since to the latest. since == latest gives an empty
+ * delta; an unknown since gives full = true. Returns false on allocation
+ * failure. Release with KimiRunA11yDeltaFree.
+ */
+bool KimiRunA11yStoreDiff(const KimiRunA11yStore *store, uint64_t since, KimiRunA11yDelta *out);
+void KimiRunA11yDeltaFree(KimiRunA11yDelta *delta);
+
+/** 64-bit FNV-1a, chainable through seed (use KIMIRUN_A11Y_HASH_SEED first). */
+#define KIMIRUN_A11Y_HASH_SEED 0xcbf29ce484222325ULL
+uint64_t KimiRunA11yHash(uint64_t seed, const void *bytes, size_t length);
+uint64_t KimiRunA11yHashU64(uint64_t seed, uint64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
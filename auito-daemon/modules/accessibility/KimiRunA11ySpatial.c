@@ -0,0 +1,415 @@
+//
+//  KimiRunA11ySpatial.c
+//  KimiRun - Spatial Index over Accessibility Element Rects
+//
+
+#include "KimiRunA11ySpatial.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct KimiRunA11ySpatial {
+    KimiRunA11yRect *rects;
+    uint32_t count;
+    double originX;
+    double originY;
+    double cellSize;
+    uint32_t columns;
+    uint32_t rows;
+    uint32_t *cellStart;           // columns * rows + 1 offsets into cellItems
+    uint32_t *cellItems;
+    uint32_t *scratch;             // count entries, query results before sorting
+    uint32_t *stamps;              // per element: last query generation that saw it
+    uint32_t generation;
+};
+
+static bool KimiRunA11ySpatialValid(const KimiRunA11yRect *rect) {
+    return isfinite(rect->x) && isfinite(rect->y) &&
+           isfinite(rect->width) && isfinite(rect->height) &&
+           rect->width > 0.0f && rect->height > 0.0f;
+}
+
+// Cells [first, last] covering [lo, hi] along one axis, clamped to the grid.
+static void KimiRunA11ySpatialSpan(double lo, double hi, double origin, double cellSize, uint32_t limit,
+                                   uint32_t *first, uint32_t *last) {
+    double a = floor((lo - origin) / cellSize);
+    double b = floor((hi - origin) / cellSize);
+    double max = (double)(limit - 1);
+    *first = (uint32_t)(a < 0.0 ? 0.0 : (a > max ? max : a));
+    *last = (uint32_t)(b < 0.0 ? 0.0 : (b > max ? max : b));
+}
+
+static void KimiRunA11ySpatialRectCells(const KimiRunA11ySpatial *index, const KimiRunA11yRect *rect,
+                                        uint32_t *c0, uint32_t *c1, uint32_t *r0, uint32_t *r1) {
+    KimiRunA11ySpatialSpan(rect->x, (double)rect->x + rect->width, index->originX, index->cellSize,
+                           index->columns, c0, c1);
+    KimiRunA11ySpatialSpan(rect->y, (double)rect->y + rect->height, index->originY, index->cellSize,
+                           index->rows, r0, r1);
+}
+
+KimiRunA11ySpatial *KimiRunA11ySpatialCreate(const KimiRunA11yRect *rects, uint32_t count, float cellSize) {
+    if (!rects && count > 0) {
+        return NULL;
+    }
+    KimiRunA11ySpatial *index = calloc(1, sizeof(*index));
+    if (!index) {
+        return NULL;
+    }
+    index->count = count;
+    index->rects = malloc((size_t)(count ? count : 1) * sizeof(*index->rects));
+    index->scratch = malloc((size_t)(count ? count : 1) * sizeof(*index->scratch));
+    index->stamps = calloc(count ? count : 1, sizeof(*index->stamps));
+    if (!index->rects || !index->scratch || !index->stamps) {
+        KimiRunA11ySpatialDestroy(index);
+        return NULL;
+    }
+    if (count > 0) {
+        memcpy(index->rects, rects, (size_t)count * sizeof(*rects));
+    }
+
+    double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (uint32_t i = 0; i < count; i++) {
+        const KimiRunA11yRect *rect = &rects[i];
+        if (!KimiRunA11ySpatialValid(rect)) {
+            continue;
+        }
+        minX = fmin(minX, rect->x);
+        minY = fmin(minY, rect->y);
+        maxX = fmax(maxX, (double)rect->x + rect->width);
+        maxY = fmax(maxY, (double)rect->y + rect->height);
+    }
+    if (minX > maxX) {
+        minX = minY = 0.0;
+        maxX = maxY = 1.0;
+    }
+
+    double size = cellSize > 0.0f ? cellSize : KIMIRUN_A11Y_SPATIAL_CELL;
+    double columns = fmax(1.0, ceil((maxX - minX) / size));
+    double rows = fmax(1.0, ceil((maxY - minY) / size));
+    while (columns * rows > KIMIRUN_A11Y_SPATIAL_MAX_CELLS) {
+        size *= 2.0;
+        columns = fmax(1.0, ceil((maxX - minX) / size));
+        rows = fmax(1.0, ceil((maxY - minY) / size));
+    }
+    index->originX = minX;
+    index->originY = minY;
+    index->cellSize = size;
+    index->columns = (uint32_t)columns;
+    index->rows = (uint32_t)rows;
+
+    uint32_t cells = index->columns * index->rows;
+    index->cellStart = calloc((size_t)cells + 1, sizeof(*index->cellStart));
+    if (!index->cellStart) {
+        KimiRunA11ySpatialDestroy(index);
+        return NULL;
+    }
+
+    // Count per cell, prefix-sum into offsets, then fill.
+    size_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!KimiRunA11ySpatialValid(&rects[i])) {
+            continue;
+        }
+        uint32_t c0, c1, r0, r1;
+        KimiRunA11ySpatialRectCells(index, &rects[i], &c0, &c1, &r0, &r1);
+        for (uint32_t r = r0; r <= r1; r++) {
+            for (uint32_t c = c0; c <= c1; c++) {
+                index->cellStart[r * index->columns + c + 1]++;
+            }
+        }
+        total += (size_t)(c1 - c0 + 1) * (r1 - r0 + 1);
+    }
+    if (total > UINT32_MAX) {
+        KimiRunA11ySpatialDestroy(index);
+        return NULL;
+    }
+    for (uint32_t cell = 0; cell < cells; cell++) {
+        index->cellStart[cell + 1] += index->cellStart[cell];
+    }
+    index->cellItems = malloc((total ? total : 1) * sizeof(*index->cellItems));
+    uint32_t *cursor = malloc((size_t)cells * sizeof(*cursor));
+    if (!index->cellItems || !cursor) {
+        free(cursor);
+        KimiRunA11ySpatialDestroy(index);
+        return NULL;
+    }
+    memcpy(cursor, index->cellStart, (size_t)cells * sizeof(*cursor));
+    for (uint32_t i = 0; i < count; i++) {
+        if (!KimiRunA11ySpatialValid(&rects[i])) {
+            continue;
+        }
+        uint32_t c0, c1, r0, r1;
+        KimiRunA11ySpatialRectCells(index, &rects[i], &c0, &c1, &r0, &r1);
+        for (uint32_t r = r0; r <= r1; r++) {
+            for (uint32_t c = c0; c <= c1; c++) {
+                index->cellItems[cursor[r * index->columns + c]++] = i;
+            }
+        }
+    }
+    free(cursor);
+    return index;
+}
+
+void KimiRunA11ySpatialDestroy(KimiRunA11ySpatial *index) {
+    if (!index) {
+        return;
+    }
+    free(index->rects);
+    free(index->scratch);
+    free(index->stamps);
+    free(index->cellStart);
+    free(index->cellItems);
+    free(index);
+}
+
+uint32_t KimiRunA11ySpatialCount(const KimiRunA11ySpatial *index) {
+    return index ? index->count : 0;
+}
+
+// Starts a query that must see each element once across several cells.
+static uint32_t KimiRunA11ySpatialNextGeneration(KimiRunA11ySpatial *index) {
+    if (++index->generation == 0) {
+        memset(index->stamps, 0, (size_t)(index->count ? index->count : 1) * sizeof(*index->stamps));
+        index->generation = 1;
+    }
+    return index->generation;
+}
+
+static double KimiRunA11ySpatialArea(const KimiRunA11yRect *rect) {
+    return (double)rect->width * rect->height;
+}
+
+static bool KimiRunA11ySpatialContains(const KimiRunA11yRect *rect, double x, double y) {
+    return x >= rect->x && x < (double)rect->x + rect->width &&
+           y >= rect->y && y < (double)rect->y + rect->height;
+}
+
+static int KimiRunA11ySpatialCompareElements(const void *a, const void *b) {
+    uint32_t left = *(const uint32_t *)a;
+    uint32_t right = *(const uint32_t *)b;
+    return (left > right) - (left < right);
+}
+
+static uint32_t KimiRunA11ySpatialEmit(const uint32_t *matches, uint32_t matched, uint32_t *out, uint32_t capacity) {
+    if (out && capacity > 0) {
+        memcpy(out, matches, (size_t)(matched < capacity ? matched : capacity) * sizeof(*out));
+    }
+    return matched;
+}
+
+uint32_t KimiRunA11ySpatialAtPoint(KimiRunA11ySpatial *index,
+                                   float x, float y,
+                                   uint32_t requiredFlags,
+                                   uint32_t *out, uint32_t capacity) {
+    if (!index || !isfinite(x) || !isfinite(y)) {
+        return 0;
+    }
+    double col = floor((x - index->originX) / index->cellSize);
+    double row = floor((y - index->originY) / index->cellSize);
+    if (col < 0.0 || row < 0.0 || col >= index->columns || row >= index->rows) {
+        return 0;
+    }
+    uint32_t cell = (uint32_t)row * index->columns + (uint32_t)col;
+    uint32_t matched = 0;
+    for (uint32_t k = index->cellStart[cell]; k < index->cellStart[cell + 1]; k++) {
+        uint32_t element = index->cellItems[k];
+        const KimiRunA11yRect *rect = &index->rects[element];
+        if ((rect->flags & requiredFlags) != requiredFlags || !KimiRunA11ySpatialContains(rect, x, y)) {
+            continue;
+        }
+        // Insertion sort by area: a point sits in a handful of nested rects.
+        double area = KimiRunA11ySpatialArea(rect);
+        uint32_t position = matched++;
+        while (position > 0 && KimiRunA11ySpatialArea(&index->rects[index->scratch[position - 1]]) > area) {
+            index->scratch[position] = index->scratch[position - 1];
+            position--;
+        }
+        index->scratch[position] = element;
+    }
+    return KimiRunA11ySpatialEmit(index->scratch, matched, out, capacity);
+}
+
+static bool KimiRunA11ySpatialMatchesRect(const KimiRunA11yRect *rect,
+                                          double x0, double y0, double x1, double y1,
+                                          bool contained) {
+    double rx1 = (double)rect->x + rect->width;
+    double ry1 = (double)rect->y + rect->height;
+    if (contained) {
+        return rect->x >= x0 && rx1 <= x1 && rect->y >= y0 && ry1 <= y1;
+    }
+    return rect->x < x1 && x0 < rx1 && rect->y < y1 && y0 < ry1;
+}
+
+uint32_t KimiRunA11ySpatialInRect(KimiRunA11ySpatial *index,
+                                  float x, float y, float width, float height,
+                                  bool contained,
+                                  uint32_t requiredFlags,
+                                  uint32_t *out, uint32_t capacity) {
+    if (!index || !isfinite(x) || !isfinite(y) || !isfinite(width) || !isfinite(height)) {
+        return 0;
+    }
+    double x0 = width < 0.0f ? (double)x + width : x;
+    double y0 = height < 0.0f ? (double)y + height : y;
+    double x1 = x0 + fabs((double)width);
+    double y1 = y0 + fabs((double)height);
+    if (x1 <= x0 || y1 <= y0) {
+        return 0;
+    }
+
+    uint32_t matched = 0;
+    uint32_t c0, c1, r0, r1;
+    KimiRunA11ySpatialSpan(x0, x1, index->originX, index->cellSize, index->columns, &c0, &c1);
+    KimiRunA11ySpatialSpan(y0, y1, index->originY, index->cellSize, index->rows, &r0, &r1);
+    size_t cells = (size_t)(c1 - c0 + 1) * (r1 - r0 + 1);
+    if (cells >= index->count) {
+        // A region covering most of the grid: a straight scan is cheaper.
+        for (uint32_t i = 0; i < index->count; i++) {
+            const KimiRunA11yRect *rect = &index->rects[i];
+            if (KimiRunA11ySpatialValid(rect) && (rect->flags & requiredFlags) == requiredFlags &&
+                KimiRunA11ySpatialMatchesRect(rect, x0, y0, x1, y1, contained)) {
+                index->scratch[matched++] = i;
+            }
+        }
+        return KimiRunA11ySpatialEmit(index->scratch, matched, out, capacity);
+    }
+
+    uint32_t generation = KimiRunA11ySpatialNextGeneration(index);
+    for (uint32_t r = r0; r <= r1; r++) {
+        for (uint32_t c = c0; c <= c1; c++) {
+            uint32_t cell = r * index->columns + c;
+            for (uint32_t k = index->cellStart[cell]; k < index->cellStart[cell + 1]; k++) {
+                uint32_t element = index->cellItems[k];
+                if (index->stamps[element] == generation) {
+                    continue;
+                }
+                index->stamps[element] = generation;
+                const KimiRunA11yRect *rect = &index->rects[element];
+                if ((rect->flags & requiredFlags) == requiredFlags &&
+                    KimiRunA11ySpatialMatchesRect(rect, x0, y0, x1, y1, contained)) {
+                    index->scratch[matched++] = element;
+                }
+            }
+        }
+    }
+    qsort(index->scratch, matched, sizeof(*index->scratch), KimiRunA11ySpatialCompareElements);
+    return KimiRunA11ySpatialEmit(index->scratch, matched, out, capacity);
+}
+
+static double KimiRunA11ySpatialDistance2(const KimiRunA11yRect *rect, double x, double y) {
+    double dx = fmax(fmax(rect->x - x, 0.0), x - ((double)rect->x + rect->width));
+    double dy = fmax(fmax(rect->y - y, 0.0), y - ((double)rect->y + rect->height));
+    return dx * dx + dy * dy;
+}
+
+typedef struct {
+    double x;
+    double y;
+    uint32_t requiredFlags;
+    uint32_t generation;
+    bool found;
+    uint32_t element;
+    double distance2;
+    double area;
+} KimiRunA11ySpatialNearestState;
+
+static void KimiRunA11ySpatialVisitCell(KimiRunA11ySpatial *index, uint32_t column, uint32_t row,
+                                        KimiRunA11ySpatialNearestState *state) {
+    uint32_t cell = row * index->columns + column;
+    for (uint32_t k = index->cellStart[cell]; k < index->cellStart[cell + 1]; k++) {
+        uint32_t element = index->cellItems[k];
+        if (index->stamps[element] == state->generation) {
+            continue;
+        }
+        index->stamps[element] = state->generation;
+        const KimiRunA11yRect *rect = &index->rects[element];
+        if ((rect->flags & state->requiredFlags) != state->requiredFlags) {
+            continue;
+        }
+        double distance2 = KimiRunA11ySpatialDistance2(rect, state->x, state->y);
+        double area = KimiRunA11ySpatialArea(rect);
+        if (!state->found || distance2 < state->distance2 ||
+            (distance2 == state->distance2 &&
+             (area < state->area || (area == state->area && element < state->element)))) {
+            state->found = true;
+            state->element = element;
+            state->distance2 = distance2;
+            state->area = area;
+        }
+    }
+}
+
+bool KimiRunA11ySpatialNearest(KimiRunA11ySpatial *index,
+                               float x, float y,
+                               float maxDistance,
+                               uint32_t requiredFlags,
+                               uint32_t *element, float *distance) {
+    if (!index || index->count == 0 || !isfinite(x) || !isfinite(y)) {
+        return false;
+    }
+    KimiRunA11ySpatialNearestState state = {
+        .x = x,
+        .y = y,
+        .requiredFlags = requiredFlags,
+        .generation = KimiRunA11ySpatialNextGeneration(index),
+    };
+    double limit2 = maxDistance < 0.0f ? INFINITY : (double)maxDistance * maxDistance;
+
+    // Search outward in square rings from the grid point nearest (x, y).
+    // Any cell outside the searched square is at least as far from (x, y)
+    // as (x, y) is from the clamped point plus the clamped point's distance
+    // to the square's open sides.
+    double gridX1 = index->originX + index->columns * index->cellSize;
+    double gridY1 = index->originY + index->rows * index->cellSize;
+    double px = fmin(fmax(x, index->originX), gridX1);
+    double py = fmin(fmax(y, index->originY), gridY1);
+    double outside2 = (x - px) * (x - px) + (y - py) * (y - py);
+    int64_t cx = (int64_t)fmin(floor((px - index->originX) / index->cellSize), index->columns - 1.0);
+    int64_t cy = (int64_t)fmin(floor((py - index->originY) / index->cellSize), index->rows - 1.0);
+    int64_t lastColumn = (int64_t)index->columns - 1;
+    int64_t lastRow = (int64_t)index->rows - 1;
+
+    for (int64_t ring = 0;; ring++) {
+        int64_t x0 = cx - ring, x1 = cx + ring, y0 = cy - ring, y1 = cy + ring;
+        for (int64_t c = x0 < 0 ? 0 : x0; c <= (x1 > lastColumn ? lastColumn : x1); c++) {
+            if (y0 >= 0) {
+                KimiRunA11ySpatialVisitCell(index, (uint32_t)c, (uint32_t)y0, &state);
+            }
+            if (ring > 0 && y1 <= lastRow) {
+                KimiRunA11ySpatialVisitCell(index, (uint32_t)c, (uint32_t)y1, &state);
+            }
+        }
+        for (int64_t r = (y0 + 1 < 0 ? 0 : y0 + 1); r <= (y1 - 1 > lastRow ? lastRow : y1 - 1); r++) {
+            if (x0 >= 0) {
+                KimiRunA11ySpatialVisitCell(index, (uint32_t)x0, (uint32_t)r, &state);
+            }
+            if (ring > 0 && x1 <= lastColumn) {
+                KimiRunA11ySpatialVisitCell(index, (uint32_t)x1, (uint32_t)r, &state);
+            }
+        }
+
+        double open = INFINITY;
+        if (x0 > 0) open = fmin(open, px - (index->originX + x0 * index->cellSize));
+        if (x1 < lastColumn) open = fmin(open, index->originX + (x1 + 1) * index->cellSize - px);
+        if (y0 > 0) open = fmin(open, py - (index->originY + y0 * index->cellSize));
+        if (y1 < lastRow) open = fmin(open, index->originY + (y1 + 1) * index->cellSize - py);
+        if (open == INFINITY) {
+            break;
+        }
+        double bound2 = outside2 + open * open;
+        if ((state.found && state.distance2 < bound2) || bound2 > limit2) {
+            break;
+        }
+    }
+
+    if (!state.found || state.distance2 > limit2) {
+        return false;
+    }
+    if (element) {
+        *element = state.element;
+    }
+    if (distance) {
+        *distance = (float)sqrt(state.distance2);
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+//
+//  KimiRunA11ySpatial.h
+//  KimiRun - Spatial Index over Accessibility Element Rects
+//
+//  Portable C (no Foundation). A uniform grid built once per collection of
+//  interactive elements. Each cell lists the elements whose rect overlaps
+//  it (cell lists are packed into one array), so point, region and
+//  nearest-element queries touch only the cells around the query instead
+//  of every element. Element numbers are the positions passed to Create.
+//  Queries reuse scratch space inside the index; callers serialize access.
+//
+
+#ifndef KIMIRUN_A11Y_SPATIAL_H
+#define KIMIRUN_A11Y_SPATIAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_A11Y_SPATIAL_CELL 64.0f
+#define KIMIRUN_A11Y_SPATIAL_MAX_CELLS 4096
+
+enum {
+    KimiRunA11ySpatialActionable = 1u << 0
+};
+
+// Screen rect plus caller-defined flag bits matched by queries.
+// Empty or non-finite rects are kept out of the index.
+typedef struct {
+    float x;
+    float y;
+    float width;
+    float height;
+    uint32_t flags;
+} KimiRunA11yRect;
+
+typedef struct KimiRunA11ySpatial KimiRunA11ySpatial;
+
+/**
+ * Build an index over rects (copied). cellSize <= 0 uses
+ * KIMIRUN_A11Y_SPATIAL_CELL; cells are enlarged when the rects span more
+ * than KIMIRUN_A11Y_SPATIAL_MAX_CELLS. NULL on allocation failure.
+ */
+KimiRunA11ySpatial *KimiRunA11ySpatialCreate(const KimiRunA11yRect *rects, uint32_t count, float cellSize);
+void KimiRunA11ySpatialDestroy(KimiRunA11ySpatial *index);
+
+uint32_t KimiRunA11ySpatialCount(const KimiRunA11ySpatial *index);
+
+/**
+ * Elements containing (x, y) whose flags include requiredFlags, smallest
+ * area first (the innermost element leads). Writes up to capacity element
+ * numbers and returns how many matched in total.
+ */
+uint32_t KimiRunA11ySpatialAtPoint(KimiRunA11ySpatial *index,
+                                   float x, float y,
+                                   uint32_t requiredFlags,
+                                   uint32_t *out, uint32_t capacity);
+
+/**
+ * Elements overlapping the rect (or entirely inside it when contained) in
+ * element order. Same out/capacity/return convention as AtPoint.
+ */
+uint32_t KimiRunA11ySpatialInRect(KimiRunA11ySpatial *index,
+                                  float x, float y, float width, float height,
+                                  bool contained,
+                                  uint32_t requiredFlags,
+                                  uint32_t *out, uint32_t capacity);
+
+/**
+ * Element with flags including requiredFlags whose rect is closest to
+ * (x, y), measured to the rect's edge (0 inside). Ties go to the smaller
+ * rect. maxDistance < 0 means unbounded. Returns false when nothing is
+ * within maxDistance.
+ */
+bool KimiRunA11ySpatialNearest(KimiRunA11ySpatial *index,
+                               float x, float y,
+                               float maxDistance,
+                               uint32_t requiredFlags,
+                               uint32_t *element, float *distance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
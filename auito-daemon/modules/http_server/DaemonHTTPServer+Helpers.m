@@ -1,4 +1,5 @@
 #import "DaemonHTTPServer.h"
+#import "../touch/TouchInjection.h"
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 #import <objc/runtime.h>
@@ -239,7 +240,7 @@
 - (NSString *)jsonResponse:(NSInteger)statusCode body:(NSString *)body {
     NSString *safeBody = body ?: @"";
     NSData *bodyData = [safeBody dataUsingEncoding:NSUTF8StringEncoding];
-    NSString *statusText = statusCode == 200 ? @"OK" : @"Not Found";
+    NSString *statusText = statusCode == 200 ? @"OK" : (statusCode == 202 ? @"Accepted" : @"Not Found");
     return [NSString stringWithFormat:
             @"HTTP/1.1 %ld %@\r\n"
             @"Content-Type: application/json\r\n"
@@ -291,6 +292,17 @@
     return [value floatValue];
 }
 
+// Coordinates honour an optional space=points|pixels|normalized parameter.
+- (CGPoint)touchPointFromQuery:(NSString *)query xKey:(NSString *)xKey yKey:(NSString *)yKey {
+    CGPoint point = CGPointMake([self floatValueFromQuery:query key:xKey],
+                                [self floatValueFromQuery:query key:yKey]);
+    NSString *space = [self stringValueFromQuery:query key:@"space"];
+    if (space.length == 0) {
+        return point;
+    }
+    return [KimiRunTouchInjection pointFromInput:point space:space];
+}
+
 - (NSString *)stringValueFromQuery:(NSString *)query key:(NSString *)key {
     NSString *pattern = [NSString stringWithFormat:@"%@=", key];
     NSRange keyRange = [query rangeOfString:pattern];
@@ -314,6 +326,27 @@
     return decoded.length ? decoded : plusReplaced;
 }
 
+// Every value of a repeated key, decoded like stringValueFromQuery:. Keys
+// are compared whole, so label= does not pick up rootLabel=.
+- (NSArray<NSString *> *)stringValuesFromQuery:(NSString *)query key:(NSString *)key {
+    NSRange queryRange = [query rangeOfString:@"?"];
+    if (queryRange.location != NSNotFound) {
+        query = [query substringFromIndex:queryRange.location + 1];
+    }
+    NSMutableArray<NSString *> *values = [NSMutableArray array];
+    NSString *prefix = [key stringByAppendingString:@"="];
+    for (NSString *pair in [query componentsSeparatedByString:@"&"]) {
+        if (![pair hasPrefix:prefix] || pair.length == prefix.length) {
+            continue;
+        }
+        NSString *plusReplaced = [[pair substringFromIndex:prefix.length] stringByReplacingOccurrencesOfString:@"+"
+                                                                                                    withString:@" "];
+        NSString *decoded = [plusReplaced stringByRemovingPercentEncoding];
+        [values addObject:decoded.length ? decoded : plusReplaced];
+    }
+    return values;
+}
+
 - (BOOL)boolValueFromQuery:(NSString *)query key:(NSString *)key defaultValue:(BOOL)defaultValue {
     NSString *value = [self stringValueFromQuery:query key:key];
     if (!value || value.length == 0) {
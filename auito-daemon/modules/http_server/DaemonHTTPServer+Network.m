@@ -1,4 +1,5 @@
 #import "DaemonHTTPServer.h"
+#import "../accessibility/AccessibilityTree.h"
 #import <Foundation/Foundation.h>
 #import <unistd.h>
 
@@ -64,6 +65,17 @@ static const NSUInteger kMobileSafariProxyPort = 8767;
 - (NSString *)proxyTouchResponseForPath:(NSString *)path
                                 timeout:(NSTimeInterval)timeout
                         resolvedPortOut:(NSUInteger *)resolvedPortOut {
+    NSData *data = [self proxyTouchDataForPath:path timeout:timeout resolvedPortOut:resolvedPortOut];
+    if (!data) {
+        return nil;
+    }
+    NSString *body = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    return body.length > 0 ? body : nil;
+}
+
+- (NSData *)proxyTouchDataForPath:(NSString *)path
+                          timeout:(NSTimeInterval)timeout
+                  resolvedPortOut:(NSUInteger *)resolvedPortOut {
     if (!path || path.length == 0) {
         return nil;
     }
@@ -80,15 +92,11 @@ static const NSUInteger kMobileSafariProxyPort = 8767;
                                (unsigned long)ports[i],
                                normalized];
         NSData *data = [self fetchURL:[NSURL URLWithString:urlString] timeout:timeout];
-        if (!data || data.length == 0) {
-            continue;
-        }
-        NSString *body = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
-        if (body.length > 0) {
+        if (data.length > 0) {
             if (resolvedPortOut) {
                 *resolvedPortOut = ports[i];
             }
-            return body;
+            return data;
         }
     }
 
@@ -99,10 +107,15 @@ static const NSUInteger kMobileSafariProxyPort = 8767;
     if (port == 0) {
         return @[];
     }
-    NSString *urlString = [NSString stringWithFormat:@"http://127.0.0.1:%lu/a11y/interactive?compact=1",
+    // msgpack is roughly a tenth of the row JSON; servers that predate
+    // ?format= ignore it and still answer with the JSON array.
+    NSString *urlString = [NSString stringWithFormat:@"http://127.0.0.1:%lu/a11y/interactive?format=msgpack",
                            (unsigned long)port];
     NSData *data = [self fetchURL:[NSURL URLWithString:urlString] timeout:0.6];
     if (!data) return @[];
+    if (((const uint8_t *)data.bytes)[0] != '[') {
+        return [AccessibilityTree interactiveElementsFromMsgPack:data] ?: @[];
+    }
     NSError *error = nil;
     id obj = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
     if (error || ![obj isKindOfClass:[NSArray class]]) {
@@ -1,11 +1,11 @@
 #import "DaemonHTTPServer.h"
 #import <Foundation/Foundation.h>
+#import "../prefs/KimiRunPrefs.h"
+#import "../touch/TouchInjection.h"
 
 static const NSUInteger kSpringBoardProxyPort = 8765;
 static const NSUInteger kPreferencesProxyPort = 8766;
 static const NSUInteger kMobileSafariProxyPort = 8767;
-static NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
-
 static uint64_t KimiRunFNV1aHash(const uint8_t *bytes, NSUInteger length) {
     if (!bytes || length == 0) {
         return 0;
@@ -118,54 +118,23 @@ static BOOL KimiRunProxyModeMatchesRequestedMethod(NSString *proxyMode, NSString
     return YES;
 }
 
-static BOOL KimiRunEnvBool(const char *key, BOOL defaultValue) {
-    if (!key) {
-        return defaultValue;
-    }
-    const char *value = getenv(key);
-    if (!value || value[0] == '\0') {
-        return defaultValue;
-    }
-    NSString *lower = [[[NSString stringWithUTF8String:value] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] lowercaseString];
-    if ([lower isEqualToString:@"1"] || [lower isEqualToString:@"true"] || [lower isEqualToString:@"yes"] || [lower isEqualToString:@"on"]) {
-        return YES;
-    }
-    if ([lower isEqualToString:@"0"] || [lower isEqualToString:@"false"] || [lower isEqualToString:@"no"] || [lower isEqualToString:@"off"]) {
-        return NO;
-    }
-    return defaultValue;
-}
-
-static BOOL KimiRunPrefBool(NSString *key, BOOL defaultValue) {
-    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
-        return defaultValue;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs objectForKey:key];
-    if (!value) {
-        return defaultValue;
-    }
-    return [prefs boolForKey:key];
-}
-
 static BOOL KimiRunStrictProxyFallbackToLocalEnabled(void) {
-    return KimiRunEnvBool("KIMIRUN_STRICT_PROXY_FALLBACK_LOCAL",
-                          KimiRunPrefBool(@"StrictProxyFallbackLocal", YES));
+    return KimiRunPrefsEnvBool("KIMIRUN_STRICT_PROXY_FALLBACK_LOCAL",
+                               KimiRunPrefsBool(@"StrictProxyFallbackLocal", YES));
 }
 
 static BOOL KimiRunStrictAllowDebugDigestFallback(void) {
-    return KimiRunEnvBool("KIMIRUN_STRICT_ALLOW_DEBUG_DIGEST_FALLBACK",
-                          KimiRunPrefBool(@"StrictAllowDebugDigestFallback", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_STRICT_ALLOW_DEBUG_DIGEST_FALLBACK",
+                               KimiRunPrefsBool(@"StrictAllowDebugDigestFallback", NO));
 }
 
 static NSString *KimiRunStrictUIDigestSource(void) {
-    const char *env = getenv("KIMIRUN_STRICT_UIDIGEST_SOURCE");
+    const char *env = KimiRunPrefsEnv("KIMIRUN_STRICT_UIDIGEST_SOURCE");
     NSString *raw = nil;
     if (env && env[0] != '\0') {
         raw = [NSString stringWithUTF8String:env];
     } else {
-        NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-        raw = [prefs stringForKey:@"StrictUIDigestSource"];
+        raw = KimiRunPrefsString(@"StrictUIDigestSource");
     }
     if (![raw isKindOfClass:[NSString class]] || raw.length == 0) {
         return @"a11y";
@@ -309,7 +278,10 @@ static NSString *KimiRunStrictUIDigestSource(void) {
 }
 
 - (BOOL)verifySpringBoardUIDeltaFromDigest:(NSString *)beforeDigest timeout:(NSTimeInterval)timeout {
-    return [self verifyUIDeltaForPort:kSpringBoardProxyPort fromDigest:beforeDigest timeout:timeout];
+    BOOL verified = [self verifyUIDeltaForPort:kSpringBoardProxyPort fromDigest:beforeDigest timeout:timeout];
+    // Local dispatch just happened in this process; feed the adaptive router.
+    [KimiRunTouchInjection noteLastGestureVerified:verified];
+    return verified;
 }
 
 - (id)strictProxyResponseForPath:(NSString *)path
@@ -2,66 +2,13 @@
 #import <Foundation/Foundation.h>
 #import "../touch/TouchInjection.h"
 #import "../touch/AXTouchInjection.h"
-
-static NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
-
-static BOOL KimiRunPrefBool(NSString *key, BOOL defaultValue) {
-    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
-        return defaultValue;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs objectForKey:key];
-    if (!value) {
-        return defaultValue;
-    }
-    return [prefs boolForKey:key];
-}
-
-static void KimiRunSetPrefBool(NSString *key, BOOL value) {
-    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
-        return;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    [prefs setBool:value forKey:key];
-    [prefs synchronize];
-}
-
-static void KimiRunSetPrefString(NSString *key, NSString *value) {
-    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
-        return;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    if ([value isKindOfClass:[NSString class]] && value.length > 0) {
-        [prefs setObject:value forKey:key];
-    } else {
-        [prefs removeObjectForKey:key];
-    }
-    [prefs synchronize];
-}
-
-static BOOL KimiRunEnvBool(const char *key, BOOL defaultValue) {
-    if (!key) {
-        return defaultValue;
-    }
-    const char *value = getenv(key);
-    if (!value || value[0] == '\0') {
-        return defaultValue;
-    }
-    NSString *lower = [[[NSString stringWithUTF8String:value] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] lowercaseString];
-    if ([lower isEqualToString:@"1"] || [lower isEqualToString:@"true"] || [lower isEqualToString:@"yes"] || [lower isEqualToString:@"on"]) {
-        return YES;
-    }
-    if ([lower isEqualToString:@"0"] || [lower isEqualToString:@"false"] || [lower isEqualToString:@"no"] || [lower isEqualToString:@"off"]) {
-        return NO;
-    }
-    return defaultValue;
-}
+#import "../prefs/KimiRunPrefs.h"
 
 static BOOL KimiRunTouchProxyEnabled(void) {
-    if (KimiRunEnvBool("KIMIRUN_TOUCH_PROXY", NO)) {
+    if (KimiRunPrefsEnvBool("KIMIRUN_TOUCH_PROXY", NO)) {
         return YES;
     }
-    return KimiRunPrefBool(@"TouchProxy", NO);
+    return KimiRunPrefsBool(@"TouchProxy", NO);
 }
 
 @interface DaemonHTTPServer (TouchAdminPrivate)
@@ -82,13 +29,14 @@ static BOOL KimiRunTouchProxyEnabled(void) {
             return [self jsonResponse:200 body:proxyBody];
         }
     }
-    uint64_t senderID = [KimiRunTouchInjection senderID];
-    BOOL captured = [KimiRunTouchInjection senderIDCaptured];
+    NSDictionary *state = [KimiRunTouchInjection senderIDState];
+    uint64_t senderID = [state[@"senderID"] unsignedLongLongValue];
+    BOOL captured = [state[@"captured"] boolValue];
     BOOL fallback = [KimiRunTouchInjection senderIDFallbackEnabled];
-    int callbackCount = [KimiRunTouchInjection senderIDCallbackCount];
+    int callbackCount = [state[@"callbackCount"] intValue];
     BOOL threadRunning = [KimiRunTouchInjection senderIDCaptureThreadRunning];
-    int digitizerCount = [KimiRunTouchInjection senderIDDigitizerCount];
-    int lastEventType = [KimiRunTouchInjection senderIDLastEventType];
+    int digitizerCount = [state[@"digitizerCount"] intValue];
+    int lastEventType = [state[@"lastEventType"] intValue];
     BOOL mainRegistered = [KimiRunTouchInjection senderIDMainRegistered];
     BOOL dispatchRegistered = [KimiRunTouchInjection senderIDDispatchRegistered];
     uintptr_t hidConn = [KimiRunTouchInjection hidConnectionPtr];
@@ -97,7 +45,7 @@ static BOOL KimiRunTouchProxyEnabled(void) {
     uintptr_t bksDeliveryPtr = [KimiRunTouchInjection bksDeliveryManagerPtr];
     BOOL bksRouterReady = [KimiRunTouchInjection bksRouterManagerAvailable];
     uintptr_t bksRouterPtr = [KimiRunTouchInjection bksRouterManagerPtr];
-    NSString *source = [KimiRunTouchInjection senderIDSourceString];
+    NSString *source = state[@"source"] ?: @"none";
     NSString *json = [NSString stringWithFormat:
                       @"{\"status\":\"ok\",\"senderID\":\"0x%llX\",\"captured\":%s,\"fallbackEnabled\":%s,\"callbackCount\":%d,\"digitizerCount\":%d,\"lastEventType\":%d,\"threadRunning\":%s,\"mainRegistered\":%s,\"dispatchRegistered\":%s,\"hidConnection\":\"0x%lX\",\"adminClientType\":%d,\"bksDeliveryReady\":%s,\"bksDeliveryManager\":\"0x%lX\",\"bksRouterReady\":%s,\"bksRouterManager\":\"0x%lX\",\"source\":\"%@\"}",
                       senderID,
@@ -226,12 +174,9 @@ static BOOL KimiRunTouchProxyEnabled(void) {
     // AX/BKS delivery is typically more reliable in SpringBoard, so proxy is on by default when enabling AX.
     BOOL setProxy = [self boolValueFromQuery:path key:@"proxy" defaultValue:enabled];
     if (enabled) {
-        KimiRunSetPrefBool(@"ForceAX", YES);
-        KimiRunSetPrefString(@"TouchMethod", @"ax");
-        KimiRunSetPrefBool(@"TouchProxy", setProxy);
+        KimiRunPrefsSetValues(@{@"ForceAX": @YES, @"TouchMethod": @"ax", @"TouchProxy": @(setProxy)});
     } else {
-        KimiRunSetPrefBool(@"ForceAX", NO);
-        KimiRunSetPrefString(@"TouchMethod", @"auto");
+        KimiRunPrefsSetValues(@{@"ForceAX": @NO, @"TouchMethod": @"auto"});
     }
 
     NSDictionary *enableResult = enabled ? [AXTouchInjection ensureAccessibilityEnabled] : @{};
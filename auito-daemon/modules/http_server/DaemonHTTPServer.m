@@ -11,7 +11,10 @@
 #import "../touch/AXTouchInjection.h"
 #import "../screenshot/KimiRunScreenshot.h"
 #import "../accessibility/AccessibilityTree.h"
+#import "../accessibility/KimiRunA11yEncode.h"
 #import "../app/AppLauncher.h"
+#import "../prefs/KimiRunPrefs.h"
+#import "../log/KimiRunLogRing.h"
 
 #define HTTP_BUFFER_SIZE 4096
 static const NSUInteger kSpringBoardProxyPort = 8765;
@@ -31,6 +34,9 @@ static const NSUInteger kMobileSafariProxyPort = 8767;
 - (NSString *)proxyTouchResponseForPath:(NSString *)path
                                 timeout:(NSTimeInterval)timeout
                         resolvedPortOut:(NSUInteger *)resolvedPortOut;
+- (NSData *)proxyTouchDataForPath:(NSString *)path
+                          timeout:(NSTimeInterval)timeout
+                  resolvedPortOut:(NSUInteger *)resolvedPortOut;
 - (id)proxyTouchHTTPResponseForPath:(NSString *)path timeout:(NSTimeInterval)timeout;
 - (id)strictProxyResponseForPath:(NSString *)path
                           timeout:(NSTimeInterval)timeout
@@ -58,7 +64,9 @@ static const NSUInteger kMobileSafariProxyPort = 8767;
 - (NSString *)jsonResponse:(NSInteger)statusCode body:(NSString *)body;
 - (NSData *)binaryResponse:(NSInteger)statusCode contentType:(NSString *)contentType body:(NSData *)body;
 - (CGFloat)floatValueFromQuery:(NSString *)query key:(NSString *)key;
+- (CGPoint)touchPointFromQuery:(NSString *)query xKey:(NSString *)xKey yKey:(NSString *)yKey;
 - (NSString *)stringValueFromQuery:(NSString *)query key:(NSString *)key;
+- (NSArray<NSString *> *)stringValuesFromQuery:(NSString *)query key:(NSString *)key;
 - (BOOL)boolValueFromQuery:(NSString *)query key:(NSString *)key defaultValue:(BOOL)defaultValue;
 - (NSInteger)contentLengthFromHeaderString:(NSString *)headerString;
 - (NSDictionary *)parseJSONBody:(NSString *)body;
@@ -70,35 +78,12 @@ static const NSUInteger kMobileSafariProxyPort = 8767;
 
 static void DaemonSocketCallback(CFSocketRef s, CFSocketCallBackType type, CFDataRef address, const void *data, void *info);
 static CGFloat ClampValue(CGFloat value, CGFloat minValue, CGFloat maxValue);
-static NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
-
-static BOOL KimiRunPrefBool(NSString *key, BOOL defaultValue) {
-    if (!key || key.length == 0) {
-        return defaultValue;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs objectForKey:key];
-    if (!value) {
-        return defaultValue;
-    }
-    return [prefs boolForKey:key];
-}
-
-static NSString *KimiRunPrefString(NSString *key) {
-    if (!key || key.length == 0) {
-        return nil;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs stringForKey:key];
-    return [value isKindOfClass:[NSString class]] ? value : nil;
-}
-
 static NSString *KimiRunDefaultTouchMethod(void) {
-    const char *env = getenv("KIMIRUN_TOUCH_METHOD");
+    const char *env = KimiRunPrefsEnv("KIMIRUN_TOUCH_METHOD");
     if (env && env[0] != '\0') {
         return [NSString stringWithUTF8String:env];
     }
-    NSString *prefMethod = KimiRunPrefString(@"TouchMethod");
+    NSString *prefMethod = KimiRunPrefsString(@"TouchMethod");
     if ([prefMethod isKindOfClass:[NSString class]] && prefMethod.length > 0) {
         return prefMethod;
     }
@@ -106,32 +91,14 @@ static NSString *KimiRunDefaultTouchMethod(void) {
     return @"ax";
 }
 
-static BOOL KimiRunEnvBool(const char *key, BOOL defaultValue) {
-    if (!key) {
-        return defaultValue;
-    }
-    const char *value = getenv(key);
-    if (!value || value[0] == '\0') {
-        return defaultValue;
-    }
-    NSString *lower = [[[NSString stringWithUTF8String:value] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] lowercaseString];
-    if ([lower isEqualToString:@"1"] || [lower isEqualToString:@"true"] || [lower isEqualToString:@"yes"] || [lower isEqualToString:@"on"]) {
-        return YES;
-    }
-    if ([lower isEqualToString:@"0"] || [lower isEqualToString:@"false"] || [lower isEqualToString:@"no"] || [lower isEqualToString:@"off"]) {
-        return NO;
-    }
-    return defaultValue;
-}
-
 static BOOL KimiRunTouchProxyEnabled(void) {
-    if (KimiRunEnvBool("KIMIRUN_TOUCH_PROXY", NO)) {
+    if (KimiRunPrefsEnvBool("KIMIRUN_TOUCH_PROXY", NO)) {
         return YES;
     }
-    if (KimiRunEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO)) {
+    if (KimiRunPrefsEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO)) {
         return YES;
     }
-    return KimiRunPrefBool(@"TouchProxy", NO);
+    return KimiRunPrefsBool(@"TouchProxy", NO);
 }
 
 static BOOL KimiRunIsStrictExplicitTouchMethod(NSString *method) {
@@ -163,12 +130,12 @@ static BOOL KimiRunShouldForceProxyMethod(NSString *method) {
         return NO;
     }
     if ([lower isEqualToString:@"zx"] || [lower isEqualToString:@"zxtouch"]) {
-        return KimiRunEnvBool("KIMIRUN_FORCE_STRICT_PROXY_ZX",
-                              KimiRunPrefBool(@"ForceStrictProxyZX", NO));
+        return KimiRunPrefsEnvBool("KIMIRUN_FORCE_STRICT_PROXY_ZX",
+                                   KimiRunPrefsBool(@"ForceStrictProxyZX", NO));
     }
     if ([lower isEqualToString:@"bks"]) {
-        return KimiRunEnvBool("KIMIRUN_FORCE_STRICT_PROXY_BKS",
-                              KimiRunPrefBool(@"ForceStrictProxyBKS", NO));
+        return KimiRunPrefsEnvBool("KIMIRUN_FORCE_STRICT_PROXY_BKS",
+                                   KimiRunPrefsBool(@"ForceStrictProxyBKS", NO));
     }
     return NO;
 }
@@ -200,14 +167,14 @@ static NSString *KimiRunUnsupportedTouchMethodMessage(NSString *method) {
         return nil;
     }
     if (KimiRunIsStrictExplicitTouchMethod(canonical) &&
-        !KimiRunEnvBool("KIMIRUN_ENABLE_STRICT_NON_AX",
-                        KimiRunPrefBool(@"EnableStrictNonAX", NO)) &&
-        !KimiRunEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO)) {
+        !KimiRunPrefsEnvBool("KIMIRUN_ENABLE_STRICT_NON_AX",
+                             KimiRunPrefsBool(@"EnableStrictNonAX", NO)) &&
+        !KimiRunPrefsEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO)) {
         return @"Strict non-AX methods are disabled by default (set EnableStrictNonAX=true or KIMIRUN_NONAX_VIA_SPRINGBOARD=1 to opt in)";
     }
     if ([canonical isEqualToString:@"zxtouch"]) {
-        BOOL enabled = KimiRunEnvBool("KIMIRUN_ENABLE_ZXTOUCH",
-                                      KimiRunPrefBool(@"EnableZXTouch", NO));
+        BOOL enabled = KimiRunPrefsEnvBool("KIMIRUN_ENABLE_ZXTOUCH",
+                                           KimiRunPrefsBool(@"EnableZXTouch", NO));
         if (!enabled) {
             return @"ZXTouch disabled for safety on this build (set EnableZXTouch=true or KIMIRUN_ENABLE_ZXTOUCH=1 to opt in)";
         }
@@ -216,18 +183,18 @@ static NSString *KimiRunUnsupportedTouchMethodMessage(NSString *method) {
 }
 
 static BOOL KimiRunProxyAllStrictMethodsEnabled(void) {
-    if (KimiRunEnvBool("KIMIRUN_TOUCH_PROXY_ALL_STRICT", NO)) {
+    if (KimiRunPrefsEnvBool("KIMIRUN_TOUCH_PROXY_ALL_STRICT", NO)) {
         return YES;
     }
-    if (KimiRunEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO)) {
+    if (KimiRunPrefsEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO)) {
         return YES;
     }
-    return KimiRunPrefBool(@"TouchProxyAllStrict", NO);
+    return KimiRunPrefsBool(@"TouchProxyAllStrict", NO);
 }
 
 static BOOL KimiRunUIDeltaGateStrictLocalEnabled(void) {
-    return KimiRunEnvBool("KIMIRUN_STRICT_LOCAL_UIDELTA",
-                          KimiRunPrefBool(@"StrictLocalUIDelta", YES));
+    return KimiRunPrefsEnvBool("KIMIRUN_STRICT_LOCAL_UIDELTA",
+                               KimiRunPrefsBool(@"StrictLocalUIDelta", YES));
 }
 
 static BOOL KimiRunShouldUseStrictProxyOnly(NSString *method) {
@@ -283,23 +250,38 @@ static uint64_t KimiRunParseSenderIDValue(id rawValue) {
     return 0;
 }
 
+// One query keeps the original {query, count, matches} shape.
+static NSDictionary *KimiRunA11yFindPayload(NSArray<NSString *> *queries, NSArray<NSArray *> *perQuery) {
+    if (queries.count == 1) {
+        NSArray *matches = perQuery.firstObject ?: @[];
+        return @{@"success": @YES, @"query": queries[0], @"count": @(matches.count), @"matches": matches};
+    }
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:queries.count];
+    NSUInteger total = 0;
+    for (NSUInteger i = 0; i < queries.count; i++) {
+        NSArray *matches = i < perQuery.count ? perQuery[i] : @[];
+        total += matches.count;
+        [results addObject:@{@"query": queries[i], @"count": @(matches.count), @"matches": matches}];
+    }
+    return @{@"success": @YES, @"queries": queries, @"count": @(total), @"results": results};
+}
+
 static NSString *KimiRunTouchLogPath(void) {
     return @"/var/mobile/Library/Preferences/kimirun_touch.log";
 }
 
-static NSTimeInterval KimiRunBKSDispatchTimestampFromInfo(NSDictionary *info) {
-    if (![info isKindOfClass:[NSDictionary class]]) {
-        return 0;
-    }
-    NSNumber *timestamp = info[@"timestamp"];
-    if ([timestamp respondsToSelector:@selector(doubleValue)]) {
-        return [timestamp doubleValue];
-    }
-    return 0;
-}
+// Bounded wait for this process's queued log lines before /logs tails the file.
+static const unsigned kKimiRunLogsFlushMillis = 100;
 
 static NSTimeInterval KimiRunCurrentBKSDispatchTimestamp(void) {
-    return KimiRunBKSDispatchTimestampFromInfo([KimiRunTouchInjection lastBKSDispatchInfo]);
+    return [KimiRunTouchInjection lastBKSDispatchTimestamp];
+}
+
+// Route attempts/experiment flags make touch responses large; only attach
+// them when explicitly asked for.
+static BOOL KimiRunBKSDispatchVerboseEnabled(void) {
+    return KimiRunPrefsEnvBool("KIMIRUN_BKS_DISPATCH_VERBOSE",
+                               KimiRunPrefsBool(@"BKSDispatchVerbose", NO));
 }
 
 static NSDictionary *KimiRunBKSDispatchInfoForMethod(NSString *method, NSTimeInterval baselineTimestamp) {
@@ -307,11 +289,8 @@ static NSDictionary *KimiRunBKSDispatchInfoForMethod(NSString *method, NSTimeInt
     if (![canonical isEqualToString:@"bks"] && ![canonical isEqualToString:@"zxtouch"]) {
         return nil;
     }
-    NSDictionary *info = [KimiRunTouchInjection lastBKSDispatchInfo];
-    if (![info isKindOfClass:[NSDictionary class]] || info.count == 0) {
-        return nil;
-    }
-    NSTimeInterval timestamp = KimiRunBKSDispatchTimestampFromInfo(info);
+    // Check freshness on the raw record before building any dictionary.
+    NSTimeInterval timestamp = [KimiRunTouchInjection lastBKSDispatchTimestamp];
     if (timestamp > 0) {
         NSTimeInterval age = [[NSDate date] timeIntervalSince1970] - timestamp;
         if (age < 0 || age > 5.0) {
@@ -321,6 +300,10 @@ static NSDictionary *KimiRunBKSDispatchInfoForMethod(NSString *method, NSTimeInt
             return nil;
         }
     }
+    NSDictionary *info = [KimiRunTouchInjection lastBKSDispatchInfoIncludingRouteDetail:KimiRunBKSDispatchVerboseEnabled()];
+    if (![info isKindOfClass:[NSDictionary class]] || info.count == 0) {
+        return nil;
+    }
     return info;
 }
 
@@ -331,66 +314,9 @@ static NSArray<NSDictionary *> *KimiRunBKSDispatchHistoryForMethod(NSString *met
     if (![canonical isEqualToString:@"bks"] && ![canonical isEqualToString:@"zxtouch"]) {
         return @[];
     }
-    NSArray<NSDictionary *> *history = [KimiRunTouchInjection recentBKSDispatchHistory:maxItems];
-    if (![history isKindOfClass:[NSArray class]] || history.count == 0) {
-        return @[];
-    }
-    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
-    NSMutableArray<NSDictionary *> *filtered = [NSMutableArray arrayWithCapacity:history.count];
-    for (id item in history) {
-        if (![item isKindOfClass:[NSDictionary class]]) {
-            continue;
-        }
-        NSDictionary *info = (NSDictionary *)item;
-        NSTimeInterval timestamp = KimiRunBKSDispatchTimestampFromInfo(info);
-        if (timestamp > 0) {
-            NSTimeInterval age = now - timestamp;
-            if (age < 0 || age > 5.0) {
-                continue;
-            }
-            if (baselineTimestamp > 0 && timestamp <= (baselineTimestamp + 0.000001)) {
-                continue;
-            }
-        }
-        NSMutableDictionary *compact = [NSMutableDictionary dictionary];
-        if (timestamp > 0) {
-            compact[@"timestamp"] = @(timestamp);
-        }
-        id ok = info[@"ok"];
-        if (ok) {
-            compact[@"ok"] = ok;
-        }
-        id reason = info[@"reason"];
-        if ([reason isKindOfClass:[NSString class]] && [reason length] > 0) {
-            compact[@"reason"] = reason;
-        }
-        id chosenSource = info[@"chosenSource"];
-        if ([chosenSource isKindOfClass:[NSString class]] && [chosenSource length] > 0) {
-            compact[@"source"] = chosenSource;
-        }
-        id chosenDestination = info[@"chosenDestination"];
-        if (chosenDestination) {
-            compact[@"destination"] = chosenDestination;
-        }
-        id chosenTargetClass = info[@"chosenTargetClass"];
-        if ([chosenTargetClass isKindOfClass:[NSString class]] && [chosenTargetClass length] > 0) {
-            compact[@"targetClass"] = chosenTargetClass;
-        }
-        id chosenPID = info[@"chosenPID"];
-        if (chosenPID) {
-            compact[@"pid"] = chosenPID;
-        }
-        id acceptedDispatches = info[@"acceptedDispatches"];
-        if (acceptedDispatches) {
-            compact[@"acceptedDispatches"] = acceptedDispatches;
-        }
-        id candidateCount = info[@"candidateCount"];
-        if (candidateCount) {
-            compact[@"candidateCount"] = candidateCount;
-        }
-        [filtered addObject:compact];
-    }
-    return filtered;
+    return [KimiRunTouchInjection recentBKSDispatchSummariesAfter:baselineTimestamp
+                                                           maxAge:5.0
+                                                            limit:maxItems];
 }
 
 static NSString *KimiRunTouchActionJSON(NSString *action,
@@ -763,14 +689,7 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     }
 
     if ([routePath isEqualToString:@"/vision/a11y"]) {
-        __block NSArray *elements = nil;
-        if ([NSThread isMainThread]) {
-            elements = [AccessibilityTree getInteractiveElements];
-        } else {
-            dispatch_sync(dispatch_get_main_queue(), ^{
-                elements = [AccessibilityTree getInteractiveElements];
-            });
-        }
+        NSArray *elements = [AccessibilityTree getInteractiveElements];
 
         if (!elements || elements.count == 0) {
             NSArray *proxyElements = [self fetchSpringBoardInteractiveElements];
@@ -1092,14 +1011,18 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
             return [self jsonResponse:400 body:json];
         }
 
-        __block BOOL success = NO;
-        if ([NSThread isMainThread]) {
-            success = [KimiRunTouchInjection typeText:text];
-        } else {
-            dispatch_sync(dispatch_get_main_queue(), ^{
-                success = [KimiRunTouchInjection typeText:text];
-            });
+        // Requests are served on the daemon's main thread, so HID playback
+        // is queued rather than waited for: 202 with the jobID to poll on
+        // /keyboard/type/status, since the keys may still fail.
+        NSDictionary *typing = [KimiRunTouchInjection typeText:text options:nil];
+        NSString *state = typing[@"state"] ?: @"failed";
+        if ([@[@"queued", @"running"] containsObject:state]) {
+            NSString *json = [NSString stringWithFormat:
+                              @"{\"status\":\"ok\",\"action\":\"type\",\"success\":false,\"state\":\"%@\",\"jobID\":\"%@\"}",
+                              state, typing[@"jobID"] ?: @""];
+            return [self jsonResponse:202 body:json];
         }
+        BOOL success = [typing[@"success"] boolValue];
 
         NSString *json = [NSString stringWithFormat:
                           @"{\"status\":\"ok\",\"action\":\"type\",\"success\":%s}",
@@ -1157,11 +1080,15 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
         }
 
         NSDictionary *localDiag = [KimiRunTouchInjection hidDiagnostics];
+        NSDictionary *localBKSDispatch = @{
+            @"last": [KimiRunTouchInjection lastBKSDispatchInfoIncludingRouteDetail:YES] ?: @{},
+            @"history": [KimiRunTouchInjection recentBKSDispatchHistory:16] ?: @[],
+        };
         BOOL proxyEnabled = KimiRunTouchProxyEnabled();
         BOOL proxyAllStrict = KimiRunProxyAllStrictMethodsEnabled();
-        BOOL enableStrictNonAX = KimiRunEnvBool("KIMIRUN_ENABLE_STRICT_NON_AX",
-                                                 KimiRunPrefBool(@"EnableStrictNonAX", NO));
-        BOOL nonaxViaSpringBoard = KimiRunEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO);
+        BOOL enableStrictNonAX = KimiRunPrefsEnvBool("KIMIRUN_ENABLE_STRICT_NON_AX",
+                                                     KimiRunPrefsBool(@"EnableStrictNonAX", NO));
+        BOOL nonaxViaSpringBoard = KimiRunPrefsEnvBool("KIMIRUN_NONAX_VIA_SPRINGBOARD", NO);
 
         BOOL sbReachable = (sbDiag != nil);
         BOOL sbHIDReady = NO;
@@ -1177,6 +1104,8 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
             @"status": @"ok",
             @"springboard": sbDiag ?: @{@"error": @"unreachable"},
             @"daemon": localDiag ?: @{},
+            @"daemonBKSDispatch": localBKSDispatch,
+            @"daemonStrategy": [KimiRunTouchInjection strategyStats:32],
             @"proxyConfig": @{
                 @"touchProxyEnabled": @(proxyEnabled),
                 @"touchProxyAllStrict": @(proxyAllStrict),
@@ -1198,8 +1127,9 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     }
 
     if ([routePath isEqualToString:@"/tap"]) {
-        CGFloat x = [self floatValueFromQuery:path key:@"x"];
-        CGFloat y = [self floatValueFromQuery:path key:@"y"];
+        CGPoint inputPoint = [self touchPointFromQuery:path xKey:@"x" yKey:@"y"];
+        CGFloat x = inputPoint.x;
+        CGFloat y = inputPoint.y;
         NSString *method = [self stringValueFromQuery:path key:@"method"];
         NSString *unsupportedMethodMessage = KimiRunUnsupportedTouchMethodMessage(method);
         if (unsupportedMethodMessage.length > 0) {
@@ -1301,10 +1231,12 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     }
 
     if ([routePath isEqualToString:@"/swipe"]) {
-        CGFloat x1 = [self floatValueFromQuery:path key:@"x1"];
-        CGFloat y1 = [self floatValueFromQuery:path key:@"y1"];
-        CGFloat x2 = [self floatValueFromQuery:path key:@"x2"];
-        CGFloat y2 = [self floatValueFromQuery:path key:@"y2"];
+        CGPoint inputStart = [self touchPointFromQuery:path xKey:@"x1" yKey:@"y1"];
+        CGPoint inputEnd = [self touchPointFromQuery:path xKey:@"x2" yKey:@"y2"];
+        CGFloat x1 = inputStart.x;
+        CGFloat y1 = inputStart.y;
+        CGFloat x2 = inputEnd.x;
+        CGFloat y2 = inputEnd.y;
         CGFloat duration = [self floatValueFromQuery:path key:@"duration"];
         NSString *method = [self stringValueFromQuery:path key:@"method"];
         NSString *unsupportedMethodMessage = KimiRunUnsupportedTouchMethodMessage(method);
@@ -1495,10 +1427,12 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     }
 
     if ([routePath isEqualToString:@"/drag"]) {
-        CGFloat x1 = [self floatValueFromQuery:path key:@"x1"];
-        CGFloat y1 = [self floatValueFromQuery:path key:@"y1"];
-        CGFloat x2 = [self floatValueFromQuery:path key:@"x2"];
-        CGFloat y2 = [self floatValueFromQuery:path key:@"y2"];
+        CGPoint inputStart = [self touchPointFromQuery:path xKey:@"x1" yKey:@"y1"];
+        CGPoint inputEnd = [self touchPointFromQuery:path xKey:@"x2" yKey:@"y2"];
+        CGFloat x1 = inputStart.x;
+        CGFloat y1 = inputStart.y;
+        CGFloat x2 = inputEnd.x;
+        CGFloat y2 = inputEnd.y;
         CGFloat duration = [self floatValueFromQuery:path key:@"duration"];
         NSString *method = [self stringValueFromQuery:path key:@"method"];
         NSString *unsupportedMethodMessage = KimiRunUnsupportedTouchMethodMessage(method);
@@ -1607,8 +1541,9 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     }
 
     if ([routePath isEqualToString:@"/doubletap"]) {
-        CGFloat x = [self floatValueFromQuery:path key:@"x"];
-        CGFloat y = [self floatValueFromQuery:path key:@"y"];
+        CGPoint inputPoint = [self touchPointFromQuery:path xKey:@"x" yKey:@"y"];
+        CGFloat x = inputPoint.x;
+        CGFloat y = inputPoint.y;
         NSString *method = [self stringValueFromQuery:path key:@"method"];
         NSString *unsupportedMethodMessage = KimiRunUnsupportedTouchMethodMessage(method);
         if (unsupportedMethodMessage.length > 0) {
@@ -1714,8 +1649,9 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     }
 
     if ([routePath isEqualToString:@"/longpress"]) {
-        CGFloat x = [self floatValueFromQuery:path key:@"x"];
-        CGFloat y = [self floatValueFromQuery:path key:@"y"];
+        CGPoint inputPoint = [self touchPointFromQuery:path xKey:@"x" yKey:@"y"];
+        CGFloat x = inputPoint.x;
+        CGFloat y = inputPoint.y;
         CGFloat duration = [self floatValueFromQuery:path key:@"duration"];
         NSString *method = [self stringValueFromQuery:path key:@"method"];
         NSString *unsupportedMethodMessage = KimiRunUnsupportedTouchMethodMessage(method);
@@ -1830,21 +1766,84 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
             return [self jsonResponse:400 body:json];
         }
 
-        __block BOOL success = NO;
-        if ([NSThread isMainThread]) {
-            success = [KimiRunTouchInjection typeText:text];
-        } else {
-            dispatch_sync(dispatch_get_main_queue(), ^{
-                success = [KimiRunTouchInjection typeText:text];
-            });
+        NSMutableDictionary *options = [NSMutableDictionary dictionary];
+        NSString *holdStr = [self stringValueFromQuery:path key:@"holdMS"];
+        NSString *intervalStr = [self stringValueFromQuery:path key:@"intervalMS"];
+        NSString *modeStr = [self stringValueFromQuery:path key:@"mode"];
+        if (holdStr.length > 0) {
+            options[@"holdMS"] = @([holdStr integerValue]);
+        }
+        if (intervalStr.length > 0) {
+            options[@"intervalMS"] = @([intervalStr integerValue]);
+        }
+        if (modeStr.length > 0) {
+            options[@"mode"] = [modeStr lowercaseString];
+        }
+        if ([[self stringValueFromQuery:path key:@"async"] boolValue]) {
+            NSString *jobID = [KimiRunTouchInjection typeTextAsync:text options:options];
+            if (jobID.length == 0) {
+                NSString *json = @"{\"status\":\"error\",\"message\":\"Failed to start typing job\"}";
+                return [self jsonResponse:500 body:json];
+            }
+            NSString *json = [NSString stringWithFormat:
+                              @"{\"status\":\"ok\",\"action\":\"type\",\"async\":true,\"jobID\":\"%@\",\"length\":%lu}",
+                              jobID, (unsigned long)text.length];
+            return [self jsonResponse:200 body:json];
         }
 
+        // This runs on the daemon's main thread, which the typing engine
+        // never holds for key playback: a job that needs HID keys comes back
+        // still pending (202, success false) with a jobID for
+        // /keyboard/type/status.
+        NSDictionary *typing = [KimiRunTouchInjection typeText:text options:options];
+        BOOL pending = [@[@"queued", @"running"] containsObject:typing[@"state"] ?: @""];
+        BOOL success = [typing[@"success"] boolValue];
+        NSMutableDictionary *payload = [@{
+            @"status": @"ok",
+            @"action": @"type",
+            @"success": @(success),
+            @"path": typing[@"path"] ?: @"none",
+            @"elapsedMS": typing[@"elapsedMS"] ?: @0,
+            @"typing": typing ?: @{},
+        } mutableCopy];
+        if (pending) {
+            payload[@"async"] = @YES;
+            payload[@"state"] = typing[@"state"];
+            payload[@"jobID"] = typing[@"jobID"] ?: @"";
+        }
+        NSError *err = nil;
+        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&err];
+        if (jsonData.length > 0 && !err) {
+            return [self jsonResponse:(pending ? 202 : 200)
+                                 body:[[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding]];
+        }
         NSString *json = [NSString stringWithFormat:
                           @"{\"status\":\"ok\",\"action\":\"type\",\"success\":%s}",
                           success ? "true" : "false"];
         return [self jsonResponse:200 body:json];
     }
 
+    if ([routePath isEqualToString:@"/keyboard/type/status"]) {
+        NSString *jobID = [self stringValueFromQuery:path key:@"id"];
+        if (!jobID || jobID.length == 0) {
+            NSString *json = @"{\"status\":\"error\",\"message\":\"Missing id\"}";
+            return [self jsonResponse:400 body:json];
+        }
+        NSDictionary *job = [KimiRunTouchInjection typingJobStatus:jobID];
+        if (!job) {
+            NSString *json = @"{\"status\":\"error\",\"message\":\"Unknown typing job\"}";
+            return [self jsonResponse:404 body:json];
+        }
+        NSMutableDictionary *payload = [NSMutableDictionary dictionaryWithDictionary:job];
+        payload[@"status"] = @"ok";
+        NSError *err = nil;
+        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&err];
+        if (jsonData.length > 0 && !err) {
+            return [self jsonResponse:200 body:[[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding]];
+        }
+        return [self jsonResponse:500 body:@"{\"status\":\"error\",\"message\":\"Failed to encode typing job\"}"];
+    }
+
     if ([routePath isEqualToString:@"/keyboard/key"]) {
         NSString *usageStr = [self stringValueFromQuery:path key:@"usage"];
         NSString *downStr = [self stringValueFromQuery:path key:@"down"];
@@ -1942,10 +1941,10 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
 
     if ([routePath isEqualToString:@"/diagnostics"]) {
         NSString *method = KimiRunDefaultTouchMethod() ?: @"auto";
-        BOOL disableLockscreen = KimiRunPrefBool(@"DisableLockScreen", NO);
-        BOOL preventSleep = KimiRunPrefBool(@"PreventSleep", NO);
-        BOOL blockSideButtonSleep = KimiRunPrefBool(@"BlockSideButtonSleep", NO);
-        BOOL allowSleep = KimiRunPrefBool(@"AllowSleep", NO);
+        BOOL disableLockscreen = KimiRunPrefsBool(@"DisableLockScreen", NO);
+        BOOL preventSleep = KimiRunPrefsBool(@"PreventSleep", NO);
+        BOOL blockSideButtonSleep = KimiRunPrefsBool(@"BlockSideButtonSleep", NO);
+        BOOL allowSleep = KimiRunPrefsBool(@"AllowSleep", NO);
         NSString *senderID = [NSString stringWithFormat:@"0x%llX", [KimiRunTouchInjection senderID]];
 
         NSDictionary *payload = @{
@@ -1965,7 +1964,8 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
             @"server": @{
                 @"port": @(self.port),
                 @"running": @(self.isRunning)
-            }
+            },
+            @"prefs": [KimiRunPrefsCurrentSnapshot() diagnosticsDictionary] ?: @{}
         };
 
         NSError *error = nil;
@@ -1977,6 +1977,7 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
     if ([routePath isEqualToString:@"/logs"]) {
         NSInteger tail = (NSInteger)[self floatValueFromQuery:path key:@"tail"];
         if (tail <= 0) tail = 200;
+        KimiRunLogRingFlush(kKimiRunLogsFlushMillis);
         NSArray<NSString *> *lines = TailFileLines(KimiRunTouchLogPath(), (NSUInteger)tail);
         NSDictionary *payload = @{
             @"success": @YES,
@@ -2000,13 +2001,32 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
         BOOL compact = [self boolValueFromQuery:path key:@"compact" defaultValue:NO];
         BOOL pretty = [self boolValueFromQuery:path key:@"pretty" defaultValue:!compact];
 
-        __block NSDictionary *tree = nil;
-        if ([NSThread isMainThread]) {
-            tree = [AccessibilityTree getFullTree];
+        NSString *rootIdentifier = [self stringValueFromQuery:path key:@"rootIdentifier"];
+        NSString *rootLabel = [self stringValueFromQuery:path key:@"rootLabel"];
+        NSString *rootPath = [self stringValueFromQuery:path key:@"rootPath"];
+        NSString *fields = [self stringValueFromQuery:path key:@"fields"];
+        NSString *maxDepthStr = [self stringValueFromQuery:path key:@"maxDepth"];
+        NSString *interactiveStr = [self stringValueFromQuery:path key:@"interactiveOnly"];
+        NSDictionary *tree = nil;
+        if (rootIdentifier || rootLabel || rootPath || fields || maxDepthStr || interactiveStr) {
+            NSError *queryError = nil;
+            tree = [AccessibilityTree getTreeWithRootIdentifier:rootIdentifier
+                                                      rootLabel:rootLabel
+                                                       rootPath:rootPath
+                                                       maxDepth:(maxDepthStr.length > 0 ? [maxDepthStr integerValue] : -1)
+                                                         fields:fields
+                                                interactiveOnly:[self boolValueFromQuery:path key:@"interactiveOnly" defaultValue:NO]
+                                                          error:&queryError];
+            if (!tree) {
+                NSDictionary *payload = @{@"success": @NO,
+                                          @"error": queryError.localizedDescription ?: @"Failed to build UI hierarchy"};
+                NSData *errorData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:nil];
+                NSString *json = errorData ? [[NSString alloc] initWithData:errorData encoding:NSUTF8StringEncoding]
+                                           : @"{\"success\":false}";
+                return [self jsonResponse:(queryError.code ?: 500) body:json];
+            }
         } else {
-            dispatch_sync(dispatch_get_main_queue(), ^{
-                tree = [AccessibilityTree getFullTree];
-            });
+            tree = [AccessibilityTree getFullTree];
         }
 
         NSError *error = nil;
@@ -2129,6 +2149,28 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
 
     if ([routePath isEqualToString:@"/a11y/interactive"]) {
         NSUInteger resolvedPort = 0;
+        NSString *format = [self stringValueFromQuery:path key:@"format"].lowercaseString;
+        BOOL versioned = [self stringValueFromQuery:path key:@"since"] != nil;
+        if (!versioned && format.length > 0 && ![format isEqualToString:@"json"]) {
+            KimiRunA11yFormat encoding;
+            if (!KimiRunA11yFormatFromName(format.UTF8String, &encoding)) {
+                NSString *json = @"{\"success\":false,\"error\":\"Unknown format (json, min, columnar, msgpack)\"}";
+                return [self jsonResponse:400 body:json];
+            }
+            NSString *contentType = @(KimiRunA11yFormatContentType(encoding));
+            NSData *proxyData = [self proxyTouchDataForPath:path timeout:1.2 resolvedPortOut:&resolvedPort];
+            if (proxyData.length > 0) {
+                return [self binaryResponse:200 contentType:contentType body:proxyData];
+            }
+            NSArray *elements = [AccessibilityTree getInteractiveElements];
+            NSInteger limit = (NSInteger)[self floatValueFromQuery:path key:@"limit"];
+            if (limit > 0 && elements.count > (NSUInteger)limit) {
+                elements = [elements subarrayWithRange:NSMakeRange(0, (NSUInteger)limit)];
+            }
+            NSData *encoded = [AccessibilityTree encodeInteractiveElements:elements format:format contentType:NULL];
+            return [self binaryResponse:200 contentType:contentType body:encoded];
+        }
+
         NSString *proxyBody = [self proxyTouchResponseForPath:path timeout:1.2 resolvedPortOut:&resolvedPort];
         if (proxyBody.length > 0) {
             return [self jsonResponse:200 body:proxyBody];
@@ -2136,16 +2178,21 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
 
         BOOL compact = [self boolValueFromQuery:path key:@"compact" defaultValue:NO];
         NSInteger limit = (NSInteger)[self floatValueFromQuery:path key:@"limit"];
-
-        __block NSArray *elements = nil;
-        if ([NSThread isMainThread]) {
-            elements = [AccessibilityTree getInteractiveElements];
-        } else {
-            dispatch_sync(dispatch_get_main_queue(), ^{
-                elements = [AccessibilityTree getInteractiveElements];
-            });
+        NSString *sinceStr = [self stringValueFromQuery:path key:@"since"];
+
+        if (sinceStr) {
+            uint64_t since = strtoull(sinceStr.UTF8String, NULL, 10);
+            NSDictionary *delta = [AccessibilityTree getInteractiveElementsSince:since];
+            NSError *error = nil;
+            NSData *jsonData = [NSJSONSerialization dataWithJSONObject:(delta ?: @{})
+                                                               options:(compact ? 0 : NSJSONWritingPrettyPrinted)
+                                                                 error:&error];
+            NSString *json = error ? @"{}" : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+            return [self jsonResponse:200 body:json];
         }
 
+        NSArray *elements = [AccessibilityTree getInteractiveElements];
+
         if (limit > 0 && elements.count > (NSUInteger)limit) {
             elements = [elements subarrayWithRange:NSMakeRange(0, (NSUInteger)limit)];
         }
@@ -2158,6 +2205,74 @@ static NSArray<NSString *> *TailFileLines(NSString *path, NSUInteger maxLines) {
         return [self jsonResponse:200 body:json];
     }
 
+    if ([routePath isEqualToString:@"/a11y/at"] ||
+        [routePath isEqualToString:@"/a11y/rect"] ||
+        [routePath isEqualToString:@"/a11y/nearest"]) {
+        NSString *proxyBody = [self proxyTouchResponseForPath:path timeout:1.2 resolvedPortOut:NULL];
+        if (proxyBody.length > 0) {
+            return [self jsonResponse:200 body:proxyBody];
+        }
+        if (![self stringValueFromQuery:path key:@"x"] || ![self stringValueFromQuery:path key:@"y"]) {
+            return [self jsonResponse:400 body:@"{\"success\":false,\"error\":\"Missing x or y\"}"];
+        }
+        CGPoint point = CGPointMake([self floatValueFromQuery:path key:@"x"], [self floatValueFromQuery:path key:@"y"]);
+        NSDictionary *payload = nil;
+        if ([routePath isEqualToString:@"/a11y/nearest"]) {
+            NSString *maxStr = [self stringValueFromQuery:path key:@"maxDistance"];
+            CGFloat distance = 0;
+            NSDictionary *element = [AccessibilityTree nearestActionableElementToPoint:point
+                                                                           maxDistance:(maxStr ? [maxStr doubleValue] : -1)
+                                                                              distance:&distance];
+            payload = element
+                ? @{@"success": @YES, @"found": @YES, @"distance": @(distance), @"element": element}
+                : @{@"success": @YES, @"found": @NO};
+        } else {
+            NSArray *elements = [routePath isEqualToString:@"/a11y/rect"]
+                ? [AccessibilityTree interactiveElementsInRect:CGRectMake(point.x, point.y,
+                                                                          [self floatValueFromQuery:path key:@"width"],
+                                                                          [self floatValueFromQuery:path key:@"height"])
+                                                     contained:[self boolValueFromQuery:path key:@"contained" defaultValue:NO]]
+                : [AccessibilityTree interactiveElementsAtPoint:point];
+            payload = @{@"success": @YES, @"count": @(elements.count), @"elements": elements ?: @[]};
+        }
+        NSError *error = nil;
+        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&error];
+        NSString *json = error ? @"{\"success\":false}" : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+        return [self jsonResponse:200 body:json];
+    }
+
+    if ([routePath isEqualToString:@"/a11y/find"]) {
+        NSString *proxyBody = [self proxyTouchResponseForPath:path timeout:1.2 resolvedPortOut:NULL];
+        if (proxyBody.length > 0) {
+            return [self jsonResponse:200 body:proxyBody];
+        }
+        BOOL inLabel = YES;
+        BOOL inIdentifier = YES;
+        NSArray<NSString *> *queries = [self stringValuesFromQuery:path key:@"label"];
+        if (queries.count > 0) {
+            inIdentifier = NO;
+        } else if ((queries = [self stringValuesFromQuery:path key:@"identifier"]).count > 0) {
+            inLabel = NO;
+        } else {
+            queries = [self stringValuesFromQuery:path key:@"q"];
+        }
+        if (queries.count == 0) {
+            return [self jsonResponse:400 body:@"{\"success\":false,\"error\":\"Missing label, identifier or q\"}"];
+        }
+        NSString *limitStr = [self stringValueFromQuery:path key:@"limit"];
+        NSInteger limit = limitStr ? [limitStr integerValue] : 10;
+        NSArray<NSArray *> *perQuery = [AccessibilityTree findElementsMatchingQueries:queries
+                                                                              inLabel:inLabel
+                                                                         inIdentifier:inIdentifier
+                                                                                fuzzy:[self boolValueFromQuery:path key:@"fuzzy" defaultValue:NO]
+                                                                                limit:(NSUInteger)MAX(limit, 0)];
+        NSDictionary *payload = KimiRunA11yFindPayload(queries, perQuery);
+        NSError *error = nil;
+        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&error];
+        NSString *json = error ? @"{\"success\":false}" : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+        return [self jsonResponse:200 body:json];
+    }
+
     if ([routePath isEqualToString:@"/a11y/activate"]) {
         NSInteger index = (NSInteger)[self floatValueFromQuery:path key:@"index"];
         if (index < 0) {
@@ -19,9 +19,29 @@
 #import "../touch/AXTouchInjection.h"
 #import "../screenshot/KimiRunScreenshot.h"
 #import "../accessibility/AccessibilityTree.h"
+#import "../socket/SocketTouchServer.h"
 
 // HTTP request buffer size
 #define HTTP_BUFFER_SIZE 4096
+// Body bytes held at once by a streamed response
+#define HTTP_STREAM_BUFFER_SIZE 16384
+// A client that takes no bytes for this long is dropped
+#define HTTP_SEND_TIMEOUT_SECONDS 2
+
+// A response whose body is written while it is being sent, as HTTP/1.1
+// chunks. writeBody passes body bytes to sink and returns nil once the body
+// is complete; if it fails before writing anything it returns the response
+// to send instead.
+typedef BOOL (^KimiRunHTTPChunkSink)(const char *bytes, size_t length);
+
+@interface KimiRunHTTPStreamedResponse : NSObject
+@property (nonatomic, assign) NSInteger statusCode;
+@property (nonatomic, copy) NSString *contentType;
+@property (nonatomic, copy) id (^writeBody)(KimiRunHTTPChunkSink sink);
+@end
+
+@implementation KimiRunHTTPStreamedResponse
+@end
 
 @interface KimiRunHTTPServer ()
 @property (nonatomic, assign) BOOL isRunning;
@@ -38,7 +58,25 @@ static NSString *KimiRunFrontmostBundleID(void);
 static NSDictionary *KimiRunLockState(void);
 static BOOL KimiRunLaunchAppBundleID(NSString *bundleID);
 static NSArray *KimiRunListApplications(BOOL includeSystem);
+static CFIndex KimiRunWriteAll(CFWriteStreamRef writeStream, const UInt8 *bytes, CFIndex totalLength);
+static dispatch_queue_t KimiRunHTTPStreamQueue(void);
 static NSUInteger sLastGoodCapturePort = 0;
+
+// One query keeps the original {query, count, matches} shape.
+static NSDictionary *KimiRunA11yFindPayload(NSArray<NSString *> *queries, NSArray<NSArray *> *perQuery) {
+    if (queries.count == 1) {
+        NSArray *matches = perQuery.firstObject ?: @[];
+        return @{@"success": @YES, @"query": queries[0], @"count": @(matches.count), @"matches": matches};
+    }
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:queries.count];
+    NSUInteger total = 0;
+    for (NSUInteger i = 0; i < queries.count; i++) {
+        NSArray *matches = i < perQuery.count ? perQuery[i] : @[];
+        total += matches.count;
+        [results addObject:@{@"query": queries[i], @"count": @(matches.count), @"matches": matches}];
+    }
+    return @{@"success": @YES, @"queries": queries, @"count": @(total), @"results": results};
+}
 static NSUInteger sLastGoodTouchPort = 0;
 
 @implementation KimiRunHTTPServer
@@ -513,6 +551,10 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         return;
     }
     
+    // Writes give up on a client that stops reading instead of blocking.
+    struct timeval sendTimeout = { HTTP_SEND_TIMEOUT_SECONDS, 0 };
+    setsockopt(nativeSocket, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
     CFReadStreamOpen(readStream);
     CFWriteStreamOpen(writeStream);
     
@@ -560,41 +602,140 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     NSLog(@"[KimiRunHTTPServer] Received request:\n%@", requestString);
     
     // Parse request
-    NSString *response = [self generateResponseForRequest:requestString];
-    
+    id response = [self generateResponseForRequest:requestString];
+    if ([response isKindOfClass:[KimiRunHTTPStreamedResponse class]]) {
+        // The body is written while main walks the views for it, so it is
+        // written from the stream queue and main only captures.
+        dispatch_async(KimiRunHTTPStreamQueue(), ^{
+            id fallback = [self sendStreamedResponse:response toStream:writeStream];
+            [self finishConnection:nativeSocket response:fallback readStream:readStream writeStream:writeStream];
+        });
+        return;
+    }
+    [self finishConnection:nativeSocket response:response readStream:readStream writeStream:writeStream];
+}
+
+// Sends response (if any), then closes and releases the connection.
+- (void)finishConnection:(CFSocketNativeHandle)nativeSocket
+                response:(id)response
+              readStream:(CFReadStreamRef)readStream
+             writeStream:(CFWriteStreamRef)writeStream {
     // Send response
-    NSData *responseData = [response dataUsingEncoding:NSUTF8StringEncoding];
-    const UInt8 *bytes = [responseData bytes];
-    CFIndex totalLength = [responseData length];
-    CFIndex bytesWritten = 0;
+    if (response) {
+        NSData *responseData = [response isKindOfClass:[NSData class]]
+            ? (NSData *)response
+            : [response dataUsingEncoding:NSUTF8StringEncoding];
+        CFIndex totalLength = [responseData length];
+        CFIndex bytesWritten = KimiRunWriteAll(writeStream, [responseData bytes], totalLength);
+        NSLog(@"[KimiRunHTTPServer] Sent %ld/%ld bytes", (long)bytesWritten, (long)totalLength);
+    }
+    
+    // Clean up
+    CFReadStreamClose(readStream);
+    CFWriteStreamClose(writeStream);
+    CFRelease(readStream);
+    CFRelease(writeStream);
+    close(nativeSocket);
     
-    // Ensure all bytes are written (important for large responses like screenshots)
+    NSLog(@"[KimiRunHTTPServer] Connection handled and closed");
+}
+
+// Streamed bodies are written here, one connection at a time.
+static dispatch_queue_t KimiRunHTTPStreamQueue(void) {
+    static dispatch_queue_t queue = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                                                            QOS_CLASS_USER_INITIATED,
+                                                                            0);
+        queue = dispatch_queue_create("com.auito.http.stream", attr);
+    });
+    return queue;
+}
+
+// Ensure all bytes are written (important for large responses like
+// screenshots). Returns the number written, short on a write error or once
+// the client has taken nothing for HTTP_SEND_TIMEOUT_SECONDS.
+static CFIndex KimiRunWriteAll(CFWriteStreamRef writeStream, const UInt8 *bytes, CFIndex totalLength) {
+    CFIndex bytesWritten = 0;
+    CFAbsoluteTime stalledSince = 0;
     while (bytesWritten < totalLength) {
-        CFIndex result = CFWriteStreamWrite(writeStream, bytes + bytesWritten, totalLength - bytesWritten);
+        CFIndex result = 0;
+        if (CFWriteStreamCanAcceptBytes(writeStream)) {
+            result = CFWriteStreamWrite(writeStream, bytes + bytesWritten, totalLength - bytesWritten);
+        }
         if (result < 0) {
             NSLog(@"[KimiRunHTTPServer] Write error");
             break;
         }
         if (result == 0) {
             // Would block, wait a bit
+            CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+            if (stalledSince == 0) {
+                stalledSince = now;
+            } else if (now - stalledSince > HTTP_SEND_TIMEOUT_SECONDS) {
+                NSLog(@"[KimiRunHTTPServer] Write timed out");
+                break;
+            }
             usleep(1000);
+            continue;
         }
+        stalledSince = 0;
         bytesWritten += result;
     }
-    
-    NSLog(@"[KimiRunHTTPServer] Sent %ld/%ld bytes", (long)bytesWritten, (long)totalLength);
-    
-    // Clean up
-    CFReadStreamClose(readStream);
-    CFWriteStreamClose(writeStream);
-    CFRelease(readStream);
-    CFRelease(writeStream);
-    close(nativeSocket);
-    
-    NSLog(@"[KimiRunHTTPServer] Connection handled and closed");
+    return bytesWritten;
 }
 
-- (NSString *)generateResponseForRequest:(NSString *)request {
+// Sends the header with the first body bytes, so a response that fails
+// before writing anything can still go out as a plain error. Returns that
+// error response, or nil once the stream has been sent (or abandoned).
+- (id)sendStreamedResponse:(KimiRunHTTPStreamedResponse *)response toStream:(CFWriteStreamRef)writeStream {
+    NSData *header = [[NSString stringWithFormat:
+        @"HTTP/1.1 %ld %@\r\n"
+        @"Content-Type: %@\r\n"
+        @"Transfer-Encoding: chunked\r\n"
+        @"Connection: close\r\n"
+        @"\r\n",
+        (long)response.statusCode, [self statusTextForCode:response.statusCode],
+        response.contentType ?: @"application/json"
+    ] dataUsingEncoding:NSUTF8StringEncoding];
+    __block BOOL headerSent = NO;
+    __block BOOL broken = NO;
+    __block unsigned long long bodyBytes = 0;
+    KimiRunHTTPChunkSink sink = ^BOOL(const char *bytes, size_t length) {
+        if (!headerSent) {
+            headerSent = YES;
+            broken = KimiRunWriteAll(writeStream, header.bytes, (CFIndex)header.length) != (CFIndex)header.length;
+        }
+        if (broken || length == 0) {
+            return !broken;
+        }
+        char size[24];
+        int sizeLength = snprintf(size, sizeof(size), "%zx\r\n", length);
+        broken = KimiRunWriteAll(writeStream, (const UInt8 *)size, sizeLength) != sizeLength ||
+                 KimiRunWriteAll(writeStream, (const UInt8 *)bytes, (CFIndex)length) != (CFIndex)length ||
+                 KimiRunWriteAll(writeStream, (const UInt8 *)"\r\n", 2) != 2;
+        bodyBytes += length;
+        return !broken;
+    };
+
+    id fallback = response.writeBody ? response.writeBody(sink) : nil;
+    if (!headerSent) {
+        if (fallback) {
+            return fallback;
+        }
+        sink(NULL, 0);
+    }
+    // A body that failed part way ends without the last chunk, so the
+    // client sees it as truncated.
+    if (!broken && !fallback) {
+        KimiRunWriteAll(writeStream, (const UInt8 *)"0\r\n\r\n", 5);
+    }
+    NSLog(@"[KimiRunHTTPServer] Streamed %llu body bytes%@", bodyBytes, (broken || fallback) ? @" (incomplete)" : @"");
+    return nil;
+}
+
+- (id)generateResponseForRequest:(NSString *)request {
     // Parse request line
     NSArray *lines = [request componentsSeparatedByString:@"\r\n"];
     if (lines.count == 0) {
@@ -631,18 +772,18 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     // When SpringBoard is serving capture endpoints for a foreground app with its own
     // injected server (Preferences/Safari), proxy to that process so screenshot + AX
     // are sourced from the true foreground context.
-    NSString *captureProxyResponse = [self proxyForegroundCaptureRequestIfNeededWithMethod:method
-                                                                                   fullPath:fullPath
-                                                                                       path:path
-                                                                                       body:body];
+    id captureProxyResponse = [self proxyForegroundCaptureRequestIfNeededWithMethod:method
+                                                                         fullPath:fullPath
+                                                                             path:path
+                                                                             body:body];
     if (captureProxyResponse) {
         return captureProxyResponse;
     }
 
-    NSString *touchProxyResponse = [self proxyForegroundTouchRequestIfNeededWithMethod:method
-                                                                               fullPath:fullPath
-                                                                                   path:path
-                                                                                   body:body];
+    id touchProxyResponse = [self proxyForegroundTouchRequestIfNeededWithMethod:method
+                                                                     fullPath:fullPath
+                                                                         path:path
+                                                                         body:body];
     if (touchProxyResponse) {
         return touchProxyResponse;
     }
@@ -707,6 +848,11 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
             return [self handleKeyboardTypeRequest:body query:fullPath];
         }
         return [self errorResponse:405 message:@"Method Not Allowed"];
+    } else if ([path isEqualToString:@"/keyboard/type/status"]) {
+        if ([method isEqualToString:@"GET"]) {
+            return [self handleKeyboardTypeStatusRequest:fullPath];
+        }
+        return [self errorResponse:405 message:@"Method Not Allowed"];
     } else if ([path isEqualToString:@"/keyboard/key"]) {
         if ([method isEqualToString:@"POST"] || [method isEqualToString:@"GET"]) {
             return [self handleKeyboardKeyRequest:body query:fullPath];
@@ -722,6 +868,18 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
             return [self handleA11yInteractiveRequest:fullPath];
         }
         return [self errorResponse:405 message:@"Method Not Allowed"];
+    } else if ([path isEqualToString:@"/a11y/at"] ||
+               [path isEqualToString:@"/a11y/rect"] ||
+               [path isEqualToString:@"/a11y/nearest"]) {
+        if ([method isEqualToString:@"GET"]) {
+            return [self handleA11ySpatialRequest:path query:fullPath];
+        }
+        return [self errorResponse:405 message:@"Method Not Allowed"];
+    } else if ([path isEqualToString:@"/a11y/find"]) {
+        if ([method isEqualToString:@"GET"]) {
+            return [self handleA11yFindRequest:fullPath];
+        }
+        return [self errorResponse:405 message:@"Method Not Allowed"];
     } else if ([path isEqualToString:@"/a11y/overlay"]) {
         if ([method isEqualToString:@"POST"] || [method isEqualToString:@"GET"]) {
             return [self handleA11yOverlayRequest:body query:fullPath];
@@ -1027,13 +1185,14 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         return [self errorResponse:405 message:@"Method Not Allowed"];
     } else if ([path isEqualToString:@"/uiHierarchy"]) {
         if ([method isEqualToString:@"GET"]) {
-            __block NSDictionary *tree = nil;
-            if ([NSThread isMainThread]) {
-                tree = [AccessibilityTree getFullTree];
-            } else {
-                dispatch_sync(dispatch_get_main_queue(), ^{
-                    tree = [AccessibilityTree getFullTree];
-                });
+            NSDictionary *parameters = [self uiHierarchyParametersFromQuery:fullPath];
+            if (![self boolValueFromString:parameters[@"pretty"] defaultValue:NO]) {
+                return [self streamedUIHierarchyResponse:parameters];
+            }
+            NSString *errorResponse = nil;
+            NSDictionary *tree = [self uiHierarchyForParameters:parameters errorResponse:&errorResponse];
+            if (!tree) {
+                return errorResponse;
             }
 
             NSError *error = nil;
@@ -1244,6 +1403,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
 - (NSString *)handleTapRequest:(NSString *)body query:(NSString *)fullPath {
     CGFloat x = 0, y = 0;
     NSString *method = nil;
+    NSString *space = nil;
     
     // Try to parse from query string (GET request)
     if ([fullPath containsString:@"?"]) {
@@ -1252,6 +1412,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         x = [self floatValueFromQuery:queryString key:@"x"];
         y = [self floatValueFromQuery:queryString key:@"y"];
         method = [self stringValueFromQuery:queryString key:@"method"];
+        space = [self stringValueFromQuery:queryString key:@"space"];
     }
     
     // If no query params, try to parse from JSON body
@@ -1262,12 +1423,20 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         if ([json[@"method"] isKindOfClass:[NSString class]]) {
             method = json[@"method"];
         }
+        if ([json[@"space"] isKindOfClass:[NSString class]]) {
+            space = json[@"space"];
+        }
     }
     
     // Validate coordinates
     if (x <= 0 || y <= 0) {
         return [self errorResponse:400 message:@"Missing or invalid coordinates (x, y)"];
     }
+    if (space.length > 0) {
+        CGPoint point = [KimiRunTouchInjection pointFromInput:CGPointMake(x, y) space:space];
+        x = point.x;
+        y = point.y;
+    }
     
     NSLog(@"[KimiRunHTTPServer] Tap request: (%.1f, %.1f)", x, y);
     
@@ -1320,6 +1489,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     CGFloat x1 = 0, y1 = 0, x2 = 0, y2 = 0;
     NSTimeInterval duration = 0.3;  // Default 300ms
     NSString *method = nil;
+    NSString *space = nil;
     
     // Try to parse from query string (GET request)
     if ([path containsString:@"?"]) {
@@ -1331,6 +1501,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         y2 = [self floatValueFromQuery:queryString key:@"y2"];
         duration = [self floatValueFromQuery:queryString key:@"duration"];
         method = [self stringValueFromQuery:queryString key:@"method"];
+        space = [self stringValueFromQuery:queryString key:@"space"];
     }
     
     // If no query params, try to parse from JSON body
@@ -1346,12 +1517,23 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         if ([json[@"method"] isKindOfClass:[NSString class]]) {
             method = json[@"method"];
         }
+        if ([json[@"space"] isKindOfClass:[NSString class]]) {
+            space = json[@"space"];
+        }
     }
     
     // Validate coordinates
     if (x1 <= 0 || y1 <= 0 || x2 <= 0 || y2 <= 0) {
         return [self errorResponse:400 message:@"Missing or invalid coordinates (x1, y1, x2, y2)"];
     }
+    if (space.length > 0) {
+        CGPoint start = [KimiRunTouchInjection pointFromInput:CGPointMake(x1, y1) space:space];
+        CGPoint end = [KimiRunTouchInjection pointFromInput:CGPointMake(x2, y2) space:space];
+        x1 = start.x;
+        y1 = start.y;
+        x2 = end.x;
+        y2 = end.y;
+    }
     
     NSLog(@"[KimiRunHTTPServer] Swipe request: (%.1f, %.1f) -> (%.1f, %.1f) duration: %.2f",
           x1, y1, x2, y2, duration);
@@ -1408,6 +1590,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     CGFloat x1 = 0, y1 = 0, x2 = 0, y2 = 0;
     NSTimeInterval duration = 1.0;  // Default 1 second
     NSString *method = nil;
+    NSString *space = nil;
     
     // Try to parse from query string (GET request)
     if ([path containsString:@"?"]) {
@@ -1419,6 +1602,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         y2 = [self floatValueFromQuery:queryString key:@"y2"];
         duration = [self floatValueFromQuery:queryString key:@"duration"];
         method = [self stringValueFromQuery:queryString key:@"method"];
+        space = [self stringValueFromQuery:queryString key:@"space"];
     }
     
     // If no query params, try to parse from JSON body
@@ -1434,12 +1618,23 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         if ([json[@"method"] isKindOfClass:[NSString class]]) {
             method = json[@"method"];
         }
+        if ([json[@"space"] isKindOfClass:[NSString class]]) {
+            space = json[@"space"];
+        }
     }
     
     // Validate coordinates
     if (x1 <= 0 || y1 <= 0 || x2 <= 0 || y2 <= 0) {
         return [self errorResponse:400 message:@"Missing or invalid coordinates (x1, y1, x2, y2)"];
     }
+    if (space.length > 0) {
+        CGPoint start = [KimiRunTouchInjection pointFromInput:CGPointMake(x1, y1) space:space];
+        CGPoint end = [KimiRunTouchInjection pointFromInput:CGPointMake(x2, y2) space:space];
+        x1 = start.x;
+        y1 = start.y;
+        x2 = end.x;
+        y2 = end.y;
+    }
     
     NSLog(@"[KimiRunHTTPServer] Drag request: (%.1f, %.1f) -> (%.1f, %.1f) duration: %.2f",
           x1, y1, x2, y2, duration);
@@ -1494,6 +1689,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     CGFloat x = 0, y = 0;
     NSTimeInterval duration = 1.0;  // Default 1 second
     NSString *method = nil;
+    NSString *space = nil;
     
     // Try to parse from query string (GET request)
     if ([path containsString:@"?"]) {
@@ -1503,6 +1699,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         y = [self floatValueFromQuery:queryString key:@"y"];
         duration = [self floatValueFromQuery:queryString key:@"duration"];
         method = [self stringValueFromQuery:queryString key:@"method"];
+        space = [self stringValueFromQuery:queryString key:@"space"];
     }
     
     // If no query params, try to parse from JSON body
@@ -1516,12 +1713,20 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         if ([json[@"method"] isKindOfClass:[NSString class]]) {
             method = json[@"method"];
         }
+        if ([json[@"space"] isKindOfClass:[NSString class]]) {
+            space = json[@"space"];
+        }
     }
     
     // Validate coordinates
     if (x <= 0 || y <= 0) {
         return [self errorResponse:400 message:@"Missing or invalid coordinates (x, y)"];
     }
+    if (space.length > 0) {
+        CGPoint point = [KimiRunTouchInjection pointFromInput:CGPointMake(x, y) space:space];
+        x = point.x;
+        y = point.y;
+    }
     
     NSLog(@"[KimiRunHTTPServer] Long press request: (%.1f, %.1f) duration: %.2f", x, y, duration);
     
@@ -1570,18 +1775,19 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
 }
 
 - (NSString *)handleSenderIDRequest {
-    uint64_t senderID = [KimiRunTouchInjection senderID];
-    BOOL captured = [KimiRunTouchInjection senderIDCaptured];
+    NSDictionary *state = [KimiRunTouchInjection senderIDState];
+    uint64_t senderID = [state[@"senderID"] unsignedLongLongValue];
+    BOOL captured = [state[@"captured"] boolValue];
     BOOL fallback = [KimiRunTouchInjection senderIDFallbackEnabled];
-    int callbackCount = [KimiRunTouchInjection senderIDCallbackCount];
+    int callbackCount = [state[@"callbackCount"] intValue];
     BOOL threadRunning = [KimiRunTouchInjection senderIDCaptureThreadRunning];
-    int digitizerCount = [KimiRunTouchInjection senderIDDigitizerCount];
-    int lastEventType = [KimiRunTouchInjection senderIDLastEventType];
+    int digitizerCount = [state[@"digitizerCount"] intValue];
+    int lastEventType = [state[@"lastEventType"] intValue];
     BOOL mainRegistered = [KimiRunTouchInjection senderIDMainRegistered];
     BOOL dispatchRegistered = [KimiRunTouchInjection senderIDDispatchRegistered];
     uintptr_t hidConn = [KimiRunTouchInjection hidConnectionPtr];
     int adminClientType = [KimiRunTouchInjection adminClientType];
-    NSString *source = [KimiRunTouchInjection senderIDSourceString];
+    NSString *source = state[@"source"] ?: @"none";
     NSString *json = [NSString stringWithFormat:
                       @"{\"status\":\"ok\",\"senderID\":\"0x%llX\",\"captured\":%s,\"fallbackEnabled\":%s,\"callbackCount\":%d,\"digitizerCount\":%d,\"lastEventType\":%d,\"threadRunning\":%s,\"mainRegistered\":%s,\"dispatchRegistered\":%s,\"hidConnection\":\"0x%lX\",\"adminClientType\":%d,\"source\":\"%@\"}",
                       senderID,
@@ -1605,6 +1811,12 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     payload[@"status"] = @"ok";
     payload[@"process"] = @"SpringBoard";
     payload[@"port"] = @(self.port);
+    payload[@"bksDispatch"] = @{
+        @"last": [KimiRunTouchInjection lastBKSDispatchInfoIncludingRouteDetail:YES] ?: @{},
+        @"history": [KimiRunTouchInjection recentBKSDispatchHistory:16] ?: @[],
+    };
+    payload[@"strategy"] = [KimiRunTouchInjection strategyStats:32];
+    payload[@"socketServer"] = [[SocketTouchServer sharedServer] statistics];
 
     NSError *err = nil;
     NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&err];
@@ -1694,35 +1906,124 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
 
 - (NSString *)handleKeyboardTypeRequest:(NSString *)body query:(NSString *)fullPath {
     NSString *text = nil;
+    NSMutableDictionary *options = [NSMutableDictionary dictionary];
+    BOOL async = NO;
     if ([fullPath containsString:@"?"]) {
         NSRange queryRange = [fullPath rangeOfString:@"?"];
         NSString *queryString = [fullPath substringFromIndex:queryRange.location + 1];
         text = [self stringValueFromQuery:queryString key:@"text"];
+        async = [[self stringValueFromQuery:queryString key:@"async"] boolValue];
+        NSString *holdStr = [self stringValueFromQuery:queryString key:@"holdMS"];
+        NSString *intervalStr = [self stringValueFromQuery:queryString key:@"intervalMS"];
+        NSString *modeStr = [self stringValueFromQuery:queryString key:@"mode"];
+        if (holdStr.length > 0) {
+            options[@"holdMS"] = @([holdStr integerValue]);
+        }
+        if (intervalStr.length > 0) {
+            options[@"intervalMS"] = @([intervalStr integerValue]);
+        }
+        if (modeStr.length > 0) {
+            options[@"mode"] = [modeStr lowercaseString];
+        }
     }
-    if ((!text || text.length == 0) && body && body.length > 0) {
+    if (body && body.length > 0) {
         NSDictionary *json = [self parseJSON:body];
-        if ([json[@"text"] isKindOfClass:[NSString class]]) {
+        if ((!text || text.length == 0) && [json[@"text"] isKindOfClass:[NSString class]]) {
             text = json[@"text"];
         }
+        if ([json[@"async"] respondsToSelector:@selector(boolValue)]) {
+            async = async || [json[@"async"] boolValue];
+        }
+        for (NSString *key in @[@"holdMS", @"intervalMS"]) {
+            if ([json[key] isKindOfClass:[NSNumber class]]) {
+                options[key] = json[key];
+            }
+        }
+        if (!options[@"mode"] && [json[@"mode"] isKindOfClass:[NSString class]]) {
+            options[@"mode"] = [json[@"mode"] lowercaseString];
+        }
     }
     if (!text || text.length == 0) {
         return [self errorResponse:400 message:@"Missing text"];
     }
 
-    __block BOOL success = NO;
-    if ([NSThread isMainThread]) {
-        success = [KimiRunTouchInjection typeText:text];
-    } else {
-        dispatch_sync(dispatch_get_main_queue(), ^{
-            success = [KimiRunTouchInjection typeText:text];
-        });
+    if (async) {
+        NSString *jobID = [KimiRunTouchInjection typeTextAsync:text options:options];
+        if (jobID.length == 0) {
+            return [self errorResponse:500 message:@"Failed to start typing job"];
+        }
+        NSString *json = [NSString stringWithFormat:
+                          @"{\"status\":\"ok\",\"action\":\"type\",\"async\":true,\"jobID\":\"%@\",\"length\":%lu}",
+                          jobID, (unsigned long)text.length];
+        return [self jsonResponse:200 body:json];
     }
 
-    if (success) {
-        NSString *json = [NSString stringWithFormat:@"{\"status\":\"ok\",\"action\":\"type\",\"text\":\"%@\"}", text];
-        return [self jsonResponse:200 body:json];
+    // We are on SpringBoard's main thread: the bulk insert is one call, but
+    // HID key playback is queued so the UI never stalls on it. A queued job
+    // is not a success yet: it goes back as 202 with its jobID to poll.
+    NSString *mode = options[@"mode"] ?: @"auto";
+    NSMutableDictionary *payload = [NSMutableDictionary dictionary];
+    BOOL success = NO;
+    BOOL queued = NO;
+    if (![mode isEqualToString:@"hid"]) {
+        NSDictionary *insert = [KimiRunTouchInjection insertTextIntoFocusedInput:text];
+        [payload addEntriesFromDictionary:insert ?: @{}];
+        success = [insert[@"success"] boolValue];
+    }
+    if (!success && ![mode isEqualToString:@"insert"]) {
+        NSMutableDictionary *hidOptions = [options mutableCopy];
+        hidOptions[@"mode"] = @"hid";
+        NSString *jobID = [KimiRunTouchInjection typeTextAsync:text options:hidOptions];
+        queued = (jobID.length > 0);
+        payload[@"path"] = @"hid";
+        payload[@"fallback"] = @(![mode isEqualToString:@"hid"]);
+        if (queued) {
+            payload[@"jobID"] = jobID;
+            payload[@"state"] = @"queued";
+        }
+    }
+    payload[@"status"] = (success || queued) ? @"ok" : @"error";
+    payload[@"action"] = @"type";
+    payload[@"mode"] = mode;
+    payload[@"text"] = text;
+    payload[@"success"] = @(success);
+    if (!success && !queued) {
+        payload[@"message"] = @"Failed to type text";
+    }
+    NSInteger statusCode = success ? 200 : (queued ? 202 : 500);
+
+    NSError *err = nil;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&err];
+    if (jsonData.length > 0 && !err) {
+        return [self jsonResponse:statusCode
+                             body:[[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding]];
     }
-    return [self errorResponse:500 message:@"Failed to type text"];
+    return (success || queued) ? [self jsonResponse:statusCode body:@"{\"status\":\"ok\",\"action\":\"type\"}"]
+                               : [self errorResponse:500 message:@"Failed to type text"];
+}
+
+- (NSString *)handleKeyboardTypeStatusRequest:(NSString *)fullPath {
+    NSString *jobID = nil;
+    if ([fullPath containsString:@"?"]) {
+        NSRange queryRange = [fullPath rangeOfString:@"?"];
+        NSString *queryString = [fullPath substringFromIndex:queryRange.location + 1];
+        jobID = [self stringValueFromQuery:queryString key:@"id"];
+    }
+    if (!jobID || jobID.length == 0) {
+        return [self errorResponse:400 message:@"Missing id"];
+    }
+    NSDictionary *job = [KimiRunTouchInjection typingJobStatus:jobID];
+    if (!job) {
+        return [self errorResponse:404 message:@"Unknown typing job"];
+    }
+    NSMutableDictionary *payload = [NSMutableDictionary dictionaryWithDictionary:job];
+    payload[@"status"] = @"ok";
+    NSError *err = nil;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&err];
+    if (jsonData.length > 0 && !err) {
+        return [self jsonResponse:200 body:[[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding]];
+    }
+    return [self errorResponse:500 message:@"Failed to encode typing job"];
 }
 
 - (NSString *)handleKeyboardKeyRequest:(NSString *)body query:(NSString *)fullPath {
@@ -1848,14 +2149,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         }
     }
 
-    __block NSDictionary *tree = nil;
-    if ([NSThread isMainThread]) {
-        tree = [AccessibilityTree getFullTree];
-    } else {
-        dispatch_sync(dispatch_get_main_queue(), ^{
-            tree = [AccessibilityTree getFullTree];
-        });
-    }
+    NSDictionary *tree = [AccessibilityTree getFullTree];
 
     NSError *error = nil;
     NSData *jsonData = [NSJSONSerialization dataWithJSONObject:(tree ?: @{})
@@ -1865,15 +2159,19 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     return [self jsonResponse:200 body:(json ?: @"{}")];
 }
 
-- (NSString *)handleA11yInteractiveRequest:(NSString *)fullPath {
+- (id)handleA11yInteractiveRequest:(NSString *)fullPath {
     BOOL pretty = YES;
     NSInteger limit = 0;
+    NSString *sinceStr = nil;
+    NSString *format = nil;
     if ([fullPath containsString:@"?"]) {
         NSRange queryRange = [fullPath rangeOfString:@"?"];
         NSString *queryString = [fullPath substringFromIndex:queryRange.location + 1];
         NSString *compactStr = [self stringValueFromQuery:queryString key:@"compact"];
         NSString *prettyStr = [self stringValueFromQuery:queryString key:@"pretty"];
         NSString *limitStr = [self stringValueFromQuery:queryString key:@"limit"];
+        sinceStr = [self stringValueFromQuery:queryString key:@"since"];
+        format = [self stringValueFromQuery:queryString key:@"format"].lowercaseString;
         if (compactStr && [self boolValueFromString:compactStr defaultValue:NO]) {
             pretty = NO;
         }
@@ -1885,19 +2183,40 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         }
     }
 
-    __block NSArray *elements = nil;
-    if ([NSThread isMainThread]) {
-        elements = [AccessibilityTree getInteractiveElements];
-    } else {
-        dispatch_sync(dispatch_get_main_queue(), ^{
-            elements = [AccessibilityTree getInteractiveElements];
-        });
+    // ?since=N switches to the versioned envelope; limit and format do not apply.
+    if (sinceStr) {
+        uint64_t since = strtoull(sinceStr.UTF8String, NULL, 10);
+        NSDictionary *delta = [AccessibilityTree getInteractiveElementsSince:since];
+        NSError *error = nil;
+        NSData *jsonData = [NSJSONSerialization dataWithJSONObject:(delta ?: @{})
+                                                           options:(pretty ? NSJSONWritingPrettyPrinted : 0)
+                                                             error:&error];
+        NSString *json = error ? nil : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+        if (!json) {
+            return [self jsonResponse:500 body:@"{\"success\":false,\"error\":\"Failed to encode snapshot\"}"];
+        }
+        return [self jsonResponse:200 body:json];
     }
 
+    NSArray *elements = [AccessibilityTree getInteractiveElements];
+
     if (limit > 0 && elements.count > (NSUInteger)limit) {
         elements = [elements subarrayWithRange:NSMakeRange(0, (NSUInteger)limit)];
     }
 
+    // ?format=min|columnar|msgpack picks a compact encoding; the default
+    // stays the row JSON below.
+    if (format.length > 0 && ![format isEqualToString:@"json"]) {
+        NSString *contentType = nil;
+        NSData *encoded = [AccessibilityTree encodeInteractiveElements:(elements ?: @[])
+                                                                format:format
+                                                           contentType:&contentType];
+        if (!encoded) {
+            return [self jsonResponse:400 body:@"{\"success\":false,\"error\":\"Unknown format (json, min, columnar, msgpack)\"}"];
+        }
+        return [self binaryResponse:200 contentType:contentType body:encoded];
+    }
+
     NSError *error = nil;
     NSData *jsonData = [NSJSONSerialization dataWithJSONObject:(elements ?: @[])
                                                        options:(pretty ? NSJSONWritingPrettyPrinted : 0)
@@ -1906,6 +2225,201 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     return [self jsonResponse:200 body:(json ?: @"[]")];
 }
 
+// /a11y/at?x=&y=              elements containing the point, innermost first
+// /a11y/rect?x=&y=&width=&height=[&contained=1]
+// /a11y/nearest?x=&y=[&maxDistance=]   nearest enabled, visible element
+- (NSString *)handleA11ySpatialRequest:(NSString *)path query:(NSString *)fullPath {
+    NSString *queryString = @"";
+    NSRange queryRange = [fullPath rangeOfString:@"?"];
+    if (queryRange.location != NSNotFound) {
+        queryString = [fullPath substringFromIndex:queryRange.location + 1];
+    }
+    NSString *xStr = [self stringValueFromQuery:queryString key:@"x"];
+    NSString *yStr = [self stringValueFromQuery:queryString key:@"y"];
+    if (!xStr || !yStr) {
+        return [self jsonResponse:400 body:@"{\"success\":false,\"error\":\"Missing x or y\"}"];
+    }
+    CGPoint point = CGPointMake([xStr doubleValue], [yStr doubleValue]);
+
+    NSDictionary *payload = nil;
+    if ([path isEqualToString:@"/a11y/nearest"]) {
+        NSString *maxStr = [self stringValueFromQuery:queryString key:@"maxDistance"];
+        CGFloat distance = 0;
+        NSDictionary *element = [AccessibilityTree nearestActionableElementToPoint:point
+                                                                       maxDistance:(maxStr ? [maxStr doubleValue] : -1)
+                                                                          distance:&distance];
+        payload = element
+            ? @{@"success": @YES, @"found": @YES, @"distance": @(distance), @"element": element}
+            : @{@"success": @YES, @"found": @NO};
+    } else {
+        NSArray *elements = nil;
+        if ([path isEqualToString:@"/a11y/rect"]) {
+            CGRect rect = CGRectMake(point.x, point.y,
+                                     [[self stringValueFromQuery:queryString key:@"width"] doubleValue],
+                                     [[self stringValueFromQuery:queryString key:@"height"] doubleValue]);
+            BOOL contained = [self boolValueFromString:[self stringValueFromQuery:queryString key:@"contained"]
+                                          defaultValue:NO];
+            elements = [AccessibilityTree interactiveElementsInRect:rect contained:contained];
+        } else {
+            elements = [AccessibilityTree interactiveElementsAtPoint:point];
+        }
+        payload = @{@"success": @YES, @"count": @(elements.count), @"elements": elements ?: @[]};
+    }
+
+    NSError *error = nil;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&error];
+    NSString *json = error ? nil : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+    if (!json) {
+        return [self jsonResponse:500 body:@"{\"success\":false,\"error\":\"Failed to encode elements\"}"];
+    }
+    return [self jsonResponse:200 body:json];
+}
+
+static bool KimiRunHTTPChunkFlush(void *context, const char *bytes, size_t length) {
+    KimiRunHTTPChunkSink sink = (__bridge KimiRunHTTPChunkSink)context;
+    return sink(bytes, length);
+}
+
+// /uiHierarchy[?rootIdentifier=|rootLabel=|rootPath=][&maxDepth=][&fields=a,b][&interactiveOnly=1][&pretty=1]
+// Decoded values of the parameters present.
+- (NSDictionary<NSString *, NSString *> *)uiHierarchyParametersFromQuery:(NSString *)fullPath {
+    NSString *queryString = @"";
+    NSRange queryRange = [fullPath rangeOfString:@"?"];
+    if (queryRange.location != NSNotFound) {
+        queryString = [fullPath substringFromIndex:queryRange.location + 1];
+    }
+    NSMutableDictionary<NSString *, NSString *> *parameters = [NSMutableDictionary dictionary];
+    for (NSString *key in @[@"rootIdentifier", @"rootLabel", @"rootPath", @"fields", @"maxDepth", @"interactiveOnly", @"pretty"]) {
+        NSString *raw = [self stringValueFromQuery:queryString key:key];
+        if (raw) {
+            parameters[key] = [[raw stringByReplacingOccurrencesOfString:@"+" withString:@" "] stringByRemovingPercentEncoding] ?: raw;
+        }
+    }
+    return parameters;
+}
+
+// Without a selector, depth, fields or interactiveOnly, the cached full tree.
+- (NSDictionary *)uiHierarchyForParameters:(NSDictionary<NSString *, NSString *> *)parameters
+                             errorResponse:(NSString **)errorResponse {
+    NSString *maxDepthStr = parameters[@"maxDepth"];
+    NSString *interactiveStr = parameters[@"interactiveOnly"];
+    if (!parameters[@"rootIdentifier"] && !parameters[@"rootLabel"] && !parameters[@"rootPath"] &&
+        !parameters[@"fields"] && !maxDepthStr && !interactiveStr) {
+        return [AccessibilityTree getFullTree];
+    }
+
+    NSError *error = nil;
+    NSDictionary *tree = [AccessibilityTree getTreeWithRootIdentifier:parameters[@"rootIdentifier"]
+                                                            rootLabel:parameters[@"rootLabel"]
+                                                             rootPath:parameters[@"rootPath"]
+                                                             maxDepth:(maxDepthStr.length > 0 ? [maxDepthStr integerValue] : -1)
+                                                               fields:parameters[@"fields"]
+                                                      interactiveOnly:[self boolValueFromString:interactiveStr defaultValue:NO]
+                                                                error:&error];
+    if (!tree && errorResponse) {
+        *errorResponse = [self errorResponse:(error.code ?: 500)
+                                     message:(error.localizedDescription ?: @"Failed to build UI hierarchy")];
+    }
+    return tree;
+}
+
+// The tree is written into the response as the views are walked; memory
+// stays at one stream buffer plus a few batches of nodes whatever the tree
+// size. writeBody runs on the stream queue: main captures the batches and
+// this side builds and writes them.
+- (KimiRunHTTPStreamedResponse *)streamedUIHierarchyResponse:(NSDictionary<NSString *, NSString *> *)parameters {
+    KimiRunHTTPStreamedResponse *response = [[KimiRunHTTPStreamedResponse alloc] init];
+    response.statusCode = 200;
+    response.contentType = @"application/json";
+    response.writeBody = ^id(KimiRunHTTPChunkSink sink) {
+        char buffer[HTTP_STREAM_BUFFER_SIZE];
+        KimiRunA11yJSONStream json;
+        KimiRunA11yJSONStreamInit(&json, buffer, sizeof(buffer), KimiRunHTTPChunkFlush, (__bridge void *)sink);
+        KimiRunA11yJSONBeginObject(&json);
+        KimiRunA11yJSONKey(&json, "success");
+        KimiRunA11yJSONBool(&json, true);
+        KimiRunA11yJSONKey(&json, "data");
+
+        NSString *maxDepthStr = parameters[@"maxDepth"];
+        NSString *interactiveStr = parameters[@"interactiveOnly"];
+        NSError *error = nil;
+        BOOL written;
+        if (!parameters[@"rootIdentifier"] && !parameters[@"rootLabel"] && !parameters[@"rootPath"] &&
+            !parameters[@"fields"] && !maxDepthStr && !interactiveStr) {
+            written = [AccessibilityTree writeFullTreeToJSON:&json];
+        } else {
+            written = [AccessibilityTree writeTreeWithRootIdentifier:parameters[@"rootIdentifier"]
+                                                           rootLabel:parameters[@"rootLabel"]
+                                                            rootPath:parameters[@"rootPath"]
+                                                            maxDepth:(maxDepthStr.length > 0 ? [maxDepthStr integerValue] : -1)
+                                                              fields:parameters[@"fields"]
+                                                     interactiveOnly:[self boolValueFromString:interactiveStr defaultValue:NO]
+                                                              toJSON:&json
+                                                               error:&error];
+        }
+        if (written) {
+            KimiRunA11yJSONEndObject(&json);
+            written = KimiRunA11yJSONFlush(&json);
+        }
+        if (!written) {
+            return [self errorResponse:(error.code ?: 500)
+                               message:(error.localizedDescription ?: @"Failed to build UI hierarchy")];
+        }
+        return nil;
+    };
+    return response;
+}
+
+// /a11y/find?label=|identifier=|q=[&fuzzy=1][&limit=10]
+// Ranked matches only, so callers no longer pull the whole element list to
+// look for one label. q= searches both fields. The key may repeat
+// (label=A&label=B): every query runs against one collection and the
+// response carries one {query, count, matches} entry per query.
+- (NSString *)handleA11yFindRequest:(NSString *)fullPath {
+    NSString *queryString = @"";
+    NSRange queryRange = [fullPath rangeOfString:@"?"];
+    if (queryRange.location != NSNotFound) {
+        queryString = [fullPath substringFromIndex:queryRange.location + 1];
+    }
+    BOOL inLabel = YES;
+    BOOL inIdentifier = YES;
+    NSArray<NSString *> *raws = [self stringValuesFromQuery:queryString key:@"label"];
+    if (raws.count > 0) {
+        inIdentifier = NO;
+    } else if ((raws = [self stringValuesFromQuery:queryString key:@"identifier"]).count > 0) {
+        inLabel = NO;
+    } else {
+        raws = [self stringValuesFromQuery:queryString key:@"q"];
+    }
+    NSMutableArray<NSString *> *queries = [NSMutableArray arrayWithCapacity:raws.count];
+    for (NSString *raw in raws) {
+        NSString *query = [[raw stringByReplacingOccurrencesOfString:@"+" withString:@" "] stringByRemovingPercentEncoding] ?: raw;
+        if (query.length > 0) {
+            [queries addObject:query];
+        }
+    }
+    if (queries.count == 0) {
+        return [self jsonResponse:400 body:@"{\"success\":false,\"error\":\"Missing label, identifier or q\"}"];
+    }
+    BOOL fuzzy = [self boolValueFromString:[self stringValueFromQuery:queryString key:@"fuzzy"] defaultValue:NO];
+    NSString *limitStr = [self stringValueFromQuery:queryString key:@"limit"];
+    NSInteger limit = limitStr ? [limitStr integerValue] : 10;
+
+    NSArray<NSArray *> *perQuery = [AccessibilityTree findElementsMatchingQueries:queries
+                                                                          inLabel:inLabel
+                                                                     inIdentifier:inIdentifier
+                                                                            fuzzy:fuzzy
+                                                                            limit:(NSUInteger)MAX(limit, 0)];
+    NSDictionary *payload = KimiRunA11yFindPayload(queries, perQuery);
+    NSError *error = nil;
+    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&error];
+    NSString *json = error ? nil : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+    if (!json) {
+        return [self jsonResponse:500 body:@"{\"success\":false,\"error\":\"Failed to encode matches\"}"];
+    }
+    return [self jsonResponse:200 body:json];
+}
+
 - (NSString *)handleA11yOverlayRequest:(NSString *)body query:(NSString *)fullPath {
     NSString *enabledStr = nil;
     NSString *interactiveStr = nil;
@@ -2049,6 +2563,19 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     return value.length ? value : nil;
 }
 
+// Every value of a repeated key, undecoded like stringValueFromQuery:.
+// Keys are compared whole, so label= does not pick up rootLabel=.
+- (NSArray<NSString *> *)stringValuesFromQuery:(NSString *)query key:(NSString *)key {
+    NSMutableArray<NSString *> *values = [NSMutableArray array];
+    NSString *prefix = [key stringByAppendingString:@"="];
+    for (NSString *pair in [query componentsSeparatedByString:@"&"]) {
+        if ([pair hasPrefix:prefix] && pair.length > prefix.length) {
+            [values addObject:[pair substringFromIndex:prefix.length]];
+        }
+    }
+    return values;
+}
+
 - (BOOL)boolValueFromString:(NSString *)value defaultValue:(BOOL)defaultValue {
     if (!value || value.length == 0) {
         return defaultValue;
@@ -2146,6 +2673,46 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     ];
 }
 
+- (NSData *)binaryResponse:(NSInteger)statusCode contentType:(NSString *)contentType body:(NSData *)body {
+    NSString *header = [NSString stringWithFormat:
+        @"HTTP/1.1 %ld %@\r\n"
+        @"Content-Type: %@\r\n"
+        @"Content-Length: %lu\r\n"
+        @"Connection: close\r\n"
+        @"\r\n",
+        (long)statusCode, [self statusTextForCode:statusCode],
+        contentType ?: @"application/octet-stream",
+        (unsigned long)(body ? body.length : 0)
+    ];
+    NSMutableData *data = [[header dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+    if (body.length > 0) {
+        [data appendData:body];
+    }
+    return data;
+}
+
+- (BOOL)isBinaryHTTPResponse:(NSData *)response {
+    NSData *separator = [@"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+    NSRange headerEnd = [response rangeOfData:separator options:0 range:NSMakeRange(0, response.length)];
+    if (headerEnd.location == NSNotFound) {
+        return NO;
+    }
+    NSString *header = [[NSString alloc] initWithData:[response subdataWithRange:NSMakeRange(0, headerEnd.location)]
+                                             encoding:NSUTF8StringEncoding];
+    return [header hasPrefix:@"HTTP/1.1 "];
+}
+
+- (BOOL)isChunkedHTTPResponse:(NSData *)response {
+    NSData *separator = [@"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding];
+    NSRange headerEnd = [response rangeOfData:separator options:0 range:NSMakeRange(0, response.length)];
+    if (headerEnd.location == NSNotFound) {
+        return NO;
+    }
+    NSString *header = [[NSString alloc] initWithData:[response subdataWithRange:NSMakeRange(0, headerEnd.location)]
+                                             encoding:NSUTF8StringEncoding];
+    return [header.lowercaseString containsString:@"\r\ntransfer-encoding: chunked"];
+}
+
 - (NSString *)errorResponse:(NSInteger)statusCode message:(NSString *)message {
     NSString *json = [NSString stringWithFormat:@"{\"status\":\"error\",\"message\":\"%@\"}", message];
     return [self jsonResponse:statusCode body:json];
@@ -2154,6 +2721,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
 - (NSString *)statusTextForCode:(NSInteger)code {
     switch (code) {
         case 200: return @"OK";
+        case 202: return @"Accepted";
         case 400: return @"Bad Request";
         case 404: return @"Not Found";
         case 405: return @"Method Not Allowed";
@@ -2171,6 +2739,10 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         [path isEqualToString:@"/screenshot/file"] ||
         [path isEqualToString:@"/a11y/tree"] ||
         [path isEqualToString:@"/a11y/interactive"] ||
+        [path isEqualToString:@"/a11y/at"] ||
+        [path isEqualToString:@"/a11y/rect"] ||
+        [path isEqualToString:@"/a11y/nearest"] ||
+        [path isEqualToString:@"/a11y/find"] ||
         [path isEqualToString:@"/a11y/debug"] ||
         [path isEqualToString:@"/a11y/activate"] ||
         [path isEqualToString:@"/a11y/overlay"]) {
@@ -2221,7 +2793,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     return NO;
 }
 
-- (NSString *)proxyForegroundTouchRequestIfNeededWithMethod:(NSString *)method
+- (id)proxyForegroundTouchRequestIfNeededWithMethod:(NSString *)method
                                                    fullPath:(NSString *)fullPath
                                                        path:(NSString *)path
                                                        body:(NSString *)body {
@@ -2252,7 +2824,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
 
     for (NSNumber *candidate in candidates) {
         NSUInteger port = candidate.unsignedIntegerValue;
-        NSString *fallbackResponse = [self proxyRequestToLocalPort:port method:method fullPath:fullPath body:body];
+        id fallbackResponse = [self proxyRequestToLocalPort:port method:method fullPath:fullPath body:body];
         if (fallbackResponse) {
             sLastGoodTouchPort = port;
             NSLog(@"[KimiRunHTTPServer] Foreground touch proxy -> :%lu for %@ method=%@",
@@ -2263,7 +2835,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     return nil;
 }
 
-- (NSString *)proxyForegroundCaptureRequestIfNeededWithMethod:(NSString *)method
+- (id)proxyForegroundCaptureRequestIfNeededWithMethod:(NSString *)method
                                                      fullPath:(NSString *)fullPath
                                                          path:(NSString *)path
                                                          body:(NSString *)body {
@@ -2293,7 +2865,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
 
     for (NSNumber *candidate in candidates) {
         NSUInteger port = candidate.unsignedIntegerValue;
-        NSString *fallbackResponse = [self proxyRequestToLocalPort:port method:method fullPath:fullPath body:body];
+        id fallbackResponse = [self proxyRequestToLocalPort:port method:method fullPath:fullPath body:body];
         if (fallbackResponse) {
             sLastGoodCapturePort = port;
             NSLog(@"[KimiRunHTTPServer] Foreground capture fallback -> :%lu for %@",
@@ -2305,7 +2877,7 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
     return nil;
 }
 
-- (NSString *)proxyRequestToLocalPort:(NSUInteger)port
+- (id)proxyRequestToLocalPort:(NSUInteger)port
                                method:(NSString *)method
                              fullPath:(NSString *)fullPath
                                  body:(NSString *)body {
@@ -2377,7 +2949,15 @@ static NSArray *KimiRunListApplications(BOOL includeSystem) {
         return nil;
     }
 
+    if ([self isChunkedHTTPResponse:responseData]) {
+        // Streamed bodies (/uiHierarchy) are forwarded with their framing.
+        return responseData;
+    }
     NSString *rawResponse = [[NSString alloc] initWithData:responseData encoding:NSUTF8StringEncoding];
+    if (!rawResponse && [self isBinaryHTTPResponse:responseData]) {
+        // Binary bodies (format=msgpack) are forwarded byte for byte.
+        return responseData;
+    }
     if (rawResponse.length == 0) {
         return nil;
     }
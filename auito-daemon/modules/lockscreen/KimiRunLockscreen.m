@@ -5,6 +5,7 @@
 
 #import "KimiRunLockscreen.h"
 #import <UIKit/UIKit.h>
+#import "../prefs/KimiRunPrefs.h"
 #import <objc/message.h>
 
 @interface SBLockScreenDisableAssertion : NSObject
@@ -22,16 +23,6 @@
 static SBLockScreenDisableAssertion *g_lockScreenAssertion = nil;
 static dispatch_source_t g_unlockTimer = nil;
 
-static NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
-
-static void KimiRunLockscreenPrefsChanged(__unused CFNotificationCenterRef center,
-                                          __unused void *observer,
-                                          __unused CFStringRef name,
-                                          __unused const void *object,
-                                          __unused CFDictionaryRef userInfo) {
-    [KimiRunLockscreen applyLockscreenState];
-}
-
 static BOOL KimiRunIsSpringBoard(void) {
     return [[[NSBundle mainBundle] bundleIdentifier] isEqualToString:@"com.apple.springboard"];
 }
@@ -49,18 +40,9 @@ static BOOL KimiRunIsUIApplicationReady(void) {
     return YES;
 }
 
-static BOOL KimiRunPrefBool(NSString *key, BOOL defaultValue) {
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs objectForKey:key];
-    if (!value) {
-        return defaultValue;
-    }
-    return [prefs boolForKey:key];
-}
-
 static BOOL KimiRunDisableLockscreenEnabled(void) {
-    BOOL enabled = KimiRunPrefBool(@"DisableLockScreen", YES);
-    const char *env = getenv("KIMIRUN_DISABLE_LOCKSCREEN");
+    BOOL enabled = KimiRunPrefsBool(@"DisableLockScreen", YES);
+    const char *env = KimiRunPrefsEnv("KIMIRUN_DISABLE_LOCKSCREEN");
     if (env && env[0] != '\0') {
         enabled = (env[0] == '1');
     }
@@ -207,14 +189,20 @@ static void KimiRunAttemptUnlockIfNeeded(id manager) {
     if (!KimiRunIsSpringBoard()) {
         return;
     }
-    CFNotificationCenterAddObserver(
-        CFNotificationCenterGetDarwinNotifyCenter(),
-        NULL,
-        (CFNotificationCallback)KimiRunLockscreenPrefsChanged,
-        CFSTR("com.auito.daemon/prefsChanged"),
-        NULL,
-        CFNotificationSuspensionBehaviorDeliverImmediately
-    );
+    // The shared prefs snapshot owns the Darwin observer and republishes
+    // before this fires, so the apply pass reads fresh values.
+    static id observerToken = nil;
+    if (observerToken) {
+        return;
+    }
+    (void)KimiRunPrefsCurrentSnapshot();
+    observerToken = [[NSNotificationCenter defaultCenter]
+        addObserverForName:KimiRunPrefsDidChangeNotification
+                    object:nil
+                     queue:[NSOperationQueue mainQueue]
+                usingBlock:^(__unused NSNotification *note) {
+        [KimiRunLockscreen applyLockscreenState];
+    }];
     NSLog(@"[KimiRunLockscreen] Registered preference change observer");
 }
 
@@ -0,0 +1,361 @@
+//
+//  KimiRunLogRing.c
+//  KimiRun - Asynchronous Log Pipeline
+//
+//  Bounded MPSC ring using per-slot sequence numbers: a producer claims a
+//  position with one CAS on the enqueue cursor, fills the slot and then
+//  publishes it by storing position + 1 into the slot sequence. The writer
+//  consumes slots in order and hands them back by storing
+//  position + capacity.
+//
+//  An idle writer parks on a condition variable instead of polling. It
+//  raises g_logWriterParked before its last look at the ring; the producer
+//  that publishes the first record after that clears the flag and signals,
+//  so only the empty -> non-empty transition takes the mutex.
+//
+
+#include "KimiRunLogRing.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define KIMIRUN_LOG_RING_MASK ((uint64_t)KIMIRUN_LOG_RING_CAPACITY - 1)
+#define KIMIRUN_LOG_BATCH_BYTES (64 * 1024)
+#define KIMIRUN_LOG_LINE_MAX (KIMIRUN_LOG_PAYLOAD_MAX + 96)
+#define KIMIRUN_LOG_PATH_MAX 1024
+
+_Static_assert((KIMIRUN_LOG_RING_CAPACITY & (KIMIRUN_LOG_RING_CAPACITY - 1)) == 0,
+               "log ring capacity must be a power of two");
+
+typedef struct {
+    _Atomic uint64_t sequence;
+    KimiRunLogRecord record;
+} KimiRunLogSlot;
+
+static KimiRunLogSlot g_logSlots[KIMIRUN_LOG_RING_CAPACITY];
+static _Atomic uint64_t g_logEnqueuePos = 0;
+static uint64_t g_logDequeuePos = 0;           // writer thread only
+static _Atomic uint64_t g_logWrittenPos = 0;
+static _Atomic uint64_t g_logDropped = 0;
+static _Atomic uint64_t g_logBytesWritten = 0;
+static _Atomic uint64_t g_logRotations = 0;
+static _Atomic uint64_t g_logWriteErrors = 0;
+
+static char g_logPath[KIMIRUN_LOG_PATH_MAX] = "kimirun.log";
+static uint64_t g_logMaxFileBytes = 2 * 1024 * 1024;
+static unsigned g_logKeepFiles = 2;
+
+static pthread_once_t g_logStartOnce = PTHREAD_ONCE_INIT;
+static _Atomic bool g_logStarted = false;
+
+static pthread_mutex_t g_logWakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_logWakeCond = PTHREAD_COND_INITIALIZER;      // writer waits here
+static pthread_cond_t g_logWrittenCond = PTHREAD_COND_INITIALIZER;   // flushers wait here
+static _Atomic bool g_logWriterParked = false;
+static _Atomic unsigned g_logFlushWaiters = 0;                       // changed under g_logWakeLock
+static _Atomic uint64_t g_logWakeups = 0;
+
+static const char kKimiRunLogLevelChars[] = {'D', 'I', 'W', 'E'};
+
+// File handling
+
+static int KimiRunLogOpen(uint64_t *sizeOut) {
+    int fd = open(g_logPath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd >= 0 && sizeOut) {
+        struct stat st;
+        *sizeOut = (fstat(fd, &st) == 0) ? (uint64_t)st.st_size : 0;
+    }
+    return fd;
+}
+
+// Another process sharing the file may have rotated it under us.
+static bool KimiRunLogFileReplaced(int fd) {
+    struct stat fdStat;
+    struct stat pathStat;
+    if (fstat(fd, &fdStat) != 0 || stat(g_logPath, &pathStat) != 0) {
+        return true;
+    }
+    return fdStat.st_ino != pathStat.st_ino || fdStat.st_dev != pathStat.st_dev;
+}
+
+static int KimiRunLogRotate(int fd, uint64_t *sizeOut) {
+    if (g_logKeepFiles == 0) {
+        if (ftruncate(fd, 0) == 0) {
+            *sizeOut = 0;
+            atomic_fetch_add_explicit(&g_logRotations, 1, memory_order_relaxed);
+        }
+        return fd;
+    }
+    char from[KIMIRUN_LOG_PATH_MAX + 16];
+    char to[KIMIRUN_LOG_PATH_MAX + 16];
+    for (unsigned generation = g_logKeepFiles; generation > 1; generation--) {
+        snprintf(from, sizeof(from), "%s.%u", g_logPath, generation - 1);
+        snprintf(to, sizeof(to), "%s.%u", g_logPath, generation);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", g_logPath);
+    rename(g_logPath, to);
+    close(fd);
+    atomic_fetch_add_explicit(&g_logRotations, 1, memory_order_relaxed);
+    return KimiRunLogOpen(sizeOut);
+}
+
+static bool KimiRunLogWriteAll(int fd, const char *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t wrote = write(fd, bytes, length);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += wrote;
+        length -= (size_t)wrote;
+    }
+    return true;
+}
+
+// Writer
+
+static bool KimiRunLogRecordReady(void) {
+    const KimiRunLogSlot *slot = &g_logSlots[g_logDequeuePos & KIMIRUN_LOG_RING_MASK];
+    return atomic_load(&slot->sequence) == g_logDequeuePos + 1;
+}
+
+// Pairs with the exchange in KimiRunLogWakeWriter: either the producer sees
+// the flag raised, or this re-check sees its record (both seq_cst).
+static void KimiRunLogPark(void) {
+    atomic_store(&g_logWriterParked, true);
+    if (KimiRunLogRecordReady()) {
+        atomic_store(&g_logWriterParked, false);
+        return;
+    }
+    pthread_mutex_lock(&g_logWakeLock);
+    while (atomic_load(&g_logWriterParked)) {
+        pthread_cond_wait(&g_logWakeCond, &g_logWakeLock);
+    }
+    pthread_mutex_unlock(&g_logWakeLock);
+}
+
+static void KimiRunLogWakeWriter(void) {
+    if (!atomic_load(&g_logWriterParked) || !atomic_exchange(&g_logWriterParked, false)) {
+        return;
+    }
+    atomic_fetch_add_explicit(&g_logWakeups, 1, memory_order_relaxed);
+    pthread_mutex_lock(&g_logWakeLock);
+    pthread_cond_signal(&g_logWakeCond);
+    pthread_mutex_unlock(&g_logWakeLock);
+}
+
+static void KimiRunLogPublishWritten(uint64_t position) {
+    atomic_store(&g_logWrittenPos, position);
+    if (atomic_load(&g_logFlushWaiters) > 0) {
+        pthread_mutex_lock(&g_logWakeLock);
+        pthread_cond_broadcast(&g_logWrittenCond);
+        pthread_mutex_unlock(&g_logWakeLock);
+    }
+}
+
+static size_t KimiRunLogFormat(const KimiRunLogRecord *record, char *out, size_t capacity) {
+    time_t seconds = (time_t)(record->timestampNanos / 1000000000ULL);
+    unsigned millis = (unsigned)((record->timestampNanos / 1000000ULL) % 1000ULL);
+    struct tm parts;
+    localtime_r(&seconds, &parts);
+    char level = record->level < sizeof(kKimiRunLogLevelChars) ? kKimiRunLogLevelChars[record->level] : '?';
+
+    int written = snprintf(out, capacity, "%04d-%02d-%02d %02d:%02d:%02d.%03u %c %s%s%s%.*s%s\n",
+                           parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday,
+                           parts.tm_hour, parts.tm_min, parts.tm_sec, millis,
+                           level,
+                           record->tag[0] ? "[" : "",
+                           record->tag,
+                           record->tag[0] ? "] " : "",
+                           (int)record->length, record->payload,
+                           record->truncated ? " ...(truncated)" : "");
+    if (written < 0) {
+        return 0;
+    }
+    return ((size_t)written < capacity) ? (size_t)written : capacity - 1;
+}
+
+static void *KimiRunLogWriterMain(void *unused) {
+    (void)unused;
+    char *batch = malloc(KIMIRUN_LOG_BATCH_BYTES);
+    if (!batch) {
+        return NULL;
+    }
+    uint64_t fileBytes = 0;
+    int fd = KimiRunLogOpen(&fileBytes);
+
+    for (;;) {
+        size_t used = 0;
+        uint64_t drained = 0;
+        while (used + KIMIRUN_LOG_LINE_MAX <= KIMIRUN_LOG_BATCH_BYTES) {
+            KimiRunLogSlot *slot = &g_logSlots[g_logDequeuePos & KIMIRUN_LOG_RING_MASK];
+            uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+            if (sequence != g_logDequeuePos + 1) {
+                break;
+            }
+            used += KimiRunLogFormat(&slot->record, batch + used, KIMIRUN_LOG_BATCH_BYTES - used);
+            atomic_store_explicit(&slot->sequence,
+                                  g_logDequeuePos + KIMIRUN_LOG_RING_CAPACITY,
+                                  memory_order_release);
+            g_logDequeuePos++;
+            drained++;
+        }
+
+        if (drained == 0) {
+            KimiRunLogPark();
+            continue;
+        }
+
+        if (fd >= 0 && KimiRunLogFileReplaced(fd)) {
+            close(fd);
+            fd = -1;
+        }
+        if (fd < 0) {
+            fd = KimiRunLogOpen(&fileBytes);
+        }
+        if (fd >= 0 && KimiRunLogWriteAll(fd, batch, used)) {
+            fileBytes += used;
+            atomic_fetch_add_explicit(&g_logBytesWritten, used, memory_order_relaxed);
+        } else {
+            atomic_fetch_add_explicit(&g_logWriteErrors, 1, memory_order_relaxed);
+        }
+        KimiRunLogPublishWritten(g_logDequeuePos);
+
+        if (fd >= 0 && g_logMaxFileBytes > 0 && fileBytes >= g_logMaxFileBytes) {
+            fd = KimiRunLogRotate(fd, &fileBytes);
+        }
+    }
+    return NULL;
+}
+
+static void KimiRunLogStart(void) {
+    for (uint64_t i = 0; i < KIMIRUN_LOG_RING_CAPACITY; i++) {
+        atomic_store_explicit(&g_logSlots[i].sequence, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_logStarted, true, memory_order_release);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    pthread_create(&thread, &attr, KimiRunLogWriterMain, NULL);
+    pthread_attr_destroy(&attr);
+}
+
+// Public API
+
+void KimiRunLogRingConfigure(const char *path, uint64_t maxFileBytes, unsigned keepFiles) {
+    if (atomic_load_explicit(&g_logStarted, memory_order_acquire)) {
+        return;
+    }
+    if (path && path[0] != '\0') {
+        snprintf(g_logPath, sizeof(g_logPath), "%s", path);
+    }
+    g_logMaxFileBytes = maxFileBytes;
+    g_logKeepFiles = keepFiles;
+}
+
+bool KimiRunLogRingPush(KimiRunLogLevel level, const char *tag, const char *payload, size_t length) {
+    pthread_once(&g_logStartOnce, KimiRunLogStart);
+
+    KimiRunLogSlot *slot = NULL;
+    uint64_t position = atomic_load_explicit(&g_logEnqueuePos, memory_order_relaxed);
+    for (;;) {
+        slot = &g_logSlots[position & KIMIRUN_LOG_RING_MASK];
+        uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int64_t diff = (int64_t)(sequence - position);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_logEnqueuePos, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&g_logDropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            position = atomic_load_explicit(&g_logEnqueuePos, memory_order_relaxed);
+        }
+    }
+
+    KimiRunLogRecord *record = &slot->record;
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    record->timestampNanos = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    record->level = (uint8_t)level;
+    record->tag[0] = '\0';
+    if (tag) {
+        size_t tagLength = strnlen(tag, KIMIRUN_LOG_TAG_MAX);
+        memcpy(record->tag, tag, tagLength);
+        record->tag[tagLength] = '\0';
+    }
+    if (!payload) {
+        length = 0;
+    }
+    record->truncated = (length > KIMIRUN_LOG_PAYLOAD_MAX);
+    if (record->truncated) {
+        length = KIMIRUN_LOG_PAYLOAD_MAX;
+    }
+    if (length > 0) {
+        memcpy(record->payload, payload, length);
+    }
+    record->length = (uint16_t)length;
+
+    atomic_store(&slot->sequence, position + 1);
+    KimiRunLogWakeWriter();
+    return true;
+}
+
+bool KimiRunLogRingFlush(unsigned timeoutMillis) {
+    if (!atomic_load_explicit(&g_logStarted, memory_order_acquire)) {
+        return true;
+    }
+    uint64_t target = atomic_load_explicit(&g_logEnqueuePos, memory_order_acquire);
+    if (atomic_load_explicit(&g_logWrittenPos, memory_order_acquire) >= target) {
+        return true;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMillis / 1000;
+    deadline.tv_nsec += (long)(timeoutMillis % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&g_logWakeLock);
+    atomic_fetch_add(&g_logFlushWaiters, 1);
+    bool drained;
+    while (!(drained = atomic_load(&g_logWrittenPos) >= target)) {
+        if (pthread_cond_timedwait(&g_logWrittenCond, &g_logWakeLock, &deadline) == ETIMEDOUT) {
+            drained = atomic_load(&g_logWrittenPos) >= target;
+            break;
+        }
+    }
+    atomic_fetch_sub(&g_logFlushWaiters, 1);
+    pthread_mutex_unlock(&g_logWakeLock);
+    return drained;
+}
+
+void KimiRunLogRingGetStats(KimiRunLogRingStats *out) {
+    if (!out) {
+        return;
+    }
+    out->enqueued = atomic_load_explicit(&g_logEnqueuePos, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&g_logDropped, memory_order_relaxed);
+    out->written = atomic_load_explicit(&g_logWrittenPos, memory_order_relaxed);
+    out->bytesWritten = atomic_load_explicit(&g_logBytesWritten, memory_order_relaxed);
+    out->rotations = atomic_load_explicit(&g_logRotations, memory_order_relaxed);
+    out->writeErrors = atomic_load_explicit(&g_logWriteErrors, memory_order_relaxed);
+    out->wakeups = atomic_load_explicit(&g_logWakeups, memory_order_relaxed);
+}
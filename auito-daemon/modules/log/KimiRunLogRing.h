@@ -0,0 +1,81 @@
+//
+//  KimiRunLogRing.h
+//  KimiRun - Asynchronous Log Pipeline
+//
+//  Portable C (C11 atomics + pthreads). Producers copy a preformatted
+//  record into a bounded lock-free multi-producer ring; one background
+//  writer thread drains it, batches lines into a single write() and
+//  rotates the file by size. A full ring drops the record instead of
+//  blocking the caller. The writer sleeps while the ring is empty and is
+//  woken by the push that makes it non-empty.
+//
+
+#ifndef KIMIRUN_LOG_RING_H
+#define KIMIRUN_LOG_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_LOG_RING_CAPACITY 512   // slots, power of two
+#define KIMIRUN_LOG_TAG_MAX 15
+#define KIMIRUN_LOG_PAYLOAD_MAX 464
+
+typedef enum {
+    KimiRunLogLevelDebug = 0,
+    KimiRunLogLevelInfo = 1,
+    KimiRunLogLevelWarn = 2,
+    KimiRunLogLevelError = 3
+} KimiRunLogLevel;
+
+typedef struct {
+    uint64_t timestampNanos;   // CLOCK_REALTIME
+    uint16_t length;           // payload bytes, excluding terminator
+    uint8_t level;
+    uint8_t truncated;
+    char tag[KIMIRUN_LOG_TAG_MAX + 1];
+    char payload[KIMIRUN_LOG_PAYLOAD_MAX];
+} KimiRunLogRecord;
+
+typedef struct {
+    uint64_t enqueued;
+    uint64_t dropped;
+    uint64_t written;
+    uint64_t bytesWritten;
+    uint64_t rotations;
+    uint64_t writeErrors;
+    uint64_t wakeups;          // times a push woke the parked writer
+} KimiRunLogRingStats;
+
+/**
+ * Configure the output file. Must be called before the first push to take
+ * effect; later calls are ignored. maxFileBytes == 0 disables rotation.
+ * keepFiles is the number of rotated generations kept (path.1 .. path.N).
+ */
+void KimiRunLogRingConfigure(const char *path, uint64_t maxFileBytes, unsigned keepFiles);
+
+/**
+ * Enqueue one record. Never blocks; returns false if the ring is full
+ * (the record is counted as dropped). tag may be NULL. Payloads longer
+ * than KIMIRUN_LOG_PAYLOAD_MAX are truncated.
+ */
+bool KimiRunLogRingPush(KimiRunLogLevel level, const char *tag, const char *payload, size_t length);
+
+/**
+ * Wait (up to timeoutMillis) until every record enqueued before the call
+ * has been written to the file. Returns true when fully drained. Readers
+ * of the log file call this first so they see their own recent lines.
+ */
+bool KimiRunLogRingFlush(unsigned timeoutMillis);
+
+void KimiRunLogRingGetStats(KimiRunLogRingStats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
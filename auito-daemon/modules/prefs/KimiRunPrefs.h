@@ -0,0 +1,88 @@
+//
+//  KimiRunPrefs.h
+//  KimiRun - Shared Preferences Snapshot
+//
+//  One immutable snapshot of the com.auito.daemon preferences domain plus
+//  KIMIRUN_* environment variables. Readers load the current snapshot
+//  lock-free; the snapshot is swapped when this process writes a preference
+//  or when the prefs-changed Darwin notification reports a change on disk.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+extern NSString *const kKimiRunPrefsSuite;
+
+/**
+ * Posted on the main queue after a new snapshot has been published.
+ */
+extern NSString *const KimiRunPrefsDidChangeNotification;
+
+@interface KimiRunPrefsSnapshot : NSObject
+
+/**
+ * Monotonic snapshot generation (1 for the first load).
+ */
+@property (nonatomic, readonly) uint64_t generation;
+
+/**
+ * Absolute time the snapshot was built.
+ */
+@property (nonatomic, readonly) CFAbsoluteTime loadedAt;
+
+/**
+ * Raw preference value for key, or nil when unset.
+ */
+- (nullable id)objectForKey:(NSString *)key;
+
+/**
+ * Captured KIMIRUN_* environment value for key, or NULL when unset/empty.
+ * The returned pointer stays valid for the lifetime of the snapshot.
+ */
+- (nullable const char *)environmentValueForKey:(const char *)key;
+
+/**
+ * Summary suitable for JSON diagnostics.
+ */
+- (NSDictionary *)diagnosticsDictionary;
+
+@end
+
+/**
+ * Current snapshot. Loads on first use; never blocks after that.
+ */
+KimiRunPrefsSnapshot *KimiRunPrefsCurrentSnapshot(void);
+
+/**
+ * Rebuild the snapshot from disk and publish it if it differs from the
+ * current one.
+ */
+void KimiRunPrefsReload(void);
+
+// Preference accessors (snapshot-backed, lock-free)
+BOOL KimiRunPrefsBool(NSString *key, BOOL defaultValue);
+NSString *_Nullable KimiRunPrefsString(NSString *key);
+NSInteger KimiRunPrefsInteger(NSString *key, NSInteger defaultValue);
+double KimiRunPrefsDouble(NSString *key, double defaultValue);
+
+// Environment accessors (snapshot-backed, lock-free)
+const char *_Nullable KimiRunPrefsEnv(const char *key);
+BOOL KimiRunPrefsEnvBool(const char *key, BOOL defaultValue);
+NSInteger KimiRunPrefsEnvInteger(const char *key, NSInteger defaultValue);
+double KimiRunPrefsEnvDouble(const char *key, double defaultValue);
+
+/**
+ * Persist a preference (nil or empty string removes it), republish the local
+ * snapshot and notify other processes via the prefs-changed Darwin notification.
+ * A write that changes nothing publishes and posts nothing.
+ */
+void KimiRunPrefsSetValue(NSString *key, id _Nullable value);
+
+/**
+ * KimiRunPrefsSetValue for several keys at once (NSNull or an empty string
+ * removes a key), published as one snapshot with one notification.
+ */
+void KimiRunPrefsSetValues(NSDictionary<NSString *, id> *values);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,364 @@
+//
+//  KimiRunPrefs.m
+//  KimiRun - Shared Preferences Snapshot
+//
+
+#import "KimiRunPrefs.h"
+#import <CoreFoundation/CoreFoundation.h>
+#import <os/lock.h>
+#import <stdatomic.h>
+#import <stdlib.h>
+#import <string.h>
+#import <strings.h>
+#import <math.h>
+
+NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
+NSString *const KimiRunPrefsDidChangeNotification = @"KimiRunPrefsDidChangeNotification";
+
+static CFStringRef const kKimiRunPrefsChangedDarwinName = CFSTR("com.auito.daemon/prefsChanged");
+static const char *const kKimiRunEnvPrefix = "KIMIRUN_";
+
+static _Atomic(void *) g_prefsSnapshot = NULL;
+static _Atomic(uint64_t) g_prefsGeneration = 0;
+static os_unfair_lock g_prefsWriteLock = OS_UNFAIR_LOCK_INIT;
+// Replaced snapshots are never freed: readers use the raw pointer without
+// retaining it, for however long they are preempted, and hand out
+// environment strings owned by the snapshot. Snapshots are small and only
+// published on a preference change. Guarded by g_prefsWriteLock.
+static CFMutableArrayRef g_prefsRetired = NULL;
+
+@interface KimiRunPrefsSnapshot () {
+    NSDictionary<NSString *, id> *_preferences;
+    NSArray<NSString *> *_environmentKeys;
+    char **_envNames;
+    char **_envValues;
+    size_t _envCount;
+}
+- (instancetype)initWithGeneration:(uint64_t)generation preferences:(NSDictionary *)preferences;
+- (BOOL)hasPreferences:(NSDictionary *)preferences;
+@end
+
+static NSDictionary *KimiRunPrefsReadDomain(void) {
+    NSDictionary *prefs = nil;
+    @try {
+        NSUserDefaults *defaults = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
+        prefs = [defaults dictionaryRepresentation];
+    } @catch (NSException *e) {
+        NSLog(@"[KimiRunPrefs] Failed to read preferences: %@", e);
+    }
+    return [prefs isKindOfClass:[NSDictionary class]] ? [prefs copy] : @{};
+}
+
+@implementation KimiRunPrefsSnapshot
+
+- (instancetype)initWithGeneration:(uint64_t)generation preferences:(NSDictionary *)preferences {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _generation = generation;
+    _loadedAt = CFAbsoluteTimeGetCurrent();
+    _preferences = preferences;
+
+    NSDictionary<NSString *, NSString *> *env = [[NSProcessInfo processInfo] environment];
+    NSMutableArray<NSString *> *names = [NSMutableArray array];
+    for (NSString *name in env) {
+        NSString *value = env[name];
+        if ([name hasPrefix:@(kKimiRunEnvPrefix)] && value.length > 0) {
+            [names addObject:name];
+        }
+    }
+    [names sortUsingSelector:@selector(compare:)];
+    _environmentKeys = [names copy];
+    _envCount = names.count;
+    if (_envCount > 0) {
+        _envNames = calloc(_envCount, sizeof(char *));
+        _envValues = calloc(_envCount, sizeof(char *));
+        for (size_t i = 0; i < _envCount; i++) {
+            _envNames[i] = strdup(names[i].UTF8String ?: "");
+            _envValues[i] = strdup(env[names[i]].UTF8String ?: "");
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (size_t i = 0; i < _envCount; i++) {
+        free(_envNames[i]);
+        free(_envValues[i]);
+    }
+    free(_envNames);
+    free(_envValues);
+}
+
+- (BOOL)hasPreferences:(NSDictionary *)preferences {
+    return [_preferences isEqualToDictionary:preferences];
+}
+
+- (id)objectForKey:(NSString *)key {
+    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
+        return nil;
+    }
+    return _preferences[key];
+}
+
+- (const char *)environmentValueForKey:(const char *)key {
+    if (!key) {
+        return NULL;
+    }
+    for (size_t i = 0; i < _envCount; i++) {
+        if (strcmp(_envNames[i], key) == 0) {
+            return _envValues[i];
+        }
+    }
+    return NULL;
+}
+
+- (NSDictionary *)diagnosticsDictionary {
+    return @{
+        @"generation": @(_generation),
+        @"loadedAt": @(_loadedAt),
+        @"ageSeconds": @(MAX(0.0, CFAbsoluteTimeGetCurrent() - _loadedAt)),
+        @"preferenceCount": @(_preferences.count),
+        @"environmentKeys": _environmentKeys ?: @[]
+    };
+}
+
+@end
+
+#pragma mark - Publication
+
+// Publishes a snapshot of the domain as it is on disk. With onlyIfChanged,
+// returns NO without publishing when the current snapshot already holds
+// exactly that, so a change seen twice (a local write, then its own
+// Darwin notification) retires no snapshot.
+static BOOL KimiRunPrefsPublish(BOOL onlyIfChanged) {
+    os_unfair_lock_lock(&g_prefsWriteLock);
+    NSDictionary *preferences = KimiRunPrefsReadDomain();
+    __unsafe_unretained KimiRunPrefsSnapshot *current =
+        (__bridge KimiRunPrefsSnapshot *)atomic_load_explicit(&g_prefsSnapshot, memory_order_acquire);
+    if (onlyIfChanged && current && [current hasPreferences:preferences]) {
+        os_unfair_lock_unlock(&g_prefsWriteLock);
+        return NO;
+    }
+    uint64_t generation = atomic_fetch_add_explicit(&g_prefsGeneration, 1, memory_order_relaxed) + 1;
+    KimiRunPrefsSnapshot *next = [[KimiRunPrefsSnapshot alloc] initWithGeneration:generation
+                                                                      preferences:preferences];
+    void *old = atomic_exchange_explicit(&g_prefsSnapshot,
+                                         (void *)CFBridgingRetain(next),
+                                         memory_order_acq_rel);
+    if (old) {
+        if (!g_prefsRetired) {
+            g_prefsRetired = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+        }
+        // The array takes its own reference; the published one moves to it.
+        CFArrayAppendValue(g_prefsRetired, old);
+        CFRelease(old);
+    }
+    os_unfair_lock_unlock(&g_prefsWriteLock);
+    return YES;
+}
+
+static void KimiRunPrefsPostDidChange(void) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [[NSNotificationCenter defaultCenter] postNotificationName:KimiRunPrefsDidChangeNotification
+                                                            object:nil];
+    });
+}
+
+static void KimiRunPrefsDarwinChanged(__unused CFNotificationCenterRef center,
+                                      __unused void *observer,
+                                      __unused CFStringRef name,
+                                      __unused const void *object,
+                                      __unused CFDictionaryRef userInfo) {
+    // Also delivered for this process's own writes, which already published.
+    if (KimiRunPrefsPublish(YES)) {
+        KimiRunPrefsPostDidChange();
+    }
+}
+
+// Returns YES on the call that published the first snapshot.
+static BOOL KimiRunPrefsBootstrap(void) {
+    static dispatch_once_t onceToken;
+    __block BOOL published = NO;
+    dispatch_once(&onceToken, ^{
+        KimiRunPrefsPublish(NO);
+        published = YES;
+        CFNotificationCenterAddObserver(
+            CFNotificationCenterGetDarwinNotifyCenter(),
+            NULL,
+            (CFNotificationCallback)KimiRunPrefsDarwinChanged,
+            kKimiRunPrefsChangedDarwinName,
+            NULL,
+            CFNotificationSuspensionBehaviorDeliverImmediately
+        );
+    });
+    return published;
+}
+
+// Raw pointer to the published snapshot; valid for the life of the process.
+static inline void *KimiRunPrefsRaw(void) {
+    void *raw = atomic_load_explicit(&g_prefsSnapshot, memory_order_acquire);
+    if (!raw) {
+        KimiRunPrefsBootstrap();
+        raw = atomic_load_explicit(&g_prefsSnapshot, memory_order_acquire);
+    }
+    return raw;
+}
+
+static id KimiRunPrefsObject(NSString *key) {
+    __unsafe_unretained KimiRunPrefsSnapshot *snapshot = (__bridge KimiRunPrefsSnapshot *)KimiRunPrefsRaw();
+    return [snapshot objectForKey:key];
+}
+
+KimiRunPrefsSnapshot *KimiRunPrefsCurrentSnapshot(void) {
+    return (__bridge KimiRunPrefsSnapshot *)KimiRunPrefsRaw();
+}
+
+void KimiRunPrefsReload(void) {
+    if (!KimiRunPrefsBootstrap()) {
+        KimiRunPrefsPublish(YES);
+    }
+}
+
+#pragma mark - Preference accessors
+
+BOOL KimiRunPrefsBool(NSString *key, BOOL defaultValue) {
+    id value = KimiRunPrefsObject(key);
+    if ([value isKindOfClass:[NSNumber class]] || [value isKindOfClass:[NSString class]]) {
+        return [value boolValue];
+    }
+    return defaultValue;
+}
+
+NSString *KimiRunPrefsString(NSString *key) {
+    id value = KimiRunPrefsObject(key);
+    if ([value isKindOfClass:[NSString class]]) {
+        return value;
+    }
+    if ([value isKindOfClass:[NSNumber class]]) {
+        return [value stringValue];
+    }
+    return nil;
+}
+
+NSInteger KimiRunPrefsInteger(NSString *key, NSInteger defaultValue) {
+    id value = KimiRunPrefsObject(key);
+    if (value && [value respondsToSelector:@selector(integerValue)]) {
+        return [value integerValue];
+    }
+    return defaultValue;
+}
+
+double KimiRunPrefsDouble(NSString *key, double defaultValue) {
+    id value = KimiRunPrefsObject(key);
+    if (value && [value respondsToSelector:@selector(doubleValue)]) {
+        double parsed = [value doubleValue];
+        if (isfinite(parsed)) {
+            return parsed;
+        }
+    }
+    return defaultValue;
+}
+
+#pragma mark - Environment accessors
+
+const char *KimiRunPrefsEnv(const char *key) {
+    __unsafe_unretained KimiRunPrefsSnapshot *snapshot = (__bridge KimiRunPrefsSnapshot *)KimiRunPrefsRaw();
+    return [snapshot environmentValueForKey:key];
+}
+
+static BOOL KimiRunEnvTokenEquals(const char *start, size_t length, const char *token) {
+    return strlen(token) == length && strncasecmp(start, token, length) == 0;
+}
+
+BOOL KimiRunPrefsEnvBool(const char *key, BOOL defaultValue) {
+    const char *value = KimiRunPrefsEnv(key);
+    if (!value) {
+        return defaultValue;
+    }
+    const char *start = value;
+    while (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r') {
+        start++;
+    }
+    size_t length = strlen(start);
+    while (length > 0 && (start[length - 1] == ' ' || start[length - 1] == '\t' ||
+                          start[length - 1] == '\n' || start[length - 1] == '\r')) {
+        length--;
+    }
+    if (KimiRunEnvTokenEquals(start, length, "1") || KimiRunEnvTokenEquals(start, length, "true") ||
+        KimiRunEnvTokenEquals(start, length, "yes") || KimiRunEnvTokenEquals(start, length, "on")) {
+        return YES;
+    }
+    if (KimiRunEnvTokenEquals(start, length, "0") || KimiRunEnvTokenEquals(start, length, "false") ||
+        KimiRunEnvTokenEquals(start, length, "no") || KimiRunEnvTokenEquals(start, length, "off")) {
+        return NO;
+    }
+    return defaultValue;
+}
+
+NSInteger KimiRunPrefsEnvInteger(const char *key, NSInteger defaultValue) {
+    const char *raw = KimiRunPrefsEnv(key);
+    if (!raw) {
+        return defaultValue;
+    }
+    char *endPtr = NULL;
+    long parsed = strtol(raw, &endPtr, 10);
+    if (endPtr == raw) {
+        return defaultValue;
+    }
+    return (NSInteger)parsed;
+}
+
+double KimiRunPrefsEnvDouble(const char *key, double defaultValue) {
+    const char *raw = KimiRunPrefsEnv(key);
+    if (!raw) {
+        return defaultValue;
+    }
+    char *endPtr = NULL;
+    double parsed = strtod(raw, &endPtr);
+    if (endPtr == raw || !isfinite(parsed)) {
+        return defaultValue;
+    }
+    return parsed;
+}
+
+#pragma mark - Writes
+
+void KimiRunPrefsSetValue(NSString *key, id value) {
+    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
+        return;
+    }
+    KimiRunPrefsSetValues(@{key: value ?: [NSNull null]});
+}
+
+void KimiRunPrefsSetValues(NSDictionary<NSString *, id> *values) {
+    if (![values isKindOfClass:[NSDictionary class]] || values.count == 0) {
+        return;
+    }
+    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
+    for (NSString *key in values) {
+        if (![key isKindOfClass:[NSString class]] || key.length == 0) {
+            continue;
+        }
+        id value = values[key];
+        BOOL remove = value == [NSNull null] || ([value isKindOfClass:[NSString class]] && [value length] == 0);
+        if (remove) {
+            [prefs removeObjectForKey:key];
+        } else {
+            [prefs setObject:value forKey:key];
+        }
+    }
+    [prefs synchronize];
+
+    // The first snapshot, if this write triggered it, already has the values.
+    if (!KimiRunPrefsBootstrap() && !KimiRunPrefsPublish(YES)) {
+        return;
+    }
+    KimiRunPrefsPostDidChange();
+    CFNotificationCenterPostNotification(CFNotificationCenterGetDarwinNotifyCenter(),
+                                         kKimiRunPrefsChangedDarwinName,
+                                         NULL,
+                                         NULL,
+                                         true);
+}
@@ -5,25 +5,15 @@
 
 #import "KimiRunSleep.h"
 #import <UIKit/UIKit.h>
-
-static NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
+#import "../prefs/KimiRunPrefs.h"
 
 static BOOL KimiRunIsSpringBoard(void) {
     return [[[NSBundle mainBundle] bundleIdentifier] isEqualToString:@"com.apple.springboard"];
 }
 
-static BOOL KimiRunPrefBool(NSString *key, BOOL defaultValue) {
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs objectForKey:key];
-    if (!value) {
-        return defaultValue;
-    }
-    return [prefs boolForKey:key];
-}
-
 static BOOL KimiRunDisableLockscreenEnabled(void) {
-    BOOL enabled = KimiRunPrefBool(@"DisableLockScreen", NO);
-    const char *env = getenv("KIMIRUN_DISABLE_LOCKSCREEN");
+    BOOL enabled = KimiRunPrefsBool(@"DisableLockScreen", NO);
+    const char *env = KimiRunPrefsEnv("KIMIRUN_DISABLE_LOCKSCREEN");
     if (env && env[0] != '\0') {
         enabled = (env[0] == '1');
     }
@@ -31,8 +21,8 @@ static BOOL KimiRunDisableLockscreenEnabled(void) {
 }
 
 static BOOL KimiRunAllowSleepEnabled(void) {
-    BOOL enabled = KimiRunPrefBool(@"AllowSleep", NO);
-    const char *env = getenv("KIMIRUN_ALLOW_SLEEP");
+    BOOL enabled = KimiRunPrefsBool(@"AllowSleep", NO);
+    const char *env = KimiRunPrefsEnv("KIMIRUN_ALLOW_SLEEP");
     if (env && env[0] != '\0') {
         enabled = (env[0] == '1');
     }
@@ -40,8 +30,8 @@ static BOOL KimiRunAllowSleepEnabled(void) {
 }
 
 static BOOL KimiRunBlockSideButtonSleepEnabled(void) {
-    BOOL enabled = KimiRunPrefBool(@"BlockSideButtonSleep", KimiRunPrefBool(@"PreventSleep", NO));
-    const char *env = getenv("KIMIRUN_BLOCK_SIDE_BUTTON_SLEEP");
+    BOOL enabled = KimiRunPrefsBool(@"BlockSideButtonSleep", KimiRunPrefsBool(@"PreventSleep", NO));
+    const char *env = KimiRunPrefsEnv("KIMIRUN_BLOCK_SIDE_BUTTON_SLEEP");
     if (env && env[0] != '\0') {
         enabled = (env[0] == '1');
     }
@@ -49,8 +39,8 @@ static BOOL KimiRunBlockSideButtonSleepEnabled(void) {
 }
 
 static BOOL KimiRunPreventSleepEnabledInternal(void) {
-    BOOL enabled = KimiRunPrefBool(@"PreventSleep", NO);
-    const char *env = getenv("KIMIRUN_PREVENT_SLEEP");
+    BOOL enabled = KimiRunPrefsBool(@"PreventSleep", NO);
+    const char *env = KimiRunPrefsEnv("KIMIRUN_PREVENT_SLEEP");
     if (env && env[0] != '\0') {
         enabled = (env[0] == '1');
     }
@@ -63,14 +53,6 @@ static BOOL KimiRunPreventSleepEnabledInternal(void) {
     return enabled;
 }
 
-static void KimiRunSleepPrefsChanged(__unused CFNotificationCenterRef center,
-                                     __unused void *observer,
-                                     __unused CFStringRef name,
-                                     __unused const void *object,
-                                     __unused CFDictionaryRef userInfo) {
-    [KimiRunSleep applyPreventSleep];
-}
-
 @implementation KimiRunSleep
 
 + (BOOL)preventSleepEnabled {
@@ -101,14 +83,18 @@ static void KimiRunSleepPrefsChanged(__unused CFNotificationCenterRef center,
     if (!KimiRunIsSpringBoard()) {
         return;
     }
-    CFNotificationCenterAddObserver(
-        CFNotificationCenterGetDarwinNotifyCenter(),
-        NULL,
-        (CFNotificationCallback)KimiRunSleepPrefsChanged,
-        CFSTR("com.auito.daemon/prefsChanged"),
-        NULL,
-        CFNotificationSuspensionBehaviorDeliverImmediately
-    );
+    static id observerToken = nil;
+    if (observerToken) {
+        return;
+    }
+    (void)KimiRunPrefsCurrentSnapshot();
+    observerToken = [[NSNotificationCenter defaultCenter]
+        addObserverForName:KimiRunPrefsDidChangeNotification
+                    object:nil
+                     queue:[NSOperationQueue mainQueue]
+                usingBlock:^(__unused NSNotification *note) {
+        [KimiRunSleep applyPreventSleep];
+    }];
     NSLog(@"[KimiRunSleep] Registered preference change observer");
 }
 
@@ -0,0 +1,115 @@
+//
+//  KimiRunBinaryTouch.c
+//  KimiRun - Binary Touch Stream Protocol
+//
+
+#include "KimiRunBinaryTouch.h"
+
+#include <string.h>
+
+static uint16_t KimiRunBTouchRead16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t KimiRunBTouchRead32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void KimiRunBTouchWrite16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void KimiRunBTouchWrite32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint16_t KimiRunBTouchFixed(float points) {
+    float scaled = points * KIMIRUN_BTOUCH_COORD_SCALE + 0.5f;
+    if (!(scaled > 0.0f)) {
+        return 0;
+    }
+    if (scaled >= 65535.0f) {
+        return 65535;
+    }
+    return (uint16_t)scaled;
+}
+
+bool KimiRunBTouchDecode(const uint8_t *bytes, KimiRunBTouchRecord *out) {
+    out->sequence = KimiRunBTouchRead32(bytes);
+    out->finger = bytes[4];
+    out->phase = bytes[5];
+    out->flags = KimiRunBTouchRead16(bytes + 6);
+    out->x = (float)KimiRunBTouchRead16(bytes + 8) / KIMIRUN_BTOUCH_COORD_SCALE;
+    out->y = (float)KimiRunBTouchRead16(bytes + 10) / KIMIRUN_BTOUCH_COORD_SCALE;
+    out->clientMicros = KimiRunBTouchRead32(bytes + 12);
+    return out->phase <= KimiRunBTouchPhaseUp;
+}
+
+void KimiRunBTouchEncode(const KimiRunBTouchRecord *record, uint8_t *bytes) {
+    KimiRunBTouchWrite32(bytes, record->sequence);
+    bytes[4] = record->finger;
+    bytes[5] = record->phase;
+    KimiRunBTouchWrite16(bytes + 6, record->flags);
+    KimiRunBTouchWrite16(bytes + 8, KimiRunBTouchFixed(record->x));
+    KimiRunBTouchWrite16(bytes + 10, KimiRunBTouchFixed(record->y));
+    KimiRunBTouchWrite32(bytes + 12, record->clientMicros);
+}
+
+void KimiRunBTouchEncodeAck(const KimiRunBTouchAck *ack, uint8_t *bytes) {
+    KimiRunBTouchWrite32(bytes, ack->sequence);
+    KimiRunBTouchWrite32(bytes + 4, ack->clientMicros);
+    KimiRunBTouchWrite32(bytes + 8, ack->latencyMicros);
+    KimiRunBTouchWrite16(bytes + 12, ack->count);
+    bytes[14] = ack->failed;
+    bytes[15] = 0;
+}
+
+void KimiRunBTouchDecodeAck(const uint8_t *bytes, KimiRunBTouchAck *out) {
+    out->sequence = KimiRunBTouchRead32(bytes);
+    out->clientMicros = KimiRunBTouchRead32(bytes + 4);
+    out->latencyMicros = KimiRunBTouchRead32(bytes + 8);
+    out->count = KimiRunBTouchRead16(bytes + 12);
+    out->failed = bytes[14];
+}
+
+uint64_t KimiRunBTouchPlayoutDue(KimiRunBTouchPlayout *playout,
+                                 uint32_t clientMicros,
+                                 uint64_t receivedMicros,
+                                 uint32_t delayMicros) {
+    if (!playout->anchored) {
+        memset(playout, 0, sizeof(*playout));
+        playout->anchored = true;
+        playout->clientMicros = clientMicros;
+        playout->minOffset = (int64_t)receivedMicros - (int64_t)clientMicros;
+    } else {
+        // Signed difference so the 32-bit client clock can wrap.
+        int32_t delta = (int32_t)(clientMicros - playout->lastClient);
+        playout->clientMicros = (uint64_t)((int64_t)playout->clientMicros + delta);
+    }
+    playout->lastClient = clientMicros;
+
+    int64_t offset = (int64_t)receivedMicros - (int64_t)playout->clientMicros;
+    if (offset < playout->minOffset) {
+        playout->minOffset = offset;
+    }
+    int64_t due = (int64_t)playout->clientMicros + playout->minOffset + (int64_t)delayMicros;
+    if (due < 0) {
+        due = 0;
+    }
+    if ((uint64_t)due < playout->lastDue) {
+        due = (int64_t)playout->lastDue;
+    }
+    playout->lastDue = (uint64_t)due;
+    return (uint64_t)due;
+}
+
+uint64_t KimiRunBTouchImmediateDue(KimiRunBTouchPlayout *playout, uint64_t receivedMicros) {
+    if (receivedMicros > playout->lastDue) {
+        playout->lastDue = receivedMicros;
+    }
+    return playout->lastDue;
+}
@@ -0,0 +1,111 @@
+//
+//  KimiRunBinaryTouch.h
+//  KimiRun - Binary Touch Stream Protocol
+//
+//  Portable C, no allocation. Wire format for the low-latency touch stream
+//  that a SocketTouchServer client enters by sending the line "BIN". After
+//  that every frame is a fixed 16-byte record, all fields little-endian:
+//
+//    record (client -> server)        ack (server -> client)
+//     0 u32 sequence                   0 u32 sequence     last record applied
+//     4 u8  finger                     4 u32 clientMicros echoed from it
+//     5 u8  phase (0 down 1 move 2 up) 8 u32 latencyMicros received -> applied
+//     6 u16 flags                     12 u16 count        records in this ack
+//     8 u16 x   (1/16 point)          14 u8  failed       rejected or failed
+//    10 u16 y   (1/16 point)          15 u8  reserved
+//    12 u32 clientMicros (client monotonic clock, wraps)
+//
+//  Records are applied in order and acknowledged in batches: one ack covers
+//  every record of a connection applied in the same dispatch pass.
+//
+//  KimiRunBTouchPlayout maps client timestamps onto the receiver's clock so
+//  records that arrive bunched up are replayed with their original spacing,
+//  at most delayMicros after they were received.
+//
+
+#ifndef KIMIRUN_BINARY_TOUCH_H
+#define KIMIRUN_BINARY_TOUCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_BTOUCH_RECORD_SIZE 16
+#define KIMIRUN_BTOUCH_ACK_SIZE 16
+#define KIMIRUN_BTOUCH_COORD_SCALE 16.0f   // fixed-point units per point
+
+// Record phases on the wire.
+enum {
+    KimiRunBTouchPhaseDown = 0,
+    KimiRunBTouchPhaseMove = 1,
+    KimiRunBTouchPhaseUp = 2
+};
+
+// Record flags.
+enum {
+    KimiRunBTouchFlagImmediate = 1u << 0   // skip the playout delay
+};
+
+typedef struct {
+    uint32_t sequence;
+    uint8_t finger;
+    uint8_t phase;                 // KimiRunBTouchPhase*
+    uint16_t flags;                // KimiRunBTouchFlag*
+    float x;                       // points
+    float y;
+    uint32_t clientMicros;
+} KimiRunBTouchRecord;
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t clientMicros;
+    uint32_t latencyMicros;
+    uint16_t count;
+    uint8_t failed;
+} KimiRunBTouchAck;
+
+typedef struct {
+    bool anchored;
+    uint32_t lastClient;           // last raw client timestamp
+    uint64_t clientMicros;         // unwrapped client clock
+    int64_t minOffset;             // min(received - client) seen so far
+    uint64_t lastDue;
+} KimiRunBTouchPlayout;
+
+/** Decode one record. False when the phase is unknown (fields still filled). */
+bool KimiRunBTouchDecode(const uint8_t *bytes, KimiRunBTouchRecord *out);
+
+/** Encode one record; coordinates are clamped to the 16-bit range. */
+void KimiRunBTouchEncode(const KimiRunBTouchRecord *record, uint8_t *bytes);
+
+void KimiRunBTouchEncodeAck(const KimiRunBTouchAck *ack, uint8_t *bytes);
+void KimiRunBTouchDecodeAck(const uint8_t *bytes, KimiRunBTouchAck *out);
+
+/**
+ * Receiver-clock time (microseconds) at which a record should be applied.
+ * The smallest receive-minus-send offset seen approximates the fastest
+ * path through the network; each record is scheduled that far after its
+ * client timestamp plus delayMicros, so it never waits longer than
+ * delayMicros past its arrival. Due times never go backwards, which keeps
+ * records in order. Zero the struct to start a new stream.
+ */
+uint64_t KimiRunBTouchPlayoutDue(KimiRunBTouchPlayout *playout,
+                                 uint32_t clientMicros,
+                                 uint64_t receivedMicros,
+                                 uint32_t delayMicros);
+
+/**
+ * Due time for a KimiRunBTouchFlagImmediate record: now, but never before
+ * the connection's earlier records.
+ */
+uint64_t KimiRunBTouchImmediateDue(KimiRunBTouchPlayout *playout, uint64_t receivedMicros);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
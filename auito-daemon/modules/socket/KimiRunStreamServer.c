@@ -0,0 +1,688 @@
+//
+//  KimiRunStreamServer.c
+//  KimiRun - Nonblocking Multi-Client Stream Server
+//
+
+#include "KimiRunStreamServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+#define KIMIRUN_STREAM_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define KIMIRUN_STREAM_SEND_FLAGS 0
+#endif
+
+#define KIMIRUN_STREAM_READ_SLACK 4096   // receive space beyond one max frame
+#define KIMIRUN_STREAM_READS_PER_WAKE 16 // fairness across busy clients
+
+struct KimiRunStreamConnection {
+    KimiRunStreamServer *server;
+    int fd;
+    uint64_t identifier;
+    char peer[32];
+    uint8_t *in;
+    size_t inLength;
+    size_t inCapacity;
+    uint8_t *out;
+    size_t outOffset;
+    size_t outLength;
+    size_t outCapacity;
+    KimiRunStreamFraming framing;
+    uint32_t recordSize;
+    bool discarding;             // skipping the rest of an oversized line
+    bool closing;                // no more input; close once output drains
+    bool dead;                   // close and free at the end of this pass
+    void *userData;
+};
+
+typedef struct KimiRunStreamPost {
+    struct KimiRunStreamPost *next;
+    uint64_t connectionID;
+    size_t length;
+    uint8_t bytes[];
+} KimiRunStreamPost;
+
+struct KimiRunStreamServer {
+    KimiRunStreamServerConfig config;
+    KimiRunStreamCallbacks callbacks;
+    int listenFD;
+    int wakeFDs[2];
+    atomic_bool stopping;
+    uint64_t nextIdentifier;
+    KimiRunStreamConnection **connections;
+    uint32_t connectionCount;
+    struct pollfd *pollFDs;
+    KimiRunStreamConnection **polled;
+    KimiRunStreamServerStats stats;      // loop thread only
+    pthread_mutex_t statsLock;
+    KimiRunStreamServerStats published;  // guarded by statsLock
+    pthread_mutex_t postLock;
+    KimiRunStreamPost *postHead;         // guarded by postLock
+    KimiRunStreamPost *postTail;
+};
+
+static bool KimiRunStreamSetNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return false;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+static bool KimiRunStreamWouldBlock(int error) {
+    return (error == EAGAIN || error == EWOULDBLOCK);
+}
+
+KimiRunStreamServer *KimiRunStreamServerCreate(const KimiRunStreamServerConfig *config,
+                                               const KimiRunStreamCallbacks *callbacks) {
+    if (!callbacks || !callbacks->onFrame) {
+        errno = EINVAL;
+        return NULL;
+    }
+    KimiRunStreamServer *server = calloc(1, sizeof(*server));
+    if (!server) {
+        return NULL;
+    }
+    if (config) {
+        server->config = *config;
+    }
+    if (server->config.maxConnections == 0) {
+        server->config.maxConnections = KIMIRUN_STREAM_DEFAULT_MAX_CONNECTIONS;
+    }
+    if (server->config.maxFrameBytes == 0) {
+        server->config.maxFrameBytes = KIMIRUN_STREAM_DEFAULT_MAX_FRAME;
+    }
+    if (server->config.maxOutputBytes == 0) {
+        server->config.maxOutputBytes = KIMIRUN_STREAM_DEFAULT_MAX_OUTPUT;
+    }
+    server->callbacks = *callbacks;
+    server->listenFD = -1;
+    server->wakeFDs[0] = -1;
+    server->wakeFDs[1] = -1;
+    server->nextIdentifier = 1;
+    atomic_init(&server->stopping, false);
+    pthread_mutex_init(&server->statsLock, NULL);
+    pthread_mutex_init(&server->postLock, NULL);
+
+    uint32_t slots = server->config.maxConnections;
+    server->connections = calloc(slots, sizeof(*server->connections));
+    server->pollFDs = calloc(slots + 2, sizeof(*server->pollFDs));
+    server->polled = calloc(slots + 2, sizeof(*server->polled));
+    if (!server->connections || !server->pollFDs || !server->polled ||
+        pipe(server->wakeFDs) != 0) {
+        int saved = errno ? errno : ENOMEM;
+        KimiRunStreamServerDestroy(server);
+        errno = saved;
+        return NULL;
+    }
+    KimiRunStreamSetNonBlocking(server->wakeFDs[0]);
+    KimiRunStreamSetNonBlocking(server->wakeFDs[1]);
+    return server;
+}
+
+bool KimiRunStreamServerListenTCP(KimiRunStreamServer *server,
+                                  const char *address,
+                                  uint16_t port,
+                                  uint16_t *boundPort) {
+    if (!server || server->listenFD >= 0) {
+        errno = EINVAL;
+        return false;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (address && address[0] != '\0' && inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+        close(fd);
+        errno = EINVAL;
+        return false;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, 64) != 0 ||
+        !KimiRunStreamSetNonBlocking(fd)) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return false;
+    }
+    if (boundPort) {
+        socklen_t len = sizeof(addr);
+        *boundPort = (getsockname(fd, (struct sockaddr *)&addr, &len) == 0) ? ntohs(addr.sin_port) : port;
+    }
+    server->listenFD = fd;
+    return true;
+}
+
+static void KimiRunStreamPublishStats(KimiRunStreamServer *server) {
+    pthread_mutex_lock(&server->statsLock);
+    server->published = server->stats;
+    pthread_mutex_unlock(&server->statsLock);
+}
+
+void KimiRunStreamServerGetStats(KimiRunStreamServer *server, KimiRunStreamServerStats *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!server) {
+        return;
+    }
+    pthread_mutex_lock(&server->statsLock);
+    *out = server->published;
+    pthread_mutex_unlock(&server->statsLock);
+}
+
+void KimiRunStreamServerStop(KimiRunStreamServer *server) {
+    if (!server) {
+        return;
+    }
+    atomic_store(&server->stopping, true);
+    if (server->wakeFDs[1] >= 0) {
+        uint8_t byte = 1;
+        ssize_t ignored = write(server->wakeFDs[1], &byte, 1);
+        (void)ignored;
+    }
+}
+
+bool KimiRunStreamServerPost(KimiRunStreamServer *server,
+                             uint64_t connectionID,
+                             const void *bytes,
+                             size_t length) {
+    if (!server || length == 0) {
+        return (server != NULL);
+    }
+    KimiRunStreamPost *post = malloc(sizeof(*post) + length);
+    if (!post) {
+        return false;
+    }
+    post->next = NULL;
+    post->connectionID = connectionID;
+    post->length = length;
+    memcpy(post->bytes, bytes, length);
+
+    pthread_mutex_lock(&server->postLock);
+    bool wake = (server->postHead == NULL);
+    if (server->postTail) {
+        server->postTail->next = post;
+    } else {
+        server->postHead = post;
+    }
+    server->postTail = post;
+    pthread_mutex_unlock(&server->postLock);
+
+    // A non-empty list already has a wake byte in flight.
+    if (wake && server->wakeFDs[1] >= 0) {
+        uint8_t byte = 1;
+        ssize_t ignored = write(server->wakeFDs[1], &byte, 1);
+        (void)ignored;
+    }
+    return true;
+}
+
+static KimiRunStreamPost *KimiRunStreamTakePosts(KimiRunStreamServer *server) {
+    pthread_mutex_lock(&server->postLock);
+    KimiRunStreamPost *posts = server->postHead;
+    server->postHead = NULL;
+    server->postTail = NULL;
+    pthread_mutex_unlock(&server->postLock);
+    return posts;
+}
+
+static void KimiRunStreamFreePosts(KimiRunStreamPost *posts) {
+    while (posts) {
+        KimiRunStreamPost *next = posts->next;
+        free(posts);
+        posts = next;
+    }
+}
+
+static void KimiRunStreamDeliverPosts(KimiRunStreamServer *server) {
+    KimiRunStreamPost *posts = KimiRunStreamTakePosts(server);
+    for (KimiRunStreamPost *post = posts; post; post = post->next) {
+        for (uint32_t i = 0; i < server->connectionCount; i++) {
+            KimiRunStreamConnection *conn = server->connections[i];
+            if (conn->identifier == post->connectionID) {
+                if (KimiRunStreamConnectionSend(conn, post->bytes, post->length)) {
+                    server->stats.posted++;
+                }
+                break;
+            }
+        }
+    }
+    KimiRunStreamFreePosts(posts);
+}
+
+static void KimiRunStreamFreeConnection(KimiRunStreamServer *server, KimiRunStreamConnection *conn) {
+    if (server->callbacks.onClose) {
+        server->callbacks.onClose(server->callbacks.context, conn);
+    }
+    if (conn->fd >= 0) {
+        close(conn->fd);
+    }
+    free(conn->in);
+    free(conn->out);
+    free(conn);
+    server->stats.closed++;
+}
+
+static void KimiRunStreamAccept(KimiRunStreamServer *server) {
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int fd = accept(server->listenFD, (struct sockaddr *)&addr, &len);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (server->connectionCount >= server->config.maxConnections || !KimiRunStreamSetNonBlocking(fd)) {
+            server->stats.rejected++;
+            close(fd);
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        KimiRunStreamConnection *conn = calloc(1, sizeof(*conn));
+        size_t inCapacity = (size_t)server->config.maxFrameBytes + KIMIRUN_STREAM_READ_SLACK;
+        uint8_t *in = conn ? malloc(inCapacity) : NULL;
+        if (!conn || !in) {
+            free(conn);
+            close(fd);
+            server->stats.rejected++;
+            continue;
+        }
+        conn->server = server;
+        conn->fd = fd;
+        conn->identifier = server->nextIdentifier++;
+        conn->in = in;
+        conn->inCapacity = inCapacity;
+        conn->framing = KimiRunStreamFramingLine;
+        char host[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+        snprintf(conn->peer, sizeof(conn->peer), "%s:%u", host, (unsigned)ntohs(addr.sin_port));
+
+        server->connections[server->connectionCount++] = conn;
+        server->stats.accepted++;
+        server->stats.active = server->connectionCount;
+        if (server->stats.active > server->stats.peakActive) {
+            server->stats.peakActive = server->stats.active;
+        }
+        if (server->callbacks.onOpen) {
+            server->callbacks.onOpen(server->callbacks.context, conn);
+        }
+    }
+}
+
+static void KimiRunStreamDeliver(KimiRunStreamServer *server,
+                                 KimiRunStreamConnection *conn,
+                                 const uint8_t *bytes,
+                                 size_t length) {
+    server->stats.frames++;
+    server->callbacks.onFrame(server->callbacks.context, conn, bytes, length);
+}
+
+static void KimiRunStreamOversize(KimiRunStreamServer *server, KimiRunStreamConnection *conn) {
+    server->stats.oversized++;
+    if (server->callbacks.onOversize) {
+        server->callbacks.onOversize(server->callbacks.context, conn);
+    }
+}
+
+// Deliver every complete frame in the receive buffer and keep the tail.
+// atEOF delivers an unterminated final line as well.
+static void KimiRunStreamDrainInput(KimiRunStreamServer *server, KimiRunStreamConnection *conn, bool atEOF) {
+    size_t maxFrame = server->config.maxFrameBytes;
+    size_t consumed = 0;
+    while (!conn->closing && !conn->dead && consumed < conn->inLength) {
+        const uint8_t *start = conn->in + consumed;
+        size_t available = conn->inLength - consumed;
+
+        if (conn->framing == KimiRunStreamFramingFixed) {
+            if (available < conn->recordSize) {
+                break;
+            }
+            consumed += conn->recordSize;
+            KimiRunStreamDeliver(server, conn, start, conn->recordSize);
+            continue;
+        }
+
+        const uint8_t *newline = memchr(start, '\n', available);
+        if (!newline) {
+            if (conn->discarding) {
+                consumed = conn->inLength;
+            } else if (available > maxFrame) {
+                conn->discarding = true;
+                consumed = conn->inLength;
+                KimiRunStreamOversize(server, conn);
+            } else if (atEOF) {
+                consumed = conn->inLength;
+                size_t length = available;
+                if (length > 0 && start[length - 1] == '\r') {
+                    length--;
+                }
+                KimiRunStreamDeliver(server, conn, start, length);
+            }
+            break;
+        }
+
+        size_t length = (size_t)(newline - start);
+        consumed += length + 1;
+        if (conn->discarding) {
+            conn->discarding = false;
+            continue;
+        }
+        if (length > maxFrame) {
+            KimiRunStreamOversize(server, conn);
+            continue;
+        }
+        if (length > 0 && start[length - 1] == '\r') {
+            length--;
+        }
+        KimiRunStreamDeliver(server, conn, start, length);
+    }
+
+    if (consumed >= conn->inLength) {
+        conn->inLength = 0;
+    } else if (consumed > 0) {
+        memmove(conn->in, conn->in + consumed, conn->inLength - consumed);
+        conn->inLength -= consumed;
+    }
+}
+
+static void KimiRunStreamRead(KimiRunStreamServer *server, KimiRunStreamConnection *conn) {
+    for (int i = 0; i < KIMIRUN_STREAM_READS_PER_WAKE && !conn->closing && !conn->dead; i++) {
+        size_t space = conn->inCapacity - conn->inLength;
+        ssize_t n = recv(conn->fd, conn->in + conn->inLength, space, 0);
+        if (n > 0) {
+            conn->inLength += (size_t)n;
+            server->stats.bytesIn += (uint64_t)n;
+            KimiRunStreamDrainInput(server, conn, false);
+            if ((size_t)n < space) {
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            KimiRunStreamDrainInput(server, conn, true);
+            conn->closing = true;
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (!KimiRunStreamWouldBlock(errno)) {
+            conn->dead = true;
+        }
+        return;
+    }
+}
+
+static void KimiRunStreamFlush(KimiRunStreamServer *server, KimiRunStreamConnection *conn) {
+    while (!conn->dead && conn->outOffset < conn->outLength) {
+        ssize_t n = send(conn->fd, conn->out + conn->outOffset,
+                         conn->outLength - conn->outOffset, KIMIRUN_STREAM_SEND_FLAGS);
+        if (n > 0) {
+            conn->outOffset += (size_t)n;
+            server->stats.bytesOut += (uint64_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && KimiRunStreamWouldBlock(errno)) {
+            return;
+        }
+        conn->dead = true;
+        return;
+    }
+    conn->outOffset = 0;
+    conn->outLength = 0;
+}
+
+bool KimiRunStreamConnectionSend(KimiRunStreamConnection *conn, const void *bytes, size_t length) {
+    if (!conn || conn->dead) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    KimiRunStreamServer *server = conn->server;
+    const uint8_t *cursor = (const uint8_t *)bytes;
+
+    // Nothing queued: write straight to the socket and only buffer the rest.
+    if (conn->outOffset == conn->outLength) {
+        conn->outOffset = 0;
+        conn->outLength = 0;
+        while (length > 0) {
+            ssize_t n = send(conn->fd, cursor, length, KIMIRUN_STREAM_SEND_FLAGS);
+            if (n > 0) {
+                cursor += n;
+                length -= (size_t)n;
+                server->stats.bytesOut += (uint64_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && KimiRunStreamWouldBlock(errno)) {
+                break;
+            }
+            conn->dead = true;
+            return false;
+        }
+        if (length == 0) {
+            return true;
+        }
+    }
+
+    size_t pending = conn->outLength - conn->outOffset;
+    if (pending + length > server->config.maxOutputBytes) {
+        server->stats.slowClientsDropped++;
+        conn->dead = true;
+        return false;
+    }
+    if (conn->outOffset > 0) {
+        memmove(conn->out, conn->out + conn->outOffset, pending);
+        conn->outOffset = 0;
+        conn->outLength = pending;
+    }
+    if (conn->outLength + length > conn->outCapacity) {
+        size_t capacity = conn->outCapacity ? conn->outCapacity : 1024;
+        while (capacity < conn->outLength + length) {
+            capacity *= 2;
+        }
+        uint8_t *grown = realloc(conn->out, capacity);
+        if (!grown) {
+            conn->dead = true;
+            return false;
+        }
+        conn->out = grown;
+        conn->outCapacity = capacity;
+    }
+    memcpy(conn->out + conn->outLength, cursor, length);
+    conn->outLength += length;
+    return true;
+}
+
+void KimiRunStreamConnectionSetFraming(KimiRunStreamConnection *conn,
+                                       KimiRunStreamFraming framing,
+                                       uint32_t recordSize) {
+    if (!conn) {
+        return;
+    }
+    if (framing == KimiRunStreamFramingFixed) {
+        uint32_t maxFrame = conn->server->config.maxFrameBytes;
+        if (recordSize == 0 || recordSize > maxFrame) {
+            return;
+        }
+        conn->recordSize = recordSize;
+    }
+    conn->framing = framing;
+    conn->discarding = false;
+}
+
+void KimiRunStreamConnectionClose(KimiRunStreamConnection *conn) {
+    if (conn) {
+        conn->closing = true;
+    }
+}
+
+void KimiRunStreamConnectionSetUserData(KimiRunStreamConnection *conn, void *userData) {
+    if (conn) {
+        conn->userData = userData;
+    }
+}
+
+void *KimiRunStreamConnectionUserData(const KimiRunStreamConnection *conn) {
+    return conn ? conn->userData : NULL;
+}
+
+uint64_t KimiRunStreamConnectionID(const KimiRunStreamConnection *conn) {
+    return conn ? conn->identifier : 0;
+}
+
+const char *KimiRunStreamConnectionPeer(const KimiRunStreamConnection *conn) {
+    return conn ? conn->peer : "";
+}
+
+static void KimiRunStreamReap(KimiRunStreamServer *server) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < server->connectionCount; i++) {
+        KimiRunStreamConnection *conn = server->connections[i];
+        if (conn->closing && conn->outOffset == conn->outLength) {
+            conn->dead = true;
+        }
+        if (conn->dead) {
+            KimiRunStreamFreeConnection(server, conn);
+        } else {
+            server->connections[kept++] = conn;
+        }
+    }
+    server->connectionCount = kept;
+    server->stats.active = kept;
+}
+
+bool KimiRunStreamServerRun(KimiRunStreamServer *server) {
+    if (!server || server->listenFD < 0) {
+        errno = EINVAL;
+        return false;
+    }
+    bool ok = true;
+    while (!atomic_load(&server->stopping)) {
+        nfds_t count = 0;
+        server->pollFDs[count].fd = server->wakeFDs[0];
+        server->pollFDs[count].events = POLLIN;
+        server->polled[count++] = NULL;
+        server->pollFDs[count].fd = server->listenFD;
+        server->pollFDs[count].events = POLLIN;
+        server->polled[count++] = NULL;
+        for (uint32_t i = 0; i < server->connectionCount; i++) {
+            KimiRunStreamConnection *conn = server->connections[i];
+            short events = 0;
+            if (!conn->closing) {
+                events |= POLLIN;
+            }
+            if (conn->outOffset < conn->outLength) {
+                events |= POLLOUT;
+            }
+            server->pollFDs[count].fd = conn->fd;
+            server->pollFDs[count].events = events;
+            server->polled[count++] = conn;
+        }
+
+        int ready = poll(server->pollFDs, count, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+
+        if (server->pollFDs[0].revents & POLLIN) {
+            uint8_t scratch[64];
+            while (read(server->wakeFDs[0], scratch, sizeof(scratch)) > 0) {
+            }
+            KimiRunStreamDeliverPosts(server);
+        }
+        for (nfds_t i = 2; i < count; i++) {
+            KimiRunStreamConnection *conn = server->polled[i];
+            short revents = server->pollFDs[i].revents;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) {
+                KimiRunStreamRead(server, conn);
+            }
+            if (revents & POLLNVAL) {
+                conn->dead = true;
+            }
+            if (conn->outOffset < conn->outLength) {
+                KimiRunStreamFlush(server, conn);
+            }
+        }
+        KimiRunStreamReap(server);
+        if (server->pollFDs[1].revents & POLLIN) {
+            KimiRunStreamAccept(server);
+        }
+        KimiRunStreamPublishStats(server);
+    }
+
+    for (uint32_t i = 0; i < server->connectionCount; i++) {
+        KimiRunStreamConnection *conn = server->connections[i];
+        KimiRunStreamFlush(server, conn);
+        KimiRunStreamFreeConnection(server, conn);
+    }
+    server->connectionCount = 0;
+    server->stats.active = 0;
+    KimiRunStreamPublishStats(server);
+    return ok;
+}
+
+void KimiRunStreamServerDestroy(KimiRunStreamServer *server) {
+    if (!server) {
+        return;
+    }
+    for (uint32_t i = 0; i < server->connectionCount; i++) {
+        KimiRunStreamFreeConnection(server, server->connections[i]);
+    }
+    if (server->listenFD >= 0) {
+        close(server->listenFD);
+    }
+    if (server->wakeFDs[0] >= 0) {
+        close(server->wakeFDs[0]);
+    }
+    if (server->wakeFDs[1] >= 0) {
+        close(server->wakeFDs[1]);
+    }
+    KimiRunStreamFreePosts(KimiRunStreamTakePosts(server));
+    pthread_mutex_destroy(&server->statsLock);
+    pthread_mutex_destroy(&server->postLock);
+    free(server->connections);
+    free(server->pollFDs);
+    free(server->polled);
+    free(server);
+}
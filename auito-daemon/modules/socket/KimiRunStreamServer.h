@@ -0,0 +1,142 @@
+//
+//  KimiRunStreamServer.h
+//  KimiRun - Nonblocking Multi-Client Stream Server
+//
+//  Portable C (POSIX sockets + poll). One thread runs a poll() loop over the
+//  listening socket and every client connection. Each connection has its own
+//  receive buffer, so commands split across TCP segments are reassembled and
+//  commands coalesced into one segment are delivered one at a time. Frames
+//  are either newline-terminated lines (a trailing '\r' is stripped) or
+//  fixed-size records; a callback may switch a connection's framing at any
+//  frame boundary. Replies are queued per connection and flushed when the
+//  socket is writable, so a slow reader never blocks the loop.
+//
+//  All callbacks and every KimiRunStreamConnection* call run on the loop
+//  thread. Only KimiRunStreamServerStop(), KimiRunStreamServerGetStats() and
+//  KimiRunStreamServerPost() may be called from other threads.
+//
+
+#ifndef KIMIRUN_STREAM_SERVER_H
+#define KIMIRUN_STREAM_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_STREAM_DEFAULT_MAX_CONNECTIONS 64
+#define KIMIRUN_STREAM_DEFAULT_MAX_FRAME 4096          // longest line accepted
+#define KIMIRUN_STREAM_DEFAULT_MAX_OUTPUT (256 * 1024) // queued reply bytes before a client is dropped
+
+typedef enum {
+    KimiRunStreamFramingLine = 0,   // '\n'-terminated, '\r' before it stripped
+    KimiRunStreamFramingFixed = 1   // recordSize bytes per frame
+} KimiRunStreamFraming;
+
+typedef struct KimiRunStreamServer KimiRunStreamServer;
+typedef struct KimiRunStreamConnection KimiRunStreamConnection;
+
+typedef struct {
+    void *context;
+    /** A client was accepted. Optional. */
+    void (*onOpen)(void *context, KimiRunStreamConnection *conn);
+    /** One complete frame. bytes is only valid for the duration of the call. */
+    void (*onFrame)(void *context, KimiRunStreamConnection *conn, const uint8_t *bytes, size_t length);
+    /**
+     * A line grew past maxFrameBytes without a terminator. The partial line
+     * is discarded up to and including the next '\n'. Optional.
+     */
+    void (*onOversize)(void *context, KimiRunStreamConnection *conn);
+    /** The connection is about to be closed and freed. Optional. */
+    void (*onClose)(void *context, KimiRunStreamConnection *conn);
+} KimiRunStreamCallbacks;
+
+typedef struct {
+    uint32_t maxConnections;     // 0 == KIMIRUN_STREAM_DEFAULT_MAX_CONNECTIONS
+    uint32_t maxFrameBytes;      // 0 == KIMIRUN_STREAM_DEFAULT_MAX_FRAME
+    uint32_t maxOutputBytes;     // 0 == KIMIRUN_STREAM_DEFAULT_MAX_OUTPUT
+} KimiRunStreamServerConfig;
+
+typedef struct {
+    uint64_t accepted;
+    uint64_t rejected;           // over maxConnections
+    uint64_t closed;
+    uint64_t frames;
+    uint64_t oversized;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint64_t slowClientsDropped; // over maxOutputBytes
+    uint64_t posted;             // KimiRunStreamServerPost() messages delivered
+    uint32_t active;
+    uint32_t peakActive;
+} KimiRunStreamServerStats;
+
+/** NULL config uses the defaults. Returns NULL with errno set on failure. */
+KimiRunStreamServer *KimiRunStreamServerCreate(const KimiRunStreamServerConfig *config,
+                                               const KimiRunStreamCallbacks *callbacks);
+
+/**
+ * Bind and listen on an IPv4 address ("0.0.0.0" when NULL). port 0 picks an
+ * ephemeral port; the bound port is returned through boundPort. Returns
+ * false with errno set on failure.
+ */
+bool KimiRunStreamServerListenTCP(KimiRunStreamServer *server,
+                                  const char *address,
+                                  uint16_t port,
+                                  uint16_t *boundPort);
+
+/** Run the loop on the calling thread until KimiRunStreamServerStop(). */
+bool KimiRunStreamServerRun(KimiRunStreamServer *server);
+
+/** Thread-safe. Wakes the loop; Run() closes every connection and returns. */
+void KimiRunStreamServerStop(KimiRunStreamServer *server);
+
+/** Thread-safe snapshot of the counters. */
+void KimiRunStreamServerGetStats(KimiRunStreamServer *server, KimiRunStreamServerStats *out);
+
+/**
+ * Thread-safe. Queue bytes for the connection with the given id and wake the
+ * loop, which sends them as KimiRunStreamConnectionSend() would. Bytes for a
+ * connection that has closed by then are dropped. Returns false when the
+ * copy can't be allocated.
+ */
+bool KimiRunStreamServerPost(KimiRunStreamServer *server,
+                             uint64_t connectionID,
+                             const void *bytes,
+                             size_t length);
+
+/** Closes the listener and frees the server. Run() must have returned. */
+void KimiRunStreamServerDestroy(KimiRunStreamServer *server);
+
+/**
+ * Queue bytes for the client and try to write them immediately. Returns
+ * false when the connection is closing or the output cap was exceeded (the
+ * connection is then dropped).
+ */
+bool KimiRunStreamConnectionSend(KimiRunStreamConnection *conn, const void *bytes, size_t length);
+
+/** Switch framing; takes effect from the next frame. recordSize is for Fixed. */
+void KimiRunStreamConnectionSetFraming(KimiRunStreamConnection *conn,
+                                       KimiRunStreamFraming framing,
+                                       uint32_t recordSize);
+
+/** Stop reading; queued output is flushed before the socket is closed. */
+void KimiRunStreamConnectionClose(KimiRunStreamConnection *conn);
+
+void KimiRunStreamConnectionSetUserData(KimiRunStreamConnection *conn, void *userData);
+void *KimiRunStreamConnectionUserData(const KimiRunStreamConnection *conn);
+
+/** Monotonic per-server connection id (starts at 1). */
+uint64_t KimiRunStreamConnectionID(const KimiRunStreamConnection *conn);
+
+/** Peer address as "a.b.c.d:port". */
+const char *KimiRunStreamConnectionPeer(const KimiRunStreamConnection *conn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
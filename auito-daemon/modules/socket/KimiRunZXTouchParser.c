@@ -0,0 +1,180 @@
+//
+//  KimiRunZXTouchParser.c
+//  KimiRun - ZXTouch Command Parser
+//
+
+#include "KimiRunZXTouchParser.h"
+
+#include <string.h>
+
+#define KIMIRUN_ZXTOUCH_MAX_TAP_DIGITS 7
+
+static bool KimiRunZXIsSpace(uint8_t c) {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f');
+}
+
+static bool KimiRunZXIsDigit(uint8_t c) {
+    return (c >= '0' && c <= '9');
+}
+
+// Fixed-width unsigned decimal; false on any non-digit.
+static bool KimiRunZXDigits(const uint8_t *bytes, size_t count, uint32_t *out) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!KimiRunZXIsDigit(bytes[i])) {
+            return false;
+        }
+        value = (value * 10) + (uint32_t)(bytes[i] - '0');
+    }
+    *out = value;
+    return true;
+}
+
+// [+-]digits[.digits] or [+-].digits, ending at a space or the end of the
+// line. Advances *cursor past the number. The integer part is capped so
+// garbage can't overflow the float; no screen coordinate comes close.
+static bool KimiRunZXDecimal(const uint8_t **cursor, const uint8_t *end, float *out) {
+    const uint8_t *p = *cursor;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+    double value = 0.0;
+    bool digits = false;
+    int integerDigits = 0;
+    while (p < end && KimiRunZXIsDigit(*p)) {
+        if (++integerDigits > KIMIRUN_ZXTOUCH_MAX_TAP_DIGITS) {
+            return false;
+        }
+        value = (value * 10.0) + (double)(*p - '0');
+        digits = true;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        double scale = 0.1;
+        while (p < end && KimiRunZXIsDigit(*p)) {
+            value += (double)(*p - '0') * scale;
+            scale *= 0.1;
+            digits = true;
+            p++;
+        }
+    }
+    if (!digits || (p < end && !KimiRunZXIsSpace(*p))) {
+        return false;
+    }
+    *out = (float)(negative ? -value : value);
+    *cursor = p;
+    return true;
+}
+
+static KimiRunZXCommandKind KimiRunZXFail(KimiRunZXCommand *out, KimiRunZXParseError error) {
+    out->kind = KimiRunZXCommandInvalid;
+    out->error = error;
+    out->count = 0;
+    return KimiRunZXCommandInvalid;
+}
+
+static KimiRunZXCommandKind KimiRunZXParseTouch(const uint8_t *p, size_t length, KimiRunZXCommand *out) {
+    // p points past the "10" task id.
+    if (length < 1 || !KimiRunZXIsDigit(p[0])) {
+        return KimiRunZXFail(out, KimiRunZXParseBadCount);
+    }
+    uint32_t count = (uint32_t)(p[0] - '0');
+    if (count < 1 || count > KIMIRUN_ZXTOUCH_MAX_RECORDS) {
+        return KimiRunZXFail(out, KimiRunZXParseBadCount);
+    }
+    if (length - 1 < (size_t)count * KIMIRUN_ZXTOUCH_RECORD_CHARS) {
+        return KimiRunZXFail(out, KimiRunZXParseTruncated);
+    }
+    const uint8_t *record = p + 1;
+    for (uint32_t i = 0; i < count; i++, record += KIMIRUN_ZXTOUCH_RECORD_CHARS) {
+        uint32_t type = 0;
+        uint32_t finger = 0;
+        uint32_t x = 0;
+        uint32_t y = 0;
+        if (!KimiRunZXDigits(record, 1, &type) ||
+            !KimiRunZXDigits(record + 1, 2, &finger) ||
+            !KimiRunZXDigits(record + 3, 5, &x) ||
+            !KimiRunZXDigits(record + 8, 5, &y) ||
+            type > KimiRunZXTouchTypeMove) {
+            return KimiRunZXFail(out, KimiRunZXParseBadRecord);
+        }
+        out->records[i].type = (uint8_t)type;
+        out->records[i].finger = (uint8_t)finger;
+        out->records[i].x = (float)x / 10.0f;
+        out->records[i].y = (float)y / 10.0f;
+    }
+    out->count = count;
+    out->kind = KimiRunZXCommandTouch;
+    out->error = KimiRunZXParseOK;
+    return KimiRunZXCommandTouch;
+}
+
+KimiRunZXCommandKind KimiRunZXTouchParse(const uint8_t *bytes, size_t length, KimiRunZXCommand *out) {
+    if (!out) {
+        return KimiRunZXCommandInvalid;
+    }
+    out->count = 0;
+    if (!bytes) {
+        return KimiRunZXFail(out, KimiRunZXParseEmpty);
+    }
+    while (length > 0 && KimiRunZXIsSpace(bytes[0])) {
+        bytes++;
+        length--;
+    }
+    while (length > 0 && KimiRunZXIsSpace(bytes[length - 1])) {
+        length--;
+    }
+    if (length == 0) {
+        return KimiRunZXFail(out, KimiRunZXParseEmpty);
+    }
+    if (length < 3) {
+        return KimiRunZXFail(out, KimiRunZXParseUnknown);
+    }
+
+    if (bytes[0] == '1' && bytes[1] == '0') {
+        return KimiRunZXParseTouch(bytes + 2, length - 2, out);
+    }
+    if (length >= 4 && memcmp(bytes, "TEST", 4) == 0) {
+        out->kind = KimiRunZXCommandTest;
+        out->error = KimiRunZXParseOK;
+        return KimiRunZXCommandTest;
+    }
+    if (length > 4 && memcmp(bytes, "TAP ", 4) == 0) {
+        const uint8_t *cursor = bytes + 4;
+        const uint8_t *end = bytes + length;
+        float x = 0.0f;
+        float y = 0.0f;
+        while (cursor < end && *cursor == ' ') {
+            cursor++;
+        }
+        if (KimiRunZXDecimal(&cursor, end, &x)) {
+            while (cursor < end && *cursor == ' ') {
+                cursor++;
+            }
+            if (KimiRunZXDecimal(&cursor, end, &y)) {
+                out->tapX = x;
+                out->tapY = y;
+                out->kind = KimiRunZXCommandTap;
+                out->error = KimiRunZXParseOK;
+                return KimiRunZXCommandTap;
+            }
+        }
+    }
+    return KimiRunZXFail(out, KimiRunZXParseUnknown);
+}
+
+const char *KimiRunZXTouchErrorReply(KimiRunZXParseError error) {
+    switch (error) {
+        case KimiRunZXParseEmpty: return "ERROR: Empty command\r\n";
+        case KimiRunZXParseBadCount: return "ERROR: Invalid event count\r\n";
+        case KimiRunZXParseTruncated: return "ERROR: Incomplete event data\r\n";
+        case KimiRunZXParseBadRecord: return "ERROR: Invalid event data\r\n";
+        case KimiRunZXParseUnknown:
+        case KimiRunZXParseOK:
+            break;
+    }
+    return "ERROR: Unknown command\r\n";
+}
@@ -0,0 +1,79 @@
+//
+//  KimiRunZXTouchParser.h
+//  KimiRun - ZXTouch Command Parser
+//
+//  Portable C, no allocation. Decodes one framed command line straight from
+//  the receive buffer into a caller-owned (usually stack) command struct:
+//    "10" count(1) { type(1) finger(2) x(5) y(5) } * count   touch records
+//    "TEST"                                                    liveness probe
+//    "TAP <x> <y>"                                             compact tap
+//  Touch coordinates are fixed-width decimal tenths of a point. Leading and
+//  trailing ASCII whitespace is ignored; bytes after the last touch record
+//  are ignored, as ZXTouch servers do.
+//
+
+#ifndef KIMIRUN_ZXTOUCH_PARSER_H
+#define KIMIRUN_ZXTOUCH_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_ZXTOUCH_MAX_RECORDS 9     // the count field is one digit
+#define KIMIRUN_ZXTOUCH_RECORD_CHARS 13
+#define KIMIRUN_ZXTOUCH_TASK_TOUCH 10
+
+// Record types on the wire.
+enum {
+    KimiRunZXTouchTypeUp = 0,
+    KimiRunZXTouchTypeDown = 1,
+    KimiRunZXTouchTypeMove = 2
+};
+
+typedef enum {
+    KimiRunZXCommandInvalid = 0,  // see error
+    KimiRunZXCommandTouch = 1,
+    KimiRunZXCommandTest = 2,
+    KimiRunZXCommandTap = 3
+} KimiRunZXCommandKind;
+
+typedef enum {
+    KimiRunZXParseOK = 0,
+    KimiRunZXParseEmpty,
+    KimiRunZXParseUnknown,
+    KimiRunZXParseBadCount,
+    KimiRunZXParseTruncated,      // fewer bytes than count records
+    KimiRunZXParseBadRecord       // non-digit field or unknown type
+} KimiRunZXParseError;
+
+typedef struct {
+    uint8_t type;                 // KimiRunZXTouchType*
+    uint8_t finger;               // 0..99 as sent
+    float x;                      // points
+    float y;
+} KimiRunZXTouchRecord;
+
+typedef struct {
+    KimiRunZXCommandKind kind;
+    KimiRunZXParseError error;
+    uint32_t count;               // touch records
+    KimiRunZXTouchRecord records[KIMIRUN_ZXTOUCH_MAX_RECORDS];
+    float tapX;                   // TAP
+    float tapY;
+} KimiRunZXCommand;
+
+/** Parse one line (without its terminator). Returns out->kind. */
+KimiRunZXCommandKind KimiRunZXTouchParse(const uint8_t *bytes, size_t length, KimiRunZXCommand *out);
+
+/** The "ERROR: ...\r\n" reply for a parse error (static string). */
+const char *KimiRunZXTouchErrorReply(KimiRunZXParseError error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
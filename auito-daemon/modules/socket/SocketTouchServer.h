@@ -13,5 +13,6 @@
 - (BOOL)startOnPort:(uint16_t)port error:(NSError **)error;
 - (void)stop;
 - (BOOL)isRunning;
+- (NSDictionary *)statistics;
 
 @end
\ No newline at end of file
@@ -7,29 +7,449 @@
 
 #import "SocketTouchServer.h"
 #import "../touch/TouchInjection.h"
-#import <sys/socket.h>
-#import <netinet/in.h>
-#import <arpa/inet.h>
-#import <unistd.h>
-#import <fcntl.h>
+#import "../prefs/KimiRunPrefs.h"
+#import "KimiRunStreamServer.h"
+#import "KimiRunZXTouchParser.h"
+#import "KimiRunBinaryTouch.h"
 #import <errno.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
 
-// ZXTouch Protocol Constants
-#define kZXTouchPort 6000
-#define kZXTouchTaskPerformTouch 10
+#define kSocketTouchMaxFinger 20
+#define kSocketTouchDispatchCapacity 1024
+#define kSocketTouchDispatchReserve KIMIRUN_STREAM_DEFAULT_MAX_CONNECTIONS // close markers
+#define kSocketTouchDispatchBatch 64
+#define kSocketTouchLatencyBuckets 24      // log2 microseconds
+#define kSocketTouchMaxPlayoutMs 100
 
-// Touch event types
-#define kZXTouchUp   0
-#define kZXTouchDown 1
-#define kZXTouchMove 2
+// Per-connection state, stored as the stream connection's user data.
+typedef struct {
+    uint32_t fingers;                      // ZXTouch fingers held (server thread)
+    bool binary;                           // switched to 16-byte records
+    uint32_t playoutMicros;                // server thread
+    KimiRunBTouchPlayout playout;          // server thread
+    uint32_t binaryFingers;                // dispatcher, applied on main
+} SocketTouchClient;
+
+// One binary record (or a close marker) waiting for its due time.
+typedef struct {
+    SocketTouchClient *client;
+    uint64_t connectionID;
+    KimiRunBTouchRecord record;
+    bool valid;
+    bool closing;                          // lift the client's fingers and free it
+    uint64_t receivedMicros;
+    uint64_t dueMicros;
+    uint64_t order;                        // arrival order, breaks due-time ties
+} SocketTouchDispatchItem;
+
+// Timed dispatcher for binary records. Items wait in a min-heap on due time,
+// so one connection's playout delay never holds up another's records; a
+// connection's own due times never go backwards, which keeps it in order.
+// One thread waits for the earliest due time, applies every due record in a
+// single main-queue pass and posts one ack per connection.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    KimiRunStreamServer *server;           // NULL once stopping
+    bool stopping;
+    uint32_t count;
+    uint64_t nextOrder;
+    uint64_t records;
+    uint64_t applied;
+    uint64_t failed;
+    uint64_t overflows;
+    uint64_t batches;
+    uint64_t acks;
+    uint64_t latencyTotalMicros;
+    uint32_t latencyLastMicros;
+    uint32_t latencyMaxMicros;
+    uint64_t latencyBuckets[kSocketTouchLatencyBuckets];
+    SocketTouchDispatchItem items[kSocketTouchDispatchCapacity];   // min-heap on (dueMicros, order)
+} SocketTouchDispatcher;
+
+static mach_timebase_info_data_t SocketTouchTimebase(void) {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return timebase;
+}
+
+static uint64_t SocketTouchNowMicros(void) {
+    mach_timebase_info_data_t timebase = SocketTouchTimebase();
+    return (mach_absolute_time() * timebase.numer / timebase.denom) / NSEC_PER_USEC;
+}
+
+static uint32_t SocketTouchPlayoutMicros(void) {
+    NSInteger ms = KimiRunPrefsEnvInteger("KIMIRUN_TOUCH_STREAM_PLAYOUT_MS",
+                                          KimiRunPrefsInteger(@"TouchStreamPlayoutMs", 8));
+    ms = MAX(0, MIN(ms, kSocketTouchMaxPlayoutMs));
+    return (uint32_t)ms * 1000;
+}
+
+static void SocketTouchLiftFingers(uint32_t fingers) {
+    for (NSInteger finger = 0; finger < kSocketTouchMaxFinger; finger++) {
+        if (fingers & (1u << finger)) {
+            [KimiRunTouchInjection liftStreamedFinger:finger];
+        }
+    }
+}
+
+static bool SocketTouchDispatchItemBefore(const SocketTouchDispatchItem *a, const SocketTouchDispatchItem *b) {
+    return a->dueMicros < b->dueMicros || (a->dueMicros == b->dueMicros && a->order < b->order);
+}
+
+static void SocketTouchDispatchSwap(SocketTouchDispatcher *dispatcher, uint32_t a, uint32_t b) {
+    SocketTouchDispatchItem swap = dispatcher->items[a];
+    dispatcher->items[a] = dispatcher->items[b];
+    dispatcher->items[b] = swap;
+}
+
+// Caller holds the lock and count > 0.
+static SocketTouchDispatchItem SocketTouchDispatcherPopLocked(SocketTouchDispatcher *dispatcher) {
+    SocketTouchDispatchItem top = dispatcher->items[0];
+    dispatcher->items[0] = dispatcher->items[--dispatcher->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t smallest = i;
+        uint32_t left = (2 * i) + 1;
+        uint32_t right = left + 1;
+        if (left < dispatcher->count && SocketTouchDispatchItemBefore(&dispatcher->items[left], &dispatcher->items[smallest])) {
+            smallest = left;
+        }
+        if (right < dispatcher->count && SocketTouchDispatchItemBefore(&dispatcher->items[right], &dispatcher->items[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        SocketTouchDispatchSwap(dispatcher, i, smallest);
+        i = smallest;
+    }
+    return top;
+}
+
+static bool SocketTouchDispatcherPush(SocketTouchDispatcher *dispatcher, const SocketTouchDispatchItem *item) {
+    if (!dispatcher) {
+        return false;
+    }
+    pthread_mutex_lock(&dispatcher->lock);
+    uint32_t limit = item->closing ? kSocketTouchDispatchCapacity
+                                   : kSocketTouchDispatchCapacity - kSocketTouchDispatchReserve;
+    if (dispatcher->stopping || dispatcher->count >= limit) {
+        if (!item->closing) {
+            dispatcher->overflows++;
+        }
+        pthread_mutex_unlock(&dispatcher->lock);
+        return false;
+    }
+    uint32_t i = dispatcher->count++;
+    dispatcher->items[i] = *item;
+    dispatcher->items[i].order = dispatcher->nextOrder++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!SocketTouchDispatchItemBefore(&dispatcher->items[i], &dispatcher->items[parent])) {
+            break;
+        }
+        SocketTouchDispatchSwap(dispatcher, i, parent);
+        i = parent;
+    }
+    if (!item->closing) {
+        dispatcher->records++;
+    }
+    pthread_cond_signal(&dispatcher->cond);
+    pthread_mutex_unlock(&dispatcher->lock);
+    return true;
+}
+
+typedef struct {
+    uint64_t connectionID;
+    KimiRunBTouchAck ack;
+} SocketTouchPendingAck;
+
+static void SocketTouchDispatcherApply(SocketTouchDispatcher *dispatcher,
+                                       SocketTouchDispatchItem *batch,
+                                       uint32_t count) {
+    uint64_t appliedAt[kSocketTouchDispatchBatch];
+    bool succeeded[kSocketTouchDispatchBatch];
+    uint64_t *appliedAtOut = appliedAt;
+    bool *succeededOut = succeeded;
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        for (uint32_t i = 0; i < count; i++) {
+            SocketTouchDispatchItem *item = &batch[i];
+            SocketTouchClient *client = item->client;
+            succeededOut[i] = false;
+            if (item->closing) {
+                SocketTouchLiftFingers(client->binaryFingers);
+                client->binaryFingers = 0;
+                continue;
+            }
+            if (!item->valid) {
+                continue;
+            }
+            // Wire phases share KimiRunTouchStreamPhase's values.
+            KimiRunTouchStreamPhase phase = (KimiRunTouchStreamPhase)item->record.phase;
+            NSInteger finger = item->record.finger;
+            BOOL result = [KimiRunTouchInjection streamTouchPhase:phase
+                                                           finger:finger
+                                                              atX:item->record.x
+                                                                Y:item->record.y];
+            if (phase == KimiRunTouchStreamPhaseUp) {
+                client->binaryFingers &= ~(1u << finger);
+            } else if (result) {
+                client->binaryFingers |= (1u << finger);
+            }
+            succeededOut[i] = result;
+            appliedAtOut[i] = SocketTouchNowMicros();
+        }
+    });
+
+    // One ack per connection, for the last record it had in this pass.
+    SocketTouchPendingAck acks[kSocketTouchDispatchBatch];
+    uint32_t ackCount = 0;
+    uint64_t applied = 0;
+    uint64_t failed = 0;
+    pthread_mutex_lock(&dispatcher->lock);
+    for (uint32_t i = 0; i < count; i++) {
+        SocketTouchDispatchItem *item = &batch[i];
+        if (item->closing) {
+            continue;
+        }
+        SocketTouchPendingAck *pending = NULL;
+        for (uint32_t j = 0; j < ackCount; j++) {
+            if (acks[j].connectionID == item->connectionID) {
+                pending = &acks[j];
+                break;
+            }
+        }
+        if (!pending) {
+            pending = &acks[ackCount++];
+            memset(pending, 0, sizeof(*pending));
+            pending->connectionID = item->connectionID;
+        }
+        pending->ack.sequence = item->record.sequence;
+        pending->ack.clientMicros = item->record.clientMicros;
+        pending->ack.count++;
+        if (!succeeded[i]) {
+            failed++;
+            pending->ack.latencyMicros = 0;
+            if (pending->ack.failed < UINT8_MAX) {
+                pending->ack.failed++;
+            }
+            continue;
+        }
+        uint64_t latency = appliedAt[i] > item->receivedMicros ? appliedAt[i] - item->receivedMicros : 0;
+        uint32_t latencyMicros = (uint32_t)MIN(latency, (uint64_t)UINT32_MAX);
+        pending->ack.latencyMicros = latencyMicros;
+        applied++;
+        dispatcher->latencyTotalMicros += latencyMicros;
+        dispatcher->latencyLastMicros = latencyMicros;
+        dispatcher->latencyMaxMicros = MAX(dispatcher->latencyMaxMicros, latencyMicros);
+        uint32_t bucket = 0;
+        while ((latencyMicros >> (bucket + 1)) != 0 && bucket + 1 < kSocketTouchLatencyBuckets) {
+            bucket++;
+        }
+        dispatcher->latencyBuckets[bucket]++;
+    }
+    dispatcher->applied += applied;
+    dispatcher->failed += failed;
+    dispatcher->batches++;
+    // Posting under the lock keeps the server alive until stop clears it.
+    if (dispatcher->server) {
+        for (uint32_t j = 0; j < ackCount; j++) {
+            uint8_t bytes[KIMIRUN_BTOUCH_ACK_SIZE];
+            KimiRunBTouchEncodeAck(&acks[j].ack, bytes);
+            if (KimiRunStreamServerPost(dispatcher->server, acks[j].connectionID, bytes, sizeof(bytes))) {
+                dispatcher->acks++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&dispatcher->lock);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (batch[i].closing) {
+            free(batch[i].client);
+        }
+    }
+}
+
+static void *SocketTouchDispatcherThread(void *arg) {
+    SocketTouchDispatcher *dispatcher = (SocketTouchDispatcher *)arg;
+    pthread_setname_np("SocketTouchDispatch");
+    SocketTouchDispatchItem batch[kSocketTouchDispatchBatch];
+    for (;;) {
+        pthread_mutex_lock(&dispatcher->lock);
+        while (!dispatcher->stopping && dispatcher->count == 0) {
+            pthread_cond_wait(&dispatcher->cond, &dispatcher->lock);
+        }
+        if (dispatcher->stopping) {
+            pthread_mutex_unlock(&dispatcher->lock);
+            break;
+        }
+        uint64_t due = dispatcher->items[0].dueMicros;
+        pthread_mutex_unlock(&dispatcher->lock);
+
+        uint64_t now = SocketTouchNowMicros();
+        if (due > now) {
+            mach_timebase_info_data_t timebase = SocketTouchTimebase();
+            uint64_t ticks = ((due - now) * NSEC_PER_USEC * timebase.denom) / timebase.numer;
+            mach_wait_until(mach_absolute_time() + ticks);
+            now = SocketTouchNowMicros();
+        }
+
+        uint32_t count = 0;
+        pthread_mutex_lock(&dispatcher->lock);
+        while (count < kSocketTouchDispatchBatch && dispatcher->count > 0 &&
+               dispatcher->items[0].dueMicros <= now) {
+            batch[count++] = SocketTouchDispatcherPopLocked(dispatcher);
+        }
+        pthread_mutex_unlock(&dispatcher->lock);
+        if (count > 0) {
+            SocketTouchDispatcherApply(dispatcher, batch, count);
+        }
+    }
+
+    // Stopped: the stream server has closed every client, so each one has a
+    // close marker queued. Drop pending records, lift what is still down.
+    uint32_t fingers = 0;
+    for (uint32_t i = 0; i < dispatcher->count; i++) {
+        SocketTouchDispatchItem *item = &dispatcher->items[i];
+        if (item->closing) {
+            fingers |= item->client->binaryFingers;
+            free(item->client);
+        }
+    }
+    if (fingers != 0) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            SocketTouchLiftFingers(fingers);
+        });
+    }
+    pthread_mutex_destroy(&dispatcher->lock);
+    pthread_cond_destroy(&dispatcher->cond);
+    free(dispatcher);
+    return NULL;
+}
+
+static SocketTouchDispatcher *SocketTouchDispatcherCreate(KimiRunStreamServer *server) {
+    SocketTouchDispatcher *dispatcher = calloc(1, sizeof(*dispatcher));
+    if (!dispatcher) {
+        return NULL;
+    }
+    pthread_mutex_init(&dispatcher->lock, NULL);
+    pthread_cond_init(&dispatcher->cond, NULL);
+    dispatcher->server = server;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_set_qos_class_np(&attr, QOS_CLASS_USER_INTERACTIVE, 0);
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, SocketTouchDispatcherThread, dispatcher);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        pthread_mutex_destroy(&dispatcher->lock);
+        pthread_cond_destroy(&dispatcher->cond);
+        free(dispatcher);
+        return NULL;
+    }
+    return dispatcher;
+}
+
+// The thread frees the dispatcher once it has drained; don't touch it after.
+static void SocketTouchDispatcherStop(SocketTouchDispatcher *dispatcher) {
+    if (!dispatcher) {
+        return;
+    }
+    pthread_mutex_lock(&dispatcher->lock);
+    dispatcher->stopping = true;
+    dispatcher->server = NULL;
+    pthread_cond_signal(&dispatcher->cond);
+    pthread_mutex_unlock(&dispatcher->lock);
+}
+
+static uint32_t SocketTouchLatencyPercentile(const SocketTouchDispatcher *dispatcher, uint64_t total, double fraction) {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)ceil((double)total * fraction);
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < kSocketTouchLatencyBuckets; bucket++) {
+        seen += dispatcher->latencyBuckets[bucket];
+        if (seen >= target) {
+            // Upper bound of the bucket, capped at the true maximum.
+            return (uint32_t)MIN((uint64_t)dispatcher->latencyMaxMicros, (2ULL << bucket) - 1);
+        }
+    }
+    return dispatcher->latencyMaxMicros;
+}
 
 @interface SocketTouchServer ()
-@property (nonatomic, assign) int serverSocket;
+@property (nonatomic, assign) KimiRunStreamServer *streamServer;
+@property (nonatomic, assign) SocketTouchDispatcher *dispatcher;
 @property (nonatomic, assign) uint16_t port;
 @property (nonatomic, strong) NSThread *serverThread;
 @property (nonatomic, assign) BOOL shouldStop;
+- (void)handleFrame:(const uint8_t *)bytes length:(size_t)length connection:(KimiRunStreamConnection *)conn;
 @end
 
+// Stream server callbacks; all run on the server thread.
+static void SocketTouchServerOnOpen(void *context, KimiRunStreamConnection *conn) {
+    SocketTouchClient *client = calloc(1, sizeof(*client));
+    if (!client) {
+        KimiRunStreamConnectionClose(conn);
+        return;
+    }
+    KimiRunStreamConnectionSetUserData(conn, client);
+    NSLog(@"[SocketTouchServer] Client %llu connected from %s",
+          (unsigned long long)KimiRunStreamConnectionID(conn), KimiRunStreamConnectionPeer(conn));
+}
+
+static void SocketTouchServerOnFrame(void *context, KimiRunStreamConnection *conn, const uint8_t *bytes, size_t length) {
+    @autoreleasepool {
+        SocketTouchServer *server = (__bridge SocketTouchServer *)context;
+        [server handleFrame:bytes length:length connection:conn];
+    }
+}
+
+static void SocketTouchServerOnOversize(void *context, KimiRunStreamConnection *conn) {
+    static const char kReply[] = "ERROR: Command too long\r\n";
+    KimiRunStreamConnectionSend(conn, kReply, sizeof(kReply) - 1);
+}
+
+// A client that disconnects mid-gesture would leave its fingers down;
+// lift whatever it still holds.
+static void SocketTouchServerOnClose(void *context, KimiRunStreamConnection *conn) {
+    SocketTouchServer *server = (__bridge SocketTouchServer *)context;
+    SocketTouchClient *client = (SocketTouchClient *)KimiRunStreamConnectionUserData(conn);
+    uint32_t fingers = client ? client->fingers : 0;
+    if (fingers != 0) {
+        // Async: stop may be waiting for this thread on main.
+        dispatch_async(dispatch_get_main_queue(), ^{
+            SocketTouchLiftFingers(fingers);
+        });
+    }
+    if (client && client->binary) {
+        // Binary fingers belong to the dispatcher; it lifts them and frees
+        // the client after the connection's queued records.
+        SocketTouchDispatchItem marker;
+        memset(&marker, 0, sizeof(marker));
+        marker.client = client;
+        marker.connectionID = KimiRunStreamConnectionID(conn);
+        marker.closing = true;
+        marker.dueMicros = KimiRunBTouchImmediateDue(&client->playout, SocketTouchNowMicros());
+        if (!SocketTouchDispatcherPush(server.dispatcher, &marker)) {
+            NSLog(@"[SocketTouchServer] Client %llu: dispatcher gone, leaking binary state",
+                  (unsigned long long)KimiRunStreamConnectionID(conn));
+        }
+    } else {
+        free(client);
+    }
+    KimiRunStreamConnectionSetUserData(conn, NULL);
+    NSLog(@"[SocketTouchServer] Client %llu disconnected (lifted=0x%x)",
+          (unsigned long long)KimiRunStreamConnectionID(conn), fingers);
+}
+
 @implementation SocketTouchServer
 
 + (instancetype)sharedServer {
@@ -44,7 +464,7 @@
 - (instancetype)init {
     self = [super init];
     if (self) {
-        _serverSocket = -1;
+        _streamServer = NULL;
         _port = 0;
         _shouldStop = NO;
     }
@@ -52,16 +472,22 @@
 }
 
 - (BOOL)startOnPort:(uint16_t)port error:(NSError **)error {
-    if (self.isRunning) {
+    if (self.streamServer) {
         [self stop];
     }
     
     self.port = port;
     self.shouldStop = NO;
     
-    // Create socket
-    self.serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (self.serverSocket < 0) {
+    KimiRunStreamCallbacks callbacks = {
+        .context = (__bridge void *)self,
+        .onOpen = SocketTouchServerOnOpen,
+        .onFrame = SocketTouchServerOnFrame,
+        .onOversize = SocketTouchServerOnOversize,
+        .onClose = SocketTouchServerOnClose
+    };
+    KimiRunStreamServer *server = KimiRunStreamServerCreate(NULL, &callbacks);
+    if (!server) {
         if (error) {
             *error = [NSError errorWithDomain:@"SocketTouchServer" 
                                          code:errno 
@@ -70,38 +496,20 @@
         return NO;
     }
     
-    // Allow socket reuse
-    int reuse = 1;
-    setsockopt(self.serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
-    
-    // Bind to address
-    struct sockaddr_in serverAddr;
-    memset(&serverAddr, 0, sizeof(serverAddr));
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(port);
-    
-    if (bind(self.serverSocket, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0) {
+    // Bind and listen on all interfaces
+    if (!KimiRunStreamServerListenTCP(server, NULL, port, NULL)) {
         if (error) {
             *error = [NSError errorWithDomain:@"SocketTouchServer" 
                                          code:errno 
                                      userInfo:@{NSLocalizedDescriptionKey: @"Failed to bind socket"}];
         }
-        close(self.serverSocket);
-        self.serverSocket = -1;
+        KimiRunStreamServerDestroy(server);
         return NO;
     }
-    
-    // Listen for connections
-    if (listen(self.serverSocket, 5) < 0) {
-        if (error) {
-            *error = [NSError errorWithDomain:@"SocketTouchServer" 
-                                         code:errno 
-                                     userInfo:@{NSLocalizedDescriptionKey: @"Failed to listen on socket"}];
-        }
-        close(self.serverSocket);
-        self.serverSocket = -1;
-        return NO;
+    self.streamServer = server;
+    self.dispatcher = SocketTouchDispatcherCreate(server);
+    if (!self.dispatcher) {
+        NSLog(@"[SocketTouchServer] Touch dispatcher unavailable; BIN streams disabled");
     }
     
     // Start server thread
@@ -118,197 +526,210 @@
 - (void)stop {
     self.shouldStop = YES;
     
-    if (self.serverSocket >= 0) {
-        close(self.serverSocket);
-        self.serverSocket = -1;
+    KimiRunStreamServer *server = self.streamServer;
+    if (!server) {
+        return;
     }
+    KimiRunStreamServerStop(server);
     
-    // Wait for thread to finish
-    if (self.serverThread && !self.serverThread.isFinished) {
-        [self.serverThread cancel];
-        [NSThread sleepForTimeInterval:0.1];
+    // Wait for the loop to close its clients; if it doesn't, leak the
+    // server rather than free it under the running thread.
+    NSThread *thread = self.serverThread;
+    for (int i = 0; i < 20 && thread && !thread.isFinished; i++) {
+        [NSThread sleepForTimeInterval:0.05];
+    }
+    if (!thread || thread.isFinished) {
+        // Every client's close marker is queued by now.
+        SocketTouchDispatcherStop(self.dispatcher);
+        KimiRunStreamServerDestroy(server);
     }
+    self.dispatcher = NULL;
+    self.streamServer = NULL;
+    self.serverThread = nil;
     
     NSLog(@"[SocketTouchServer] Stopped");
 }
 
 - (BOOL)isRunning {
-    return self.serverSocket >= 0 && !self.shouldStop;
+    return self.streamServer != NULL && !self.shouldStop;
+}
+
+- (NSDictionary *)statistics {
+    KimiRunStreamServerStats stats;
+    KimiRunStreamServerGetStats(self.streamServer, &stats);
+    return @{
+        @"running": @(self.isRunning),
+        @"port": @(self.port),
+        @"active": @(stats.active),
+        @"peakActive": @(stats.peakActive),
+        @"accepted": @(stats.accepted),
+        @"rejected": @(stats.rejected),
+        @"commands": @(stats.frames),
+        @"oversized": @(stats.oversized),
+        @"bytesIn": @(stats.bytesIn),
+        @"bytesOut": @(stats.bytesOut),
+        @"slowClientsDropped": @(stats.slowClientsDropped),
+        @"binary": [self binaryStatistics]
+    };
+}
+
+- (NSDictionary *)binaryStatistics {
+    SocketTouchDispatcher *dispatcher = self.dispatcher;
+    if (!dispatcher) {
+        return @{@"running": @NO};
+    }
+    pthread_mutex_lock(&dispatcher->lock);
+    uint64_t applied = dispatcher->applied;
+    NSDictionary *latency = @{
+        @"lastUs": @(dispatcher->latencyLastMicros),
+        @"meanUs": @(applied ? dispatcher->latencyTotalMicros / applied : 0),
+        @"p50Us": @(SocketTouchLatencyPercentile(dispatcher, applied, 0.50)),
+        @"p99Us": @(SocketTouchLatencyPercentile(dispatcher, applied, 0.99)),
+        @"maxUs": @(dispatcher->latencyMaxMicros)
+    };
+    NSDictionary *result = @{
+        @"running": @YES,
+        @"playoutMs": @(SocketTouchPlayoutMicros() / 1000),
+        @"queued": @(dispatcher->count),
+        @"records": @(dispatcher->records),
+        @"applied": @(applied),
+        @"failed": @(dispatcher->failed),
+        @"overflows": @(dispatcher->overflows),
+        @"batches": @(dispatcher->batches),
+        @"acks": @(dispatcher->acks),
+        @"latency": latency
+    };
+    pthread_mutex_unlock(&dispatcher->lock);
+    return result;
 }
 
 - (void)serverLoop {
     @autoreleasepool {
         NSLog(@"[SocketTouchServer] Server loop started");
         
-        while (!self.shouldStop) {
-            struct sockaddr_in clientAddr;
-            socklen_t clientLen = sizeof(clientAddr);
-            
-            // Accept connection (with timeout)
-            int clientSocket = accept(self.serverSocket, 
-                                     (struct sockaddr *)&clientAddr, 
-                                     &clientLen);
-            
-            if (clientSocket < 0) {
-                if (errno == EINTR || errno == EAGAIN) {
-                    continue;
-                }
-                NSLog(@"[SocketTouchServer] Accept error: %d", errno);
-                [NSThread sleepForTimeInterval:0.1];
-                continue;
-            }
-            
-            NSLog(@"[SocketTouchServer] Client connected from %s:%d", 
-                  inet_ntoa(clientAddr.sin_addr), ntohs(clientAddr.sin_port));
-            
-            // Handle client in a separate thread
-            [self handleClient:clientSocket];
+        if (!KimiRunStreamServerRun(self.streamServer)) {
+            NSLog(@"[SocketTouchServer] Server loop failed: %d", errno);
         }
         
         NSLog(@"[SocketTouchServer] Server loop ended");
     }
 }
 
-- (void)handleClient:(int)clientSocket {
-    @autoreleasepool {
-        char buffer[1024];
-        ssize_t bytesRead;
-        
-        while ((bytesRead = recv(clientSocket, buffer, sizeof(buffer) - 1, 0)) > 0) {
-            buffer[bytesRead] = '\0';
-            
-            // Process command
-            NSString *command = [[NSString alloc] initWithUTF8String:buffer];
-            NSString *response = [self processCommand:command];
-            
-            // Send response
-            const char *responseBytes = [response UTF8String];
-            send(clientSocket, responseBytes, strlen(responseBytes), 0);
-        }
-        
-        close(clientSocket);
-        NSLog(@"[SocketTouchServer] Client disconnected");
+- (void)handleFrame:(const uint8_t *)bytes length:(size_t)length connection:(KimiRunStreamConnection *)conn {
+    SocketTouchClient *client = (SocketTouchClient *)KimiRunStreamConnectionUserData(conn);
+    if (client->binary) {
+        [self handleBinaryRecord:bytes client:client connection:conn];
+        return;
     }
-}
-
-- (NSString *)processCommand:(NSString *)command {
-    // Remove newlines and whitespace
-    command = [command stringByTrimmingCharactersInSet:
-               [NSCharacterSet whitespaceAndNewlineCharacterSet]];
-    
-    if (command.length == 0) {
-        return @"ERROR: Empty command\r\n";
+    // Stray blank lines (e.g. a doubled "\r\n") are not commands.
+    if (length == 0) {
+        return;
     }
-    
-    NSLog(@"[SocketTouchServer] Processing command: %@", command);
-    
-    // Parse ZXTouch protocol
-    // Format: "10<type><fingerIndex><x><y>"
-    // Example: "10110123401234" = touch down, finger 1, x=123.4, y=123.4
-    
-    if (command.length >= 3) {
-        NSString *taskIdStr = [command substringToIndex:2];
-        int taskId = [taskIdStr intValue];
-        
-        if (taskId == kZXTouchTaskPerformTouch) {
-            return [self handleTouchCommand:command];
-        }
-        
-        // Simple test command
-        if ([command hasPrefix:@"TEST"]) {
-            return @"OK: Server is running\r\n";
-        }
-        
-        // Simple tap command: "TAP x y"
-        if ([command hasPrefix:@"TAP "]) {
-            NSArray *parts = [command componentsSeparatedByString:@" "];
-            if (parts.count >= 3) {
-                CGFloat x = [parts[1] floatValue];
-                CGFloat y = [parts[2] floatValue];
-                
-                BOOL success = [KimiRunTouchInjection tapAtX:x Y:y];
-                return success ? @"OK\r\n" : @"ERROR\r\n";
-            }
-        }
+    // "BIN" switches the rest of the connection to 16-byte records.
+    if (length == 3 && memcmp(bytes, "BIN", 3) == 0) {
+        [self beginBinaryStreamForClient:client connection:conn];
+        return;
+    }
+    // Decoded in place into a stack command; nothing is allocated per line.
+    KimiRunZXCommand command;
+    const char *reply = "ERROR\r\n";
+    switch (KimiRunZXTouchParse(bytes, length, &command)) {
+        case KimiRunZXCommandTouch:
+            reply = [self performTouchCommand:&command connection:conn] ? "0\r\n" : "ERROR\r\n";
+            break;
+        case KimiRunZXCommandTest:
+            reply = "OK: Server is running\r\n";
+            break;
+        case KimiRunZXCommandTap:
+            reply = [KimiRunTouchInjection tapAtX:command.tapX Y:command.tapY] ? "OK\r\n" : "ERROR\r\n";
+            break;
+        case KimiRunZXCommandInvalid:
+            reply = KimiRunZXTouchErrorReply(command.error);
+            break;
     }
     
-    return @"ERROR: Unknown command\r\n";
+    // Send response (queued by the stream server if the client is slow)
+    KimiRunStreamConnectionSend(conn, reply, strlen(reply));
 }
 
-- (NSString *)handleTouchCommand:(NSString *)command {
-    // ZXTouch format: "10" + count + events
-    // Each event: type(1) + finger(2) + x(5) + y(5) = 13 chars
-    
-    if (command.length < 3) {
-        return @"ERROR: Invalid touch command\r\n";
+- (void)beginBinaryStreamForClient:(SocketTouchClient *)client connection:(KimiRunStreamConnection *)conn {
+    if (!self.dispatcher) {
+        static const char kReply[] = "ERROR: Binary stream unavailable\r\n";
+        KimiRunStreamConnectionSend(conn, kReply, sizeof(kReply) - 1);
+        return;
     }
+    client->binary = true;
+    client->playoutMicros = SocketTouchPlayoutMicros();
+    memset(&client->playout, 0, sizeof(client->playout));
     
-    NSString *countStr = [command substringWithRange:NSMakeRange(2, 1)];
-    int eventCount = [countStr intValue];
-    
-    if (eventCount < 1 || eventCount > 20) {
-        return @"ERROR: Invalid event count\r\n";
+    static const char kReply[] = "OK: BIN 16\r\n";
+    KimiRunStreamConnectionSend(conn, kReply, sizeof(kReply) - 1);
+    KimiRunStreamConnectionSetFraming(conn, KimiRunStreamFramingFixed, KIMIRUN_BTOUCH_RECORD_SIZE);
+}
+
+- (void)handleBinaryRecord:(const uint8_t *)bytes client:(SocketTouchClient *)client connection:(KimiRunStreamConnection *)conn {
+    SocketTouchDispatchItem item;
+    memset(&item, 0, sizeof(item));
+    item.client = client;
+    item.connectionID = KimiRunStreamConnectionID(conn);
+    item.valid = KimiRunBTouchDecode(bytes, &item.record) && item.record.finger < kSocketTouchMaxFinger;
+    item.receivedMicros = SocketTouchNowMicros();
+    if (item.record.flags & KimiRunBTouchFlagImmediate) {
+        item.dueMicros = KimiRunBTouchImmediateDue(&client->playout, item.receivedMicros);
+    } else {
+        item.dueMicros = KimiRunBTouchPlayoutDue(&client->playout, item.record.clientMicros,
+                                                 item.receivedMicros, client->playoutMicros);
     }
-    
-    NSUInteger offset = 3;
-    NSMutableArray *events = [NSMutableArray array];
-    
-    for (int i = 0; i < eventCount; i++) {
-        if (offset + 13 > command.length) {
-            return @"ERROR: Incomplete event data\r\n";
-        }
-        
-        NSString *eventStr = [command substringWithRange:NSMakeRange(offset, 13)];
-        
-        // Parse event
-        int type = [[eventStr substringWithRange:NSMakeRange(0, 1)] intValue];
-        int finger = [[eventStr substringWithRange:NSMakeRange(1, 2)] intValue];
-        int xScaled = [[eventStr substringWithRange:NSMakeRange(3, 5)] intValue];
-        int yScaled = [[eventStr substringWithRange:NSMakeRange(8, 5)] intValue];
-        
-        CGFloat x = xScaled / 10.0;
-        CGFloat y = yScaled / 10.0;
-        
-        [events addObject:@{
-            @"type": @(type),
-            @"finger": @(finger),
-            @"x": @(x),
-            @"y": @(y)
-        }];
-        
-        offset += 13;
+    if (!SocketTouchDispatcherPush(self.dispatcher, &item)) {
+        // Only happens when injection has stalled for seconds; acks would
+        // otherwise arrive out of order.
+        NSLog(@"[SocketTouchServer] Client %llu outpaced the touch dispatcher; closing",
+              (unsigned long long)item.connectionID);
+        KimiRunStreamConnectionClose(conn);
     }
-    
-    // Execute touch events on main thread
+}
+
+- (BOOL)performTouchCommand:(const KimiRunZXCommand *)command connection:(KimiRunStreamConnection *)conn {
+    // Each record is one injected phase for its finger; fingers stay down
+    // between commands so clients can stream moves at display rate.
     __block BOOL success = YES;
+    SocketTouchClient *client = (SocketTouchClient *)KimiRunStreamConnectionUserData(conn);
+    __block uint32_t fingers = client->fingers;
     dispatch_sync(dispatch_get_main_queue(), ^{
-        for (NSDictionary *event in events) {
-            int type = [event[@"type"] intValue];
-            CGFloat x = [event[@"x"] floatValue];
-            CGFloat y = [event[@"y"] floatValue];
+        for (uint32_t i = 0; i < command->count; i++) {
+            const KimiRunZXTouchRecord *record = &command->records[i];
+            NSInteger finger = record->finger;
             
-            BOOL result = NO;
-            switch (type) {
-                case kZXTouchDown:
-                    // Note: We need to add injectTouchDown method
-                    result = [KimiRunTouchInjection tapAtX:x Y:y]; // Simplified
+            KimiRunTouchStreamPhase phase;
+            switch (record->type) {
+                case KimiRunZXTouchTypeDown:
+                    phase = KimiRunTouchStreamPhaseDown;
                     break;
-                case kZXTouchUp:
-                    result = YES; // Up is handled by tap
+                case KimiRunZXTouchTypeMove:
+                    phase = KimiRunTouchStreamPhaseMove;
                     break;
-                case kZXTouchMove:
-                    // Would need swipe implementation
-                    result = YES;
+                default:
+                    phase = KimiRunTouchStreamPhaseUp;
                     break;
             }
+            if (finger >= kSocketTouchMaxFinger) {
+                success = NO;
+                continue;
+            }
             
+            BOOL result = [KimiRunTouchInjection streamTouchPhase:phase finger:finger atX:record->x Y:record->y];
+            if (phase == KimiRunTouchStreamPhaseUp) {
+                fingers &= ~(1u << finger);
+            } else if (result) {
+                fingers |= (1u << finger);
+            }
             if (!result) {
                 success = NO;
             }
         }
     });
-    
-    return success ? @"0\r\n" : @"ERROR\r\n";
+    client->fingers = fingers;
+    return success;
 }
 
 @end
\ No newline at end of file
@@ -0,0 +1,372 @@
+//
+//  KimiRunStrategyScore.c
+//  KimiRun - Adaptive Touch Strategy Scoring
+//
+//  Ordering follows the classic sequential-search rule: trying candidates
+//  in ascending cost / P(success) minimises the expected cost of finding
+//  one that works. P(success) is acceptance x verified-delta rate; cost is
+//  the p50 latency plus a fixed per-attempt penalty.
+//
+
+#include "KimiRunStrategyScore.h"
+
+#include <math.h>
+#include <string.h>
+
+#define KIMIRUN_STRATEGY_BUCKET_BASE_MS 0.125
+#define KIMIRUN_STRATEGY_MIN_SUCCESS 0.02
+
+static double KimiRunStrategyClamp01(double value) {
+    if (value < 0.0) {
+        return 0.0;
+    }
+    return value > 1.0 ? 1.0 : value;
+}
+
+static double KimiRunStrategyDecayFactor(const KimiRunStrategyConfig *config, double updatedAt, double now) {
+    double age = now - updatedAt;
+    if (age <= 0.0 || config->halfLifeSeconds <= 0.0) {
+        return 1.0;
+    }
+    return exp2(-age / config->halfLifeSeconds);
+}
+
+static unsigned KimiRunStrategyBucketForLatency(double latencyMs) {
+    double upper = KIMIRUN_STRATEGY_BUCKET_BASE_MS;
+    unsigned bucket = 0;
+    while (bucket + 1 < KIMIRUN_STRATEGY_LATENCY_BUCKETS && latencyMs >= upper) {
+        upper *= 2.0;
+        bucket++;
+    }
+    return bucket;
+}
+
+static double KimiRunStrategyBucketLower(unsigned bucket) {
+    return bucket == 0 ? 0.0 : KIMIRUN_STRATEGY_BUCKET_BASE_MS * (double)(1u << (bucket - 1));
+}
+
+static double KimiRunStrategyBucketUpper(unsigned bucket) {
+    return KIMIRUN_STRATEGY_BUCKET_BASE_MS * (double)(1u << bucket);
+}
+
+static bool KimiRunStrategyKeyMatches(const KimiRunStrategyEntry *entry,
+                                      const char *bundle,
+                                      uint8_t gesture,
+                                      uint8_t backend) {
+    return entry->used &&
+           entry->gesture == gesture &&
+           entry->backend == backend &&
+           strncmp(entry->bundle, bundle, KIMIRUN_STRATEGY_BUNDLE_MAX) == 0;
+}
+
+static const KimiRunStrategyEntry *KimiRunStrategyFind(const KimiRunStrategyTable *table,
+                                                       const char *bundle,
+                                                       uint8_t gesture,
+                                                       uint8_t backend) {
+    for (size_t i = 0; i < KIMIRUN_STRATEGY_MAX_ENTRIES; i++) {
+        if (KimiRunStrategyKeyMatches(&table->entries[i], bundle, gesture, backend)) {
+            return &table->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Returns the entry decayed to `now`, creating (or evicting the stalest
+// entry for) a new one when the key is unknown.
+static KimiRunStrategyEntry *KimiRunStrategyAcquire(KimiRunStrategyTable *table,
+                                                    const char *bundle,
+                                                    uint8_t gesture,
+                                                    uint8_t backend,
+                                                    double now) {
+    KimiRunStrategyEntry *entry = (KimiRunStrategyEntry *)KimiRunStrategyFind(table, bundle, gesture, backend);
+    if (entry) {
+        double factor = KimiRunStrategyDecayFactor(&table->config, entry->updatedAt, now);
+        if (factor < 1.0) {
+            entry->attempts *= factor;
+            entry->accepts *= factor;
+            entry->verifications *= factor;
+            entry->verified *= factor;
+            for (unsigned i = 0; i < KIMIRUN_STRATEGY_LATENCY_BUCKETS; i++) {
+                entry->latency[i] *= factor;
+            }
+        }
+        if (now > entry->updatedAt) {
+            entry->updatedAt = now;
+        }
+        return entry;
+    }
+
+    KimiRunStrategyEntry *victim = NULL;
+    for (size_t i = 0; i < KIMIRUN_STRATEGY_MAX_ENTRIES; i++) {
+        KimiRunStrategyEntry *candidate = &table->entries[i];
+        if (!candidate->used) {
+            victim = candidate;
+            break;
+        }
+        if (!victim || candidate->updatedAt < victim->updatedAt) {
+            victim = candidate;
+        }
+    }
+    if (victim->used) {
+        table->evictions++;
+    }
+    memset(victim, 0, sizeof(*victim));
+    for (size_t i = 0; i < KIMIRUN_STRATEGY_BUNDLE_MAX && bundle[i] != '\0'; i++) {
+        victim->bundle[i] = bundle[i];
+    }
+    victim->gesture = gesture;
+    victim->backend = backend;
+    victim->used = 1;
+    victim->updatedAt = now;
+    return victim;
+}
+
+static double KimiRunStrategyP50(const KimiRunStrategyEntry *entry, double factor) {
+    double total = 0.0;
+    for (unsigned i = 0; i < KIMIRUN_STRATEGY_LATENCY_BUCKETS; i++) {
+        total += entry->latency[i] * factor;
+    }
+    if (total <= 0.0) {
+        return -1.0;
+    }
+    double half = total * 0.5;
+    double running = 0.0;
+    for (unsigned i = 0; i < KIMIRUN_STRATEGY_LATENCY_BUCKETS; i++) {
+        double weight = entry->latency[i] * factor;
+        if (weight > 0.0 && running + weight >= half) {
+            double fraction = (half - running) / weight;
+            double lower = KimiRunStrategyBucketLower(i);
+            return lower + (KimiRunStrategyBucketUpper(i) - lower) * fraction;
+        }
+        running += weight;
+    }
+    return KimiRunStrategyBucketUpper(KIMIRUN_STRATEGY_LATENCY_BUCKETS - 1);
+}
+
+static void KimiRunStrategyScoreEntry(const KimiRunStrategyTable *table,
+                                      const KimiRunStrategyEntry *entry,
+                                      uint8_t backend,
+                                      double now,
+                                      KimiRunStrategyScore *out) {
+    const KimiRunStrategyConfig *config = &table->config;
+    double factor = entry ? KimiRunStrategyDecayFactor(config, entry->updatedAt, now) : 0.0;
+    double attempts = entry ? entry->attempts * factor : 0.0;
+    double accepts = entry ? entry->accepts * factor : 0.0;
+    double verifications = entry ? entry->verifications * factor : 0.0;
+    double verified = entry ? entry->verified * factor : 0.0;
+    double prior = config->priorWeight > 0.0 ? config->priorWeight : 0.0;
+    double priorLatency = config->priorLatencyMs[backend];
+
+    memset(out, 0, sizeof(*out));
+    out->bundle = entry ? entry->bundle : "";
+    out->gesture = entry ? entry->gesture : 0;
+    out->backend = backend;
+    out->samples = attempts;
+    out->acceptanceRate = (attempts + prior) > 0.0
+        ? (accepts + config->priorAcceptance * prior) / (attempts + prior)
+        : config->priorAcceptance;
+    out->verifiedRate = (verifications + prior) > 0.0
+        ? (verified + config->priorVerified[backend] * prior) / (verifications + prior)
+        : config->priorVerified[backend];
+
+    double p50 = entry ? KimiRunStrategyP50(entry, factor) : -1.0;
+    double latencySamples = 0.0;
+    if (entry) {
+        for (unsigned i = 0; i < KIMIRUN_STRATEGY_LATENCY_BUCKETS; i++) {
+            latencySamples += entry->latency[i] * factor;
+        }
+    }
+    if (p50 < 0.0) {
+        out->p50LatencyMs = priorLatency;
+    } else if (latencySamples + prior > 0.0) {
+        out->p50LatencyMs = (p50 * latencySamples + priorLatency * prior) / (latencySamples + prior);
+    } else {
+        out->p50LatencyMs = p50;
+    }
+
+    double success = KimiRunStrategyClamp01(out->acceptanceRate) * KimiRunStrategyClamp01(out->verifiedRate);
+    if (success < KIMIRUN_STRATEGY_MIN_SUCCESS) {
+        success = KIMIRUN_STRATEGY_MIN_SUCCESS;
+    }
+    out->expectedCostMs = (out->p50LatencyMs + config->failurePenaltyMs) / success;
+    out->ageSeconds = entry ? now - entry->updatedAt : 0.0;
+    if (entry) {
+        out->totalAttempts = entry->totalAttempts;
+        out->totalAccepts = entry->totalAccepts;
+        out->totalVerifications = entry->totalVerifications;
+        out->totalVerified = entry->totalVerified;
+    }
+}
+
+// Public API
+
+void KimiRunStrategyConfigDefaults(KimiRunStrategyConfig *config) {
+    if (!config) {
+        return;
+    }
+    memset(config, 0, sizeof(*config));
+    config->halfLifeSeconds = 600.0;
+    config->priorWeight = 2.0;
+    config->priorAcceptance = 0.5;
+    for (unsigned i = 0; i < KIMIRUN_STRATEGY_MAX_BACKENDS; i++) {
+        config->priorVerified[i] = 0.5;
+        config->priorLatencyMs[i] = 2.0;
+    }
+    config->failurePenaltyMs = 1.0;
+    config->reorderMargin = 0.25;
+    config->minSamples = 3.0;
+}
+
+void KimiRunStrategyTableInit(KimiRunStrategyTable *table, const KimiRunStrategyConfig *config) {
+    if (!table) {
+        return;
+    }
+    memset(table, 0, sizeof(*table));
+    if (config) {
+        table->config = *config;
+    } else {
+        KimiRunStrategyConfigDefaults(&table->config);
+    }
+}
+
+void KimiRunStrategyRecordAttempt(KimiRunStrategyTable *table,
+                                  const char *bundle,
+                                  uint8_t gesture,
+                                  uint8_t backend,
+                                  bool accepted,
+                                  double latencyMs,
+                                  double now) {
+    if (!table || backend >= KIMIRUN_STRATEGY_MAX_BACKENDS) {
+        return;
+    }
+    KimiRunStrategyEntry *entry = KimiRunStrategyAcquire(table, bundle ? bundle : "", gesture, backend, now);
+    entry->attempts += 1.0;
+    entry->totalAttempts++;
+    if (accepted) {
+        entry->accepts += 1.0;
+        entry->totalAccepts++;
+    }
+    if (latencyMs >= 0.0 && isfinite(latencyMs)) {
+        entry->latency[KimiRunStrategyBucketForLatency(latencyMs)] += 1.0;
+    }
+}
+
+void KimiRunStrategyRecordVerification(KimiRunStrategyTable *table,
+                                       const char *bundle,
+                                       uint8_t gesture,
+                                       uint8_t backend,
+                                       bool verified,
+                                       double now) {
+    if (!table || backend >= KIMIRUN_STRATEGY_MAX_BACKENDS) {
+        return;
+    }
+    KimiRunStrategyEntry *entry = KimiRunStrategyAcquire(table, bundle ? bundle : "", gesture, backend, now);
+    entry->verifications += 1.0;
+    entry->totalVerifications++;
+    if (verified) {
+        entry->verified += 1.0;
+        entry->totalVerified++;
+    }
+}
+
+bool KimiRunStrategyGetScore(const KimiRunStrategyTable *table,
+                             const char *bundle,
+                             uint8_t gesture,
+                             uint8_t backend,
+                             double now,
+                             KimiRunStrategyScore *out) {
+    if (!table || !out || backend >= KIMIRUN_STRATEGY_MAX_BACKENDS) {
+        return false;
+    }
+    const KimiRunStrategyEntry *entry = KimiRunStrategyFind(table, bundle ? bundle : "", gesture, backend);
+    KimiRunStrategyScoreEntry(table, entry, backend, now, out);
+    out->gesture = gesture;
+    return true;
+}
+
+size_t KimiRunStrategyOrder(const KimiRunStrategyTable *table,
+                            const char *bundle,
+                            uint8_t gesture,
+                            const uint8_t *candidates,
+                            size_t count,
+                            double now,
+                            uint8_t *out) {
+    if (!table || !candidates || !out) {
+        return 0;
+    }
+    uint8_t order[KIMIRUN_STRATEGY_MAX_BACKENDS];
+    double cost[KIMIRUN_STRATEGY_MAX_BACKENDS];
+    bool trusted[KIMIRUN_STRATEGY_MAX_BACKENDS];
+    bool seen[KIMIRUN_STRATEGY_MAX_BACKENDS] = {false};
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t backend = candidates[i];
+        if (backend >= KIMIRUN_STRATEGY_MAX_BACKENDS || seen[backend]) {
+            continue;
+        }
+        seen[backend] = true;
+        KimiRunStrategyScore score;
+        KimiRunStrategyGetScore(table, bundle, gesture, backend, now, &score);
+        order[n] = backend;
+        cost[n] = score.expectedCostMs;
+        trusted[n] = score.samples >= table->config.minSamples;
+        n++;
+    }
+
+    // Insertion sort keeps the static order unless a candidate is clearly
+    // cheaper. Only a candidate with minSamples of its own evidence moves;
+    // one scored from priors alone never overtakes anything, so a measured
+    // but slow front-runner is not displaced by untested guesses.
+    double margin = 1.0 + (table->config.reorderMargin > 0.0 ? table->config.reorderMargin : 0.0);
+    for (size_t i = 1; i < n; i++) {
+        uint8_t backend = order[i];
+        double c = cost[i];
+        bool t = trusted[i];
+        size_t j = i;
+        while (j > 0 && t && c * margin < cost[j - 1]) {
+            order[j] = order[j - 1];
+            cost[j] = cost[j - 1];
+            trusted[j] = trusted[j - 1];
+            j--;
+        }
+        order[j] = backend;
+        cost[j] = c;
+        trusted[j] = t;
+    }
+    memcpy(out, order, n);
+    return n;
+}
+
+size_t KimiRunStrategySnapshot(const KimiRunStrategyTable *table,
+                               double now,
+                               KimiRunStrategyScore *out,
+                               size_t maxCount) {
+    if (!table || !out || maxCount == 0) {
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < KIMIRUN_STRATEGY_MAX_ENTRIES; i++) {
+        const KimiRunStrategyEntry *entry = &table->entries[i];
+        if (!entry->used) {
+            continue;
+        }
+        KimiRunStrategyScore score;
+        KimiRunStrategyScoreEntry(table, entry, entry->backend, now, &score);
+        // Insert by recency, dropping the oldest once full.
+        size_t j = n;
+        if (n == maxCount) {
+            if (out[n - 1].ageSeconds <= score.ageSeconds) {
+                continue;
+            }
+            j = n - 1;
+        } else {
+            n++;
+        }
+        while (j > 0 && out[j - 1].ageSeconds > score.ageSeconds) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = score;
+    }
+    return n;
+}
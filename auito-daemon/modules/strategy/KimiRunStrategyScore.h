@@ -0,0 +1,137 @@
+//
+//  KimiRunStrategyScore.h
+//  KimiRun - Adaptive Touch Strategy Scoring
+//
+//  Portable C (no Foundation). Keeps decayed per-(bundle, gesture, backend)
+//  outcome statistics and orders candidate backends by expected cost.
+//  The table does no locking; callers serialize access.
+//
+//  Every sample carries weight 1 when recorded and loses half of it every
+//  halfLifeSeconds, so old behaviour fades and the estimates drift back to
+//  the configured priors when a backend stops being exercised.
+//
+
+#ifndef KIMIRUN_STRATEGY_SCORE_H
+#define KIMIRUN_STRATEGY_SCORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_STRATEGY_MAX_ENTRIES 96
+#define KIMIRUN_STRATEGY_BUNDLE_MAX 63
+#define KIMIRUN_STRATEGY_MAX_BACKENDS 8      // backend ids are 0..7
+#define KIMIRUN_STRATEGY_LATENCY_BUCKETS 16  // bucket i < 0.125ms << i
+
+typedef struct {
+    double halfLifeSeconds;        // sample weight half-life
+    double priorWeight;            // pseudo-samples backing the priors
+    double priorAcceptance;        // [0,1]
+    double priorVerified[KIMIRUN_STRATEGY_MAX_BACKENDS];    // [0,1]
+    double priorLatencyMs[KIMIRUN_STRATEGY_MAX_BACKENDS];
+    double failurePenaltyMs;       // added to the cost of every attempt
+    double reorderMargin;          // 0.25 == must be 25% cheaper to move ahead
+    double minSamples;             // decayed samples before an entry can move
+} KimiRunStrategyConfig;
+
+typedef struct {
+    char bundle[KIMIRUN_STRATEGY_BUNDLE_MAX + 1];
+    uint8_t gesture;
+    uint8_t backend;
+    uint8_t used;
+    double updatedAt;              // caller clock, seconds
+    double attempts;               // decayed
+    double accepts;                // decayed
+    double verifications;          // decayed
+    double verified;               // decayed
+    double latency[KIMIRUN_STRATEGY_LATENCY_BUCKETS];
+    uint32_t totalAttempts;
+    uint32_t totalAccepts;
+    uint32_t totalVerifications;
+    uint32_t totalVerified;
+} KimiRunStrategyEntry;
+
+typedef struct {
+    KimiRunStrategyConfig config;
+    KimiRunStrategyEntry entries[KIMIRUN_STRATEGY_MAX_ENTRIES];
+    uint32_t evictions;
+} KimiRunStrategyTable;
+
+typedef struct {
+    const char *bundle;            // points into the table
+    uint8_t gesture;
+    uint8_t backend;
+    double samples;                // decayed attempts
+    double acceptanceRate;         // prior-smoothed
+    double verifiedRate;           // prior-smoothed
+    double p50LatencyMs;
+    double expectedCostMs;
+    double ageSeconds;
+    uint32_t totalAttempts;
+    uint32_t totalAccepts;
+    uint32_t totalVerifications;
+    uint32_t totalVerified;
+} KimiRunStrategyScore;
+
+void KimiRunStrategyConfigDefaults(KimiRunStrategyConfig *config);
+
+void KimiRunStrategyTableInit(KimiRunStrategyTable *table, const KimiRunStrategyConfig *config);
+
+/** One dispatch attempt. latencyMs is the wall time the backend call took. */
+void KimiRunStrategyRecordAttempt(KimiRunStrategyTable *table,
+                                  const char *bundle,
+                                  uint8_t gesture,
+                                  uint8_t backend,
+                                  bool accepted,
+                                  double latencyMs,
+                                  double now);
+
+/** Outcome of an out-of-band check (e.g. a UI delta) for an accepted gesture. */
+void KimiRunStrategyRecordVerification(KimiRunStrategyTable *table,
+                                       const char *bundle,
+                                       uint8_t gesture,
+                                       uint8_t backend,
+                                       bool verified,
+                                       double now);
+
+/**
+ * Score one key. Unknown keys are scored from the priors alone.
+ * Returns false only for an invalid backend id.
+ */
+bool KimiRunStrategyGetScore(const KimiRunStrategyTable *table,
+                             const char *bundle,
+                             uint8_t gesture,
+                             uint8_t backend,
+                             double now,
+                             KimiRunStrategyScore *out);
+
+/**
+ * Reorder candidates (given in static preference order) by expected cost.
+ * An entry only moves ahead of another once it has minSamples of evidence
+ * of its own and is cheaper by more than reorderMargin; entries scored
+ * from priors alone keep their static slot, so cold keys keep the static
+ * order. Duplicates are dropped. Returns the number written to out.
+ */
+size_t KimiRunStrategyOrder(const KimiRunStrategyTable *table,
+                            const char *bundle,
+                            uint8_t gesture,
+                            const uint8_t *candidates,
+                            size_t count,
+                            double now,
+                            uint8_t *out);
+
+/** Copy scores of live entries, most recently updated first. */
+size_t KimiRunStrategySnapshot(const KimiRunStrategyTable *table,
+                               double now,
+                               KimiRunStrategyScore *out,
+                               size_t maxCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
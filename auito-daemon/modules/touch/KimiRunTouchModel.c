@@ -0,0 +1,161 @@
+//
+//  KimiRunTouchModel.c
+//  KimiRun - Portable Touch Event Model
+//
+
+#include "KimiRunTouchModel.h"
+
+#include <math.h>
+#include <string.h>
+
+static const double kKimiRunTouchModelHalfPi = 1.5707963267948966;
+
+bool KimiRunTouchEventShapeFor(KimiRunTouchEventKind kind,
+                               int phase,
+                               KimiRunTouchMaskProfile profile,
+                               KimiRunTouchEventShape *out) {
+    if (!out) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    if (phase < KimiRunTouchModelPhaseDown || phase > KimiRunTouchModelPhaseUp) {
+        return false;
+    }
+    bool up = (phase == KimiRunTouchModelPhaseUp);
+    bool move = (phase == KimiRunTouchModelPhaseMove);
+    bool xxtouch = (profile == KimiRunTouchMaskProfileXXTouch);
+
+    switch (kind) {
+        case KimiRunTouchEventKindSimParent:
+            // legacy_raw leaves the parent mask empty and not touching.
+            if (xxtouch) {
+                out->eventMask = move
+                    ? (KimiRunTouchModelMaskPosition | KimiRunTouchModelMaskAttribute)
+                    : (KimiRunTouchModelMaskTouch | KimiRunTouchModelMaskIdentity);
+                out->touching = !up;
+            }
+            return true;
+        case KimiRunTouchEventKindSimChild:
+            if (xxtouch) {
+                out->eventMask = move
+                    ? (KimiRunTouchModelMaskPosition | KimiRunTouchModelMaskAttribute)
+                    : (KimiRunTouchModelMaskTouch | KimiRunTouchModelMaskRange | KimiRunTouchModelMaskIdentity);
+            } else {
+                // Legacy SimulateTouch mask profile (3/4/2).
+                out->eventMask = move ? 4 : (up ? 2 : 3);
+            }
+            out->inRange = !up;
+            out->touching = !up;
+            return true;
+        case KimiRunTouchEventKindLegacyHand:
+            out->eventMask = move
+                ? (KimiRunTouchModelMaskPosition | KimiRunTouchModelMaskTouch)
+                : (KimiRunTouchModelMaskRange | KimiRunTouchModelMaskTouch | KimiRunTouchModelMaskPosition);
+            // iOS 13.2.3 requires the identity flag in the digitizer mask.
+            out->eventMask |= KimiRunTouchModelMaskIdentity;
+            out->inRange = !up;
+            out->touching = !up;
+            out->pressure = up ? 0.0f : 1.0f;
+            out->touchCount = up ? 0 : 1;
+            return true;
+        case KimiRunTouchEventKindNone:
+            break;
+    }
+    return false;
+}
+
+void KimiRunTouchTransformSetIdentity(KimiRunTouchTransform *t) {
+    if (!t) {
+        return;
+    }
+    t->a = 1.0;
+    t->b = 0.0;
+    t->c = 0.0;
+    t->d = 1.0;
+    t->tx = 0.0;
+    t->ty = 0.0;
+}
+
+void KimiRunTouchTransformApply(const KimiRunTouchTransform *t,
+                                double x,
+                                double y,
+                                float *normX,
+                                float *normY) {
+    float nx = (float)x;
+    float ny = (float)y;
+    if (t) {
+        nx = (float)(t->a * x + t->c * y + t->tx);
+        ny = (float)(t->b * x + t->d * y + t->ty);
+    }
+    if (normX) {
+        *normX = fmaxf(0.0f, fminf(1.0f, nx));
+    }
+    if (normY) {
+        *normY = fmaxf(0.0f, fminf(1.0f, ny));
+    }
+}
+
+long KimiRunTouchPlanStepCount(double startX,
+                               double startY,
+                               double endX,
+                               double endY,
+                               long fallbackSteps,
+                               double deltaPx) {
+    long safeFallback = (fallbackSteps > 0) ? fallbackSteps : 1;
+    if (!(deltaPx > 0.0)) {
+        return safeFallback;
+    }
+    double dx = endX - startX;
+    double dy = endY - startY;
+    double distance = sqrt((dx * dx) + (dy * dy));
+    if (!(distance > 0.0)) {
+        return 1;
+    }
+    long steps = (long)ceil(distance / deltaPx);
+    return (steps > 0) ? steps : 1;
+}
+
+uint32_t KimiRunTouchPlanStepDelayMicros(double durationSeconds, long steps) {
+    long safeSteps = (steps > 0) ? steps : 1;
+    double micros = (durationSeconds * 1000000.0) / (double)safeSteps;
+    if (!isfinite(micros) || micros < 1000.0) {
+        micros = 1000.0;
+    }
+    return (uint32_t)llround(micros);
+}
+
+static double KimiRunTouchPlanCurve(double a, double b, double t) {
+    double warped = sin(kKimiRunTouchModelHalfPi * t);
+    double easedT = sin(warped * t * kKimiRunTouchModelHalfPi);
+    return a + ((b - a) * easedT);
+}
+
+void KimiRunTouchPlanPointAtStep(double startX,
+                                 double startY,
+                                 double endX,
+                                 double endY,
+                                 long step,
+                                 long totalSteps,
+                                 bool simpleCurve,
+                                 double *outX,
+                                 double *outY) {
+    double x = endX;
+    double y = endY;
+    if (totalSteps > 0) {
+        long clamped = step < 0 ? 0 : (step > totalSteps ? totalSteps : step);
+        double t = (double)clamped / (double)totalSteps;
+        if (simpleCurve) {
+            x = KimiRunTouchPlanCurve(startX, endX, t);
+            y = KimiRunTouchPlanCurve(startY, endY, t);
+        } else {
+            x = startX + ((endX - startX) * t);
+            y = startY + ((endY - startY) * t);
+        }
+    }
+    if (outX) {
+        *outX = x;
+    }
+    if (outY) {
+        *outY = y;
+    }
+}
@@ -0,0 +1,112 @@
+//
+//  KimiRunTouchModel.h
+//  KimiRun - Portable Touch Event Model
+//
+//  Portable C (no Foundation / IOKit). The parts of gesture planning and
+//  IOHID event building that are pure arithmetic: step planning, the
+//  digitizer masks and flags each event kind carries per phase, and the
+//  interface -> digitizer coordinate transform. The event builder and the
+//  gesture composer call these, and so does the offline trace replay tool,
+//  which keeps recorded traces checkable off-device.
+//
+
+#ifndef KIMIRUN_TOUCH_MODEL_H
+#define KIMIRUN_TOUCH_MODEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Same values as KimiRunTouchPhase.
+enum {
+    KimiRunTouchModelPhaseDown = 0,
+    KimiRunTouchModelPhaseMove = 1,
+    KimiRunTouchModelPhaseUp = 2
+};
+
+// Same values as the kIOHIDDigitizerEvent* mask bits.
+enum {
+    KimiRunTouchModelMaskRange = 0x01,
+    KimiRunTouchModelMaskTouch = 0x02,
+    KimiRunTouchModelMaskPosition = 0x04,
+    KimiRunTouchModelMaskIdentity = 0x20,
+    KimiRunTouchModelMaskAttribute = 0x40
+};
+
+typedef enum {
+    KimiRunTouchEventKindNone = 0,
+    KimiRunTouchEventKindSimParent = 1,   // SimulateTouch-style parent (type 3, index 99)
+    KimiRunTouchEventKindSimChild = 2,    // finger child appended to a sim parent
+    KimiRunTouchEventKindLegacyHand = 3   // legacy HAND parent + single FINGER child
+} KimiRunTouchEventKind;
+
+typedef enum {
+    KimiRunTouchMaskProfileLegacyRaw = 0, // SimEventMaskProfile=legacy_raw
+    KimiRunTouchMaskProfileXXTouch = 1    // SimEventMaskProfile=xxtouch
+} KimiRunTouchMaskProfile;
+
+typedef struct {
+    uint32_t eventMask;
+    bool inRange;
+    bool touching;
+    float pressure;
+    uint32_t touchCount;
+} KimiRunTouchEventShape;
+
+/** Interface points -> normalized digitizer space; same layout as CGAffineTransform. */
+typedef struct {
+    double a, b, c, d, tx, ty;
+} KimiRunTouchTransform;
+
+/**
+ * Mask and flags for one event. Returns false for an unknown kind or
+ * phase (out is zeroed).
+ */
+bool KimiRunTouchEventShapeFor(KimiRunTouchEventKind kind,
+                               int phase,
+                               KimiRunTouchMaskProfile profile,
+                               KimiRunTouchEventShape *out);
+
+void KimiRunTouchTransformSetIdentity(KimiRunTouchTransform *t);
+
+/** Apply t and clamp to [0,1]. A NULL transform is treated as identity. */
+void KimiRunTouchTransformApply(const KimiRunTouchTransform *t,
+                                double x,
+                                double y,
+                                float *normX,
+                                float *normY);
+
+/**
+ * Move steps for a gesture. deltaPx > 0 sizes steps by distance
+ * (GestureDeltaPx); otherwise fallbackSteps (at least 1) is used.
+ */
+long KimiRunTouchPlanStepCount(double startX,
+                               double startY,
+                               double endX,
+                               double endY,
+                               long fallbackSteps,
+                               double deltaPx);
+
+/** Per-step sleep, floored at 1ms. */
+uint32_t KimiRunTouchPlanStepDelayMicros(double durationSeconds, long steps);
+
+/** Point for move step (0...totalSteps, clamped), linear or simple_curve. */
+void KimiRunTouchPlanPointAtStep(double startX,
+                                 double startY,
+                                 double endX,
+                                 double endY,
+                                 long step,
+                                 long totalSteps,
+                                 bool simpleCurve,
+                                 double *outX,
+                                 double *outY);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,13 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** Phases for streamTouchPhase:finger:atX:Y: (same values as the internal touch phase). */
+typedef NS_ENUM(NSInteger, KimiRunTouchStreamPhase) {
+    KimiRunTouchStreamPhaseDown = 0,
+    KimiRunTouchStreamPhaseMove = 1,
+    KimiRunTouchStreamPhaseUp = 2
+};
+
 @interface KimiRunTouchInjection : NSObject
 
 /**
@@ -81,6 +88,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)senderIDSourceString;
 
+/**
+ * Sender ID, captured flag, source and callback counters read as one
+ * snapshot (senderID, captured, source, generation, callbackCount,
+ * digitizerCount, lastEventType, ignoredInjected).
+ */
++ (NSDictionary *)senderIDState;
+
 /**
  * Whether sender ID fallback to constant is enabled.
  */
@@ -152,12 +166,53 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable NSDictionary *)lastBKSDispatchInfo;
 
+/**
+ * Last BKS dispatch telemetry. Route attempts and experiment flags are
+ * only attached when includeRouteDetail is YES.
+ */
++ (nullable NSDictionary *)lastBKSDispatchInfoIncludingRouteDetail:(BOOL)includeRouteDetail;
+
+/**
+ * Timestamp (seconds since 1970) of the last BKS dispatch record, 0 if none.
+ * Does not build any telemetry dictionaries.
+ */
++ (NSTimeInterval)lastBKSDispatchTimestamp;
+
 /**
  * Recent BKS dispatch telemetry snapshots, oldest to newest.
  * Pass 0 to return all retained snapshots.
  */
 + (NSArray<NSDictionary *> *)recentBKSDispatchHistory:(NSUInteger)limit;
 
+/**
+ * Compact summaries (source/destination/targetClass/pid/counts) of recent
+ * BKS dispatches newer than `after` and younger than maxAge seconds,
+ * oldest to newest. Pass 0 to disable either filter.
+ */
++ (NSArray<NSDictionary *> *)recentBKSDispatchSummariesAfter:(NSTimeInterval)after
+                                                      maxAge:(NSTimeInterval)maxAge
+                                                       limit:(NSUInteger)limit;
+
+/**
+ * Convert an input coordinate to screen points. space is "points",
+ * "pixels" (screenshot pixels) or "normalized" (0..1); nil/"auto" keeps
+ * the legacy pixel-detection heuristic. Uses cached screen metrics.
+ */
++ (CGPoint)pointFromInput:(CGPoint)point space:(nullable NSString *)space;
+
+/**
+ * Adaptive routing table: per (frontmost bundle, gesture, backend)
+ * acceptance rate, verified-delta rate, p50 latency and expected cost,
+ * most recently used first.
+ */
++ (NSArray<NSDictionary *> *)strategyStats:(NSUInteger)limit;
+
+/**
+ * Report whether the most recent swipe/drag/long press produced a UI
+ * delta. Ignored unless a gesture finished within the last few seconds.
+ */
++ (void)noteLastGestureVerified:(BOOL)verified;
+
 /**
  * Perform a single tap at the specified screen coordinates.
  * Coordinates are in screen points (not normalized).
@@ -201,6 +256,21 @@ NS_ASSUME_NONNULL_BEGIN
           duration:(NSTimeInterval)duration
             method:(nullable NSString *)method;
 
+/**
+ * Inject one phase for one finger through the SimulateTouch path; the
+ * finger stays down between calls. A down on a finger that is already
+ * down continues it as a move, a move on a lifted finger starts it, and
+ * an up on a lifted finger does nothing.
+ * finger is 0..19; coordinates are screen points (pixel heuristic as for
+ * taps). TouchStreamMethod / KIMIRUN_TOUCH_STREAM_METHOD=conn dispatches
+ * through the HID connection instead. Call on the main thread: finger
+ * state is shared with the SimulateTouch tap and swipe paths.
+ */
++ (BOOL)streamTouchPhase:(KimiRunTouchStreamPhase)phase finger:(NSInteger)finger atX:(CGFloat)x Y:(CGFloat)y;
+
+/** Lift a streamed finger at its last position. NO if it was not down. Main thread. */
++ (BOOL)liftStreamedFinger:(NSInteger)finger;
+
 /**
  * Send a keyboard usage code (usage page 0x07).
  * @param usage HID usage ID (keyboard page)
@@ -209,10 +279,53 @@ NS_ASSUME_NONNULL_BEGIN
 + (BOOL)sendKeyUsage:(uint16_t)usage down:(BOOL)down;
 
 /**
- * Type ASCII text using HID keyboard events (best-effort).
+ * Type text into the focused input. Tries insertText on the focused
+ * responder first, then plays a HID key stream (US layout) on the typing
+ * queue. Off the main thread this waits for playback. On the main thread
+ * playback is queued and NO is returned, since it may still fail; use
+ * typeTextAsync:options:completion: there to learn the outcome.
  */
 + (BOOL)typeText:(NSString *)text;
 
+/**
+ * Same as typeText: but returns the job status dictionary (see
+ * typingJobStatus:). options as for typeTextAsync:options:. Off the main
+ * thread this waits for playback. On the main thread it never waits: the
+ * insert runs inline and, if keys are needed, the status comes back still
+ * "queued" or "running"; use typeTextAsync:options:completion: for the final one.
+ */
++ (nullable NSDictionary *)typeText:(NSString *)text options:(nullable NSDictionary *)options;
+
+/**
+ * Start typing without waiting. Returns a job ID for typingJobStatus:, or
+ * nil for empty text. options: mode ("auto" inserts into the focused input
+ * and falls back to HID keys, "insert" never uses HID, "hid" skips the
+ * insert), holdMS (key down time), intervalMS (gap between characters).
+ */
++ (nullable NSString *)typeTextAsync:(NSString *)text options:(nullable NSDictionary *)options;
+
+/**
+ * typeTextAsync:options: that calls completion on the main thread with the
+ * final job status. Returns nil (and never calls completion) for empty text.
+ */
++ (nullable NSString *)typeTextAsync:(NSString *)text
+                             options:(nullable NSDictionary *)options
+                          completion:(nullable void (^)(NSDictionary *status))completion;
+
+/**
+ * Insert the whole string into the focused text input in one call (no HID
+ * fallback). Any characters are accepted. Returns success, insertPath
+ * (firstResponder / keyboardImpl / keyboardTaskQueue) and elapsedMS.
+ */
++ (NSDictionary *)insertTextIntoFocusedInput:(NSString *)text;
+
+/**
+ * Status of a recent typing job: state, mode, path (insert / hid),
+ * insertPath, insertMS, fallback, charactersTyped, keyEvents, elapsedMS,
+ * charsPerSecond. nil for unknown IDs.
+ */
++ (nullable NSDictionary *)typingJobStatus:(NSString *)jobID;
+
 /**
  * Perform a drag gesture from start point to end point.
  * Uses 50 interpolation steps for smoother movement.
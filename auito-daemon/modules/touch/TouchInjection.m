@@ -9,6 +9,8 @@
 #import "TouchInjection.h"
 #import "AXTouchInjection.h"
 #import "internal/TouchInjectionInternal.h"
+#import "../accessibility/AccessibilityTree.h"
+#import "../log/KimiRunLogRing.h"
 #import <UIKit/UIKit.h>
 #import <dlfcn.h>
 #import <mach/mach_time.h>
@@ -122,19 +124,13 @@ int g_adminClientType = -1;
 void *g_hidConnection = NULL;
 
 IOHIDEventSystemClientRef g_senderClient = NULL;
-uint64_t g_senderID = 0;
-BOOL g_senderCaptured = NO;
-int g_senderSource = 0; // 0=none, 1=ioreg, 2=callback, 3=persisted, 4=override
 BOOL g_senderFallbackEnabled = YES;
-int g_senderCallbackCount = 0;
 BOOL g_senderThreadRunning = NO;
 NSThread *g_senderThread = nil;
 CFRunLoopRef g_senderRunLoop = NULL;
 BOOL g_senderCleanupDone = NO;
 IOHIDEventSystemClientRef g_senderClientMain = NULL;
 BOOL g_senderMainRegistered = NO;
-int g_senderCallbackDigitizerCount = 0;
-int g_senderLastEventType = -1;
 IOHIDEventSystemClientRef g_senderClientDispatch = NULL;
 BOOL g_senderDispatchRegistered = NO;
 // Mirror SimulateTouch defaults: no matching filters, no extra callback registrations
@@ -147,31 +143,30 @@ int g_proxySenderDigitizerCount = 0;
 NSString *g_proxySenderSource = nil;
 BOOL g_loggedBKHIDSelectors = NO;
 __weak id g_currentFirstResponder = nil;
-NSString *const kKimiRunPrefsSuite = @"com.auito.daemon";
 static NSString *KimiRunLogPath(void) {
     return @"/var/mobile/Library/Preferences/kimirun_touch.log";
 }
 
+// Log lines go through the async ring; the writer thread appends in batches
+// and rotates past kKimiRunLogMaxFileBytes.
+static const uint64_t kKimiRunLogMaxFileBytes = 2 * 1024 * 1024;
+static const unsigned kKimiRunLogKeepFiles = 2;
+
 void KimiRunLog(NSString *line) {
     if (!line) {
         return;
     }
-    @try {
-        NSString *msg = [line stringByAppendingString:@"\n"];
-        NSFileHandle *fh = [NSFileHandle fileHandleForWritingAtPath:KimiRunLogPath()];
-        if (!fh) {
-            [msg writeToFile:KimiRunLogPath() atomically:YES encoding:NSUTF8StringEncoding error:nil];
-            return;
-        }
-        [fh seekToEndOfFile];
-        NSData *data = [msg dataUsingEncoding:NSUTF8StringEncoding];
-        if (data) {
-            [fh writeData:data];
-        }
-        [fh closeFile];
-    } @catch (NSException *e) {
-        // Best effort only
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        KimiRunLogRingConfigure(KimiRunLogPath().fileSystemRepresentation,
+                                kKimiRunLogMaxFileBytes,
+                                kKimiRunLogKeepFiles);
+    });
+    const char *utf8 = line.UTF8String;
+    if (!utf8) {
+        return;
     }
+    KimiRunLogRingPush(KimiRunLogLevelInfo, NULL, utf8, strlen(utf8));
 }
 
 
@@ -187,33 +182,10 @@ uint64_t GetCurrentTimestamp(void) {
     return mach_absolute_time();
 }
 
-// Update screen metrics
+// Update screen metrics (forces a rebuild of the cached snapshot)
 BOOL UpdateScreenMetrics(void) {
-    UIScreen *mainScreen = [UIScreen mainScreen];
-    if (!mainScreen) {
-        NSLog(@"[KimiRunTouchInjection] Warning: UIScreen not available");
-        return NO;
-    }
-    
-    CGRect bounds = mainScreen.bounds;
-    g_screenWidth = bounds.size.width;
-    g_screenHeight = bounds.size.height;
-    g_screenScale = mainScreen.scale > 0 ? mainScreen.scale : 1.0;
-    if ([mainScreen respondsToSelector:@selector(nativeBounds)]) {
-        CGRect nativeBounds = mainScreen.nativeBounds;
-        g_screenPixelWidth = nativeBounds.size.width;
-        g_screenPixelHeight = nativeBounds.size.height;
-    } else {
-        g_screenPixelWidth = g_screenWidth * g_screenScale;
-        g_screenPixelHeight = g_screenHeight * g_screenScale;
-    }
-    
-    if (g_screenWidth <= 0 || g_screenHeight <= 0) {
-        NSLog(@"[KimiRunTouchInjection] Warning: Invalid screen dimensions");
-        return NO;
-    }
-    
-    return YES;
+    KimiRunScreenMetricsInvalidate();
+    return KimiRunScreenMetricsSnapshot(NULL);
 }
 
 // Convert pixel coordinates to points if needed (e.g. from screenshots)
@@ -221,23 +193,10 @@ void AdjustInputCoordinates(CGFloat *x, CGFloat *y) {
     if (!x || !y) {
         return;
     }
-    if (g_screenWidth <= 0 || g_screenHeight <= 0) {
-        if (!UpdateScreenMetrics()) {
-            return;
-        }
-    }
-    if (g_screenScale <= 1.0) {
-        return;
-    }
-    BOOL looksLikePixels = (*x > g_screenWidth + 1.0 || *y > g_screenHeight + 1.0) &&
-                           (*x <= g_screenPixelWidth + 1.0) &&
-                           (*y <= g_screenPixelHeight + 1.0);
-    if (looksLikePixels) {
-        *x = *x / g_screenScale;
-        *y = *y / g_screenScale;
-        NSLog(@"[KimiRunTouchInjection] Converted pixel coords to points: (%.1f, %.1f) scale=%.1f",
-              *x, *y, g_screenScale);
-    }
+    CGPoint point = CGPointMake(*x, *y);
+    KimiRunConvertInputPoints(&point, 1, KimiRunCoordinateSpaceAuto);
+    *x = point.x;
+    *y = point.y;
 }
 
 
@@ -516,76 +475,164 @@ BOOL ForceFocusSearchField(void) {
     return NO;
 }
 
-static BOOL UsageForChar(unichar c, uint16_t *usage, BOOL *needsShift) {
-    if (!usage || !needsShift) {
+// Hands the whole string to the focused text input (first responder,
+// UIKeyboardImpl, or its task queue) in one call. Main thread only.
+// pathOut names the receiver that accepted it.
+BOOL KimiRunInsertTextViaFocusedInput(NSString *text, NSString **pathOut) {
+    if (!text || text.length == 0) {
         return NO;
     }
-    *needsShift = NO;
+    LogFocusContext(@"BeforeType");
 
-    if (c >= 'A' && c <= 'Z') {
-        *needsShift = YES;
-        c = (unichar)tolower((int)c);
-    }
-    if (c >= 'a' && c <= 'z') {
-        *usage = (uint16_t)(0x04 + (c - 'a'));
-        return YES;
-    }
-    if (c >= '1' && c <= '9') {
-        *usage = (uint16_t)(0x1E + (c - '1'));
-        return YES;
-    }
-    if (c == '0') {
-        *usage = 0x27;
-        return YES;
-    }
-    if (c == ' ') {
-        *usage = 0x2C;
-        return YES;
+    id responder = CurrentFirstResponder();
+    if (!responder) {
+        ForceFocusSearchField();
+        responder = CurrentFirstResponder();
+        LogFocusContext(@"AfterForceFocus");
     }
-    if (c == '\n' || c == '\r') {
-        *usage = 0x28; // Enter
-        return YES;
+    if (responder && [responder respondsToSelector:@selector(insertText:)]) {
+        @try {
+            [responder performSelector:@selector(insertText:) withObject:text];
+            NSLog(@"[KimiRunTouchInjection] Inserted text via first responder: %@", responder);
+            KimiRunLog([NSString stringWithFormat:@"[TypeText] inserted via firstResponder=%@", NSStringFromClass([responder class])]);
+            if (pathOut) {
+                *pathOut = @"firstResponder";
+            }
+            KimiRunA11yNoteActionPerformed();
+            return YES;
+        } @catch (NSException *e) {
+            NSLog(@"[KimiRunTouchInjection] First responder insertText failed: %@", e);
+            KimiRunLog([NSString stringWithFormat:@"[TypeText] firstResponder insertText failed: %@", e]);
+        }
     }
-    if (c == '\b') {
-        *usage = 0x2A; // Backspace
-        return YES;
+
+    Class kbClass = NSClassFromString(@"UIKeyboardImpl");
+    if (kbClass) {
+        id kb = nil;
+        if ([kbClass respondsToSelector:@selector(activeInstance)]) {
+            kb = [kbClass performSelector:@selector(activeInstance)];
+        } else if ([kbClass respondsToSelector:@selector(sharedInstance)]) {
+            kb = [kbClass performSelector:@selector(sharedInstance)];
+        }
+        if (kb && [kb respondsToSelector:@selector(insertText:)]) {
+            @try {
+                [kb performSelector:@selector(insertText:) withObject:text];
+                NSLog(@"[KimiRunTouchInjection] Inserted text via UIKeyboardImpl");
+                KimiRunLog(@"[TypeText] inserted via UIKeyboardImpl insertText");
+                if (pathOut) {
+                    *pathOut = @"keyboardImpl";
+                }
+                KimiRunA11yNoteActionPerformed();
+                return YES;
+            } @catch (NSException *e) {
+                NSLog(@"[KimiRunTouchInjection] UIKeyboardImpl insertText failed: %@", e);
+                KimiRunLog([NSString stringWithFormat:@"[TypeText] UIKeyboardImpl insertText failed: %@", e]);
+            }
+        }
+        // Explicit focus+insert pipeline using UIKeyboardImpl task queue (only if UIKeyboardTaskQueue exists)
+        if (kb && [kb respondsToSelector:NSSelectorFromString(@"taskQueue")]) {
+            id queue = [kb performSelector:NSSelectorFromString(@"taskQueue")];
+            Class queueClass = queue ? [queue class] : Nil;
+            if (queue && queueClass && [NSStringFromClass(queueClass) containsString:@"UIKeyboardTaskQueue"] &&
+                [queue respondsToSelector:NSSelectorFromString(@"addTask:")]) {
+                @try {
+                    // Ensure keyboard is active if possible
+                    if ([kb respondsToSelector:NSSelectorFromString(@"setKeyboardActive:")]) {
+                        void (*msgSendActive)(id, SEL, BOOL) = (void (*)(id, SEL, BOOL))objc_msgSend;
+                        msgSendActive(kb, NSSelectorFromString(@"setKeyboardActive:"), YES);
+                    }
+
+                    void (^taskBlock)(id, int) = ^(id context, int arg2) {
+                        SEL addInputSel = NSSelectorFromString(@"addInputString:withFlags:executionContext:");
+                        if ([kb respondsToSelector:addInputSel]) {
+                            void (*msgSendAddInput)(id, SEL, id, int, id) = (void (*)(id, SEL, id, int, id))objc_msgSend;
+                            msgSendAddInput(kb, addInputSel, text, 0, context);
+                        }
+                    };
+                    void (*msgSendAddTask)(id, SEL, id) = (void (*)(id, SEL, id))objc_msgSend;
+                    msgSendAddTask(queue, NSSelectorFromString(@"addTask:"), taskBlock);
+                    NSLog(@"[KimiRunTouchInjection] Inserted text via UIKeyboardTaskQueue");
+                    KimiRunLog(@"[TypeText] inserted via UIKeyboardTaskQueue");
+                    if (pathOut) {
+                        *pathOut = @"keyboardTaskQueue";
+                    }
+                    KimiRunA11yNoteActionPerformed();
+                    return YES;
+                } @catch (NSException *e) {
+                    NSLog(@"[KimiRunTouchInjection] UIKeyboardTaskQueue insertText failed: %@", e);
+                    KimiRunLog([NSString stringWithFormat:@"[TypeText] UIKeyboardTaskQueue insertText failed: %@", e]);
+                }
+            } else {
+                NSLog(@"[KimiRunTouchInjection] UIKeyboardTaskQueue not available (queue=%p class=%@)",
+                      queue, queueClass ? NSStringFromClass(queueClass) : @"(nil)");
+                KimiRunLog([NSString stringWithFormat:@"[TypeText] UIKeyboardTaskQueue not available (queue=%p class=%@)",
+                          queue, queueClass ? NSStringFromClass(queueClass) : @"(nil)"]);
+            }
+        }
     }
+
     return NO;
 }
 
-static BOOL TypeTextViaHID(NSString *text) {
-    if (!text || text.length == 0) {
+// Dispatches one keyboard usage through the HID clients; safe off the main
+// thread. BKS delivery is only used as a last resort and runs on main.
+BOOL KimiRunPostKeyboardUsage(uint16_t usage, BOOL down) {
+    if (!_IOHIDEventCreateKeyboardEvent || !_IOHIDEventSystemClientDispatchEvent) {
+        NSLog(@"[KimiRunTouchInjection] Keyboard event symbols missing");
         return NO;
     }
-    if (!_IOHIDEventCreateKeyboardEvent || !_IOHIDEventSystemClientDispatchEvent) {
-        NSLog(@"[KimiRunTouchInjection] Keyboard HID symbols missing");
+
+    IOHIDEventRef event = _IOHIDEventCreateKeyboardEvent(kCFAllocatorDefault,
+                                                         GetCurrentTimestamp(),
+                                                         0x07,
+                                                         usage,
+                                                         down,
+                                                         0);
+    if (!event) {
         return NO;
     }
 
-    BOOL okAny = NO;
-    for (NSUInteger i = 0; i < text.length; i++) {
-        unichar c = [text characterAtIndex:i];
-        uint16_t usage = 0;
-        BOOL needsShift = NO;
-        if (!UsageForChar(c, &usage, &needsShift)) {
-            continue;
-        }
-        if (needsShift) {
-            [KimiRunTouchInjection sendKeyUsage:0xE1 down:YES];
-            usleep(5000);
-        }
-        if ([KimiRunTouchInjection sendKeyUsage:usage down:YES]) {
-            okAny = YES;
+    if (_IOHIDEventSetSenderID) {
+        uint64_t sender = KimiRunCurrentSenderID();
+        if (sender == 0) {
+            sender = kTouchSenderID;
         }
-        usleep(8000);
-        [KimiRunTouchInjection sendKeyUsage:usage down:NO];
-        if (needsShift) {
-            usleep(3000);
-            [KimiRunTouchInjection sendKeyUsage:0xE1 down:NO];
+        _IOHIDEventSetSenderID(event, sender);
+    }
+
+    BOOL dispatched = NO;
+    if (g_hidClient) {
+        _IOHIDEventSystemClientDispatchEvent(g_hidClient, event);
+        dispatched = YES;
+    }
+    if (g_simClient) {
+        _IOHIDEventSystemClientDispatchEvent(g_simClient, event);
+        dispatched = YES;
+    }
+    if (g_adminClient) {
+        _IOHIDEventSystemClientDispatchEvent(g_adminClient, event);
+        dispatched = YES;
+    }
+    if (!dispatched && g_bksSharedDeliveryManager) {
+        if ([NSThread isMainThread]) {
+            dispatched = [KimiRunTouchInjection deliverViaBKS:event];
+        } else {
+            // Queued, not synchronous: the main thread may be waiting on the
+            // typing queue. Main-queue FIFO keeps key order intact.
+            CFRetain(event);
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [KimiRunTouchInjection deliverViaBKS:event];
+                CFRelease(event);
+            });
+            dispatched = YES;
         }
-        usleep(8000);
     }
-    return okAny;
+
+    CFRelease(event);
+    if (dispatched && !down) {
+        KimiRunA11yNoteActionPerformed();
+    }
+    return dispatched;
 }
 
 
@@ -594,27 +641,40 @@ static BOOL TypeTextViaHID(NSString *text) {
 @implementation KimiRunTouchInjection
 
 + (uint64_t)senderID {
-    return g_senderID;
+    return KimiRunCurrentSenderID();
 }
 
 + (BOOL)senderIDCaptured {
-    return g_senderCaptured;
+    KimiRunSenderIDSnapshot snapshot;
+    KimiRunSenderIDGetSnapshot(&snapshot);
+    return snapshot.captured;
 }
 
 + (NSString *)senderIDSourceString {
-    switch (g_senderSource) {
-        case 1: return @"ioreg";
-        case 2: return @"callback";
-        case 3: return @"persisted";
-        case 4: return @"override";
-        default: return (g_senderID == 0 ? @"none" : @"unknown");
-    }
+    KimiRunSenderIDSnapshot snapshot;
+    KimiRunSenderIDGetSnapshot(&snapshot);
+    return KimiRunSenderIDSourceName(snapshot.source, snapshot.senderID);
+}
+
++ (NSDictionary *)senderIDState {
+    KimiRunSenderIDSnapshot snapshot;
+    KimiRunSenderIDGetSnapshot(&snapshot);
+    return @{
+        @"senderID": @(snapshot.senderID),
+        @"captured": @(snapshot.captured),
+        @"source": KimiRunSenderIDSourceName(snapshot.source, snapshot.senderID),
+        @"generation": @(snapshot.generation),
+        @"callbackCount": @(snapshot.callbackCount),
+        @"digitizerCount": @(snapshot.digitizerCount),
+        @"lastEventType": @(snapshot.lastEventType),
+        @"ignoredInjected": @(snapshot.ignoredInjected),
+    };
 }
 
 + (void)setSenderIDOverride:(uint64_t)senderID persist:(BOOL)persist {
-    g_senderID = senderID;
-    g_senderCaptured = NO;
-    g_senderSource = (senderID != 0) ? 4 : 0;
+    KimiRunSenderIDPublish(senderID,
+                           (senderID != 0) ? KimiRunSenderIDSourceOverride : KimiRunSenderIDSourceNone,
+                           NO);
     if (persist && senderID != 0) {
         KimiRunPersistSenderID(senderID);
     }
@@ -622,10 +682,11 @@ static BOOL TypeTextViaHID(NSString *text) {
         // Re-attempt IORegistry lookup when clearing override
         KimiRunTryLoadSenderIDFromIORegistry();
     }
+    uint64_t effective = KimiRunCurrentSenderID();
     NSLog(@"[KimiRunTouchInjection] SenderID override set: 0x%llX (persist=%d)",
-          g_senderID, persist ? 1 : 0);
+          effective, persist ? 1 : 0);
     KimiRunLog([NSString stringWithFormat:@"[SenderID] override=0x%llX persist=%d",
-                g_senderID, persist ? 1 : 0]);
+                effective, persist ? 1 : 0]);
 }
 
 + (void)setProxySenderContextWithID:(uint64_t)senderID
@@ -677,7 +738,9 @@ static BOOL TypeTextViaHID(NSString *text) {
 }
 
 + (int)senderIDCallbackCount {
-    return g_senderCallbackCount;
+    KimiRunSenderIDSnapshot snapshot;
+    KimiRunSenderIDGetSnapshot(&snapshot);
+    return snapshot.callbackCount;
 }
 
 + (BOOL)senderIDCaptureThreadRunning {
@@ -685,11 +748,15 @@ static BOOL TypeTextViaHID(NSString *text) {
 }
 
 + (int)senderIDDigitizerCount {
-    return g_senderCallbackDigitizerCount;
+    KimiRunSenderIDSnapshot snapshot;
+    KimiRunSenderIDGetSnapshot(&snapshot);
+    return snapshot.digitizerCount;
 }
 
 + (int)senderIDLastEventType {
-    return g_senderLastEventType;
+    KimiRunSenderIDSnapshot snapshot;
+    KimiRunSenderIDGetSnapshot(&snapshot);
+    return snapshot.lastEventType;
 }
 
 + (BOOL)senderIDMainRegistered {
@@ -725,15 +792,44 @@ static BOOL TypeTextViaHID(NSString *text) {
 }
 
 + (NSDictionary *)lastBKSDispatchInfo {
-    NSDictionary *info = KimiRunCopyLastBKSDispatchInfo();
+    NSDictionary *info = KimiRunCopyLastBKSDispatchInfo(YES);
     return info ?: @{};
 }
 
++ (NSDictionary *)lastBKSDispatchInfoIncludingRouteDetail:(BOOL)includeRouteDetail {
+    NSDictionary *info = KimiRunCopyLastBKSDispatchInfo(includeRouteDetail);
+    return info ?: @{};
+}
+
++ (NSTimeInterval)lastBKSDispatchTimestamp {
+    return KimiRunLastBKSDispatchTimestamp();
+}
+
 + (NSArray<NSDictionary *> *)recentBKSDispatchHistory:(NSUInteger)limit {
     NSArray<NSDictionary *> *history = KimiRunCopyRecentBKSDispatchHistory(limit);
     return history ?: @[];
 }
 
++ (NSArray<NSDictionary *> *)recentBKSDispatchSummariesAfter:(NSTimeInterval)after
+                                                      maxAge:(NSTimeInterval)maxAge
+                                                       limit:(NSUInteger)limit {
+    NSArray<NSDictionary *> *summaries = KimiRunCopyBKSDispatchSummaries(after, maxAge, limit);
+    return summaries ?: @[];
+}
+
++ (CGPoint)pointFromInput:(CGPoint)point space:(NSString *)space {
+    KimiRunConvertInputPoints(&point, 1, KimiRunCoordinateSpaceFromString(space));
+    return point;
+}
+
++ (NSArray<NSDictionary *> *)strategyStats:(NSUInteger)limit {
+    return KimiRunCopyStrategyStats(limit) ?: @[];
+}
+
++ (void)noteLastGestureVerified:(BOOL)verified {
+    KimiRunStrategyNoteVerification(verified);
+}
+
 + (BOOL)forceFocusSearchField {
     return ForceFocusSearchField();
 }
@@ -741,13 +837,20 @@ static BOOL TypeTextViaHID(NSString *text) {
 
 + (NSDictionary *)hidDiagnostics {
     CGRect bounds = [UIScreen mainScreen].bounds;
+    KimiRunLogRingStats logStats;
+    KimiRunLogRingGetStats(&logStats);
+    KimiRunSenderIDSnapshot sender;
+    KimiRunSenderIDGetSnapshot(&sender);
     return @{
-        @"senderID": [NSString stringWithFormat:@"0x%llX", (unsigned long long)g_senderID],
-        @"senderCaptured": @(g_senderCaptured),
-        @"senderSource": [self senderIDSourceString] ?: @"none",
-        @"senderCallbackCount": @(g_senderCallbackCount),
-        @"senderDigitizerCount": @(g_senderCallbackDigitizerCount),
-        @"senderLastEventType": @(g_senderLastEventType),
+        @"senderID": [NSString stringWithFormat:@"0x%llX", (unsigned long long)sender.senderID],
+        @"senderCaptured": @(sender.captured),
+        @"senderSource": KimiRunSenderIDSourceName(sender.source, sender.senderID),
+        @"senderGeneration": @(sender.generation),
+        @"senderCallbackCount": @(sender.callbackCount),
+        @"senderDigitizerCount": @(sender.digitizerCount),
+        @"senderLastEventType": @(sender.lastEventType),
+        @"senderIgnoredInjected": @(sender.ignoredInjected),
+        @"senderEarlyEvents": KimiRunSenderIDEarlyEvents(),
         @"senderCaptureThreadRunning": @(g_senderThreadRunning),
         @"senderMainRegistered": @(g_senderMainRegistered),
         @"senderDispatchRegistered": @(g_senderDispatchRegistered),
@@ -765,6 +868,17 @@ static BOOL TypeTextViaHID(NSString *text) {
         @"screenHeight": @(bounds.size.height),
         @"screenScale": @([UIScreen mainScreen].scale),
         @"initialized": @(g_initialized),
+        @"logRing": @{
+            @"enqueued": @(logStats.enqueued),
+            @"dropped": @(logStats.dropped),
+            @"written": @(logStats.written),
+            @"rotations": @(logStats.rotations),
+            @"writeErrors": @(logStats.writeErrors),
+            @"wakeups": @(logStats.wakeups),
+        },
+        @"bksAtoms": KimiRunBKSAtomDiagnostics(),
+        @"touchTrace": KimiRunTouchTraceDiagnostics(),
+        @"zxTouchClient": KimiRunZXTouchClientDiagnostics(),
     };
 }
 
@@ -773,151 +887,83 @@ static BOOL TypeTextViaHID(NSString *text) {
 }
 
 + (BOOL)sendKeyUsage:(uint16_t)usage down:(BOOL)down {
-    if (![NSThread isMainThread]) {
-        __block BOOL result = NO;
-        dispatch_sync(dispatch_get_main_queue(), ^{
-            result = [self sendKeyUsage:usage down:down];
-        });
-        return result;
-    }
-
     if (!g_initialized) {
-        if (![self initialize]) {
+        __block BOOL ready = NO;
+        if ([NSThread isMainThread]) {
+            ready = [self initialize];
+        } else {
+            dispatch_sync(dispatch_get_main_queue(), ^{
+                ready = g_initialized || [self initialize];
+            });
+        }
+        if (!ready) {
             return NO;
         }
     }
+    return KimiRunPostKeyboardUsage(usage, down);
+}
 
-    if (!_IOHIDEventCreateKeyboardEvent || !_IOHIDEventSystemClientDispatchEvent) {
-        NSLog(@"[KimiRunTouchInjection] Keyboard event symbols missing");
++ (BOOL)typeText:(NSString *)text {
+    if (!text || text.length == 0) {
         return NO;
     }
-
-    IOHIDEventRef event = _IOHIDEventCreateKeyboardEvent(kCFAllocatorDefault,
-                                                         GetCurrentTimestamp(),
-                                                         0x07,
-                                                         usage,
-                                                         down,
-                                                         0);
-    if (!event) {
+    if ([NSThread isMainThread]) {
+        if (KimiRunInsertTextViaFocusedInput(text, NULL)) {
+            return YES;
+        }
+        // Key playback must not sleep on the main thread; queue it instead.
+        // Its outcome is not known yet, so this is not reported as typed.
+        KimiRunStartTypingJob(text, @{@"mode": @"hid"});
         return NO;
     }
+    NSDictionary *result = KimiRunRunTypingJob(text, nil);
+    return [result[@"success"] boolValue];
+}
 
-    if (_IOHIDEventSetSenderID) {
-        uint64_t sender = g_senderID != 0 ? g_senderID : kTouchSenderID;
-        _IOHIDEventSetSenderID(event, sender);
-    }
++ (NSDictionary *)typeText:(NSString *)text options:(NSDictionary *)options {
+    return KimiRunRunTypingJob(text, options);
+}
 
-    BOOL dispatched = NO;
-    if (g_hidClient) {
-        _IOHIDEventSystemClientDispatchEvent(g_hidClient, event);
-        dispatched = YES;
-    }
-    if (g_simClient) {
-        _IOHIDEventSystemClientDispatchEvent(g_simClient, event);
-        dispatched = YES;
-    }
-    if (g_adminClient) {
-        _IOHIDEventSystemClientDispatchEvent(g_adminClient, event);
-        dispatched = YES;
-    }
-    if (!dispatched && g_bksSharedDeliveryManager) {
-        dispatched = [self deliverViaBKS:event];
-    }
++ (NSString *)typeTextAsync:(NSString *)text options:(NSDictionary *)options {
+    return KimiRunStartTypingJob(text, options);
+}
 
-    CFRelease(event);
-    return dispatched;
++ (NSString *)typeTextAsync:(NSString *)text
+                    options:(NSDictionary *)options
+                 completion:(void (^)(NSDictionary *status))completion {
+    return KimiRunStartTypingJobWithCompletion(text, options, completion);
 }
 
-+ (BOOL)typeText:(NSString *)text {
++ (NSDictionary *)insertTextIntoFocusedInput:(NSString *)text {
     if (!text || text.length == 0) {
-        return NO;
+        return @{@"success": @NO, @"error": @"empty_text"};
     }
     if (![NSThread isMainThread]) {
-        __block BOOL result = NO;
+        __block NSDictionary *result = nil;
         dispatch_sync(dispatch_get_main_queue(), ^{
-            result = [self typeText:text];
+            result = [self insertTextIntoFocusedInput:text];
         });
         return result;
     }
-
-    LogFocusContext(@"BeforeType");
-
-    id responder = CurrentFirstResponder();
-    if (!responder) {
-        ForceFocusSearchField();
-        responder = CurrentFirstResponder();
-        LogFocusContext(@"AfterForceFocus");
-    }
-    if (responder && [responder respondsToSelector:@selector(insertText:)]) {
-        @try {
-            [responder performSelector:@selector(insertText:) withObject:text];
-            NSLog(@"[KimiRunTouchInjection] Inserted text via first responder: %@", responder);
-            KimiRunLog([NSString stringWithFormat:@"[TypeText] inserted via firstResponder=%@", NSStringFromClass([responder class])]);
-            return YES;
-        } @catch (NSException *e) {
-            NSLog(@"[KimiRunTouchInjection] First responder insertText failed: %@", e);
-            KimiRunLog([NSString stringWithFormat:@"[TypeText] firstResponder insertText failed: %@", e]);
-        }
-    }
-
-    Class kbClass = NSClassFromString(@"UIKeyboardImpl");
-    if (kbClass) {
-        id kb = nil;
-        if ([kbClass respondsToSelector:@selector(activeInstance)]) {
-            kb = [kbClass performSelector:@selector(activeInstance)];
-        } else if ([kbClass respondsToSelector:@selector(sharedInstance)]) {
-            kb = [kbClass performSelector:@selector(sharedInstance)];
-        }
-        if (kb && [kb respondsToSelector:@selector(insertText:)]) {
-            @try {
-                [kb performSelector:@selector(insertText:) withObject:text];
-                NSLog(@"[KimiRunTouchInjection] Inserted text via UIKeyboardImpl");
-                KimiRunLog(@"[TypeText] inserted via UIKeyboardImpl insertText");
-                return YES;
-            } @catch (NSException *e) {
-                NSLog(@"[KimiRunTouchInjection] UIKeyboardImpl insertText failed: %@", e);
-                KimiRunLog([NSString stringWithFormat:@"[TypeText] UIKeyboardImpl insertText failed: %@", e]);
-            }
-        }
-        // Explicit focus+insert pipeline using UIKeyboardImpl task queue (only if UIKeyboardTaskQueue exists)
-        if (kb && [kb respondsToSelector:NSSelectorFromString(@"taskQueue")]) {
-            id queue = [kb performSelector:NSSelectorFromString(@"taskQueue")];
-            Class queueClass = queue ? [queue class] : Nil;
-            if (queue && queueClass && [NSStringFromClass(queueClass) containsString:@"UIKeyboardTaskQueue"] &&
-                [queue respondsToSelector:NSSelectorFromString(@"addTask:")]) {
-                @try {
-                    // Ensure keyboard is active if possible
-                    if ([kb respondsToSelector:NSSelectorFromString(@"setKeyboardActive:")]) {
-                        void (*msgSendActive)(id, SEL, BOOL) = (void (*)(id, SEL, BOOL))objc_msgSend;
-                        msgSendActive(kb, NSSelectorFromString(@"setKeyboardActive:"), YES);
-                    }
-
-                    void (^taskBlock)(id, int) = ^(id context, int arg2) {
-                        SEL addInputSel = NSSelectorFromString(@"addInputString:withFlags:executionContext:");
-                        if ([kb respondsToSelector:addInputSel]) {
-                            void (*msgSendAddInput)(id, SEL, id, int, id) = (void (*)(id, SEL, id, int, id))objc_msgSend;
-                            msgSendAddInput(kb, addInputSel, text, 0, context);
-                        }
-                    };
-                    void (*msgSendAddTask)(id, SEL, id) = (void (*)(id, SEL, id))objc_msgSend;
-                    msgSendAddTask(queue, NSSelectorFromString(@"addTask:"), taskBlock);
-                    NSLog(@"[KimiRunTouchInjection] Inserted text via UIKeyboardTaskQueue");
-                    KimiRunLog(@"[TypeText] inserted via UIKeyboardTaskQueue");
-                    return YES;
-                } @catch (NSException *e) {
-                    NSLog(@"[KimiRunTouchInjection] UIKeyboardTaskQueue insertText failed: %@", e);
-                    KimiRunLog([NSString stringWithFormat:@"[TypeText] UIKeyboardTaskQueue insertText failed: %@", e]);
-                }
-            } else {
-                NSLog(@"[KimiRunTouchInjection] UIKeyboardTaskQueue not available (queue=%p class=%@)",
-                      queue, queueClass ? NSStringFromClass(queueClass) : @"(nil)");
-                KimiRunLog([NSString stringWithFormat:@"[TypeText] UIKeyboardTaskQueue not available (queue=%p class=%@)",
-                          queue, queueClass ? NSStringFromClass(queueClass) : @"(nil)"]);
-            }
-        }
-    }
-
-    return TypeTextViaHID(text);
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSString *insertPath = nil;
+    BOOL inserted = KimiRunInsertTextViaFocusedInput(text, &insertPath);
+    double elapsedMS = (CFAbsoluteTimeGetCurrent() - start) * 1000.0;
+    KimiRunLog([NSString stringWithFormat:@"[TypeText] bulk insert ok=%d path=%@ length=%lu elapsedMS=%.2f",
+                inserted, insertPath ?: @"(none)", (unsigned long)text.length, elapsedMS]);
+    NSMutableDictionary *result = [NSMutableDictionary dictionary];
+    result[@"success"] = @(inserted);
+    result[@"path"] = @"insert";
+    result[@"length"] = @(text.length);
+    result[@"elapsedMS"] = @(elapsedMS);
+    if (insertPath.length > 0) {
+        result[@"insertPath"] = insertPath;
+    }
+    return result;
+}
+
++ (NSDictionary *)typingJobStatus:(NSString *)jobID {
+    return KimiRunTypingJobStatus(jobID);
 }
 
 
@@ -358,13 +358,13 @@ static void KimiRunInvalidateBKSAssertion(id assertion) {
 @implementation KimiRunTouchInjection (BKSRoutingDispatch)
 
 static BOOL KimiRunBKSPostRouteDispatchEnabled(void) {
-    return KimiRunTouchEnvBool("KIMIRUN_BKS_POST_ROUTE_DISPATCH",
-                               KimiRunTouchPrefBool(@"BKSPostRouteDispatch", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_BKS_POST_ROUTE_DISPATCH",
+                               KimiRunPrefsBool(@"BKSPostRouteDispatch", NO));
 }
 
 static BOOL KimiRunBKSPostRouteContextDispatchEnabled(void) {
-    return KimiRunTouchEnvBool("KIMIRUN_BKS_POST_ROUTE_CONTEXT_DISPATCH",
-                               KimiRunTouchPrefBool(@"BKSPostRouteContextDispatch", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_BKS_POST_ROUTE_CONTEXT_DISPATCH",
+                               KimiRunPrefsBool(@"BKSPostRouteContextDispatch", NO));
 }
 
 static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **pathOut) {
@@ -447,19 +447,25 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
         KimiRunRecordBKSDispatchFailure(@"delivery_manager_unavailable");
         return NO;
     }
-    KimiRunLog([NSString stringWithFormat:@"[BKS] delivery begin manager=%p router=%p",
-                g_bksSharedDeliveryManager, g_bksSharedRouterManager]);
+    // Per-route dictionaries and per-dispatch log lines cost more than the
+    // dispatch itself; only build them when someone will read them. Failure
+    // paths below still log unconditionally.
+    BOOL dispatchDetail = KimiRunBKSDispatchDetailEnabled();
+    if (dispatchDetail) {
+        KimiRunLog([NSString stringWithFormat:@"[BKS] delivery begin manager=%p router=%p",
+                    g_bksSharedDeliveryManager, g_bksSharedRouterManager]);
+    }
     
     id assertion = nil;
-    BOOL focusOverrideEnabled = KimiRunTouchEnvBool("KIMIRUN_BKS_FOCUS_OVERRIDE",
-                                                    KimiRunTouchPrefBool(@"BKSFocusOverride", NO));
+    BOOL focusOverrideEnabled = KimiRunPrefsEnvBool("KIMIRUN_BKS_FOCUS_OVERRIDE",
+                                                    KimiRunPrefsBool(@"BKSFocusOverride", NO));
     SEL setFocusTargetOverrideSel = @selector(_setFocusTargetOverride:);
     BOOL canSetFocusTargetOverride = focusOverrideEnabled &&
                                      [g_bksSharedDeliveryManager respondsToSelector:setFocusTargetOverrideSel];
     BOOL setFocusOverrideForAnyTarget = NO;
 
-    BOOL timingExperimentEnabled = KimiRunTouchEnvBool("KIMIRUN_BKS_TIMING_EXPERIMENT",
-                                                       KimiRunTouchPrefBool(@"BKSTimingExperimentEnabled", NO));
+    BOOL timingExperimentEnabled = KimiRunPrefsEnvBool("KIMIRUN_BKS_TIMING_EXPERIMENT",
+                                                       KimiRunPrefsBool(@"BKSTimingExperimentEnabled", NO));
     NSString *focusHintPhase = KimiRunNormalizeExperimentMode(
         KimiRunTouchEnvOrPrefString("KIMIRUN_BKS_FOCUS_HINT_PHASE",
                                     @"BKSFocusHintPhase",
@@ -472,15 +478,15 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
                                     @"per_target"),
         @[ @"per_target", @"before_all", @"none" ],
         @"per_target");
-    BOOL sortCandidatesByPreference = KimiRunTouchEnvBool("KIMIRUN_BKS_SORT_CANDIDATES",
-                                                          KimiRunTouchPrefBool(@"BKSSortCandidates",
-                                                                               timingExperimentEnabled));
-    BOOL flushEachTarget = KimiRunTouchEnvBool("KIMIRUN_BKS_FLUSH_EACH_TARGET",
-                                               KimiRunTouchPrefBool(@"BKSFlushEachTarget", NO));
-    BOOL useSourceDescriptor = KimiRunTouchEnvBool("KIMIRUN_BKS_USE_SOURCE_DESCRIPTOR",
-                                                   KimiRunTouchPrefBool(@"BKSUseSourceDescriptor", NO));
-    BOOL noSenderDescriptorMatch = KimiRunTouchEnvBool("KIMIRUN_BKS_NO_SENDER_DESCRIPTOR_MATCH",
-                                                       KimiRunTouchPrefBool(@"BKSNoSenderDescriptorMatch", NO));
+    BOOL sortCandidatesByPreference = KimiRunPrefsEnvBool("KIMIRUN_BKS_SORT_CANDIDATES",
+                                                          KimiRunPrefsBool(@"BKSSortCandidates",
+                                                                           timingExperimentEnabled));
+    BOOL flushEachTarget = KimiRunPrefsEnvBool("KIMIRUN_BKS_FLUSH_EACH_TARGET",
+                                               KimiRunPrefsBool(@"BKSFlushEachTarget", NO));
+    BOOL useSourceDescriptor = KimiRunPrefsEnvBool("KIMIRUN_BKS_USE_SOURCE_DESCRIPTOR",
+                                                   KimiRunPrefsBool(@"BKSUseSourceDescriptor", NO));
+    BOOL noSenderDescriptorMatch = KimiRunPrefsEnvBool("KIMIRUN_BKS_NO_SENDER_DESCRIPTOR_MATCH",
+                                                       KimiRunPrefsBool(@"BKSNoSenderDescriptorMatch", NO));
     BOOL autoDisabledSenderDescriptorMatch = NO;
     if (!noSenderDescriptorMatch) {
         BOOL senderCaptured = [KimiRunTouchInjection senderIDCaptured];
@@ -491,45 +497,45 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
             autoDisabledSenderDescriptorMatch = YES;
         }
     }
-    BOOL pinFocusToTarget = KimiRunTouchEnvBool("KIMIRUN_BKS_PIN_FOCUS_TO_TARGET",
-                                                KimiRunTouchPrefBool(@"BKSPinFocusToTarget", NO));
-    BOOL pinFocusSetAdjustedPID = KimiRunTouchEnvBool("KIMIRUN_BKS_PIN_FOCUS_SET_ADJUSTED_PID",
-                                                      KimiRunTouchPrefBool(@"BKSPinFocusSetAdjustedPID", NO));
-    BOOL invalidateDispatchAssertion = KimiRunTouchEnvBool("KIMIRUN_BKS_DISPATCH_ASSERTION_INVALIDATE",
-                                                           KimiRunTouchPrefBool(@"BKSDispatchAssertionInvalidate", YES));
+    BOOL pinFocusToTarget = KimiRunPrefsEnvBool("KIMIRUN_BKS_PIN_FOCUS_TO_TARGET",
+                                                KimiRunPrefsBool(@"BKSPinFocusToTarget", NO));
+    BOOL pinFocusSetAdjustedPID = KimiRunPrefsEnvBool("KIMIRUN_BKS_PIN_FOCUS_SET_ADJUSTED_PID",
+                                                      KimiRunPrefsBool(@"BKSPinFocusSetAdjustedPID", NO));
+    BOOL invalidateDispatchAssertion = KimiRunPrefsEnvBool("KIMIRUN_BKS_DISPATCH_ASSERTION_INVALIDATE",
+                                                           KimiRunPrefsBool(@"BKSDispatchAssertionInvalidate", YES));
     NSInteger dispatchAssertionHoldMS = KimiRunClampInteger(
-        KimiRunTouchEnvInteger("KIMIRUN_BKS_DISPATCH_ASSERTION_HOLD_MS",
-                               KimiRunTouchPrefInteger(@"BKSDispatchAssertionHoldMS", 0)),
+        KimiRunPrefsEnvInteger("KIMIRUN_BKS_DISPATCH_ASSERTION_HOLD_MS",
+                               KimiRunPrefsInteger(@"BKSDispatchAssertionHoldMS", 0)),
         0, 2000);
     NSInteger preDispatchDelayMS = KimiRunClampInteger(
-        KimiRunTouchEnvInteger("KIMIRUN_BKS_PRE_DISPATCH_DELAY_MS",
-                               KimiRunTouchPrefInteger(@"BKSPredispatchDelayMS", 0)),
+        KimiRunPrefsEnvInteger("KIMIRUN_BKS_PRE_DISPATCH_DELAY_MS",
+                               KimiRunPrefsInteger(@"BKSPredispatchDelayMS", 0)),
         0, 300);
     NSInteger perTargetDelayMS = KimiRunClampInteger(
-        KimiRunTouchEnvInteger("KIMIRUN_BKS_PER_TARGET_DELAY_MS",
-                               KimiRunTouchPrefInteger(@"BKSPerTargetDelayMS", 0)),
+        KimiRunPrefsEnvInteger("KIMIRUN_BKS_PER_TARGET_DELAY_MS",
+                               KimiRunPrefsInteger(@"BKSPerTargetDelayMS", 0)),
         0, 300);
     NSInteger postFocusDelayMS = KimiRunClampInteger(
-        KimiRunTouchEnvInteger("KIMIRUN_BKS_POST_FOCUS_DELAY_MS",
-                               KimiRunTouchPrefInteger(@"BKSPostFocusDelayMS", 0)),
+        KimiRunPrefsEnvInteger("KIMIRUN_BKS_POST_FOCUS_DELAY_MS",
+                               KimiRunPrefsInteger(@"BKSPostFocusDelayMS", 0)),
         0, 300);
     NSInteger pinFocusDelayMS = KimiRunClampInteger(
-        KimiRunTouchEnvInteger("KIMIRUN_BKS_PIN_FOCUS_DELAY_MS",
-                               KimiRunTouchPrefInteger(@"BKSPinFocusDelayMS", 0)),
+        KimiRunPrefsEnvInteger("KIMIRUN_BKS_PIN_FOCUS_DELAY_MS",
+                               KimiRunPrefsInteger(@"BKSPinFocusDelayMS", 0)),
         0, 300);
-    BOOL systemFocusExperimentEnabled = KimiRunTouchEnvBool("KIMIRUN_BKS_SYSTEM_FOCUS_EXPERIMENT",
-                                                            KimiRunTouchPrefBool(@"BKSSystemFocusExperimentEnabled", NO));
+    BOOL systemFocusExperimentEnabled = KimiRunPrefsEnvBool("KIMIRUN_BKS_SYSTEM_FOCUS_EXPERIMENT",
+                                                            KimiRunPrefsBool(@"BKSSystemFocusExperimentEnabled", NO));
     NSString *systemFocusPhase = KimiRunNormalizeExperimentMode(
         KimiRunTouchEnvOrPrefString("KIMIRUN_BKS_SYSTEM_FOCUS_PHASE",
                                     @"BKSSystemFocusPhase",
                                     @"none"),
         @[ @"before", @"per_target", @"after", @"none" ],
         @"none");
-    BOOL systemFocusValue = KimiRunTouchEnvBool("KIMIRUN_BKS_SYSTEM_FOCUS_VALUE",
-                                                KimiRunTouchPrefBool(@"BKSSystemFocusValue", NO));
+    BOOL systemFocusValue = KimiRunPrefsEnvBool("KIMIRUN_BKS_SYSTEM_FOCUS_VALUE",
+                                                KimiRunPrefsBool(@"BKSSystemFocusValue", NO));
     NSInteger systemFocusDelayMS = KimiRunClampInteger(
-        KimiRunTouchEnvInteger("KIMIRUN_BKS_SYSTEM_FOCUS_DELAY_MS",
-                               KimiRunTouchPrefInteger(@"BKSSystemFocusDelayMS", 0)),
+        KimiRunPrefsEnvInteger("KIMIRUN_BKS_SYSTEM_FOCUS_DELAY_MS",
+                               KimiRunPrefsInteger(@"BKSSystemFocusDelayMS", 0)),
         0, 500);
     NSString *dispatchReason = KimiRunTouchEnvOrPrefString("KIMIRUN_BKS_DISPATCH_REASON",
                                                            @"BKSDispatchReason",
@@ -554,9 +560,11 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
         // Set BKS sender ID. Prefer captured live sender, fallback to known constants.
         if (_IOHIDEventSetSenderID) {
             _IOHIDEventSetSenderID(event, selectedSenderID);
-            NSLog(@"[KimiRunTouchInjection] Set BKS sender ID: 0x%llX (%@)",
-                  selectedSenderID,
-                  selectedSenderSource ?: @"unknown");
+            if (dispatchDetail) {
+                NSLog(@"[KimiRunTouchInjection] Set BKS sender ID: 0x%llX (%@)",
+                      selectedSenderID,
+                      selectedSenderSource ?: @"unknown");
+            }
         }
 
         // Use discovered iOS 13.2.3 API surface:
@@ -570,44 +578,47 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
         Class routerClass = NSClassFromString(@"BKSHIDEventRouter");
         SEL syncSel = @selector(_syncServiceFlushState);
 
-        NSMutableDictionary *experimentInfo = [NSMutableDictionary dictionary];
-        experimentInfo[@"enabled"] = @(timingExperimentEnabled);
-        experimentInfo[@"focusHintPhase"] = focusHintPhase ?: @"before";
-        experimentInfo[@"focusOverrideMode"] = focusOverrideMode ?: @"per_target";
-        experimentInfo[@"sortCandidates"] = @(sortCandidatesByPreference);
-        experimentInfo[@"flushEachTarget"] = @(flushEachTarget);
-        experimentInfo[@"useSourceDescriptor"] = @(useSourceDescriptor);
-        experimentInfo[@"noSenderDescriptorMatch"] = @(noSenderDescriptorMatch);
-        experimentInfo[@"autoDisabledSenderDescriptorMatch"] = @(autoDisabledSenderDescriptorMatch);
-        experimentInfo[@"proxySenderLikelyLive"] = @([KimiRunTouchInjection proxySenderLikelyLive]);
-        experimentInfo[@"proxySenderCaptured"] = @([KimiRunTouchInjection proxySenderCaptured]);
-        experimentInfo[@"proxySenderDigitizerCount"] = @([KimiRunTouchInjection proxySenderDigitizerCount]);
-        uint64_t proxySenderID = [KimiRunTouchInjection proxySenderID];
-        if (proxySenderID != 0) {
-            experimentInfo[@"proxySenderIDHex"] = [NSString stringWithFormat:@"0x%llX", proxySenderID];
-        }
-        NSString *proxySource = [KimiRunTouchInjection proxySenderSourceString];
-        if (proxySource.length > 0) {
-            experimentInfo[@"proxySenderSource"] = proxySource;
-        }
-        experimentInfo[@"bksEventMode"] = KimiRunBKSEventMode();
-        experimentInfo[@"pinFocusToTarget"] = @(pinFocusToTarget);
-        experimentInfo[@"pinFocusSetAdjustedPID"] = @(pinFocusSetAdjustedPID);
-        experimentInfo[@"dispatchAssertionInvalidate"] = @(invalidateDispatchAssertion);
-        experimentInfo[@"dispatchAssertionHoldMS"] = @(dispatchAssertionHoldMS);
-        experimentInfo[@"dispatchReason"] = dispatchReason ?: @"kimirun-touch";
         BOOL postRouteDispatchEnabled = KimiRunBKSPostRouteDispatchEnabled();
         BOOL postRouteContextDispatchEnabled = KimiRunBKSPostRouteContextDispatchEnabled();
-        experimentInfo[@"postRouteDispatchEnabled"] = @(postRouteDispatchEnabled);
-        experimentInfo[@"postRouteContextDispatchEnabled"] = @(postRouteContextDispatchEnabled);
-        experimentInfo[@"preDispatchDelayMS"] = @(preDispatchDelayMS);
-        experimentInfo[@"perTargetDelayMS"] = @(perTargetDelayMS);
-        experimentInfo[@"postFocusDelayMS"] = @(postFocusDelayMS);
-        experimentInfo[@"pinFocusDelayMS"] = @(pinFocusDelayMS);
-        experimentInfo[@"systemFocusExperimentEnabled"] = @(systemFocusExperimentEnabled);
-        experimentInfo[@"systemFocusPhase"] = systemFocusPhase ?: @"none";
-        experimentInfo[@"systemFocusValue"] = @(systemFocusValue);
-        experimentInfo[@"systemFocusDelayMS"] = @(systemFocusDelayMS);
+        NSMutableDictionary *experimentInfo = nil;
+        if (dispatchDetail) {
+            experimentInfo = [NSMutableDictionary dictionary];
+            experimentInfo[@"enabled"] = @(timingExperimentEnabled);
+            experimentInfo[@"focusHintPhase"] = focusHintPhase ?: @"before";
+            experimentInfo[@"focusOverrideMode"] = focusOverrideMode ?: @"per_target";
+            experimentInfo[@"sortCandidates"] = @(sortCandidatesByPreference);
+            experimentInfo[@"flushEachTarget"] = @(flushEachTarget);
+            experimentInfo[@"useSourceDescriptor"] = @(useSourceDescriptor);
+            experimentInfo[@"noSenderDescriptorMatch"] = @(noSenderDescriptorMatch);
+            experimentInfo[@"autoDisabledSenderDescriptorMatch"] = @(autoDisabledSenderDescriptorMatch);
+            experimentInfo[@"proxySenderLikelyLive"] = @([KimiRunTouchInjection proxySenderLikelyLive]);
+            experimentInfo[@"proxySenderCaptured"] = @([KimiRunTouchInjection proxySenderCaptured]);
+            experimentInfo[@"proxySenderDigitizerCount"] = @([KimiRunTouchInjection proxySenderDigitizerCount]);
+            uint64_t proxySenderID = [KimiRunTouchInjection proxySenderID];
+            if (proxySenderID != 0) {
+                experimentInfo[@"proxySenderIDHex"] = [NSString stringWithFormat:@"0x%llX", proxySenderID];
+            }
+            NSString *proxySource = [KimiRunTouchInjection proxySenderSourceString];
+            if (proxySource.length > 0) {
+                experimentInfo[@"proxySenderSource"] = proxySource;
+            }
+            experimentInfo[@"bksEventMode"] = KimiRunBKSEventMode();
+            experimentInfo[@"pinFocusToTarget"] = @(pinFocusToTarget);
+            experimentInfo[@"pinFocusSetAdjustedPID"] = @(pinFocusSetAdjustedPID);
+            experimentInfo[@"dispatchAssertionInvalidate"] = @(invalidateDispatchAssertion);
+            experimentInfo[@"dispatchAssertionHoldMS"] = @(dispatchAssertionHoldMS);
+            experimentInfo[@"dispatchReason"] = dispatchReason ?: @"kimirun-touch";
+            experimentInfo[@"postRouteDispatchEnabled"] = @(postRouteDispatchEnabled);
+            experimentInfo[@"postRouteContextDispatchEnabled"] = @(postRouteContextDispatchEnabled);
+            experimentInfo[@"preDispatchDelayMS"] = @(preDispatchDelayMS);
+            experimentInfo[@"perTargetDelayMS"] = @(perTargetDelayMS);
+            experimentInfo[@"postFocusDelayMS"] = @(postFocusDelayMS);
+            experimentInfo[@"pinFocusDelayMS"] = @(pinFocusDelayMS);
+            experimentInfo[@"systemFocusExperimentEnabled"] = @(systemFocusExperimentEnabled);
+            experimentInfo[@"systemFocusPhase"] = systemFocusPhase ?: @"none";
+            experimentInfo[@"systemFocusValue"] = @(systemFocusValue);
+            experimentInfo[@"systemFocusDelayMS"] = @(systemFocusDelayMS);
+        }
         NSUInteger focusHintsAppliedBefore = 0;
         NSUInteger focusHintsAppliedPerTarget = 0;
         NSUInteger focusHintsAppliedAfter = 0;
@@ -657,10 +668,12 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
                 }
             }
         }
-        experimentInfo[@"senderDescriptorMatchApplied"] = @(senderDescriptorMatchApplied);
-        if (senderDescriptorMatchValue != 0) {
-            experimentInfo[@"senderDescriptorMatchValueHex"] = [NSString stringWithFormat:@"0x%llX",
-                                                                senderDescriptorMatchValue];
+        if (experimentInfo) {
+            experimentInfo[@"senderDescriptorMatchApplied"] = @(senderDescriptorMatchApplied);
+            if (senderDescriptorMatchValue != 0) {
+                experimentInfo[@"senderDescriptorMatchValueHex"] = [NSString stringWithFormat:@"0x%llX",
+                                                                    senderDescriptorMatchValue];
+            }
         }
 
         // Ensure router manager has event routers configured when available.
@@ -777,15 +790,15 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
                                         @"BKSForceTargetSource",
                                         @""));
         NSInteger forcedTargetPIDRaw = KimiRunClampInteger(
-            KimiRunTouchEnvInteger("KIMIRUN_BKS_FORCE_TARGET_PID",
-                                   KimiRunTouchPrefInteger(@"BKSForceTargetPID", 0)),
+            KimiRunPrefsEnvInteger("KIMIRUN_BKS_FORCE_TARGET_PID",
+                                   KimiRunPrefsInteger(@"BKSForceTargetPID", 0)),
             0, INT_MAX);
         NSString *forcedTargetProcess = KimiRunLowerTrimmed(
             KimiRunTouchEnvOrPrefString("KIMIRUN_BKS_FORCE_TARGET_PROCESS",
                                         @"BKSForceTargetProcess",
                                         @""));
-        BOOL forceTargetOnly = KimiRunTouchEnvBool("KIMIRUN_BKS_FORCE_TARGET_ONLY",
-                                                   KimiRunTouchPrefBool(@"BKSForceTargetOnly", NO));
+        BOOL forceTargetOnly = KimiRunPrefsEnvBool("KIMIRUN_BKS_FORCE_TARGET_ONLY",
+                                                   KimiRunPrefsBool(@"BKSForceTargetOnly", NO));
         int forcedTargetPID = (forcedTargetPIDRaw > 0) ? (int)forcedTargetPIDRaw : -1;
         if (forcedTargetPID <= 0) {
             forcedTargetPID = KimiRunForcedTargetPIDForProcess(forcedTargetProcess,
@@ -910,7 +923,7 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
         NSNumber *chosenDestination = nil;
         NSString *chosenTargetClass = nil;
         int chosenTargetPid = -1;
-        NSMutableArray<NSDictionary *> *routeAttempts = [NSMutableArray array];
+        NSMutableArray<NSDictionary *> *routeAttempts = dispatchDetail ? [NSMutableArray array] : nil;
         NSMutableArray *pendingDispatchAssertions = [NSMutableArray array];
         g_bksLastMeaningfulDispatch = NO;
 
@@ -1006,25 +1019,27 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
                     chosenTargetPid = targetPid;
                 }
 
-                NSMutableDictionary *attempt = [NSMutableDictionary dictionary];
-                attempt[@"source"] = source ?: @"unknown";
-                attempt[@"targetClass"] = targetClassName;
-                attempt[@"pid"] = @(targetPid);
-                attempt[@"accepted"] = @(accepted);
-                attempt[@"meaningful"] = @(meaningfulAcceptance);
-                attempt[@"focusPinApplied"] = @(focusPinApplied);
-                if (destination) {
-                    attempt[@"destination"] = destination;
+                if (dispatchDetail) {
+                    NSMutableDictionary *attempt = [NSMutableDictionary dictionary];
+                    attempt[@"source"] = source ?: @"unknown";
+                    attempt[@"targetClass"] = targetClassName;
+                    attempt[@"pid"] = @(targetPid);
+                    attempt[@"accepted"] = @(accepted);
+                    attempt[@"meaningful"] = @(meaningfulAcceptance);
+                    attempt[@"focusPinApplied"] = @(focusPinApplied);
+                    if (destination) {
+                        attempt[@"destination"] = destination;
+                    }
+                    [routeAttempts addObject:attempt];
+
+                    KimiRunLog([NSString stringWithFormat:@"[BKS] route source=%@ destination=%@ accepted=%@ meaningful=%@ pid=%d target=%@",
+                                source,
+                                destination ? [destination stringValue] : @"(none)",
+                                accepted ? @"yes" : @"no",
+                                meaningfulAcceptance ? @"yes" : @"no",
+                                targetPid,
+                                targetClassName]);
                 }
-                [routeAttempts addObject:attempt];
-
-                KimiRunLog([NSString stringWithFormat:@"[BKS] route source=%@ destination=%@ accepted=%@ meaningful=%@ pid=%d target=%@",
-                            source,
-                            destination ? [destination stringValue] : @"(none)",
-                            accepted ? @"yes" : @"no",
-                            meaningfulAcceptance ? @"yes" : @"no",
-                            targetPid,
-                            targetClassName]);
                 // dispatchDiscreteEvents... may return a BSSimpleAssertion. Invalidation timing
                 // can affect whether the target process consumes dispatched touch phases.
                 if (dispatchResult) {
@@ -1035,16 +1050,18 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
                     }
                 }
             } @catch (NSException *e) {
-                NSMutableDictionary *attempt = [NSMutableDictionary dictionary];
-                attempt[@"source"] = source ?: @"unknown";
-                attempt[@"accepted"] = @NO;
-                attempt[@"meaningful"] = @NO;
-                attempt[@"focusPinApplied"] = @(focusPinApplied);
-                attempt[@"exception"] = e.name ?: @"NSException";
-                if (destination) {
-                    attempt[@"destination"] = destination;
+                if (routeAttempts) {
+                    NSMutableDictionary *attempt = [NSMutableDictionary dictionary];
+                    attempt[@"source"] = source ?: @"unknown";
+                    attempt[@"accepted"] = @NO;
+                    attempt[@"meaningful"] = @NO;
+                    attempt[@"focusPinApplied"] = @(focusPinApplied);
+                    attempt[@"exception"] = e.name ?: @"NSException";
+                    if (destination) {
+                        attempt[@"destination"] = destination;
+                    }
+                    [routeAttempts addObject:attempt];
                 }
-                [routeAttempts addObject:attempt];
                 KimiRunLog([NSString stringWithFormat:@"[BKS] route exception source=%@ destination=%@ name=%@ reason=%@",
                             source,
                             destination ? [destination stringValue] : @"(none)",
@@ -1094,72 +1111,60 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
             [(BKSHIDEventDeliveryManager *)g_bksSharedDeliveryManager _syncServiceFlushState];
         }
 
-        experimentInfo[@"focusHintsAppliedBefore"] = @(focusHintsAppliedBefore);
-        experimentInfo[@"focusHintsAppliedPerTarget"] = @(focusHintsAppliedPerTarget);
-        experimentInfo[@"focusHintsAppliedAfter"] = @(focusHintsAppliedAfter);
-        experimentInfo[@"focusPinsAttempted"] = @(focusPinsAttempted);
-        experimentInfo[@"focusPinsApplied"] = @(focusPinsApplied);
-        experimentInfo[@"systemFocusAppliedBefore"] = @(systemFocusAppliedBefore);
-        experimentInfo[@"systemFocusAppliedPerTarget"] = @(systemFocusAppliedPerTarget);
-        experimentInfo[@"systemFocusAppliedAfter"] = @(systemFocusAppliedAfter);
-        experimentInfo[@"dispatchAssertionCount"] = @(pendingDispatchAssertions.count);
-        experimentInfo[@"focusOverrideAppliedBeforeAll"] = @(focusOverrideAppliedBeforeAll);
-        if (focusOverrideBeforeAllPID > 0) {
-            experimentInfo[@"focusOverrideBeforeAllPID"] = @(focusOverrideBeforeAllPID);
+        if (experimentInfo) {
+            experimentInfo[@"focusHintsAppliedBefore"] = @(focusHintsAppliedBefore);
+            experimentInfo[@"focusHintsAppliedPerTarget"] = @(focusHintsAppliedPerTarget);
+            experimentInfo[@"focusHintsAppliedAfter"] = @(focusHintsAppliedAfter);
+            experimentInfo[@"focusPinsAttempted"] = @(focusPinsAttempted);
+            experimentInfo[@"focusPinsApplied"] = @(focusPinsApplied);
+            experimentInfo[@"systemFocusAppliedBefore"] = @(systemFocusAppliedBefore);
+            experimentInfo[@"systemFocusAppliedPerTarget"] = @(systemFocusAppliedPerTarget);
+            experimentInfo[@"systemFocusAppliedAfter"] = @(systemFocusAppliedAfter);
+            experimentInfo[@"dispatchAssertionCount"] = @(pendingDispatchAssertions.count);
+            experimentInfo[@"focusOverrideAppliedBeforeAll"] = @(focusOverrideAppliedBeforeAll);
+            if (focusOverrideBeforeAllPID > 0) {
+                experimentInfo[@"focusOverrideBeforeAllPID"] = @(focusOverrideBeforeAllPID);
+            }
         }
 
-        NSMutableDictionary *dispatchInfo = [NSMutableDictionary dictionary];
-        dispatchInfo[@"ok"] = @(acceptedFocusedTarget);
-        dispatchInfo[@"acceptedDispatches"] = @(acceptedDispatches);
-        dispatchInfo[@"candidateCount"] = @(targetCandidates.count);
-        dispatchInfo[@"timestamp"] = @([[NSDate date] timeIntervalSince1970]);
-        dispatchInfo[@"attempts"] = routeAttempts;
-        dispatchInfo[@"senderIDHex"] = [NSString stringWithFormat:@"0x%llX", selectedSenderID];
-        dispatchInfo[@"senderIDSource"] = selectedSenderSource ?: @"unknown";
-        dispatchInfo[@"senderIDCaptured"] = @([KimiRunTouchInjection senderIDCaptured]);
-        dispatchInfo[@"senderIDCallbackCount"] = @([KimiRunTouchInjection senderIDCallbackCount]);
-        dispatchInfo[@"senderIDDigitizerCount"] = @([KimiRunTouchInjection senderIDDigitizerCount]);
-        dispatchInfo[@"senderIDLastEventType"] = @([KimiRunTouchInjection senderIDLastEventType]);
-        dispatchInfo[@"senderIDCaptureThreadRunning"] = @([KimiRunTouchInjection senderIDCaptureThreadRunning]);
-        dispatchInfo[@"senderIDMainRegistered"] = @([KimiRunTouchInjection senderIDMainRegistered]);
-        dispatchInfo[@"senderIDDispatchRegistered"] = @([KimiRunTouchInjection senderIDDispatchRegistered]);
-        uintptr_t hidConnectionPtr = [KimiRunTouchInjection hidConnectionPtr];
-        dispatchInfo[@"hidConnectionPtr"] = @((unsigned long long)hidConnectionPtr);
-        dispatchInfo[@"hidConnectionHex"] = [NSString stringWithFormat:@"0x%llX",
-                                             (unsigned long long)hidConnectionPtr];
-        if (chosenSource.length > 0) {
-            dispatchInfo[@"chosenSource"] = chosenSource;
-        }
+        KimiRunBKSDispatchRecord dispatchRecord = {0};
+        dispatchRecord.ok = acceptedFocusedTarget ? 1 : 0;
+        dispatchRecord.acceptedDispatches = (uint32_t)acceptedDispatches;
+        dispatchRecord.candidateCount = (uint32_t)targetCandidates.count;
+        dispatchRecord.timestamp = [[NSDate date] timeIntervalSince1970];
+        dispatchRecord.senderID = selectedSenderID;
+        dispatchRecord.senderIDSource = KimiRunBKSInternString(selectedSenderSource);
+        dispatchRecord.senderIDCaptured = [KimiRunTouchInjection senderIDCaptured] ? 1 : 0;
+        dispatchRecord.senderIDCallbackCount = [KimiRunTouchInjection senderIDCallbackCount];
+        dispatchRecord.senderIDDigitizerCount = [KimiRunTouchInjection senderIDDigitizerCount];
+        dispatchRecord.senderIDLastEventType = [KimiRunTouchInjection senderIDLastEventType];
+        dispatchRecord.senderIDCaptureThreadRunning = [KimiRunTouchInjection senderIDCaptureThreadRunning] ? 1 : 0;
+        dispatchRecord.senderIDMainRegistered = [KimiRunTouchInjection senderIDMainRegistered] ? 1 : 0;
+        dispatchRecord.senderIDDispatchRegistered = [KimiRunTouchInjection senderIDDispatchRegistered] ? 1 : 0;
+        dispatchRecord.hidConnection = [KimiRunTouchInjection hidConnectionPtr];
+        dispatchRecord.source = KimiRunBKSInternString(chosenSource);
         if (chosenDestination) {
-            dispatchInfo[@"chosenDestination"] = chosenDestination;
-        }
-        if (chosenTargetClass.length > 0) {
-            dispatchInfo[@"chosenTargetClass"] = chosenTargetClass;
-        }
-        dispatchInfo[@"chosenPID"] = @(chosenTargetPid);
-        if (frontmostPid > 0) {
-            dispatchInfo[@"frontmostPID"] = @(frontmostPid);
-            dispatchInfo[@"chosenMatchesFrontmost"] = @(chosenTargetPid > 0 && chosenTargetPid == frontmostPid);
-        }
-        if (springboardPid > 0) {
-            dispatchInfo[@"springBoardPID"] = @(springboardPid);
-        }
-        if (backboarddPid > 0) {
-            dispatchInfo[@"backboarddPID"] = @(backboarddPid);
-        }
-        dispatchInfo[@"experiment"] = experimentInfo;
+            dispatchRecord.hasChosenDestination = 1;
+            dispatchRecord.chosenDestination = [chosenDestination unsignedLongLongValue];
+        }
+        dispatchRecord.targetClass = KimiRunBKSInternString(chosenTargetClass);
+        dispatchRecord.chosenPID = chosenTargetPid;
+        dispatchRecord.frontmostPID = frontmostPid;
+        dispatchRecord.springBoardPID = springboardPid;
+        dispatchRecord.backboarddPID = backboarddPid;
         if (!acceptedFocusedTarget) {
-            dispatchInfo[@"reason"] = @"no_focused_or_router_acceptance";
+            dispatchRecord.reason = KimiRunBKSInternString(@"no_focused_or_router_acceptance");
+        }
+        if (dispatchDetail) {
+            KimiRunLog([NSString stringWithFormat:@"[BKS] chosen source=%@ destination=%@ class=%@ pid=%d focusedAccepted=%@ accepted=%lu candidates=%lu",
+                        chosenSource.length > 0 ? chosenSource : @"(none)",
+                        chosenDestination ? [chosenDestination stringValue] : @"(none)",
+                        chosenTargetClass.length > 0 ? chosenTargetClass : @"(none)",
+                        chosenTargetPid,
+                        acceptedFocusedTarget ? @"yes" : @"no",
+                        (unsigned long)acceptedDispatches,
+                        (unsigned long)targetCandidates.count]);
         }
-        KimiRunRecordBKSDispatchInfo(dispatchInfo);
-        KimiRunLog([NSString stringWithFormat:@"[BKS] chosen source=%@ destination=%@ class=%@ pid=%d focusedAccepted=%@ accepted=%lu candidates=%lu",
-                    chosenSource.length > 0 ? chosenSource : @"(none)",
-                    chosenDestination ? [chosenDestination stringValue] : @"(none)",
-                    chosenTargetClass.length > 0 ? chosenTargetClass : @"(none)",
-                    chosenTargetPid,
-                    acceptedFocusedTarget ? @"yes" : @"no",
-                    (unsigned long)acceptedDispatches,
-                    (unsigned long)targetCandidates.count]);
 
         BOOL postRouteDispatchSucceeded = NO;
         NSString *postRouteDispatchPath = nil;
@@ -1173,17 +1178,19 @@ static BOOL KimiRunBKSDispatchEventAfterRouting(IOHIDEventRef event, NSString **
             postRouteDispatchSucceeded = YES;
         }
 
-        dispatchInfo[@"eventDispatchSucceeded"] = @(postRouteDispatchSucceeded);
-        if (postRouteDispatchPath.length > 0) {
-            dispatchInfo[@"eventDispatchPath"] = postRouteDispatchPath;
-        }
+        dispatchRecord.hasEventDispatchResult = 1;
+        dispatchRecord.eventDispatchSucceeded = postRouteDispatchSucceeded ? 1 : 0;
+        dispatchRecord.eventDispatchPath = KimiRunBKSInternString(postRouteDispatchPath);
+        KimiRunRecordBKSDispatch(&dispatchRecord, routeAttempts, experimentInfo);
 
         if (acceptedFocusedTarget && postRouteDispatchSucceeded) {
             g_bksLastMeaningfulDispatch = YES;
             g_bksLastMeaningfulDispatchTime = CFAbsoluteTimeGetCurrent();
-            NSLog(@"[KimiRunTouchInjection] BKS dispatch accepted on focused/router target");
-            KimiRunLog([NSString stringWithFormat:@"[BKS] dispatch accepted on focused/router target (accepted=%lu)",
-                        (unsigned long)acceptedDispatches]);
+            if (dispatchDetail) {
+                NSLog(@"[KimiRunTouchInjection] BKS dispatch accepted on focused/router target");
+                KimiRunLog([NSString stringWithFormat:@"[BKS] dispatch accepted on focused/router target (accepted=%lu)",
+                            (unsigned long)acceptedDispatches]);
+            }
             return YES;
         }
 
@@ -1,8 +1,11 @@
 #import "TouchInjectionInternal.h"
 #import <stdlib.h>
+#import <os/lock.h>
 #import <sys/sysctl.h>
 #import <unistd.h>
 
+extern int proc_pidpath(int pid, void *buffer, uint32_t buffersize);
+
 int KimiRunPIDForProcessName(NSString *processName) {
     if (![processName isKindOfClass:[NSString class]] || processName.length == 0) {
         return -1;
@@ -110,6 +113,48 @@ int KimiRunFrontmostApplicationPID(void) {
     return -1;
 }
 
+// Cached per PID: resolving the bundle reads Info.plist from disk.
+static os_unfair_lock g_frontmostBundleLock = OS_UNFAIR_LOCK_INIT;
+static int g_frontmostBundlePID = -1;
+static NSString *g_frontmostBundleID = nil;
+
+static NSString *KimiRunBundleIdentifierForPID(int pid) {
+    char path[4 * MAXPATHLEN];
+    if (proc_pidpath(pid, path, sizeof(path)) <= 0) {
+        return nil;
+    }
+    NSString *executablePath = [NSString stringWithUTF8String:path];
+    NSRange appRange = [executablePath rangeOfString:@".app/" options:NSBackwardsSearch];
+    if (appRange.location != NSNotFound) {
+        NSString *bundlePath = [executablePath substringToIndex:appRange.location + 4];
+        NSString *bundleID = [[NSBundle bundleWithPath:bundlePath] bundleIdentifier];
+        if (bundleID.length > 0) {
+            return bundleID;
+        }
+    }
+    return executablePath.lastPathComponent;
+}
+
+NSString *KimiRunFrontmostBundleIdentifier(void) {
+    int pid = KimiRunFrontmostApplicationPID();
+    if (pid <= 0) {
+        return @"com.apple.springboard";
+    }
+    os_unfair_lock_lock(&g_frontmostBundleLock);
+    NSString *cached = (pid == g_frontmostBundlePID) ? g_frontmostBundleID : nil;
+    os_unfair_lock_unlock(&g_frontmostBundleLock);
+    if (cached) {
+        return cached;
+    }
+
+    NSString *bundleID = KimiRunBundleIdentifierForPID(pid) ?: [NSString stringWithFormat:@"pid:%d", pid];
+    os_unfair_lock_lock(&g_frontmostBundleLock);
+    g_frontmostBundlePID = pid;
+    g_frontmostBundleID = bundleID;
+    os_unfair_lock_unlock(&g_frontmostBundleLock);
+    return bundleID;
+}
+
 BOOL KimiRunApplyBKSSystemAppFocus(BOOL controlsFocus, NSString *phaseTag) {
     Class focusManagerClass = NSClassFromString(@"BKSEventFocusManager");
     if (!focusManagerClass || ![focusManagerClass respondsToSelector:@selector(sharedInstance)]) {
@@ -224,8 +269,8 @@ BOOL KimiRunApplyBKSEventFocusForPID(int targetPid,
 void KimiRunApplyBKSFocusHints(void) {
     // Focus manager mutations can destabilize daemon context on iOS 13.2.3.
     // Keep disabled unless explicitly enabled for targeted experiments.
-    BOOL focusHintsEnabled = KimiRunTouchEnvBool("KIMIRUN_BKS_FOCUS_HINTS",
-                                                 KimiRunTouchPrefBool(@"BKSFocusHintsEnabled", NO));
+    BOOL focusHintsEnabled = KimiRunPrefsEnvBool("KIMIRUN_BKS_FOCUS_HINTS",
+                                                 KimiRunPrefsBool(@"BKSFocusHintsEnabled", NO));
     if (!focusHintsEnabled) {
         return;
     }
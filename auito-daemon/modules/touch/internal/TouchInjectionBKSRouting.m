@@ -1,4 +1,5 @@
 #import "TouchInjectionInternal.h"
+#import <os/lock.h>
 #import <stdlib.h>
 #import <sys/sysctl.h>
 #import <unistd.h>
@@ -6,55 +7,302 @@
 volatile BOOL g_bksLastMeaningfulDispatch = NO;
 volatile CFAbsoluteTime g_bksLastMeaningfulDispatchTime = 0;
 volatile CFAbsoluteTime g_bksLastFocusHintTime = 0;
-static NSDictionary *g_bksLastDispatchInfo = nil;
-static NSMutableArray<NSDictionary *> *g_bksDispatchHistory = nil;
-static const NSUInteger kKimiRunBKSDispatchHistoryLimit = 64;
-
-static void KimiRunSetLastBKSDispatchInfo(NSDictionary *info) {
-    NSDictionary *safeInfo = [info isKindOfClass:[NSDictionary class]] ? [info copy] : @{};
-    @synchronized([KimiRunTouchInjection class]) {
-        g_bksLastDispatchInfo = safeInfo;
-        if (!g_bksDispatchHistory) {
-            g_bksDispatchHistory = [NSMutableArray array];
+
+#define KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY 64
+#define KIMIRUN_BKS_ATOM_CAPACITY 128
+
+// Fixed ring of plain records, written under g_bksDispatchLock. Dictionaries
+// are only built when a reader asks for them.
+static KimiRunBKSDispatchRecord g_bksDispatchRing[KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY];
+static NSUInteger g_bksDispatchCount = 0;      // total records ever written
+static os_unfair_lock g_bksDispatchLock = OS_UNFAIR_LOCK_INIT;
+
+// Route attempts and experiment flags are already objects; only the latest
+// pair is retained for verbose readers.
+static NSArray<NSDictionary *> *g_bksLastDispatchAttempts = nil;
+static NSDictionary *g_bksLastDispatchExperiment = nil;
+
+// Atom 0 is "unset"; interned strings are never released. Once the table
+// is full, new strings map to the reserved overflow atom and are counted.
+#define KIMIRUN_BKS_ATOM_OVERFLOW (KIMIRUN_BKS_ATOM_CAPACITY - 1)
+static NSString *g_bksAtoms[KIMIRUN_BKS_ATOM_CAPACITY];
+static NSUInteger g_bksAtomCount = 1;
+static NSUInteger g_bksAtomOverflows = 0;
+static os_unfair_lock g_bksAtomLock = OS_UNFAIR_LOCK_INIT;
+
+BOOL KimiRunBKSDispatchDetailEnabled(void) {
+    return KimiRunPrefsEnvBool("KIMIRUN_BKS_DISPATCH_VERBOSE",
+                               KimiRunPrefsBool(@"BKSDispatchVerbose", NO));
+}
+
+KimiRunBKSAtom KimiRunBKSInternString(NSString *value) {
+    if (![value isKindOfClass:[NSString class]] || value.length == 0) {
+        return 0;
+    }
+    KimiRunBKSAtom atom = 0;
+    os_unfair_lock_lock(&g_bksAtomLock);
+    for (NSUInteger i = 1; i < g_bksAtomCount; i++) {
+        if (g_bksAtoms[i] == value || [g_bksAtoms[i] isEqualToString:value]) {
+            atom = (KimiRunBKSAtom)i;
+            break;
         }
-        [g_bksDispatchHistory addObject:safeInfo];
-        if (g_bksDispatchHistory.count > kKimiRunBKSDispatchHistoryLimit) {
-            NSRange trimRange = NSMakeRange(0, g_bksDispatchHistory.count - kKimiRunBKSDispatchHistoryLimit);
-            [g_bksDispatchHistory removeObjectsInRange:trimRange];
+    }
+    BOOL firstOverflow = NO;
+    if (atom == 0) {
+        if (g_bksAtomCount < KIMIRUN_BKS_ATOM_OVERFLOW) {
+            g_bksAtoms[g_bksAtomCount] = [value copy];
+            atom = (KimiRunBKSAtom)g_bksAtomCount;
+            g_bksAtomCount++;
+        } else {
+            atom = KIMIRUN_BKS_ATOM_OVERFLOW;
+            firstOverflow = (g_bksAtomOverflows++ == 0);
         }
     }
+    os_unfair_lock_unlock(&g_bksAtomLock);
+    if (firstOverflow) {
+        KimiRunLog([NSString stringWithFormat:@"[BKS] telemetry atom table full (%d); first dropped string=%@",
+                    KIMIRUN_BKS_ATOM_OVERFLOW - 1, value]);
+    }
+    return atom;
+}
+
+static NSString *KimiRunBKSAtomString(KimiRunBKSAtom atom) {
+    if (atom == 0) {
+        return nil;
+    }
+    if (atom == KIMIRUN_BKS_ATOM_OVERFLOW) {
+        return @"(atom table full)";
+    }
+    NSString *value = nil;
+    os_unfair_lock_lock(&g_bksAtomLock);
+    if (atom < g_bksAtomCount) {
+        value = g_bksAtoms[atom];
+    }
+    os_unfair_lock_unlock(&g_bksAtomLock);
+    return value;
 }
 
-static void KimiRunSetBKSDispatchFailureInfo(NSString *reason) {
+static NSDictionary *KimiRunBKSDispatchRecordDictionary(const KimiRunBKSDispatchRecord *record) {
     NSMutableDictionary *info = [NSMutableDictionary dictionary];
-    info[@"ok"] = @NO;
-    info[@"timestamp"] = @([[NSDate date] timeIntervalSince1970]);
-    if ([reason isKindOfClass:[NSString class]] && reason.length > 0) {
+    info[@"ok"] = @(record->ok != 0);
+    info[@"timestamp"] = @(record->timestamp);
+    NSString *reason = KimiRunBKSAtomString(record->reason);
+    if (record->failure) {
+        info[@"reason"] = reason ?: @"unknown";
+        return info;
+    }
+    info[@"acceptedDispatches"] = @(record->acceptedDispatches);
+    info[@"candidateCount"] = @(record->candidateCount);
+    info[@"senderIDHex"] = [NSString stringWithFormat:@"0x%llX", (unsigned long long)record->senderID];
+    info[@"senderIDSource"] = KimiRunBKSAtomString(record->senderIDSource) ?: @"unknown";
+    info[@"senderIDCaptured"] = @(record->senderIDCaptured != 0);
+    info[@"senderIDCallbackCount"] = @(record->senderIDCallbackCount);
+    info[@"senderIDDigitizerCount"] = @(record->senderIDDigitizerCount);
+    info[@"senderIDLastEventType"] = @(record->senderIDLastEventType);
+    info[@"senderIDCaptureThreadRunning"] = @(record->senderIDCaptureThreadRunning != 0);
+    info[@"senderIDMainRegistered"] = @(record->senderIDMainRegistered != 0);
+    info[@"senderIDDispatchRegistered"] = @(record->senderIDDispatchRegistered != 0);
+    info[@"hidConnectionPtr"] = @((unsigned long long)record->hidConnection);
+    info[@"hidConnectionHex"] = [NSString stringWithFormat:@"0x%llX",
+                                 (unsigned long long)record->hidConnection];
+    NSString *source = KimiRunBKSAtomString(record->source);
+    if (source.length > 0) {
+        info[@"chosenSource"] = source;
+    }
+    if (record->hasChosenDestination) {
+        info[@"chosenDestination"] = @(record->chosenDestination);
+    }
+    NSString *targetClass = KimiRunBKSAtomString(record->targetClass);
+    if (targetClass.length > 0) {
+        info[@"chosenTargetClass"] = targetClass;
+    }
+    info[@"chosenPID"] = @(record->chosenPID);
+    if (record->frontmostPID > 0) {
+        info[@"frontmostPID"] = @(record->frontmostPID);
+        info[@"chosenMatchesFrontmost"] = @(record->chosenPID > 0 && record->chosenPID == record->frontmostPID);
+    }
+    if (record->springBoardPID > 0) {
+        info[@"springBoardPID"] = @(record->springBoardPID);
+    }
+    if (record->backboarddPID > 0) {
+        info[@"backboarddPID"] = @(record->backboarddPID);
+    }
+    if (record->hasEventDispatchResult) {
+        info[@"eventDispatchSucceeded"] = @(record->eventDispatchSucceeded != 0);
+        NSString *path = KimiRunBKSAtomString(record->eventDispatchPath);
+        if (path.length > 0) {
+            info[@"eventDispatchPath"] = path;
+        }
+    }
+    if (reason.length > 0) {
         info[@"reason"] = reason;
-    } else {
-        info[@"reason"] = @"unknown";
     }
-    KimiRunSetLastBKSDispatchInfo(info);
+    return info;
+}
+
+// Compact form used in touch responses.
+static NSDictionary *KimiRunBKSDispatchRecordSummary(const KimiRunBKSDispatchRecord *record) {
+    NSMutableDictionary *compact = [NSMutableDictionary dictionary];
+    if (record->timestamp > 0) {
+        compact[@"timestamp"] = @(record->timestamp);
+    }
+    compact[@"ok"] = @(record->ok != 0);
+    NSString *reason = KimiRunBKSAtomString(record->reason);
+    if (reason.length > 0) {
+        compact[@"reason"] = reason;
+    } else if (record->failure) {
+        compact[@"reason"] = @"unknown";
+    }
+    if (record->failure) {
+        return compact;
+    }
+    NSString *source = KimiRunBKSAtomString(record->source);
+    if (source.length > 0) {
+        compact[@"source"] = source;
+    }
+    if (record->hasChosenDestination) {
+        compact[@"destination"] = @(record->chosenDestination);
+    }
+    NSString *targetClass = KimiRunBKSAtomString(record->targetClass);
+    if (targetClass.length > 0) {
+        compact[@"targetClass"] = targetClass;
+    }
+    compact[@"pid"] = @(record->chosenPID);
+    compact[@"acceptedDispatches"] = @(record->acceptedDispatches);
+    compact[@"candidateCount"] = @(record->candidateCount);
+    return compact;
+}
+
+static void KimiRunAppendBKSDispatchRecord(const KimiRunBKSDispatchRecord *record,
+                                           NSArray<NSDictionary *> *attempts,
+                                           NSDictionary *experiment) {
+    os_unfair_lock_lock(&g_bksDispatchLock);
+    g_bksDispatchRing[g_bksDispatchCount % KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY] = *record;
+    g_bksDispatchCount++;
+    g_bksLastDispatchAttempts = attempts;
+    g_bksLastDispatchExperiment = experiment;
+    os_unfair_lock_unlock(&g_bksDispatchLock);
 }
 
-NSDictionary *KimiRunCopyLastBKSDispatchInfo(void) {
-    @synchronized([KimiRunTouchInjection class]) {
-        return [g_bksLastDispatchInfo copy];
+// Copies up to `capacity` newest records, oldest first. Returns the count.
+static NSUInteger KimiRunCopyBKSDispatchRecords(KimiRunBKSDispatchRecord *out, NSUInteger capacity) {
+    os_unfair_lock_lock(&g_bksDispatchLock);
+    NSUInteger available = MIN(g_bksDispatchCount, (NSUInteger)KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY);
+    NSUInteger count = MIN(available, capacity);
+    NSUInteger first = g_bksDispatchCount - count;
+    for (NSUInteger i = 0; i < count; i++) {
+        out[i] = g_bksDispatchRing[(first + i) % KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY];
     }
+    os_unfair_lock_unlock(&g_bksDispatchLock);
+    return count;
+}
+
+void KimiRunRecordBKSDispatch(const KimiRunBKSDispatchRecord *record,
+                              NSArray<NSDictionary *> *attempts,
+                              NSDictionary *experiment) {
+    if (!record) {
+        return;
+    }
+    KimiRunAppendBKSDispatchRecord(record, attempts, experiment);
+}
+
+void KimiRunRecordBKSDispatchFailure(NSString *reason) {
+    KimiRunBKSDispatchRecord record = {0};
+    record.failure = 1;
+    record.timestamp = [[NSDate date] timeIntervalSince1970];
+    record.reason = KimiRunBKSInternString(reason);
+    KimiRunAppendBKSDispatchRecord(&record, nil, nil);
+}
+
+NSTimeInterval KimiRunLastBKSDispatchTimestamp(void) {
+    NSTimeInterval timestamp = 0;
+    os_unfair_lock_lock(&g_bksDispatchLock);
+    if (g_bksDispatchCount > 0) {
+        timestamp = g_bksDispatchRing[(g_bksDispatchCount - 1) % KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY].timestamp;
+    }
+    os_unfair_lock_unlock(&g_bksDispatchLock);
+    return timestamp;
+}
+
+NSDictionary *KimiRunCopyLastBKSDispatchInfo(BOOL includeRouteDetail) {
+    KimiRunBKSDispatchRecord record;
+    NSArray<NSDictionary *> *attempts = nil;
+    NSDictionary *experiment = nil;
+    os_unfair_lock_lock(&g_bksDispatchLock);
+    BOOL hasRecord = g_bksDispatchCount > 0;
+    if (hasRecord) {
+        record = g_bksDispatchRing[(g_bksDispatchCount - 1) % KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY];
+        attempts = g_bksLastDispatchAttempts;
+        experiment = g_bksLastDispatchExperiment;
+    }
+    os_unfair_lock_unlock(&g_bksDispatchLock);
+    if (!hasRecord) {
+        return nil;
+    }
+    NSDictionary *base = KimiRunBKSDispatchRecordDictionary(&record);
+    if (!includeRouteDetail || record.failure || (!attempts && !experiment)) {
+        return base;
+    }
+    NSMutableDictionary *info = [base mutableCopy];
+    if (attempts) {
+        info[@"attempts"] = attempts;
+    }
+    if (experiment) {
+        info[@"experiment"] = experiment;
+    }
+    return info;
 }
 
 NSArray<NSDictionary *> *KimiRunCopyRecentBKSDispatchHistory(NSUInteger limit) {
-    @synchronized([KimiRunTouchInjection class]) {
-        if (!g_bksDispatchHistory || g_bksDispatchHistory.count == 0) {
-            return @[];
-        }
-        NSUInteger count = g_bksDispatchHistory.count;
-        if (limit == 0 || limit >= count) {
-            return [g_bksDispatchHistory copy];
+    KimiRunBKSDispatchRecord records[KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY];
+    NSUInteger capacity = (limit == 0) ? KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY
+                                       : MIN(limit, (NSUInteger)KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY);
+    NSUInteger count = KimiRunCopyBKSDispatchRecords(records, capacity);
+    NSMutableArray<NSDictionary *> *history = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [history addObject:KimiRunBKSDispatchRecordDictionary(&records[i])];
+    }
+    return history;
+}
+
+NSArray<NSDictionary *> *KimiRunCopyBKSDispatchSummaries(NSTimeInterval after,
+                                                         NSTimeInterval maxAgeSeconds,
+                                                         NSUInteger limit) {
+    KimiRunBKSDispatchRecord records[KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY];
+    NSUInteger capacity = (limit == 0) ? KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY
+                                       : MIN(limit, (NSUInteger)KIMIRUN_BKS_DISPATCH_HISTORY_CAPACITY);
+    NSUInteger count = KimiRunCopyBKSDispatchRecords(records, capacity);
+    if (count == 0) {
+        return @[];
+    }
+    NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+    NSMutableArray<NSDictionary *> *summaries = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSTimeInterval timestamp = records[i].timestamp;
+        if (timestamp > 0) {
+            NSTimeInterval age = now - timestamp;
+            if (age < 0 || (maxAgeSeconds > 0 && age > maxAgeSeconds)) {
+                continue;
+            }
+            if (after > 0 && timestamp <= (after + 0.000001)) {
+                continue;
+            }
         }
-        NSRange tailRange = NSMakeRange(count - limit, limit);
-        return [[g_bksDispatchHistory subarrayWithRange:tailRange] copy];
+        [summaries addObject:KimiRunBKSDispatchRecordSummary(&records[i])];
     }
+    return summaries;
+}
+
+NSDictionary *KimiRunBKSAtomDiagnostics(void) {
+    os_unfair_lock_lock(&g_bksAtomLock);
+    NSUInteger interned = g_bksAtomCount - 1;
+    NSUInteger overflows = g_bksAtomOverflows;
+    os_unfair_lock_unlock(&g_bksAtomLock);
+    return @{
+        @"interned": @(interned),
+        @"capacity": @(KIMIRUN_BKS_ATOM_OVERFLOW - 1),
+        @"overflows": @(overflows),
+    };
 }
 
 void KimiRunResolveBKSManagers(void) {
@@ -99,15 +347,6 @@ void KimiRunResolveBKSManagers(void) {
     }
 }
 
-
-void KimiRunRecordBKSDispatchInfo(NSDictionary *info) {
-    KimiRunSetLastBKSDispatchInfo(info);
-}
-
-void KimiRunRecordBKSDispatchFailure(NSString *reason) {
-    KimiRunSetBKSDispatchFailureInfo(reason);
-}
-
 static void LogSelectorsForClass(Class cls, const char *tag) {
     if (!cls || !tag) {
         return;
@@ -12,18 +12,19 @@
     
     NSLog(@"[KimiRunTouchInjection] Initializing...");
     
-    // Update screen metrics
+    // Update screen metrics; rotation / screen-mode changes invalidate the cache
+    KimiRunScreenMetricsStartObserving();
     if (!UpdateScreenMetrics()) {
         NSLog(@"[KimiRunTouchInjection] Warning: Could not get screen metrics, will retry on first use");
     }
 
     // Configure senderID capture tuning (env overrides prefs)
-    g_senderUseMatching = KimiRunTouchEnvBool("KIMIRUN_SENDER_MATCHING",
-                                              KimiRunTouchPrefBool(@"SenderUseMatching", NO));
-    g_senderUseExtraCallbacks = KimiRunTouchEnvBool("KIMIRUN_SENDER_EXTRACB",
-                                                    KimiRunTouchPrefBool(@"SenderUseExtraCallbacks", YES));
-    g_touchUseMatching = KimiRunTouchEnvBool("KIMIRUN_TOUCH_MATCHING",
-                                             KimiRunTouchPrefBool(@"TouchUseMatching", NO));
+    g_senderUseMatching = KimiRunPrefsEnvBool("KIMIRUN_SENDER_MATCHING",
+                                              KimiRunPrefsBool(@"SenderUseMatching", NO));
+    g_senderUseExtraCallbacks = KimiRunPrefsEnvBool("KIMIRUN_SENDER_EXTRACB",
+                                                    KimiRunPrefsBool(@"SenderUseExtraCallbacks", YES));
+    g_touchUseMatching = KimiRunPrefsEnvBool("KIMIRUN_TOUCH_MATCHING",
+                                             KimiRunPrefsBool(@"TouchUseMatching", NO));
 
     // Load persisted sender ID if available
     KimiRunLoadPersistedSenderID();
@@ -145,7 +146,9 @@
           g_touchUseMatching, g_senderUseMatching, g_senderUseExtraCallbacks);
 
     // Start sender ID capture (SimulateTouch)
-    if (!g_senderCaptured &&
+    KimiRunSenderIDSnapshot senderState;
+    KimiRunSenderIDGetSnapshot(&senderState);
+    if (!senderState.captured &&
         _IOHIDEventSystemClientCreate && _IOHIDEventSystemClientScheduleWithRunLoop &&
         _IOHIDEventSystemClientRegisterEventCallback && _IOHIDEventGetType && _IOHIDEventGetSenderID) {
         if (!g_senderThread) {
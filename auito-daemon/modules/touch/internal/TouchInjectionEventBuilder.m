@@ -1,5 +1,10 @@
 #import "TouchInjectionInternal.h"
+#import "../../accessibility/AccessibilityTree.h"
+#import "../../trace/KimiRunTouchTrace.h"
 #import <dlfcn.h>
+#import <errno.h>
+#import <mach/mach_time.h>
+#import <stdatomic.h>
 
 static BOOL DispatchSimulateTouchEvent(IOHIDEventRef parent);
 static BOOL DispatchSimulateTouchEventViaConnection(IOHIDEventRef parent);
@@ -37,16 +42,8 @@ static BOOL g_ContextBindNonSpringBoardLogged = NO;
 // Extracted from TouchInjection.m: IOHID event building + low-level posting
 // Normalize coordinates to 0.0-1.0 range for IOHIDEvent
 static void NormalizeCoordinates(CGFloat x, CGFloat y, float *normX, float *normY) {
-    if (g_screenWidth <= 0 || g_screenHeight <= 0) {
-        UpdateScreenMetrics();
-    }
-
-    *normX = (float)(x / g_screenWidth);
-    *normY = (float)(y / g_screenHeight);
-
-    // Clamp to valid range
-    *normX = fmaxf(0.0f, fminf(1.0f, *normX));
-    *normY = fmaxf(0.0f, fminf(1.0f, *normY));
+    CGPoint point = CGPointMake(x, y);
+    KimiRunDigitizerPointsFromInterfacePoints(&point, 1, normX, normY);
 }
 
 static uint64_t KimiRunPreferredBKSSenderID(void) {
@@ -105,28 +102,155 @@ static BOOL KimiRunUseXXTouchMaskProfile(void) {
     return [[KimiRunSimEventMaskProfile() lowercaseString] isEqualToString:@"xxtouch"];
 }
 
-static IOHIDDigitizerEventMask KimiRunSimulateTouchParentEventMask(KimiRunTouchPhase phase) {
-    switch (phase) {
-        case KimiRunTouchPhaseDown:
-        case KimiRunTouchPhaseUp:
-            return (kIOHIDDigitizerEventTouch | kIOHIDDigitizerEventIdentity);
-        case KimiRunTouchPhaseMove:
-            return (kIOHIDDigitizerEventPosition | kIOHIDDigitizerEventAttribute);
+static KimiRunTouchMaskProfile KimiRunCurrentMaskProfile(void) {
+    return KimiRunUseXXTouchMaskProfile() ? KimiRunTouchMaskProfileXXTouch : KimiRunTouchMaskProfileLegacyRaw;
+}
+
+#pragma mark - Event trace
+
+// Records every built event to a binary trace (see modules/trace) when
+// TouchTrace / KIMIRUN_TOUCH_TRACE is on. The file is opened on the first
+// traced event and kept for the life of the process; turning the pref off
+// only stops appends. The pref is shared by SpringBoard, the daemon and
+// hooked apps, and opening truncates, so each process writes its own file.
+static const uint64_t kKimiRunTouchTraceMaxBytes = 16 * 1024 * 1024;
+static KimiRunTouchTraceWriter g_touchTraceWriter;
+static BOOL g_touchTraceOpen = NO;
+static NSString *g_touchTracePath = nil;
+static _Atomic uint32_t g_touchTraceMetricsGeneration = 0;
+// Backend whose Post*/Create* path is building events on this thread.
+static __thread KimiRunTouchBackend g_touchTraceBackend = KimiRunTouchBackendNone;
+
+// kimirun_touch.trace -> kimirun_touch.SpringBoard.trace
+static NSString *KimiRunTouchTraceProcessPath(NSString *path) {
+    NSString *process = [NSProcessInfo processInfo].processName;
+    if (process.length == 0) {
+        process = [NSString stringWithFormat:@"pid%d", getpid()];
+    }
+    NSString *extension = path.pathExtension;
+    NSString *stem = [[path stringByDeletingPathExtension] stringByAppendingFormat:@".%@", process];
+    return extension.length > 0 ? [stem stringByAppendingPathExtension:extension] : stem;
+}
+
+static BOOL KimiRunTouchTraceWanted(void) {
+    return KimiRunPrefsEnvBool("KIMIRUN_TOUCH_TRACE", KimiRunPrefsBool(@"TouchTrace", NO));
+}
+
+static KimiRunTouchTraceWriter *KimiRunTouchTraceActiveWriter(void) {
+    if (!KimiRunTouchTraceWanted()) {
+        return NULL;
     }
-    return 0;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *path = KimiRunTouchEnvOrPrefString("KIMIRUN_TOUCH_TRACE_PATH",
+                                                     @"TouchTracePath",
+                                                     @"/var/mobile/Library/Preferences/kimirun_touch.trace");
+        path = KimiRunTouchTraceProcessPath(path);
+        mach_timebase_info_data_t timebase = {0, 0};
+        mach_timebase_info(&timebase);
+        g_touchTracePath = [path copy];
+        g_touchTraceOpen = KimiRunTouchTraceWriterOpen(&g_touchTraceWriter,
+                                                       path.fileSystemRepresentation,
+                                                       timebase.numer,
+                                                       timebase.denom,
+                                                       kKimiRunTouchTraceMaxBytes);
+        if (g_touchTraceOpen) {
+            KimiRunLog([NSString stringWithFormat:@"[Trace] recording touch events to %@", path]);
+        } else {
+            NSLog(@"[KimiRunTouchInjection] Touch trace open failed path=%@ errno=%d", path, errno);
+        }
+    });
+    return g_touchTraceOpen ? &g_touchTraceWriter : NULL;
 }
 
-static IOHIDDigitizerEventMask KimiRunSimulateTouchChildEventMask(KimiRunTouchPhase phase) {
-    switch (phase) {
-        case KimiRunTouchPhaseDown:
-        case KimiRunTouchPhaseUp:
-            return (kIOHIDDigitizerEventTouch |
-                    kIOHIDDigitizerEventRange |
-                    kIOHIDDigitizerEventIdentity);
-        case KimiRunTouchPhaseMove:
-            return (kIOHIDDigitizerEventPosition | kIOHIDDigitizerEventAttribute);
+static void KimiRunTouchTraceMetricsIfChanged(KimiRunTouchTraceWriter *writer) {
+    KimiRunScreenMetrics metrics;
+    if (!KimiRunScreenMetricsSnapshot(&metrics)) {
+        return;
+    }
+    uint32_t previous = atomic_exchange(&g_touchTraceMetricsGeneration, metrics.generation);
+    if (previous == metrics.generation) {
+        return;
+    }
+    KimiRunTouchTraceRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = KimiRunTouchTraceRecordMetrics;
+    record.u.metrics.a = (float)metrics.toDigitizer.a;
+    record.u.metrics.b = (float)metrics.toDigitizer.b;
+    record.u.metrics.c = (float)metrics.toDigitizer.c;
+    record.u.metrics.d = (float)metrics.toDigitizer.d;
+    record.u.metrics.tx = (float)metrics.toDigitizer.tx;
+    record.u.metrics.ty = (float)metrics.toDigitizer.ty;
+    record.u.metrics.width = (float)metrics.width;
+    record.u.metrics.height = (float)metrics.height;
+    KimiRunTouchTraceWriterAppend(writer, &record);
+}
+
+// Sender the event will carry once dispatched on the current backend.
+static uint64_t KimiRunTouchTraceSenderID(KimiRunTouchEventKind kind) {
+    if (g_touchTraceBackend == KimiRunTouchBackendBKS) {
+        return KimiRunPreferredBKSSenderID();
+    }
+    if (kind == KimiRunTouchEventKindLegacyHand) {
+        return kTouchSenderID;
+    }
+    uint64_t sender = KimiRunCurrentSenderID();
+    if (sender == 0 && g_senderFallbackEnabled) {
+        return kTouchSenderID;
+    }
+    return sender;
+}
+
+static void KimiRunTouchTraceEvent(KimiRunTouchEventKind kind,
+                                   KimiRunTouchPhase phase,
+                                   int fingerIndex,
+                                   const KimiRunTouchEventShape *shape,
+                                   uint64_t timestamp,
+                                   CGFloat x,
+                                   CGFloat y,
+                                   float normX,
+                                   float normY) {
+    KimiRunTouchTraceWriter *writer = KimiRunTouchTraceActiveWriter();
+    if (!writer) {
+        return;
     }
-    return 0;
+    KimiRunTouchTraceMetricsIfChanged(writer);
+
+    KimiRunTouchTraceRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = KimiRunTouchTraceRecordEvent;
+    record.kind = (uint8_t)kind;
+    record.phase = (uint8_t)phase;
+    record.fingerIndex = (uint8_t)fingerIndex;
+    record.backend = (uint8_t)(g_touchTraceBackend != KimiRunTouchBackendNone
+                               ? g_touchTraceBackend
+                               : (kind == KimiRunTouchEventKindLegacyHand ? KimiRunTouchBackendLegacy : KimiRunTouchBackendNone));
+    record.profile = (uint8_t)KimiRunCurrentMaskProfile();
+    record.flags = (uint8_t)((shape->inRange ? KimiRunTouchTraceFlagInRange : 0) |
+                             (shape->touching ? KimiRunTouchTraceFlagTouching : 0));
+    record.eventMask = shape->eventMask;
+    record.u.event.eventTimestamp = timestamp;
+    record.u.event.senderID = KimiRunTouchTraceSenderID(kind);
+    record.u.event.inputX = (float)x;
+    record.u.event.inputY = (float)y;
+    record.u.event.normX = normX;
+    record.u.event.normY = normY;
+    KimiRunTouchTraceWriterAppend(writer, &record);
+}
+
+NSDictionary *KimiRunTouchTraceDiagnostics(void) {
+    KimiRunTouchTraceStats stats;
+    KimiRunTouchTraceWriterGetStats(g_touchTraceOpen ? &g_touchTraceWriter : NULL, &stats);
+    return @{
+        @"enabled": @(KimiRunTouchTraceWanted()),
+        @"open": @(g_touchTraceOpen),
+        @"path": g_touchTracePath ?: @"",
+        @"records": @(stats.records),
+        @"gestures": @(stats.gestures),
+        @"bytesWritten": @(stats.bytesWritten),
+        @"dropped": @(stats.dropped),
+        @"writeErrors": @(stats.writeErrors)
+    };
 }
 
 static NSString *KimiRunSimDispatchMode(void) {
@@ -184,18 +308,18 @@ static void KimiRunLoadBackBoardTouchSPIs(void) {
 }
 
 static BOOL KimiRunNonAXContextBindEnabled(void) {
-    return KimiRunTouchEnvBool("KIMIRUN_NONAX_CONTEXT_BIND",
-                               KimiRunTouchPrefBool(@"NonAXContextBind", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_NONAX_CONTEXT_BIND",
+                               KimiRunPrefsBool(@"NonAXContextBind", NO));
 }
 
 static BOOL KimiRunNonAXSetSimpleDeliveryInfoEnabled(void) {
-    return KimiRunTouchEnvBool("KIMIRUN_NONAX_SET_SIMPLE_DELIVERY_INFO",
-                               KimiRunTouchPrefBool(@"NonAXSetSimpleDeliveryInfo", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_NONAX_SET_SIMPLE_DELIVERY_INFO",
+                               KimiRunPrefsBool(@"NonAXSetSimpleDeliveryInfo", NO));
 }
 
 static BOOL KimiRunNonAXVerboseEventDebugEnabled(void) {
-    return KimiRunTouchEnvBool("KIMIRUN_NONAX_VERBOSE_EVENT_DEBUG",
-                               KimiRunTouchPrefBool(@"NonAXVerboseEventDebug", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_NONAX_VERBOSE_EVENT_DEBUG",
+                               KimiRunPrefsBool(@"NonAXVerboseEventDebug", NO));
 }
 
 static BOOL KimiRunIsSpringBoardProcess(void) {
@@ -463,37 +587,15 @@ static IOHIDEventRef CreateTouchEvent(uint64_t timestamp, KimiRunTouchPhase phas
     NSLog(@"[KimiRunTouchInjection] Normalized: (%.3f, %.3f)", normX, normY);
     
     // Determine phase-specific properties
-    uint32_t eventMask = 0;
-    BOOL inRange = YES;
-    BOOL touch = YES;
-    float pressure = 1.0f;
-    uint32_t touchCount = 1;
-    
-    switch (phase) {
-        case KimiRunTouchPhaseDown:
-            eventMask = (kIOHIDDigitizerEventRange | kIOHIDDigitizerEventTouch | kIOHIDDigitizerEventPosition);
-            inRange = YES;
-            touch = YES;
-            pressure = 1.0f;
-            touchCount = 1;
-            break;
-        case KimiRunTouchPhaseMove:
-            eventMask = (kIOHIDDigitizerEventPosition | kIOHIDDigitizerEventTouch);
-            inRange = YES;
-            touch = YES;
-            pressure = 1.0f;
-            touchCount = 1;
-            break;
-        case KimiRunTouchPhaseUp:
-            eventMask = (kIOHIDDigitizerEventRange | kIOHIDDigitizerEventTouch | kIOHIDDigitizerEventPosition);
-            inRange = NO;
-            touch = NO;
-            pressure = 0.0f;
-            touchCount = 0;
-            break;
-    }
-    // iOS 13.2.3 requires identity flag in digitizer event mask
-    eventMask |= kIOHIDDigitizerEventIdentity;
+    KimiRunTouchEventShape shape;
+    KimiRunTouchEventShapeFor(KimiRunTouchEventKindLegacyHand, (int)phase,
+                              KimiRunCurrentMaskProfile(), &shape);
+    uint32_t eventMask = shape.eventMask;
+    BOOL inRange = shape.inRange;
+    BOOL touch = shape.touching;
+    float pressure = shape.pressure;
+    uint32_t touchCount = shape.touchCount;
+    KimiRunTouchTraceEvent(KimiRunTouchEventKindLegacyHand, phase, 1, &shape, timestamp, x, y, normX, normY);
     
     NSLog(@"[KimiRunTouchInjection] Creating HAND event: mask=0x%02X, range=%d, touch=%d, pressure=%.1f", eventMask, inRange, touch, pressure);
     
@@ -575,11 +677,12 @@ static IOHIDEventRef CreateSimulateTouchParentEvent(uint64_t timestamp, KimiRunT
         return NULL;
     }
 
-    BOOL useXXTouchMaskProfile = KimiRunUseXXTouchMaskProfile();
-    IOHIDDigitizerEventMask eventMask = useXXTouchMaskProfile
-        ? KimiRunSimulateTouchParentEventMask(phase)
-        : 0;
-    BOOL isTouching = useXXTouchMaskProfile ? (phase != KimiRunTouchPhaseUp) : NO;
+    KimiRunTouchEventShape shape;
+    KimiRunTouchEventShapeFor(KimiRunTouchEventKindSimParent, (int)phase,
+                              KimiRunCurrentMaskProfile(), &shape);
+    IOHIDDigitizerEventMask eventMask = shape.eventMask;
+    BOOL isTouching = shape.touching;
+    KimiRunTouchTraceEvent(KimiRunTouchEventKindSimParent, phase, 0, &shape, timestamp, 0.0, 0.0, 0.0f, 0.0f);
 
     IOHIDEventRef parent = _IOHIDEventCreateDigitizerEvent(
         kCFAllocatorDefault,
@@ -615,61 +718,29 @@ static IOHIDEventRef CreateSimulateTouchChildEvent(KimiRunTouchPhase phase, int
     if (!_IOHIDEventCreateDigitizerFingerEvent) {
         return NULL;
     }
-    if (g_screenWidth <= 0 || g_screenHeight <= 0) {
-        if (!UpdateScreenMetrics()) {
-            return NULL;
-        }
+    if (!KimiRunScreenMetricsSnapshot(NULL)) {
+        return NULL;
     }
+    float normX, normY;
+    NormalizeCoordinates(x, y, &normX, &normY);
 
-    BOOL useXXTouchMaskProfile = KimiRunUseXXTouchMaskProfile();
-    uint32_t eventMask = 0;
-    BOOL inRange = YES;
-    BOOL touch = YES;
-    if (useXXTouchMaskProfile) {
-        eventMask = (uint32_t)KimiRunSimulateTouchChildEventMask(phase);
-        switch (phase) {
-            case KimiRunTouchPhaseDown:
-                inRange = YES;
-                touch = YES;
-                break;
-            case KimiRunTouchPhaseMove:
-                inRange = YES;
-                touch = YES;
-                break;
-            case KimiRunTouchPhaseUp:
-                inRange = NO;
-                touch = NO;
-                break;
-        }
-    } else {
-        // Legacy SimulateTouch mask profile (3/4/2).
-        switch (phase) {
-            case KimiRunTouchPhaseDown:
-                eventMask = 3;
-                inRange = YES;
-                touch = YES;
-                break;
-            case KimiRunTouchPhaseMove:
-                eventMask = 4;
-                inRange = YES;
-                touch = YES;
-                break;
-            case KimiRunTouchPhaseUp:
-                eventMask = 2;
-                inRange = NO;
-                touch = NO;
-                break;
-        }
-    }
+    KimiRunTouchEventShape shape;
+    KimiRunTouchEventShapeFor(KimiRunTouchEventKindSimChild, (int)phase,
+                              KimiRunCurrentMaskProfile(), &shape);
+    uint32_t eventMask = shape.eventMask;
+    BOOL inRange = shape.inRange;
+    BOOL touch = shape.touching;
+    uint64_t timestamp = GetCurrentTimestamp();
+    KimiRunTouchTraceEvent(KimiRunTouchEventKindSimChild, phase, index, &shape, timestamp, x, y, normX, normY);
 
     IOHIDEventRef child = _IOHIDEventCreateDigitizerFingerEvent(
         kCFAllocatorDefault,
-        GetCurrentTimestamp(),
+        timestamp,
         index,
         3, // identity
         eventMask,
-        x / g_screenWidth,
-        y / g_screenHeight,
+        normX,
+        normY,
         0.0f,
         0.0f,
         0.0f,
@@ -686,7 +757,17 @@ static IOHIDEventRef CreateSimulateTouchChildEvent(KimiRunTouchPhase phase, int
     return child;
 }
 
+static IOHIDEventRef CreateBKSTouchEventInternal(uint64_t timestamp, KimiRunTouchPhase phase, CGFloat x, CGFloat y);
+
 static IOHIDEventRef CreateBKSTouchEvent(uint64_t timestamp, KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
+    KimiRunTouchBackend previousBackend = g_touchTraceBackend;
+    g_touchTraceBackend = KimiRunTouchBackendBKS;
+    IOHIDEventRef event = CreateBKSTouchEventInternal(timestamp, phase, x, y);
+    g_touchTraceBackend = previousBackend;
+    return event;
+}
+
+static IOHIDEventRef CreateBKSTouchEventInternal(uint64_t timestamp, KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
     NSString *eventMode = KimiRunBKSEventMode();
     if ([eventMode isEqualToString:@"legacy_hand"]) {
         // Experiment: feed BKS using legacy hand+finger payload to match older consuming paths.
@@ -779,8 +860,10 @@ static void SimulateTouchAppendTrackedEvents(IOHIDEventRef parent) {
 
 static BOOL PostSimulateTouchEventInternal(KimiRunTouchPhase phase, int fingerIndex, CGFloat x, CGFloat y, BOOL viaConnection) {
     uint64_t timestamp = GetCurrentTimestamp();
+    g_touchTraceBackend = viaConnection ? KimiRunTouchBackendConn : KimiRunTouchBackendSim;
     IOHIDEventRef parent = CreateSimulateTouchParentEvent(timestamp, phase);
     if (!parent) {
+        g_touchTraceBackend = KimiRunTouchBackendNone;
         return NO;
     }
 
@@ -792,6 +875,7 @@ static BOOL PostSimulateTouchEventInternal(KimiRunTouchPhase phase, int fingerIn
 
     SimulateTouchTrackEvent(phase, fingerIndex, x, y);
     SimulateTouchAppendTrackedEvents(parent);
+    g_touchTraceBackend = KimiRunTouchBackendNone;
     SimulateTouchSetParentFlags(parent);
     BOOL ok = viaConnection ? DispatchSimulateTouchEventViaConnection(parent) : DispatchSimulateTouchEvent(parent);
     CFRelease(parent);
@@ -808,7 +892,7 @@ static BOOL DispatchSimulateTouchEvent(IOHIDEventRef parent) {
     if (!_IOHIDEventSetSenderID) {
         return NO;
     }
-    uint64_t sender = g_senderID;
+    uint64_t sender = KimiRunCurrentSenderID();
     if (sender == 0 && g_senderFallbackEnabled) {
         sender = kTouchSenderID;
         NSLog(@"[KimiRunTouchInjection] Using fallback senderID: 0x%llX", sender);
@@ -877,7 +961,7 @@ static BOOL DispatchSimulateTouchEventViaConnection(IOHIDEventRef parent) {
     if (!_IOHIDEventSetSenderID) {
         return NO;
     }
-    uint64_t sender = g_senderID;
+    uint64_t sender = KimiRunCurrentSenderID();
     if (sender == 0 && g_senderFallbackEnabled) {
         sender = kTouchSenderID;
         NSLog(@"[KimiRunTouchInjection] Using fallback senderID (conn): 0x%llX", sender);
@@ -960,24 +1044,53 @@ IOHIDEventRef KimiRunCreateBKSTouchEvent(uint64_t timestamp, KimiRunTouchPhase p
     return CreateBKSTouchEvent(timestamp, phase, x, y);
 }
 
+// Composed gestures, taps and streamed fingers all reach the backends through
+// the wrappers below, so a delivered up phase is the pipeline's "action
+// performed" point.
+static BOOL KimiRunNoteDeliveredPhase(KimiRunTouchPhase phase, BOOL delivered) {
+    if (delivered && phase == KimiRunTouchPhaseUp) {
+        KimiRunA11yNoteActionPerformed();
+    }
+    return delivered;
+}
+
 BOOL KimiRunPostTouchEvent(KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
-    return PostTouchEvent(phase, x, y);
+    return KimiRunNoteDeliveredPhase(phase, PostTouchEvent(phase, x, y));
 }
 
 BOOL KimiRunPostSimulateTouchEvent(KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
-    return PostSimulateTouchEvent(phase, x, y);
+    return KimiRunNoteDeliveredPhase(phase, PostSimulateTouchEvent(phase, x, y));
 }
 
 BOOL KimiRunPostSimulateTouchEventViaConnection(KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
-    return PostSimulateTouchEventViaConnection(phase, x, y);
+    return KimiRunNoteDeliveredPhase(phase, PostSimulateTouchEventViaConnection(phase, x, y));
+}
+
+BOOL KimiRunPostSimulateTouchFingerPhase(KimiRunTouchPhase phase, int fingerIndex, CGFloat x, CGFloat y, BOOL viaConnection) {
+    if (!SimulateTouchValidFingerIndex(fingerIndex)) {
+        return NO;
+    }
+    return KimiRunNoteDeliveredPhase(phase, PostSimulateTouchEventInternal(phase, fingerIndex, x, y, viaConnection));
+}
+
+BOOL KimiRunSimTouchFingerActive(int fingerIndex, CGPoint *lastPoint) {
+    if (!SimulateTouchValidFingerIndex(fingerIndex) ||
+        g_simEventsToAppend[fingerIndex][kSimTouchValidIndex] == KimiRunSimTouchInvalid) {
+        return NO;
+    }
+    if (lastPoint) {
+        *lastPoint = CGPointMake((CGFloat)g_simEventsToAppend[fingerIndex][kSimTouchXIndex],
+                                 (CGFloat)g_simEventsToAppend[fingerIndex][kSimTouchYIndex]);
+    }
+    return YES;
 }
 
 BOOL KimiRunPostLegacyTouchEventPhase(KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
-    return PostLegacyTouchEventPhase(phase, x, y);
+    return KimiRunNoteDeliveredPhase(phase, PostLegacyTouchEventPhase(phase, x, y));
 }
 
 BOOL KimiRunPostBKSTouchEventPhase(KimiRunTouchPhase phase, CGFloat x, CGFloat y) {
-    return PostBKSTouchEventPhase(phase, x, y);
+    return KimiRunNoteDeliveredPhase(phase, PostBKSTouchEventPhase(phase, x, y));
 }
 
 BOOL KimiRunDispatchEventWithContextBind(IOHIDEventRef event, NSString **pathOut) {
@@ -2,18 +2,17 @@
 #import <unistd.h>
 #import <sys/socket.h>
 #import <netinet/in.h>
+#import <netinet/tcp.h>
 #import <arpa/inet.h>
 #import <fcntl.h>
 #import <errno.h>
 #import <stdlib.h>
 #import <math.h>
+#import <pthread.h>
+#import <mach/mach_time.h>
 
 #define KimiRunResolveMethod KimiRunResolveTouchMethod
 #define KimiRunRejectUnverifiedExplicitResult KimiRunRejectUnverifiedTouchResult
-#define DispatchPhaseWithOptions KimiRunDispatchPhase
-#define KimiRunPrefString KimiRunTouchPrefString
-#define KimiRunPrefBool KimiRunTouchPrefBool
-#define KimiRunEnvBool KimiRunTouchEnvBool
 
 #define CreateTouchEvent KimiRunCreateTouchEvent
 #define CreateBKSTouchEvent KimiRunCreateBKSTouchEvent
@@ -31,46 +30,12 @@ static CGPoint KimiRunNormalizePoint(CGPoint point) {
     return CGPointMake(x, y);
 }
 
-static double KimiRunTouchEnvDouble(const char *key, double defaultValue) {
-    if (!key) {
-        return defaultValue;
-    }
-    const char *value = getenv(key);
-    if (!value || value[0] == '\0') {
-        return defaultValue;
-    }
-    char *endPtr = NULL;
-    double parsed = strtod(value, &endPtr);
-    if (endPtr == value || !isfinite(parsed)) {
-        return defaultValue;
-    }
-    return parsed;
-}
-
-static double KimiRunTouchPrefDouble(NSString *key, double defaultValue) {
-    if (![key isKindOfClass:[NSString class]] || key.length == 0) {
-        return defaultValue;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id raw = [prefs objectForKey:key];
-    if (!raw) {
-        return defaultValue;
-    }
-    if ([raw respondsToSelector:@selector(doubleValue)]) {
-        double value = [raw doubleValue];
-        if (isfinite(value)) {
-            return value;
-        }
-    }
-    return defaultValue;
-}
-
 static double KimiRunGestureDeltaPixels(void) {
-    double env = KimiRunTouchEnvDouble("KIMIRUN_GESTURE_DELTA_PX", NAN);
+    double env = KimiRunPrefsEnvDouble("KIMIRUN_GESTURE_DELTA_PX", NAN);
     if (isfinite(env) && env > 0.0) {
         return env;
     }
-    double pref = KimiRunTouchPrefDouble(@"GestureDeltaPx", 0.0);
+    double pref = KimiRunPrefsDouble(@"GestureDeltaPx", 0.0);
     return (isfinite(pref) && pref > 0.0) ? pref : 0.0;
 }
 
@@ -88,37 +53,14 @@ static BOOL KimiRunGestureUseSimpleCurve(void) {
             [lower isEqualToString:@"xxtouch_curve"]);
 }
 
-static double KimiRunGestureCurveInterpolation(double a, double b, double t) {
-    double warped = sin(1.5707963267948966 * t);
-    double easedT = sin(warped * t * 1.5707963267948966);
-    return a + ((b - a) * easedT);
-}
-
 static NSInteger KimiRunGestureStepCount(CGPoint start, CGPoint end, NSInteger fallbackSteps) {
-    NSInteger safeFallback = (fallbackSteps > 0) ? fallbackSteps : 1;
-    double deltaPx = KimiRunGestureDeltaPixels();
-    if (!(deltaPx > 0.0)) {
-        return safeFallback;
-    }
-
-    double dx = (double)end.x - (double)start.x;
-    double dy = (double)end.y - (double)start.y;
-    double distance = sqrt((dx * dx) + (dy * dy));
-    if (!(distance > 0.0)) {
-        return 1;
-    }
-
-    NSInteger steps = (NSInteger)ceil(distance / deltaPx);
-    return (steps > 0) ? steps : 1;
+    return (NSInteger)KimiRunTouchPlanStepCount(start.x, start.y, end.x, end.y,
+                                                (long)fallbackSteps,
+                                                KimiRunGestureDeltaPixels());
 }
 
 static useconds_t KimiRunGestureStepDelayMicros(NSTimeInterval duration, NSInteger steps) {
-    NSInteger safeSteps = (steps > 0) ? steps : 1;
-    double micros = (duration * 1000000.0) / (double)safeSteps;
-    if (!isfinite(micros) || micros < 1000.0) {
-        micros = 1000.0;
-    }
-    return (useconds_t)llround(micros);
+    return (useconds_t)KimiRunTouchPlanStepDelayMicros(duration, (long)steps);
 }
 
 static CGPoint KimiRunGesturePointAtStep(CGPoint start,
@@ -126,53 +68,82 @@ static CGPoint KimiRunGesturePointAtStep(CGPoint start,
                                          NSInteger step,
                                          NSInteger totalSteps,
                                          BOOL useSimpleCurve) {
-    if (totalSteps <= 0) {
-        return end;
-    }
-    NSInteger clampedStep = step;
-    if (clampedStep < 0) {
-        clampedStep = 0;
-    } else if (clampedStep > totalSteps) {
-        clampedStep = totalSteps;
-    }
-    double t = (double)clampedStep / (double)totalSteps;
-    if (useSimpleCurve) {
-        return CGPointMake((CGFloat)KimiRunGestureCurveInterpolation(start.x, end.x, t),
-                           (CGFloat)KimiRunGestureCurveInterpolation(start.y, end.y, t));
-    }
-    return CGPointMake((CGFloat)(start.x + ((end.x - start.x) * t)),
-                       (CGFloat)(start.y + ((end.y - start.y) * t)));
+    double x = 0.0;
+    double y = 0.0;
+    KimiRunTouchPlanPointAtStep(start.x, start.y, end.x, end.y,
+                                (long)step, (long)totalSteps,
+                                useSimpleCurve, &x, &y);
+    return CGPointMake((CGFloat)x, (CGFloat)y);
 }
 
 static BOOL KimiRunZXTouchEnabled(void) {
     // ZXTouch can destabilize SpringBoard on some iOS 13 setups.
     // Keep it opt-in until explicitly enabled by operator.
-    return KimiRunEnvBool("KIMIRUN_ENABLE_ZXTOUCH",
-                          KimiRunPrefBool(@"EnableZXTouch", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_ENABLE_ZXTOUCH",
+                               KimiRunPrefsBool(@"EnableZXTouch", NO));
 }
 
 static NSString *KimiRunZXTouchHost(void) {
-    const char *env = getenv("KIMIRUN_ZXTOUCH_HOST");
+    const char *env = KimiRunPrefsEnv("KIMIRUN_ZXTOUCH_HOST");
     if (env && env[0] != '\0') {
         return [NSString stringWithUTF8String:env];
     }
-    NSString *host = KimiRunPrefString(@"ZXTouchHost");
+    NSString *host = KimiRunPrefsString(@"ZXTouchHost");
     return (host.length > 0) ? host : @"127.0.0.1";
 }
 
 static int KimiRunZXTouchPort(void) {
-    const char *env = getenv("KIMIRUN_ZXTOUCH_PORT");
+    const char *env = KimiRunPrefsEnv("KIMIRUN_ZXTOUCH_PORT");
     if (env && env[0] != '\0') {
         return atoi(env);
     }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    NSInteger port = [prefs integerForKey:@"ZXTouchPort"];
+    NSInteger port = KimiRunPrefsInteger(@"ZXTouchPort", 0);
     return (port > 0) ? (int)port : 6000;
 }
 
-static int KimiRunZXTouchConnect(void) {
-    NSString *host = KimiRunZXTouchHost();
-    int port = KimiRunZXTouchPort();
+
+// ZXTouch client. One connection is kept open and reused by every ZX
+// gesture; it is dropped on a send error or when the server has closed it,
+// and the failing batch is resent once on a fresh connection. A gesture is
+// formatted up front into one buffer and written in timed batches: lines
+// that share a due time (or have fallen behind it) go out in one send().
+// The connection lock is held for the whole gesture so two gestures never
+// interleave their lines on the shared socket.
+
+// "10" + "1" + type + finger(2) + x(5) + y(5) + "\r\n" plus the terminator.
+#define KIMIRUN_ZXTOUCH_LINE_MAX 24
+
+typedef struct {
+    char *bytes;
+    size_t length;
+    size_t *lineStarts;     // count + 1 entries; lineStarts[count] == length
+    uint64_t *dueMicros;    // offset from the first line
+    size_t count;
+    size_t capacity;        // lines
+} KimiRunZXTouchBatch;
+
+typedef struct {
+    uint64_t connects;
+    uint64_t reconnects;
+    uint64_t sendErrors;
+    uint64_t batches;
+    uint64_t lines;
+} KimiRunZXTouchClientStats;
+
+static pthread_mutex_t g_zxTouchLock = PTHREAD_MUTEX_INITIALIZER;
+static int g_zxTouchFD = -1;
+static char g_zxTouchEndpoint[80];
+static KimiRunZXTouchClientStats g_zxTouchStats;
+
+static uint64_t KimiRunZXTouchTicksForMicros(uint64_t micros) {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (micros * NSEC_PER_USEC * timebase.denom) / timebase.numer;
+}
+
+static int KimiRunZXTouchConnect(const char *host, int port) {
     int fd = socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0) {
         return -1;
@@ -187,7 +158,7 @@ static int KimiRunZXTouchConnect(void) {
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_port = htons((uint16_t)port);
-    if (inet_pton(AF_INET, host.UTF8String, &addr.sin_addr) <= 0) {
+    if (!host || inet_pton(AF_INET, host, &addr.sin_addr) <= 0) {
         close(fd);
         return -1;
     }
@@ -225,70 +196,234 @@ static int KimiRunZXTouchConnect(void) {
     send_to.tv_sec = 0;
     send_to.tv_usec = 500000;
     setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_to, sizeof(send_to));
+    // Lines are tiny and timed; don't let Nagle hold a batch back behind
+    // the previous one's ACK.
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
     return fd;
 }
 
-static BOOL KimiRunZXTouchSendLines(NSArray<NSString *> *lines, useconds_t delayBetween) {
-    if (!KimiRunZXTouchEnabled()) {
-        return NO;
-    }
-    if (!lines || lines.count == 0) {
-        return NO;
-    }
-    int fd = KimiRunZXTouchConnect();
-    if (fd < 0) {
-        return NO;
+// Caller holds g_zxTouchLock.
+static void KimiRunZXTouchDropLocked(void) {
+    if (g_zxTouchFD >= 0) {
+        close(g_zxTouchFD);
+        g_zxTouchFD = -1;
     }
-    ssize_t total = 0;
-    for (NSUInteger i = 0; i < lines.count; i++) {
-        NSString *line = lines[i];
-        if (!line) {
+}
+
+// Drains anything the server sent back and reports whether the peer is
+// still there. A closed idle connection would otherwise swallow the first
+// write of the next gesture.
+static BOOL KimiRunZXTouchConnectionAlive(int fd) {
+    char scratch[64];
+    for (;;) {
+        ssize_t n = recv(fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+        if (n > 0) {
             continue;
         }
-        NSData *data = [line dataUsingEncoding:NSUTF8StringEncoding];
-        ssize_t sent = send(fd, data.bytes, data.length, 0);
-        if (sent != (ssize_t)data.length) {
-            close(fd);
+        if (n == 0) {
             return NO;
         }
-        total += sent;
-        if (delayBetween > 0 && i + 1 < lines.count) {
-            usleep(delayBetween);
+        if (errno == EINTR) {
+            continue;
         }
+        return (errno == EAGAIN || errno == EWOULDBLOCK);
     }
-    close(fd);
-    return (total > 0);
 }
 
-static NSString *KimiRunZXTouchFormatTouchLine(int type, int fingerIndex, CGFloat x, CGFloat y) {
+// Caller holds g_zxTouchLock. Returns the shared fd, (re)connecting when
+// there is none, the endpoint prefs changed, or the peer went away.
+static int KimiRunZXTouchAcquireLocked(void) {
+    NSString *host = KimiRunZXTouchHost();
+    int port = KimiRunZXTouchPort();
+    char endpoint[sizeof(g_zxTouchEndpoint)];
+    snprintf(endpoint, sizeof(endpoint), "%s:%d", host.UTF8String ?: "", port);
+
+    if (g_zxTouchFD >= 0) {
+        if (strcmp(endpoint, g_zxTouchEndpoint) == 0 && KimiRunZXTouchConnectionAlive(g_zxTouchFD)) {
+            return g_zxTouchFD;
+        }
+        KimiRunZXTouchDropLocked();
+    }
+    g_zxTouchFD = KimiRunZXTouchConnect(host.UTF8String, port);
+    if (g_zxTouchFD >= 0) {
+        strlcpy(g_zxTouchEndpoint, endpoint, sizeof(g_zxTouchEndpoint));
+        g_zxTouchStats.connects++;
+    }
+    return g_zxTouchFD;
+}
+
+static BOOL KimiRunZXTouchBatchInit(KimiRunZXTouchBatch *batch, size_t lines) {
+    memset(batch, 0, sizeof(*batch));
+    batch->bytes = malloc(lines * KIMIRUN_ZXTOUCH_LINE_MAX);
+    batch->lineStarts = malloc((lines + 1) * sizeof(size_t));
+    batch->dueMicros = malloc(lines * sizeof(uint64_t));
+    if (!batch->bytes || !batch->lineStarts || !batch->dueMicros) {
+        free(batch->bytes);
+        free(batch->lineStarts);
+        free(batch->dueMicros);
+        memset(batch, 0, sizeof(*batch));
+        return NO;
+    }
+    batch->capacity = lines;
+    batch->lineStarts[0] = 0;
+    return YES;
+}
+
+static void KimiRunZXTouchBatchFree(KimiRunZXTouchBatch *batch) {
+    free(batch->bytes);
+    free(batch->lineStarts);
+    free(batch->dueMicros);
+    memset(batch, 0, sizeof(*batch));
+}
+
+static void KimiRunZXTouchBatchAppend(KimiRunZXTouchBatch *batch,
+                                      int type,
+                                      int fingerIndex,
+                                      CGFloat x,
+                                      CGFloat y,
+                                      uint64_t dueMicros) {
+    if (batch->count >= batch->capacity) {
+        return;
+    }
     int scaledX = (int)llround(x * 10.0);
     int scaledY = (int)llround(y * 10.0);
     if (scaledX < 0) scaledX = 0;
     if (scaledY < 0) scaledY = 0;
     if (scaledX > 99999) scaledX = 99999;
     if (scaledY > 99999) scaledY = 99999;
-    NSString *event = [NSString stringWithFormat:@"1%d%02d%05d%05d", type, fingerIndex, scaledX, scaledY];
-    return [NSString stringWithFormat:@"%d%@\r\n", kZXTouchTaskPerformTouch, event];
+    int written = snprintf(batch->bytes + batch->length, KIMIRUN_ZXTOUCH_LINE_MAX,
+                           "%d1%d%02d%05d%05d\r\n",
+                           kZXTouchTaskPerformTouch, type, fingerIndex, scaledX, scaledY);
+    if (written <= 0 || written >= KIMIRUN_ZXTOUCH_LINE_MAX) {
+        return;
+    }
+    batch->length += (size_t)written;
+    batch->dueMicros[batch->count] = dueMicros;
+    batch->count++;
+    batch->lineStarts[batch->count] = batch->length;
+}
+
+// Writes lines [first, end) with as few send() calls as the socket allows.
+// On failure *sentLines is the number of whole lines that made it out.
+static BOOL KimiRunZXTouchWriteLines(int fd,
+                                     const KimiRunZXTouchBatch *batch,
+                                     size_t first,
+                                     size_t end,
+                                     size_t *sentLines) {
+    size_t offset = batch->lineStarts[first];
+    size_t stop = batch->lineStarts[end];
+    while (offset < stop) {
+        ssize_t sent = send(fd, batch->bytes + offset, stop - offset, 0);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            size_t whole = 0;
+            while (first + whole < end && batch->lineStarts[first + whole + 1] <= offset) {
+                whole++;
+            }
+            *sentLines = whole;
+            return NO;
+        }
+        offset += (size_t)sent;
+    }
+    *sentLines = end - first;
+    return YES;
+}
+
+static BOOL KimiRunZXTouchSendBatch(const KimiRunZXTouchBatch *batch) {
+    if (!KimiRunZXTouchEnabled()) {
+        return NO;
+    }
+    if (!batch || batch->count == 0) {
+        return NO;
+    }
+    pthread_mutex_lock(&g_zxTouchLock);
+    int fd = KimiRunZXTouchAcquireLocked();
+    if (fd < 0) {
+        pthread_mutex_unlock(&g_zxTouchLock);
+        return NO;
+    }
+
+    BOOL ok = YES;
+    BOOL retried = NO;
+    uint64_t start = mach_absolute_time();
+    size_t i = 0;
+    while (i < batch->count) {
+        uint64_t due = start + KimiRunZXTouchTicksForMicros(batch->dueMicros[i]);
+        if (due > mach_absolute_time()) {
+            mach_wait_until(due);
+        }
+        // Everything already due goes out together, so a late wakeup
+        // catches up in one write instead of drifting further behind.
+        uint64_t now = mach_absolute_time();
+        size_t end = i + 1;
+        while (end < batch->count &&
+               start + KimiRunZXTouchTicksForMicros(batch->dueMicros[end]) <= now) {
+            end++;
+        }
+
+        size_t sentLines = 0;
+        BOOL sent = KimiRunZXTouchWriteLines(fd, batch, i, end, &sentLines);
+        g_zxTouchStats.lines += sentLines;
+        if (sent) {
+            g_zxTouchStats.batches++;
+            i = end;
+            continue;
+        }
+
+        g_zxTouchStats.sendErrors++;
+        KimiRunZXTouchDropLocked();
+        if (retried) {
+            ok = NO;
+            break;
+        }
+        retried = YES;
+        g_zxTouchStats.reconnects++;
+        fd = KimiRunZXTouchAcquireLocked();
+        if (fd < 0) {
+            ok = NO;
+            break;
+        }
+        i += sentLines;
+    }
+    pthread_mutex_unlock(&g_zxTouchLock);
+    if (!ok) {
+        NSLog(@"[KimiRunTouchInjection] ZXTouch send failed after reconnect (lines=%lu)",
+              (unsigned long)batch->count);
+    }
+    return ok;
 }
 
 static BOOL KimiRunZXTouchTap(CGPoint point) {
     point = KimiRunNormalizePoint(point);
-    NSArray<NSString *> *lines = @[
-        KimiRunZXTouchFormatTouchLine(kZXTouchTouchDown, 1, point.x, point.y),
-        KimiRunZXTouchFormatTouchLine(kZXTouchTouchUp, 1, point.x, point.y)
-    ];
-    return KimiRunZXTouchSendLines(lines, 50000);
+    KimiRunZXTouchBatch batch;
+    if (!KimiRunZXTouchBatchInit(&batch, 2)) {
+        return NO;
+    }
+    KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchDown, 1, point.x, point.y, 0);
+    KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchUp, 1, point.x, point.y, 50000);
+    BOOL ok = KimiRunZXTouchSendBatch(&batch);
+    KimiRunZXTouchBatchFree(&batch);
+    return ok;
 }
 
 static BOOL KimiRunZXTouchLongPress(CGPoint point, NSTimeInterval duration) {
     point = KimiRunNormalizePoint(point);
-    NSString *down = KimiRunZXTouchFormatTouchLine(kZXTouchTouchDown, 1, point.x, point.y);
-    NSString *up = KimiRunZXTouchFormatTouchLine(kZXTouchTouchUp, 1, point.x, point.y);
-    if (!KimiRunZXTouchSendLines(@[down], 0)) {
+    uint64_t holdMicros = (duration > 0) ? (uint64_t)llround(duration * 1000000.0) : 0;
+    KimiRunZXTouchBatch batch;
+    if (!KimiRunZXTouchBatchInit(&batch, 2)) {
         return NO;
     }
-    usleep((useconds_t)(duration * 1000000));
-    return KimiRunZXTouchSendLines(@[up], 0);
+    KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchDown, 1, point.x, point.y, 0);
+    KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchUp, 1, point.x, point.y, holdMicros);
+    BOOL ok = KimiRunZXTouchSendBatch(&batch);
+    KimiRunZXTouchBatchFree(&batch);
+    return ok;
 }
 
 static BOOL KimiRunZXTouchGesture(CGPoint start, CGPoint end, NSTimeInterval duration, int steps) {
@@ -298,28 +433,57 @@ static BOOL KimiRunZXTouchGesture(CGPoint start, CGPoint end, NSTimeInterval dur
     start = KimiRunNormalizePoint(start);
     end = KimiRunNormalizePoint(end);
     BOOL useSimpleCurve = KimiRunGestureUseSimpleCurve();
-    useconds_t stepDelay = KimiRunGestureStepDelayMicros(duration, steps);
+    uint64_t stepDelay = KimiRunGestureStepDelayMicros(duration, steps);
 
-    NSMutableArray<NSString *> *lines = [NSMutableArray arrayWithCapacity:(NSUInteger)(steps + 2)];
-    [lines addObject:KimiRunZXTouchFormatTouchLine(kZXTouchTouchDown, 1, start.x, start.y)];
+    KimiRunZXTouchBatch batch;
+    if (!KimiRunZXTouchBatchInit(&batch, (size_t)steps + 2)) {
+        return NO;
+    }
+    KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchDown, 1, start.x, start.y, 0);
     for (int i = 1; i <= steps; i++) {
         CGPoint point = KimiRunGesturePointAtStep(start, end, i, steps, useSimpleCurve);
-        [lines addObject:KimiRunZXTouchFormatTouchLine(kZXTouchTouchMove, 1, point.x, point.y)];
+        KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchMove, 1, point.x, point.y, stepDelay * (uint64_t)i);
     }
-    [lines addObject:KimiRunZXTouchFormatTouchLine(kZXTouchTouchUp, 1, end.x, end.y)];
-    return KimiRunZXTouchSendLines(lines, stepDelay);
+    KimiRunZXTouchBatchAppend(&batch, kZXTouchTouchUp, 1, end.x, end.y, stepDelay * (uint64_t)(steps + 1));
+    BOOL ok = KimiRunZXTouchSendBatch(&batch);
+    KimiRunZXTouchBatchFree(&batch);
+    return ok;
 }
 
 static BOOL KimiRunZXTouchAvailable(void) {
     if (!KimiRunZXTouchEnabled()) {
         return NO;
     }
-    int fd = KimiRunZXTouchConnect();
-    if (fd < 0) {
-        return NO;
-    }
-    close(fd);
-    return YES;
+    pthread_mutex_lock(&g_zxTouchLock);
+    int fd = KimiRunZXTouchAcquireLocked();
+    pthread_mutex_unlock(&g_zxTouchLock);
+    return (fd >= 0);
+}
+
+NSDictionary *KimiRunZXTouchClientDiagnostics(void) {
+    pthread_mutex_lock(&g_zxTouchLock);
+    KimiRunZXTouchClientStats stats = g_zxTouchStats;
+    BOOL connected = (g_zxTouchFD >= 0);
+    NSString *endpoint = connected ? [NSString stringWithUTF8String:g_zxTouchEndpoint] : @"";
+    pthread_mutex_unlock(&g_zxTouchLock);
+    return @{
+        @"enabled": @(KimiRunZXTouchEnabled()),
+        @"connected": @(connected),
+        @"endpoint": endpoint ?: @"",
+        @"connects": @(stats.connects),
+        @"reconnects": @(stats.reconnects),
+        @"sendErrors": @(stats.sendErrors),
+        @"batches": @(stats.batches),
+        @"lines": @(stats.lines)
+    };
+}
+
+static BOOL KimiRunTouchStreamViaConnection(void) {
+    NSString *raw = KimiRunTouchEnvOrPrefString("KIMIRUN_TOUCH_STREAM_METHOD",
+                                                @"TouchStreamMethod",
+                                                @"sim");
+    return ([raw isKindOfClass:[NSString class]] &&
+            [[raw lowercaseString] isEqualToString:@"conn"]);
 }
 
 @implementation KimiRunTouchInjection (GestureComposer)
@@ -356,6 +520,9 @@ static BOOL KimiRunZXTouchAvailable(void) {
 
     NSLog(@"[KimiRunTouchInjection] Tap requested at (%.1f, %.1f), method=%@ initialized=%d, onMainThread=%d",
           x, y, lower, g_initialized, [NSThread isMainThread]);
+    // Taps run their own cascade; keep a follow-up UI-delta check from being
+    // credited to the previous phase-based gesture.
+    KimiRunStrategyClearPendingVerification();
     
     // Ensure touch injection runs on main thread
     if (![NSThread isMainThread]) {
@@ -600,11 +767,11 @@ static BOOL KimiRunZXTouchAvailable(void) {
         duration = kDefaultSwipeDuration;
     }
 
-    CGFloat ax1 = x1, ay1 = y1, ax2 = x2, ay2 = y2;
-    AdjustInputCoordinates(&ax1, &ay1);
-    AdjustInputCoordinates(&ax2, &ay2);
-    CGPoint startPoint = CGPointMake(ax1, ay1);
-    CGPoint endPoint = CGPointMake(ax2, ay2);
+    CGPoint plan[2] = {CGPointMake(x1, y1), CGPointMake(x2, y2)};
+    KimiRunConvertInputPoints(plan, 2, KimiRunCoordinateSpaceAuto);
+    CGFloat ax1 = plan[0].x, ay1 = plan[0].y, ax2 = plan[1].x, ay2 = plan[1].y;
+    CGPoint startPoint = plan[0];
+    CGPoint endPoint = plan[1];
     int steps = (int)KimiRunGestureStepCount(startPoint, endPoint, kSwipeSteps);
     useconds_t stepDelay = KimiRunGestureStepDelayMicros(duration, steps);
     BOOL useSimpleCurve = KimiRunGestureUseSimpleCurve();
@@ -666,8 +833,10 @@ static BOOL KimiRunZXTouchAvailable(void) {
         return zxSuccess;
     }
 
-    if (!DispatchPhaseWithOptions(KimiRunTouchPhaseDown, ax1, ay1,
-                                  wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+    KimiRunGestureSession session;
+    KimiRunGestureSessionBegin(&session, KimiRunGestureKindSwipe,
+                               wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback);
+    if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseDown, ax1, ay1)) {
         if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
             BOOL zxSuccess = KimiRunZXTouchGesture(CGPointMake(ax1, ay1),
                                                    CGPointMake(ax2, ay2),
@@ -687,8 +856,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
     for (int i = 1; i <= steps; i++) {
         usleep(stepDelay);
         CGPoint movePoint = KimiRunGesturePointAtStep(startPoint, endPoint, i, steps, useSimpleCurve);
-        if (!DispatchPhaseWithOptions(KimiRunTouchPhaseMove, movePoint.x, movePoint.y,
-                                      wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+        if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseMove, movePoint.x, movePoint.y)) {
             if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
                 BOOL zxSuccess = KimiRunZXTouchGesture(CGPointMake(ax1, ay1),
                                                        CGPointMake(ax2, ay2),
@@ -707,8 +875,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
     }
 
     usleep(stepDelay);
-    if (!DispatchPhaseWithOptions(KimiRunTouchPhaseUp, ax2, ay2,
-                                  wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+    if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseUp, ax2, ay2)) {
         if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
             BOOL zxSuccess = KimiRunZXTouchGesture(CGPointMake(ax1, ay1),
                                                    CGPointMake(ax2, ay2),
@@ -725,6 +892,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
         return NO;
     }
 
+    KimiRunGestureSessionEnd(&session);
     NSLog(@"[KimiRunTouchInjection] Swipe completed");
     if (KimiRunRejectUnverifiedExplicitResult(lower, @"dispatch")) {
         return NO;
@@ -781,11 +949,11 @@ static BOOL KimiRunZXTouchAvailable(void) {
         duration = kDefaultDragDuration;
     }
 
-    CGFloat ax1 = x1, ay1 = y1, ax2 = x2, ay2 = y2;
-    AdjustInputCoordinates(&ax1, &ay1);
-    AdjustInputCoordinates(&ax2, &ay2);
-    CGPoint startPoint = CGPointMake(ax1, ay1);
-    CGPoint endPoint = CGPointMake(ax2, ay2);
+    CGPoint plan[2] = {CGPointMake(x1, y1), CGPointMake(x2, y2)};
+    KimiRunConvertInputPoints(plan, 2, KimiRunCoordinateSpaceAuto);
+    CGFloat ax1 = plan[0].x, ay1 = plan[0].y, ax2 = plan[1].x, ay2 = plan[1].y;
+    CGPoint startPoint = plan[0];
+    CGPoint endPoint = plan[1];
     int steps = (int)KimiRunGestureStepCount(startPoint, endPoint, kDragSteps);
     useconds_t stepDelay = KimiRunGestureStepDelayMicros(duration, steps);
     BOOL useSimpleCurve = KimiRunGestureUseSimpleCurve();
@@ -833,8 +1001,10 @@ static BOOL KimiRunZXTouchAvailable(void) {
         return zxSuccess;
     }
 
-    if (!DispatchPhaseWithOptions(KimiRunTouchPhaseDown, ax1, ay1,
-                                  wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+    KimiRunGestureSession session;
+    KimiRunGestureSessionBegin(&session, KimiRunGestureKindDrag,
+                               wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback);
+    if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseDown, ax1, ay1)) {
         if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
             BOOL zxSuccess = KimiRunZXTouchGesture(CGPointMake(ax1, ay1),
                                                    CGPointMake(ax2, ay2),
@@ -854,8 +1024,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
     for (int i = 1; i <= steps; i++) {
         usleep(stepDelay);
         CGPoint movePoint = KimiRunGesturePointAtStep(startPoint, endPoint, i, steps, useSimpleCurve);
-        if (!DispatchPhaseWithOptions(KimiRunTouchPhaseMove, movePoint.x, movePoint.y,
-                                      wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+        if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseMove, movePoint.x, movePoint.y)) {
             if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
                 BOOL zxSuccess = KimiRunZXTouchGesture(CGPointMake(ax1, ay1),
                                                        CGPointMake(ax2, ay2),
@@ -874,8 +1043,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
     }
 
     usleep(stepDelay);
-    if (!DispatchPhaseWithOptions(KimiRunTouchPhaseUp, ax2, ay2,
-                                  wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+    if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseUp, ax2, ay2)) {
         if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
             BOOL zxSuccess = KimiRunZXTouchGesture(CGPointMake(ax1, ay1),
                                                    CGPointMake(ax2, ay2),
@@ -892,6 +1060,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
         return NO;
     }
 
+    KimiRunGestureSessionEnd(&session);
     NSLog(@"[KimiRunTouchInjection] Drag completed");
     if (KimiRunRejectUnverifiedExplicitResult(lower, @"dispatch")) {
         return NO;
@@ -974,8 +1143,10 @@ static BOOL KimiRunZXTouchAvailable(void) {
         return zxSuccess;
     }
 
-    if (!DispatchPhaseWithOptions(KimiRunTouchPhaseDown, adjX, adjY,
-                                  wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+    KimiRunGestureSession session;
+    KimiRunGestureSessionBegin(&session, KimiRunGestureKindLongPress,
+                               wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback);
+    if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseDown, adjX, adjY)) {
         if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
             BOOL zxSuccess = KimiRunZXTouchLongPress(CGPointMake(adjX, adjY), duration);
             if (zxSuccess) {
@@ -991,8 +1162,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
 
     usleep((useconds_t)(duration * 1000000.0));
 
-    if (!DispatchPhaseWithOptions(KimiRunTouchPhaseUp, adjX, adjY,
-                                  wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback)) {
+    if (!KimiRunGestureSessionDispatch(&session, KimiRunTouchPhaseUp, adjX, adjY)) {
         if ((wantZX || allowFallback) && KimiRunZXTouchAvailable()) {
             BOOL zxSuccess = KimiRunZXTouchLongPress(CGPointMake(adjX, adjY), duration);
             if (zxSuccess) {
@@ -1006,6 +1176,7 @@ static BOOL KimiRunZXTouchAvailable(void) {
         return NO;
     }
 
+    KimiRunGestureSessionEnd(&session);
     NSLog(@"[KimiRunTouchInjection] Long press completed");
     if (KimiRunRejectUnverifiedExplicitResult(lower, @"dispatch")) {
         return NO;
@@ -1039,6 +1210,40 @@ static BOOL KimiRunZXTouchAvailable(void) {
     NSLog(@"[KimiRunTouchInjection] Double tap completed");
     return YES;
 }
+
++ (BOOL)streamTouchPhase:(KimiRunTouchStreamPhase)phase finger:(NSInteger)finger atX:(CGFloat)x Y:(CGFloat)y {
+    if (finger < 0 || finger >= kSimulateTouchMaxFingerIndex ||
+        phase < KimiRunTouchStreamPhaseDown || phase > KimiRunTouchStreamPhaseUp) {
+        return NO;
+    }
+    int index = (int)finger;
+    BOOL active = KimiRunSimTouchFingerActive(index, NULL);
+    KimiRunTouchPhase effective = (KimiRunTouchPhase)phase;
+    if (effective == KimiRunTouchPhaseDown && active) {
+        effective = KimiRunTouchPhaseMove;
+    } else if (effective == KimiRunTouchPhaseMove && !active) {
+        effective = KimiRunTouchPhaseDown;
+    } else if (effective == KimiRunTouchPhaseUp && !active) {
+        return YES;
+    }
+    CGFloat adjX = x;
+    CGFloat adjY = y;
+    AdjustInputCoordinates(&adjX, &adjY);
+    return KimiRunPostSimulateTouchFingerPhase(effective, index, adjX, adjY, KimiRunTouchStreamViaConnection());
+}
+
++ (BOOL)liftStreamedFinger:(NSInteger)finger {
+    if (finger < 0 || finger >= kSimulateTouchMaxFingerIndex) {
+        return NO;
+    }
+    CGPoint last = CGPointZero;
+    if (!KimiRunSimTouchFingerActive((int)finger, &last)) {
+        return NO;
+    }
+    // The tracked point is already in adjusted screen points.
+    return KimiRunPostSimulateTouchFingerPhase(KimiRunTouchPhaseUp, (int)finger, last.x, last.y,
+                                               KimiRunTouchStreamViaConnection());
+}
 #pragma clang diagnostic pop
 
 @end
@@ -1051,7 +1256,5 @@ static BOOL KimiRunZXTouchAvailable(void) {
 #undef CreateBKSTouchEvent
 #undef CreateTouchEvent
 
-#undef DispatchPhaseWithOptions
 #undef KimiRunRejectUnverifiedExplicitResult
 #undef KimiRunResolveMethod
-#undef KimiRunPrefString
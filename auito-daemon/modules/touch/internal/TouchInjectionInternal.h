@@ -6,6 +6,8 @@
 #import "../../../headers/BackBoardServices+Extended.h"
 #import "../TouchInjection.h"
 #import "../AXTouchInjection.h"
+#import "../KimiRunTouchModel.h"
+#import "../../prefs/KimiRunPrefs.h"
 
 // Shared constants
 #define kTouchSenderID 0xDEFACEDBEEFFECE5ULL
@@ -41,6 +43,95 @@ typedef NS_ENUM(NSInteger, KimiRunSimTouchValidity) {
     KimiRunSimTouchValidAtNextAppend = 2
 };
 
+typedef NS_ENUM(NSInteger, KimiRunCoordinateSpace) {
+    KimiRunCoordinateSpaceAuto = 0,        // points, or pixels when only the pixel bounds fit
+    KimiRunCoordinateSpacePoints = 1,
+    KimiRunCoordinateSpacePixels = 2,
+    KimiRunCoordinateSpaceNormalized = 3   // 0..1 of the interface-oriented screen
+};
+
+// Cached UIScreen metrics. toDigitizer maps interface-oriented points to the
+// normalized (portrait) digitizer space and folds in the current rotation.
+typedef struct {
+    CGFloat width;                 // interface points
+    CGFloat height;
+    CGFloat scale;
+    CGFloat pixelWidth;            // interface pixels
+    CGFloat pixelHeight;
+    CGAffineTransform toDigitizer;
+    uint32_t generation;
+    BOOL valid;
+} KimiRunScreenMetrics;
+
+typedef NS_ENUM(NSInteger, KimiRunTouchBackend) {
+    KimiRunTouchBackendNone = 0,
+    KimiRunTouchBackendBKS = 1,
+    KimiRunTouchBackendSim = 2,
+    KimiRunTouchBackendConn = 3,
+    KimiRunTouchBackendLegacy = 4
+};
+
+// Stable ids: they key persisted-in-memory strategy statistics.
+typedef NS_ENUM(NSInteger, KimiRunGestureKind) {
+    KimiRunGestureKindSwipe = 0,
+    KimiRunGestureKindDrag = 1,
+    KimiRunGestureKindLongPress = 2
+};
+
+// One down..up sequence. The backend that accepts the down phase is latched
+// and later phases go straight to it; the full cascade only runs again
+// after the latched backend rejects a phase. With adaptive routing the
+// down-phase cascade is ordered by the measured cost for (bundle, gesture).
+typedef struct {
+    KimiRunGestureKind gesture;
+    BOOL adaptive;
+    char bundle[64];
+    BOOL wantSim;
+    BOOL wantConn;
+    BOOL wantLegacy;
+    BOOL wantBKS;
+    BOOL wantAX;
+    BOOL allowFallback;
+    KimiRunTouchBackend latched;
+    uint32_t phases;
+    uint32_t attempts;             // backend calls across all phases
+    uint32_t relatches;
+} KimiRunGestureSession;
+
+// BKS dispatch telemetry. Strings are interned once into a small atom table
+// so a record is plain data and recording it never allocates.
+typedef uint16_t KimiRunBKSAtom;   // 0 == unset
+
+typedef struct {
+    NSTimeInterval timestamp;      // seconds since 1970
+    uint64_t senderID;
+    uint64_t chosenDestination;
+    uintptr_t hidConnection;
+    int32_t chosenPID;
+    int32_t frontmostPID;
+    int32_t springBoardPID;
+    int32_t backboarddPID;
+    uint32_t acceptedDispatches;
+    uint32_t candidateCount;
+    int32_t senderIDCallbackCount;
+    int32_t senderIDDigitizerCount;
+    int32_t senderIDLastEventType;
+    KimiRunBKSAtom source;
+    KimiRunBKSAtom targetClass;
+    KimiRunBKSAtom senderIDSource;
+    KimiRunBKSAtom reason;
+    KimiRunBKSAtom eventDispatchPath;
+    uint8_t failure;               // only ok/timestamp/reason are meaningful
+    uint8_t ok;
+    uint8_t hasChosenDestination;
+    uint8_t hasEventDispatchResult;
+    uint8_t eventDispatchSucceeded;
+    uint8_t senderIDCaptured;
+    uint8_t senderIDCaptureThreadRunning;
+    uint8_t senderIDMainRegistered;
+    uint8_t senderIDDispatchRegistered;
+} KimiRunBKSDispatchRecord;
+
 enum {
     kSimTouchValidIndex = 0,
     kSimTouchPhaseIndex = 1,
@@ -130,19 +221,13 @@ extern int g_adminClientType;
 extern void *g_hidConnection;
 
 extern IOHIDEventSystemClientRef g_senderClient;
-extern uint64_t g_senderID;
-extern BOOL g_senderCaptured;
-extern int g_senderSource;
 extern BOOL g_senderFallbackEnabled;
-extern int g_senderCallbackCount;
 extern BOOL g_senderThreadRunning;
 extern NSThread *g_senderThread;
 extern CFRunLoopRef g_senderRunLoop;
 extern BOOL g_senderCleanupDone;
 extern IOHIDEventSystemClientRef g_senderClientMain;
 extern BOOL g_senderMainRegistered;
-extern int g_senderCallbackDigitizerCount;
-extern int g_senderLastEventType;
 extern IOHIDEventSystemClientRef g_senderClientDispatch;
 extern BOOL g_senderDispatchRegistered;
 extern BOOL g_touchUseMatching;
@@ -150,7 +235,6 @@ extern BOOL g_senderUseMatching;
 extern BOOL g_senderUseExtraCallbacks;
 extern BOOL g_loggedBKHIDSelectors;
 extern __weak id g_currentFirstResponder;
-extern NSString *const kKimiRunPrefsSuite;
 extern volatile BOOL g_bksLastMeaningfulDispatch;
 extern volatile CFAbsoluteTime g_bksLastMeaningfulDispatchTime;
 extern volatile CFAbsoluteTime g_bksLastFocusHintTime;
@@ -162,22 +246,49 @@ uint64_t GetCurrentTimestamp(void);
 BOOL UpdateScreenMetrics(void);
 void UpdateHIDConnection(void);
 void AdjustInputCoordinates(CGFloat *x, CGFloat *y);
+
+// Screen metrics cache (TouchInjectionScreenMetrics.m)
+BOOL KimiRunScreenMetricsSnapshot(KimiRunScreenMetrics *out);
+void KimiRunScreenMetricsInvalidate(void);
+void KimiRunScreenMetricsStartObserving(void);
+KimiRunCoordinateSpace KimiRunCoordinateSpaceFromString(NSString *value);
+void KimiRunConvertInputPoints(CGPoint *points, size_t count, KimiRunCoordinateSpace space);
+void KimiRunDigitizerPointsFromInterfacePoints(const CGPoint *points, size_t count, float *normX, float *normY);
+KimiRunTouchTransform KimiRunTouchTransformFromAffine(CGAffineTransform t);
+
+// Binary event trace (TouchInjectionEventBuilder.m)
+NSDictionary *KimiRunTouchTraceDiagnostics(void);
+
+// Persistent ZXTouch client (TouchInjectionGestureComposer.m)
+NSDictionary *KimiRunZXTouchClientDiagnostics(void);
 void NotifyUserEvent(void);
 BOOL ForceFocusSearchField(void);
+BOOL KimiRunInsertTextViaFocusedInput(NSString *text, NSString **pathOut);
+BOOL KimiRunPostKeyboardUsage(uint16_t usage, BOOL down);
 void KimiRunResolveBKSManagers(void);
 void KimiRunApplyBKSFocusHints(void);
 BOOL KimiRunApplyBKSEventFocusForPID(int targetPid, NSString *phaseTag, BOOL setAdjustedPID);
 BOOL KimiRunApplyBKSSystemAppFocus(BOOL controlsFocus, NSString *phaseTag);
 BOOL KimiRunBKSRecentMeaningfulDispatch(NSTimeInterval maxAgeSeconds);
-NSDictionary *KimiRunCopyLastBKSDispatchInfo(void);
+NSDictionary *KimiRunCopyLastBKSDispatchInfo(BOOL includeRouteDetail);
 NSArray<NSDictionary *> *KimiRunCopyRecentBKSDispatchHistory(NSUInteger limit);
-void KimiRunRecordBKSDispatchInfo(NSDictionary *info);
+NSArray<NSDictionary *> *KimiRunCopyBKSDispatchSummaries(NSTimeInterval after,
+                                                         NSTimeInterval maxAgeSeconds,
+                                                         NSUInteger limit);
+NSTimeInterval KimiRunLastBKSDispatchTimestamp(void);
+KimiRunBKSAtom KimiRunBKSInternString(NSString *value);
+NSDictionary *KimiRunBKSAtomDiagnostics(void);
+// BKSDispatchVerbose / KIMIRUN_BKS_DISPATCH_VERBOSE: build route attempts,
+// experiment flags and per-dispatch log lines.
+BOOL KimiRunBKSDispatchDetailEnabled(void);
+void KimiRunRecordBKSDispatch(const KimiRunBKSDispatchRecord *record,
+                              NSArray<NSDictionary *> *attempts,
+                              NSDictionary *experiment);
 void KimiRunRecordBKSDispatchFailure(NSString *reason);
 int KimiRunPIDForProcessName(NSString *processName);
 int KimiRunFrontmostApplicationPID(void);
+NSString *KimiRunFrontmostBundleIdentifier(void);
 NSInteger KimiRunClampInteger(NSInteger value, NSInteger minimum, NSInteger maximum);
-NSInteger KimiRunTouchPrefInteger(NSString *key, NSInteger defaultValue);
-NSInteger KimiRunTouchEnvInteger(const char *key, NSInteger defaultValue);
 NSString *KimiRunTouchEnvOrPrefString(const char *envKey,
                                       NSString *prefKey,
                                       NSString *defaultValue);
@@ -185,6 +296,35 @@ NSString *KimiRunNormalizeExperimentMode(NSString *value,
                                          NSArray<NSString *> *allowed,
                                          NSString *fallback);
 
+// Sender-ID state (TouchInjectionSenderIDManager.m). senderID, source and
+// captured are published together and read as one consistent snapshot; the
+// callback counters are relaxed and may run ahead of them.
+typedef NS_ENUM(uint8_t, KimiRunSenderIDSource) {
+    KimiRunSenderIDSourceNone = 0,
+    KimiRunSenderIDSourceIORegistry = 1,
+    KimiRunSenderIDSourceCallback = 2,
+    KimiRunSenderIDSourcePersisted = 3,
+    KimiRunSenderIDSourceOverride = 4
+};
+
+typedef struct {
+    uint64_t senderID;
+    KimiRunSenderIDSource source;
+    BOOL captured;
+    uint32_t generation;           // bumps on every publish
+    int32_t callbackCount;
+    int32_t digitizerCount;
+    int32_t lastEventType;         // -1 before the first callback
+    int32_t ignoredInjected;       // digitizer events carrying kTouchSenderID
+} KimiRunSenderIDSnapshot;
+
+void KimiRunSenderIDGetSnapshot(KimiRunSenderIDSnapshot *out);
+uint64_t KimiRunCurrentSenderID(void);
+/** Publish a new state; returns YES when the sender ID changed. */
+BOOL KimiRunSenderIDPublish(uint64_t senderID, KimiRunSenderIDSource source, BOOL captured);
+NSString *KimiRunSenderIDSourceName(KimiRunSenderIDSource source, uint64_t senderID);
+NSArray<NSDictionary *> *KimiRunSenderIDEarlyEvents(void);
+
 // SenderID manager exported wrappers
 void KimiRunLoadPersistedSenderID(void);
 void KimiRunTryLoadSenderIDFromIORegistry(void);
@@ -195,10 +335,15 @@ void KimiRunCleanupSenderCallbacks(void);
 void KimiRunApplyDigitizerMatching(IOHIDEventSystemClientRef client);
 void KimiRunPersistSenderID(uint64_t senderID);
 
+// Keyboard typing engine
+NSString *KimiRunStartTypingJob(NSString *text, NSDictionary *options);
+NSString *KimiRunStartTypingJobWithCompletion(NSString *text,
+                                              NSDictionary *options,
+                                              void (^completion)(NSDictionary *status));
+NSDictionary *KimiRunRunTypingJob(NSString *text, NSDictionary *options);
+NSDictionary *KimiRunTypingJobStatus(NSString *jobID);
+
 // Strategy router exported wrappers
-NSString *KimiRunTouchPrefString(NSString *key);
-BOOL KimiRunTouchPrefBool(NSString *key, BOOL defaultValue);
-BOOL KimiRunTouchEnvBool(const char *key, BOOL defaultValue);
 NSString *KimiRunResolveTouchMethod(NSString *method);
 BOOL KimiRunRejectUnverifiedTouchResult(NSString *lowerMethod, NSString *backendTag);
 BOOL KimiRunDispatchPhase(KimiRunTouchPhase phase,
@@ -210,6 +355,23 @@ BOOL KimiRunDispatchPhase(KimiRunTouchPhase phase,
                           BOOL wantBKS,
                           BOOL wantAX,
                           BOOL allowFallback);
+void KimiRunGestureSessionBegin(KimiRunGestureSession *session,
+                                KimiRunGestureKind gesture,
+                                BOOL wantSim,
+                                BOOL wantConn,
+                                BOOL wantLegacy,
+                                BOOL wantBKS,
+                                BOOL wantAX,
+                                BOOL allowFallback);
+BOOL KimiRunGestureSessionDispatch(KimiRunGestureSession *session,
+                                   KimiRunTouchPhase phase,
+                                   CGFloat x,
+                                   CGFloat y);
+void KimiRunGestureSessionEnd(KimiRunGestureSession *session);
+NSString *KimiRunTouchBackendName(KimiRunTouchBackend backend);
+void KimiRunStrategyNoteVerification(BOOL verified);
+void KimiRunStrategyClearPendingVerification(void);
+NSArray<NSDictionary *> *KimiRunCopyStrategyStats(NSUInteger limit);
 
 // Event builder exported wrappers
 BOOL KimiRunDispatchEvent(IOHIDEventRef event);
@@ -218,6 +380,10 @@ IOHIDEventRef KimiRunCreateBKSTouchEvent(uint64_t timestamp, KimiRunTouchPhase p
 BOOL KimiRunPostTouchEvent(KimiRunTouchPhase phase, CGFloat x, CGFloat y);
 BOOL KimiRunPostSimulateTouchEvent(KimiRunTouchPhase phase, CGFloat x, CGFloat y);
 BOOL KimiRunPostSimulateTouchEventViaConnection(KimiRunTouchPhase phase, CGFloat x, CGFloat y);
+// Per-finger SimulateTouch phases. The finger stays in the tracked set
+// (g_simEventsToAppend) from down until up, so other fingers' events carry it.
+BOOL KimiRunPostSimulateTouchFingerPhase(KimiRunTouchPhase phase, int fingerIndex, CGFloat x, CGFloat y, BOOL viaConnection);
+BOOL KimiRunSimTouchFingerActive(int fingerIndex, CGPoint *lastPoint);
 BOOL KimiRunPostLegacyTouchEventPhase(KimiRunTouchPhase phase, CGFloat x, CGFloat y);
 BOOL KimiRunPostBKSTouchEventPhase(KimiRunTouchPhase phase, CGFloat x, CGFloat y);
 BOOL KimiRunDispatchEventWithContextBind(IOHIDEventRef event, NSString **pathOut);
@@ -0,0 +1,465 @@
+#import "TouchInjectionInternal.h"
+#import <mach/mach_time.h>
+#import <stdlib.h>
+
+// Keyboard typing engine: text is converted once into a flat HID usage
+// stream (shift transitions coalesced), then played on a dedicated serial
+// queue against absolute deadlines so the main thread never sleeps between
+// keys. The focused-input insertText attempt still runs on main first.
+
+#define kKimiRunUsageLeftShift 0xE1
+#define kKimiRunTypingJobHistoryLimit 16
+
+typedef struct {
+    uint16_t usage;
+    uint8_t down;
+    uint8_t endsCharacter;   // key-up of a typed character
+} KimiRunKeyStreamEvent;
+
+typedef struct {
+    KimiRunKeyStreamEvent *events;
+    NSUInteger count;
+    NSUInteger characters;   // characters that map to a usage
+    NSUInteger skipped;      // characters with no US-layout usage
+} KimiRunKeyStream;
+
+static BOOL KimiRunUsageForCharacter(unichar c, uint16_t *usage, BOOL *needsShift) {
+    if (!usage || !needsShift) {
+        return NO;
+    }
+    *needsShift = NO;
+
+    if (c >= 'A' && c <= 'Z') {
+        *needsShift = YES;
+        c = (unichar)(c - 'A' + 'a');
+    }
+    if (c >= 'a' && c <= 'z') {
+        *usage = (uint16_t)(0x04 + (c - 'a'));
+        return YES;
+    }
+    if (c >= '1' && c <= '9') {
+        *usage = (uint16_t)(0x1E + (c - '1'));
+        return YES;
+    }
+
+    // US layout: unshifted and shifted symbols sharing a key.
+    static const struct {
+        unichar plain;
+        unichar shifted;
+        uint16_t usage;
+    } kSymbolKeys[] = {
+        {'0', ')', 0x27}, {'1', '!', 0x1E}, {'2', '@', 0x1F}, {'3', '#', 0x20},
+        {'4', '$', 0x21}, {'5', '%', 0x22}, {'6', '^', 0x23}, {'7', '&', 0x24},
+        {'8', '*', 0x25}, {'9', '(', 0x26}, {'-', '_', 0x2D}, {'=', '+', 0x2E},
+        {'[', '{', 0x2F}, {']', '}', 0x30}, {'\\', '|', 0x31}, {';', ':', 0x33},
+        {'\'', '"', 0x34}, {'`', '~', 0x35}, {',', '<', 0x36}, {'.', '>', 0x37},
+        {'/', '?', 0x38},
+    };
+    for (size_t i = 0; i < sizeof(kSymbolKeys) / sizeof(kSymbolKeys[0]); i++) {
+        if (c == kSymbolKeys[i].plain) {
+            *usage = kSymbolKeys[i].usage;
+            return YES;
+        }
+        if (c == kSymbolKeys[i].shifted) {
+            *usage = kSymbolKeys[i].usage;
+            *needsShift = YES;
+            return YES;
+        }
+    }
+
+    switch (c) {
+        case ' ':
+            *usage = 0x2C;
+            return YES;
+        case '\n':
+        case '\r':
+            *usage = 0x28; // Enter
+            return YES;
+        case '\t':
+            *usage = 0x2B;
+            return YES;
+        case '\b':
+            *usage = 0x2A; // Backspace
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+static void KimiRunKeyStreamAppend(KimiRunKeyStream *stream, uint16_t usage, BOOL down, BOOL endsCharacter) {
+    KimiRunKeyStreamEvent *event = &stream->events[stream->count++];
+    event->usage = usage;
+    event->down = down ? 1 : 0;
+    event->endsCharacter = endsCharacter ? 1 : 0;
+}
+
+// Builds the full down/up stream. Shift is pressed once per run of shifted
+// characters instead of around every key.
+static BOOL KimiRunBuildKeyStream(NSString *text, KimiRunKeyStream *stream) {
+    memset(stream, 0, sizeof(*stream));
+    NSUInteger length = text.length;
+    if (length == 0) {
+        return NO;
+    }
+    // Worst case: shift down + key down + key up + shift up per character.
+    stream->events = calloc(length * 4, sizeof(KimiRunKeyStreamEvent));
+    if (!stream->events) {
+        return NO;
+    }
+    unichar *chars = malloc(length * sizeof(unichar));
+    if (!chars) {
+        free(stream->events);
+        stream->events = NULL;
+        return NO;
+    }
+    [text getCharacters:chars range:NSMakeRange(0, length)];
+
+    BOOL shiftHeld = NO;
+    for (NSUInteger i = 0; i < length; i++) {
+        uint16_t usage = 0;
+        BOOL needsShift = NO;
+        if (!KimiRunUsageForCharacter(chars[i], &usage, &needsShift)) {
+            stream->skipped++;
+            continue;
+        }
+        if (needsShift != shiftHeld) {
+            KimiRunKeyStreamAppend(stream, kKimiRunUsageLeftShift, needsShift, NO);
+            shiftHeld = needsShift;
+        }
+        KimiRunKeyStreamAppend(stream, usage, YES, NO);
+        KimiRunKeyStreamAppend(stream, usage, NO, YES);
+        stream->characters++;
+    }
+    if (shiftHeld) {
+        KimiRunKeyStreamAppend(stream, kKimiRunUsageLeftShift, NO, NO);
+    }
+    free(chars);
+    return stream->count > 0;
+}
+
+static void KimiRunFreeKeyStream(KimiRunKeyStream *stream) {
+    free(stream->events);
+    stream->events = NULL;
+    stream->count = 0;
+}
+
+#pragma mark - Jobs
+
+@interface KimiRunTypingJob : NSObject
+@property (nonatomic, copy) NSString *jobID;
+@property (nonatomic, copy) NSString *text;
+@property (nonatomic, assign) uint32_t holdMS;
+@property (nonatomic, assign) uint32_t intervalMS;
+@property (nonatomic, copy) NSString *mode;          // auto | insert | hid
+@property (atomic, copy) NSString *insertPath;
+@property (atomic, assign) double insertMS;
+@property (atomic, copy) NSString *state;
+@property (atomic, copy) NSString *path;
+@property (atomic, copy) NSString *error;
+@property (atomic, assign) NSUInteger keyEvents;
+@property (atomic, assign) NSUInteger charactersTotal;
+@property (atomic, assign) NSUInteger charactersTyped;
+@property (atomic, assign) NSUInteger skippedCharacters;
+@property (atomic, assign) BOOL success;
+@property (atomic, assign) CFAbsoluteTime createdAt;
+@property (atomic, assign) CFAbsoluteTime startedAt;
+@property (atomic, assign) CFAbsoluteTime finishedAt;
+@end
+
+@implementation KimiRunTypingJob
+
+- (NSDictionary *)statusDictionary {
+    CFAbsoluteTime started = self.startedAt;
+    CFAbsoluteTime finished = self.finishedAt;
+    CFAbsoluteTime end = finished > 0 ? finished : CFAbsoluteTimeGetCurrent();
+    double elapsed = started > 0 ? MAX(0.0, end - started) : 0.0;
+    NSUInteger typed = self.charactersTyped;
+
+    NSMutableDictionary *status = [NSMutableDictionary dictionary];
+    status[@"jobID"] = self.jobID ?: @"";
+    status[@"state"] = self.state ?: @"queued";
+    status[@"success"] = @(self.success);
+    status[@"characters"] = @(self.charactersTotal);
+    status[@"charactersTyped"] = @(typed);
+    status[@"skippedCharacters"] = @(self.skippedCharacters);
+    status[@"keyEvents"] = @(self.keyEvents);
+    status[@"holdMS"] = @(self.holdMS);
+    status[@"intervalMS"] = @(self.intervalMS);
+    status[@"elapsedMS"] = @(elapsed * 1000.0);
+    status[@"charsPerSecond"] = @(elapsed > 0 ? (double)typed / elapsed : 0.0);
+    status[@"mode"] = self.mode ?: @"auto";
+    if (self.path.length > 0) {
+        status[@"path"] = self.path;
+    }
+    if ([self.path isEqualToString:@"hid"] && ![self.mode isEqualToString:@"hid"]) {
+        status[@"fallback"] = @YES;
+    }
+    if (self.insertPath.length > 0) {
+        status[@"insertPath"] = self.insertPath;
+    }
+    if (self.insertMS > 0) {
+        status[@"insertMS"] = @(self.insertMS);
+    }
+    if (self.error.length > 0) {
+        status[@"error"] = self.error;
+    }
+    return status;
+}
+
+@end
+
+static dispatch_queue_t KimiRunTypingQueue(void) {
+    static dispatch_queue_t queue = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dispatch_queue_attr_t attr = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL,
+                                                                            QOS_CLASS_USER_INTERACTIVE,
+                                                                            0);
+        queue = dispatch_queue_create("com.auito.keyboard.typing", attr);
+    });
+    return queue;
+}
+
+static NSMutableDictionary<NSString *, KimiRunTypingJob *> *g_typingJobs = nil;
+static NSMutableArray<NSString *> *g_typingJobOrder = nil;
+static NSUInteger g_typingJobCounter = 0;
+
+static void KimiRunRegisterTypingJob(KimiRunTypingJob *job) {
+    @synchronized([KimiRunTypingJob class]) {
+        if (!g_typingJobs) {
+            g_typingJobs = [NSMutableDictionary dictionary];
+            g_typingJobOrder = [NSMutableArray array];
+        }
+        g_typingJobCounter++;
+        job.jobID = [NSString stringWithFormat:@"type-%lu-%04x",
+                     (unsigned long)g_typingJobCounter, arc4random_uniform(0x10000)];
+        g_typingJobs[job.jobID] = job;
+        [g_typingJobOrder addObject:job.jobID];
+        while (g_typingJobOrder.count > kKimiRunTypingJobHistoryLimit) {
+            [g_typingJobs removeObjectForKey:g_typingJobOrder.firstObject];
+            [g_typingJobOrder removeObjectAtIndex:0];
+        }
+    }
+}
+
+static uint32_t KimiRunTypingOptionMS(NSDictionary *options,
+                                      NSString *key,
+                                      const char *envKey,
+                                      NSString *prefKey,
+                                      NSInteger defaultValue,
+                                      NSInteger minimum) {
+    NSInteger value = KimiRunPrefsEnvInteger(envKey, KimiRunPrefsInteger(prefKey, defaultValue));
+    id option = [options isKindOfClass:[NSDictionary class]] ? options[key] : nil;
+    if ([option respondsToSelector:@selector(integerValue)]) {
+        value = [option integerValue];
+    }
+    return (uint32_t)KimiRunClampInteger(value, minimum, 1000);
+}
+
+static NSString *KimiRunTypingMode(NSDictionary *options) {
+    if (![options isKindOfClass:[NSDictionary class]]) {
+        return @"auto";
+    }
+    NSString *mode = [options[@"mode"] isKindOfClass:[NSString class]] ? [options[@"mode"] lowercaseString] : nil;
+    if ([mode isEqualToString:@"insert"] || [mode isEqualToString:@"hid"]) {
+        return mode;
+    }
+    id insert = options[@"insert"];
+    if ([insert respondsToSelector:@selector(boolValue)] && ![insert boolValue]) {
+        return @"hid";
+    }
+    return @"auto";
+}
+
+static KimiRunTypingJob *KimiRunMakeTypingJob(NSString *text, NSDictionary *options) {
+    KimiRunTypingJob *job = [[KimiRunTypingJob alloc] init];
+    job.text = text;
+    job.state = @"queued";
+    job.createdAt = CFAbsoluteTimeGetCurrent();
+    job.charactersTotal = text.length;
+    job.mode = KimiRunTypingMode(options);
+    job.holdMS = KimiRunTypingOptionMS(options, @"holdMS",
+                                       "KIMIRUN_KEYBOARD_HOLD_MS", @"KeyboardKeyHoldMS", 8, 1);
+    job.intervalMS = KimiRunTypingOptionMS(options, @"intervalMS",
+                                           "KIMIRUN_KEYBOARD_INTERVAL_MS", @"KeyboardKeyIntervalMS", 8, 0);
+    return job;
+}
+
+static uint64_t KimiRunMachTicksForMS(uint32_t ms) {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return ((uint64_t)ms * NSEC_PER_MSEC * timebase.denom) / timebase.numer;
+}
+
+// Main thread only. Makes sure the HID clients exist for playback, then
+// tries to hand the whole string to the focused input in one call. Returns
+// YES when the job is finished (inserted, or insert-only mode failed).
+static BOOL KimiRunTryFocusedInsert(KimiRunTypingJob *job) {
+    if (!g_initialized) {
+        [KimiRunTouchInjection initialize];
+    }
+    if ([job.mode isEqualToString:@"hid"]) {
+        return NO;
+    }
+    job.startedAt = CFAbsoluteTimeGetCurrent();
+    job.state = @"running";
+    NSString *insertPath = nil;
+    BOOL inserted = KimiRunInsertTextViaFocusedInput(job.text, &insertPath);
+    job.insertMS = (CFAbsoluteTimeGetCurrent() - job.startedAt) * 1000.0;
+    job.insertPath = insertPath;
+    if (inserted) {
+        job.path = @"insert";
+        job.charactersTyped = job.charactersTotal;
+        job.success = YES;
+        job.finishedAt = CFAbsoluteTimeGetCurrent();
+        job.state = @"done";
+        KimiRunLog([NSString stringWithFormat:@"[TypeText] bulk insert job=%@ path=%@ length=%lu elapsedMS=%.2f",
+                    job.jobID, insertPath ?: @"(unknown)", (unsigned long)job.charactersTotal, job.insertMS]);
+        return YES;
+    }
+    if ([job.mode isEqualToString:@"insert"]) {
+        job.path = @"insert";
+        job.error = @"no_focused_text_input";
+        job.finishedAt = CFAbsoluteTimeGetCurrent();
+        job.state = @"failed";
+        return YES;
+    }
+    return NO;
+}
+
+// Runs on the typing queue and never touches the main thread. Only callers
+// off main wait for it; main-thread callers get the job status instead.
+static void KimiRunPlayKeyStream(KimiRunTypingJob *job) {
+    if (job.startedAt <= 0) {
+        job.startedAt = CFAbsoluteTimeGetCurrent();
+    }
+    job.state = @"running";
+
+    job.path = @"hid";
+    KimiRunKeyStream stream;
+    if (!KimiRunBuildKeyStream(job.text, &stream)) {
+        job.skippedCharacters = stream.skipped;
+        job.error = @"no_typeable_characters";
+        job.finishedAt = CFAbsoluteTimeGetCurrent();
+        job.state = @"failed";
+        KimiRunFreeKeyStream(&stream);
+        return;
+    }
+    job.keyEvents = stream.count;
+    job.skippedCharacters = stream.skipped;
+    job.charactersTotal = stream.characters;
+
+    uint64_t holdTicks = KimiRunMachTicksForMS(job.holdMS);
+    uint64_t intervalTicks = KimiRunMachTicksForMS(job.intervalMS);
+    uint64_t deadline = mach_absolute_time();
+    BOOL okAny = NO;
+    NSUInteger typed = 0;
+    for (NSUInteger i = 0; i < stream.count; i++) {
+        const KimiRunKeyStreamEvent *event = &stream.events[i];
+        if (KimiRunPostKeyboardUsage(event->usage, event->down != 0)) {
+            okAny = YES;
+        }
+        if (event->endsCharacter) {
+            typed++;
+            job.charactersTyped = typed;
+        }
+        // Hold between a key going down and the next transition; after a
+        // character is released wait the inter-key interval instead.
+        deadline += event->endsCharacter ? intervalTicks : holdTicks;
+        if (deadline > mach_absolute_time()) {
+            mach_wait_until(deadline);
+        }
+    }
+    KimiRunFreeKeyStream(&stream);
+
+    job.success = okAny;
+    job.finishedAt = CFAbsoluteTimeGetCurrent();
+    job.state = okAny ? @"done" : @"failed";
+    if (!okAny) {
+        job.error = @"hid_dispatch_failed";
+    }
+    NSDictionary *status = [job statusDictionary];
+    KimiRunLog([NSString stringWithFormat:@"[TypeText] hid stream job=%@ chars=%@ events=%@ elapsedMS=%.1f cps=%.1f",
+                job.jobID, status[@"charactersTyped"], status[@"keyEvents"],
+                [status[@"elapsedMS"] doubleValue], [status[@"charsPerSecond"] doubleValue]]);
+}
+
+static void KimiRunFinishTypingJob(KimiRunTypingJob *job, void (^completion)(NSDictionary *status)) {
+    if (!completion) {
+        return;
+    }
+    NSDictionary *status = [job statusDictionary];
+    if ([NSThread isMainThread]) {
+        completion(status);
+        return;
+    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+        completion(status);
+    });
+}
+
+NSString *KimiRunStartTypingJobWithCompletion(NSString *text,
+                                              NSDictionary *options,
+                                              void (^completion)(NSDictionary *status)) {
+    if (![text isKindOfClass:[NSString class]] || text.length == 0) {
+        return nil;
+    }
+    KimiRunTypingJob *job = KimiRunMakeTypingJob(text, options);
+    KimiRunRegisterTypingJob(job);
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (KimiRunTryFocusedInsert(job)) {
+            KimiRunFinishTypingJob(job, completion);
+            return;
+        }
+        dispatch_async(KimiRunTypingQueue(), ^{
+            KimiRunPlayKeyStream(job);
+            KimiRunFinishTypingJob(job, completion);
+        });
+    });
+    return job.jobID;
+}
+
+NSString *KimiRunStartTypingJob(NSString *text, NSDictionary *options) {
+    return KimiRunStartTypingJobWithCompletion(text, options, nil);
+}
+
+NSDictionary *KimiRunRunTypingJob(NSString *text, NSDictionary *options) {
+    if (![text isKindOfClass:[NSString class]] || text.length == 0) {
+        return nil;
+    }
+    KimiRunTypingJob *job = KimiRunMakeTypingJob(text, options);
+    KimiRunRegisterTypingJob(job);
+    if ([NSThread isMainThread]) {
+        // Playback can take seconds; the main thread only does the insert
+        // and gets back the job status with the keys still queued.
+        if (!KimiRunTryFocusedInsert(job)) {
+            dispatch_async(KimiRunTypingQueue(), ^{
+                KimiRunPlayKeyStream(job);
+            });
+        }
+        return [job statusDictionary];
+    }
+    __block BOOL finished = NO;
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        finished = KimiRunTryFocusedInsert(job);
+    });
+    if (!finished) {
+        dispatch_sync(KimiRunTypingQueue(), ^{
+            KimiRunPlayKeyStream(job);
+        });
+    }
+    return [job statusDictionary];
+}
+
+NSDictionary *KimiRunTypingJobStatus(NSString *jobID) {
+    if (![jobID isKindOfClass:[NSString class]] || jobID.length == 0) {
+        return nil;
+    }
+    KimiRunTypingJob *job = nil;
+    @synchronized([KimiRunTypingJob class]) {
+        job = g_typingJobs[jobID];
+    }
+    return [job statusDictionary];
+}
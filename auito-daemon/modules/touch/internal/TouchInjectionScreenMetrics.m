@@ -0,0 +1,229 @@
+#import "TouchInjectionInternal.h"
+#import <os/lock.h>
+#import <stdatomic.h>
+
+// Screen metrics cache + input -> digitizer coordinate transform.
+// UIScreen is queried only when the cache is rebuilt (first use and after an
+// orientation / screen-mode notification); per-event conversion is plain
+// arithmetic on a snapshot.
+
+static os_unfair_lock g_screenMetricsLock = OS_UNFAIR_LOCK_INIT;
+static KimiRunScreenMetrics g_screenMetrics;
+static _Atomic uint32_t g_screenMetricsGeneration = 1;
+static uint32_t g_screenMetricsBuiltGeneration = 0;   // guarded by g_screenMetricsLock
+
+static CGAffineTransform KimiRunDigitizerTransformForScreen(UIScreen *screen, CGSize interfaceSize) {
+    CGSize fixedSize = interfaceSize;
+    CGPoint origin = CGPointZero;
+    CGPoint unitX = CGPointMake(1.0, 0.0);
+    CGPoint unitY = CGPointMake(0.0, 1.0);
+    if ([screen respondsToSelector:@selector(fixedCoordinateSpace)]) {
+        // The digitizer reports in the fixed (portrait) space; UIScreen.bounds
+        // and screenshots follow the interface orientation.
+        id<UICoordinateSpace> from = screen.coordinateSpace;
+        id<UICoordinateSpace> to = screen.fixedCoordinateSpace;
+        if (from && to) {
+            fixedSize = to.bounds.size;
+            origin = [from convertPoint:CGPointZero toCoordinateSpace:to];
+            unitX = [from convertPoint:CGPointMake(1.0, 0.0) toCoordinateSpace:to];
+            unitY = [from convertPoint:CGPointMake(0.0, 1.0) toCoordinateSpace:to];
+        }
+    }
+    if (fixedSize.width <= 0 || fixedSize.height <= 0) {
+        return CGAffineTransformIdentity;
+    }
+    CGAffineTransform t;
+    t.a = (unitX.x - origin.x) / fixedSize.width;
+    t.b = (unitX.y - origin.y) / fixedSize.height;
+    t.c = (unitY.x - origin.x) / fixedSize.width;
+    t.d = (unitY.y - origin.y) / fixedSize.height;
+    t.tx = origin.x / fixedSize.width;
+    t.ty = origin.y / fixedSize.height;
+    return t;
+}
+
+static BOOL KimiRunBuildScreenMetrics(KimiRunScreenMetrics *out) {
+    UIScreen *mainScreen = [UIScreen mainScreen];
+    if (!mainScreen) {
+        return NO;
+    }
+    CGRect bounds = mainScreen.bounds;
+    if (bounds.size.width <= 0 || bounds.size.height <= 0) {
+        return NO;
+    }
+    memset(out, 0, sizeof(*out));
+    out->width = bounds.size.width;
+    out->height = bounds.size.height;
+    out->scale = mainScreen.scale > 0 ? mainScreen.scale : 1.0;
+
+    // nativeBounds is always portrait; map it onto the interface orientation.
+    CGFloat pixelScale = out->scale;
+    if ([mainScreen respondsToSelector:@selector(nativeBounds)] &&
+        [mainScreen respondsToSelector:@selector(fixedCoordinateSpace)]) {
+        CGSize fixed = mainScreen.fixedCoordinateSpace.bounds.size;
+        CGRect nativeBounds = mainScreen.nativeBounds;
+        if (fixed.width > 0 && nativeBounds.size.width > 0) {
+            pixelScale = nativeBounds.size.width / fixed.width;
+        }
+    }
+    out->pixelWidth = out->width * pixelScale;
+    out->pixelHeight = out->height * pixelScale;
+    out->toDigitizer = KimiRunDigitizerTransformForScreen(mainScreen, bounds.size);
+    out->valid = YES;
+    return YES;
+}
+
+BOOL KimiRunScreenMetricsSnapshot(KimiRunScreenMetrics *out) {
+    uint32_t wanted = atomic_load_explicit(&g_screenMetricsGeneration, memory_order_acquire);
+    os_unfair_lock_lock(&g_screenMetricsLock);
+    BOOL fresh = g_screenMetrics.valid && g_screenMetricsBuiltGeneration == wanted;
+    if (fresh && out) {
+        *out = g_screenMetrics;
+    }
+    os_unfair_lock_unlock(&g_screenMetricsLock);
+    if (fresh) {
+        return YES;
+    }
+
+    // Rebuild outside the lock: UIScreen may take its own locks.
+    KimiRunScreenMetrics built;
+    if (!KimiRunBuildScreenMetrics(&built)) {
+        NSLog(@"[KimiRunTouchInjection] Warning: UIScreen metrics unavailable");
+        if (out) {
+            memset(out, 0, sizeof(*out));
+        }
+        return NO;
+    }
+    built.generation = wanted;
+
+    os_unfair_lock_lock(&g_screenMetricsLock);
+    g_screenMetrics = built;
+    g_screenMetricsBuiltGeneration = wanted;
+    g_screenWidth = built.width;
+    g_screenHeight = built.height;
+    g_screenScale = built.scale;
+    g_screenPixelWidth = built.pixelWidth;
+    g_screenPixelHeight = built.pixelHeight;
+    os_unfair_lock_unlock(&g_screenMetricsLock);
+
+    KimiRunLog([NSString stringWithFormat:@"[Screen] metrics gen=%u %.0fx%.0f@%.1f pixels=%.0fx%.0f transform=[%.4f %.4f %.4f %.4f %.4f %.4f]",
+                wanted, built.width, built.height, built.scale, built.pixelWidth, built.pixelHeight,
+                built.toDigitizer.a, built.toDigitizer.b, built.toDigitizer.c, built.toDigitizer.d,
+                built.toDigitizer.tx, built.toDigitizer.ty]);
+    if (out) {
+        *out = built;
+    }
+    return YES;
+}
+
+void KimiRunScreenMetricsInvalidate(void) {
+    atomic_fetch_add_explicit(&g_screenMetricsGeneration, 1, memory_order_release);
+}
+
+void KimiRunScreenMetricsStartObserving(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        NSArray<NSString *> *names = @[
+            UIApplicationDidChangeStatusBarOrientationNotification,
+            UIDeviceOrientationDidChangeNotification,
+            UIScreenModeDidChangeNotification,
+            UIScreenDidConnectNotification,
+            UIScreenDidDisconnectNotification,
+        ];
+        for (NSString *name in names) {
+            [center addObserverForName:name object:nil queue:nil usingBlock:^(__unused NSNotification *note) {
+                KimiRunScreenMetricsInvalidate();
+            }];
+        }
+    });
+}
+
+KimiRunCoordinateSpace KimiRunCoordinateSpaceFromString(NSString *value) {
+    if (![value isKindOfClass:[NSString class]] || value.length == 0) {
+        return KimiRunCoordinateSpaceAuto;
+    }
+    NSString *lower = [value lowercaseString];
+    if ([lower isEqualToString:@"points"] || [lower isEqualToString:@"point"] || [lower isEqualToString:@"pt"]) {
+        return KimiRunCoordinateSpacePoints;
+    }
+    if ([lower isEqualToString:@"pixels"] || [lower isEqualToString:@"pixel"] || [lower isEqualToString:@"px"]) {
+        return KimiRunCoordinateSpacePixels;
+    }
+    if ([lower isEqualToString:@"normalized"] || [lower isEqualToString:@"norm"] || [lower isEqualToString:@"unit"]) {
+        return KimiRunCoordinateSpaceNormalized;
+    }
+    return KimiRunCoordinateSpaceAuto;
+}
+
+void KimiRunConvertInputPoints(CGPoint *points, size_t count, KimiRunCoordinateSpace space) {
+    if (!points || count == 0) {
+        return;
+    }
+    KimiRunScreenMetrics m;
+    if (!KimiRunScreenMetricsSnapshot(&m)) {
+        return;
+    }
+    switch (space) {
+        case KimiRunCoordinateSpacePoints:
+            return;
+        case KimiRunCoordinateSpacePixels: {
+            CGFloat sx = m.width / m.pixelWidth;
+            CGFloat sy = m.height / m.pixelHeight;
+            for (size_t i = 0; i < count; i++) {
+                points[i].x *= sx;
+                points[i].y *= sy;
+            }
+            return;
+        }
+        case KimiRunCoordinateSpaceNormalized:
+            for (size_t i = 0; i < count; i++) {
+                points[i].x *= m.width;
+                points[i].y *= m.height;
+            }
+            return;
+        case KimiRunCoordinateSpaceAuto:
+            break;
+    }
+    if (m.scale <= 1.0) {
+        return;
+    }
+    // Legacy heuristic: a point outside the point bounds but inside the pixel
+    // bounds came from a screenshot.
+    CGFloat sx = m.width / m.pixelWidth;
+    CGFloat sy = m.height / m.pixelHeight;
+    for (size_t i = 0; i < count; i++) {
+        CGFloat x = points[i].x;
+        CGFloat y = points[i].y;
+        BOOL looksLikePixels = (x > m.width + 1.0 || y > m.height + 1.0) &&
+                               (x <= m.pixelWidth + 1.0) &&
+                               (y <= m.pixelHeight + 1.0);
+        if (looksLikePixels) {
+            points[i].x = x * sx;
+            points[i].y = y * sy;
+        }
+    }
+}
+
+KimiRunTouchTransform KimiRunTouchTransformFromAffine(CGAffineTransform t) {
+    KimiRunTouchTransform out;
+    out.a = t.a;
+    out.b = t.b;
+    out.c = t.c;
+    out.d = t.d;
+    out.tx = t.tx;
+    out.ty = t.ty;
+    return out;
+}
+
+void KimiRunDigitizerPointsFromInterfacePoints(const CGPoint *points, size_t count, float *normX, float *normY) {
+    if (!points || !normX || !normY || count == 0) {
+        return;
+    }
+    KimiRunScreenMetrics m;
+    CGAffineTransform t = KimiRunScreenMetricsSnapshot(&m) ? m.toDigitizer : CGAffineTransformIdentity;
+    KimiRunTouchTransform transform = KimiRunTouchTransformFromAffine(t);
+    for (size_t i = 0; i < count; i++) {
+        KimiRunTouchTransformApply(&transform, points[i].x, points[i].y, &normX[i], &normY[i]);
+    }
+}
@@ -1,10 +1,162 @@
 #import "TouchInjectionInternal.h"
+#import <os/lock.h>
+#import <stdatomic.h>
 #include <mach/kern_return.h>
 
 // IOKit function not declared in our SDK headers
 extern kern_return_t IORegistryEntryGetRegistryEntryID(io_registry_entry_t entry, uint64_t *entryID);
 
 static void CleanupSenderCallbacks(void);
+static void PersistSenderID(uint64_t senderID);
+
+#pragma mark - State
+
+// id/source/captured are published under a sequence counter that is odd
+// while a write is in progress; readers retry until they see the same even
+// value on both sides. Writers are rare and serialize on the unfair lock.
+// The HID callback only touches relaxed counters until it has a sender.
+static os_unfair_lock g_senderStateWriteLock = OS_UNFAIR_LOCK_INIT;
+static _Atomic uint32_t g_senderStateSequence = 0;
+static _Atomic uint64_t g_senderStateID = 0;
+static _Atomic uint32_t g_senderStateMeta = 0;        // source | captured << 8
+static _Atomic int32_t g_senderCallbackCount = 0;
+static _Atomic int32_t g_senderCallbackDigitizerCount = 0;
+static _Atomic int32_t g_senderLastEventType = -1;
+static _Atomic int32_t g_senderIgnoredInjected = 0;
+static _Atomic bool g_senderCaptureSettled = false;
+static _Atomic bool g_senderCleanupClaimed = false;
+
+// First few callback events, recorded raw and formatted later by the
+// capture thread's heartbeat (and /touch/diagnostics).
+#define kKimiRunSenderEarlyEventCount 10
+typedef NS_ENUM(uint32_t, KimiRunSenderEarlyKind) {
+    KimiRunSenderEarlyParent = 1,      // digitizer parent
+    KimiRunSenderEarlyChild = 2,       // digitizer child of a non-digitizer parent
+    KimiRunSenderEarlySkipped = 3      // non-digitizer parent
+};
+static _Atomic uint64_t g_senderEarlySender[kKimiRunSenderEarlyEventCount];
+static _Atomic uint32_t g_senderEarlyTag[kKimiRunSenderEarlyEventCount];   // kind << 16 | type; 0 == empty
+static int g_senderEarlyLogged = 0;    // capture thread only
+
+BOOL KimiRunSenderIDPublish(uint64_t senderID, KimiRunSenderIDSource source, BOOL captured) {
+    uint32_t meta = (uint32_t)source | (captured ? (1u << 8) : 0u);
+    os_unfair_lock_lock(&g_senderStateWriteLock);
+    uint64_t previous = atomic_load_explicit(&g_senderStateID, memory_order_relaxed);
+    uint32_t sequence = atomic_load_explicit(&g_senderStateSequence, memory_order_relaxed);
+    atomic_store_explicit(&g_senderStateSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&g_senderStateID, senderID, memory_order_relaxed);
+    atomic_store_explicit(&g_senderStateMeta, meta, memory_order_relaxed);
+    atomic_store_explicit(&g_senderStateSequence, sequence + 2, memory_order_release);
+    os_unfair_lock_unlock(&g_senderStateWriteLock);
+    return previous != senderID;
+}
+
+void KimiRunSenderIDGetSnapshot(KimiRunSenderIDSnapshot *out) {
+    if (!out) {
+        return;
+    }
+    uint64_t senderID = 0;
+    uint32_t meta = 0;
+    uint32_t before = 0;
+    for (;;) {
+        before = atomic_load_explicit(&g_senderStateSequence, memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        senderID = atomic_load_explicit(&g_senderStateID, memory_order_relaxed);
+        meta = atomic_load_explicit(&g_senderStateMeta, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&g_senderStateSequence, memory_order_relaxed) == before) {
+            break;
+        }
+    }
+    out->senderID = senderID;
+    out->source = (KimiRunSenderIDSource)(meta & 0xFFu);
+    out->captured = (meta & (1u << 8)) != 0;
+    out->generation = before / 2;
+    out->callbackCount = atomic_load_explicit(&g_senderCallbackCount, memory_order_relaxed);
+    out->digitizerCount = atomic_load_explicit(&g_senderCallbackDigitizerCount, memory_order_relaxed);
+    out->lastEventType = atomic_load_explicit(&g_senderLastEventType, memory_order_relaxed);
+    out->ignoredInjected = atomic_load_explicit(&g_senderIgnoredInjected, memory_order_relaxed);
+}
+
+uint64_t KimiRunCurrentSenderID(void) {
+    return atomic_load_explicit(&g_senderStateID, memory_order_acquire);
+}
+
+NSString *KimiRunSenderIDSourceName(KimiRunSenderIDSource source, uint64_t senderID) {
+    switch (source) {
+        case KimiRunSenderIDSourceIORegistry: return @"ioreg";
+        case KimiRunSenderIDSourceCallback: return @"callback";
+        case KimiRunSenderIDSourcePersisted: return @"persisted";
+        case KimiRunSenderIDSourceOverride: return @"override";
+        case KimiRunSenderIDSourceNone: break;
+    }
+    return (senderID == 0 ? @"none" : @"unknown");
+}
+
+static void NoteSenderEarlyEvent(int32_t callbackIndex, KimiRunSenderEarlyKind kind, int type, uint64_t sender) {
+    if (callbackIndex < 1 || callbackIndex > kKimiRunSenderEarlyEventCount) {
+        return;
+    }
+    int slot = callbackIndex - 1;
+    atomic_store_explicit(&g_senderEarlySender[slot], sender, memory_order_relaxed);
+    atomic_store_explicit(&g_senderEarlyTag[slot], ((uint32_t)kind << 16) | ((uint32_t)type & 0xFFFFu),
+                          memory_order_release);
+}
+
+static NSString *SenderEarlyKindName(uint32_t kind) {
+    switch (kind) {
+        case KimiRunSenderEarlyParent: return @"digitizer parent";
+        case KimiRunSenderEarlyChild: return @"digitizer child";
+        case KimiRunSenderEarlySkipped: return @"skip non-digitizer parent";
+    }
+    return @"unknown";
+}
+
+NSArray<NSDictionary *> *KimiRunSenderIDEarlyEvents(void) {
+    NSMutableArray<NSDictionary *> *events = [NSMutableArray array];
+    for (int i = 0; i < kKimiRunSenderEarlyEventCount; i++) {
+        uint32_t tag = atomic_load_explicit(&g_senderEarlyTag[i], memory_order_acquire);
+        if (tag == 0) {
+            continue;
+        }
+        uint64_t sender = atomic_load_explicit(&g_senderEarlySender[i], memory_order_relaxed);
+        [events addObject:@{
+            @"index": @(i + 1),
+            @"kind": SenderEarlyKindName(tag >> 16),
+            @"type": @((int)(tag & 0xFFFFu)),
+            @"sender": [NSString stringWithFormat:@"0x%llX", sender]
+        }];
+    }
+    return events;
+}
+
+// Capture thread heartbeat: log early events recorded since the last call.
+static void LogSenderEarlyEvents(void) {
+    while (g_senderEarlyLogged < kKimiRunSenderEarlyEventCount) {
+        uint32_t tag = atomic_load_explicit(&g_senderEarlyTag[g_senderEarlyLogged], memory_order_acquire);
+        if (tag == 0) {
+            break;
+        }
+        uint64_t sender = atomic_load_explicit(&g_senderEarlySender[g_senderEarlyLogged], memory_order_relaxed);
+        KimiRunLog([NSString stringWithFormat:@"[SenderID] %@ type=%d sender=0x%llX",
+                    SenderEarlyKindName(tag >> 16), (int)(tag & 0xFFFFu), sender]);
+        g_senderEarlyLogged++;
+    }
+}
+
+static dispatch_queue_t SenderIDWorkQueue(void) {
+    static dispatch_queue_t queue;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("com.kimirun.senderid", DISPATCH_QUEUE_SERIAL);
+    });
+    return queue;
+}
+
+#pragma mark - Persistence
 
 // Extracted from TouchInjection.m: senderID persistence + capture management
 static void PersistSenderID(uint64_t senderID) {
@@ -39,10 +191,8 @@ static void LoadPersistedSenderID(void) {
         if (llabs(lastReboot - thisRebootTime) <= 3) {
             uint64_t persisted = [dict[@"senderID"] unsignedLongLongValue];
             if (persisted != 0 && persisted != kTouchSenderID) {
-                g_senderID = persisted;
-                g_senderCaptured = NO;
-                g_senderSource = 3;
-                NSLog(@"[KimiRunTouchInjection] Loaded persisted senderID: 0x%llX", g_senderID);
+                KimiRunSenderIDPublish(persisted, KimiRunSenderIDSourcePersisted, NO);
+                NSLog(@"[KimiRunTouchInjection] Loaded persisted senderID: 0x%llX", persisted);
             } else if (persisted == kTouchSenderID) {
                 NSLog(@"[KimiRunTouchInjection] Ignoring persisted fallback senderID");
             }
@@ -53,7 +203,7 @@ static void LoadPersistedSenderID(void) {
 }
 
 static void TryLoadSenderIDFromIORegistry(void) {
-    if (g_senderID != 0) {
+    if (KimiRunCurrentSenderID() != 0) {
         return;
     }
     @try {
@@ -71,24 +221,20 @@ static void TryLoadSenderIDFromIORegistry(void) {
         uint64_t entryID = 0;
         kern_return_t kr = IORegistryEntryGetRegistryEntryID(service, &entryID);
         if (kr == KERN_SUCCESS && entryID != 0) {
-            g_senderID = entryID;
-            g_senderCaptured = NO;
-            g_senderSource = 1;
-            NSLog(@"[KimiRunTouchInjection] Loaded senderID from IORegistry entry ID: 0x%llX", g_senderID);
-            KimiRunLog([NSString stringWithFormat:@"[SenderID] IORegistry entryID=0x%llX", g_senderID]);
-            PersistSenderID(g_senderID);
+            KimiRunSenderIDPublish(entryID, KimiRunSenderIDSourceIORegistry, NO);
+            NSLog(@"[KimiRunTouchInjection] Loaded senderID from IORegistry entry ID: 0x%llX", entryID);
+            KimiRunLog([NSString stringWithFormat:@"[SenderID] IORegistry entryID=0x%llX", entryID]);
+            PersistSenderID(entryID);
         } else {
             // Fallback: try Multitouch ID property (less reliable but non-zero)
             CFTypeRef value = IORegistryEntryCreateCFProperty(service, CFSTR("Multitouch ID"), kCFAllocatorDefault, 0);
             if (value && CFGetTypeID(value) == CFNumberGetTypeID()) {
                 uint64_t mtID = 0;
                 if (CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &mtID) && mtID != 0) {
-                    g_senderID = mtID;
-                    g_senderCaptured = NO;
-                    g_senderSource = 1;
-                    NSLog(@"[KimiRunTouchInjection] Loaded senderID from IORegistry Multitouch ID (fallback): 0x%llX", g_senderID);
-                    KimiRunLog([NSString stringWithFormat:@"[SenderID] IORegistry MultitouchID(fallback)=0x%llX", g_senderID]);
-                    PersistSenderID(g_senderID);
+                    KimiRunSenderIDPublish(mtID, KimiRunSenderIDSourceIORegistry, NO);
+                    NSLog(@"[KimiRunTouchInjection] Loaded senderID from IORegistry Multitouch ID (fallback): 0x%llX", mtID);
+                    KimiRunLog([NSString stringWithFormat:@"[SenderID] IORegistry MultitouchID(fallback)=0x%llX", mtID]);
+                    PersistSenderID(mtID);
                 }
             }
             if (value) {
@@ -101,81 +247,87 @@ static void TryLoadSenderIDFromIORegistry(void) {
     }
 }
 
+#pragma mark - Capture
+
+static void FinishSenderCapture(uint64_t sender, int eventType, BOOL changed) {
+    if (changed) {
+        PersistSenderID(sender);
+    }
+    NSLog(@"[KimiRunTouchInjection] Captured digitizer senderID: 0x%llX (eventType=%d)", sender, eventType);
+    KimiRunLog([NSString stringWithFormat:@"[SenderID] captured-digitizer 0x%llX eventType=%d", sender, eventType]);
+    CleanupSenderCallbacks();
+}
+
+// Runs on the HID callback thread for every event until capture, so it
+// only does atomic bookkeeping; persistence, logging and callback teardown
+// are handed to the sender-ID work queue.
 static void SenderIDCallback(void* target, void* refcon, void* service, IOHIDEventRef event) {
     if (!_IOHIDEventGetType || !_IOHIDEventGetSenderID || !event) {
         return;
     }
-    g_senderCallbackCount++;
-    g_senderLastEventType = (int)_IOHIDEventGetType(event);
-    BOOL isDigitizer = (g_senderLastEventType == kIOHIDEventTypeDigitizer || g_senderLastEventType == 11);
+    int32_t callbackIndex = atomic_fetch_add_explicit(&g_senderCallbackCount, 1, memory_order_relaxed) + 1;
+    int eventType = (int)_IOHIDEventGetType(event);
+    atomic_store_explicit(&g_senderLastEventType, eventType, memory_order_relaxed);
+    BOOL isDigitizer = (eventType == kIOHIDEventTypeDigitizer || eventType == 11);
+    if (isDigitizer) {
+        atomic_fetch_add_explicit(&g_senderCallbackDigitizerCount, 1, memory_order_relaxed);
+    }
+    if (atomic_load_explicit(&g_senderCaptureSettled, memory_order_relaxed)) {
+        // Captured; the registrations are being torn down.
+        return;
+    }
+
     uint64_t sender = 0;
     BOOL senderFromDigitizer = NO;
     if (isDigitizer) {
-        g_senderCallbackDigitizerCount++;
         senderFromDigitizer = YES;
         sender = _IOHIDEventGetSenderID(event);
-        if (g_senderCallbackCount <= 10) {
-            KimiRunLog([NSString stringWithFormat:@"[SenderID] digitizer parent type=%d sender=0x%llX", g_senderLastEventType, sender]);
-        }
+        NoteSenderEarlyEvent(callbackIndex, KimiRunSenderEarlyParent, eventType, sender);
     } else {
-        // Log non-digitizer events but do NOT capture sender from them.
+        // Do NOT capture sender from non-digitizer events.
         // SimulateTouch only captures from kIOHIDEventTypeDigitizer events.
         // Non-digitizer events (type 1=VendorDefined, 15=Biometric, etc.) have
         // different sender IDs that do NOT match the touch digitizer.
-        if (g_senderCallbackCount <= 10) {
-            uint64_t nonDigSender = _IOHIDEventGetSenderID(event);
-            KimiRunLog([NSString stringWithFormat:@"[SenderID] skip non-digitizer parent type=%d sender=0x%llX",
-                        g_senderLastEventType,
-                        nonDigSender]);
+        if (callbackIndex <= kKimiRunSenderEarlyEventCount) {
+            NoteSenderEarlyEvent(callbackIndex, KimiRunSenderEarlySkipped, eventType, _IOHIDEventGetSenderID(event));
         }
         // Check children for digitizer sub-events
         if (_IOHIDEventGetChildren) {
             CFArrayRef children = _IOHIDEventGetChildren(event);
-            if (children) {
-                CFIndex count = CFArrayGetCount(children);
-                for (CFIndex i = 0; i < count; i++) {
-                    IOHIDEventRef child = (IOHIDEventRef)CFArrayGetValueAtIndex(children, i);
-                    if (!child) {
-                        continue;
-                    }
-                    IOHIDEventType childType = _IOHIDEventGetType(child);
-                    if (childType == kIOHIDEventTypeDigitizer || childType == 11) {
-                        g_senderCallbackDigitizerCount++;
-                        senderFromDigitizer = YES;
-                        sender = _IOHIDEventGetSenderID(child);
-                        if (g_senderCallbackCount <= 10) {
-                            KimiRunLog([NSString stringWithFormat:@"[SenderID] digitizer child type=%d sender=0x%llX",
-                                        (int)childType,
-                                        sender]);
-                        }
-                        if (sender != 0) {
-                            break;
-                        }
+            CFIndex count = children ? CFArrayGetCount(children) : 0;
+            for (CFIndex i = 0; i < count; i++) {
+                IOHIDEventRef child = (IOHIDEventRef)CFArrayGetValueAtIndex(children, i);
+                if (!child) {
+                    continue;
+                }
+                IOHIDEventType childType = _IOHIDEventGetType(child);
+                if (childType == kIOHIDEventTypeDigitizer || childType == 11) {
+                    atomic_fetch_add_explicit(&g_senderCallbackDigitizerCount, 1, memory_order_relaxed);
+                    senderFromDigitizer = YES;
+                    sender = _IOHIDEventGetSenderID(child);
+                    NoteSenderEarlyEvent(callbackIndex, KimiRunSenderEarlyChild, (int)childType, sender);
+                    if (sender != 0) {
+                        break;
                     }
                 }
             }
         }
     }
-    if (sender != 0 && senderFromDigitizer) {
-        if (sender == kTouchSenderID) {
-            // Ignore fallback senderID from our own injected events
-            KimiRunLog(@"[SenderID] ignoring fallback senderID from injected event");
-        } else {
-            if (g_senderID != sender) {
-                g_senderID = sender;
-                PersistSenderID(g_senderID);
-            }
-            g_senderCaptured = YES;
-            g_senderSource = 2;
-            NSLog(@"[KimiRunTouchInjection] Captured digitizer senderID: 0x%llX (eventType=%d)", g_senderID, g_senderLastEventType);
-            KimiRunLog([NSString stringWithFormat:@"[SenderID] captured-digitizer 0x%llX eventType=%d", g_senderID, g_senderLastEventType]);
-            CleanupSenderCallbacks();
-        }
+    if (sender == 0 || !senderFromDigitizer) {
+        return;
     }
-    if (g_senderCallbackCount <= 5 || (g_senderCallbackCount % 100) == 0) {
-        NSLog(@"[KimiRunTouchInjection] SenderID callback fired (%d), lastType=%d, digitizerCount=%d, senderFromDigitizer=%d",
-              g_senderCallbackCount, g_senderLastEventType, g_senderCallbackDigitizerCount, senderFromDigitizer);
+    if (sender == kTouchSenderID) {
+        // Fallback senderID from our own injected events.
+        atomic_fetch_add_explicit(&g_senderIgnoredInjected, 1, memory_order_relaxed);
+        return;
+    }
+    BOOL changed = KimiRunSenderIDPublish(sender, KimiRunSenderIDSourceCallback, YES);
+    if (atomic_exchange_explicit(&g_senderCaptureSettled, true, memory_order_acq_rel)) {
+        return;
     }
+    dispatch_async(SenderIDWorkQueue(), ^{
+        FinishSenderCapture(sender, eventType, changed);
+    });
 }
 
 static void ApplyDigitizerMatching(IOHIDEventSystemClientRef client) {
@@ -199,7 +351,7 @@ static void ApplyDigitizerMatching(IOHIDEventSystemClientRef client) {
 }
 
 static void CleanupSenderCallbacks(void) {
-    if (g_senderCleanupDone) {
+    if (atomic_exchange_explicit(&g_senderCleanupClaimed, true, memory_order_acq_rel)) {
         return;
     }
     g_senderCleanupDone = YES;
@@ -275,8 +427,12 @@ static void SenderIDThreadMain(void) {
         // Periodic logging to confirm thread is alive
         NSTimer *timer = [NSTimer timerWithTimeInterval:2.0
                                                  target:[NSBlockOperation blockOperationWithBlock:^{
-            NSLog(@"[KimiRunTouchInjection] SenderID thread alive, callbackCount=%d, senderID=0x%llX",
-                  g_senderCallbackCount, g_senderID);
+            KimiRunSenderIDSnapshot snapshot;
+            KimiRunSenderIDGetSnapshot(&snapshot);
+            LogSenderEarlyEvents();
+            NSLog(@"[KimiRunTouchInjection] SenderID thread alive, callbackCount=%d, digitizerCount=%d, lastType=%d, ignoredInjected=%d, senderID=0x%llX",
+                  snapshot.callbackCount, snapshot.digitizerCount, snapshot.lastEventType,
+                  snapshot.ignoredInjected, snapshot.senderID);
         }]
                                                selector:@selector(main)
                                                userInfo:nil
@@ -1,4 +1,6 @@
 #import "TouchInjectionInternal.h"
+#import "../../strategy/KimiRunStrategyScore.h"
+#import <os/lock.h>
 
 #define PostBKSTouchEventPhase KimiRunPostBKSTouchEventPhase
 #define PostSimulateTouchEvent KimiRunPostSimulateTouchEvent
@@ -6,59 +8,20 @@
 #define PostLegacyTouchEventPhase KimiRunPostLegacyTouchEventPhase
 
 // Extracted from TouchInjection.m: strategy resolution + dispatch routing
-static NSString *KimiRunPrefString(NSString *key) {
-    if (!key || key.length == 0) {
-        return nil;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs stringForKey:key];
-    return [value isKindOfClass:[NSString class]] ? value : nil;
-}
-
-static BOOL KimiRunPrefBool(NSString *key, BOOL defaultValue) {
-    if (!key || key.length == 0) {
-        return defaultValue;
-    }
-    NSUserDefaults *prefs = [[NSUserDefaults alloc] initWithSuiteName:kKimiRunPrefsSuite];
-    id value = [prefs objectForKey:key];
-    if (!value) {
-        return defaultValue;
-    }
-    return [prefs boolForKey:key];
-}
-
-static BOOL KimiRunEnvBool(const char *key, BOOL defaultValue) {
-    if (!key) {
-        return defaultValue;
-    }
-    const char *value = getenv(key);
-    if (!value || value[0] == '\0') {
-        return defaultValue;
-    }
-    NSString *lower = [[[NSString stringWithUTF8String:value] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] lowercaseString];
-    if ([lower isEqualToString:@"1"] || [lower isEqualToString:@"true"] || [lower isEqualToString:@"yes"] || [lower isEqualToString:@"on"]) {
-        return YES;
-    }
-    if ([lower isEqualToString:@"0"] || [lower isEqualToString:@"false"] || [lower isEqualToString:@"no"] || [lower isEqualToString:@"off"]) {
-        return NO;
-    }
-    return defaultValue;
-}
-
 static BOOL KimiRunForceAXEnabled(void) {
     // Default to AX on-device unless explicitly disabled.
     // Non-AX paths can still be tested by setting KIMIRUN_FORCE_AX=0
     // or preference ForceAX=false.
-    return KimiRunEnvBool("KIMIRUN_FORCE_AX",
-                          KimiRunPrefBool(@"ForceAX", YES));
+    return KimiRunPrefsEnvBool("KIMIRUN_FORCE_AX",
+                               KimiRunPrefsBool(@"ForceAX", YES));
 }
 
 static NSString *KimiRunDefaultMethod(void) {
-    const char *env = getenv("KIMIRUN_TOUCH_METHOD");
+    const char *env = KimiRunPrefsEnv("KIMIRUN_TOUCH_METHOD");
     if (env && env[0] != '\0') {
         return [NSString stringWithUTF8String:env];
     }
-    return KimiRunPrefString(@"TouchMethod");
+    return KimiRunPrefsString(@"TouchMethod");
 }
 
 static NSString *KimiRunResolveMethod(NSString *method) {
@@ -111,13 +74,13 @@ static BOOL KimiRunMethodRequiresVerifiedDelivery(NSString *lowerMethod) {
 }
 
 static BOOL KimiRunStrictRequireLiveSenderEnabled(void) {
-    return KimiRunEnvBool("KIMIRUN_STRICT_REQUIRE_LIVE_SENDER",
-                          KimiRunPrefBool(@"StrictRequireLiveSender", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_STRICT_REQUIRE_LIVE_SENDER",
+                               KimiRunPrefsBool(@"StrictRequireLiveSender", NO));
 }
 
 static BOOL KimiRunContextBindExperimentEnabled(void) {
-    return KimiRunEnvBool("KIMIRUN_NONAX_CONTEXT_BIND",
-                          KimiRunPrefBool(@"NonAXContextBind", NO));
+    return KimiRunPrefsEnvBool("KIMIRUN_NONAX_CONTEXT_BIND",
+                               KimiRunPrefsBool(@"NonAXContextBind", NO));
 }
 
 static BOOL KimiRunSenderLikelyLiveForStrict(void) {
@@ -161,61 +124,201 @@ static BOOL KimiRunRejectUnverifiedExplicitResult(NSString *lowerMethod, NSStrin
     return YES;
 }
 
-static BOOL DispatchPhaseWithOptions(KimiRunTouchPhase phase,
-                                     CGFloat x,
-                                     CGFloat y,
-                                     BOOL wantSim,
-                                     BOOL wantConn,
-                                     BOOL wantLegacy,
-                                     BOOL wantBKS,
-                                     BOOL wantAX,
-                                     BOOL allowFallback) {
-    // Prefer BKS when requested (auto/ax), since IOHID dispatch can report success
-    // even when the target process does not consume the event.
-    if (wantBKS && PostBKSTouchEventPhase(phase, x, y)) {
-        return YES;
+// Adaptive routing statistics, keyed by (frontmost bundle, gesture, backend).
+typedef struct {
+    BOOL valid;
+    char bundle[64];
+    KimiRunGestureKind gesture;
+    KimiRunTouchBackend backend;
+    CFAbsoluteTime endedAt;
+} KimiRunStrategyPending;
+
+static const CFTimeInterval kKimiRunStrategyVerificationWindow = 5.0;
+
+static os_unfair_lock g_strategyLock = OS_UNFAIR_LOCK_INIT;
+static KimiRunStrategyTable g_strategyTable;
+static BOOL g_strategyTableReady = NO;
+static KimiRunStrategyPending g_strategyPending;
+
+static BOOL KimiRunAdaptiveRoutingEnabled(void) {
+    return KimiRunPrefsEnvBool("KIMIRUN_ADAPTIVE_ROUTING",
+                               KimiRunPrefsBool(@"AdaptiveTouchRouting", YES));
+}
+
+static void KimiRunStrategyEnsureTableLocked(void) {
+    if (g_strategyTableReady) {
+        return;
     }
-    if (wantSim && PostSimulateTouchEvent(phase, x, y)) {
-        return YES;
+    KimiRunStrategyConfig config;
+    KimiRunStrategyConfigDefaults(&config);
+    config.halfLifeSeconds = KimiRunPrefsEnvDouble("KIMIRUN_ADAPTIVE_ROUTING_HALF_LIFE",
+                                                   KimiRunPrefsDouble(@"AdaptiveTouchRoutingHalfLife", 600.0));
+    // BKS starts ahead because IOHID paths can report success even when the
+    // target process never consumes the event; verified deltas can overturn it.
+    config.priorVerified[KimiRunTouchBackendBKS] = 0.85;
+    config.priorVerified[KimiRunTouchBackendSim] = 0.4;
+    config.priorVerified[KimiRunTouchBackendConn] = 0.4;
+    config.priorVerified[KimiRunTouchBackendLegacy] = 0.4;
+    config.priorLatencyMs[KimiRunTouchBackendBKS] = 4.0;
+    config.priorLatencyMs[KimiRunTouchBackendSim] = 1.0;
+    config.priorLatencyMs[KimiRunTouchBackendConn] = 1.0;
+    config.priorLatencyMs[KimiRunTouchBackendLegacy] = 1.0;
+    KimiRunStrategyTableInit(&g_strategyTable, &config);
+    g_strategyTableReady = YES;
+}
+
+static BOOL PostPhaseViaBackend(KimiRunGestureSession *session,
+                                KimiRunTouchBackend backend,
+                                KimiRunTouchPhase phase,
+                                CGFloat x,
+                                CGFloat y) {
+    CFAbsoluteTime start = (session && session->adaptive) ? CFAbsoluteTimeGetCurrent() : 0;
+    BOOL ok = NO;
+    switch (backend) {
+        case KimiRunTouchBackendBKS:
+            ok = PostBKSTouchEventPhase(phase, x, y);
+            break;
+        case KimiRunTouchBackendSim:
+            ok = PostSimulateTouchEvent(phase, x, y);
+            break;
+        case KimiRunTouchBackendConn:
+            ok = PostSimulateTouchEventViaConnection(phase, x, y);
+            break;
+        case KimiRunTouchBackendLegacy:
+            ok = PostLegacyTouchEventPhase(phase, x, y);
+            break;
+        case KimiRunTouchBackendNone:
+            return NO;
     }
-    if (wantConn && PostSimulateTouchEventViaConnection(phase, x, y)) {
-        return YES;
+    if (!session) {
+        return ok;
     }
-    if (wantLegacy && PostLegacyTouchEventPhase(phase, x, y)) {
-        return YES;
+    session->attempts++;
+    if (session->adaptive) {
+        CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+        os_unfair_lock_lock(&g_strategyLock);
+        KimiRunStrategyEnsureTableLocked();
+        KimiRunStrategyRecordAttempt(&g_strategyTable, session->bundle, (uint8_t)session->gesture,
+                                     (uint8_t)backend, ok, (now - start) * 1000.0, now);
+        os_unfair_lock_unlock(&g_strategyLock);
     }
+    return ok;
+}
+
+// Full fallback cascade. Returns the backend that accepted the phase, or
+// KimiRunTouchBackendNone. `skip` is a backend that already failed this phase.
+static KimiRunTouchBackend DispatchPhaseCascade(KimiRunGestureSession *session,
+                                                KimiRunTouchPhase phase,
+                                                CGFloat x,
+                                                CGFloat y,
+                                                BOOL wantSim,
+                                                BOOL wantConn,
+                                                BOOL wantLegacy,
+                                                BOOL wantBKS,
+                                                BOOL wantAX,
+                                                BOOL allowFallback,
+                                                KimiRunTouchBackend skip) {
+    // Prefer BKS when requested (auto/ax), since IOHID dispatch can report success
+    // even when the target process does not consume the event.
+    KimiRunTouchBackend order[12];
+    size_t count = 0;
+    if (wantBKS) order[count++] = KimiRunTouchBackendBKS;
+    if (wantSim) order[count++] = KimiRunTouchBackendSim;
+    if (wantConn) order[count++] = KimiRunTouchBackendConn;
+    if (wantLegacy) order[count++] = KimiRunTouchBackendLegacy;
+    size_t axStart = count;
     if (wantAX) {
         // AX has reliable tap activation, but no native phase-based swipe/drag pipeline.
         // For gesture phases, fall back to in-process touch synthesis to keep auto/ax usable.
-        if (PostSimulateTouchEvent(phase, x, y)) {
-            return YES;
-        }
-        if (PostSimulateTouchEventViaConnection(phase, x, y)) {
-            return YES;
-        }
-        if (PostLegacyTouchEventPhase(phase, x, y)) {
-            return YES;
-        }
-        if (PostBKSTouchEventPhase(phase, x, y)) {
-            return YES;
-        }
-        NSLog(@"[KimiRunTouchInjection] AX gesture fallback failed for phase=%d", (int)phase);
+        order[count++] = KimiRunTouchBackendSim;
+        order[count++] = KimiRunTouchBackendConn;
+        order[count++] = KimiRunTouchBackendLegacy;
+        order[count++] = KimiRunTouchBackendBKS;
     }
+    size_t axEnd = count;
     if (allowFallback) {
-        if (!wantBKS && PostBKSTouchEventPhase(phase, x, y)) {
-            return YES;
+        if (!wantBKS) order[count++] = KimiRunTouchBackendBKS;
+        if (!wantSim) order[count++] = KimiRunTouchBackendSim;
+        if (!wantConn) order[count++] = KimiRunTouchBackendConn;
+        if (!wantLegacy) order[count++] = KimiRunTouchBackendLegacy;
+    }
+
+    if (session && session->adaptive && count > 1) {
+        // Static order becomes the tie-break; repeats of a backend within
+        // one phase are dropped.
+        uint8_t candidates[12];
+        uint8_t ranked[KIMIRUN_STRATEGY_MAX_BACKENDS];
+        for (size_t i = 0; i < count; i++) {
+            candidates[i] = (uint8_t)order[i];
         }
-        if (!wantSim && PostSimulateTouchEvent(phase, x, y)) {
-            return YES;
+        os_unfair_lock_lock(&g_strategyLock);
+        KimiRunStrategyEnsureTableLocked();
+        size_t rankedCount = KimiRunStrategyOrder(&g_strategyTable, session->bundle, (uint8_t)session->gesture,
+                                                  candidates, count, CFAbsoluteTimeGetCurrent(), ranked);
+        os_unfair_lock_unlock(&g_strategyLock);
+        for (size_t i = 0; i < rankedCount; i++) {
+            KimiRunTouchBackend backend = (KimiRunTouchBackend)ranked[i];
+            if (backend != skip && PostPhaseViaBackend(session, backend, phase, x, y)) {
+                return backend;
+            }
         }
-        if (!wantConn && PostSimulateTouchEventViaConnection(phase, x, y)) {
-            return YES;
+        return KimiRunTouchBackendNone;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (order[i] != skip && PostPhaseViaBackend(session, order[i], phase, x, y)) {
+            return order[i];
         }
-        if (!wantLegacy && PostLegacyTouchEventPhase(phase, x, y)) {
+        if (i + 1 == axEnd && axEnd > axStart) {
+            NSLog(@"[KimiRunTouchInjection] AX gesture fallback failed for phase=%d", (int)phase);
+        }
+    }
+    return KimiRunTouchBackendNone;
+}
+
+static BOOL DispatchPhaseWithOptions(KimiRunTouchPhase phase,
+                                     CGFloat x,
+                                     CGFloat y,
+                                     BOOL wantSim,
+                                     BOOL wantConn,
+                                     BOOL wantLegacy,
+                                     BOOL wantBKS,
+                                     BOOL wantAX,
+                                     BOOL allowFallback) {
+    return DispatchPhaseCascade(NULL, phase, x, y, wantSim, wantConn, wantLegacy, wantBKS, wantAX,
+                                allowFallback, KimiRunTouchBackendNone) != KimiRunTouchBackendNone;
+}
+
+static BOOL DispatchSessionPhase(KimiRunGestureSession *session,
+                                 KimiRunTouchPhase phase,
+                                 CGFloat x,
+                                 CGFloat y) {
+    session->phases++;
+    KimiRunTouchBackend failed = KimiRunTouchBackendNone;
+    if (phase != KimiRunTouchPhaseDown && session->latched != KimiRunTouchBackendNone) {
+        if (PostPhaseViaBackend(session, session->latched, phase, x, y)) {
             return YES;
         }
+        failed = session->latched;
+        NSLog(@"[KimiRunTouchInjection] Latched backend %@ rejected phase=%d, re-running cascade",
+              KimiRunTouchBackendName(failed), (int)phase);
     }
-    return NO;
+    KimiRunTouchBackend accepted = DispatchPhaseCascade(session, phase, x, y,
+                                                        session->wantSim,
+                                                        session->wantConn,
+                                                        session->wantLegacy,
+                                                        session->wantBKS,
+                                                        session->wantAX,
+                                                        session->allowFallback,
+                                                        failed);
+    if (accepted == KimiRunTouchBackendNone) {
+        return NO;
+    }
+    if (failed != KimiRunTouchBackendNone) {
+        session->relatches++;
+    }
+    session->latched = accepted;
+    return YES;
 }
 
 #undef PostLegacyTouchEventPhase
@@ -223,18 +326,6 @@ static BOOL DispatchPhaseWithOptions(KimiRunTouchPhase phase,
 #undef PostSimulateTouchEvent
 #undef PostBKSTouchEventPhase
 
-NSString *KimiRunTouchPrefString(NSString *key) {
-    return KimiRunPrefString(key);
-}
-
-BOOL KimiRunTouchPrefBool(NSString *key, BOOL defaultValue) {
-    return KimiRunPrefBool(key, defaultValue);
-}
-
-BOOL KimiRunTouchEnvBool(const char *key, BOOL defaultValue) {
-    return KimiRunEnvBool(key, defaultValue);
-}
-
 NSString *KimiRunResolveTouchMethod(NSString *method) {
     return KimiRunResolveMethod(method);
 }
@@ -268,3 +359,146 @@ BOOL KimiRunDispatchPhase(KimiRunTouchPhase phase,
                           BOOL allowFallback) {
     return DispatchPhaseWithOptions(phase, x, y, wantSim, wantConn, wantLegacy, wantBKS, wantAX, allowFallback);
 }
+
+NSString *KimiRunTouchBackendName(KimiRunTouchBackend backend) {
+    switch (backend) {
+        case KimiRunTouchBackendBKS: return @"bks";
+        case KimiRunTouchBackendSim: return @"sim";
+        case KimiRunTouchBackendConn: return @"conn";
+        case KimiRunTouchBackendLegacy: return @"legacy";
+        case KimiRunTouchBackendNone: break;
+    }
+    return @"none";
+}
+
+void KimiRunGestureSessionBegin(KimiRunGestureSession *session,
+                                KimiRunGestureKind gesture,
+                                BOOL wantSim,
+                                BOOL wantConn,
+                                BOOL wantLegacy,
+                                BOOL wantBKS,
+                                BOOL wantAX,
+                                BOOL allowFallback) {
+    if (!session) {
+        return;
+    }
+    memset(session, 0, sizeof(*session));
+    session->gesture = gesture;
+    session->wantSim = wantSim;
+    session->wantConn = wantConn;
+    session->wantLegacy = wantLegacy;
+    session->wantBKS = wantBKS;
+    session->wantAX = wantAX;
+    session->allowFallback = allowFallback;
+    session->latched = KimiRunTouchBackendNone;
+    session->adaptive = KimiRunAdaptiveRoutingEnabled();
+    if (session->adaptive) {
+        NSString *bundle = KimiRunFrontmostBundleIdentifier();
+        strlcpy(session->bundle, bundle.UTF8String ?: "", sizeof(session->bundle));
+    }
+    KimiRunStrategyClearPendingVerification();
+}
+
+BOOL KimiRunGestureSessionDispatch(KimiRunGestureSession *session,
+                                   KimiRunTouchPhase phase,
+                                   CGFloat x,
+                                   CGFloat y) {
+    if (!session) {
+        return NO;
+    }
+    return DispatchSessionPhase(session, phase, x, y);
+}
+
+static NSString *KimiRunGestureKindName(KimiRunGestureKind gesture) {
+    switch (gesture) {
+        case KimiRunGestureKindSwipe: return @"swipe";
+        case KimiRunGestureKindDrag: return @"drag";
+        case KimiRunGestureKindLongPress: return @"longpress";
+    }
+    return @"gesture";
+}
+
+void KimiRunGestureSessionEnd(KimiRunGestureSession *session) {
+    if (!session || session->phases == 0) {
+        return;
+    }
+    if (session->adaptive && session->latched != KimiRunTouchBackendNone) {
+        os_unfair_lock_lock(&g_strategyLock);
+        g_strategyPending.valid = YES;
+        strlcpy(g_strategyPending.bundle, session->bundle, sizeof(g_strategyPending.bundle));
+        g_strategyPending.gesture = session->gesture;
+        g_strategyPending.backend = session->latched;
+        g_strategyPending.endedAt = CFAbsoluteTimeGetCurrent();
+        os_unfair_lock_unlock(&g_strategyLock);
+    }
+    KimiRunLog([NSString stringWithFormat:@"[Gesture] %@ bundle=%s backend=%@ phases=%u attempts=%u relatches=%u",
+                KimiRunGestureKindName(session->gesture),
+                session->bundle[0] ? session->bundle : "-",
+                KimiRunTouchBackendName(session->latched),
+                session->phases,
+                session->attempts,
+                session->relatches]);
+}
+
+void KimiRunStrategyNoteVerification(BOOL verified) {
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    os_unfair_lock_lock(&g_strategyLock);
+    KimiRunStrategyPending pending = g_strategyPending;
+    g_strategyPending.valid = NO;
+    if (pending.valid && now - pending.endedAt <= kKimiRunStrategyVerificationWindow) {
+        KimiRunStrategyEnsureTableLocked();
+        KimiRunStrategyRecordVerification(&g_strategyTable, pending.bundle, (uint8_t)pending.gesture,
+                                          (uint8_t)pending.backend, verified, now);
+    }
+    os_unfair_lock_unlock(&g_strategyLock);
+}
+
+void KimiRunStrategyClearPendingVerification(void) {
+    os_unfair_lock_lock(&g_strategyLock);
+    g_strategyPending.valid = NO;
+    os_unfair_lock_unlock(&g_strategyLock);
+}
+
+NSArray<NSDictionary *> *KimiRunCopyStrategyStats(NSUInteger limit) {
+    if (limit == 0 || limit > KIMIRUN_STRATEGY_MAX_ENTRIES) {
+        limit = KIMIRUN_STRATEGY_MAX_ENTRIES;
+    }
+    KimiRunStrategyScore *scores = calloc(limit, sizeof(KimiRunStrategyScore));
+    char (*bundles)[KIMIRUN_STRATEGY_BUNDLE_MAX + 1] = calloc(limit, KIMIRUN_STRATEGY_BUNDLE_MAX + 1);
+    if (!scores || !bundles) {
+        free(scores);
+        free(bundles);
+        return @[];
+    }
+    os_unfair_lock_lock(&g_strategyLock);
+    KimiRunStrategyEnsureTableLocked();
+    size_t count = KimiRunStrategySnapshot(&g_strategyTable, CFAbsoluteTimeGetCurrent(), scores, limit);
+    // Score bundles point into the table; copy them before unlocking.
+    for (size_t i = 0; i < count; i++) {
+        strlcpy(bundles[i], scores[i].bundle, sizeof(bundles[i]));
+    }
+    os_unfair_lock_unlock(&g_strategyLock);
+
+    NSMutableArray *rows = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        const KimiRunStrategyScore *score = &scores[i];
+        [rows addObject:@{
+            @"bundle": [NSString stringWithUTF8String:bundles[i]] ?: @"",
+            @"gesture": KimiRunGestureKindName((KimiRunGestureKind)score->gesture),
+            @"backend": KimiRunTouchBackendName((KimiRunTouchBackend)score->backend),
+            @"samples": @(score->samples),
+            @"acceptanceRate": @(score->acceptanceRate),
+            @"verifiedRate": @(score->verifiedRate),
+            @"p50LatencyMS": @(score->p50LatencyMs),
+            @"expectedCostMS": @(score->expectedCostMs),
+            @"ageSeconds": @(score->ageSeconds),
+            @"attempts": @(score->totalAttempts),
+            @"accepts": @(score->totalAccepts),
+            @"verifications": @(score->totalVerifications),
+            @"verified": @(score->totalVerified),
+        }];
+    }
+    free(bundles);
+    free(scores);
+    return rows;
+}
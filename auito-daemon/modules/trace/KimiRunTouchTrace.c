@@ -0,0 +1,228 @@
+//
+//  KimiRunTouchTrace.c
+//  KimiRun - Binary Touch Event Trace
+//
+
+#include "KimiRunTouchTrace.h"
+#include "../touch/KimiRunTouchModel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t KimiRunTouchTraceClockNanos(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static bool KimiRunTouchTraceWriteAll(int fd, const void *bytes, size_t length) {
+    const uint8_t *cursor = (const uint8_t *)bytes;
+    while (length > 0) {
+        ssize_t written = write(fd, cursor, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// Caller holds writer->lock.
+static bool KimiRunTouchTraceFlushLocked(KimiRunTouchTraceWriter *writer) {
+    if (writer->pending == 0) {
+        return true;
+    }
+    size_t bytes = writer->pending * sizeof(KimiRunTouchTraceRecord);
+    if (writer->fd < 0 || !KimiRunTouchTraceWriteAll(writer->fd, writer->buffer, bytes)) {
+        writer->stats.writeErrors++;
+        writer->stats.dropped += writer->pending;
+        writer->pending = 0;
+        return false;
+    }
+    writer->stats.bytesWritten += bytes;
+    writer->pending = 0;
+    return true;
+}
+
+bool KimiRunTouchTraceWriterOpen(KimiRunTouchTraceWriter *writer,
+                                 const char *path,
+                                 uint32_t timebaseNumer,
+                                 uint32_t timebaseDenom,
+                                 uint64_t maxBytes) {
+    if (!writer || !path || path[0] == '\0') {
+        errno = EINVAL;
+        return false;
+    }
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+    pthread_mutex_init(&writer->lock, NULL);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    KimiRunTouchTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = KIMIRUN_TOUCH_TRACE_MAGIC;
+    header.version = KIMIRUN_TOUCH_TRACE_VERSION;
+    header.recordSize = (uint16_t)sizeof(KimiRunTouchTraceRecord);
+    header.timebaseNumer = timebaseNumer ? timebaseNumer : 1;
+    header.timebaseDenom = timebaseDenom ? timebaseDenom : 1;
+    header.createdAtNanos = KimiRunTouchTraceClockNanos(CLOCK_REALTIME);
+    header.pid = (uint32_t)getpid();
+    if (!KimiRunTouchTraceWriteAll(fd, &header, sizeof(header))) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return false;
+    }
+    writer->fd = fd;
+    writer->maxBytes = maxBytes;
+    writer->stats.bytesWritten = sizeof(header);
+    return true;
+}
+
+bool KimiRunTouchTraceWriterAppend(KimiRunTouchTraceWriter *writer, const KimiRunTouchTraceRecord *record) {
+    if (!writer || !record) {
+        return false;
+    }
+    pthread_mutex_lock(&writer->lock);
+    uint64_t projected = writer->stats.bytesWritten +
+                         ((uint64_t)(writer->pending + 1) * sizeof(KimiRunTouchTraceRecord));
+    if (writer->fd < 0 || (writer->maxBytes > 0 && projected > writer->maxBytes)) {
+        writer->stats.dropped++;
+        pthread_mutex_unlock(&writer->lock);
+        return false;
+    }
+
+    KimiRunTouchTraceRecord *slot = &writer->buffer[writer->pending++];
+    *slot = *record;
+    slot->traceNanos = KimiRunTouchTraceClockNanos(CLOCK_MONOTONIC);
+    bool topLevel = (record->kind == KimiRunTouchEventKindSimParent ||
+                     record->kind == KimiRunTouchEventKindLegacyHand);
+    if (record->type == KimiRunTouchTraceRecordEvent && topLevel &&
+        record->phase == KimiRunTouchModelPhaseDown) {
+        writer->gesture++;
+        writer->stats.gestures = writer->gesture;
+    }
+    slot->gesture = writer->gesture;
+    writer->stats.records++;
+
+    bool ok = true;
+    if (writer->pending == KIMIRUN_TOUCH_TRACE_BATCH ||
+        (record->type == KimiRunTouchTraceRecordEvent && record->phase == KimiRunTouchModelPhaseUp)) {
+        ok = KimiRunTouchTraceFlushLocked(writer);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+bool KimiRunTouchTraceWriterFlush(KimiRunTouchTraceWriter *writer) {
+    if (!writer) {
+        return false;
+    }
+    pthread_mutex_lock(&writer->lock);
+    bool ok = KimiRunTouchTraceFlushLocked(writer);
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+void KimiRunTouchTraceWriterClose(KimiRunTouchTraceWriter *writer) {
+    if (!writer) {
+        return;
+    }
+    pthread_mutex_lock(&writer->lock);
+    KimiRunTouchTraceFlushLocked(writer);
+    if (writer->fd >= 0) {
+        close(writer->fd);
+        writer->fd = -1;
+    }
+    pthread_mutex_unlock(&writer->lock);
+}
+
+void KimiRunTouchTraceWriterGetStats(KimiRunTouchTraceWriter *writer, KimiRunTouchTraceStats *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!writer) {
+        return;
+    }
+    pthread_mutex_lock(&writer->lock);
+    *out = writer->stats;
+    pthread_mutex_unlock(&writer->lock);
+}
+
+bool KimiRunTouchTraceReaderOpen(KimiRunTouchTraceReader *reader, const char *path) {
+    if (!reader || !path) {
+        errno = EINVAL;
+        return false;
+    }
+    memset(reader, 0, sizeof(*reader));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    if (fread(&reader->header, sizeof(reader->header), 1, file) != 1 ||
+        reader->header.magic != KIMIRUN_TOUCH_TRACE_MAGIC ||
+        reader->header.version != KIMIRUN_TOUCH_TRACE_VERSION ||
+        reader->header.recordSize != sizeof(KimiRunTouchTraceRecord)) {
+        fclose(file);
+        errno = EINVAL;
+        return false;
+    }
+    reader->file = file;
+    return true;
+}
+
+bool KimiRunTouchTraceReaderNext(KimiRunTouchTraceReader *reader, KimiRunTouchTraceRecord *out) {
+    if (!reader || !reader->file || !out) {
+        return false;
+    }
+    return fread(out, sizeof(*out), 1, reader->file) == 1;
+}
+
+void KimiRunTouchTraceReaderClose(KimiRunTouchTraceReader *reader) {
+    if (reader && reader->file) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+const char *KimiRunTouchTraceBackendName(uint8_t backend) {
+    // Mirrors KimiRunTouchBackendName().
+    switch (backend) {
+        case 1: return "bks";
+        case 2: return "sim";
+        case 3: return "conn";
+        case 4: return "legacy";
+        default: return "none";
+    }
+}
+
+const char *KimiRunTouchTraceKindName(uint8_t kind) {
+    switch (kind) {
+        case KimiRunTouchEventKindSimParent: return "sim_parent";
+        case KimiRunTouchEventKindSimChild: return "sim_child";
+        case KimiRunTouchEventKindLegacyHand: return "legacy_hand";
+        default: return "none";
+    }
+}
+
+const char *KimiRunTouchTracePhaseName(uint8_t phase) {
+    switch (phase) {
+        case KimiRunTouchModelPhaseDown: return "down";
+        case KimiRunTouchModelPhaseMove: return "move";
+        case KimiRunTouchModelPhaseUp: return "up";
+        default: return "?";
+    }
+}
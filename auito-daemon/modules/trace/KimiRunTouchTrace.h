@@ -0,0 +1,150 @@
+//
+//  KimiRunTouchTrace.h
+//  KimiRun - Binary Touch Event Trace
+//
+//  Portable C (pthreads). A trace file is a fixed header followed by
+//  fixed-size records in host byte order: one record per IOHID event the
+//  builder creates, plus a metrics record whenever the interface ->
+//  digitizer transform changes. The writer buffers records and writes them
+//  in batches; appends are serialized by the writer's own mutex.
+//
+//  File layout:
+//    KimiRunTouchTraceHeader                 (32 bytes)
+//    KimiRunTouchTraceRecord * n             (56 bytes each)
+//
+
+#ifndef KIMIRUN_TOUCH_TRACE_H
+#define KIMIRUN_TOUCH_TRACE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIMIRUN_TOUCH_TRACE_MAGIC 0x5454524Bu   // "KRTT" little-endian
+#define KIMIRUN_TOUCH_TRACE_VERSION 1
+#define KIMIRUN_TOUCH_TRACE_BATCH 64             // records buffered before a write
+
+typedef enum {
+    KimiRunTouchTraceRecordEvent = 1,
+    KimiRunTouchTraceRecordMetrics = 2
+} KimiRunTouchTraceRecordType;
+
+// Record flag bits.
+enum {
+    KimiRunTouchTraceFlagInRange = 0x01,
+    KimiRunTouchTraceFlagTouching = 0x02
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t timebaseNumer;      // event timestamps * numer / denom == ns
+    uint32_t timebaseDenom;
+    uint64_t createdAtNanos;     // CLOCK_REALTIME
+    uint32_t pid;
+    uint32_t reserved;
+} KimiRunTouchTraceHeader;
+
+typedef struct {
+    uint64_t traceNanos;         // CLOCK_MONOTONIC when the record was taken
+    uint8_t type;                // KimiRunTouchTraceRecordType
+    uint8_t kind;                // KimiRunTouchEventKind
+    uint8_t phase;               // KimiRunTouchPhase
+    uint8_t fingerIndex;
+    uint8_t backend;             // KimiRunTouchBackend that built the event
+    uint8_t profile;             // KimiRunTouchMaskProfile
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t gesture;            // increments at every top-level down event
+    uint32_t eventMask;
+    union {
+        struct {
+            uint64_t eventTimestamp;   // timestamp stamped on the IOHIDEvent
+            uint64_t senderID;
+            float inputX;              // interface points handed to the builder
+            float inputY;
+            float normX;               // digitizer-normalized coordinates
+            float normY;
+        } event;
+        struct {
+            float a, b, c, d, tx, ty;  // KimiRunTouchTransform
+            float width;               // interface points
+            float height;
+        } metrics;
+    } u;
+} KimiRunTouchTraceRecord;
+
+_Static_assert(sizeof(KimiRunTouchTraceHeader) == 32, "trace header layout");
+_Static_assert(sizeof(KimiRunTouchTraceRecord) == 56, "trace record layout");
+
+typedef struct {
+    uint64_t records;
+    uint64_t bytesWritten;
+    uint64_t dropped;            // over maxBytes or after a write error
+    uint64_t writeErrors;
+    uint32_t gestures;
+} KimiRunTouchTraceStats;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int fd;
+    uint64_t maxBytes;           // 0 == unbounded
+    uint32_t gesture;
+    size_t pending;
+    KimiRunTouchTraceStats stats;
+    KimiRunTouchTraceRecord buffer[KIMIRUN_TOUCH_TRACE_BATCH];
+} KimiRunTouchTraceWriter;
+
+typedef struct {
+    FILE *file;
+    KimiRunTouchTraceHeader header;
+} KimiRunTouchTraceReader;
+
+/**
+ * Truncate/create path and write the header. timebase is what converts
+ * eventTimestamp to nanoseconds (mach_timebase_info on device; 1/1 for
+ * nanosecond clocks). Returns false with errno set on failure.
+ */
+bool KimiRunTouchTraceWriterOpen(KimiRunTouchTraceWriter *writer,
+                                 const char *path,
+                                 uint32_t timebaseNumer,
+                                 uint32_t timebaseDenom,
+                                 uint64_t maxBytes);
+
+/**
+ * Append one record. traceNanos and gesture are filled in by the writer;
+ * a top-level down event (sim parent or legacy hand) starts a new gesture.
+ * Up events flush so a finished gesture is on disk.
+ */
+bool KimiRunTouchTraceWriterAppend(KimiRunTouchTraceWriter *writer, const KimiRunTouchTraceRecord *record);
+
+bool KimiRunTouchTraceWriterFlush(KimiRunTouchTraceWriter *writer);
+
+void KimiRunTouchTraceWriterClose(KimiRunTouchTraceWriter *writer);
+
+void KimiRunTouchTraceWriterGetStats(KimiRunTouchTraceWriter *writer, KimiRunTouchTraceStats *out);
+
+/** Open and validate the header. */
+bool KimiRunTouchTraceReaderOpen(KimiRunTouchTraceReader *reader, const char *path);
+
+/** Next record; false at end of file or on a short read. */
+bool KimiRunTouchTraceReaderNext(KimiRunTouchTraceReader *reader, KimiRunTouchTraceRecord *out);
+
+void KimiRunTouchTraceReaderClose(KimiRunTouchTraceReader *reader);
+
+const char *KimiRunTouchTraceBackendName(uint8_t backend);
+const char *KimiRunTouchTraceKindName(uint8_t kind);
+const char *KimiRunTouchTracePhaseName(uint8_t phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,334 @@
+//
+//  kimirun_a11y_diff.c
+//  KimiRun - Accessibility snapshot delta check / benchmark
+//
+//  Host-side tool (not part of the theos targets) for the portable
+//  KimiRunA11ySnapshot store:
+//    check  mutates synthetic element lists (field edits, inserts,
+//           removals, moves, duplicate keys) and verifies that applying
+//           each delta to the older list rebuilds the newer one exactly,
+//           the way an /a11y/interactive?since= client would
+//    bench  times commit + diff for lists of -e elements with a few
+//           changes per step and reports the delta size against the list
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_a11y_diff.c modules/accessibility/KimiRunA11ySnapshot.c
+//       -o kimirun_a11y_diff
+//
+//  Usage:
+//    kimirun_a11y_diff check [-n iterations] [-e elements] [-s seed]
+//    kimirun_a11y_diff bench [-n iterations] [-e elements]
+//
+//  Exit status: 0 clean, 1 invariant failures, 2 usage error.
+//
+
+#include "accessibility/KimiRunA11ySnapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kDiffMaxElements 4096
+
+static size_t g_failures = 0;
+
+static uint64_t DiffNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t DiffRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+static void DiffFail(uint64_t iteration, const char *what) {
+    if (g_failures < 20) {
+        fprintf(stderr, "FAIL iteration %llu: %s\n", (unsigned long long)iteration, what);
+    }
+    g_failures++;
+}
+
+// One edit step: field changes, removals, inserts and an occasional move,
+// with identities drawn so that some keys repeat.
+static uint32_t DiffMutate(const KimiRunA11yEntry *from, uint32_t count, KimiRunA11yEntry *to,
+                           uint32_t limit, uint64_t *nextIdentity, uint64_t *rng) {
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < count && out < limit; i++) {
+        uint32_t roll = DiffRandom(rng) % 100;
+        if (roll < 3) {
+            continue;
+        }
+        if (roll < 6 && out < limit) {
+            to[out].key = KimiRunA11yHashU64(KIMIRUN_A11Y_HASH_SEED, (*nextIdentity)++);
+            to[out].hash = DiffRandom(rng);
+            out++;
+            if (out >= limit) {
+                break;
+            }
+        }
+        to[out] = from[i];
+        if (roll >= 6 && roll < 12) {
+            to[out].hash = DiffRandom(rng);
+        }
+        out++;
+    }
+    if (out > 1 && DiffRandom(rng) % 4 == 0) {
+        uint32_t a = DiffRandom(rng) % out;
+        uint32_t b = DiffRandom(rng) % out;
+        KimiRunA11yEntry swap = to[a];
+        to[a] = to[b];
+        to[b] = swap;
+    }
+    if (out > 0 && out < limit && DiffRandom(rng) % 8 == 0) {
+        // A second element with the same identity (e.g. two identical cells).
+        to[out] = to[DiffRandom(rng) % out];
+        to[out].hash ^= 1;
+        out++;
+    }
+    return out;
+}
+
+static int DiffFindKey(const KimiRunA11yEntry *entries, uint32_t count, uint64_t key) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (entries[i].key == key) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Client side: rebuild the latest list from the previous one and a delta.
+static bool DiffApply(const KimiRunA11yEntry *old, uint32_t oldCount,
+                      const KimiRunA11yEntry *latest, uint32_t latestCount,
+                      const KimiRunA11yDelta *delta, KimiRunA11yEntry *rebuilt) {
+    static KimiRunA11yEntry survivors[kDiffMaxElements];
+    static bool filled[kDiffMaxElements];
+    uint32_t survivorCount = 0;
+    for (uint32_t i = 0; i < oldCount; i++) {
+        bool removed = false;
+        for (uint32_t r = 0; r < delta->removedCount; r++) {
+            if (delta->removed[r] == old[i].key) {
+                removed = true;
+                break;
+            }
+        }
+        if (!removed) {
+            survivors[survivorCount++] = old[i];
+        }
+    }
+    if (survivorCount + delta->addedCount != latestCount) {
+        return false;
+    }
+    memset(filled, 0, latestCount * sizeof(filled[0]));
+    // The server sends the elements themselves; the latest list stands in.
+    for (uint32_t i = 0; i < delta->addedCount; i++) {
+        rebuilt[delta->added[i]] = latest[delta->added[i]];
+        filled[delta->added[i]] = true;
+    }
+    if (delta->orderChanged) {
+        // "order" carries every key of the latest list.
+        for (uint32_t i = 0; i < latestCount; i++) {
+            if (filled[i]) {
+                continue;
+            }
+            int found = DiffFindKey(survivors, survivorCount, latest[i].key);
+            if (found < 0) {
+                return false;
+            }
+            rebuilt[i] = survivors[found];
+        }
+    } else {
+        for (uint32_t i = 0, s = 0; i < latestCount; i++) {
+            if (!filled[i]) {
+                rebuilt[i] = survivors[s++];
+            }
+        }
+    }
+    for (uint32_t i = 0; i < delta->changedCount; i++) {
+        uint32_t index = delta->changed[i];
+        if (index >= latestCount || filled[index]) {
+            return false;
+        }
+        rebuilt[index].hash = latest[index].hash;
+    }
+    return true;
+}
+
+static int DiffCheck(uint64_t iterations, uint32_t elements, uint64_t seed) {
+    static KimiRunA11yEntry lists[KIMIRUN_A11Y_DEFAULT_HISTORY + 2][kDiffMaxElements];
+    static uint32_t counts[KIMIRUN_A11Y_DEFAULT_HISTORY + 2];
+    static uint64_t sequences[KIMIRUN_A11Y_DEFAULT_HISTORY + 2];
+    static KimiRunA11yEntry rebuilt[kDiffMaxElements];
+    const uint32_t ring = KIMIRUN_A11Y_DEFAULT_HISTORY + 2;
+    uint64_t rng = seed ? seed : 0x9e3779b97f4a7c15ULL;
+    uint64_t nextIdentity = 1;
+    size_t fullCount = 0, emptyCount = 0, reordered = 0;
+
+    KimiRunA11yStore *store = KimiRunA11yStoreCreate(0);
+    if (!store) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < elements; i++) {
+        lists[0][i].key = KimiRunA11yHashU64(KIMIRUN_A11Y_HASH_SEED, nextIdentity++);
+        lists[0][i].hash = DiffRandom(&rng);
+    }
+    counts[0] = elements;
+    sequences[0] = KimiRunA11yStoreCommit(store, lists[0], counts[0], NULL);
+
+    for (uint64_t it = 1; it <= iterations; it++) {
+        uint32_t prev = (uint32_t)((it - 1) % ring);
+        uint32_t cur = (uint32_t)(it % ring);
+        if (DiffRandom(&rng) % 16 == 0) {
+            memcpy(lists[cur], lists[prev], counts[prev] * sizeof(KimiRunA11yEntry));
+            counts[cur] = counts[prev];
+        } else {
+            counts[cur] = DiffMutate(lists[prev], counts[prev], lists[cur], kDiffMaxElements,
+                                     &nextIdentity, &rng);
+        }
+        bool changed = false;
+        sequences[cur] = KimiRunA11yStoreCommit(store, lists[cur], counts[cur], &changed);
+        if (sequences[cur] == 0) {
+            DiffFail(it, "commit failed");
+            continue;
+        }
+        bool same = counts[cur] == counts[prev] &&
+            memcmp(lists[cur], lists[prev], counts[cur] * sizeof(KimiRunA11yEntry)) == 0;
+        if (changed == same || (same && sequences[cur] != sequences[prev])) {
+            DiffFail(it, "sequence does not track changes");
+        }
+        for (uint32_t i = 0; i < counts[cur]; i++) {
+            if (DiffFindKey(lists[cur], i, lists[cur][i].key) >= 0) {
+                DiffFail(it, "duplicate key after commit");
+                break;
+            }
+        }
+
+        // Diff from a random older snapshot, some of which have been evicted.
+        uint32_t back = DiffRandom(&rng) % (it < ring ? (uint32_t)it + 1 : ring);
+        uint32_t from = (uint32_t)((it - back) % ring);
+        KimiRunA11yDelta delta;
+        if (!KimiRunA11yStoreDiff(store, sequences[from], &delta)) {
+            DiffFail(it, "diff failed");
+            continue;
+        }
+        bool held = KimiRunA11yStoreSequence(store) - sequences[from] < KIMIRUN_A11Y_DEFAULT_HISTORY;
+        if (delta.full) {
+            fullCount++;
+            if (held) {
+                DiffFail(it, "full delta for a held snapshot");
+            }
+        } else if (!held) {
+            DiffFail(it, "delta for an evicted snapshot");
+        } else if (sequences[from] == sequences[cur]) {
+            emptyCount++;
+            if (delta.addedCount || delta.changedCount || delta.removedCount || delta.orderChanged) {
+                DiffFail(it, "non-empty delta against the latest snapshot");
+            }
+        } else {
+            reordered += delta.orderChanged;
+            if (!DiffApply(lists[from], counts[from], lists[cur], counts[cur], &delta, rebuilt) ||
+                memcmp(rebuilt, lists[cur], counts[cur] * sizeof(KimiRunA11yEntry)) != 0) {
+                DiffFail(it, "delta does not rebuild the latest list");
+            }
+        }
+        KimiRunA11yDeltaFree(&delta);
+    }
+    KimiRunA11yStoreDestroy(store);
+    printf("check iterations %llu (%u elements)\n", (unsigned long long)iterations, elements);
+    printf("full/empty/reordered  %zu / %zu / %zu\n", fullCount, emptyCount, reordered);
+    printf("failures         %zu\n", g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static int DiffBench(uint64_t iterations, uint32_t elements) {
+    static KimiRunA11yEntry lists[2][kDiffMaxElements];
+    uint64_t rng = 0x2545f4914f6cdd1dULL;
+    uint64_t nextIdentity = 1;
+    for (uint32_t i = 0; i < elements; i++) {
+        lists[0][i].key = KimiRunA11yHashU64(KIMIRUN_A11Y_HASH_SEED, nextIdentity++);
+        lists[0][i].hash = DiffRandom(&rng);
+    }
+    uint32_t counts[2] = { elements, 0 };
+    KimiRunA11yStore *store = KimiRunA11yStoreCreate(0);
+    if (!store) {
+        return 1;
+    }
+    uint64_t previous = KimiRunA11yStoreCommit(store, lists[0], counts[0], NULL);
+    uint64_t commitNanos = 0, diffNanos = 0, deltaEntries = 0, listEntries = 0;
+    for (uint64_t it = 1; it <= iterations; it++) {
+        uint32_t prev = (uint32_t)((it - 1) & 1);
+        uint32_t cur = (uint32_t)(it & 1);
+        // A handful of edits per step, as with a live screen.
+        memcpy(lists[cur], lists[prev], counts[prev] * sizeof(KimiRunA11yEntry));
+        counts[cur] = counts[prev];
+        for (int edit = 0; edit < 3 && counts[cur] > 0; edit++) {
+            lists[cur][DiffRandom(&rng) % counts[cur]].hash = DiffRandom(&rng);
+        }
+
+        uint64_t start = DiffNowNanos();
+        uint64_t sequence = KimiRunA11yStoreCommit(store, lists[cur], counts[cur], NULL);
+        uint64_t committed = DiffNowNanos();
+        KimiRunA11yDelta delta;
+        bool ok = KimiRunA11yStoreDiff(store, previous, &delta);
+        diffNanos += DiffNowNanos() - committed;
+        commitNanos += committed - start;
+        if (ok) {
+            deltaEntries += delta.addedCount + delta.changedCount + delta.removedCount;
+            KimiRunA11yDeltaFree(&delta);
+        }
+        listEntries += counts[cur];
+        previous = sequence;
+    }
+    KimiRunA11yStoreDestroy(store);
+    printf("bench iterations %llu (%u elements)\n", (unsigned long long)iterations, elements);
+    printf("commit           %.2f us\n", iterations ? (double)commitNanos / 1e3 / (double)iterations : 0.0);
+    printf("diff             %.2f us\n", iterations ? (double)diffNanos / 1e3 / (double)iterations : 0.0);
+    printf("delta/list       %.2f%% of elements sent\n",
+           listEntries ? 100.0 * (double)deltaEntries / (double)listEntries : 0.0);
+    return 0;
+}
+
+static void DiffUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check [-n iterations] [-e elements] [-s seed]\n", argv0);
+    fprintf(stderr, "       %s bench [-n iterations] [-e elements]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        DiffUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    uint32_t elements = 500;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:e:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 'e': elements = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                DiffUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (elements == 0 || elements > kDiffMaxElements / 2) {
+        fprintf(stderr, "elements must be 1..%d\n", kDiffMaxElements / 2);
+        return 2;
+    }
+    if (strcmp(mode, "check") == 0) {
+        return DiffCheck(iterations ? iterations : 20000, elements, seed);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return DiffBench(iterations ? iterations : 20000, elements);
+    }
+    DiffUsage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,388 @@
+//
+//  kimirun_a11y_encode_bench.c
+//  KimiRun - Interactive element encoding benchmark
+//
+//  Host-side tool (not part of the theos targets) for KimiRunA11yEncode.
+//  Builds a realistic interactive-element set (a Settings-like list:
+//  cells, labels, switches, nav/tab buttons, a search field; fractional
+//  frames; stable keys) and compares, per encoding, the payload size and
+//  the encode time:
+//    legacy-pretty   the row dictionaries as NSJSONSerialization writes
+//                    them with NSJSONWritingPrettyPrinted (emulated here)
+//    legacy-compact  the same without whitespace (?compact=1)
+//    min / columnar / msgpack   KimiRunA11yEncode
+//  The msgpack payload is decoded again and checked field by field.
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_a11y_encode_bench.c modules/accessibility/KimiRunA11yEncode.c
+//       -lm -o kimirun_a11y_encode_bench
+//
+//  Usage:
+//    kimirun_a11y_encode_bench [-e elements] [-n iterations] [-s seed]
+//
+//  Exit status: 0 clean, 1 round-trip failures, 2 usage error.
+//
+
+#include "accessibility/KimiRunA11yEncode.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kBenchMaxElements 4096
+
+static size_t g_failures = 0;
+
+static uint64_t BenchNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t BenchRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+typedef struct {
+    const char *type;
+    const char *className;
+    uint64_t traits;
+    int textKind;                  // 0 none, 1 text, 2 text + placeholder
+} BenchKind;
+
+static const BenchKind kBenchKinds[] = {
+    { "Cell", "PSTableCell", 0, 0 },
+    { "Cell", "PSTableCell", 0, 0 },
+    { "Cell", "PSSwitchTableCell", 0, 0 },
+    { "Button", "UIButton", 1, 1 },
+    { "StaticText", "UILabel", 64, 1 },
+    { "StaticText", "UILabel", 64, 1 },
+    { "Button", "UITabBarButton", 1 | 8, 0 },
+    { "Button", "_UIButtonBarButton", 1, 0 },
+    { "SearchField", "UISearchBarTextField", 1024, 2 },
+    { "Other", "UISwitch", 0, 0 },
+    { "Header", "UITableViewHeaderFooterView", 65536, 0 },
+    { "Image", "UIImageView", 4, 0 },
+};
+
+static const char *const kBenchWords[] = {
+    "General", "Wi-Fi", "Bluetooth", "Cellular", "Personal Hotspot", "Notifications",
+    "Sounds & Haptics", "Focus", "Screen Time", "Control Centre", "Display & Brightness",
+    "Home Screen", "Accessibility", "Wallpaper", "Siri & Search", "Face ID & Passcode",
+    "Emergency SOS", "Exposure Notifications", "Battery", "Privacy & Security",
+    "App Store", "Wallet & Apple Pay", "Passwords", "Mail", "Contacts", "Calendar",
+};
+
+static const char *const kBenchValues[] = { "", "", "", "On", "Off", "Not Connected", "1", "Automatic" };
+
+typedef struct {
+    KimiRunA11yElement elements[kBenchMaxElements];
+    char strings[kBenchMaxElements][3][48];
+    size_t count;
+} BenchSet;
+
+static void BenchBuildSet(BenchSet *set, size_t count, uint64_t seed) {
+    uint64_t rng = seed ? seed : 0x9e3779b97f4a7c15ULL;
+    const size_t kinds = sizeof(kBenchKinds) / sizeof(kBenchKinds[0]);
+    const size_t words = sizeof(kBenchWords) / sizeof(kBenchWords[0]);
+    const size_t values = sizeof(kBenchValues) / sizeof(kBenchValues[0]);
+    set->count = count;
+    for (size_t i = 0; i < count; i++) {
+        KimiRunA11yElement *e = &set->elements[i];
+        const BenchKind *kind = &kBenchKinds[BenchRandom(&rng) % kinds];
+        memset(e, 0, sizeof(*e));
+        e->type = kind->type;
+        e->className = kind->className;
+        e->traits = kind->traits;
+        snprintf(set->strings[i][0], sizeof(set->strings[i][0]), "%s",
+                 kBenchWords[BenchRandom(&rng) % words]);
+        e->label = set->strings[i][0];
+        if (BenchRandom(&rng) % 4 == 0) {
+            snprintf(set->strings[i][1], sizeof(set->strings[i][1]), "com.apple.settings.row.%zu", i);
+            e->identifier = set->strings[i][1];
+        } else {
+            e->identifier = "";
+        }
+        e->value = kBenchValues[BenchRandom(&rng) % values];
+        e->hint = (BenchRandom(&rng) % 10 == 0) ? "Double tap to open." : "";
+        if (kind->textKind >= 1) {
+            e->text = e->label;
+        }
+        if (kind->textKind == 2) {
+            snprintf(set->strings[i][2], sizeof(set->strings[i][2]), "Search");
+            e->placeholder = set->strings[i][2];
+        }
+        // Rows of a grouped list at @3x: thirds of a point are common.
+        float row = (float)(i % 18);
+        e->x = (BenchRandom(&rng) % 3 == 0) ? 20.0f : 16.0f + (float)(BenchRandom(&rng) % 3) / 3.0f;
+        e->y = 91.0f + row * 44.333332f;
+        e->width = 358.0f - (e->x - 16.0f) * 2.0f;
+        e->height = (BenchRandom(&rng) % 5 == 0) ? 52.666668f : 44.0f;
+        e->flags = KimiRunA11yFlagEnabled | KimiRunA11yFlagVisible;
+        if (BenchRandom(&rng) % 20 == 0) {
+            e->flags &= (uint8_t)~KimiRunA11yFlagEnabled;
+        }
+        e->key = ((uint64_t)BenchRandom(&rng) << 32) | BenchRandom(&rng);
+    }
+}
+
+// The dictionary AccessibilityTree builds per element, written the way
+// NSJSONSerialization does: full double precision, traits as names,
+// bounds as a dictionary, rect string and center duplicating it.
+static const struct {
+    uint64_t bit;
+    const char *name;
+} kBenchTraitNames[] = {
+    { 1, "Button" }, { 2, "Link" }, { 1024, "SearchField" }, { 4, "Image" }, { 8, "Selected" },
+    { 256, "NotEnabled" }, { 64, "StaticText" }, { 65536, "Header" }, { 4096, "Adjustable" },
+};
+
+typedef struct {
+    char *bytes;
+    size_t length;
+    size_t capacity;
+} BenchText;
+
+static void BenchAppend(BenchText *text, const char *bytes, size_t length) {
+    if (text->length + length > text->capacity) {
+        size_t capacity = text->capacity ? text->capacity : 4096;
+        while (capacity < text->length + length) {
+            capacity *= 2;
+        }
+        text->bytes = realloc(text->bytes, capacity);
+        if (!text->bytes) {
+            abort();
+        }
+        text->capacity = capacity;
+    }
+    memcpy(text->bytes + text->length, bytes, length);
+    text->length += length;
+}
+
+__attribute__((format(printf, 2, 3)))
+static void BenchAppendf(BenchText *text, const char *format, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n > 0) {
+        BenchAppend(text, line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    }
+}
+
+static const char *BenchNumber(double value, char *buffer, size_t size) {
+    if (value == floor(value) && fabs(value) < 1e15) {
+        snprintf(buffer, size, "%.0f", value);
+    } else {
+        snprintf(buffer, size, "%.17g", value);
+    }
+    return buffer;
+}
+
+static void BenchLegacyString(BenchText *text, const char *value) {
+    BenchAppend(text, "\"", 1);
+    BenchAppend(text, value ? value : "", value ? strlen(value) : 0);
+    BenchAppend(text, "\"", 1);
+}
+
+static void BenchEncodeLegacy(const BenchSet *set, bool pretty, BenchText *out) {
+    const char *nl = pretty ? "\n" : "";
+    const char *in1 = pretty ? "  " : "";
+    const char *in2 = pretty ? "    " : "";
+    const char *in3 = pretty ? "      " : "";
+    const char *sep = pretty ? " : " : ":";
+    char a[40], b[40], c[40], d[40];
+    out->length = 0;
+    BenchAppendf(out, "[%s", nl);
+    for (size_t i = 0; i < set->count; i++) {
+        const KimiRunA11yElement *e = &set->elements[i];
+        double x = e->x, y = e->y, w = e->width, h = e->height;
+        BenchAppendf(out, "%s{%s", in1, nl);
+#define BENCH_FIELD(name) BenchAppendf(out, "%s\"%s\"%s", in2, name, sep)
+        BENCH_FIELD("type"); BenchLegacyString(out, e->type); BenchAppendf(out, ",%s", nl);
+        BENCH_FIELD("className"); BenchLegacyString(out, e->className); BenchAppendf(out, ",%s", nl);
+        BENCH_FIELD("label"); BenchLegacyString(out, e->label); BenchAppendf(out, ",%s", nl);
+        BENCH_FIELD("identifier"); BenchLegacyString(out, e->identifier); BenchAppendf(out, ",%s", nl);
+        BENCH_FIELD("value"); BenchLegacyString(out, e->value); BenchAppendf(out, ",%s", nl);
+        BENCH_FIELD("hint"); BenchLegacyString(out, e->hint); BenchAppendf(out, ",%s", nl);
+        BENCH_FIELD("traits");
+        BenchAppendf(out, "[%s", nl);
+        bool first = true;
+        for (size_t t = 0; t < sizeof(kBenchTraitNames) / sizeof(kBenchTraitNames[0]); t++) {
+            if (e->traits & kBenchTraitNames[t].bit) {
+                BenchAppendf(out, "%s%s\"%s\"", first ? "" : pretty ? ",\n" : ",", in3, kBenchTraitNames[t].name);
+                first = false;
+            }
+        }
+        BenchAppendf(out, "%s%s],%s", first ? "" : nl, first ? "" : in2, nl);
+        BENCH_FIELD("bounds");
+        BenchAppendf(out, "{%s%s\"x\"%s%s,%s%s\"y\"%s%s,%s%s\"width\"%s%s,%s%s\"height\"%s%s%s%s},%s",
+                     nl, in3, sep, BenchNumber(x, a, sizeof(a)), nl,
+                     in3, sep, BenchNumber(y, b, sizeof(b)), nl,
+                     in3, sep, BenchNumber(w, c, sizeof(c)), nl,
+                     in3, sep, BenchNumber(h, d, sizeof(d)), nl, in2, nl);
+        BENCH_FIELD("rect");
+        BenchAppendf(out, "\"%.1f,%.1f,%.1f,%.1f\",%s", x, y, w, h, nl);
+        BENCH_FIELD("center_x"); BenchAppendf(out, "%s,%s", BenchNumber(x + w / 2, a, sizeof(a)), nl);
+        BENCH_FIELD("center_y"); BenchAppendf(out, "%s,%s", BenchNumber(y + h / 2, a, sizeof(a)), nl);
+        BENCH_FIELD("enabled"); BenchAppendf(out, "%s,%s", (e->flags & KimiRunA11yFlagEnabled) ? "true" : "false", nl);
+        BENCH_FIELD("visible"); BenchAppendf(out, "%s,%s", (e->flags & KimiRunA11yFlagVisible) ? "true" : "false", nl);
+        if (e->text) {
+            BENCH_FIELD("text"); BenchLegacyString(out, e->text); BenchAppendf(out, ",%s", nl);
+        }
+        if (e->placeholder) {
+            BENCH_FIELD("placeholder"); BenchLegacyString(out, e->placeholder); BenchAppendf(out, ",%s", nl);
+        }
+        BENCH_FIELD("key"); BenchAppendf(out, "\"%016llx\",%s", (unsigned long long)e->key, nl);
+        BENCH_FIELD("index"); BenchAppendf(out, "%zu%s", i, nl);
+#undef BENCH_FIELD
+        BenchAppendf(out, "%s}%s%s", in1, i + 1 < set->count ? "," : "", nl);
+    }
+    BenchAppend(out, "]", 1);
+}
+
+static bool BenchSameString(const char *a, const char *b, bool optional) {
+    if (optional && (!a || !b)) {
+        return a == b;
+    }
+    return strcmp(a ? a : "", b ? b : "") == 0;
+}
+
+static void BenchCheckRoundTrip(const BenchSet *set, const KimiRunA11yBuffer *msgpack) {
+    KimiRunA11yDecoded decoded;
+    if (!KimiRunA11yDecodeMsgPack(msgpack->bytes, msgpack->length, &decoded)) {
+        fprintf(stderr, "FAIL msgpack payload does not decode\n");
+        g_failures++;
+        return;
+    }
+    if (decoded.count != set->count) {
+        fprintf(stderr, "FAIL decoded %zu elements, encoded %zu\n", decoded.count, set->count);
+        g_failures++;
+    }
+    for (size_t i = 0; i < decoded.count && i < set->count; i++) {
+        const KimiRunA11yElement *a = &set->elements[i];
+        const KimiRunA11yElement *b = &decoded.elements[i];
+        bool same = BenchSameString(a->type, b->type, false) &&
+            BenchSameString(a->className, b->className, false) &&
+            BenchSameString(a->label, b->label, false) &&
+            BenchSameString(a->identifier, b->identifier, false) &&
+            BenchSameString(a->value, b->value, false) &&
+            BenchSameString(a->hint, b->hint, false) &&
+            BenchSameString(a->text, b->text, true) &&
+            BenchSameString(a->placeholder, b->placeholder, true) &&
+            a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height &&
+            a->traits == b->traits && a->flags == b->flags && a->key == b->key;
+        if (!same) {
+            if (g_failures < 10) {
+                fprintf(stderr, "FAIL element %zu differs after msgpack round trip\n", i);
+            }
+            g_failures++;
+        }
+    }
+    KimiRunA11yDecodedFree(&decoded);
+
+    // Every truncation must be rejected cleanly.
+    for (size_t cut = 0; cut < msgpack->length; cut += 1 + msgpack->length / 512) {
+        if (KimiRunA11yDecodeMsgPack(msgpack->bytes, cut, &decoded)) {
+            fprintf(stderr, "FAIL truncated payload (%zu of %zu bytes) decoded\n", cut, msgpack->length);
+            g_failures++;
+            KimiRunA11yDecodedFree(&decoded);
+        }
+    }
+}
+
+static int BenchCompare(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void BenchReport(const char *name, size_t bytes, size_t baseline, uint64_t *samples, size_t n) {
+    qsort(samples, n, sizeof(samples[0]), BenchCompare);
+    printf("%-16s %9zu B  %5.1f%%  %8.1f us  %8.1f us\n", name, bytes,
+           baseline ? 100.0 * (double)bytes / (double)baseline : 0.0,
+           (double)samples[n / 2] / 1e3, (double)samples[(n * 99) / 100] / 1e3);
+}
+
+int main(int argc, char **argv) {
+    size_t count = 300;
+    size_t iterations = 2000;
+    uint64_t seed = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "e:n:s:h")) != -1) {
+        switch (opt) {
+            case 'e': count = strtoul(optarg, NULL, 10); break;
+            case 'n': iterations = strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-e elements] [-n iterations] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (count == 0 || count > kBenchMaxElements || iterations == 0) {
+        fprintf(stderr, "elements must be 1..%d, iterations > 0\n", kBenchMaxElements);
+        return 2;
+    }
+
+    static BenchSet set;
+    BenchBuildSet(&set, count, seed);
+    uint64_t *samples = calloc(iterations, sizeof(*samples));
+    if (!samples) {
+        return 1;
+    }
+
+    printf("%zu elements, %zu iterations\n", count, iterations);
+    printf("%-16s %11s  %6s  %11s  %11s\n", "encoding", "bytes", "size", "p50", "p99");
+
+    BenchText legacy = { 0 };
+    size_t baseline = 0;
+    for (int pretty = 1; pretty >= 0; pretty--) {
+        for (size_t i = 0; i < iterations; i++) {
+            uint64_t start = BenchNowNanos();
+            BenchEncodeLegacy(&set, pretty, &legacy);
+            samples[i] = BenchNowNanos() - start;
+        }
+        if (pretty) {
+            baseline = legacy.length;
+        }
+        BenchReport(pretty ? "legacy-pretty" : "legacy-compact", legacy.length, baseline, samples, iterations);
+    }
+    free(legacy.bytes);
+
+    static const struct {
+        const char *name;
+        KimiRunA11yFormat format;
+    } kFormats[] = {
+        { "min", KimiRunA11yFormatMin },
+        { "columnar", KimiRunA11yFormatColumnar },
+        { "msgpack", KimiRunA11yFormatMsgPack },
+    };
+    for (size_t f = 0; f < sizeof(kFormats) / sizeof(kFormats[0]); f++) {
+        KimiRunA11yBuffer buffer = { 0 };
+        for (size_t i = 0; i < iterations; i++) {
+            buffer.length = 0;
+            uint64_t start = BenchNowNanos();
+            if (!KimiRunA11yEncode(kFormats[f].format, set.elements, set.count, &buffer)) {
+                fprintf(stderr, "FAIL %s encode\n", kFormats[f].name);
+                g_failures++;
+                break;
+            }
+            samples[i] = BenchNowNanos() - start;
+        }
+        BenchReport(kFormats[f].name, buffer.length, baseline, samples, iterations);
+        if (kFormats[f].format == KimiRunA11yFormatMsgPack) {
+            BenchCheckRoundTrip(&set, &buffer);
+        }
+        KimiRunA11yBufferFree(&buffer);
+    }
+    free(samples);
+    printf("failures         %zu\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,677 @@
+//
+//  kimirun_a11y_json_stream.c
+//  KimiRun - Streaming JSON writer check / benchmark
+//
+//  Host-side tool (not part of the theos targets) for KimiRunA11yJSONStream:
+//    check  random documents (nested objects and arrays, strings with
+//           quotes, control bytes and multi-byte UTF-8, integers, doubles)
+//           written through buffers of 16..80 bytes and through one large
+//           buffer: identical bytes, no flush larger than the buffer, and
+//           the output parses back to the same document; misuse (values
+//           without keys, mismatched closes, two top-level values, nesting
+//           too deep, a failing flush) fails the writer
+//    bench  /uiHierarchy-shaped documents of 200..5000 elements: total
+//           time, time until the first flush, and peak buffer for a 16 KB
+//           streaming buffer against one buffer holding the whole document
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_a11y_json_stream.c modules/accessibility/KimiRunA11yJSONStream.c
+//       -lm -o kimirun_a11y_json_stream
+//
+//  Usage:
+//    kimirun_a11y_json_stream check [-n iterations] [-s seed]
+//    kimirun_a11y_json_stream bench [-n iterations] [-s seed]
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage error.
+//
+
+#include "accessibility/KimiRunA11yJSONStream.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kStreamMaxNodes 512
+#define kStreamMaxString 48
+#define kStreamBenchBuffer (16 * 1024)
+
+static size_t g_failures = 0;
+
+static uint64_t StreamNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t StreamRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+static void StreamFail(uint64_t iteration, const char *what) {
+    if (g_failures < 10) {
+        fprintf(stderr, "iteration %llu: %s\n", (unsigned long long)iteration, what);
+    }
+    g_failures++;
+}
+
+// Growable sink; records the largest single flush.
+typedef struct {
+    char *bytes;
+    size_t length;
+    size_t capacity;
+    size_t largestFlush;
+    uint64_t firstFlushNanos;
+    bool refuse;
+} StreamSink;
+
+static bool StreamSinkFlush(void *context, const char *bytes, size_t length) {
+    StreamSink *sink = context;
+    if (sink->refuse) {
+        return false;
+    }
+    if (!sink->firstFlushNanos) {
+        sink->firstFlushNanos = StreamNowNanos();
+    }
+    if (length > sink->largestFlush) {
+        sink->largestFlush = length;
+    }
+    if (sink->length + length > sink->capacity) {
+        size_t capacity = sink->capacity ? sink->capacity : 4096;
+        while (capacity < sink->length + length) {
+            capacity *= 2;
+        }
+        sink->bytes = realloc(sink->bytes, capacity);
+        sink->capacity = capacity;
+    }
+    memcpy(sink->bytes + sink->length, bytes, length);
+    sink->length += length;
+    return true;
+}
+
+static bool StreamDiscardFlush(void *context, const char *bytes, size_t length) {
+    StreamSink *sink = context;
+    if (!sink->firstFlushNanos) {
+        sink->firstFlushNanos = StreamNowNanos();
+    }
+    if (length > sink->largestFlush) {
+        sink->largestFlush = length;
+    }
+    sink->length += length;
+    (void)bytes;
+    return true;
+}
+
+typedef enum {
+    StreamNodeObject,
+    StreamNodeArray,
+    StreamNodeString,
+    StreamNodeInteger,
+    StreamNodeDouble,
+    StreamNodeBool,
+    StreamNodeNull
+} StreamNodeKind;
+
+typedef struct {
+    StreamNodeKind kind;
+    int parent;
+    int firstChild;
+    int nextSibling;
+    char key[kStreamMaxString];    // member name when the parent is an object
+    size_t keyLength;
+    char text[kStreamMaxString];
+    size_t textLength;
+    int64_t integer;
+    double number;
+} StreamNode;
+
+typedef struct {
+    StreamNode nodes[kStreamMaxNodes];
+    int count;
+} StreamDoc;
+
+static size_t StreamRandomString(uint64_t *rng, char *out, bool allowNul) {
+    static const char *const kPieces[] = {
+        "a", "Z", "0", " ", "\"", "\\", "/", "\n", "\r", "\t", "\x01", "\x1f",
+        "\xc3\xa9", "\xe2\x80\xa8", "\xf0\x9f\x98\x80", "\x7f"
+    };
+    size_t length = 0;
+    uint32_t pieces = StreamRandom(rng) % 12;
+    for (uint32_t i = 0; i < pieces; i++) {
+        const char *piece = kPieces[StreamRandom(rng) % (sizeof(kPieces) / sizeof(kPieces[0]))];
+        size_t n = strlen(piece);
+        if (allowNul && StreamRandom(rng) % 16 == 0) {
+            piece = "\0";
+            n = 1;
+        }
+        if (length + n >= kStreamMaxString) {
+            break;
+        }
+        memcpy(out + length, piece, n);
+        length += n;
+    }
+    out[length] = 0;
+    return length;
+}
+
+static int StreamDocAdd(StreamDoc *doc, int parent, uint64_t *rng, int depth) {
+    if (doc->count == kStreamMaxNodes) {
+        return -1;
+    }
+    int index = doc->count++;
+    StreamNode *node = &doc->nodes[index];
+    memset(node, 0, sizeof(*node));
+    node->parent = parent;
+    node->firstChild = -1;
+    node->nextSibling = -1;
+    if (parent >= 0 && doc->nodes[parent].kind == StreamNodeObject) {
+        // Keys are C strings in the writer's API.
+        node->keyLength = StreamRandomString(rng, node->key, false);
+    }
+    uint32_t roll = StreamRandom(rng) % 10;
+    if (depth < 8 && roll < 3) {
+        node->kind = roll == 0 ? StreamNodeArray : StreamNodeObject;
+        int last = -1;
+        uint32_t children = StreamRandom(rng) % 6;
+        for (uint32_t i = 0; i < children; i++) {
+            int child = StreamDocAdd(doc, index, rng, depth + 1);
+            if (child < 0) {
+                break;
+            }
+            if (last < 0) {
+                doc->nodes[index].firstChild = child;
+            } else {
+                doc->nodes[last].nextSibling = child;
+            }
+            last = child;
+        }
+        return index;
+    }
+    switch (roll) {
+        case 3:
+        case 4:
+            node->kind = StreamNodeString;
+            node->textLength = StreamRandomString(rng, node->text, true);
+            break;
+        case 5:
+            node->kind = StreamNodeInteger;
+            node->integer = (int64_t)(((uint64_t)StreamRandom(rng) << 32) | StreamRandom(rng));
+            break;
+        case 6:
+        case 7: {
+            node->kind = StreamNodeDouble;
+            uint32_t shape = StreamRandom(rng) % 4;
+            double base = (double)(StreamRandom(rng) % 100000) - 50000.0;
+            if (shape == 0) {
+                node->number = base;
+            } else if (shape == 1) {
+                node->number = base / 2.0;
+            } else if (shape == 2) {
+                node->number = base / 3.0;
+            } else {
+                node->number = ldexp(base, (int)(StreamRandom(rng) % 200) - 100);
+            }
+            break;
+        }
+        case 8:
+            node->kind = StreamNodeBool;
+            node->integer = StreamRandom(rng) & 1;
+            break;
+        default:
+            node->kind = StreamNodeNull;
+            break;
+    }
+    return index;
+}
+
+static bool StreamWriteNode(KimiRunA11yJSONStream *stream, const StreamDoc *doc, int index) {
+    const StreamNode *node = &doc->nodes[index];
+    if (node->parent >= 0 && doc->nodes[node->parent].kind == StreamNodeObject &&
+        !KimiRunA11yJSONKey(stream, node->key)) {
+        return false;
+    }
+    switch (node->kind) {
+        case StreamNodeObject:
+        case StreamNodeArray: {
+            bool object = node->kind == StreamNodeObject;
+            if (!(object ? KimiRunA11yJSONBeginObject(stream) : KimiRunA11yJSONBeginArray(stream))) {
+                return false;
+            }
+            for (int child = node->firstChild; child >= 0; child = doc->nodes[child].nextSibling) {
+                if (!StreamWriteNode(stream, doc, child)) {
+                    return false;
+                }
+            }
+            return object ? KimiRunA11yJSONEndObject(stream) : KimiRunA11yJSONEndArray(stream);
+        }
+        case StreamNodeString:
+            return KimiRunA11yJSONString(stream, node->text, node->textLength);
+        case StreamNodeInteger:
+            return KimiRunA11yJSONInteger(stream, node->integer);
+        case StreamNodeDouble:
+            return KimiRunA11yJSONDouble(stream, node->number);
+        case StreamNodeBool:
+            return KimiRunA11yJSONBool(stream, node->integer != 0);
+        case StreamNodeNull:
+            return KimiRunA11yJSONNull(stream);
+    }
+    return false;
+}
+
+typedef struct {
+    const char *p;
+    const char *end;
+} StreamParser;
+
+static void StreamSkipSpace(StreamParser *parser) {
+    while (parser->p < parser->end && (*parser->p == ' ' || *parser->p == '\n')) {
+        parser->p++;
+    }
+}
+
+static bool StreamParseString(StreamParser *parser, char *out, size_t *outLength) {
+    size_t length = 0;
+    if (parser->p >= parser->end || *parser->p != '"') {
+        return false;
+    }
+    parser->p++;
+    while (parser->p < parser->end && *parser->p != '"') {
+        unsigned char c = (unsigned char)*parser->p++;
+        if (c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            if (parser->p >= parser->end) {
+                return false;
+            }
+            char e = *parser->p++;
+            if (e == 'n') c = '\n';
+            else if (e == 'r') c = '\r';
+            else if (e == 't') c = '\t';
+            else if (e == '"' || e == '\\' || e == '/') c = (unsigned char)e;
+            else if (e == 'u') {
+                if (parser->end - parser->p < 4 || parser->p[0] != '0' || parser->p[1] != '0') {
+                    return false;
+                }
+                c = (unsigned char)strtoul((char[]){ parser->p[2], parser->p[3], 0 }, NULL, 16);
+                parser->p += 4;
+            } else {
+                return false;
+            }
+        }
+        if (length + 1 >= kStreamMaxString) {
+            return false;
+        }
+        out[length++] = (char)c;
+    }
+    if (parser->p >= parser->end) {
+        return false;
+    }
+    parser->p++;
+    out[length] = 0;
+    *outLength = length;
+    return true;
+}
+
+// Copies the number at parser->p into token (NUL-terminated) and returns
+// its length, 0 if there is none or it does not fit. The written bytes
+// are not terminated, so strtoll/strtod must not run on them directly.
+static size_t StreamNumberToken(const StreamParser *parser, char *token, size_t capacity) {
+    size_t length = 0;
+    const char *p = parser->p;
+    while (p < parser->end && *p && strchr("0123456789+-.eE", *p)) {
+        if (length + 1 >= capacity) {
+            return 0;
+        }
+        token[length++] = *p++;
+    }
+    token[length] = 0;
+    return length;
+}
+
+static bool StreamParseCompare(StreamParser *parser, const StreamDoc *doc, int index) {
+    const StreamNode *node = &doc->nodes[index];
+    char text[kStreamMaxString];
+    size_t length = 0;
+    StreamSkipSpace(parser);
+    switch (node->kind) {
+        case StreamNodeObject:
+        case StreamNodeArray: {
+            bool object = node->kind == StreamNodeObject;
+            if (parser->p >= parser->end || *parser->p++ != (object ? '{' : '[')) {
+                return false;
+            }
+            for (int child = node->firstChild; child >= 0; child = doc->nodes[child].nextSibling) {
+                if (child != node->firstChild && (parser->p >= parser->end || *parser->p++ != ',')) {
+                    return false;
+                }
+                if (object) {
+                    if (!StreamParseString(parser, text, &length) ||
+                        length != doc->nodes[child].keyLength ||
+                        memcmp(text, doc->nodes[child].key, length) != 0 ||
+                        parser->p >= parser->end || *parser->p++ != ':') {
+                        return false;
+                    }
+                }
+                if (!StreamParseCompare(parser, doc, child)) {
+                    return false;
+                }
+            }
+            return parser->p < parser->end && *parser->p++ == (object ? '}' : ']');
+        }
+        case StreamNodeString:
+            return StreamParseString(parser, text, &length) &&
+                   length == node->textLength && memcmp(text, node->text, length) == 0;
+        case StreamNodeInteger: {
+            char token[32];
+            char *end = NULL;
+            size_t n = StreamNumberToken(parser, token, sizeof(token));
+            long long value = strtoll(token, &end, 10);
+            if (n == 0 || end != token + n || value != node->integer) {
+                return false;
+            }
+            parser->p += n;
+            return true;
+        }
+        case StreamNodeDouble: {
+            char token[32];
+            char *end = NULL;
+            size_t n = StreamNumberToken(parser, token, sizeof(token));
+            double value = strtod(token, &end);
+            if (n == 0 || end != token + n || value != node->number) {
+                return false;
+            }
+            parser->p += n;
+            return true;
+        }
+        case StreamNodeBool: {
+            const char *literal = node->integer ? "true" : "false";
+            size_t n = strlen(literal);
+            if ((size_t)(parser->end - parser->p) < n || memcmp(parser->p, literal, n) != 0) {
+                return false;
+            }
+            parser->p += n;
+            return true;
+        }
+        case StreamNodeNull:
+            if (parser->end - parser->p < 4 || memcmp(parser->p, "null", 4) != 0) {
+                return false;
+            }
+            parser->p += 4;
+            return true;
+    }
+    return false;
+}
+
+static bool StreamWriteDoc(const StreamDoc *doc, size_t capacity, StreamSink *sink, KimiRunA11yJSONStream *stream) {
+    char *buffer = malloc(capacity);
+    KimiRunA11yJSONStreamInit(stream, buffer, capacity, StreamSinkFlush, sink);
+    bool ok = StreamWriteNode(stream, doc, 0) && KimiRunA11yJSONFlush(stream);
+    free(buffer);
+    return ok;
+}
+
+static void StreamCheckMisuse(void) {
+    char buffer[32];
+    StreamSink sink = {0};
+    KimiRunA11yJSONStream stream;
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    KimiRunA11yJSONBeginObject(&stream);
+    if (KimiRunA11yJSONInteger(&stream, 1) || !stream.failed || KimiRunA11yJSONEndObject(&stream)) {
+        StreamFail(0, "value without a key accepted");
+    }
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    KimiRunA11yJSONBeginArray(&stream);
+    if (KimiRunA11yJSONKey(&stream, "k")) {
+        StreamFail(0, "key inside an array accepted");
+    }
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    KimiRunA11yJSONBeginObject(&stream);
+    if (KimiRunA11yJSONEndArray(&stream)) {
+        StreamFail(0, "object closed as an array");
+    }
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    KimiRunA11yJSONBeginObject(&stream);
+    KimiRunA11yJSONKey(&stream, "k");
+    if (KimiRunA11yJSONEndObject(&stream)) {
+        StreamFail(0, "object closed after a dangling key");
+    }
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    KimiRunA11yJSONNull(&stream);
+    if (KimiRunA11yJSONNull(&stream)) {
+        StreamFail(0, "second top-level value accepted");
+    }
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    bool opened = true;
+    for (int i = 0; i <= KIMIRUN_A11Y_JSON_MAX_DEPTH && opened; i++) {
+        opened = KimiRunA11yJSONBeginArray(&stream);
+        if (!opened && i != KIMIRUN_A11Y_JSON_MAX_DEPTH) {
+            StreamFail(0, "nesting failed below the limit");
+        }
+    }
+    if (opened) {
+        StreamFail(0, "nesting past the limit accepted");
+    }
+
+    sink.refuse = true;
+    KimiRunA11yJSONStreamInit(&stream, buffer, sizeof(buffer), StreamSinkFlush, &sink);
+    KimiRunA11yJSONBeginArray(&stream);
+    bool ok = true;
+    for (int i = 0; i < 64 && ok; i++) {
+        ok = KimiRunA11yJSONString(&stream, "refused", 7);
+    }
+    if (ok || KimiRunA11yJSONNull(&stream) || KimiRunA11yJSONFlush(&stream)) {
+        StreamFail(0, "failing flush not reported");
+    }
+
+    KimiRunA11yJSONStreamInit(&stream, buffer, 8, StreamSinkFlush, &sink);
+    if (!stream.failed) {
+        StreamFail(0, "buffer below 16 bytes accepted");
+    }
+    free(sink.bytes);
+}
+
+static int StreamCheck(uint64_t iterations, uint64_t seed) {
+    uint64_t rng = seed ? seed : 0x5eed0050ull;
+    StreamDoc *doc = malloc(sizeof(*doc));
+    StreamCheckMisuse();
+    for (uint64_t iteration = 0; iteration < iterations; iteration++) {
+        doc->count = 0;
+        StreamDocAdd(doc, -1, &rng, 0);
+
+        StreamSink whole = {0};
+        StreamSink chunked = {0};
+        KimiRunA11yJSONStream wholeStream;
+        KimiRunA11yJSONStream chunkedStream;
+        size_t capacity = 16 + StreamRandom(&rng) % 65;
+        if (!StreamWriteDoc(doc, 1 << 20, &whole, &wholeStream) ||
+            !StreamWriteDoc(doc, capacity, &chunked, &chunkedStream)) {
+            StreamFail(iteration, "writer failed");
+        } else if (whole.length != chunked.length || memcmp(whole.bytes, chunked.bytes, whole.length) != 0) {
+            StreamFail(iteration, "chunked output differs");
+        } else if (chunked.largestFlush > capacity) {
+            StreamFail(iteration, "flush larger than the buffer");
+        } else if (chunkedStream.bytes != chunked.length || !chunkedStream.done) {
+            StreamFail(iteration, "byte count or completion wrong");
+        } else {
+            StreamParser parser = { whole.bytes, whole.bytes + whole.length };
+            if (!StreamParseCompare(&parser, doc, 0) || parser.p != parser.end) {
+                StreamFail(iteration, "output does not parse back to the document");
+            }
+        }
+        free(whole.bytes);
+        free(chunked.bytes);
+    }
+    free(doc);
+    printf("check: %llu documents, %zu failures\n", (unsigned long long)iterations, g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static const char *const kBenchTypes[] = { "Cell", "StaticText", "Button", "Switch", "Image", "Other" };
+static const char *const kBenchClasses[] = {
+    "PSTableCell", "UITableViewCellContentView", "UILabel", "UIButton", "UISwitch", "UIImageView"
+};
+
+// One /uiHierarchy element as elementDictForCapture: emits it.
+static void StreamBenchElement(KimiRunA11yJSONStream *stream, uint32_t i) {
+    char label[48];
+    char rect[64];
+    double x = (i % 2) ? 16.0 : 0.0;
+    double y = 97.33333333333333 + 44.0 * (double)i;
+    double width = (i % 2) ? 343.5 : 375.0;
+    double height = 44.0;
+    int labelLength = snprintf(label, sizeof(label), "Settings row %u", i);
+    int rectLength = snprintf(rect, sizeof(rect), "%.1f,%.1f,%.1f,%.1f", x, y, width, height);
+    const char *type = kBenchTypes[i % 6];
+    const char *cls = kBenchClasses[i % 6];
+
+    KimiRunA11yJSONBeginObject(stream);
+    KimiRunA11yJSONKey(stream, "type");
+    KimiRunA11yJSONString(stream, type, strlen(type));
+    KimiRunA11yJSONKey(stream, "className");
+    KimiRunA11yJSONString(stream, cls, strlen(cls));
+    KimiRunA11yJSONKey(stream, "label");
+    KimiRunA11yJSONString(stream, label, (size_t)labelLength);
+    KimiRunA11yJSONKey(stream, "identifier");
+    KimiRunA11yJSONString(stream, "", 0);
+    KimiRunA11yJSONKey(stream, "value");
+    KimiRunA11yJSONString(stream, (i % 3) ? "" : "On", (i % 3) ? 0 : 2);
+    KimiRunA11yJSONKey(stream, "hint");
+    KimiRunA11yJSONString(stream, "", 0);
+    KimiRunA11yJSONKey(stream, "traits");
+    KimiRunA11yJSONBeginArray(stream);
+    KimiRunA11yJSONString(stream, "button", 6);
+    KimiRunA11yJSONEndArray(stream);
+    KimiRunA11yJSONKey(stream, "bounds");
+    KimiRunA11yJSONBeginObject(stream);
+    KimiRunA11yJSONKey(stream, "x");
+    KimiRunA11yJSONDouble(stream, x);
+    KimiRunA11yJSONKey(stream, "y");
+    KimiRunA11yJSONDouble(stream, y);
+    KimiRunA11yJSONKey(stream, "width");
+    KimiRunA11yJSONDouble(stream, width);
+    KimiRunA11yJSONKey(stream, "height");
+    KimiRunA11yJSONDouble(stream, height);
+    KimiRunA11yJSONEndObject(stream);
+    KimiRunA11yJSONKey(stream, "rect");
+    KimiRunA11yJSONString(stream, rect, (size_t)rectLength);
+    KimiRunA11yJSONKey(stream, "center_x");
+    KimiRunA11yJSONDouble(stream, x + width / 2.0);
+    KimiRunA11yJSONKey(stream, "center_y");
+    KimiRunA11yJSONDouble(stream, y + height / 2.0);
+    KimiRunA11yJSONKey(stream, "enabled");
+    KimiRunA11yJSONBool(stream, true);
+    KimiRunA11yJSONKey(stream, "visible");
+    KimiRunA11yJSONBool(stream, true);
+    KimiRunA11yJSONKey(stream, "index");
+    KimiRunA11yJSONUnsigned(stream, i);
+    KimiRunA11yJSONEndObject(stream);
+}
+
+static void StreamBenchDoc(KimiRunA11yJSONStream *stream, uint32_t elements) {
+    KimiRunA11yJSONBeginObject(stream);
+    KimiRunA11yJSONKey(stream, "success");
+    KimiRunA11yJSONBool(stream, true);
+    KimiRunA11yJSONKey(stream, "data");
+    KimiRunA11yJSONBeginObject(stream);
+    KimiRunA11yJSONKey(stream, "type");
+    KimiRunA11yJSONString(stream, "Window", 6);
+    KimiRunA11yJSONKey(stream, "children");
+    KimiRunA11yJSONBeginArray(stream);
+    for (uint32_t i = 0; i < elements; i++) {
+        StreamBenchElement(stream, i);
+    }
+    KimiRunA11yJSONEndArray(stream);
+    KimiRunA11yJSONEndObject(stream);
+    KimiRunA11yJSONEndObject(stream);
+    KimiRunA11yJSONFlush(stream);
+}
+
+static int StreamBench(uint64_t iterations, uint64_t seed) {
+    static const uint32_t kSizes[] = { 200, 1000, 5000 };
+    (void)seed;
+    printf("%-6s %-9s %10s %12s %12s %12s\n", "elems", "mode", "bytes", "total us", "first us", "peak buffer");
+    for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++) {
+        uint32_t elements = kSizes[s];
+        // Size the single buffer from one streamed pass, as a serializer
+        // producing the whole document at once would need.
+        StreamSink probe = {0};
+        char *small = malloc(kStreamBenchBuffer);
+        KimiRunA11yJSONStream stream;
+        KimiRunA11yJSONStreamInit(&stream, small, kStreamBenchBuffer, StreamDiscardFlush, &probe);
+        StreamBenchDoc(&stream, elements);
+        size_t documentBytes = probe.length;
+        char *large = malloc(documentBytes + 16);
+
+        for (int mode = 0; mode < 2; mode++) {
+            bool streamed = mode == 0;
+            uint64_t total = 0;
+            uint64_t first = 0;
+            for (uint64_t i = 0; i < iterations; i++) {
+                StreamSink sink = {0};
+                uint64_t start = StreamNowNanos();
+                KimiRunA11yJSONStreamInit(&stream, streamed ? small : large,
+                                          streamed ? kStreamBenchBuffer : documentBytes + 16,
+                                          StreamDiscardFlush, &sink);
+                StreamBenchDoc(&stream, elements);
+                uint64_t end = StreamNowNanos();
+                total += end - start;
+                first += sink.firstFlushNanos - start;
+                if (sink.length != documentBytes) {
+                    StreamFail(i, "bench document size changed");
+                }
+            }
+            printf("%-6u %-9s %10zu %12.1f %12.1f %12zu\n",
+                   elements, streamed ? "streamed" : "whole", documentBytes,
+                   (double)total / (double)iterations / 1000.0,
+                   (double)first / (double)iterations / 1000.0,
+                   streamed ? (size_t)kStreamBenchBuffer : documentBytes);
+        }
+        free(small);
+        free(large);
+    }
+    return g_failures ? 1 : 0;
+}
+
+static void StreamUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check|bench [-n iterations] [-s seed]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        StreamUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                StreamUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (strcmp(mode, "check") == 0) {
+        return StreamCheck(iterations ? iterations : 5000, seed);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return StreamBench(iterations ? iterations : 200, seed);
+    }
+    StreamUsage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,480 @@
+//
+//  kimirun_a11y_sampler.c
+//  KimiRun - Adaptive hit-test sampling check / benchmark
+//
+//  Host-side tool (not part of the theos targets) for the portable
+//  KimiRunA11ySampler planner, against synthetic screens (nav bar, search
+//  field, list rows with switches and info buttons, icon grids, forms, tab
+//  bar) where a hit test returns the smallest element under the point:
+//    check  budget and stop accounting, every point inside the region,
+//           determinism, uniform screens costing only the coarse grid,
+//           exact seeds finding every element
+//    bench  hit tests issued, elements whose attributes are read, and share
+//           of elements found by the old fixed 6 x 10 grid (which read every
+//           hit), the adaptive planner, and the planner seeded from a
+//           slightly stale snapshot
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_a11y_sampler.c modules/accessibility/KimiRunA11ySampler.c
+//       -lm -o kimirun_a11y_sampler
+//
+//  Usage:
+//    kimirun_a11y_sampler check [-n iterations] [-s seed]
+//    kimirun_a11y_sampler bench [-n iterations] [-s seed]
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage error.
+//
+
+#include "accessibility/KimiRunA11ySampler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kSamplerMaxElements 128
+#define kSamplerScreenWidth 390.0f
+#define kSamplerScreenHeight 844.0f
+
+typedef struct {
+    float x;
+    float y;
+    float width;
+    float height;
+} SamplerRect;
+
+typedef struct {
+    SamplerRect rects[kSamplerMaxElements];
+    uint32_t count;
+} SamplerScreen;
+
+typedef struct {
+    const SamplerScreen *screen;
+    float regionX;
+    float regionY;
+    float regionWidth;
+    float regionHeight;
+    uint32_t calls;
+    uint32_t hits;                 // calls that landed on an element
+    uint32_t stopAfter;            // 0 = never
+    bool outside;                  // a point fell outside the region
+    bool found[kSamplerMaxElements];
+} SamplerContext;
+
+static size_t g_failures = 0;
+
+static uint64_t SamplerNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t SamplerRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+static float SamplerUniform(uint64_t *state, float lo, float hi) {
+    return lo + (hi - lo) * (float)(SamplerRandom(state) & 0xffffff) / (float)0x1000000;
+}
+
+static void SamplerFail(uint64_t iteration, const char *what) {
+    if (g_failures < 20) {
+        fprintf(stderr, "FAIL iteration %llu: %s\n", (unsigned long long)iteration, what);
+    }
+    g_failures++;
+}
+
+static void SamplerAdd(SamplerScreen *screen, float x, float y, float width, float height) {
+    if (screen->count < kSamplerMaxElements) {
+        screen->rects[screen->count++] = (SamplerRect){ x, y, width, height };
+    }
+}
+
+static void SamplerMakeScreen(SamplerScreen *screen, uint64_t *rng) {
+    screen->count = 0;
+    if (SamplerRandom(rng) % 10 < 7) {
+        SamplerAdd(screen, 8.0f, 50.0f, 80.0f, 38.0f);
+    }
+    if (SamplerRandom(rng) % 10 < 6) {
+        SamplerAdd(screen, 322.0f, 50.0f, 60.0f, 38.0f);
+    }
+    float top = 96.0f;
+    if (SamplerRandom(rng) % 10 < 4) {
+        SamplerAdd(screen, 16.0f, top, 358.0f, 36.0f);
+        top += 44.0f;
+    }
+    bool tabBar = SamplerRandom(rng) % 2 == 0;
+    float bottom = tabBar ? 795.0f : kSamplerScreenHeight - 34.0f;
+
+    uint32_t layout = SamplerRandom(rng) % 3;
+    if (layout == 0) {
+        // Grouped list: full-width rows, some with a trailing control.
+        float y = top + 20.0f;
+        while (y < bottom) {
+            float height = SamplerRandom(rng) % 4 == 0 ? 60.0f : 44.0f;
+            if (y + height > bottom) {
+                break;
+            }
+            SamplerAdd(screen, 0.0f, y, kSamplerScreenWidth, height);
+            uint32_t accessory = SamplerRandom(rng) % 10;
+            if (accessory < 3) {
+                SamplerAdd(screen, 323.0f, y + (height - 31.0f) * 0.5f, 51.0f, 31.0f);
+            } else if (accessory < 5) {
+                SamplerAdd(screen, 350.0f, y + (height - 22.0f) * 0.5f, 22.0f, 22.0f);
+            }
+            y += height;
+            if (SamplerRandom(rng) % 5 == 0) {
+                y += 35.0f;
+            }
+        }
+    } else if (layout == 1) {
+        // Icon grid with gaps between icons.
+        for (uint32_t row = 0; row < 6; row++) {
+            for (uint32_t column = 0; column < 4; column++) {
+                if (SamplerRandom(rng) % 8 == 0) {
+                    continue;
+                }
+                float y = top + 20.0f + (float)row * 100.0f;
+                if (y + 64.0f <= bottom) {
+                    SamplerAdd(screen, 27.0f + (float)column * 90.0f, y, 64.0f, 64.0f);
+                }
+            }
+        }
+    } else {
+        // Form: stacked fields and buttons, with small links between.
+        float y = top + 24.0f;
+        while (y < bottom - 60.0f) {
+            uint32_t kind = SamplerRandom(rng) % 3;
+            if (kind == 0) {
+                SamplerAdd(screen, 16.0f, y, 358.0f, 50.0f);
+                y += 50.0f;
+            } else if (kind == 1) {
+                SamplerAdd(screen, 24.0f, y, 342.0f, 44.0f);
+                y += 44.0f;
+            } else {
+                SamplerAdd(screen, SamplerUniform(rng, 16.0f, 240.0f), y, SamplerUniform(rng, 60.0f, 140.0f), 22.0f);
+                y += 22.0f;
+            }
+            y += SamplerUniform(rng, 8.0f, 40.0f);
+        }
+    }
+
+    if (tabBar) {
+        uint32_t items = 4 + SamplerRandom(rng) % 2;
+        float width = kSamplerScreenWidth / (float)items;
+        for (uint32_t i = 0; i < items; i++) {
+            SamplerAdd(screen, width * (float)i, 795.0f, width, 49.0f);
+        }
+    }
+}
+
+// Smallest element under the point, the way AX hit tests return the
+// deepest accessible element.
+static uint32_t SamplerHitIndex(const SamplerScreen *screen, float x, float y) {
+    uint32_t best = UINT32_MAX;
+    float bestArea = INFINITY;
+    for (uint32_t i = 0; i < screen->count; i++) {
+        const SamplerRect *r = &screen->rects[i];
+        float area = r->width * r->height;
+        if (x >= r->x && x < r->x + r->width && y >= r->y && y < r->y + r->height && area < bestArea) {
+            best = i;
+            bestArea = area;
+        }
+    }
+    return best;
+}
+
+static uint64_t SamplerHitTest(void *context, float x, float y) {
+    SamplerContext *ctx = context;
+    ctx->calls++;
+    if (ctx->stopAfter && ctx->calls > ctx->stopAfter) {
+        return KIMIRUN_A11Y_SAMPLE_STOP;
+    }
+    if (x < ctx->regionX || y < ctx->regionY ||
+        x >= ctx->regionX + ctx->regionWidth || y >= ctx->regionY + ctx->regionHeight) {
+        ctx->outside = true;
+    }
+    uint32_t index = SamplerHitIndex(ctx->screen, x, y);
+    if (index == UINT32_MAX) {
+        return KIMIRUN_A11Y_SAMPLE_NONE;
+    }
+    ctx->hits++;
+    ctx->found[index] = true;
+    return (uint64_t)index + 1;
+}
+
+static void SamplerContextReset(SamplerContext *ctx, const SamplerScreen *screen) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->screen = screen;
+    ctx->regionWidth = kSamplerScreenWidth;
+    ctx->regionHeight = kSamplerScreenHeight;
+}
+
+static uint32_t SamplerFoundCount(const SamplerContext *ctx) {
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < ctx->screen->count; i++) {
+        found += ctx->found[i] ? 1u : 0u;
+    }
+    return found;
+}
+
+// The fallback's previous behaviour: centers of a fixed 6 x 10 grid.
+static void SamplerFixedGrid(SamplerContext *ctx) {
+    const uint32_t columns = 6;
+    const uint32_t rows = 10;
+    float dx = kSamplerScreenWidth / (float)columns;
+    float dy = kSamplerScreenHeight / (float)rows;
+    for (uint32_t row = 0; row < rows; row++) {
+        for (uint32_t column = 0; column < columns; column++) {
+            SamplerHitTest(ctx, ((float)column + 0.5f) * dx, ((float)row + 0.5f) * dy);
+        }
+    }
+}
+
+// Element centers as a previous snapshot would have them: some elements
+// gone, the rest shifted a little (scrolling, animation).
+static uint32_t SamplerStaleSeeds(const SamplerScreen *screen, uint64_t *rng, float shift, float *seeds) {
+    uint32_t count = 0;
+    float dy = SamplerUniform(rng, -shift, shift);
+    for (uint32_t i = 0; i < screen->count; i++) {
+        if (SamplerRandom(rng) % 5 == 0) {
+            continue;
+        }
+        const SamplerRect *r = &screen->rects[i];
+        seeds[count * 2] = r->x + r->width * 0.5f;
+        seeds[count * 2 + 1] = r->y + r->height * 0.5f + dy;
+        count++;
+    }
+    return count;
+}
+
+static int SamplerCheck(uint64_t iterations, uint64_t seed) {
+    uint64_t rng = seed ? seed : 0x5a3b1e9d;
+    SamplerScreen screen;
+    SamplerContext ctx;
+    KimiRunA11ySampleConfig config;
+    KimiRunA11ySampleStats stats;
+    float seeds[kSamplerMaxElements * 2 + 4];
+
+    // Uniform screens: nothing, or one element covering everything.
+    KimiRunA11ySampleConfigDefault(&config);
+    for (uint32_t fill = 0; fill < 2; fill++) {
+        screen.count = 0;
+        if (fill) {
+            SamplerAdd(&screen, 0.0f, 0.0f, kSamplerScreenWidth, kSamplerScreenHeight);
+        }
+        SamplerContextReset(&ctx, &screen);
+        KimiRunA11ySample(0.0f, 0.0f, kSamplerScreenWidth, kSamplerScreenHeight, &config, NULL, 0,
+                          SamplerHitTest, &ctx, &stats);
+        if (stats.calls != config.columns * config.rows || stats.splits != 0 || ctx.calls != stats.calls) {
+            SamplerFail(0, "uniform screen cost more than the coarse grid");
+        }
+    }
+
+    for (uint64_t iteration = 0; iteration < iterations; iteration++) {
+        SamplerMakeScreen(&screen, &rng);
+        config.columns = 1 + SamplerRandom(&rng) % 6;
+        config.rows = 1 + SamplerRandom(&rng) % 10;
+        config.minCellSize = SamplerUniform(&rng, 4.0f, 60.0f);
+        config.maxCalls = SamplerRandom(&rng) % 200;
+        uint32_t seedCount = SamplerStaleSeeds(&screen, &rng, 40.0f, seeds);
+        // Seeds outside the region and non-finite ones are skipped.
+        seeds[seedCount * 2] = NAN;
+        seeds[seedCount * 2 + 1] = 10.0f;
+        seeds[seedCount * 2 + 2] = -50.0f;
+        seeds[seedCount * 2 + 3] = 10.0f;
+        seedCount += 2;
+
+        SamplerContextReset(&ctx, &screen);
+        ctx.regionX = SamplerUniform(&rng, 0.0f, 40.0f);
+        ctx.regionY = SamplerUniform(&rng, 0.0f, 100.0f);
+        ctx.regionWidth = kSamplerScreenWidth - ctx.regionX - SamplerUniform(&rng, 0.0f, 40.0f);
+        ctx.regionHeight = kSamplerScreenHeight - ctx.regionY - SamplerUniform(&rng, 0.0f, 100.0f);
+        if (!KimiRunA11ySample(ctx.regionX, ctx.regionY, ctx.regionWidth, ctx.regionHeight, &config,
+                               seeds, seedCount, SamplerHitTest, &ctx, &stats)) {
+            SamplerFail(iteration, "allocation failure");
+            continue;
+        }
+        uint32_t coarse = config.columns * config.rows;
+        if (ctx.calls != stats.calls) {
+            SamplerFail(iteration, "calls miscounted");
+        }
+        if (stats.calls > (config.maxCalls > coarse ? config.maxCalls : coarse)) {
+            SamplerFail(iteration, "budget exceeded");
+        }
+        if (stats.calls < stats.seedCalls + coarse + stats.splits * 2 ||
+            stats.calls > stats.seedCalls + coarse + stats.splits * 4) {
+            SamplerFail(iteration, "calls are not seeds + coarse + 2 to 4 per split");
+        }
+        if (stats.seedCalls > seedCount - 2) {
+            SamplerFail(iteration, "invalid seeds sampled");
+        }
+        if (ctx.outside) {
+            SamplerFail(iteration, "hit test outside the region");
+        }
+        if (stats.splits > 0 && stats.depth == 0) {
+            SamplerFail(iteration, "split without depth");
+        }
+
+        // Same inputs, same plan.
+        SamplerContext again;
+        KimiRunA11ySampleStats againStats;
+        SamplerContextReset(&again, &screen);
+        again.regionX = ctx.regionX;
+        again.regionY = ctx.regionY;
+        again.regionWidth = ctx.regionWidth;
+        again.regionHeight = ctx.regionHeight;
+        KimiRunA11ySample(ctx.regionX, ctx.regionY, ctx.regionWidth, ctx.regionHeight, &config,
+                          seeds, seedCount, SamplerHitTest, &again, &againStats);
+        if (memcmp(&stats, &againStats, sizeof(stats)) != 0 || memcmp(ctx.found, again.found, sizeof(ctx.found)) != 0) {
+            SamplerFail(iteration, "not deterministic");
+        }
+
+        // Stopping: the callback that says stop is the last one made.
+        if (stats.calls > 1) {
+            uint32_t stopAfter = SamplerRandom(&rng) % (stats.calls - 1) + 1;
+            SamplerContextReset(&again, &screen);
+            again.regionX = ctx.regionX;
+            again.regionY = ctx.regionY;
+            again.regionWidth = ctx.regionWidth;
+            again.regionHeight = ctx.regionHeight;
+            again.stopAfter = stopAfter;
+            KimiRunA11ySample(ctx.regionX, ctx.regionY, ctx.regionWidth, ctx.regionHeight, &config,
+                              seeds, seedCount, SamplerHitTest, &again, &againStats);
+            if (!againStats.stopped || again.calls != stopAfter + 1 || againStats.calls != again.calls) {
+                SamplerFail(iteration, "stop not honoured");
+            }
+        }
+
+        // Exact centers as seeds with room to spare find every element
+        // whose center hits it.
+        uint32_t exact = 0;
+        for (uint32_t i = 0; i < screen.count; i++) {
+            seeds[i * 2] = screen.rects[i].x + screen.rects[i].width * 0.5f;
+            seeds[i * 2 + 1] = screen.rects[i].y + screen.rects[i].height * 0.5f;
+        }
+        KimiRunA11ySampleConfigDefault(&config);
+        config.maxCalls = screen.count + config.columns * config.rows + 32;
+        SamplerContextReset(&ctx, &screen);
+        KimiRunA11ySample(0.0f, 0.0f, kSamplerScreenWidth, kSamplerScreenHeight, &config,
+                          seeds, screen.count, SamplerHitTest, &ctx, &stats);
+        for (uint32_t i = 0; i < screen.count; i++) {
+            if (SamplerHitIndex(&screen, seeds[i * 2], seeds[i * 2 + 1]) == i) {
+                exact++;
+                if (!ctx.found[i]) {
+                    SamplerFail(iteration, "seeded element not found");
+                    break;
+                }
+            }
+        }
+        if (exact == 0 && screen.count > 0) {
+            SamplerFail(iteration, "screen without a hittable center");
+        }
+    }
+
+    printf("check: %llu iterations, %zu failures\n", (unsigned long long)iterations, g_failures);
+    return g_failures ? 1 : 0;
+}
+
+typedef struct {
+    uint64_t calls;
+    uint64_t resolved;
+    uint64_t found;
+    uint64_t total;
+} SamplerTally;
+
+// deduped: attributes are read once per element rather than once per hit.
+static void SamplerTallyAdd(SamplerTally *tally, const SamplerContext *ctx, bool deduped) {
+    uint32_t found = SamplerFoundCount(ctx);
+    tally->calls += ctx->calls;
+    tally->resolved += deduped ? found : ctx->hits;
+    tally->found += found;
+    tally->total += ctx->screen->count;
+}
+
+static void SamplerTallyPrint(const char *name, const SamplerTally *tally, uint64_t iterations) {
+    printf("%-22s %7.1f hit tests  %5.1f resolved  %5.1f%% found\n", name,
+           (double)tally->calls / (double)iterations,
+           (double)tally->resolved / (double)iterations,
+           tally->total ? 100.0 * (double)tally->found / (double)tally->total : 0.0);
+}
+
+static int SamplerBench(uint64_t iterations, uint64_t seed) {
+    uint64_t rng = seed ? seed : 0x2c6fe1d3;
+    SamplerScreen screen;
+    SamplerContext ctx;
+    KimiRunA11ySampleConfig config;
+    KimiRunA11ySampleConfigDefault(&config);
+    float seeds[kSamplerMaxElements * 2];
+    SamplerTally grid = {0};
+    SamplerTally adaptive = {0};
+    SamplerTally seeded = {0};
+    uint64_t planNanos = 0;
+
+    for (uint64_t iteration = 0; iteration < iterations; iteration++) {
+        SamplerMakeScreen(&screen, &rng);
+
+        SamplerContextReset(&ctx, &screen);
+        SamplerFixedGrid(&ctx);
+        SamplerTallyAdd(&grid, &ctx, false);
+
+        SamplerContextReset(&ctx, &screen);
+        uint64_t start = SamplerNowNanos();
+        KimiRunA11ySample(0.0f, 0.0f, kSamplerScreenWidth, kSamplerScreenHeight, &config, NULL, 0,
+                          SamplerHitTest, &ctx, NULL);
+        planNanos += SamplerNowNanos() - start;
+        SamplerTallyAdd(&adaptive, &ctx, true);
+
+        uint32_t seedCount = SamplerStaleSeeds(&screen, &rng, 12.0f, seeds);
+        SamplerContextReset(&ctx, &screen);
+        KimiRunA11ySample(0.0f, 0.0f, kSamplerScreenWidth, kSamplerScreenHeight, &config, seeds, seedCount,
+                          SamplerHitTest, &ctx, NULL);
+        SamplerTallyAdd(&seeded, &ctx, true);
+    }
+
+    printf("bench: %llu screens, budget %u calls, coarse %u x %u, min cell %.0f pt\n",
+           (unsigned long long)iterations, config.maxCalls, config.columns, config.rows, config.minCellSize);
+    SamplerTallyPrint("fixed 6 x 10 grid", &grid, iterations);
+    SamplerTallyPrint("adaptive", &adaptive, iterations);
+    SamplerTallyPrint("adaptive + seeds", &seeded, iterations);
+    printf("planning (adaptive)    %.2f us per screen\n", (double)planNanos / 1e3 / (double)iterations);
+    return 0;
+}
+
+static void SamplerUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check [-n iterations] [-s seed]\n", argv0);
+    fprintf(stderr, "       %s bench [-n iterations] [-s seed]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        SamplerUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                SamplerUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (strcmp(mode, "check") == 0) {
+        return SamplerCheck(iterations ? iterations : 5000, seed);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return SamplerBench(iterations ? iterations : 20000, seed);
+    }
+    SamplerUsage(argv[0]);
+    return 2;
+}
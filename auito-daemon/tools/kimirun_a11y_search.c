@@ -0,0 +1,367 @@
+//
+//  kimirun_a11y_search.c
+//  KimiRun - Accessibility label search check / benchmark
+//
+//  Host-side tool (not part of the theos targets) for the portable
+//  KimiRunA11ySearch index:
+//    check  indexes random Settings-like labels and identifiers (mixed
+//           case, repeated words, stray whitespace, empty fields) and
+//           compares every query (exact words, prefixes, fragments, typos)
+//           with a scan that scores each string directly
+//    bench  times index build and exact / substring / fuzzy lookups
+//           against that scan
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_a11y_search.c modules/accessibility/KimiRunA11ySearch.c
+//       modules/accessibility/KimiRunA11ySnapshot.c -o kimirun_a11y_search
+//
+//  Usage:
+//    kimirun_a11y_search check [-n iterations] [-e elements] [-s seed]
+//    kimirun_a11y_search bench [-n iterations] [-e elements]
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage error.
+//
+
+#include "accessibility/KimiRunA11ySearch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kSearchMaxElements 4096
+#define kSearchMaxText 96
+
+static size_t g_failures = 0;
+
+static const char *const kSearchWords[] = {
+    "Wi-Fi", "Bluetooth", "General", "Settings", "About", "Cellular", "Personal",
+    "Hotspot", "Notifications", "Sounds", "Haptics", "Focus", "Screen", "Time",
+    "Control", "Centre", "Display", "Brightness", "Home", "Accessibility",
+    "Wallpaper", "Siri", "Search", "Face", "ID", "Passcode", "Emergency", "SOS",
+    "Privacy", "Security", "App", "Store", "Wallet", "Pay", "Passwords", "Mail",
+    "Contacts", "Calendar", "Notes", "Reminders", "Phone", "Messages", "Safari",
+    "Back", "Done", "Edit", "Cancel", "On", "Off", "VPN", "Battery", "Storage",
+};
+
+static uint64_t SearchNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t SearchRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+static void SearchFail(uint64_t iteration, const char *what, const char *query) {
+    if (g_failures < 20) {
+        fprintf(stderr, "FAIL iteration %llu: %s (query \"%s\")\n", (unsigned long long)iteration, what, query);
+    }
+    g_failures++;
+}
+
+static void SearchPhrase(char *out, uint64_t *rng) {
+    size_t words = sizeof(kSearchWords) / sizeof(kSearchWords[0]);
+    uint32_t count = SearchRandom(rng) % 4;
+    out[0] = '\0';
+    for (uint32_t i = 0; i < count; i++) {
+        const char *word = kSearchWords[SearchRandom(rng) % words];
+        const char *gap = (SearchRandom(rng) % 8 == 0) ? "  " : " ";
+        if (strlen(out) + strlen(word) + 3 >= kSearchMaxText) {
+            break;
+        }
+        if (i > 0 || SearchRandom(rng) % 10 == 0) {
+            strcat(out, gap);
+        }
+        strcat(out, word);
+    }
+    if (SearchRandom(rng) % 6 == 0) {
+        for (char *p = out; *p; p++) {
+            if (*p >= 'a' && *p <= 'z') {
+                *p = (char)(*p - 32);
+            }
+        }
+    }
+}
+
+// A query drawn from the indexed strings: whole, a prefix, a fragment, a
+// one-byte typo, or an unrelated word.
+static void SearchQuery(char *out, char texts[][kSearchMaxText], uint32_t count, uint64_t *rng) {
+    const char *source = texts[SearchRandom(rng) % count];
+    size_t length = strlen(source);
+    uint32_t kind = SearchRandom(rng) % 5;
+    if (length == 0 || kind == 4) {
+        strcpy(out, kSearchWords[SearchRandom(rng) % (sizeof(kSearchWords) / sizeof(kSearchWords[0]))]);
+        return;
+    }
+    size_t start = kind == 2 ? SearchRandom(rng) % length : 0;
+    size_t span = kind == 0 ? length - start : 1 + SearchRandom(rng) % (length - start);
+    memcpy(out, source + start, span);
+    out[span] = '\0';
+    if (kind == 3) {
+        out[SearchRandom(rng) % span] = (char)('a' + SearchRandom(rng) % 26);
+    }
+}
+
+static uint32_t ScanTrigrams(const char *text, size_t length, bool padded, uint32_t *out) {
+    char buffer[kSearchMaxText + 2];
+    size_t n = 0;
+    if (padded) {
+        buffer[n++] = ' ';
+    }
+    memcpy(buffer + n, text, length);
+    n += length;
+    if (padded) {
+        buffer[n++] = ' ';
+    }
+    uint32_t count = 0;
+    for (size_t i = 0; i + 2 < n; i++) {
+        uint32_t trigram = ((uint32_t)(unsigned char)buffer[i] << 16) |
+                           ((uint32_t)(unsigned char)buffer[i + 1] << 8) | (unsigned char)buffer[i + 2];
+        bool seen = false;
+        for (uint32_t j = 0; j < count && !seen; j++) {
+            seen = out[j] == trigram;
+        }
+        if (!seen) {
+            out[count++] = trigram;
+        }
+    }
+    return count;
+}
+
+static int ScanCompare(const void *a, const void *b) {
+    const KimiRunA11yMatch *left = a;
+    const KimiRunA11yMatch *right = b;
+    if (left->score != right->score) {
+        return left->score > right->score ? -1 : 1;
+    }
+    if (left->kind != right->kind) {
+        return left->kind < right->kind ? -1 : 1;
+    }
+    return (left->element > right->element) - (left->element < right->element);
+}
+
+// Scores every document on its own, the way the index should.
+static uint32_t ScanFind(char labels[][kSearchMaxText], char identifiers[][kSearchMaxText], uint32_t count,
+                         const char *query, uint32_t fields, bool fuzzy, KimiRunA11yMatch *out) {
+    char q[kSearchMaxText];
+    size_t ql = KimiRunA11ySearchNormalize(query, q);
+    if (ql == 0) {
+        return 0;
+    }
+    uint32_t qp[kSearchMaxText + 2], dt[kSearchMaxText + 2];
+    uint32_t paddedCount = ScanTrigrams(q, ql, true, qp);
+    uint32_t found = 0;
+    for (uint32_t e = 0; e < count; e++) {
+        KimiRunA11yMatch best = { e, 0, KimiRunA11yMatchFuzzy, -1.0f };
+        for (uint32_t f = 0; f < 2; f++) {
+            uint32_t field = f ? KimiRunA11ySearchIdentifier : KimiRunA11ySearchLabel;
+            if (!(fields & field)) {
+                continue;
+            }
+            char d[kSearchMaxText];
+            size_t dl = KimiRunA11ySearchNormalize(f ? identifiers[e] : labels[e], d);
+            if (dl == 0) {
+                continue;
+            }
+            KimiRunA11yMatch candidates[2];
+            uint32_t n = 0;
+            const char *at = strstr(d, q);
+            if (dl == ql && at) {
+                candidates[n++] = (KimiRunA11yMatch){ e, field, KimiRunA11yMatchExact, 1.0f };
+            } else if (at) {
+                float share = (float)ql / (float)dl;
+                candidates[n++] = at == d
+                    ? (KimiRunA11yMatch){ e, field, KimiRunA11yMatchPrefix, 0.9f + 0.09f * share }
+                    : (KimiRunA11yMatch){ e, field, KimiRunA11yMatchSubstring, 0.8f + 0.09f * share };
+            }
+            if (fuzzy) {
+                uint32_t documentCount = ScanTrigrams(d, dl, true, dt);
+                uint32_t shared = 0;
+                for (uint32_t i = 0; i < paddedCount; i++) {
+                    for (uint32_t j = 0; j < documentCount; j++) {
+                        shared += qp[i] == dt[j];
+                    }
+                }
+                float similarity = shared ? (float)shared / (float)(paddedCount + documentCount - shared) : 0.0f;
+                if (shared && similarity >= KIMIRUN_A11Y_SEARCH_FUZZY_THRESHOLD) {
+                    candidates[n++] = (KimiRunA11yMatch){ e, field, KimiRunA11yMatchFuzzy, 0.79f * similarity };
+                }
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                if (candidates[i].score > best.score ||
+                    (candidates[i].score == best.score && candidates[i].kind < best.kind)) {
+                    best = candidates[i];
+                }
+            }
+        }
+        if (best.score >= 0.0f) {
+            out[found++] = best;
+        }
+    }
+    qsort(out, found, sizeof(*out), ScanCompare);
+    return found;
+}
+
+static bool SearchSame(const KimiRunA11yMatch *a, const KimiRunA11yMatch *b, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (a[i].element != b[i].element || a[i].kind != b[i].kind || a[i].score != b[i].score) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SearchFill(char labels[][kSearchMaxText], char identifiers[][kSearchMaxText],
+                       const char **labelPointers, const char **identifierPointers,
+                       uint32_t count, uint64_t *rng) {
+    for (uint32_t i = 0; i < count; i++) {
+        SearchPhrase(labels[i], rng);
+        if (SearchRandom(rng) % 3 == 0) {
+            snprintf(identifiers[i], kSearchMaxText, "com.apple.settings.%s", labels[i]);
+        } else {
+            identifiers[i][0] = '\0';
+        }
+        labelPointers[i] = labels[i];
+        identifierPointers[i] = (SearchRandom(rng) % 10 == 0) ? NULL : identifiers[i];
+        if (!identifierPointers[i]) {
+            identifiers[i][0] = '\0';
+        }
+    }
+}
+
+static int SearchCheck(uint64_t iterations, uint32_t elements, uint64_t seed) {
+    static char labels[kSearchMaxElements][kSearchMaxText];
+    static char identifiers[kSearchMaxElements][kSearchMaxText];
+    static const char *labelPointers[kSearchMaxElements];
+    static const char *identifierPointers[kSearchMaxElements];
+    static KimiRunA11yMatch expected[kSearchMaxElements];
+    static KimiRunA11yMatch actual[kSearchMaxElements];
+    uint64_t rng = seed ? seed : 0x9e3779b97f4a7c15ULL;
+    size_t counts[4] = {0};
+
+    for (uint64_t it = 1; it <= iterations; it++) {
+        uint32_t count = 1 + SearchRandom(&rng) % elements;
+        SearchFill(labels, identifiers, labelPointers, identifierPointers, count, &rng);
+        KimiRunA11ySearch *index = KimiRunA11ySearchCreate(labelPointers, identifierPointers, count);
+        if (!index) {
+            SearchFail(it, "create failed", "");
+            continue;
+        }
+        for (int query = 0; query < 12; query++) {
+            char text[kSearchMaxText];
+            SearchQuery(text, (SearchRandom(&rng) & 1) ? labels : identifiers, count, &rng);
+            uint32_t fields = 1 + SearchRandom(&rng) % 3;
+            bool fuzzy = SearchRandom(&rng) & 1;
+            uint32_t want = ScanFind(labels, identifiers, count, text, fields, fuzzy, expected);
+            uint32_t capacity = (SearchRandom(&rng) % 4 == 0) ? want / 2 : count;
+            uint32_t got = KimiRunA11ySearchFind(index, text, fields, fuzzy, actual, capacity);
+            if (got != want || !SearchSame(actual, expected, got < capacity ? got : capacity)) {
+                SearchFail(it, "matches differ from scan", text);
+            }
+            for (uint32_t i = 0; i < want; i++) {
+                counts[expected[i].kind]++;
+            }
+        }
+        KimiRunA11ySearchDestroy(index);
+    }
+    printf("check iterations %llu (up to %u elements)\n", (unsigned long long)iterations, elements);
+    printf("exact/prefix/substring/fuzzy  %zu / %zu / %zu / %zu\n", counts[0], counts[1], counts[2], counts[3]);
+    printf("failures         %zu\n", g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static int SearchBench(uint64_t iterations, uint32_t elements) {
+    static char labels[kSearchMaxElements][kSearchMaxText];
+    static char identifiers[kSearchMaxElements][kSearchMaxText];
+    static const char *labelPointers[kSearchMaxElements];
+    static const char *identifierPointers[kSearchMaxElements];
+    static KimiRunA11yMatch matches[kSearchMaxElements];
+    uint64_t rng = 0x2545f4914f6cdd1dULL;
+    SearchFill(labels, identifiers, labelPointers, identifierPointers, elements, &rng);
+
+    uint64_t start = SearchNowNanos();
+    uint64_t builds = iterations / 100 + 1;
+    for (uint64_t it = 0; it < builds; it++) {
+        KimiRunA11ySearchDestroy(KimiRunA11ySearchCreate(labelPointers, identifierPointers, elements));
+    }
+    double buildUs = (double)(SearchNowNanos() - start) / 1e3 / (double)builds;
+
+    KimiRunA11ySearch *index = KimiRunA11ySearchCreate(labelPointers, identifierPointers, elements);
+    if (!index) {
+        return 1;
+    }
+    const char *queries[] = { "General", "blue", "Notif", "Bluetoth", "screen time" };
+    const char *names[] = { "exact", "prefix", "substring", "fuzzy typo", "fuzzy phrase" };
+    size_t queryCount = sizeof(queries) / sizeof(queries[0]);
+    printf("bench iterations %llu (%u elements)\n", (unsigned long long)iterations, elements);
+    printf("build            %.2f us\n", buildUs);
+    uint64_t sink = 0;
+    for (size_t q = 0; q < queryCount; q++) {
+        bool fuzzy = q >= 3;
+        uint64_t indexNanos = 0, scanNanos = 0;
+        for (uint64_t it = 0; it < iterations; it++) {
+            uint64_t t0 = SearchNowNanos();
+            sink += KimiRunA11ySearchFind(index, queries[q], KimiRunA11ySearchLabel | KimiRunA11ySearchIdentifier,
+                                          fuzzy, matches, 10);
+            uint64_t t1 = SearchNowNanos();
+            if (it % 16 == 0) {
+                sink += ScanFind(labels, identifiers, elements, queries[q],
+                                 KimiRunA11ySearchLabel | KimiRunA11ySearchIdentifier, fuzzy, matches);
+                scanNanos += SearchNowNanos() - t1;
+            }
+            indexNanos += t1 - t0;
+        }
+        double n = iterations ? (double)iterations : 1.0;
+        double scans = (double)((iterations + 15) / 16);
+        printf("%-16s %.2f us (scan %.2f us)\n", names[q], (double)indexNanos / 1e3 / n,
+               (double)scanNanos / 1e3 / (scans > 0.0 ? scans : 1.0));
+    }
+    printf("sink             %llu\n", (unsigned long long)sink);
+    KimiRunA11ySearchDestroy(index);
+    return 0;
+}
+
+static void SearchUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check [-n iterations] [-e elements] [-s seed]\n", argv0);
+    fprintf(stderr, "       %s bench [-n iterations] [-e elements]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        SearchUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    uint32_t elements = 300;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:e:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 'e': elements = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                SearchUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (elements == 0 || elements > kSearchMaxElements) {
+        fprintf(stderr, "elements must be 1..%d\n", kSearchMaxElements);
+        return 2;
+    }
+    if (strcmp(mode, "check") == 0) {
+        return SearchCheck(iterations ? iterations : 2000, elements, seed);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return SearchBench(iterations ? iterations : 20000, elements);
+    }
+    SearchUsage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,337 @@
+//
+//  kimirun_a11y_spatial.c
+//  KimiRun - Accessibility spatial index check / benchmark
+//
+//  Host-side tool (not part of the theos targets) for the portable
+//  KimiRunA11ySpatial grid:
+//    check  builds indexes over random screens (nested containers, rows,
+//           small controls, empty and off-screen rects, flag mixes) and
+//           compares every point, region and nearest query with a
+//           straight scan of the same rects
+//    bench  times index build and each query kind against the linear
+//           scan the HTTP handlers used before
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_a11y_spatial.c modules/accessibility/KimiRunA11ySpatial.c
+//       -lm -o kimirun_a11y_spatial
+//
+//  Usage:
+//    kimirun_a11y_spatial check [-n iterations] [-e elements] [-s seed]
+//    kimirun_a11y_spatial bench [-n iterations] [-e elements]
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage error.
+//
+
+#include "accessibility/KimiRunA11ySpatial.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kSpatialMaxElements 8192
+#define kSpatialScreenWidth 430.0f
+#define kSpatialScreenHeight 932.0f
+
+static size_t g_failures = 0;
+
+static uint64_t SpatialNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t SpatialRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+static float SpatialUniform(uint64_t *state, float lo, float hi) {
+    return lo + (hi - lo) * (float)(SpatialRandom(state) & 0xffffff) / (float)0x1000000;
+}
+
+static void SpatialFail(uint64_t iteration, const char *what) {
+    if (g_failures < 20) {
+        fprintf(stderr, "FAIL iteration %llu: %s\n", (unsigned long long)iteration, what);
+    }
+    g_failures++;
+}
+
+// A screen the way the interactive list looks: a few large containers,
+// table rows, controls inside rows, bars, and some junk frames.
+static void SpatialScreen(KimiRunA11yRect *rects, uint32_t count, uint64_t *rng) {
+    for (uint32_t i = 0; i < count; i++) {
+        KimiRunA11yRect *rect = &rects[i];
+        uint32_t kind = SpatialRandom(rng) % 20;
+        if (kind == 0) {
+            *rect = (KimiRunA11yRect){ 0.0f, SpatialUniform(rng, 0.0f, 100.0f),
+                                       kSpatialScreenWidth, SpatialUniform(rng, 300.0f, kSpatialScreenHeight), 0 };
+        } else if (kind < 9) {
+            float y = SpatialUniform(rng, -200.0f, kSpatialScreenHeight + 200.0f);
+            *rect = (KimiRunA11yRect){ 16.0f, y, kSpatialScreenWidth - 32.0f, 44.0f + (float)(SpatialRandom(rng) % 3) * 0.5f, 0 };
+        } else if (kind < 17) {
+            *rect = (KimiRunA11yRect){ SpatialUniform(rng, 0.0f, kSpatialScreenWidth - 40.0f),
+                                       SpatialUniform(rng, 0.0f, kSpatialScreenHeight - 40.0f),
+                                       SpatialUniform(rng, 8.0f, 80.0f), SpatialUniform(rng, 8.0f, 44.0f), 0 };
+        } else if (kind == 17) {
+            *rect = (KimiRunA11yRect){ SpatialUniform(rng, 0.0f, kSpatialScreenWidth), 10.0f, 0.0f, 20.0f, 0 };
+        } else if (kind == 18) {
+            *rect = (KimiRunA11yRect){ SpatialUniform(rng, -5000.0f, 5000.0f),
+                                       SpatialUniform(rng, -5000.0f, 20000.0f), 60.0f, 30.0f, 0 };
+        } else {
+            *rect = (KimiRunA11yRect){ NAN, 0.0f, 10.0f, 10.0f, 0 };
+        }
+        // Same-size rects exercise the nearest tie-break.
+        if (SpatialRandom(rng) % 8 == 0 && i > 0) {
+            rect->width = rects[i - 1].width;
+            rect->height = rects[i - 1].height;
+        }
+        rect->flags = (SpatialRandom(rng) % 4 != 0) ? KimiRunA11ySpatialActionable : 0;
+    }
+}
+
+static bool SpatialValid(const KimiRunA11yRect *rect) {
+    return isfinite(rect->x) && isfinite(rect->y) && isfinite(rect->width) && isfinite(rect->height) &&
+           rect->width > 0.0f && rect->height > 0.0f;
+}
+
+static bool SpatialContains(const KimiRunA11yRect *rect, float x, float y) {
+    return x >= rect->x && x < (double)rect->x + rect->width &&
+           y >= rect->y && y < (double)rect->y + rect->height;
+}
+
+static double SpatialDistance2(const KimiRunA11yRect *rect, double x, double y) {
+    double dx = fmax(fmax(rect->x - x, 0.0), x - ((double)rect->x + rect->width));
+    double dy = fmax(fmax(rect->y - y, 0.0), y - ((double)rect->y + rect->height));
+    return dx * dx + dy * dy;
+}
+
+// The brute-force answers the index must reproduce.
+static uint32_t ScanAtPoint(const KimiRunA11yRect *rects, uint32_t count, float x, float y,
+                            uint32_t flags, uint32_t *out) {
+    uint32_t matched = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (SpatialValid(&rects[i]) && (rects[i].flags & flags) == flags && SpatialContains(&rects[i], x, y)) {
+            out[matched++] = i;
+        }
+    }
+    // Stable by area, so equal areas stay in element order like the index.
+    for (uint32_t i = 1; i < matched; i++) {
+        uint32_t element = out[i];
+        double area = (double)rects[element].width * rects[element].height;
+        uint32_t j = i;
+        while (j > 0 && (double)rects[out[j - 1]].width * rects[out[j - 1]].height > area) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = element;
+    }
+    return matched;
+}
+
+static uint32_t ScanInRect(const KimiRunA11yRect *rects, uint32_t count,
+                           double x0, double y0, double x1, double y1, bool contained,
+                           uint32_t flags, uint32_t *out) {
+    uint32_t matched = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const KimiRunA11yRect *r = &rects[i];
+        if (!SpatialValid(r) || (r->flags & flags) != flags) {
+            continue;
+        }
+        double rx1 = (double)r->x + r->width, ry1 = (double)r->y + r->height;
+        bool hit = contained
+            ? (r->x >= x0 && rx1 <= x1 && r->y >= y0 && ry1 <= y1)
+            : (r->x < x1 && x0 < rx1 && r->y < y1 && y0 < ry1);
+        if (hit) {
+            out[matched++] = i;
+        }
+    }
+    return matched;
+}
+
+static bool ScanNearest(const KimiRunA11yRect *rects, uint32_t count, float x, float y,
+                        float maxDistance, uint32_t flags, uint32_t *element, double *distance2) {
+    bool found = false;
+    double best = 0.0, bestArea = 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        const KimiRunA11yRect *r = &rects[i];
+        if (!SpatialValid(r) || (r->flags & flags) != flags) {
+            continue;
+        }
+        double d2 = SpatialDistance2(r, x, y);
+        double area = (double)r->width * r->height;
+        if (!found || d2 < best || (d2 == best && area < bestArea)) {
+            found = true;
+            best = d2;
+            bestArea = area;
+            *element = i;
+        }
+    }
+    if (found && maxDistance >= 0.0f && best > (double)maxDistance * maxDistance) {
+        return false;
+    }
+    *distance2 = best;
+    return found;
+}
+
+static int SpatialCheck(uint64_t iterations, uint32_t elements, uint64_t seed) {
+    static KimiRunA11yRect rects[kSpatialMaxElements];
+    static uint32_t expected[kSpatialMaxElements];
+    static uint32_t actual[kSpatialMaxElements];
+    uint64_t rng = seed ? seed : 0x9e3779b97f4a7c15ULL;
+    size_t pointHits = 0, regionHits = 0, nearestFound = 0;
+
+    for (uint64_t it = 1; it <= iterations; it++) {
+        uint32_t count = 1 + SpatialRandom(&rng) % elements;
+        SpatialScreen(rects, count, &rng);
+        float cellSize = (SpatialRandom(&rng) % 3 == 0) ? SpatialUniform(&rng, 4.0f, 200.0f) : 0.0f;
+        KimiRunA11ySpatial *index = KimiRunA11ySpatialCreate(rects, count, cellSize);
+        if (!index) {
+            SpatialFail(it, "create failed");
+            continue;
+        }
+
+        for (int query = 0; query < 16; query++) {
+            uint32_t flags = (SpatialRandom(&rng) & 1) ? KimiRunA11ySpatialActionable : 0;
+            float x = SpatialUniform(&rng, -100.0f, kSpatialScreenWidth + 100.0f);
+            float y = SpatialUniform(&rng, -300.0f, kSpatialScreenHeight + 300.0f);
+            if (query == 0 && SpatialValid(&rects[0])) {
+                x = rects[0].x;            // on an edge
+                y = rects[0].y;
+            }
+
+            uint32_t want = ScanAtPoint(rects, count, x, y, flags, expected);
+            uint32_t capacity = SpatialRandom(&rng) % 3 == 0 ? want / 2 : count;
+            uint32_t got = KimiRunA11ySpatialAtPoint(index, x, y, flags, actual, capacity);
+            uint32_t written = got < capacity ? got : capacity;
+            if (got != want || memcmp(actual, expected, written * sizeof(uint32_t)) != 0) {
+                SpatialFail(it, "point query differs from scan");
+            }
+            pointHits += want;
+
+            float w = SpatialUniform(&rng, -50.0f, 300.0f);
+            float h = SpatialUniform(&rng, -50.0f, 600.0f);
+            bool contained = SpatialRandom(&rng) & 1;
+            double qx = w < 0.0f ? (double)x + w : x, qy = h < 0.0f ? (double)y + h : y;
+            want = (w == 0.0f || h == 0.0f) ? 0
+                : ScanInRect(rects, count, qx, qy, qx + fabsf(w), qy + fabsf(h), contained, flags, expected);
+            got = KimiRunA11ySpatialInRect(index, x, y, w, h, contained, flags, actual, count);
+            if (got != want || memcmp(actual, expected, want * sizeof(uint32_t)) != 0) {
+                SpatialFail(it, "region query differs from scan");
+            }
+            regionHits += want;
+
+            float maxDistance = (SpatialRandom(&rng) & 1) ? -1.0f : SpatialUniform(&rng, 0.0f, 120.0f);
+            uint32_t wantElement = 0, gotElement = 0;
+            double wantDistance2 = 0.0;
+            float gotDistance = 0.0f;
+            bool wantFound = ScanNearest(rects, count, x, y, maxDistance, flags, &wantElement, &wantDistance2);
+            bool gotFound = KimiRunA11ySpatialNearest(index, x, y, maxDistance, flags, &gotElement, &gotDistance);
+            if (wantFound != gotFound ||
+                (wantFound && (gotElement != wantElement ||
+                               fabs(gotDistance - sqrt(wantDistance2)) > 1e-3))) {
+                SpatialFail(it, "nearest query differs from scan");
+            }
+            nearestFound += wantFound;
+        }
+        KimiRunA11ySpatialDestroy(index);
+    }
+    printf("check iterations %llu (up to %u elements)\n", (unsigned long long)iterations, elements);
+    printf("point/region/nearest matches  %zu / %zu / %zu\n", pointHits, regionHits, nearestFound);
+    printf("failures         %zu\n", g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static int SpatialBench(uint64_t iterations, uint32_t elements) {
+    static KimiRunA11yRect rects[kSpatialMaxElements];
+    static uint32_t out[kSpatialMaxElements];
+    uint64_t rng = 0x2545f4914f6cdd1dULL;
+    SpatialScreen(rects, elements, &rng);
+
+    uint64_t start = SpatialNowNanos();
+    for (uint64_t it = 0; it < iterations / 100 + 1; it++) {
+        KimiRunA11ySpatialDestroy(KimiRunA11ySpatialCreate(rects, elements, 0.0f));
+    }
+    double buildUs = (double)(SpatialNowNanos() - start) / 1e3 / (double)(iterations / 100 + 1);
+
+    KimiRunA11ySpatial *index = KimiRunA11ySpatialCreate(rects, elements, 0.0f);
+    if (!index) {
+        return 1;
+    }
+    uint64_t pointNanos = 0, regionNanos = 0, nearestNanos = 0, scanNanos = 0, sink = 0;
+    for (uint64_t it = 0; it < iterations; it++) {
+        float x = SpatialUniform(&rng, 0.0f, kSpatialScreenWidth);
+        float y = SpatialUniform(&rng, 0.0f, kSpatialScreenHeight);
+        uint32_t element = 0;
+        float distance = 0.0f;
+        double distance2 = 0.0;
+
+        uint64_t t0 = SpatialNowNanos();
+        sink += KimiRunA11ySpatialAtPoint(index, x, y, KimiRunA11ySpatialActionable, out, 8);
+        uint64_t t1 = SpatialNowNanos();
+        sink += KimiRunA11ySpatialInRect(index, x, y, 120.0f, 88.0f, false, 0, out, elements);
+        uint64_t t2 = SpatialNowNanos();
+        sink += KimiRunA11ySpatialNearest(index, x, y, -1.0f, KimiRunA11ySpatialActionable, &element, &distance);
+        uint64_t t3 = SpatialNowNanos();
+        sink += ScanNearest(rects, elements, x, y, -1.0f, KimiRunA11ySpatialActionable, &element, &distance2);
+        uint64_t t4 = SpatialNowNanos();
+
+        pointNanos += t1 - t0;
+        regionNanos += t2 - t1;
+        nearestNanos += t3 - t2;
+        scanNanos += t4 - t3;
+    }
+    KimiRunA11ySpatialDestroy(index);
+    double n = iterations ? (double)iterations : 1.0;
+    printf("bench iterations %llu (%u elements, sink %llu)\n",
+           (unsigned long long)iterations, elements, (unsigned long long)sink);
+    printf("build            %.2f us\n", buildUs);
+    printf("at point         %.3f us\n", (double)pointNanos / 1e3 / n);
+    printf("in rect          %.3f us\n", (double)regionNanos / 1e3 / n);
+    printf("nearest          %.3f us\n", (double)nearestNanos / 1e3 / n);
+    printf("nearest (scan)   %.3f us\n", (double)scanNanos / 1e3 / n);
+    return 0;
+}
+
+static void SpatialUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check [-n iterations] [-e elements] [-s seed]\n", argv0);
+    fprintf(stderr, "       %s bench [-n iterations] [-e elements]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        SpatialUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    uint32_t elements = 500;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:e:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 'e': elements = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                SpatialUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (elements == 0 || elements > kSpatialMaxElements) {
+        fprintf(stderr, "elements must be 1..%d\n", kSpatialMaxElements);
+        return 2;
+    }
+    if (strcmp(mode, "check") == 0) {
+        return SpatialCheck(iterations ? iterations : 2000, elements, seed);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return SpatialBench(iterations ? iterations : 100000, elements);
+    }
+    SpatialUsage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,636 @@
+//
+//  kimirun_binary_touch_bench.c
+//  KimiRun - Binary touch stream latency check / benchmark
+//
+//  Host-side tool (not part of the theos targets). Runs the portable
+//  KimiRunStreamServer on loopback with the same shape of binary handler
+//  SocketTouchServer uses:
+//    - "BIN" switches a connection to 16-byte KimiRunBinaryTouch records
+//    - each record gets a playout due time from KimiRunBTouchPlayoutDue and
+//      is queued for a dispatcher thread, which waits for the earliest due
+//      time, "applies" every due record and posts one ack per connection
+//      through KimiRunStreamServerPost
+//  Clients stream one finger each at a fixed rate (optionally writing
+//  several records per send to mimic network bunching) and time every ack.
+//  Checks: codec round trips, playout clock wrap, every record acked exactly
+//  once, ack sequences increasing. Reports records per ack, ack round trip
+//  (client timestamp -> ack received) and how far applied spacing strays
+//  from the client's spacing.
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -D_POSIX_C_SOURCE=200809L -Imodules
+//       tools/kimirun_binary_touch_bench.c modules/socket/KimiRunBinaryTouch.c
+//       modules/socket/KimiRunStreamServer.c -lpthread -o kimirun_binary_touch_bench
+//
+//  Usage:
+//    kimirun_binary_touch_bench [-c clients] [-r hz] [-d seconds] [-b records_per_write] [-p playout_ms]
+//
+//  Exit status: 0 clean, 1 protocol or ack errors, 2 usage or I/O error.
+//
+
+#include "socket/KimiRunBinaryTouch.h"
+#include "socket/KimiRunStreamServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kBenchMaxClients 64
+#define kBenchQueueCapacity 4096
+#define kBenchBatch 64
+
+typedef struct {
+    bool binary;
+    KimiRunBTouchPlayout playout;
+} BenchConnection;
+
+typedef struct {
+    uint64_t connectionID;
+    KimiRunBTouchRecord record;
+    uint64_t receivedMicros;
+    uint64_t dueMicros;
+    uint64_t order;                   // arrival order, breaks due-time ties
+} BenchItem;
+
+typedef struct {
+    uint64_t connectionID;
+    uint64_t lastApplied;
+    uint32_t lastClient;
+} BenchCadence;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool stopping;
+    uint32_t count;
+    uint64_t nextOrder;
+    BenchItem items[kBenchQueueCapacity];   // min-heap on (dueMicros, order)
+    // Dispatcher thread only.
+    BenchCadence cadence[kBenchMaxClients];
+    uint64_t spacingSamples;
+    double spacingErrorTotal;
+    uint64_t spacingErrorMax;
+    uint64_t batches;
+    uint64_t acks;
+} BenchDispatcher;
+
+typedef struct {
+    uint16_t port;
+    uint32_t client;
+    uint32_t records;
+    uint32_t periodMicros;
+    uint32_t perWrite;
+    uint64_t acked;
+    uint64_t acks;
+    uint32_t *rtts;
+    uint64_t rttCount;
+    bool failed;
+    char error[96];
+} BenchClient;
+
+static KimiRunStreamServer *g_server;
+static BenchDispatcher g_dispatcher;
+static uint32_t g_playoutMicros = 8000;
+static atomic_uint_fast64_t g_overflows;
+
+static uint64_t BenchNowMicros(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ull) + ((uint64_t)ts.tv_nsec / 1000ull);
+}
+
+static void BenchSleepUntil(uint64_t micros) {
+    uint64_t now = BenchNowMicros();
+    if (micros <= now) {
+        return;
+    }
+    uint64_t wait = micros - now;
+    struct timespec ts = {(time_t)(wait / 1000000ull), (long)((wait % 1000000ull) * 1000ull)};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static int BenchCheckCodec(void) {
+    int failures = 0;
+    unsigned seed = 7;
+    for (int i = 0; i < 100000; i++) {
+        KimiRunBTouchRecord in = {
+            .sequence = (uint32_t)rand_r(&seed) * 2654435761u,
+            .finger = (uint8_t)(rand_r(&seed) % 20),
+            .phase = (uint8_t)(rand_r(&seed) % 3),
+            .flags = (uint16_t)(rand_r(&seed) & 1),
+            .x = (float)(rand_r(&seed) % 65536) / KIMIRUN_BTOUCH_COORD_SCALE,
+            .y = (float)(rand_r(&seed) % 65536) / KIMIRUN_BTOUCH_COORD_SCALE,
+            .clientMicros = (uint32_t)rand_r(&seed) * 40503u
+        };
+        uint8_t bytes[KIMIRUN_BTOUCH_RECORD_SIZE];
+        KimiRunBTouchRecord out;
+        KimiRunBTouchEncode(&in, bytes);
+        if (!KimiRunBTouchDecode(bytes, &out) || out.sequence != in.sequence || out.finger != in.finger ||
+            out.phase != in.phase || out.flags != in.flags || out.x != in.x || out.y != in.y ||
+            out.clientMicros != in.clientMicros) {
+            failures++;
+        }
+    }
+    uint8_t bytes[KIMIRUN_BTOUCH_RECORD_SIZE] = {0};
+    KimiRunBTouchRecord record;
+    bytes[5] = 3;
+    if (KimiRunBTouchDecode(bytes, &record)) {
+        failures++;   // unknown phase must be rejected
+    }
+    KimiRunBTouchAck ack = {0xdeadbeefu, 0x01020304u, 12345u, 9, 2};
+    KimiRunBTouchAck back;
+    uint8_t ackBytes[KIMIRUN_BTOUCH_ACK_SIZE];
+    KimiRunBTouchEncodeAck(&ack, ackBytes);
+    KimiRunBTouchDecodeAck(ackBytes, &back);
+    if (back.sequence != ack.sequence || back.clientMicros != ack.clientMicros ||
+        back.latencyMicros != ack.latencyMicros || back.count != ack.count || back.failed != ack.failed) {
+        failures++;
+    }
+
+    // A 120 Hz stream across the 32-bit client clock wrap, delivered with
+    // up to 20 ms of jitter: spacing is restored and order kept.
+    KimiRunBTouchPlayout playout;
+    memset(&playout, 0, sizeof(playout));
+    uint64_t lastDue = 0;
+    uint32_t client = UINT32_MAX - 50000u;
+    for (int i = 0; i < 200; i++, client += 8333u) {
+        uint64_t sent = 1000000ull + (uint64_t)i * 8333ull;
+        uint64_t received = sent + 300 + (uint64_t)((i * 7919) % 20000);
+        uint64_t due = KimiRunBTouchPlayoutDue(&playout, client, received, 25000);
+        if (due < lastDue || due > received + 25000 || (i > 0 && due - lastDue > 8333 + 20000)) {
+            failures++;
+        }
+        lastDue = due;
+    }
+    return failures;
+}
+
+static bool BenchItemBefore(const BenchItem *a, const BenchItem *b) {
+    return a->dueMicros < b->dueMicros || (a->dueMicros == b->dueMicros && a->order < b->order);
+}
+
+static bool BenchPush(const BenchItem *item) {
+    BenchDispatcher *d = &g_dispatcher;
+    pthread_mutex_lock(&d->lock);
+    if (d->count >= kBenchQueueCapacity) {
+        pthread_mutex_unlock(&d->lock);
+        return false;
+    }
+    uint32_t i = d->count++;
+    d->items[i] = *item;
+    d->items[i].order = d->nextOrder++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!BenchItemBefore(&d->items[i], &d->items[parent])) {
+            break;
+        }
+        BenchItem swap = d->items[i];
+        d->items[i] = d->items[parent];
+        d->items[parent] = swap;
+        i = parent;
+    }
+    pthread_cond_signal(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+    return true;
+}
+
+// Caller holds the lock and count > 0.
+static BenchItem BenchPop(void) {
+    BenchDispatcher *d = &g_dispatcher;
+    BenchItem top = d->items[0];
+    d->items[0] = d->items[--d->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t smallest = i;
+        uint32_t left = (2 * i) + 1;
+        uint32_t right = left + 1;
+        if (left < d->count && BenchItemBefore(&d->items[left], &d->items[smallest])) {
+            smallest = left;
+        }
+        if (right < d->count && BenchItemBefore(&d->items[right], &d->items[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        BenchItem swap = d->items[i];
+        d->items[i] = d->items[smallest];
+        d->items[smallest] = swap;
+        i = smallest;
+    }
+    return top;
+}
+
+static BenchCadence *BenchCadenceFor(uint64_t connectionID) {
+    BenchCadence *empty = NULL;
+    for (int i = 0; i < kBenchMaxClients; i++) {
+        BenchCadence *cadence = &g_dispatcher.cadence[i];
+        if (cadence->connectionID == connectionID) {
+            return cadence;
+        }
+        if (!empty && cadence->connectionID == 0) {
+            empty = cadence;
+        }
+    }
+    if (empty) {
+        empty->connectionID = connectionID;
+    }
+    return empty;
+}
+
+static void *BenchDispatcherThread(void *arg) {
+    (void)arg;
+    BenchDispatcher *d = &g_dispatcher;
+    BenchItem batch[kBenchBatch];
+    for (;;) {
+        pthread_mutex_lock(&d->lock);
+        while (!d->stopping && d->count == 0) {
+            pthread_cond_wait(&d->cond, &d->lock);
+        }
+        if (d->stopping) {
+            pthread_mutex_unlock(&d->lock);
+            return NULL;
+        }
+        uint64_t due = d->items[0].dueMicros;
+        pthread_mutex_unlock(&d->lock);
+        BenchSleepUntil(due);
+
+        uint64_t now = BenchNowMicros();
+        uint32_t count = 0;
+        pthread_mutex_lock(&d->lock);
+        while (count < kBenchBatch && d->count > 0 && d->items[0].dueMicros <= now) {
+            batch[count++] = BenchPop();
+        }
+        pthread_mutex_unlock(&d->lock);
+
+        // "Apply" in order, then one ack per connection.
+        KimiRunBTouchAck acks[kBenchBatch];
+        uint64_t ackIDs[kBenchBatch];
+        uint32_t ackCount = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            BenchItem *item = &batch[i];
+            uint64_t applied = BenchNowMicros();
+            BenchCadence *cadence = BenchCadenceFor(item->connectionID);
+            if (cadence && cadence->lastApplied != 0) {
+                int64_t clientGap = (int32_t)(item->record.clientMicros - cadence->lastClient);
+                int64_t appliedGap = (int64_t)(applied - cadence->lastApplied);
+                uint64_t error = (uint64_t)llabs(appliedGap - clientGap);
+                d->spacingSamples++;
+                d->spacingErrorTotal += (double)error;
+                if (error > d->spacingErrorMax) {
+                    d->spacingErrorMax = error;
+                }
+            }
+            if (cadence) {
+                cadence->lastApplied = applied;
+                cadence->lastClient = item->record.clientMicros;
+            }
+            uint32_t j = 0;
+            while (j < ackCount && ackIDs[j] != item->connectionID) {
+                j++;
+            }
+            if (j == ackCount) {
+                memset(&acks[j], 0, sizeof(acks[j]));
+                ackIDs[j] = item->connectionID;
+                ackCount++;
+            }
+            acks[j].sequence = item->record.sequence;
+            acks[j].clientMicros = item->record.clientMicros;
+            acks[j].latencyMicros = (uint32_t)(applied - item->receivedMicros);
+            acks[j].count++;
+        }
+        for (uint32_t j = 0; j < ackCount; j++) {
+            uint8_t bytes[KIMIRUN_BTOUCH_ACK_SIZE];
+            KimiRunBTouchEncodeAck(&acks[j], bytes);
+            KimiRunStreamServerPost(g_server, ackIDs[j], bytes, sizeof(bytes));
+        }
+        d->batches++;
+        d->acks += ackCount;
+    }
+}
+
+static void BenchOnOpen(void *context, KimiRunStreamConnection *conn) {
+    (void)context;
+    KimiRunStreamConnectionSetUserData(conn, calloc(1, sizeof(BenchConnection)));
+}
+
+static void BenchOnClose(void *context, KimiRunStreamConnection *conn) {
+    (void)context;
+    free(KimiRunStreamConnectionUserData(conn));
+}
+
+static void BenchOnFrame(void *context, KimiRunStreamConnection *conn, const uint8_t *bytes, size_t length) {
+    (void)context;
+    BenchConnection *state = (BenchConnection *)KimiRunStreamConnectionUserData(conn);
+    if (!state->binary) {
+        if (length == 3 && memcmp(bytes, "BIN", 3) == 0) {
+            state->binary = true;
+            KimiRunStreamConnectionSend(conn, "OK: BIN 16\r\n", 12);
+            KimiRunStreamConnectionSetFraming(conn, KimiRunStreamFramingFixed, KIMIRUN_BTOUCH_RECORD_SIZE);
+        }
+        return;
+    }
+    BenchItem item;
+    memset(&item, 0, sizeof(item));
+    item.connectionID = KimiRunStreamConnectionID(conn);
+    KimiRunBTouchDecode(bytes, &item.record);
+    item.receivedMicros = BenchNowMicros();
+    item.dueMicros = (item.record.flags & KimiRunBTouchFlagImmediate)
+        ? KimiRunBTouchImmediateDue(&state->playout, item.receivedMicros)
+        : KimiRunBTouchPlayoutDue(&state->playout, item.record.clientMicros, item.receivedMicros, g_playoutMicros);
+    if (!BenchPush(&item)) {
+        atomic_fetch_add(&g_overflows, 1);
+        KimiRunStreamConnectionClose(conn);
+    }
+}
+
+static void *BenchServerThread(void *arg) {
+    KimiRunStreamServerRun((KimiRunStreamServer *)arg);
+    return NULL;
+}
+
+static int BenchConnect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool BenchWriteAll(int fd, const void *bytes, size_t length) {
+    const uint8_t *cursor = (const uint8_t *)bytes;
+    while (length > 0) {
+        ssize_t n = send(fd, cursor, length, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        cursor += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static void BenchFail(BenchClient *client, const char *message) {
+    if (!client->failed) {
+        client->failed = true;
+        snprintf(client->error, sizeof(client->error), "%s", message);
+    }
+}
+
+static void *BenchClientThread(void *arg) {
+    BenchClient *client = (BenchClient *)arg;
+    int fd = BenchConnect(client->port);
+    char hello[12];
+    if (fd < 0 || !BenchWriteAll(fd, "BIN\n", 4) ||
+        recv(fd, hello, sizeof(hello), MSG_WAITALL) != (ssize_t)sizeof(hello) ||
+        memcmp(hello, "OK: BIN 16\r\n", sizeof(hello)) != 0) {
+        BenchFail(client, "BIN handshake failed");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    uint8_t in[KIMIRUN_BTOUCH_ACK_SIZE * 64];
+    size_t inLength = 0;
+    uint32_t sent = 0;
+    bool haveAck = false;
+    uint32_t lastAckSeq = 0;
+    uint64_t start = BenchNowMicros();
+    uint64_t deadline = 0;
+    uint8_t finger = (uint8_t)(client->client % 20);
+
+    while (!client->failed && client->acked < client->records) {
+        uint64_t now = BenchNowMicros();
+        if (sent < client->records) {
+            // Write once the last record of the next group is due.
+            uint32_t last = sent + client->perWrite - 1;
+            if (last >= client->records) {
+                last = client->records - 1;
+            }
+            uint64_t writeAt = start + (uint64_t)last * client->periodMicros;
+            if (now >= writeAt) {
+                uint8_t out[KIMIRUN_BTOUCH_RECORD_SIZE * 64];
+                size_t length = 0;
+                for (uint32_t k = sent; k <= last; k++) {
+                    KimiRunBTouchRecord record = {
+                        .sequence = k + 1,
+                        .finger = finger,
+                        .phase = (k == 0) ? KimiRunBTouchPhaseDown
+                                          : ((k + 1 == client->records) ? KimiRunBTouchPhaseUp : KimiRunBTouchPhaseMove),
+                        .x = 100.0f + (float)(k % 200),
+                        .y = 200.0f + (float)client->client,
+                        .clientMicros = (uint32_t)(start + (uint64_t)k * client->periodMicros)
+                    };
+                    KimiRunBTouchEncode(&record, out + length);
+                    length += KIMIRUN_BTOUCH_RECORD_SIZE;
+                }
+                if (!BenchWriteAll(fd, out, length)) {
+                    BenchFail(client, "send failed");
+                    break;
+                }
+                sent = last + 1;
+                if (sent == client->records) {
+                    deadline = BenchNowMicros() + 2000000ull;
+                }
+                continue;
+            }
+        } else if (now > deadline) {
+            BenchFail(client, "timed out waiting for acks");
+            break;
+        }
+
+        uint64_t wakeAt = (sent < client->records)
+            ? start + (uint64_t)(sent + client->perWrite - 1 < client->records ? sent + client->perWrite - 1
+                                                                                 : client->records - 1) * client->periodMicros
+            : deadline;
+        int timeout = wakeAt > now ? (int)((wakeAt - now + 999) / 1000) : 0;
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout) <= 0) {
+            continue;
+        }
+        ssize_t n = recv(fd, in + inLength, sizeof(in) - inLength, 0);
+        if (n <= 0) {
+            BenchFail(client, "connection closed");
+            break;
+        }
+        inLength += (size_t)n;
+        uint64_t received = BenchNowMicros();
+        size_t offset = 0;
+        for (; offset + KIMIRUN_BTOUCH_ACK_SIZE <= inLength; offset += KIMIRUN_BTOUCH_ACK_SIZE) {
+            KimiRunBTouchAck ack;
+            KimiRunBTouchDecodeAck(in + offset, &ack);
+            if ((haveAck && ack.sequence <= lastAckSeq) || ack.sequence > sent || ack.count == 0 || ack.failed != 0) {
+                BenchFail(client, "bad ack");
+                break;
+            }
+            haveAck = true;
+            lastAckSeq = ack.sequence;
+            client->acked += ack.count;
+            client->acks++;
+            client->rtts[client->rttCount++] = (uint32_t)received - ack.clientMicros;
+        }
+        memmove(in, in + offset, inLength - offset);
+        inLength -= offset;
+    }
+    if (!client->failed && (client->acked != client->records || lastAckSeq != client->records)) {
+        BenchFail(client, "ack count mismatch");
+    }
+    close(fd);
+    return NULL;
+}
+
+static int BenchCompareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void BenchUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-c clients] [-r hz] [-d seconds] [-b records_per_write] [-p playout_ms]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t clients = 8;
+    uint32_t hz = 120;
+    double seconds = 2.0;
+    uint32_t perWrite = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:r:d:b:p:")) != -1) {
+        switch (opt) {
+            case 'c': clients = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'r': hz = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'd': seconds = strtod(optarg, NULL); break;
+            case 'b': perWrite = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'p': g_playoutMicros = (uint32_t)strtoul(optarg, NULL, 10) * 1000u; break;
+            default:
+                BenchUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (clients == 0 || clients > kBenchMaxClients || hz == 0 || seconds <= 0.0 || perWrite == 0 || perWrite > 64) {
+        BenchUsage(argv[0]);
+        return 2;
+    }
+
+    int codecFailures = BenchCheckCodec();
+    printf("codec/playout checks  %s\n", codecFailures ? "FAILED" : "ok");
+
+    pthread_mutex_init(&g_dispatcher.lock, NULL);
+    pthread_cond_init(&g_dispatcher.cond, NULL);
+    KimiRunStreamCallbacks callbacks = {
+        .onOpen = BenchOnOpen,
+        .onFrame = BenchOnFrame,
+        .onClose = BenchOnClose
+    };
+    g_server = KimiRunStreamServerCreate(NULL, &callbacks);
+    uint16_t port = 0;
+    if (!g_server || !KimiRunStreamServerListenTCP(g_server, "127.0.0.1", 0, &port)) {
+        perror("listen");
+        return 2;
+    }
+    pthread_t serverThread;
+    pthread_t dispatcherThread;
+    pthread_create(&serverThread, NULL, BenchServerThread, g_server);
+    pthread_create(&dispatcherThread, NULL, BenchDispatcherThread, NULL);
+
+    uint32_t records = (uint32_t)(seconds * hz);
+    if (records < 2) {
+        records = 2;
+    }
+    BenchClient *states = calloc(clients, sizeof(*states));
+    pthread_t *threads = calloc(clients, sizeof(*threads));
+    for (uint32_t i = 0; i < clients; i++) {
+        states[i].port = port;
+        states[i].client = i;
+        states[i].records = records;
+        states[i].periodMicros = 1000000u / hz;
+        states[i].perWrite = perWrite;
+        states[i].rtts = calloc(records, sizeof(uint32_t));
+        pthread_create(&threads[i], NULL, BenchClientThread, &states[i]);
+    }
+
+    uint64_t totalRecords = 0;
+    uint64_t totalAcks = 0;
+    uint64_t rttCount = 0;
+    int failures = codecFailures;
+    for (uint32_t i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+        totalRecords += states[i].acked;
+        totalAcks += states[i].acks;
+        rttCount += states[i].rttCount;
+        if (states[i].failed) {
+            fprintf(stderr, "client %u: %s\n", i, states[i].error);
+            failures++;
+        }
+    }
+    uint32_t *rtts = calloc(rttCount ? rttCount : 1, sizeof(uint32_t));
+    uint64_t filled = 0;
+    for (uint32_t i = 0; i < clients; i++) {
+        memcpy(rtts + filled, states[i].rtts, states[i].rttCount * sizeof(uint32_t));
+        filled += states[i].rttCount;
+    }
+    qsort(rtts, rttCount, sizeof(uint32_t), BenchCompareU32);
+
+    KimiRunStreamServerStats stats;
+    KimiRunStreamServerStop(g_server);
+    pthread_join(serverThread, NULL);
+    KimiRunStreamServerGetStats(g_server, &stats);
+    pthread_mutex_lock(&g_dispatcher.lock);
+    g_dispatcher.stopping = true;
+    pthread_cond_signal(&g_dispatcher.cond);
+    pthread_mutex_unlock(&g_dispatcher.lock);
+    pthread_join(dispatcherThread, NULL);
+    KimiRunStreamServerDestroy(g_server);
+
+    printf("clients               %u at %u Hz, %u record(s) per write, playout %u ms\n",
+           clients, hz, perWrite, g_playoutMicros / 1000);
+    printf("records acked         %llu / %llu\n",
+           (unsigned long long)totalRecords, (unsigned long long)records * clients);
+    printf("acks                  %llu (%.2f records/ack), %llu posted\n",
+           (unsigned long long)totalAcks, totalAcks ? (double)totalRecords / (double)totalAcks : 0.0,
+           (unsigned long long)stats.posted);
+    if (rttCount > 0) {
+        printf("ack round trip us     p50 %u  p99 %u  max %u\n",
+               rtts[rttCount / 2], rtts[(rttCount * 99) / 100], rtts[rttCount - 1]);
+    }
+    printf("spacing error us      mean %.0f  max %llu\n",
+           g_dispatcher.spacingSamples ? g_dispatcher.spacingErrorTotal / (double)g_dispatcher.spacingSamples : 0.0,
+           (unsigned long long)g_dispatcher.spacingErrorMax);
+    printf("queue overflows       %llu\n", (unsigned long long)atomic_load(&g_overflows));
+
+    for (uint32_t i = 0; i < clients; i++) {
+        free(states[i].rtts);
+    }
+    free(states);
+    free(threads);
+    free(rtts);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,346 @@
+//
+//  kimirun_log_ring.c
+//  KimiRun - Async log ring check / benchmark
+//
+//  Host-side tool (not part of the theos targets) for KimiRunLogRing:
+//    check  several producers push numbered records (random lengths, some
+//           past KIMIRUN_LOG_PAYLOAD_MAX) and retry when the ring is full;
+//           after KimiRunLogRingFlush every record is in the file exactly
+//           once, in per-producer order, truncated exactly when it was too
+//           long, and the counters agree (dropped == refused pushes). Then
+//           the writer must stay parked while idle: one push after a quiet
+//           period costs exactly one wakeup
+//    bench  uncontended push cost, multi-producer throughput, and the
+//           latency from a push into an idle ring until the line is in
+//           the file (the old writer polled every 5 ms)
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_log_ring.c modules/log/KimiRunLogRing.c
+//       -lpthread -o kimirun_log_ring
+//
+//  Usage:
+//    kimirun_log_ring check [-n records per producer] [-p producers] [-o file]
+//    kimirun_log_ring bench [-n records per producer] [-p producers] [-o file]
+//
+//  The ring is process-wide, so each run exercises one configuration.
+//  The output file (default /tmp/kimirun_log_ring.<pid>.log) is removed
+//  on exit.
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage or I/O error.
+//
+
+#include "log/KimiRunLogRing.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kRingMaxProducers 64
+#define kRingMaxFiller 600
+#define kRingFlushMillis 10000
+#define kRingLatencySamples 400
+
+static size_t g_failures = 0;
+
+typedef struct {
+    unsigned id;
+    unsigned records;
+    uint64_t seed;
+    uint64_t refused;
+    uint64_t pushNanos;
+} RingProducer;
+
+static uint64_t RingNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t RingRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return (uint32_t)(*state >> 33);
+}
+
+static void RingSleepMillis(unsigned millis) {
+    struct timespec pause = { millis / 1000, (long)(millis % 1000) * 1000000L };
+    nanosleep(&pause, NULL);
+}
+
+static void RingFail(const char *what, unsigned producer, unsigned sequence) {
+    if (g_failures < 20) {
+        fprintf(stderr, "FAIL producer %u seq %u: %s\n", producer, sequence, what);
+    }
+    g_failures++;
+}
+
+// Filler length for (producer, sequence); the checker recomputes it.
+static size_t RingFillerLength(unsigned producer, unsigned sequence) {
+    uint64_t state = ((uint64_t)producer << 32) ^ sequence ^ 0x10c0ffeeull;
+    RingRandom(&state);
+    return RingRandom(&state) % kRingMaxFiller;
+}
+
+static void RingPushUntilAccepted(RingProducer *producer, const char *tag, const char *payload, size_t length) {
+    while (!KimiRunLogRingPush(KimiRunLogLevelInfo, tag, payload, length)) {
+        producer->refused++;
+        sched_yield();
+    }
+}
+
+static void *RingProducerMain(void *argument) {
+    RingProducer *producer = argument;
+    char tag[16];
+    char payload[64 + kRingMaxFiller];
+    snprintf(tag, sizeof(tag), "t%u", producer->id);
+    uint64_t start = RingNowNanos();
+    for (unsigned sequence = 0; sequence < producer->records; sequence++) {
+        int head = snprintf(payload, sizeof(payload), "p=%u seq=%u ", producer->id, sequence);
+        size_t filler = RingFillerLength(producer->id, sequence);
+        memset(payload + head, 'a' + (char)(sequence % 26), filler);
+        RingPushUntilAccepted(producer, tag, payload, (size_t)head + filler);
+    }
+    producer->pushNanos = RingNowNanos() - start;
+    return NULL;
+}
+
+static uint64_t RingRunProducers(RingProducer *producers, unsigned count, unsigned records) {
+    pthread_t threads[kRingMaxProducers];
+    uint64_t refused = 0;
+    for (unsigned i = 0; i < count; i++) {
+        producers[i] = (RingProducer){ .id = i, .records = records };
+        pthread_create(&threads[i], NULL, RingProducerMain, &producers[i]);
+    }
+    for (unsigned i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+        refused += producers[i].refused;
+    }
+    return refused;
+}
+
+// Each line: "YYYY-MM-DD HH:MM:SS.mmm I [tN] p=N seq=S <filler>[ ...(truncated)]".
+static void RingVerifyLine(const char *line, size_t length, unsigned producers, unsigned *next) {
+    const char *bracket = memchr(line, '[', length);
+    unsigned tagId = 0;
+    unsigned producer = 0;
+    unsigned sequence = 0;
+    int consumed = 0;
+    if (!bracket || sscanf(bracket, "[t%u] p=%u seq=%u %n", &tagId, &producer, &sequence, &consumed) != 3 ||
+        consumed == 0 || tagId != producer || producer >= producers) {
+        RingFail("unparsable line", producer, sequence);
+        return;
+    }
+    if (sequence != next[producer]) {
+        RingFail("out of order or missing", producer, sequence);
+    }
+    next[producer] = sequence + 1;
+
+    const char *filler = bracket + consumed;
+    size_t fillerLength = length - (size_t)(filler - line);
+    static const char kTruncated[] = " ...(truncated)";
+    size_t markerLength = sizeof(kTruncated) - 1;
+    bool truncated = fillerLength >= markerLength &&
+                     memcmp(filler + fillerLength - markerLength, kTruncated, markerLength) == 0;
+    if (truncated) {
+        fillerLength -= markerLength;
+    }
+    size_t headLength = (size_t)(filler - bracket) - (size_t)(strchr(bracket, ' ') + 1 - bracket);
+    size_t expected = RingFillerLength(producer, sequence);
+    bool tooLong = headLength + expected > KIMIRUN_LOG_PAYLOAD_MAX;
+    if (truncated != tooLong) {
+        RingFail("truncation flag wrong", producer, sequence);
+    } else if (!tooLong && fillerLength != expected) {
+        RingFail("payload length wrong", producer, sequence);
+    }
+    for (size_t i = 0; i < fillerLength; i++) {
+        if (filler[i] != 'a' + (char)(sequence % 26)) {
+            RingFail("payload bytes wrong", producer, sequence);
+            break;
+        }
+    }
+}
+
+static void RingVerifyFile(const char *path, unsigned producers, unsigned records) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        RingFail("log file missing", 0, 0);
+        return;
+    }
+    unsigned next[kRingMaxProducers] = {0};
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, file)) > 0) {
+        if (line[length - 1] == '\n') {
+            line[--length] = '\0';
+        }
+        RingVerifyLine(line, (size_t)length, producers, next);
+    }
+    free(line);
+    fclose(file);
+    for (unsigned i = 0; i < producers; i++) {
+        if (next[i] != records) {
+            RingFail("records lost at the tail", i, next[i]);
+        }
+    }
+}
+
+static int RingCheck(const char *path, unsigned producers, unsigned records) {
+    KimiRunLogRingConfigure(path, 0, 0);
+    RingProducer workers[kRingMaxProducers];
+    uint64_t refused = RingRunProducers(workers, producers, records);
+    if (!KimiRunLogRingFlush(kRingFlushMillis)) {
+        RingFail("flush timed out", 0, 0);
+    }
+
+    KimiRunLogRingStats stats;
+    KimiRunLogRingGetStats(&stats);
+    uint64_t total = (uint64_t)producers * records;
+    if (stats.enqueued != total || stats.written != total) {
+        RingFail("enqueued/written counters wrong", 0, 0);
+    }
+    if (stats.dropped != refused) {
+        RingFail("dropped counter does not match refused pushes", 0, 0);
+    }
+    if (stats.writeErrors != 0) {
+        RingFail("write errors", 0, 0);
+    }
+    RingVerifyFile(path, producers, records);
+
+    // A polling writer would not count wakeups at all; a parked one is
+    // woken exactly once by the first push after a quiet period.
+    RingSleepMillis(50);
+    KimiRunLogRingGetStats(&stats);
+    uint64_t wakeupsBefore = stats.wakeups;
+    RingSleepMillis(50);
+    KimiRunLogRingGetStats(&stats);
+    if (stats.wakeups != wakeupsBefore) {
+        RingFail("writer woke while the ring was empty", 0, 0);
+    }
+    KimiRunLogRingPush(KimiRunLogLevelWarn, "idle", "one", 3);
+    if (!KimiRunLogRingFlush(kRingFlushMillis)) {
+        RingFail("flush after idle timed out", 0, 0);
+    }
+    KimiRunLogRingGetStats(&stats);
+    if (stats.wakeups != wakeupsBefore + 1) {
+        RingFail("idle push did not wake the writer exactly once", 0, 0);
+    }
+
+    printf("check: %u producers x %u records, %llu refused pushes, %llu wakeups, %zu failures\n",
+           producers, records, (unsigned long long)refused, (unsigned long long)stats.wakeups, g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static int RingCompareU64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int RingBench(const char *path, unsigned producers, unsigned records) {
+    KimiRunLogRingConfigure(path, 2 * 1024 * 1024, 2);
+    static const char kLine[] = "BKS dispatch phase=move x=201.5 y=433.0 route=sim latency=0.42ms";
+
+    // Uncontended: bursts below the ring capacity so nothing is refused.
+    RingProducer single = {0};
+    uint64_t pushNanos = 0;
+    uint64_t pushes = 0;
+    for (unsigned burst = 0; burst < 200; burst++) {
+        uint64_t start = RingNowNanos();
+        for (unsigned i = 0; i < KIMIRUN_LOG_RING_CAPACITY / 2; i++) {
+            RingPushUntilAccepted(&single, "bench", kLine, sizeof(kLine) - 1);
+        }
+        pushNanos += RingNowNanos() - start;
+        pushes += KIMIRUN_LOG_RING_CAPACITY / 2;
+        KimiRunLogRingFlush(kRingFlushMillis);
+    }
+    printf("push, 1 producer:      %7.1f ns/record\n", (double)pushNanos / (double)pushes);
+
+    RingProducer workers[kRingMaxProducers];
+    uint64_t start = RingNowNanos();
+    uint64_t refused = RingRunProducers(workers, producers, records);
+    KimiRunLogRingFlush(kRingFlushMillis);
+    double seconds = (double)(RingNowNanos() - start) / 1e9;
+    uint64_t total = (uint64_t)producers * records;
+    printf("%2u producers:          %7.0f records/s to disk, %llu refused pushes\n",
+           producers, (double)total / seconds, (unsigned long long)refused);
+
+    // Idle ring: the writer is parked when each record arrives.
+    uint64_t samples[kRingLatencySamples];
+    for (unsigned i = 0; i < kRingLatencySamples; i++) {
+        RingSleepMillis(2);
+        uint64_t pushed = RingNowNanos();
+        KimiRunLogRingPush(KimiRunLogLevelInfo, "bench", kLine, sizeof(kLine) - 1);
+        KimiRunLogRingFlush(kRingFlushMillis);
+        samples[i] = RingNowNanos() - pushed;
+    }
+    qsort(samples, kRingLatencySamples, sizeof(samples[0]), RingCompareU64);
+    printf("idle push -> in file:  p50 %6.1f us  p99 %6.1f us  max %6.1f us\n",
+           (double)samples[kRingLatencySamples / 2] / 1e3,
+           (double)samples[kRingLatencySamples * 99 / 100] / 1e3,
+           (double)samples[kRingLatencySamples - 1] / 1e3);
+
+    KimiRunLogRingStats stats;
+    KimiRunLogRingGetStats(&stats);
+    printf("written %llu, rotations %llu, wakeups %llu, write errors %llu\n",
+           (unsigned long long)stats.written, (unsigned long long)stats.rotations,
+           (unsigned long long)stats.wakeups, (unsigned long long)stats.writeErrors);
+    return 0;
+}
+
+static void RingRemoveFiles(const char *path) {
+    char rotated[1100];
+    unlink(path);
+    for (unsigned generation = 1; generation <= 2; generation++) {
+        snprintf(rotated, sizeof(rotated), "%s.%u", path, generation);
+        unlink(rotated);
+    }
+}
+
+static void RingUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check|bench [-n records] [-p producers] [-o file]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        RingUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    unsigned records = 0;
+    unsigned producers = 8;
+    char path[1024];
+    snprintf(path, sizeof(path), "/tmp/kimirun_log_ring.%d.log", (int)getpid());
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:p:o:h")) != -1) {
+        switch (opt) {
+            case 'n': records = (unsigned)strtoul(optarg, NULL, 10); break;
+            case 'p': producers = (unsigned)strtoul(optarg, NULL, 10); break;
+            case 'o': snprintf(path, sizeof(path), "%s", optarg); break;
+            default:
+                RingUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (producers == 0 || producers > kRingMaxProducers) {
+        RingUsage(argv[0]);
+        return 2;
+    }
+    RingRemoveFiles(path);
+    int status;
+    if (strcmp(mode, "check") == 0) {
+        status = RingCheck(path, producers, records ? records : 20000);
+    } else if (strcmp(mode, "bench") == 0) {
+        status = RingBench(path, producers, records ? records : 50000);
+    } else {
+        RingUsage(argv[0]);
+        return 2;
+    }
+    RingRemoveFiles(path);
+    return status;
+}
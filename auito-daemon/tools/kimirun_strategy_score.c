@@ -0,0 +1,324 @@
+//
+//  kimirun_strategy_score.c
+//  KimiRun - Adaptive strategy scoring check
+//
+//  Host-side tool (not part of the theos targets) for KimiRunStrategyScore.
+//  Feeds synthetic outcome streams through a table configured with the
+//  router's priors (TouchInjectionStrategyRouter.m) and checks:
+//    - cold keys keep the static order; duplicates and bad ids are dropped
+//    - a measured but slow BKS (accepted, p50 >= 8 ms) is not overtaken by
+//      backends that only have priors
+//    - a trusted, clearly cheaper backend moves ahead, and falls back to its
+//      static slot once its samples decay below minSamples
+//    - scores: counters, prior smoothing, p50 inside the sample's bucket
+//    - eviction of the stalest key when the table is full
+//    - random streams: the output is a permutation of the unique valid
+//      candidates, no untrusted candidate overtakes anything, and a trusted
+//      one only overtakes entries it beats by reorderMargin
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_strategy_score.c modules/strategy/KimiRunStrategyScore.c
+//       -lm -o kimirun_strategy_score
+//
+//  Usage:
+//    kimirun_strategy_score check [-n iterations] [-s seed]
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage error.
+//
+
+#include "strategy/KimiRunStrategyScore.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Backend ids as in TouchInjectionInternal.h.
+enum { kBKS = 1, kSim = 2, kConn = 3, kLegacy = 4 };
+
+#define kGestureTap 1
+#define kBundle "com.apple.Preferences"
+
+static size_t g_failures = 0;
+
+static void ScoreFail(uint64_t iteration, const char *what) {
+    if (g_failures < 20) {
+        fprintf(stderr, "FAIL [%llu] %s\n", (unsigned long long)iteration, what);
+    }
+    g_failures++;
+}
+
+static uint32_t ScoreRandom(uint64_t *state) {
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    return (uint32_t)(*state >> 33);
+}
+
+static double ScoreUniform(uint64_t *state) {
+    return (double)ScoreRandom(state) / 4294967296.0;
+}
+
+static void ScoreRouterTable(KimiRunStrategyTable *table) {
+    KimiRunStrategyConfig config;
+    KimiRunStrategyConfigDefaults(&config);
+    config.priorVerified[kBKS] = 0.85;
+    config.priorVerified[kSim] = 0.4;
+    config.priorVerified[kConn] = 0.4;
+    config.priorVerified[kLegacy] = 0.4;
+    config.priorLatencyMs[kBKS] = 4.0;
+    config.priorLatencyMs[kSim] = 1.0;
+    config.priorLatencyMs[kConn] = 1.0;
+    config.priorLatencyMs[kLegacy] = 1.0;
+    KimiRunStrategyTableInit(table, &config);
+}
+
+static bool ScoreOrderIs(const KimiRunStrategyTable *table, double now,
+                         const uint8_t *candidates, size_t count,
+                         const uint8_t *expected, size_t expectedCount) {
+    uint8_t out[KIMIRUN_STRATEGY_MAX_BACKENDS];
+    size_t n = KimiRunStrategyOrder(table, kBundle, kGestureTap, candidates, count, now, out);
+    return n == expectedCount && memcmp(out, expected, n) == 0;
+}
+
+static const uint8_t kStatic[] = { kBKS, kSim, kConn, kLegacy };
+
+static void ScoreCheckCold(void) {
+    KimiRunStrategyTable table;
+    ScoreRouterTable(&table);
+    if (!ScoreOrderIs(&table, 0.0, kStatic, 4, kStatic, 4)) {
+        ScoreFail(0, "cold key does not keep the static order");
+    }
+    const uint8_t messy[] = { kSim, kSim, 9, kBKS, KIMIRUN_STRATEGY_MAX_BACKENDS, kSim };
+    const uint8_t cleaned[] = { kSim, kBKS };
+    if (!ScoreOrderIs(&table, 0.0, messy, sizeof(messy), cleaned, sizeof(cleaned))) {
+        ScoreFail(0, "duplicates or invalid ids not dropped");
+    }
+}
+
+// The regression: priors alone used to put sim, conn and legacy ahead of a
+// BKS that had been measured as accepted but slow.
+static void ScoreCheckSlowTrustedBKS(void) {
+    KimiRunStrategyTable table;
+    ScoreRouterTable(&table);
+    double now = 100.0;
+    for (int i = 0; i < 10; i++) {
+        KimiRunStrategyRecordAttempt(&table, kBundle, kGestureTap, kBKS, true, 8.0 + 0.5 * i, now);
+        now += 0.5;
+    }
+    KimiRunStrategyScore score;
+    KimiRunStrategyGetScore(&table, kBundle, kGestureTap, kBKS, now, &score);
+    if (score.p50LatencyMs < 6.0) {
+        ScoreFail(0, "slow BKS samples did not raise p50");
+    }
+    if (!ScoreOrderIs(&table, now, kStatic, 4, kStatic, 4)) {
+        ScoreFail(0, "untrusted backends overtook a measured BKS on priors");
+    }
+}
+
+static void ScoreCheckTrustedCheaperMoves(void) {
+    KimiRunStrategyTable table;
+    ScoreRouterTable(&table);
+    double now = 100.0;
+    for (int i = 0; i < 10; i++) {
+        KimiRunStrategyRecordAttempt(&table, kBundle, kGestureTap, kBKS, true, 9.0, now);
+        KimiRunStrategyRecordVerification(&table, kBundle, kGestureTap, kBKS, i % 2 == 0, now);
+        KimiRunStrategyRecordAttempt(&table, kBundle, kGestureTap, kConn, true, 0.3, now);
+        KimiRunStrategyRecordVerification(&table, kBundle, kGestureTap, kConn, true, now);
+        now += 0.5;
+    }
+    const uint8_t connFirst[] = { kConn, kBKS, kSim, kLegacy };
+    if (!ScoreOrderIs(&table, now, kStatic, 4, connFirst, 4)) {
+        ScoreFail(0, "trusted cheaper backend did not move ahead");
+    }
+
+    // Ten half-lives later conn has ~0.01 samples left: back to static.
+    double later = now + 10.0 * table.config.halfLifeSeconds;
+    if (!ScoreOrderIs(&table, later, kStatic, 4, kStatic, 4)) {
+        ScoreFail(0, "decayed evidence still reorders");
+    }
+}
+
+static void ScoreCheckScores(void) {
+    KimiRunStrategyTable table;
+    ScoreRouterTable(&table);
+    for (int i = 0; i < 6; i++) {
+        KimiRunStrategyRecordAttempt(&table, kBundle, kGestureTap, kSim, i < 3, 3.0, 10.0);
+    }
+    KimiRunStrategyRecordVerification(&table, kBundle, kGestureTap, kSim, true, 10.0);
+    KimiRunStrategyScore score;
+    if (!KimiRunStrategyGetScore(&table, kBundle, kGestureTap, kSim, 10.0, &score)) {
+        ScoreFail(0, "valid backend rejected");
+        return;
+    }
+    const KimiRunStrategyConfig *config = &table.config;
+    double acceptance = (3.0 + config->priorAcceptance * config->priorWeight) / (6.0 + config->priorWeight);
+    double verified = (1.0 + config->priorVerified[kSim] * config->priorWeight) / (1.0 + config->priorWeight);
+    if (score.totalAttempts != 6 || score.totalAccepts != 3 ||
+        score.totalVerifications != 1 || score.totalVerified != 1 || fabs(score.samples - 6.0) > 1e-9) {
+        ScoreFail(0, "counters wrong");
+    }
+    if (fabs(score.acceptanceRate - acceptance) > 1e-9 || fabs(score.verifiedRate - verified) > 1e-9) {
+        ScoreFail(0, "prior smoothing wrong");
+    }
+    // 3 ms falls in [2, 4); blended 6:2 with the 1 ms prior.
+    if (score.p50LatencyMs < (2.0 * 6.0 + 1.0 * 2.0) / 8.0 || score.p50LatencyMs >= (4.0 * 6.0 + 1.0 * 2.0) / 8.0) {
+        ScoreFail(0, "p50 outside the sample bucket");
+    }
+    KimiRunStrategyGetScore(&table, kBundle, kGestureTap, kSim, 10.0 + config->halfLifeSeconds, &score);
+    if (fabs(score.samples - 3.0) > 1e-9) {
+        ScoreFail(0, "samples do not halve after one half-life");
+    }
+    if (KimiRunStrategyGetScore(&table, kBundle, kGestureTap, KIMIRUN_STRATEGY_MAX_BACKENDS, 10.0, &score)) {
+        ScoreFail(0, "invalid backend scored");
+    }
+}
+
+static void ScoreCheckEviction(void) {
+    KimiRunStrategyTable table;
+    ScoreRouterTable(&table);
+    char bundle[32];
+    for (int i = 0; i <= KIMIRUN_STRATEGY_MAX_ENTRIES; i++) {
+        snprintf(bundle, sizeof(bundle), "com.example.app%d", i);
+        KimiRunStrategyRecordAttempt(&table, bundle, kGestureTap, kSim, true, 1.0, (double)i);
+    }
+    KimiRunStrategyScore score;
+    KimiRunStrategyGetScore(&table, "com.example.app0", kGestureTap, kSim, 1000.0, &score);
+    if (table.evictions != 1 || score.totalAttempts != 0) {
+        ScoreFail(0, "stalest entry not evicted");
+    }
+    KimiRunStrategyScore snapshot[4];
+    size_t n = KimiRunStrategySnapshot(&table, 1000.0, snapshot, 4);
+    if (n != 4 || strcmp(snapshot[0].bundle, "com.example.app96") != 0 ||
+        snapshot[0].ageSeconds > snapshot[3].ageSeconds) {
+        ScoreFail(0, "snapshot not most recent first");
+    }
+}
+
+// One synthetic backend: acceptance, verification and latency behaviour.
+typedef struct {
+    double acceptance;
+    double verified;
+    double latencyMs;
+} ScoreBehaviour;
+
+static void ScoreCheckRandom(uint64_t iterations, uint64_t seed) {
+    uint64_t rng = seed ? seed : 0x5eed0032ull;
+    for (uint64_t iteration = 0; iteration < iterations; iteration++) {
+        KimiRunStrategyTable table;
+        ScoreRouterTable(&table);
+        ScoreBehaviour behaviour[KIMIRUN_STRATEGY_MAX_BACKENDS];
+        for (unsigned b = 0; b < KIMIRUN_STRATEGY_MAX_BACKENDS; b++) {
+            behaviour[b].acceptance = ScoreUniform(&rng);
+            behaviour[b].verified = ScoreUniform(&rng);
+            behaviour[b].latencyMs = 0.1 + 20.0 * ScoreUniform(&rng);
+        }
+        double now = 0.0;
+        unsigned events = ScoreRandom(&rng) % 80;
+        for (unsigned e = 0; e < events; e++) {
+            uint8_t backend = (uint8_t)(ScoreRandom(&rng) % KIMIRUN_STRATEGY_MAX_BACKENDS);
+            const ScoreBehaviour *b = &behaviour[backend];
+            bool accepted = ScoreUniform(&rng) < b->acceptance;
+            double latency = b->latencyMs * (0.5 + ScoreUniform(&rng));
+            KimiRunStrategyRecordAttempt(&table, kBundle, kGestureTap, backend, accepted, latency, now);
+            if (accepted && ScoreUniform(&rng) < 0.5) {
+                KimiRunStrategyRecordVerification(&table, kBundle, kGestureTap, backend,
+                                                  ScoreUniform(&rng) < b->verified, now);
+            }
+            now += 60.0 * ScoreUniform(&rng);
+        }
+
+        uint8_t candidates[12];
+        size_t count = 1 + ScoreRandom(&rng) % 12;
+        for (size_t i = 0; i < count; i++) {
+            candidates[i] = (uint8_t)(ScoreRandom(&rng) % (KIMIRUN_STRATEGY_MAX_BACKENDS + 2));
+        }
+        uint8_t unique[KIMIRUN_STRATEGY_MAX_BACKENDS];
+        size_t uniqueCount = 0;
+        bool seen[KIMIRUN_STRATEGY_MAX_BACKENDS + 2] = {false};
+        for (size_t i = 0; i < count; i++) {
+            if (candidates[i] < KIMIRUN_STRATEGY_MAX_BACKENDS && !seen[candidates[i]]) {
+                seen[candidates[i]] = true;
+                unique[uniqueCount++] = candidates[i];
+            }
+        }
+
+        uint8_t out[KIMIRUN_STRATEGY_MAX_BACKENDS];
+        size_t n = KimiRunStrategyOrder(&table, kBundle, kGestureTap, candidates, count, now, out);
+        if (n != uniqueCount) {
+            ScoreFail(iteration, "output is not the unique valid candidates");
+            continue;
+        }
+        int position[KIMIRUN_STRATEGY_MAX_BACKENDS];
+        for (size_t i = 0; i < KIMIRUN_STRATEGY_MAX_BACKENDS; i++) {
+            position[i] = -1;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (out[i] >= KIMIRUN_STRATEGY_MAX_BACKENDS || !seen[out[i]] || position[out[i]] >= 0) {
+                ScoreFail(iteration, "output is not a permutation");
+                break;
+            }
+            position[out[i]] = (int)i;
+        }
+
+        double margin = 1.0 + table.config.reorderMargin;
+        for (size_t later = 1; later < uniqueCount; later++) {
+            KimiRunStrategyScore laterScore;
+            KimiRunStrategyGetScore(&table, kBundle, kGestureTap, unique[later], now, &laterScore);
+            bool trusted = laterScore.samples >= table.config.minSamples;
+            for (size_t earlier = 0; earlier < later; earlier++) {
+                if (position[unique[later]] > position[unique[earlier]]) {
+                    continue;
+                }
+                KimiRunStrategyScore earlierScore;
+                KimiRunStrategyGetScore(&table, kBundle, kGestureTap, unique[earlier], now, &earlierScore);
+                if (!trusted) {
+                    ScoreFail(iteration, "untrusted candidate overtook another");
+                } else if (!(laterScore.expectedCostMs * margin < earlierScore.expectedCostMs)) {
+                    ScoreFail(iteration, "trusted candidate overtook one it does not clearly beat");
+                }
+            }
+        }
+    }
+}
+
+static int ScoreCheck(uint64_t iterations, uint64_t seed) {
+    ScoreCheckCold();
+    ScoreCheckSlowTrustedBKS();
+    ScoreCheckTrustedCheaperMoves();
+    ScoreCheckScores();
+    ScoreCheckEviction();
+    ScoreCheckRandom(iterations, seed);
+    printf("check: %llu random streams, %zu failures\n", (unsigned long long)iterations, g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static void ScoreUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s check [-n iterations] [-s seed]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        ScoreUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                ScoreUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (strcmp(mode, "check") == 0) {
+        return ScoreCheck(iterations ? iterations : 20000, seed);
+    }
+    ScoreUsage(argv[0]);
+    return 2;
+}
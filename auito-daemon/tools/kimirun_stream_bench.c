@@ -0,0 +1,386 @@
+//
+//  kimirun_stream_bench.c
+//  KimiRun - Stream server framing check / benchmark
+//
+//  Host-side tool (not part of the theos targets). Runs the portable
+//  KimiRunStreamServer on loopback with a ZXTouch-shaped line handler and
+//  drives it from many concurrent clients:
+//    - every client streams numbered "10..." touch lines, either fragmented
+//      into random 1..n byte writes or pipelined many lines per write
+//    - the server checks each line's shape and per-connection ordering and
+//      answers "0\r\n" per line, which the client counts
+//    - one client sends an oversized line and a framing switch to 8-byte
+//      records to check recovery and fixed-size framing
+//  then reports commands per second across all clients.
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -D_POSIX_C_SOURCE=200809L -Imodules
+//       tools/kimirun_stream_bench.c modules/socket/KimiRunStreamServer.c
+//       -lpthread -o kimirun_stream_bench
+//
+//  Usage:
+//    kimirun_stream_bench [-c clients] [-n lines] [-f max_fragment] [-p lines_per_write]
+//
+//  Exit status: 0 clean, 1 framing or ordering errors, 2 usage or I/O error.
+//
+
+#include "socket/KimiRunStreamServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kBenchLineLength 18            // "10" + "1" + type + ff + x5 + y5 + "\r\n"
+#define kBenchRecordSize 8
+
+typedef struct {
+    uint32_t expectedSeq;
+    uint32_t client;
+    bool clientKnown;
+    bool binary;
+} BenchConnection;
+
+typedef struct {
+    atomic_uint_fast64_t lines;
+    atomic_uint_fast64_t records;
+    atomic_uint_fast64_t shapeErrors;
+    atomic_uint_fast64_t orderErrors;
+    atomic_uint_fast64_t oversizeReplies;
+} BenchServerReport;
+
+typedef struct {
+    uint16_t port;
+    uint32_t client;
+    uint32_t lines;
+    uint32_t maxFragment;
+    uint32_t linesPerWrite;
+    bool probe;                       // oversize + framing switch client
+    uint64_t replies;
+    bool failed;
+} BenchClient;
+
+static BenchServerReport g_report;
+
+static uint64_t BenchNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static bool BenchParseDigits(const uint8_t *bytes, size_t count, uint32_t *out) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (bytes[i] < '0' || bytes[i] > '9') {
+            return false;
+        }
+        value = (value * 10) + (uint32_t)(bytes[i] - '0');
+    }
+    *out = value;
+    return true;
+}
+
+static void BenchOnOpen(void *context, KimiRunStreamConnection *conn) {
+    (void)context;
+    KimiRunStreamConnectionSetUserData(conn, calloc(1, sizeof(BenchConnection)));
+}
+
+static void BenchOnClose(void *context, KimiRunStreamConnection *conn) {
+    (void)context;
+    free(KimiRunStreamConnectionUserData(conn));
+}
+
+static void BenchOnOversize(void *context, KimiRunStreamConnection *conn) {
+    (void)context;
+    atomic_fetch_add(&g_report.oversizeReplies, 1);
+    KimiRunStreamConnectionSend(conn, "E\r\n", 3);
+}
+
+// Lines: "101" type(1) finger(2) x(5) y(5), where x carries the sequence
+// number and y the client id. "BIN" switches to 8-byte records of
+// (uint32 seq, uint32 client).
+static void BenchOnFrame(void *context, KimiRunStreamConnection *conn, const uint8_t *bytes, size_t length) {
+    (void)context;
+    BenchConnection *state = KimiRunStreamConnectionUserData(conn);
+    if (state->binary) {
+        uint32_t seq = 0;
+        memcpy(&seq, bytes, sizeof(seq));
+        if (length != kBenchRecordSize || seq != state->expectedSeq) {
+            atomic_fetch_add(&g_report.orderErrors, 1);
+        }
+        state->expectedSeq = seq + 1;
+        atomic_fetch_add(&g_report.records, 1);
+        KimiRunStreamConnectionSend(conn, "0\r\n", 3);
+        return;
+    }
+    if (length == 3 && memcmp(bytes, "BIN", 3) == 0) {
+        state->binary = true;
+        state->expectedSeq = 0;
+        KimiRunStreamConnectionSetFraming(conn, KimiRunStreamFramingFixed, kBenchRecordSize);
+        return;
+    }
+    uint32_t type = 0;
+    uint32_t finger = 0;
+    uint32_t seq = 0;
+    uint32_t client = 0;
+    if (length != kBenchLineLength - 2 || memcmp(bytes, "101", 3) != 0 ||
+        !BenchParseDigits(bytes + 3, 1, &type) ||
+        !BenchParseDigits(bytes + 4, 2, &finger) ||
+        !BenchParseDigits(bytes + 6, 5, &seq) ||
+        !BenchParseDigits(bytes + 11, 5, &client) ||
+        type > 2) {
+        atomic_fetch_add(&g_report.shapeErrors, 1);
+        KimiRunStreamConnectionSend(conn, "E\r\n", 3);
+        return;
+    }
+    if (!state->clientKnown) {
+        state->clientKnown = true;
+        state->client = client;
+    }
+    if (client != state->client || seq != state->expectedSeq % 100000) {
+        atomic_fetch_add(&g_report.orderErrors, 1);
+    }
+    state->expectedSeq++;
+    atomic_fetch_add(&g_report.lines, 1);
+    KimiRunStreamConnectionSend(conn, "0\r\n", 3);
+}
+
+static void *BenchServerThread(void *arg) {
+    KimiRunStreamServerRun((KimiRunStreamServer *)arg);
+    return NULL;
+}
+
+static int BenchConnect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool BenchWriteAll(int fd, const char *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(fd, bytes, length, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// Counts replies; each is 3 bytes ("0\r\n" or "E\r\n").
+static void BenchReadReplies(int fd, BenchClient *client, uint64_t *replyBytes, int flags) {
+    char scratch[4096];
+    for (;;) {
+        ssize_t n = recv(fd, scratch, sizeof(scratch), flags);
+        if (n > 0) {
+            *replyBytes += (uint64_t)n;
+            if (flags == 0) {
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            client->failed = true;
+        }
+        return;
+    }
+}
+
+static void *BenchClientThread(void *arg) {
+    BenchClient *client = (BenchClient *)arg;
+    int fd = BenchConnect(client->port);
+    if (fd < 0) {
+        client->failed = true;
+        return NULL;
+    }
+    unsigned seed = client->client * 2654435761u + 1;
+    size_t chunkLines = client->linesPerWrite ? client->linesPerWrite : 1;
+    char *buffer = malloc(chunkLines * kBenchLineLength + 1);
+    uint64_t replyBytes = 0;
+    uint64_t expectedReplies = client->lines;
+
+    if (client->probe) {
+        // An oversized line must be answered once and not eat the next line.
+        size_t big = KIMIRUN_STREAM_DEFAULT_MAX_FRAME * 3;
+        char *junk = malloc(big);
+        memset(junk, 'x', big);
+        BenchWriteAll(fd, junk, big);
+        BenchWriteAll(fd, "\r\n", 2);
+        free(junk);
+        expectedReplies++;
+    }
+
+    for (uint32_t sent = 0; sent < client->lines && !client->failed;) {
+        size_t batch = 0;
+        size_t length = 0;
+        while (batch < chunkLines && sent < client->lines) {
+            int type = (sent == 0) ? 1 : ((sent + 1 == client->lines) ? 0 : 2);
+            length += (size_t)snprintf(buffer + length, kBenchLineLength + 1, "101%d%02d%05u%05u\r\n",
+                                       type, 1, sent % 100000, client->client);
+            batch++;
+            sent++;
+        }
+        if (client->maxFragment > 0) {
+            size_t offset = 0;
+            while (offset < length) {
+                size_t piece = 1 + (size_t)(rand_r(&seed) % client->maxFragment);
+                if (piece > length - offset) {
+                    piece = length - offset;
+                }
+                if (!BenchWriteAll(fd, buffer + offset, piece)) {
+                    client->failed = true;
+                    break;
+                }
+                offset += piece;
+            }
+        } else if (!BenchWriteAll(fd, buffer, length)) {
+            client->failed = true;
+        }
+        BenchReadReplies(fd, client, &replyBytes, MSG_DONTWAIT);
+    }
+
+    if (client->probe && !client->failed) {
+        // Switch to fixed 8-byte records mid-stream, in the same write as
+        // the first records.
+        char mixed[3 + 2 + 4 * kBenchRecordSize];
+        memcpy(mixed, "BIN\r\n", 5);
+        for (uint32_t i = 0; i < 4; i++) {
+            uint32_t record[2] = { i, client->client };
+            memcpy(mixed + 5 + (i * kBenchRecordSize), record, sizeof(record));
+        }
+        BenchWriteAll(fd, mixed, sizeof(mixed));
+        expectedReplies += 4;
+    }
+
+    while (!client->failed && replyBytes < expectedReplies * 3) {
+        BenchReadReplies(fd, client, &replyBytes, 0);
+    }
+    client->replies = replyBytes / 3;
+    free(buffer);
+    close(fd);
+    return NULL;
+}
+
+static void BenchUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-c clients] [-n lines] [-f max_fragment] [-p lines_per_write]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t clients = 32;
+    uint32_t lines = 20000;
+    uint32_t maxFragment = 7;
+    uint32_t linesPerWrite = 64;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:f:p:h")) != -1) {
+        switch (opt) {
+            case 'c': clients = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'n': lines = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'f': maxFragment = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'p': linesPerWrite = (uint32_t)strtoul(optarg, NULL, 10); break;
+            default:
+                BenchUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (clients < 2 || lines == 0 || clients > KIMIRUN_STREAM_DEFAULT_MAX_CONNECTIONS) {
+        BenchUsage(argv[0]);
+        return 2;
+    }
+
+    KimiRunStreamCallbacks callbacks = {
+        .onOpen = BenchOnOpen,
+        .onFrame = BenchOnFrame,
+        .onOversize = BenchOnOversize,
+        .onClose = BenchOnClose
+    };
+    KimiRunStreamServer *server = KimiRunStreamServerCreate(NULL, &callbacks);
+    uint16_t port = 0;
+    if (!server || !KimiRunStreamServerListenTCP(server, "127.0.0.1", 0, &port)) {
+        fprintf(stderr, "cannot start server: %s\n", strerror(errno));
+        return 2;
+    }
+    pthread_t serverThread;
+    pthread_create(&serverThread, NULL, BenchServerThread, server);
+
+    // Half the clients fragment every write, half pipeline whole batches.
+    BenchClient *workers = calloc(clients, sizeof(*workers));
+    pthread_t *threads = calloc(clients, sizeof(*threads));
+    uint64_t start = BenchNowNanos();
+    for (uint32_t i = 0; i < clients; i++) {
+        workers[i].port = port;
+        workers[i].client = i;
+        workers[i].lines = lines;
+        workers[i].maxFragment = (i % 2 == 0) ? maxFragment : 0;
+        workers[i].linesPerWrite = linesPerWrite;
+        workers[i].probe = (i == 0);
+        pthread_create(&threads[i], NULL, BenchClientThread, &workers[i]);
+    }
+    uint64_t replies = 0;
+    uint32_t failedClients = 0;
+    for (uint32_t i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+        replies += workers[i].replies;
+        if (workers[i].failed) {
+            failedClients++;
+        }
+    }
+    double seconds = (double)(BenchNowNanos() - start) / 1e9;
+
+    KimiRunStreamServerStop(server);
+    pthread_join(serverThread, NULL);
+    KimiRunStreamServerStats stats;
+    KimiRunStreamServerGetStats(server, &stats);
+    KimiRunStreamServerDestroy(server);
+
+    uint64_t expectedLines = (uint64_t)clients * lines;
+    uint64_t linesSeen = atomic_load(&g_report.lines);
+    uint64_t records = atomic_load(&g_report.records);
+    uint64_t shapeErrors = atomic_load(&g_report.shapeErrors);
+    uint64_t orderErrors = atomic_load(&g_report.orderErrors);
+    uint64_t oversize = atomic_load(&g_report.oversizeReplies);
+
+    printf("clients          %u (fragment<=%u bytes on even, %u lines/write)\n", clients, maxFragment, linesPerWrite);
+    printf("lines            %llu / %llu\n", (unsigned long long)linesSeen, (unsigned long long)expectedLines);
+    printf("fixed records    %llu / 4\n", (unsigned long long)records);
+    printf("replies          %llu\n", (unsigned long long)replies);
+    printf("oversized        %llu\n", (unsigned long long)oversize);
+    printf("shape errors     %llu\n", (unsigned long long)shapeErrors);
+    printf("order errors     %llu\n", (unsigned long long)orderErrors);
+    printf("failed clients   %u\n", failedClients);
+    printf("peak active      %u\n", stats.peakActive);
+    printf("bytes in/out     %llu / %llu\n", (unsigned long long)stats.bytesIn, (unsigned long long)stats.bytesOut);
+    printf("elapsed          %.3f s\n", seconds);
+    printf("throughput       %.0f commands/s\n", seconds > 0 ? (double)(linesSeen + records) / seconds : 0.0);
+
+    free(workers);
+    free(threads);
+    bool clean = (linesSeen == expectedLines && records == 4 && oversize == 1 &&
+                  shapeErrors == 0 && orderErrors == 0 && failedClients == 0);
+    return clean ? 0 : 1;
+}
@@ -0,0 +1,499 @@
+//
+//  kimirun_trace_replay.c
+//  KimiRun - Offline touch trace replay / benchmark
+//
+//  Host-side tool (not part of the theos targets). Reads a trace written
+//  with TouchTrace=1, re-derives every event through the same portable
+//  model the builder and gesture composer use, and reports mismatches:
+//    - mask / range / touch flags per (kind, phase, mask profile)
+//    - normalized coordinates from the last recorded transform
+//    - move points against the planner (linear or simple_curve)
+//  then times the model over the whole trace.
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_POSIX_C_SOURCE=200809L -Imodules
+//       tools/kimirun_trace_replay.c modules/touch/KimiRunTouchModel.c
+//       modules/trace/KimiRunTouchTrace.c -lm -lpthread -o kimirun_trace_replay
+//
+//  Usage:
+//    kimirun_trace_replay [-v] [-b iterations] trace
+//    kimirun_trace_replay -s out.trace [-n gestures]   synthesize a trace
+//
+//  Exit status: 0 clean, 1 mismatches, 2 usage or I/O error.
+//
+
+#include "touch/KimiRunTouchModel.h"
+#include "trace/KimiRunTouchTrace.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kReplayNormTolerance 2e-4      // float transform vs double on device
+#define kReplayPointTolerance 1e-2     // points, float storage
+#define kReplayMaxReports 20
+
+typedef struct {
+    KimiRunTouchTraceRecord *records;
+    size_t count;
+    KimiRunTouchTraceHeader header;
+} ReplayTrace;
+
+typedef struct {
+    size_t events;
+    size_t metrics;
+    size_t shapeMismatches;
+    size_t normMismatches;
+    size_t normUnchecked;
+    size_t gestures;
+    size_t gesturesLinear;
+    size_t gesturesCurve;
+    size_t gesturesStationary;
+    size_t gesturesIncomplete;
+    size_t plannerMismatches;
+    size_t reports;
+    size_t backendEvents[8];
+} ReplayReport;
+
+typedef struct {
+    double x;
+    double y;
+    int phase;
+} ReplayPoint;
+
+static bool g_verbose = false;
+
+static uint64_t ReplayNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static bool ReplayLoad(const char *path, ReplayTrace *trace) {
+    KimiRunTouchTraceReader reader;
+    if (!KimiRunTouchTraceReaderOpen(&reader, path)) {
+        fprintf(stderr, "cannot open trace %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    memset(trace, 0, sizeof(*trace));
+    trace->header = reader.header;
+    size_t capacity = 1024;
+    trace->records = malloc(capacity * sizeof(KimiRunTouchTraceRecord));
+    if (!trace->records) {
+        KimiRunTouchTraceReaderClose(&reader);
+        return false;
+    }
+    KimiRunTouchTraceRecord record;
+    while (KimiRunTouchTraceReaderNext(&reader, &record)) {
+        if (trace->count == capacity) {
+            capacity *= 2;
+            KimiRunTouchTraceRecord *grown = realloc(trace->records, capacity * sizeof(KimiRunTouchTraceRecord));
+            if (!grown) {
+                KimiRunTouchTraceReaderClose(&reader);
+                return false;
+            }
+            trace->records = grown;
+        }
+        trace->records[trace->count++] = record;
+    }
+    KimiRunTouchTraceReaderClose(&reader);
+    return true;
+}
+
+static void ReplayTransformFromRecord(const KimiRunTouchTraceRecord *record, KimiRunTouchTransform *out) {
+    out->a = record->u.metrics.a;
+    out->b = record->u.metrics.b;
+    out->c = record->u.metrics.c;
+    out->d = record->u.metrics.d;
+    out->tx = record->u.metrics.tx;
+    out->ty = record->u.metrics.ty;
+}
+
+static void ReplayMismatch(ReplayReport *report, size_t index, const char *what, const char *detail) {
+    if (report->reports++ < kReplayMaxReports) {
+        fprintf(stderr, "record %zu: %s mismatch (%s)\n", index, what, detail);
+    }
+}
+
+static bool ReplayIsTopLevel(const KimiRunTouchTraceRecord *record) {
+    return record->type == KimiRunTouchTraceRecordEvent &&
+           (record->kind == KimiRunTouchEventKindSimParent ||
+            record->kind == KimiRunTouchEventKindLegacyHand);
+}
+
+// Builder half: masks, flags and normalization per record.
+static void ReplayCheckEvents(const ReplayTrace *trace, ReplayReport *report) {
+    KimiRunTouchTransform transform;
+    bool haveTransform = false;
+    char detail[160];
+    for (size_t i = 0; i < trace->count; i++) {
+        const KimiRunTouchTraceRecord *record = &trace->records[i];
+        if (record->type == KimiRunTouchTraceRecordMetrics) {
+            ReplayTransformFromRecord(record, &transform);
+            haveTransform = true;
+            report->metrics++;
+            continue;
+        }
+        if (record->type != KimiRunTouchTraceRecordEvent) {
+            continue;
+        }
+        report->events++;
+        report->backendEvents[record->backend & 7]++;
+        if (g_verbose) {
+            printf("%8zu g=%-5u %-11s %-4s f=%-2u %-6s mask=0x%02X flags=%u in=(%.2f, %.2f) norm=(%.4f, %.4f) sender=0x%llX\n",
+                   i, record->gesture,
+                   KimiRunTouchTraceKindName(record->kind),
+                   KimiRunTouchTracePhaseName(record->phase),
+                   record->fingerIndex,
+                   KimiRunTouchTraceBackendName(record->backend),
+                   record->eventMask, record->flags,
+                   record->u.event.inputX, record->u.event.inputY,
+                   record->u.event.normX, record->u.event.normY,
+                   (unsigned long long)record->u.event.senderID);
+        }
+
+        KimiRunTouchEventShape shape;
+        if (!KimiRunTouchEventShapeFor((KimiRunTouchEventKind)record->kind, record->phase,
+                                       (KimiRunTouchMaskProfile)record->profile, &shape)) {
+            report->shapeMismatches++;
+            ReplayMismatch(report, i, "shape", "unknown kind or phase");
+            continue;
+        }
+        uint8_t flags = (uint8_t)((shape.inRange ? KimiRunTouchTraceFlagInRange : 0) |
+                                  (shape.touching ? KimiRunTouchTraceFlagTouching : 0));
+        if (shape.eventMask != record->eventMask || flags != record->flags) {
+            report->shapeMismatches++;
+            snprintf(detail, sizeof(detail), "mask 0x%02X/0x%02X flags %u/%u",
+                     record->eventMask, shape.eventMask, record->flags, flags);
+            ReplayMismatch(report, i, "shape", detail);
+        }
+
+        if (record->kind == KimiRunTouchEventKindSimParent) {
+            continue;   // parents carry no coordinates
+        }
+        if (!haveTransform) {
+            report->normUnchecked++;
+            continue;
+        }
+        float nx = 0.0f;
+        float ny = 0.0f;
+        KimiRunTouchTransformApply(&transform, record->u.event.inputX, record->u.event.inputY, &nx, &ny);
+        if (fabs(nx - record->u.event.normX) > kReplayNormTolerance ||
+            fabs(ny - record->u.event.normY) > kReplayNormTolerance) {
+            report->normMismatches++;
+            snprintf(detail, sizeof(detail), "norm (%.5f, %.5f) expected (%.5f, %.5f)",
+                     record->u.event.normX, record->u.event.normY, nx, ny);
+            ReplayMismatch(report, i, "normalize", detail);
+        }
+    }
+}
+
+// The point of a top-level event: its own input for a legacy hand, the
+// directly built child that follows a sim parent otherwise.
+static bool ReplayTopLevelPoint(const ReplayTrace *trace, size_t index, ReplayPoint *out) {
+    const KimiRunTouchTraceRecord *record = &trace->records[index];
+    out->phase = record->phase;
+    if (record->kind == KimiRunTouchEventKindLegacyHand) {
+        out->x = record->u.event.inputX;
+        out->y = record->u.event.inputY;
+        return true;
+    }
+    for (size_t j = index + 1; j < trace->count; j++) {
+        const KimiRunTouchTraceRecord *next = &trace->records[j];
+        if (next->type != KimiRunTouchTraceRecordEvent) {
+            continue;
+        }
+        if (next->kind != KimiRunTouchEventKindSimChild || next->gesture != record->gesture) {
+            return false;
+        }
+        out->x = next->u.event.inputX;
+        out->y = next->u.event.inputY;
+        return true;
+    }
+    return false;
+}
+
+static bool ReplayPlannerMatches(const ReplayPoint *points, size_t count, bool simpleCurve) {
+    const ReplayPoint *start = &points[0];
+    const ReplayPoint *end = &points[count - 1];
+    long steps = (long)count - 2;
+    for (long i = 1; i <= steps; i++) {
+        double x = 0.0;
+        double y = 0.0;
+        KimiRunTouchPlanPointAtStep(start->x, start->y, end->x, end->y, i, steps, simpleCurve, &x, &y);
+        if (fabs(x - points[i].x) > kReplayPointTolerance ||
+            fabs(y - points[i].y) > kReplayPointTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Planner half: each gesture's moves must lie on the planned path.
+static void ReplayCheckGestures(const ReplayTrace *trace, ReplayReport *report) {
+    ReplayPoint *points = malloc((trace->count + 1) * sizeof(ReplayPoint));
+    if (!points) {
+        return;
+    }
+    size_t i = 0;
+    while (i < trace->count) {
+        if (!ReplayIsTopLevel(&trace->records[i]) ||
+            trace->records[i].phase != KimiRunTouchModelPhaseDown) {
+            i++;
+            continue;
+        }
+        uint32_t gesture = trace->records[i].gesture;
+        size_t count = 0;
+        size_t first = i;
+        for (; i < trace->count && (trace->records[i].type != KimiRunTouchTraceRecordEvent ||
+                                    trace->records[i].gesture == gesture); i++) {
+            if (!ReplayIsTopLevel(&trace->records[i])) {
+                continue;
+            }
+            ReplayPoint point;
+            if (!ReplayTopLevelPoint(trace, i, &point)) {
+                continue;
+            }
+            // A relatch rebuilds the same phase on the next backend.
+            if (count > 0 && points[count - 1].phase == point.phase &&
+                fabs(points[count - 1].x - point.x) < kReplayPointTolerance &&
+                fabs(points[count - 1].y - point.y) < kReplayPointTolerance) {
+                continue;
+            }
+            points[count++] = point;
+        }
+        report->gestures++;
+        if (count < 2 || points[count - 1].phase != KimiRunTouchModelPhaseUp) {
+            report->gesturesIncomplete++;
+            continue;
+        }
+        if (count == 2) {
+            report->gesturesStationary++;
+            continue;
+        }
+        if (ReplayPlannerMatches(points, count, false)) {
+            report->gesturesLinear++;
+        } else if (ReplayPlannerMatches(points, count, true)) {
+            report->gesturesCurve++;
+        } else {
+            report->plannerMismatches++;
+            char detail[96];
+            snprintf(detail, sizeof(detail), "gesture %u, %zu moves", gesture, count - 2);
+            ReplayMismatch(report, first, "planner", detail);
+        }
+    }
+    free(points);
+}
+
+// Times the pure model work the builder does per event and the planner
+// work per move, over the whole trace.
+static void ReplayBenchmark(const ReplayTrace *trace, unsigned iterations) {
+    if (trace->count == 0 || iterations == 0) {
+        return;
+    }
+    KimiRunTouchTransform transform;
+    KimiRunTouchTransformSetIdentity(&transform);
+    volatile uint32_t sink = 0;
+    size_t built = 0;
+    uint64_t start = ReplayNowNanos();
+    for (unsigned it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < trace->count; i++) {
+            const KimiRunTouchTraceRecord *record = &trace->records[i];
+            if (record->type == KimiRunTouchTraceRecordMetrics) {
+                ReplayTransformFromRecord(record, &transform);
+                continue;
+            }
+            KimiRunTouchEventShape shape;
+            KimiRunTouchEventShapeFor((KimiRunTouchEventKind)record->kind, record->phase,
+                                      (KimiRunTouchMaskProfile)record->profile, &shape);
+            float nx = 0.0f;
+            float ny = 0.0f;
+            KimiRunTouchTransformApply(&transform, record->u.event.inputX, record->u.event.inputY, &nx, &ny);
+            double px = 0.0;
+            double py = 0.0;
+            KimiRunTouchPlanPointAtStep(0.0, 0.0, record->u.event.inputX, record->u.event.inputY,
+                                        (long)(i & 31), 32, (i & 1) != 0, &px, &py);
+            sink += shape.eventMask + (uint32_t)(nx * 1000.0f) + (uint32_t)px;
+            built++;
+        }
+    }
+    uint64_t elapsed = ReplayNowNanos() - start;
+    double seconds = (double)elapsed / 1e9;
+    printf("benchmark: %zu events x %u iterations in %.3f ms, %.1f ns/event, %.2f M events/s (sink=%u)\n",
+           built / iterations, iterations, (double)elapsed / 1e6,
+           built ? (double)elapsed / (double)built : 0.0,
+           seconds > 0.0 ? ((double)built / seconds) / 1e6 : 0.0,
+           (unsigned)sink);
+}
+
+// Recorded on-device pacing between consecutive top-level events.
+static void ReplayRecordedTiming(const ReplayTrace *trace) {
+    uint64_t previous = 0;
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    size_t intervals = 0;
+    double toNanos = (double)trace->header.timebaseNumer / (double)trace->header.timebaseDenom;
+    for (size_t i = 0; i < trace->count; i++) {
+        const KimiRunTouchTraceRecord *record = &trace->records[i];
+        if (!ReplayIsTopLevel(record)) {
+            continue;
+        }
+        uint64_t stamp = (uint64_t)((double)record->u.event.eventTimestamp * toNanos);
+        if (previous != 0 && record->phase != KimiRunTouchModelPhaseDown && stamp >= previous) {
+            uint64_t delta = stamp - previous;
+            total += delta;
+            worst = delta > worst ? delta : worst;
+            intervals++;
+        }
+        previous = stamp;
+    }
+    if (intervals > 0) {
+        printf("recorded: %zu intervals, mean %.3f ms, max %.3f ms\n",
+               intervals, (double)total / (double)intervals / 1e6, (double)worst / 1e6);
+    }
+}
+
+static int ReplaySynthesize(const char *path, unsigned gestures) {
+    KimiRunTouchTraceWriter writer;
+    if (!KimiRunTouchTraceWriterOpen(&writer, path, 1, 1, 0)) {
+        fprintf(stderr, "cannot create %s: %s\n", path, strerror(errno));
+        return 2;
+    }
+    // Portrait 390x844 interface, digitizer == interface orientation.
+    KimiRunTouchTransform transform = {1.0 / 390.0, 0.0, 0.0, 1.0 / 844.0, 0.0, 0.0};
+    KimiRunTouchTraceRecord metrics;
+    memset(&metrics, 0, sizeof(metrics));
+    metrics.type = KimiRunTouchTraceRecordMetrics;
+    metrics.u.metrics.a = (float)transform.a;
+    metrics.u.metrics.d = (float)transform.d;
+    metrics.u.metrics.width = 390.0f;
+    metrics.u.metrics.height = 844.0f;
+    KimiRunTouchTraceWriterAppend(&writer, &metrics);
+
+    srand(1);
+    for (unsigned g = 0; g < gestures; g++) {
+        double sx = rand() % 390;
+        double sy = rand() % 844;
+        double ex = rand() % 390;
+        double ey = rand() % 844;
+        bool curve = (g % 3) == 0;
+        KimiRunTouchMaskProfile profile = (g & 1) ? KimiRunTouchMaskProfileXXTouch : KimiRunTouchMaskProfileLegacyRaw;
+        long steps = KimiRunTouchPlanStepCount(sx, sy, ex, ey, 20, (g % 4) == 0 ? 12.0 : 0.0);
+        for (long s = 0; s <= steps + 1; s++) {
+            int phase = (s == 0) ? KimiRunTouchModelPhaseDown
+                      : (s == steps + 1 ? KimiRunTouchModelPhaseUp : KimiRunTouchModelPhaseMove);
+            double x = sx;
+            double y = sy;
+            if (phase == KimiRunTouchModelPhaseUp) {
+                x = ex;
+                y = ey;
+            } else if (phase == KimiRunTouchModelPhaseMove) {
+                KimiRunTouchPlanPointAtStep(sx, sy, ex, ey, s, steps, curve, &x, &y);
+            }
+            KimiRunTouchEventKind kinds[2] = {KimiRunTouchEventKindSimParent, KimiRunTouchEventKindSimChild};
+            for (int k = 0; k < 2; k++) {
+                KimiRunTouchEventShape shape;
+                KimiRunTouchEventShapeFor(kinds[k], phase, profile, &shape);
+                KimiRunTouchTraceRecord record;
+                memset(&record, 0, sizeof(record));
+                record.type = KimiRunTouchTraceRecordEvent;
+                record.kind = (uint8_t)kinds[k];
+                record.phase = (uint8_t)phase;
+                record.fingerIndex = (uint8_t)(k == 0 ? 0 : 1);
+                record.backend = 2;
+                record.profile = (uint8_t)profile;
+                record.flags = (uint8_t)((shape.inRange ? KimiRunTouchTraceFlagInRange : 0) |
+                                         (shape.touching ? KimiRunTouchTraceFlagTouching : 0));
+                record.eventMask = shape.eventMask;
+                record.u.event.eventTimestamp = ReplayNowNanos();
+                record.u.event.senderID = 0xDEFACEDBEEFFECE5ull;
+                if (kinds[k] == KimiRunTouchEventKindSimChild) {
+                    record.u.event.inputX = (float)x;
+                    record.u.event.inputY = (float)y;
+                    KimiRunTouchTransformApply(&transform, x, y, &record.u.event.normX, &record.u.event.normY);
+                }
+                KimiRunTouchTraceWriterAppend(&writer, &record);
+            }
+        }
+    }
+    KimiRunTouchTraceStats stats;
+    KimiRunTouchTraceWriterGetStats(&writer, &stats);
+    KimiRunTouchTraceWriterClose(&writer);
+    printf("wrote %llu records (%u gestures) to %s\n",
+           (unsigned long long)stats.records, stats.gestures, path);
+    return stats.writeErrors ? 2 : 0;
+}
+
+static void ReplayUsage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [-v] [-b iterations] trace\n"
+            "       %s -s out.trace [-n gestures]\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    unsigned iterations = 200;
+    unsigned gestures = 100;
+    const char *synthPath = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "vb:s:n:")) != -1) {
+        switch (opt) {
+            case 'v':
+                g_verbose = true;
+                break;
+            case 'b':
+                iterations = (unsigned)strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                synthPath = optarg;
+                break;
+            case 'n':
+                gestures = (unsigned)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                ReplayUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (synthPath) {
+        return ReplaySynthesize(synthPath, gestures);
+    }
+    if (optind >= argc) {
+        ReplayUsage(argv[0]);
+        return 2;
+    }
+
+    ReplayTrace trace;
+    if (!ReplayLoad(argv[optind], &trace)) {
+        return 2;
+    }
+    ReplayReport report;
+    memset(&report, 0, sizeof(report));
+    ReplayCheckEvents(&trace, &report);
+    ReplayCheckGestures(&trace, &report);
+
+    printf("trace: %zu records, %zu events, %zu metrics, pid %u\n",
+           trace.count, report.events, report.metrics, trace.header.pid);
+    printf("backends:");
+    for (uint8_t b = 0; b < 8; b++) {
+        if (report.backendEvents[b]) {
+            printf(" %s=%zu", KimiRunTouchTraceBackendName(b), report.backendEvents[b]);
+        }
+    }
+    printf("\n");
+    printf("builder: %zu shape mismatches, %zu normalize mismatches, %zu unchecked\n",
+           report.shapeMismatches, report.normMismatches, report.normUnchecked);
+    printf("planner: %zu gestures, %zu linear, %zu simple_curve, %zu stationary, %zu incomplete, %zu mismatches\n",
+           report.gestures, report.gesturesLinear, report.gesturesCurve,
+           report.gesturesStationary, report.gesturesIncomplete, report.plannerMismatches);
+    ReplayRecordedTiming(&trace);
+    ReplayBenchmark(&trace, iterations);
+    free(trace.records);
+
+    size_t mismatches = report.shapeMismatches + report.normMismatches + report.plannerMismatches;
+    return mismatches ? 1 : 0;
+}
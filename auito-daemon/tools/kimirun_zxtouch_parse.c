@@ -0,0 +1,342 @@
+//
+//  kimirun_zxtouch_parse.c
+//  KimiRun - ZXTouch parser fuzz / benchmark
+//
+//  Host-side tool (not part of the theos targets) for the portable
+//  KimiRunZXTouchParser:
+//    fuzz   mutates a seed corpus (bit flips, inserts, deletes, truncation,
+//           splices) and checks every result for internal consistency;
+//           also round-trips randomly generated valid commands
+//    bench  parses a mixed command set and reports records per second
+//  Each input is parsed from an exact-size heap copy, so building with
+//  -fsanitize=address,undefined catches any over-read.
+//
+//  Build (Linux or macOS), from auito-daemon/:
+//    cc -std=c11 -O2 -D_DEFAULT_SOURCE -Imodules
+//       tools/kimirun_zxtouch_parse.c modules/socket/KimiRunZXTouchParser.c
+//       -o kimirun_zxtouch_parse
+//  libFuzzer (clang): add -DKIMIRUN_LIBFUZZER -fsanitize=fuzzer,address.
+//
+//  Usage:
+//    kimirun_zxtouch_parse fuzz [-n iterations] [-s seed]
+//    kimirun_zxtouch_parse bench [-n iterations]
+//
+//  Exit status: 0 clean, 1 invariant failures, 2 usage error.
+//
+
+#include "socket/KimiRunZXTouchParser.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define kParseMaxInput 256
+#define kParseMaxReports 20
+
+static const char *const kParseSeeds[] = {
+    "1011010500001230",
+    "10220105010012401020060000700",
+    "103101050000123020106000012300010600001230",
+    "109000000009999910101111999982020222299997003033339999610404444999952050555599994006066669999310707777999922080888899991",
+    "  1010019999999999  \r",
+    "TEST",
+    "TAP 100 200",
+    "TAP  12.5   -3.25 extra",
+    "TAP .5 7.",
+    "100",
+    "10",
+    "1011",
+    "10a1010500001230",
+    "1013010500001230",
+    "101101050000123",
+    "hello",
+    "",
+};
+
+static size_t g_failures = 0;
+
+static uint64_t ParseNowNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void ParseReport(const uint8_t *bytes, size_t length, const char *what) {
+    g_failures++;
+    if (g_failures > kParseMaxReports) {
+        return;
+    }
+    fprintf(stderr, "FAIL %s: \"", what);
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = bytes[i];
+        if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\') {
+            fputc(c, stderr);
+        } else {
+            fprintf(stderr, "\\x%02x", c);
+        }
+    }
+    fprintf(stderr, "\"\n");
+}
+
+// Parses an exact-size copy and checks the result against the grammar.
+static void ParseCheck(const uint8_t *input, size_t length) {
+    uint8_t *copy = malloc(length ? length : 1);
+    if (length) {
+        memcpy(copy, input, length);
+    }
+    KimiRunZXCommand first;
+    KimiRunZXCommand second;
+    memset(&first, 0xA5, sizeof(first));
+    memset(&second, 0x5A, sizeof(second));
+    KimiRunZXCommandKind kind = KimiRunZXTouchParse(copy, length, &first);
+    KimiRunZXTouchParse(copy, length, &second);
+    free(copy);
+
+    if (kind != first.kind) {
+        ParseReport(input, length, "return value != kind");
+    }
+    if (first.kind != second.kind || first.error != second.error || first.count != second.count) {
+        ParseReport(input, length, "nondeterministic");
+    }
+    switch (first.kind) {
+        case KimiRunZXCommandTouch:
+            if (first.error != KimiRunZXParseOK || first.count < 1 || first.count > KIMIRUN_ZXTOUCH_MAX_RECORDS) {
+                ParseReport(input, length, "touch count/error");
+            }
+            for (uint32_t i = 0; i < first.count && i < KIMIRUN_ZXTOUCH_MAX_RECORDS; i++) {
+                const KimiRunZXTouchRecord *r = &first.records[i];
+                if (r->type > KimiRunZXTouchTypeMove || r->finger > 99 ||
+                    !(r->x >= 0.0f && r->x <= 9999.9f) || !(r->y >= 0.0f && r->y <= 9999.9f) ||
+                    r->type != second.records[i].type || r->finger != second.records[i].finger ||
+                    r->x != second.records[i].x || r->y != second.records[i].y) {
+                    ParseReport(input, length, "touch record");
+                }
+            }
+            break;
+        case KimiRunZXCommandTap:
+            if (first.error != KimiRunZXParseOK || !isfinite(first.tapX) || !isfinite(first.tapY)) {
+                ParseReport(input, length, "tap");
+            }
+            break;
+        case KimiRunZXCommandTest:
+            if (first.error != KimiRunZXParseOK) {
+                ParseReport(input, length, "test");
+            }
+            break;
+        case KimiRunZXCommandInvalid:
+            if (first.error == KimiRunZXParseOK || first.count != 0 ||
+                strncmp(KimiRunZXTouchErrorReply(first.error), "ERROR: ", 7) != 0) {
+                ParseReport(input, length, "invalid error");
+            }
+            break;
+        default:
+            ParseReport(input, length, "kind out of range");
+            break;
+    }
+}
+
+#ifdef KIMIRUN_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    ParseCheck(data, size);
+    if (g_failures > 0) {
+        abort();
+    }
+    return 0;
+}
+
+#else
+
+static uint32_t ParseRandom(uint64_t *state) {
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static size_t ParseMutate(uint8_t *buffer, size_t length, uint64_t *rng) {
+    static const uint8_t kInteresting[] = { '0', '1', '2', '9', ' ', '\r', '\n', '.', '-', 'T', 0x00, 0xff, 'A' };
+    uint32_t rounds = 1 + (ParseRandom(rng) % 4);
+    for (uint32_t r = 0; r < rounds; r++) {
+        uint32_t op = ParseRandom(rng) % 6;
+        size_t at = length ? (ParseRandom(rng) % length) : 0;
+        switch (op) {
+            case 0: // flip a bit
+                if (length) {
+                    buffer[at] ^= (uint8_t)(1u << (ParseRandom(rng) % 8));
+                }
+                break;
+            case 1: // overwrite with an interesting byte
+                if (length) {
+                    buffer[at] = kInteresting[ParseRandom(rng) % sizeof(kInteresting)];
+                }
+                break;
+            case 2: // insert
+                if (length < kParseMaxInput) {
+                    memmove(buffer + at + 1, buffer + at, length - at);
+                    buffer[at] = kInteresting[ParseRandom(rng) % sizeof(kInteresting)];
+                    length++;
+                }
+                break;
+            case 3: // delete
+                if (length) {
+                    memmove(buffer + at, buffer + at + 1, length - at - 1);
+                    length--;
+                }
+                break;
+            case 4: // truncate
+                length = at;
+                break;
+            case 5: { // splice another seed's tail
+                const char *seed = kParseSeeds[ParseRandom(rng) % (sizeof(kParseSeeds) / sizeof(kParseSeeds[0]))];
+                size_t seedLength = strlen(seed);
+                size_t from = seedLength ? (ParseRandom(rng) % seedLength) : 0;
+                size_t take = seedLength - from;
+                if (at + take > kParseMaxInput) {
+                    take = kParseMaxInput - at;
+                }
+                memcpy(buffer + at, seed + from, take);
+                length = at + take;
+                break;
+            }
+        }
+    }
+    return length;
+}
+
+// Generate a valid touch command, parse it, and compare field by field.
+static void ParseRoundTrip(uint64_t *rng) {
+    uint32_t count = 1 + (ParseRandom(rng) % KIMIRUN_ZXTOUCH_MAX_RECORDS);
+    KimiRunZXTouchRecord expected[KIMIRUN_ZXTOUCH_MAX_RECORDS];
+    char line[3 + (KIMIRUN_ZXTOUCH_MAX_RECORDS * KIMIRUN_ZXTOUCH_RECORD_CHARS) + 1];
+    size_t length = (size_t)snprintf(line, sizeof(line), "10%u", count);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t type = ParseRandom(rng) % 3;
+        uint32_t finger = ParseRandom(rng) % 100;
+        uint32_t x = ParseRandom(rng) % 100000;
+        uint32_t y = ParseRandom(rng) % 100000;
+        length += (size_t)snprintf(line + length, sizeof(line) - length, "%u%02u%05u%05u", type, finger, x, y);
+        expected[i].type = (uint8_t)type;
+        expected[i].finger = (uint8_t)finger;
+        expected[i].x = (float)x / 10.0f;
+        expected[i].y = (float)y / 10.0f;
+    }
+    KimiRunZXCommand command;
+    if (KimiRunZXTouchParse((const uint8_t *)line, length, &command) != KimiRunZXCommandTouch ||
+        command.count != count) {
+        ParseReport((const uint8_t *)line, length, "round trip kind/count");
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const KimiRunZXTouchRecord *got = &command.records[i];
+        if (got->type != expected[i].type || got->finger != expected[i].finger ||
+            got->x != expected[i].x || got->y != expected[i].y) {
+            ParseReport((const uint8_t *)line, length, "round trip record");
+            return;
+        }
+    }
+}
+
+static int ParseFuzz(uint64_t iterations, uint64_t seed) {
+    uint64_t rng = seed ? seed : 0x9E3779B97F4A7C15ull;
+    size_t seedCount = sizeof(kParseSeeds) / sizeof(kParseSeeds[0]);
+    for (size_t i = 0; i < seedCount; i++) {
+        ParseCheck((const uint8_t *)kParseSeeds[i], strlen(kParseSeeds[i]));
+    }
+    uint8_t buffer[kParseMaxInput + 1];
+    size_t kinds[4] = { 0, 0, 0, 0 };
+    for (uint64_t i = 0; i < iterations; i++) {
+        const char *base = kParseSeeds[ParseRandom(&rng) % seedCount];
+        size_t length = strlen(base);
+        memcpy(buffer, base, length);
+        length = ParseMutate(buffer, length, &rng);
+        ParseCheck(buffer, length);
+        KimiRunZXCommand command;
+        kinds[KimiRunZXTouchParse(buffer, length, &command) & 3]++;
+        if ((i & 7) == 0) {
+            ParseRoundTrip(&rng);
+        }
+    }
+    printf("fuzz iterations  %llu\n", (unsigned long long)iterations);
+    printf("invalid/touch/test/tap  %zu / %zu / %zu / %zu\n", kinds[0], kinds[1], kinds[2], kinds[3]);
+    printf("failures         %zu\n", g_failures);
+    return g_failures ? 1 : 0;
+}
+
+static int ParseBench(uint64_t iterations) {
+    static const char *const kBenchLines[] = {
+        "1011010500001230",
+        "10220105010012402020601001250",
+        "10520105010012402020601001250203070100126020408010012700050901001280",
+        "1010010501001240",
+        "TAP 100.5 200.25",
+        "10a1010500001230",
+    };
+    size_t lineCount = sizeof(kBenchLines) / sizeof(kBenchLines[0]);
+    size_t lengths[sizeof(kBenchLines) / sizeof(kBenchLines[0])];
+    for (size_t i = 0; i < lineCount; i++) {
+        lengths[i] = strlen(kBenchLines[i]);
+    }
+    volatile float sink = 0.0f;
+    uint64_t records = 0;
+    uint64_t start = ParseNowNanos();
+    for (uint64_t i = 0; i < iterations; i++) {
+        size_t which = (size_t)(i % lineCount);
+        KimiRunZXCommand command;
+        if (KimiRunZXTouchParse((const uint8_t *)kBenchLines[which], lengths[which], &command) == KimiRunZXCommandTouch) {
+            records += command.count;
+            sink += command.records[command.count - 1].x;
+        }
+    }
+    double seconds = (double)(ParseNowNanos() - start) / 1e9;
+    (void)sink;
+    printf("bench lines      %llu\n", (unsigned long long)iterations);
+    printf("records          %llu\n", (unsigned long long)records);
+    printf("elapsed          %.3f s\n", seconds);
+    printf("lines/s          %.0f\n", seconds > 0 ? (double)iterations / seconds : 0.0);
+    printf("records/s        %.0f\n", seconds > 0 ? (double)records / seconds : 0.0);
+    printf("ns/line          %.1f\n", iterations ? (seconds * 1e9) / (double)iterations : 0.0);
+    return 0;
+}
+
+static void ParseUsage(const char *argv0) {
+    fprintf(stderr, "usage: %s fuzz [-n iterations] [-s seed]\n", argv0);
+    fprintf(stderr, "       %s bench [-n iterations]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        ParseUsage(argv[0]);
+        return 2;
+    }
+    const char *mode = argv[1];
+    uint64_t iterations = 0;
+    uint64_t seed = 0;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                ParseUsage(argv[0]);
+                return 2;
+        }
+    }
+    if (strcmp(mode, "fuzz") == 0) {
+        return ParseFuzz(iterations ? iterations : 2000000, seed);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return ParseBench(iterations ? iterations : 20000000);
+    }
+    ParseUsage(argv[0]);
+    return 2;
+}
+
+#endif
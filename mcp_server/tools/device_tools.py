@@ -10,8 +10,9 @@ import socket
 import subprocess
 import time
 import base64
+import json
 import httpx
-from typing import List, Dict, Any
+from typing import List, Dict, Any, Optional
 from mcp.types import Tool, TextContent, ImageContent
 
 # AuiTO API configuration from environment or defaults.
@@ -268,6 +269,20 @@ class DeviceToolRegistry:
                     }
                 }
             ),
+            Tool(
+                name="device_a11y_find",
+                description="Find accessibility elements by label or identifier, ranked best first",
+                inputSchema={
+                    "type": "object",
+                    "properties": {
+                        "query": {"type": "string", "description": "Text to look for"},
+                        "field": {"type": "string", "enum": ["label", "identifier", "any"], "default": "any"},
+                        "fuzzy": {"type": "boolean", "description": "Also return near matches (typos, word order)", "default": False},
+                        "limit": {"type": "integer", "description": "Maximum matches", "default": 10}
+                    },
+                    "required": ["query"]
+                }
+            ),
             Tool(
                 name="device_a11y_activate",
                 description="Activate an accessibility element by index from the most recent a11y/interactive result",
@@ -359,6 +374,8 @@ class DeviceToolRegistry:
                 return await self._handle_screen_size()
             elif name == "device_a11y_interactive":
                 return await self._handle_a11y_interactive(arguments)
+            elif name == "device_a11y_find":
+                return await self._handle_a11y_find(arguments)
             elif name == "device_a11y_activate":
                 return await self._handle_a11y_activate(arguments)
             elif name == "device_a11y_overlay":
@@ -506,6 +523,14 @@ class DeviceToolRegistry:
         """Handle device_type_text tool"""
         text = arguments.get("text", "")
         response = self.client.get("/keyboard/type", params={"text": text})
+        if response.status_code == 202:
+            # Key playback was queued; the reply only means it was started.
+            job = self._wait_for_typing_job(response, len(text))
+            if job is None:
+                return [TextContent(type="text", text=f"Typing not confirmed: {response.text}")]
+            if job.get("success"):
+                return [TextContent(type="text", text=f"Typed text: {json.dumps(job)}")]
+            return [TextContent(type="text", text=f"Typing failed: {json.dumps(job)}")]
         return [TextContent(type="text", text=f"Typed text: {response.text}")]
     
     async def _handle_swipe(self, arguments: dict) -> List[TextContent]:
@@ -646,6 +671,21 @@ class DeviceToolRegistry:
         except Exception:
             return None
 
+    def _wait_for_typing_job(self, response, length: int) -> Optional[Dict[str, Any]]:
+        """Poll /keyboard/type/status for a queued typing job until it is done or failed."""
+        data = self._json_or_none(response) or {}
+        job_id = data.get("jobID")
+        if not job_id:
+            return None
+        # Default key timing is well under 100 ms a character.
+        deadline = time.monotonic() + 5.0 + 0.1 * length
+        while time.monotonic() < deadline:
+            job = self._json_or_none(self.client.get("/keyboard/type/status", params={"id": job_id})) or {}
+            if job.get("state") in ("done", "failed"):
+                return job
+            time.sleep(0.1)
+        return None
+
     def _get_a11y_interactive(self, compact: bool = True, limit: int = 60) -> List[Dict[str, Any]]:
         """Fetch a11y interactive elements with compact JSON to avoid truncation."""
         params = {}
@@ -656,27 +696,57 @@ class DeviceToolRegistry:
         response = self.client.get("/a11y/interactive", params=params)
         return response.json()
 
+    def _find_a11y(self, query: str, field: str = "label", fuzzy: bool = False, limit: int = 10) -> List[Dict[str, Any]]:
+        """Ranked /a11y/find matches ({score, match, field, element}) for query."""
+        key = field if field in {"label", "identifier"} else "q"
+        params = {key: query, "limit": str(limit)}
+        if fuzzy:
+            params["fuzzy"] = "1"
+        data = self._json_or_none(self.client.get("/a11y/find", params=params)) or {}
+        return data.get("matches") or []
+
+    def _find_exact_label(self, label: str) -> List[Dict[str, Any]]:
+        return [m.get("element") or {} for m in self._find_a11y(label) if m.get("match") == "exact"]
+
+    def _find_exact_labels(self, labels: List[str], limit: int = 10) -> Dict[str, List[Dict[str, Any]]]:
+        """Exact matches for several labels in one /a11y/find call (repeated label=)."""
+        params = {"label": list(labels), "limit": str(limit)}
+        data = self._json_or_none(self.client.get("/a11y/find", params=params)) or {}
+        results = data.get("results")
+        if results is None:
+            # Servers without multi-label support answer the first label only.
+            if len(labels) == 1:
+                results = [data]
+            else:
+                return {label: self._find_exact_label(label) for label in labels}
+        found: Dict[str, List[Dict[str, Any]]] = {}
+        for entry in results:
+            matches = entry.get("matches") or []
+            found[entry.get("query", "")] = [m.get("element") or {} for m in matches if m.get("match") == "exact"]
+        return found
+
     def _ensure_settings_root(self, max_steps: int = 6) -> bool:
         """Try to return to Settings root by activating back buttons or tapping top-left."""
-        target_labels = {"Wi-Fi", "Bluetooth", "General"}
-        back_labels = {"Settings", "General", "About", "Wi-Fi", "Bluetooth"}
+        target_labels = ["Wi-Fi", "Bluetooth", "General"]
+        back_labels = ["Settings", "General", "About", "Wi-Fi", "Bluetooth"]
 
         for _ in range(max_steps):
+            found: Dict[str, List[Dict[str, Any]]] = {}
             try:
-                items = self._get_a11y_interactive(compact=True, limit=40)
+                found = self._find_exact_labels(list(dict.fromkeys(target_labels + back_labels)))
             except Exception:
-                items = []
+                pass
 
-            labels = {(it.get("label") or "") for it in items}
-            if target_labels.issubset(labels):
+            if all(found.get(label) for label in target_labels):
                 return True
 
             back_index = None
-            for it in items:
-                label = it.get("label") or ""
-                class_name = it.get("className") or ""
-                if label in back_labels and class_name.endswith("Button"):
-                    back_index = it.get("index")
+            for label in back_labels:
+                for it in found.get(label, []):
+                    if (it.get("className") or "").endswith("Button"):
+                        back_index = it.get("index")
+                        break
+                if back_index is not None:
                     break
 
             if back_index is not None:
@@ -698,6 +768,15 @@ class DeviceToolRegistry:
         response = self.client.get("/a11y/interactive", params=params)
         return [TextContent(type="text", text=response.text)]
 
+    async def _handle_a11y_find(self, arguments: dict) -> List[TextContent]:
+        field = arguments.get("field", "any")
+        key = field if field in {"label", "identifier"} else "q"
+        params = {key: arguments.get("query", ""), "limit": str(arguments.get("limit", 10))}
+        if arguments.get("fuzzy"):
+            params["fuzzy"] = "1"
+        response = self.client.get("/a11y/find", params=params)
+        return [TextContent(type="text", text=response.text)]
+
     async def _handle_a11y_activate(self, arguments: dict) -> List[TextContent]:
         index = int(arguments.get("index"))
         response = self.client.get("/a11y/activate", params={"index": index})